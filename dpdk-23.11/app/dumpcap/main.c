@@ -26,10 +26,12 @@
 #include <rte_alarm.h>
 #include <rte_bpf.h>
 #include <rte_config.h>
+#include <rte_cycles.h>
 #include <rte_debug.h>
 #include <rte_eal.h>
 #include <rte_errno.h>
 #include <rte_ethdev.h>
+#include <rte_latencystats.h>
 #include <rte_lcore.h>
 #include <rte_malloc.h>
 #include <rte_mbuf.h>
@@ -37,6 +39,7 @@
 #include <rte_pcapng.h>
 #include <rte_pdump.h>
 #include <rte_ring.h>
+#include <rte_ring_peek.h>
 #include <rte_string_fns.h>
 #include <rte_time.h>
 #include <rte_version.h>
@@ -46,8 +49,10 @@
 
 #define MONITOR_INTERVAL  (500 * 1000)
 #define MBUF_POOL_CACHE_SIZE 32
-#define BURST_SIZE 32
+/* packets dequeued from the ring and written with one system call */
+#define BURST_SIZE 256
 #define SLEEP_THRESHOLD 1000
+#define TRIGGER_INTERVAL_MS 100
 
 /* command line flags */
 static const char *progname;
@@ -55,6 +60,7 @@ static bool quit_signal;
 static bool group_read;
 static bool quiet;
 static bool use_pcapng = true;
+static bool zero_copy;
 static char *output_name;
 static const char *tmp_dir = "/tmp";
 static unsigned int ring_size = 2048;
@@ -71,10 +77,31 @@ static struct {
 	size_t size;		/* file size (bytes) */
 } stop;
 
+/* pre-trigger capture */
+static struct {
+	double pre;		/* seconds kept in memory, 0 if not used */
+	double post;		/* seconds written after a trigger */
+	unsigned int packets;	/* packets kept in memory */
+	uint64_t latency_ns;	/* latency threshold, 0 if not used */
+	uint64_t drops;		/* drops per check interval, 0 if not used */
+} trigger = {
+	.packets = 16384,
+};
+
+/* Packet kept in memory waiting for a trigger */
+struct retained_pkt {
+	struct rte_mbuf *mbuf;
+	uint64_t tsc;		/* when dequeued from the capture ring */
+};
+
 /* Running state */
 static time_t start_time;
 static uint64_t packets_received;
 static size_t file_size;
+static struct rte_ring *retain_ring;
+static uint64_t trigger_end;	/* TSC to write until, 0 when waiting */
+static uint64_t trigger_check;	/* TSC of next trigger check */
+static uint64_t pdump_triggers;
 
 /* capture options */
 struct capture_options {
@@ -96,6 +123,9 @@ struct interface {
 	struct rte_rxtx_callback *rx_cb[RTE_MAX_QUEUES_PER_PORT];
 	const char *ifname;
 	const char *ifdescr;
+
+	uint64_t drops;		/* drops at last trigger check */
+	uint64_t slow_pkts;	/* packets over latency threshold */
 };
 
 TAILQ_HEAD(interface_list, interface);
@@ -125,6 +155,7 @@ static void usage(void)
 	       "  -D, --list-interfaces    print list of interfaces and exit\n"
 	       "  -d                       print generated BPF code for capture filter\n"
 	       "  -S                       print statistics for each interface once per second\n"
+	       "  --zero-copy              reference packets in the primary instead of copying\n"
 	       "\n"
 	       "Stop conditions:\n"
 	       "  -c <packet count>        stop after n packets (def: infinite)\n"
@@ -132,6 +163,15 @@ static void usage(void)
 	       "                           duration:NUM - stop after NUM seconds\n"
 	       "                           filesize:NUM - stop this file after NUM kB\n"
 	       "                            packets:NUM - stop after NUM packets\n"
+	       "Trigger conditions:\n"
+	       "  --pre-trigger <seconds>  keep packets in memory, write only on trigger\n"
+	       "  --pre-trigger-packets <count>\n"
+	       "                           packets kept in memory (def: %u)\n"
+	       "  --post-trigger <seconds> keep writing after a trigger (def: 0)\n"
+	       "  --trigger <trigger cond.> ...\n"
+	       "                            latency:NUM - latency above NUM ns\n"
+	       "                              drops:NUM - NUM drops in %u ms\n"
+	       "                           /pdump/trigger telemetry command always triggers\n"
 	       "Output (files):\n"
 	       "  -w <filename>            name of file to save (def: tempfile)\n"
 	       "  -g                       enable group read access on the output file(s)\n"
@@ -148,7 +188,8 @@ static void usage(void)
 	       "  -v, --version            print version information and exit\n"
 	       "  -h, --help               display this help and exit\n"
 	       "\n"
-	       "Use Ctrl-C to stop capturing at any time.\n");
+	       "Use Ctrl-C to stop capturing at any time.\n",
+	       trigger.packets, TRIGGER_INTERVAL_MS);
 }
 
 static const char *version(void)
@@ -208,6 +249,41 @@ static void auto_stop(char *opt)
 	}
 }
 
+/* Set trigger conditions */
+static void add_trigger(char *opt)
+{
+	char *value;
+
+	value = strchr(opt, ':');
+	if (value == NULL)
+		rte_exit(EXIT_FAILURE,
+			 "Missing colon in trigger parameter\n");
+
+	*value++ = '\0';
+	if (strcmp(opt, "latency") == 0) {
+		trigger.latency_ns = get_uint(value, "latency", 0);
+	} else if (strcmp(opt, "drops") == 0) {
+		trigger.drops = get_uint(value, "drops", 0);
+	} else {
+		rte_exit(EXIT_FAILURE,
+			 "Unknown trigger parameter \"%s\"\n", opt);
+	}
+}
+
+/* Parse a number of seconds, which can be fractional */
+static double get_seconds(const char *arg, const char *name)
+{
+	double secs;
+	char *endp;
+
+	secs = strtod(arg, &endp);
+	if (*arg == '\0' || *endp != '\0' || secs < 0)
+		rte_exit(EXIT_FAILURE,
+			 "Invalid %s \"%s\"\n", name, arg);
+
+	return secs;
+}
+
 /* Add interface to list of interfaces to capture */
 static struct interface *add_interface(const char *name)
 {
@@ -346,10 +422,15 @@ static void parse_opts(int argc, char **argv)
 		{ "list-interfaces", no_argument,       NULL, 'D' },
 		{ "no-promiscuous-mode", no_argument,   NULL, 'p' },
 		{ "output-file",     required_argument, NULL, 'w' },
+		{ "post-trigger",    required_argument, NULL, 0 },
+		{ "pre-trigger",     required_argument, NULL, 0 },
+		{ "pre-trigger-packets", required_argument, NULL, 0 },
 		{ "ring-buffer",     required_argument, NULL, 'b' },
 		{ "snapshot-length", required_argument, NULL, 's' },
 		{ "temp-dir",        required_argument, NULL, 0 },
+		{ "trigger",         required_argument, NULL, 0 },
 		{ "version",         no_argument,       NULL, 'v' },
+		{ "zero-copy",       no_argument,       NULL, 0 },
 		{ NULL },
 	};
 	int option_index, c;
@@ -373,6 +454,17 @@ static void parse_opts(int argc, char **argv)
 				file_prefix = optarg;
 			} else if (!strcmp(longopt, "temp-dir")) {
 				tmp_dir = optarg;
+			} else if (!strcmp(longopt, "zero-copy")) {
+				zero_copy = true;
+			} else if (!strcmp(longopt, "pre-trigger")) {
+				trigger.pre = get_seconds(optarg, "pre-trigger");
+			} else if (!strcmp(longopt, "pre-trigger-packets")) {
+				trigger.packets = get_uint(optarg,
+						"pre-trigger-packets", 0);
+			} else if (!strcmp(longopt, "post-trigger")) {
+				trigger.post = get_seconds(optarg, "post-trigger");
+			} else if (!strcmp(longopt, "trigger")) {
+				add_trigger(optarg);
 			} else if (!strcmp(longopt, "ifdescr")) {
 				if (last_intf == NULL)
 					rte_exit(EXIT_FAILURE,
@@ -470,6 +562,25 @@ static void parse_opts(int argc, char **argv)
 			exit(1);
 		}
 	}
+
+	if (trigger.pre == 0) {
+		if (trigger.latency_ns || trigger.drops || trigger.post)
+			rte_exit(EXIT_FAILURE,
+				 "Trigger options need --pre-trigger\n");
+	} else {
+		/* pcap format has no capture time recorded with the packet */
+		if (!use_pcapng)
+			rte_exit(EXIT_FAILURE,
+				 "--pre-trigger needs pcapng format\n");
+		/* would hold mbufs of the primary process for seconds */
+		if (zero_copy)
+			rte_exit(EXIT_FAILURE,
+				 "--pre-trigger can not be used with --zero-copy\n");
+		if (trigger.packets < BURST_SIZE)
+			rte_exit(EXIT_FAILURE,
+				 "--pre-trigger-packets must be at least %u\n",
+				 BURST_SIZE);
+	}
 }
 
 static void
@@ -663,6 +774,26 @@ static struct rte_ring *create_ring(void)
 	return ring;
 }
 
+/* Create ring of packets kept in memory until a trigger */
+static struct rte_ring *create_retain_ring(void)
+{
+	char ring_name[RTE_RING_NAMESIZE];
+	struct rte_ring *ring;
+
+	snprintf(ring_name, sizeof(ring_name),
+		 "dumpcap-retain-%d", getpid());
+
+	ring = rte_ring_create_elem(ring_name, sizeof(struct retained_pkt),
+				    trigger.packets, rte_socket_id(),
+				    RING_F_SP_ENQ | RING_F_SC_DEQ |
+				    RING_F_EXACT_SZ);
+	if (ring == NULL)
+		rte_exit(EXIT_FAILURE, "Could not create retain ring :%s\n",
+			 rte_strerror(rte_errno));
+
+	return ring;
+}
+
 static struct rte_mempool *create_mempool(void)
 {
 	const struct interface *intf;
@@ -673,6 +804,11 @@ static struct rte_mempool *create_mempool(void)
 
 	snprintf(pool_name, sizeof(pool_name), "capture_%d", getpid());
 
+	/* Zero copy uses a header, a trailer and one mbuf per segment */
+	if (zero_copy)
+		num_mbufs = 4 * ring_size;
+	num_mbufs += retain_ring ? trigger.packets : 0;
+
 	/* Common pool so size mbuf for biggest snap length */
 	TAILQ_FOREACH(intf, &interfaces, next) {
 		uint32_t mbuf_size = rte_pcapng_mbuf_size(intf->opts.snap_len);
@@ -796,6 +932,8 @@ static void enable_pdump(struct rte_ring *r, struct rte_mempool *mp)
 	flags = RTE_PDUMP_FLAG_RXTX;
 	if (use_pcapng)
 		flags |= RTE_PDUMP_FLAG_PCAPNG;
+	if (zero_copy)
+		flags |= RTE_PDUMP_FLAG_ZERO_COPY;
 
 	TAILQ_FOREACH(intf, &interfaces, next) {
 		ret = rte_pdump_enable_bpf(intf->port, RTE_PDUMP_ALL_QUEUES,
@@ -891,13 +1029,202 @@ pcap_write_packets(pcap_dumper_t *dumper,
 	return total;
 }
 
+/* Write packets to capture file and free them */
+static int write_packets(dumpcap_out_t out,
+			 struct rte_mbuf *pkts[], unsigned int n)
+{
+	ssize_t written;
+
+	if (use_pcapng)
+		written = rte_pcapng_write_packets(out.pcapng, pkts, n);
+	else
+		written = pcap_write_packets(out.dumper, pkts, n);
+
+	rte_pdump_free_bulk(pkts, n);
+
+	if (written < 0)
+		return -1;
+
+	file_size += written;
+	packets_received += n;
+	if (!quiet)
+		show_count(packets_received);
+
+	return 0;
+}
+
+/*
+ * Free retained packets older than the pre-trigger window,
+ * and the oldest ones if there is not room for more.
+ */
+static void expire_retained(uint64_t now, unsigned int room)
+{
+	uint64_t window = trigger.pre * rte_get_tsc_hz();
+	struct retained_pkt rp;
+
+	while (rte_ring_dequeue_bulk_elem_start(retain_ring, &rp,
+						sizeof(rp), 1, NULL) != 0) {
+		if (now - rp.tsc <= window &&
+		    rte_ring_free_count(retain_ring) >= room) {
+			rte_ring_dequeue_elem_finish(retain_ring, 0);
+			break;
+		}
+
+		rte_ring_dequeue_elem_finish(retain_ring, 1);
+		rte_pdump_free_bulk(&rp.mbuf, 1);
+	}
+}
+
+/* Keep packets in memory until a trigger */
+static void retain_packets(struct rte_mbuf *pkts[], unsigned int n)
+{
+	struct retained_pkt rp[BURST_SIZE];
+	uint64_t now = rte_get_tsc_cycles();
+	unsigned int i;
+
+	expire_retained(now, n);
+
+	for (i = 0; i < n; i++) {
+		rp[i].mbuf = pkts[i];
+		rp[i].tsc = now;
+	}
+	rte_ring_sp_enqueue_bulk_elem(retain_ring, rp, sizeof(rp[0]), n, NULL);
+}
+
+/* Write all packets kept in memory to the capture file */
+static int flush_retained(dumpcap_out_t out)
+{
+	struct retained_pkt rp[BURST_SIZE];
+	struct rte_mbuf *pkts[BURST_SIZE];
+	unsigned int i, n;
+
+	expire_retained(rte_get_tsc_cycles(), 0);
+
+	while ((n = rte_ring_sc_dequeue_burst_elem(retain_ring, rp, sizeof(rp[0]),
+						   BURST_SIZE, NULL)) != 0) {
+		for (i = 0; i < n; i++)
+			pkts[i] = rp[i].mbuf;
+
+		if (write_packets(out, pkts, n) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+/* Number of packets on the port with a latency above the threshold */
+static uint64_t latency_over(uint16_t port)
+{
+	static struct rte_latencystats_hist hist;
+	uint64_t count = 0;
+	unsigned int i;
+
+	if (rte_latencystats_hist_get(port, RTE_LATENCYSTATS_ALL_QUEUES,
+				      &hist) < 0)
+		return 0;
+
+	for (i = 0; i < RTE_LATENCYSTATS_HIST_BUCKETS; i++) {
+		if (rte_latencystats_hist_bucket_ns(i) >= trigger.latency_ns)
+			count += hist.buckets[i];
+	}
+
+	return count;
+}
+
+/*
+ * Check trigger conditions since last call.
+ * Returns the condition which fired, or NULL.
+ */
+static const char *check_triggers(void)
+{
+	const char *reason = NULL;
+	struct rte_eth_stats stats;
+	struct interface *intf;
+	uint64_t count;
+
+	if (rte_pdump_trigger_count(&count) == 0 && count != pdump_triggers) {
+		pdump_triggers = count;
+		reason = "/pdump/trigger";
+	}
+
+	TAILQ_FOREACH(intf, &interfaces, next) {
+		if (trigger.drops &&
+		    rte_eth_stats_get(intf->port, &stats) == 0) {
+			count = stats.imissed + stats.ierrors + stats.rx_nombuf;
+			if (count >= intf->drops &&
+			    count - intf->drops >= trigger.drops)
+				reason = "drops";
+			intf->drops = count;
+		}
+
+		if (trigger.latency_ns) {
+			count = latency_over(intf->port);
+			if (count > intf->slow_pkts)
+				reason = "latency";
+			intf->slow_pkts = count;
+		}
+	}
+
+	return reason;
+}
+
+/* Setup pre-trigger capture, before enabling capture */
+static void enable_trigger(void)
+{
+	struct rte_latencystats_hist hist;
+	struct interface *intf;
+
+	if (trigger.latency_ns) {
+		TAILQ_FOREACH(intf, &interfaces, next) {
+			if (rte_latencystats_hist_get(intf->port,
+					RTE_LATENCYSTATS_ALL_QUEUES, &hist) < 0)
+				rte_exit(EXIT_FAILURE,
+					 "Latency statistics not available on port %u\n",
+					 intf->port);
+		}
+	}
+
+	/* current values of the counters are the reference */
+	check_triggers();
+	trigger_check = rte_get_tsc_cycles();
+}
+
+/* Start writing to the capture file when a trigger fires */
+static int update_trigger(dumpcap_out_t out)
+{
+	uint64_t now = rte_get_tsc_cycles();
+	const char *reason;
+
+	if (now < trigger_check)
+		return 0;
+	trigger_check = now + rte_get_tsc_hz() * TRIGGER_INTERVAL_MS / 1000;
+
+	reason = check_triggers();
+	if (reason != NULL) {
+		if (!quiet)
+			fprintf(stderr, "\nTrigger on %s\n", reason);
+
+		if (trigger_end == 0 && flush_retained(out) < 0)
+			return -1;
+
+		/* later triggers extend the window */
+		trigger_end = now + (uint64_t)(trigger.post * rte_get_tsc_hz());
+		if (trigger_end == 0)
+			trigger_end = 1;
+	} else if (trigger_end != 0 && now >= trigger_end) {
+		/* back to keeping packets in memory */
+		trigger_end = 0;
+	}
+
+	return 0;
+}
+
 /* Process all packets in ring and dump to capture file */
 static int process_ring(dumpcap_out_t out, struct rte_ring *r)
 {
 	struct rte_mbuf *pkts[BURST_SIZE];
 	unsigned int avail, n;
 	static unsigned int empty_count;
-	ssize_t written;
 
 	n = rte_ring_sc_dequeue_burst(r, (void **) pkts, BURST_SIZE,
 				      &avail);
@@ -912,22 +1239,13 @@ static int process_ring(dumpcap_out_t out, struct rte_ring *r)
 
 	empty_count = (avail == 0);
 
-	if (use_pcapng)
-		written = rte_pcapng_write_packets(out.pcapng, pkts, n);
-	else
-		written = pcap_write_packets(out.dumper, pkts, n);
-
-	rte_pktmbuf_free_bulk(pkts, n);
-
-	if (written < 0)
-		return -1;
-
-	file_size += written;
-	packets_received += n;
-	if (!quiet)
-		show_count(packets_received);
+	/* waiting for a trigger */
+	if (retain_ring != NULL && trigger_end == 0) {
+		retain_packets(pkts, n);
+		return 0;
+	}
 
-	return 0;
+	return write_packets(out, pkts, n);
 }
 
 int main(int argc, char **argv)
@@ -970,9 +1288,14 @@ int main(int argc, char **argv)
 	}
 
 	r = create_ring();
+	if (trigger.pre != 0)
+		retain_ring = create_retain_ring();
 	mp = create_mempool();
 	out = create_output();
 
+	if (retain_ring != NULL)
+		enable_trigger();
+
 	start_time = time(NULL);
 	enable_pdump(r, mp);
 
@@ -982,7 +1305,8 @@ int main(int argc, char **argv)
 	}
 
 	while (!__atomic_load_n(&quit_signal, __ATOMIC_RELAXED)) {
-		if (process_ring(out, r) < 0) {
+		if (process_ring(out, r) < 0 ||
+		    (retain_ring != NULL && update_trigger(out) < 0)) {
 			fprintf(stderr, "pcapng file write failed; %s\n",
 				strerror(errno));
 			break;
@@ -1012,6 +1336,10 @@ int main(int argc, char **argv)
 	cleanup_pdump_resources();
 
 	rte_ring_free(r);
+	if (retain_ring != NULL) {
+		expire_retained(rte_get_tsc_cycles(), trigger.packets);
+		rte_ring_free(retain_ring);
+	}
 	rte_mempool_free(mp);
 
 	return rte_eal_cleanup() ? EXIT_FAILURE : 0;
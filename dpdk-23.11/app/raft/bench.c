@@ -0,0 +1,464 @@
+// bench.c
+#include "bench.h"
+#include "sim.h"
+#include "ports.h"
+#include "election.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <rte_common.h>
+
+/* The cluster under test: the simulator, or one real port per node */
+struct bench_backend {
+    const char *name;
+    int (*init)(const raft_config_t *cfg);
+    void (*fini)(void);
+    void (*run_until)(uint64_t end_us);
+    uint64_t (*now_us)(void);
+    void (*set_hook)(sim_hook_fn hook, void *arg);
+    uint32_t (*leader)(uint16_t group_id, uint32_t *term);
+    int (*node_state)(uint32_t node_id, uint16_t group_id,
+                      uint32_t *term, uint32_t *leader);
+    void (*node_set_up)(uint32_t node_id, bool up);
+    int (*node_restart)(uint32_t node_id);
+    void (*partition)(const bool *side);
+    void (*heal)(void);
+};
+
+static const struct bench_backend sim_backend = {
+    .name = "sim",
+    .init = sim_init,
+    .fini = sim_fini,
+    .run_until = sim_run_until,
+    .now_us = sim_now_us,
+    .set_hook = sim_set_hook,
+    .leader = sim_leader,
+    .node_state = sim_node_raft_state,
+    .node_set_up = sim_node_set_up,
+    .node_restart = sim_node_restart,
+    .partition = sim_partition,
+    .heal = sim_heal,
+};
+
+static const struct bench_backend ports_backend = {
+    .name = "ports",
+    .init = ports_init,
+    .fini = ports_fini,
+    .run_until = ports_run_until,
+    .now_us = ports_now_us,
+    .set_hook = ports_set_hook,
+    .leader = ports_leader,
+    .node_state = ports_node_raft_state,
+    .node_set_up = ports_node_set_up,
+    .node_restart = ports_node_restart,
+    .partition = ports_partition,
+    .heal = ports_heal,
+};
+
+static const struct bench_backend *be;
+
+/* How often a trial checks whether it is over, the metrics do not depend on it */
+#define BENCH_CHECK_US 1000
+
+static const char *const fault_names[FAULT_MAX] = {
+    [FAULT_CRASH] = "crash",
+    [FAULT_PAUSE] = "pause",
+    [FAULT_PARTITION] = "partition",
+};
+
+enum trial_status {
+    TRIAL_OK,
+    TRIAL_NO_LEADER,     /* nothing to attack after settle_ms */
+    TRIAL_TIMEOUT,       /* no majority behind a new leader within timeout_ms */
+};
+
+static const char *const status_names[] = {
+    [TRIAL_OK] = "ok",
+    [TRIAL_NO_LEADER] = "no_leader",
+    [TRIAL_TIMEOUT] = "timeout",
+};
+
+struct trial {
+    raft_fault_t fault;
+    enum trial_status status;
+    uint32_t victim;
+    uint32_t old_term;
+    uint32_t new_leader;
+    uint32_t new_term;
+    uint64_t detect_us;      /* fault -> a survivor starts an election */
+    uint64_t elect_us;       /* that election -> a survivor is leader */
+    uint64_t unavail_us;     /* fault -> a majority follows the new leader */
+};
+
+struct observation {
+    bool detected;
+    bool elected;
+    bool available;
+    uint32_t leader;
+    uint32_t term;
+};
+
+/* First time each stage was seen during a trial */
+struct watch {
+    uint32_t victim;
+    uint32_t old_term;
+    uint16_t group;
+    uint64_t t_detect, t_elect, t_avail;
+    bool detected, elected, available;
+    struct observation o;   /* as of t_avail */
+};
+
+#define METRIC_NUM 3
+static const char *const metric_names[METRIC_NUM] = {
+    "detect_us", "elect_us", "unavail_us",
+};
+
+static inline uint64_t trial_metric(const struct trial *t, int m)
+{
+    return m == 0 ? t->detect_us : m == 1 ? t->elect_us : t->unavail_us;
+}
+
+struct distribution {
+    uint32_t n;
+    uint64_t min, p50, p90, p99, max, mean;
+};
+
+static uint32_t member_num(void)
+{
+    uint32_t n = 0;
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+        n += global_config.member_map[id];
+    return n;
+}
+
+/* How far the survivors of group g got since the victim led it in old_term */
+static void observe(uint32_t victim, uint32_t old_term, uint16_t g,
+                    struct observation *o)
+{
+    uint32_t term, leader, followers = 0;
+
+    memset(o, 0, sizeof(*o));
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+    {
+        if (id == victim)
+            continue;
+        int state = be->node_state(id, g, &term, &leader);
+        if (state < 0 || term <= old_term)
+            continue;
+        o->detected = true;
+        if (state == STATE_LEADER && term >= o->term)
+        {
+            o->leader = id;
+            o->term = term;
+        }
+    }
+    if (o->leader == 0)
+        return;
+    o->elected = true;
+
+    // a recovered victim following the new leader counts as well
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+    {
+        if (be->node_state(id, g, &term, &leader) >= 0 &&
+            term == o->term && leader == o->leader)
+            followers++;
+    }
+    o->available = followers > member_num() / 2;
+}
+
+static void inject(raft_fault_t fault, uint32_t victim)
+{
+    bool side[MAX_NODES + 1] = {false};
+
+    switch (fault)
+    {
+    case FAULT_CRASH:
+    case FAULT_PAUSE:
+        be->node_set_up(victim, false);
+        break;
+    case FAULT_PARTITION:
+        side[victim] = true;
+        be->partition(side);
+        break;
+    default:
+        break;
+    }
+}
+
+static void recover(raft_fault_t fault, uint32_t victim)
+{
+    switch (fault)
+    {
+    case FAULT_CRASH:
+        be->node_restart(victim);
+        break;
+    case FAULT_PAUSE:
+        be->node_set_up(victim, true);
+        break;
+    case FAULT_PARTITION:
+        be->heal();
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Called by the backend after every packet delivery and timer pass on the
+ * simulator, after every polling round on ports: each stage is stamped
+ * when it happens, not when the trial loop next looks.
+ */
+static void watch_hook(void *arg)
+{
+    struct watch *w = arg;
+    struct observation o;
+
+    if (w->available)
+        return;
+    observe(w->victim, w->old_term, w->group, &o);
+    if (o.detected && !w->detected)
+    {
+        w->detected = true;
+        w->t_detect = be->now_us();
+    }
+    if (o.elected && !w->elected)
+    {
+        w->elected = true;
+        w->t_elect = be->now_us();
+    }
+    if (o.available)
+    {
+        w->available = true;
+        w->t_avail = be->now_us();
+        w->o = o;
+    }
+}
+
+static void run_trial(raft_fault_t fault, struct trial *t)
+{
+    const raft_bench_config_t *cfg = &global_config.bench;
+    struct watch w;
+
+    memset(t, 0, sizeof(*t));
+    t->fault = fault;
+    be->run_until(be->now_us() + cfg->settle_ms * 1000ULL);
+    t->victim = be->leader(cfg->group, &t->old_term);
+    if (t->victim == 0)
+    {
+        t->status = TRIAL_NO_LEADER;
+        return;
+    }
+
+    uint64_t t0 = be->now_us();
+    uint64_t t_recover = t0 + cfg->fault_ms * 1000ULL;
+    uint64_t t_end = t0 + cfg->timeout_ms * 1000ULL;
+    bool recovered = false;
+
+    memset(&w, 0, sizeof(w));
+    w.victim = t->victim;
+    w.old_term = t->old_term;
+    w.group = cfg->group;
+    inject(fault, t->victim);
+    be->set_hook(watch_hook, &w);
+    while (!w.available && be->now_us() < t_end)
+    {
+        uint64_t next = be->now_us() + BENCH_CHECK_US;
+        if (!recovered)
+            next = RTE_MIN(next, t_recover);
+        be->run_until(next);
+        if (!recovered && be->now_us() >= t_recover)
+        {
+            recover(fault, t->victim);
+            recovered = true;
+        }
+    }
+    be->set_hook(NULL, NULL);
+    if (!recovered)
+    {
+        be->run_until(t_recover);
+        recover(fault, t->victim);
+    }
+
+    if (!w.available)
+    {
+        t->status = TRIAL_TIMEOUT;
+        return;
+    }
+    t->status = TRIAL_OK;
+    t->new_leader = w.o.leader;
+    t->new_term = w.o.term;
+    t->detect_us = w.t_detect - t0;
+    t->elect_us = w.t_elect - w.t_detect;
+    t->unavail_us = w.t_avail - t0;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Nearest-rank percentile of n sorted samples */
+static inline uint64_t percentile(const uint64_t *v, uint32_t n, uint32_t p)
+{
+    uint32_t rank = (p * n + 99) / 100;
+    return v[rank > 0 ? rank - 1 : 0];
+}
+
+static void distribution_of(const struct trial *trials, uint32_t count,
+                            raft_fault_t fault, int metric,
+                            uint64_t *scratch, struct distribution *d)
+{
+    uint64_t sum = 0;
+
+    memset(d, 0, sizeof(*d));
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (trials[i].fault == fault && trials[i].status == TRIAL_OK)
+            scratch[d->n++] = trial_metric(&trials[i], metric);
+    }
+    if (d->n == 0)
+        return;
+    qsort(scratch, d->n, sizeof(*scratch), cmp_u64);
+    for (uint32_t i = 0; i < d->n; i++)
+        sum += scratch[i];
+    d->min = scratch[0];
+    d->p50 = percentile(scratch, d->n, 50);
+    d->p90 = percentile(scratch, d->n, 90);
+    d->p99 = percentile(scratch, d->n, 99);
+    d->max = scratch[d->n - 1];
+    d->mean = sum / d->n;
+}
+
+static void write_trials(FILE *fp, const struct trial *trials, uint32_t count)
+{
+    fprintf(fp, "trial,fault,status,victim,old_term,new_leader,new_term,"
+                "detect_us,elect_us,unavail_us\n");
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const struct trial *t = &trials[i];
+        fprintf(fp, "%u,%s,%s,%u,%u,%u,%u,%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+                i, fault_names[t->fault], status_names[t->status], t->victim,
+                t->old_term, t->new_leader, t->new_term,
+                t->detect_us, t->elect_us, t->unavail_us);
+    }
+}
+
+/* One JSON object with a distribution per fault type and metric */
+static void write_summary(FILE *fp, const struct trial *trials, uint32_t count,
+                          uint64_t *scratch)
+{
+    const raft_bench_config_t *cfg = &global_config.bench;
+    bool first = true;
+
+    fprintf(fp, "{\"backend\":\"%s\",\"seed\":%" PRIu64 ",\"nodes\":%u,\"groups\":%u,\"group\":%u,"
+                "\"step_us\":%u,\"delay_us\":%u,\"jitter_us\":%u,\"loss\":%g,"
+                "\"election_timeout_ms\":[%u,%u],\"heartbeat_interval_ms\":%u,"
+                "\"faults\":{",
+            be->name, global_config.sim.seed, member_num(), global_config.group_num, cfg->group,
+            global_config.sim.step_us, global_config.sim.delay_us,
+            global_config.sim.jitter_us, global_config.sim.loss,
+            global_config.election_timeout_min_ms, global_config.election_timeout_max_ms,
+            global_config.heartbeat_interval_ms);
+    for (int f = 0; f < FAULT_MAX; f++)
+    {
+        if (!cfg->faults[f])
+            continue;
+        uint32_t runs = 0, ok = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            runs += trials[i].fault == (raft_fault_t)f;
+            ok += trials[i].fault == (raft_fault_t)f && trials[i].status == TRIAL_OK;
+        }
+        fprintf(fp, "%s\"%s\":{\"trials\":%u,\"ok\":%u", first ? "" : ",",
+                fault_names[f], runs, ok);
+        first = false;
+        for (int m = 0; m < METRIC_NUM; m++)
+        {
+            struct distribution d;
+            distribution_of(trials, count, f, m, scratch, &d);
+            fprintf(fp, ",\"%s\":{\"min\":%" PRIu64 ",\"p50\":%" PRIu64 ",\"p90\":%" PRIu64
+                        ",\"p99\":%" PRIu64 ",\"max\":%" PRIu64 ",\"mean\":%" PRIu64 "}",
+                    metric_names[m], d.min, d.p50, d.p90, d.p99, d.max, d.mean);
+            printf("[BENCH] %-9s %-10s n=%u min=%" PRIu64 " p50=%" PRIu64 " p90=%" PRIu64
+                   " p99=%" PRIu64 " max=%" PRIu64 " mean=%" PRIu64 "\n",
+                   fault_names[f], metric_names[m], d.n, d.min, d.p50, d.p90, d.p99,
+                   d.max, d.mean);
+        }
+        fprintf(fp, "}");
+    }
+    fprintf(fp, "}}\n");
+}
+
+/* foo.csv -> foo.json, anything else gets .json appended */
+static void summary_path(const char *csv, char *out, size_t len)
+{
+    size_t n = strlen(csv);
+    if (n > 4 && strcmp(csv + n - 4, ".csv") == 0)
+        n -= 4;
+    snprintf(out, len, "%.*s.json", (int)n, csv);
+}
+
+/* transport "sim" or "ports" with bench.trials > 0 */
+int bench_main(void)
+{
+    const raft_bench_config_t *cfg = &global_config.bench;
+    uint32_t count = 0, max = cfg->trials * FAULT_MAX;
+    char json_path[sizeof(cfg->output) + 8];
+    int ret = -1;
+
+    // the benchmark injects every fault itself
+    global_config.test_auto_fail = false;
+    global_config.sim.partition_end_ms = 0;
+
+    struct trial *trials = calloc(max, sizeof(*trials));
+    uint64_t *scratch = calloc(max, sizeof(*scratch));
+    be = strcmp(global_config.transport, "ports") == 0 ? &ports_backend : &sim_backend;
+    if (trials == NULL || scratch == NULL || be->init(&global_config) < 0)
+        goto out;
+
+    // interleave fault types so that they see the same cluster history
+    for (uint32_t i = 0; i < cfg->trials; i++)
+    {
+        for (int f = 0; f < FAULT_MAX; f++)
+        {
+            if (!cfg->faults[f])
+                continue;
+            struct trial *t = &trials[count++];
+            run_trial(f, t);
+            printf("[BENCH] trial %u %s: %s victim=%u detect=%" PRIu64 "us elect=%" PRIu64
+                   "us unavailable=%" PRIu64 "us\n",
+                   count - 1, fault_names[f], status_names[t->status], t->victim,
+                   t->detect_us, t->elect_us, t->unavail_us);
+        }
+    }
+
+    FILE *fp = fopen(cfg->output, "w");
+    if (fp == NULL)
+    {
+        printf("[BENCH] cannot write %s\n", cfg->output);
+        goto fini;
+    }
+    write_trials(fp, trials, count);
+    fclose(fp);
+
+    summary_path(cfg->output, json_path, sizeof(json_path));
+    fp = fopen(json_path, "w");
+    if (fp == NULL)
+    {
+        printf("[BENCH] cannot write %s\n", json_path);
+        goto fini;
+    }
+    write_summary(fp, trials, count, scratch);
+    fclose(fp);
+    printf("[BENCH] %u trials written to %s and %s\n", count, cfg->output, json_path);
+    ret = 0;
+
+fini:
+    be->fini();
+out:
+    free(scratch);
+    free(trials);
+    return ret;
+}
@@ -24,36 +24,132 @@ static int parse_mac(const char *str, struct rte_ether_addr *mac) {
         &mac->addr_bytes[3], &mac->addr_bytes[4], &mac->addr_bytes[5]) == 6;
 }
 
+static uint32_t get_u32(json_t *obj, const char *key, uint32_t def) {
+    json_t *v = json_object_get(obj, key);
+    return v ? json_integer_value(v) : def;
+}
+
+static void parse_sim(json_t *sim, raft_sim_config_t *cfg) {
+    cfg->seed = get_u32(sim, "seed", 1);
+    cfg->duration_ms = get_u32(sim, "duration_ms", 10000);
+    cfg->step_us = get_u32(sim, "step_us", 100);
+    cfg->delay_us = get_u32(sim, "delay_us", 20);
+    cfg->jitter_us = get_u32(sim, "jitter_us", 10);
+    json_t *loss = json_object_get(sim, "loss");
+    cfg->loss = loss ? json_number_value(loss) : 0.0;
+
+    json_t *part = json_object_get(sim, "partition_nodes");
+    for (size_t i = 0; i < json_array_size(part); i++) {
+        uint32_t id = json_integer_value(json_array_get(part, i));
+        if (id >= 1 && id <= MAX_NODES)
+            cfg->partition_map[id] = true;
+    }
+    cfg->partition_start_ms = get_u32(sim, "partition_start_ms", 0);
+    cfg->partition_end_ms = get_u32(sim, "partition_end_ms", 0);
+    if (cfg->step_us == 0)
+        cfg->step_us = 100;
+}
+
+static int parse_bench(json_t *bench, raft_bench_config_t *cfg) {
+    static const char *const fault_names[FAULT_MAX] = {
+        [FAULT_CRASH] = "crash",
+        [FAULT_PAUSE] = "pause",
+        [FAULT_PARTITION] = "partition",
+    };
+
+    cfg->trials = get_u32(bench, "trials", 0);
+    cfg->group = get_u32(bench, "group", 0);
+    cfg->settle_ms = get_u32(bench, "settle_ms", 1000);
+    cfg->fault_ms = get_u32(bench, "fault_ms", 1000);
+    cfg->timeout_ms = get_u32(bench, "timeout_ms", 5000);
+    json_t *output = json_object_get(bench, "output");
+    snprintf(cfg->output, sizeof(cfg->output), "%s",
+             output ? json_string_value(output) : "failover_bench.csv");
+
+    json_t *faults = json_object_get(bench, "faults");
+    if (faults == NULL) {
+        for (int f = 0; f < FAULT_MAX; f++)
+            cfg->faults[f] = true;
+        return 0;
+    }
+    for (size_t i = 0; i < json_array_size(faults); i++) {
+        const char *name = json_string_value(json_array_get(faults, i));
+        int f;
+        for (f = 0; f < FAULT_MAX; f++) {
+            if (name != NULL && strcmp(name, fault_names[f]) == 0)
+                break;
+        }
+        if (f == FAULT_MAX) {
+            fprintf(stderr, "bench.faults: unknown fault \"%s\"\n", name ? name : "");
+            return -1;
+        }
+        cfg->faults[f] = true;
+    }
+    return 0;
+}
+
 /*make global.config available*/
 int load_config(const char *filename) {
+    return load_config_into(filename, &global_config);
+}
+
+/* parse filename into cfg, also used to re-read membership at runtime */
+int load_config_into(const char *filename, raft_config_t *cfg) {
     json_error_t error;
     json_t *root = json_load_file(filename, 0, &error);
     if (!root) {
         fprintf(stderr, "JSON parse error: %s\n", error.text);
         return -1;
     }
-    global_config.node_num = json_integer_value(json_object_get(root, "node_num"));
-    global_config.node_id = json_integer_value(json_object_get(root, "node_id"));
-    global_config.port_id = json_integer_value(json_object_get(root, "port_id"));
-    global_config.election_timeout_min_ms = json_integer_value(json_object_get(root, "election_timeout_min_ms"));
-    global_config.election_timeout_max_ms = json_integer_value(json_object_get(root, "election_timeout_max_ms"));
-    global_config.heartbeat_interval_ms = json_integer_value(json_object_get(root, "heartbeat_interval_ms"));
-    global_config.test_auto_fail_timeout_ms = json_integer_value(json_object_get(root, "test_auto_fail_timeout_ms"));
-    global_config.test_auto_fail_duration_ms = json_integer_value(json_object_get(root, "test_auto_fail_duration_ms"));
-    global_config.test_auto_fail = json_is_true(json_object_get(root, "test_auto_fail"));
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->node_num = json_integer_value(json_object_get(root, "node_num"));
+    cfg->node_id = json_integer_value(json_object_get(root, "node_id"));
+    cfg->port_id = json_integer_value(json_object_get(root, "port_id"));
+    json_t *group_num = json_object_get(root, "group_num");
+    cfg->group_num = group_num ? json_integer_value(group_num) : 1;
+    if (cfg->group_num == 0 || cfg->group_num > RAFT_MAX_GROUPS) {
+        fprintf(stderr, "group_num must be in [1, %d]\n", RAFT_MAX_GROUPS);
+        json_decref(root);
+        return -1;
+    }
+    cfg->election_timeout_min_ms = json_integer_value(json_object_get(root, "election_timeout_min_ms"));
+    cfg->election_timeout_max_ms = json_integer_value(json_object_get(root, "election_timeout_max_ms"));
+    cfg->heartbeat_interval_ms = json_integer_value(json_object_get(root, "heartbeat_interval_ms"));
+    cfg->test_auto_fail_timeout_ms = json_integer_value(json_object_get(root, "test_auto_fail_timeout_ms"));
+    cfg->test_auto_fail_duration_ms = json_integer_value(json_object_get(root, "test_auto_fail_duration_ms"));
+    cfg->test_auto_fail = json_is_true(json_object_get(root, "test_auto_fail"));
+
+    if (parse_bench(json_object_get(root, "bench"), &cfg->bench) < 0) {
+        json_decref(root);
+        return -1;
+    }
+    if (cfg->bench.trials > 0 && cfg->bench.group >= cfg->group_num) {
+        fprintf(stderr, "bench.group must be below group_num\n");
+        json_decref(root);
+        return -1;
+    }
+
+    json_t *transport = json_object_get(root, "transport");
+    snprintf(cfg->transport, sizeof(cfg->transport), "%s",
+             transport ? json_string_value(transport) : "ethdev");
+    parse_sim(json_object_get(root, "sim"), &cfg->sim);
 
     json_t *ip_map = json_object_get(root, "ip_map");
     json_t *mac_map = json_object_get(root, "mac_map");
+    json_t *port_map = json_object_get(root, "port_map");
 
     for (int i = 1; i <= MAX_NODES; i++) {
         char key[4];
         snprintf(key, sizeof(key), "%d", i);
         json_t *ip = json_object_get(ip_map, key);
         json_t *mac = json_object_get(mac_map, key);
+        // transport "ports": node i on port i - 1 unless port_map says otherwise
+        cfg->port_map[i] = get_u32(port_map, key, i - 1);
         if (!ip || !mac) continue; // skip null
 
-        strncpy(global_config.ip_map[i], json_string_value(ip), 16);
-        parse_mac(json_string_value(mac), &global_config.mac_map[i]);
+        strncpy(cfg->ip_map[i], json_string_value(ip), 15);
+        if (parse_mac(json_string_value(mac), &cfg->mac_map[i]))
+            cfg->member_map[i] = true;
     }
 
     json_decref(root);
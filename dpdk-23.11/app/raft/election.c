@@ -2,51 +2,69 @@
 #include "election.h"
 #include "networking.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-#include <rte_timer.h>
-#include <rte_cycles.h>
-#include <rte_time.h>
+#include <rte_common.h>
+#include <rte_random.h>
 #include "timeout.h"
 #include "config.h"
+#include "membership.h"
 
-// typedef struct {
-//     uint32_t self_id;
-//     uint32_t current_term;
-//     uint32_t voted_for;
-//     uint32_t vote_granted;
-//     raft_state_t current_state;
-//     uint64_t last_heard_us;
-// } raft_node_t;
-static int test_auto_fail_enabled = 0;
-static uint64_t election_start_time = 0;
-static raft_node_t raft_node;
-static struct rte_timer election_timer;
-static void election_timeout_cb(struct rte_timer *t, void *arg);
+/*
+ * Everything a node knows about its Raft groups. It is reached through a
+ * pointer so that the simulator can host several nodes in one process
+ * and switch between them with election_state_select().
+ */
+struct election_state {
+    int test_auto_fail_enabled;
+    uint32_t self_node_id;
+    uint32_t leader_groups; /* number of groups this node currently leads */
+    struct raft_timer fail_timer;    /* trigger auto-fail */
+    struct raft_timer recover_timer; /* trigger auto-recovery */
+    /* All Raft groups hosted by this node share the port, the timing
+     * wheel and the heartbeat packets sent to each peer. */
+    raft_node_t groups[RAFT_MAX_GROUPS];
+};
+
+static struct election_state *es;
+static void election_timeout_cb(struct raft_timer *t, void *arg);
+
+struct election_state *election_state_create(void)
+{
+    return calloc(1, sizeof(struct election_state));
+}
+
+void election_state_free(struct election_state *st)
+{
+    if (es == st)
+        es = NULL;
+    free(st);
+}
+
+void election_state_select(struct election_state *st)
+{
+    es = st;
+}
 
 /* Implementing Test Auto Fail */
-static struct rte_timer fail_timer;    /* trigger auto-fail */
-static struct rte_timer recover_timer; /* trigger auto-recovery */
 static void test_auto_fail_enable(int enabled)
 {
-    test_auto_fail_enabled = enabled;
+    es->test_auto_fail_enabled = enabled;
     printf("Test auto-fail %s\n", enabled ? "enabled" : "disabled");
 }
 
-static void fail_disable_cb(__rte_unused struct rte_timer *t, void *arg)
+static void fail_disable_cb(__rte_unused struct raft_timer *t, void *arg)
 {
     (void)arg;
     test_auto_fail_enable(0);
 }
 
-static void fail_enable_cb(__rte_unused struct rte_timer *t, void *arg)
+static void fail_enable_cb(__rte_unused struct raft_timer *t, void *arg)
 {
     (void)arg;
     test_auto_fail_enable(1);
-    uint64_t cycles = (uint64_t)global_config.test_auto_fail_duration_ms *
-                      rte_get_timer_hz() / 1000;
-    rte_timer_init(&recover_timer);
-    rte_timer_reset(&recover_timer, cycles, SINGLE, rte_lcore_id(),
-                    fail_disable_cb, NULL);
+    timeout_start(&es->recover_timer, global_config.test_auto_fail_duration_ms,
+                  fail_disable_cb, NULL);
 }
 
 /* End of Test Auto Fail */
@@ -54,188 +72,317 @@ static void fail_enable_cb(__rte_unused struct rte_timer *t, void *arg)
 /* Timer for microsecond */
 static inline uint64_t monotonic_us(void)
 {
-    return rte_get_timer_cycles() * 1000000ULL / rte_get_timer_hz();
+    return timeout_now_us();
 }
 /* Implement Raft Packet Broadcast Function*/
 static void broadcast_raft_packet(struct raft_packet *pkt)
 {
-    for (uint32_t peer = 1; peer <= global_config.node_num; peer++)
+    const struct raft_peer_table *peers = membership_get();
+    for (uint32_t peer = 1; peer <= MAX_NODES; peer++)
     {
-        if (peer == raft_node.self_id)
+        if (peer == es->self_node_id || !peers->peers[peer].member)
             continue;
         send_raft_packet(pkt, peer);
     }
 }
+static void broadcast_raft_payload(const void *payload, uint16_t len)
+{
+    const struct raft_peer_table *peers = membership_get();
+    for (uint32_t peer = 1; peer <= MAX_NODES; peer++)
+    {
+        if (peer == es->self_node_id || !peers->peers[peer].member)
+            continue;
+        send_raft_payload(payload, len, peer);
+    }
+}
+
+static inline raft_node_t *get_group(uint16_t group_id)
+{
+    if (group_id >= global_config.group_num)
+        return NULL;
+    return &es->groups[group_id];
+}
+
+/* Keep leader_groups in sync with the per-group state */
+static void set_state(raft_node_t *node, raft_state_t state)
+{
+    if (node->current_state == STATE_LEADER && state != STATE_LEADER)
+        es->leader_groups--;
+    else if (node->current_state != STATE_LEADER && state == STATE_LEADER)
+        es->leader_groups++;
+    node->current_state = state;
+}
+
 void raft_init(uint32_t id)
 {
-    memset(&raft_node, 0, sizeof(raft_node));
-    raft_node.self_id = id;
-    raft_node.current_state = STATE_FOLLOWER;
-    raft_node.current_term = 0;
-    raft_node.voted_for = 0;
-    raft_node.vote_granted = 0;
-    raft_node.last_heard_us = 0;
-    printf("Raft init: node_id=%u\n", raft_node.self_id);
+    memset(es, 0, sizeof(*es));
+    es->self_node_id = id;
+    timeout_timer_init(&es->fail_timer);
+    timeout_timer_init(&es->recover_timer);
     timeout_init(global_config.election_timeout_min_ms, global_config.election_timeout_max_ms);
-    timeout_start_election(&election_timer, election_timeout_cb, NULL);
+    for (uint32_t g = 0; g < global_config.group_num; g++)
+    {
+        raft_node_t *node = &es->groups[g];
+
+        node->self_id = id;
+        node->group_id = g;
+        node->current_state = STATE_FOLLOWER;
+        timeout_timer_init(&node->election_timer);
+        timeout_start_election(&node->election_timer, election_timeout_cb, node);
+    }
+    printf("Raft init: node_id=%u, groups=%u\n", id, global_config.group_num);
 }
-static void start_election(void)
+static void start_election(raft_node_t *node)
 {
 
-    raft_node.current_state = STATE_CANDIDATE;
-    raft_node.current_term++;
-    raft_node.voted_for = raft_node.self_id;
-    raft_node.vote_granted = 1;
-    raft_node.last_heard_us = monotonic_us();
+    set_state(node, STATE_CANDIDATE);
+    node->current_term++;
+    node->voted_for = node->self_id;
+    node->vote_granted = 1;
+    node->leader_id = 0;
+    node->last_heard_us = monotonic_us();
 
-    printf("Node %u starting election for term %u\n", raft_node.self_id, raft_node.current_term);
+    printf("Node %u group %u starting election for term %u\n",
+           node->self_id, node->group_id, node->current_term);
 
     struct raft_packet pkt = {
         .msg_type = MSG_VOTE_REQUEST,
-        .term = raft_node.current_term,
-        .node_id = raft_node.self_id,
+        .term = node->current_term,
+        .node_id = node->self_id,
+        .group_id = node->group_id,
     };
     broadcast_raft_packet(&pkt);
-    timeout_start_election(&election_timer, election_timeout_cb, NULL);
+    timeout_start_election(&node->election_timer, election_timeout_cb, node);
+}
+
+/* A higher term always turns the group back into a follower */
+static void step_down_if_stale(raft_node_t *node, uint32_t term)
+{
+    if (term > node->current_term)
+    {
+        node->current_term = term;
+        set_state(node, STATE_FOLLOWER);
+        node->voted_for = 0;
+        node->leader_id = 0;
+        timeout_start_election(&node->election_timer,
+                               election_timeout_cb,
+                               node);
+    }
+}
+
+static void handle_heartbeat(raft_node_t *node, uint32_t term,
+                             uint32_t leader_id, uint64_t now_us)
+{
+    if (term < node->current_term)
+        return;
+
+    set_state(node, STATE_FOLLOWER);
+    node->current_term = term;
+    node->last_heard_us = now_us;
+    timeout_start_election(&node->election_timer,
+                           election_timeout_cb,
+                           node);
+    if (node->leader_id != leader_id)
+    {
+        node->leader_id = leader_id;
+        printf("Node %u group %u follows leader %u in term %u\n",
+               node->self_id, node->group_id, leader_id, term);
+    }
 }
+
 void raft_handle_packet(const struct raft_packet *pkt, uint16_t port)
 {
     (void)port;
-    if (test_auto_fail_enabled)
+    if (es->test_auto_fail_enabled)
         return; // Suppose this node is down for testing
+    raft_node_t *node = get_group(pkt->group_id);
+    if (node == NULL || !membership_is_member(pkt->node_id))
+        return; // removed servers must not disrupt the cluster
     uint64_t now_us = monotonic_us();
-    if (pkt->term > raft_node.current_term)
-    {
-        raft_node.current_term = pkt->term;
-        raft_node.current_state = STATE_FOLLOWER;
-        raft_node.voted_for = 0;
-        timeout_start_election(&election_timer,
-                               election_timeout_cb,
-                               NULL);
-    }
+    step_down_if_stale(node, pkt->term);
 
     switch (pkt->msg_type)
     {
     case MSG_VOTE_REQUEST:
-        if (raft_node.current_state == STATE_FOLLOWER &&
-            (raft_node.voted_for == 0 || raft_node.voted_for == pkt->node_id))
+        if (node->current_state == STATE_FOLLOWER &&
+            (node->voted_for == 0 || node->voted_for == pkt->node_id))
         {
-            raft_node.voted_for = pkt->node_id;
-            raft_node.last_heard_us = now_us;
-            timeout_start_election(&election_timer,
+            node->voted_for = pkt->node_id;
+            node->last_heard_us = now_us;
+            timeout_start_election(&node->election_timer,
                                    election_timeout_cb,
-                                   NULL);
+                                   node);
 
             struct raft_packet resp = {
                 .msg_type = MSG_VOTE_RESPONSE,
-                .term = raft_node.current_term,
-                .node_id = raft_node.self_id,
+                .term = node->current_term,
+                .node_id = node->self_id,
+                .group_id = node->group_id,
             };
             send_raft_packet(&resp, pkt->node_id);
-            printf("Node %u granted vote to %u in term %u\n",
-                   raft_node.self_id, pkt->node_id, raft_node.current_term);
+            printf("Node %u group %u granted vote to %u in term %u\n",
+                   node->self_id, node->group_id, pkt->node_id, node->current_term);
         }
         break;
 
     case MSG_VOTE_RESPONSE:
-        if (raft_node.current_state == STATE_CANDIDATE && pkt->term == raft_node.current_term)
+        if (node->current_state == STATE_CANDIDATE && pkt->term == node->current_term)
         {
-            raft_node.vote_granted++;
-            printf("Node %u received vote from %u (total: %u/%u)\n",
-                   raft_node.self_id, pkt->node_id, raft_node.vote_granted, global_config.node_num);
-            if (raft_node.vote_granted > global_config.node_num / 2)
+            uint32_t member_num = membership_get()->member_num;
+            node->vote_granted++;
+            printf("Node %u group %u received vote from %u (total: %u/%u)\n",
+                   node->self_id, node->group_id, pkt->node_id,
+                   node->vote_granted, member_num);
+            if (node->vote_granted > member_num / 2)
             {
-                raft_node.current_state = STATE_LEADER;
+                set_state(node, STATE_LEADER);
+                node->leader_id = node->self_id;
                 uint64_t elect_time = monotonic_us();
-                printf("[RAFT] Node %u: Elected as leader, T_elect = %lu us, [Election latency] is %lu us\n",
-                       raft_node.self_id, elect_time, elect_time - election_start_time);
+                printf("[RAFT] Node %u group %u: Elected as leader, T_elect = %lu us, [Election latency] is %lu us\n",
+                       node->self_id, node->group_id, elect_time,
+                       elect_time - node->election_start_time);
                 FILE *fp = fopen("failover_stats.csv", "a");
-                fprintf(fp, "elect,%lu,%lu,%lu\n",
-                        raft_node.self_id,
+                fprintf(fp, "elect,%u,%lu,%lu,%u\n",
+                        node->self_id,
                         elect_time,
-                        elect_time - election_start_time);
+                        elect_time - node->election_start_time,
+                        node->group_id);
                 fclose(fp);
 
-                raft_send_heartbeat();
-                if (raft_node.vote_granted > global_config.node_num)
-                    raft_node.vote_granted = global_config.node_num;
-                timeout_stop(&election_timer);
-                if (global_config.test_auto_fail)
+                /* assert leadership of this group right away */
+                struct raft_packet hb = {
+                    .msg_type = MSG_HEARTBEAT,
+                    .term = node->current_term,
+                    .node_id = node->self_id,
+                    .group_id = node->group_id,
+                };
+                broadcast_raft_packet(&hb);
+                if (node->vote_granted > member_num)
+                    node->vote_granted = member_num;
+                timeout_stop(&node->election_timer);
+                if (global_config.test_auto_fail && es->leader_groups == 1)
                 {
                     uint64_t delay = global_config.test_auto_fail_timeout_ms + rte_rand() % (global_config.test_auto_fail_timeout_ms +1);
-                    uint64_t cycles = (uint64_t)delay *
-                                      rte_get_timer_hz() / 1000;
-                    rte_timer_init(&fail_timer);
-                    rte_timer_reset(&fail_timer, cycles, SINGLE, rte_lcore_id(),
-                                    fail_enable_cb, NULL);
+                    timeout_start(&es->fail_timer, delay, fail_enable_cb, NULL);
                 }
             }
         }
         break;
 
     case MSG_HEARTBEAT:
-        if (pkt->term >= raft_node.current_term)
-        {
-            raft_node.current_state = STATE_FOLLOWER;
-            raft_node.current_term = pkt->term;
-            raft_node.last_heard_us = now_us;
-
-            timeout_start_election(&election_timer,
-                                   election_timeout_cb,
-                                   NULL);
-            printf("Node %u received heartbeat from leader %u\n",
-                   raft_node.self_id, pkt->node_id);
-        }
+        handle_heartbeat(node, pkt->term, pkt->node_id, now_us);
         break;
     }
 }
 
+void raft_handle_heartbeat_batch(const struct raft_heartbeat_batch *batch,
+                                 uint16_t len, uint16_t port)
+{
+    (void)port;
+    if (es->test_auto_fail_enabled)
+        return; // Suppose this node is down for testing
+    if (len < RAFT_HB_BATCH_SIZE(0) || batch->count > RAFT_HB_BATCH_MAX ||
+        len < RAFT_HB_BATCH_SIZE(batch->count))
+        return;
+    if (!membership_is_member(batch->node_id))
+        return;
+
+    uint64_t now_us = monotonic_us();
+    for (uint16_t i = 0; i < batch->count; i++)
+    {
+        const struct raft_heartbeat_entry *e = &batch->entries[i];
+        raft_node_t *node = get_group(e->group_id);
+        if (node == NULL)
+            continue;
+        step_down_if_stale(node, e->term);
+        handle_heartbeat(node, e->term, batch->node_id, now_us);
+    }
+}
+
+/*
+ * Heartbeats of all groups led by this node are coalesced: every peer
+ * receives one MSG_HEARTBEAT_BATCH packet per RAFT_HB_BATCH_MAX groups
+ * instead of one packet per group.
+ */
 void raft_send_heartbeat(void)
 {
-    if (raft_node.current_state != STATE_LEADER || test_auto_fail_enabled)
+    static struct raft_heartbeat_batch batch;
+
+    if (es->leader_groups == 0 || es->test_auto_fail_enabled)
         return;
 
-    struct raft_packet pkt = {
-        .msg_type = MSG_HEARTBEAT,
-        .term = raft_node.current_term,
-        .node_id = raft_node.self_id,
-    };
-    broadcast_raft_packet(&pkt);
+    batch.msg_type = MSG_HEARTBEAT_BATCH;
+    batch.node_id = es->self_node_id;
+    batch.count = 0;
+    for (uint32_t g = 0; g < global_config.group_num; g++)
+    {
+        const raft_node_t *node = &es->groups[g];
+        if (node->current_state != STATE_LEADER)
+            continue;
+
+        batch.entries[batch.count].group_id = node->group_id;
+        batch.entries[batch.count].term = node->current_term;
+        if (++batch.count == RAFT_HB_BATCH_MAX)
+        {
+            broadcast_raft_payload(&batch, RAFT_HB_BATCH_SIZE(batch.count));
+            batch.count = 0;
+        }
+    }
+    if (batch.count > 0)
+        broadcast_raft_payload(&batch, RAFT_HB_BATCH_SIZE(batch.count));
 }
 
 uint32_t raft_get_node_id(void)
 {
-    return raft_node.self_id;
+    return es->self_node_id;
+}
+uint32_t raft_get_term(uint16_t group_id)
+{
+    raft_node_t *node = get_group(group_id);
+    return node ? node->current_term : 0;
+}
+uint32_t raft_get_leader(uint16_t group_id)
+{
+    raft_node_t *node = get_group(group_id);
+    return node ? node->leader_id : 0;
 }
-uint32_t raft_get_term(void)
+raft_state_t raft_get_state(uint16_t group_id)
 {
-    return raft_node.current_term;
+    raft_node_t *node = get_group(group_id);
+    return node ? node->current_state : STATE_FOLLOWER;
 }
-raft_state_t raft_get_state(void)
+uint32_t raft_get_leader_count(void)
 {
-    return raft_node.current_state;
+    return es->leader_groups;
 }
-static void election_timeout_cb(struct rte_timer *t, void *arg)
+static void election_timeout_cb(struct raft_timer *t, void *arg)
 {
     (void)t;
-    (void)arg;
+    raft_node_t *node = arg;
 
     uint64_t detect_time = monotonic_us();
-    if (raft_node.current_state != STATE_LEADER)
+    if (!membership_is_member(node->self_id))
+    {
+        // not a voter (yet or any more): stay passive but keep listening
+        timeout_start_election(&node->election_timer, election_timeout_cb, node);
+        return;
+    }
+    if (node->current_state != STATE_LEADER)
     {
-        printf("[RAFT] Node %u: Detected leader failure, T_detect = %lu us, [Detection latency] is %lu us\n",
-               raft_node.self_id, detect_time, detect_time - raft_node.last_heard_us);
-        election_start_time = detect_time;
-        if (raft_node.last_heard_us != 0)
+        printf("[RAFT] Node %u group %u: Detected leader failure, T_detect = %lu us, [Detection latency] is %lu us\n",
+               node->self_id, node->group_id, detect_time, detect_time - node->last_heard_us);
+        node->election_start_time = detect_time;
+        if (node->last_heard_us != 0)
         {
             FILE *fp = fopen("failover_stats.csv", "a");
-            fprintf(fp, "detect,%lu,%lu,%lu\n",
-                    raft_node.self_id,
+            fprintf(fp, "detect,%u,%lu,%lu,%u\n",
+                    node->self_id,
                     detect_time,
-                    detect_time - raft_node.last_heard_us);
+                    detect_time - node->last_heard_us,
+                    node->group_id);
             fclose(fp);
         }
 
-        start_election();
+        start_election(node);
     }
 }
@@ -0,0 +1,14 @@
+// include/bench.h
+#ifndef BENCH_H
+#define BENCH_H
+
+/*
+ * Failover benchmark, on the simulator or on one real port per node:
+ * repeatedly settles the cluster, injects a crash, pause or partition
+ * into the leader of one group and measures how long the survivors take
+ * to notice, to elect a new leader and to have a majority following it
+ * again.
+ */
+int bench_main(void);
+
+#endif // BENCH_H
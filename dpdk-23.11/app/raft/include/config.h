@@ -4,21 +4,61 @@
 #include <stdbool.h>
 
 #define MAX_NODES 16
+#define RAFT_MAX_GROUPS 1024
+
+/* In-process simulator settings, the "sim" object of config.json */
+typedef struct {
+    uint64_t seed;                           /**< seeds rte_rand for a reproducible run */
+    uint32_t duration_ms;                    /**< virtual time to simulate */
+    uint32_t step_us;                        /**< virtual time between timer polls */
+    uint32_t delay_us;                       /**< one-way delay of every link */
+    uint32_t jitter_us;                      /**< extra uniform delay in [0, jitter_us] */
+    double loss;                             /**< drop probability per packet */
+    bool partition_map[MAX_NODES+1];         /**< nodes cut off from the rest ... */
+    uint32_t partition_start_ms;             /**< ... from this virtual time ... */
+    uint32_t partition_end_ms;               /**< ... until this one */
+} raft_sim_config_t;
+
+/* Fault injected into the leader by the failover benchmark */
+typedef enum {
+    FAULT_CRASH,        /**< process dies, restarts with no state */
+    FAULT_PAUSE,        /**< process stops, resumes with its old state */
+    FAULT_PARTITION,    /**< process keeps running, cut off from the rest */
+    FAULT_MAX
+} raft_fault_t;
+
+/* Failover benchmark settings, the "bench" object of config.json */
+typedef struct {
+    uint32_t trials;                         /**< trials per fault type, 0 = no benchmark */
+    bool faults[FAULT_MAX];                  /**< fault types to run */
+    uint32_t group;                          /**< group whose leader is attacked */
+    uint32_t settle_ms;                      /**< healthy run before each fault */
+    uint32_t fault_ms;                       /**< how long the fault lasts */
+    uint32_t timeout_ms;                     /**< give up on a trial after this */
+    char output[64];                         /**< per-trial CSV, summary goes to output.json */
+} raft_bench_config_t;
 
 typedef struct {
     uint32_t node_num;
     uint32_t node_id;
     uint32_t port_id;
+    uint32_t group_num;                      /**< Raft groups multiplexed on this port */
     char ip_map[MAX_NODES+1][16];              
     struct rte_ether_addr mac_map[MAX_NODES+1];
+    bool member_map[MAX_NODES+1];            /**< ids listed in both ip_map and mac_map */
     uint32_t election_timeout_min_ms;
     uint32_t election_timeout_max_ms;
     uint32_t heartbeat_interval_ms;
     uint32_t test_auto_fail_timeout_ms;      /**< Timeout for auto-fail test */
     uint32_t test_auto_fail_duration_ms;     /**< Duration for auto-fail test */
     bool test_auto_fail;                /**< Enable auto-fail test */
+    uint16_t port_map[MAX_NODES+1];          /**< port of each node with transport "ports" */
+    char transport[16];                      /**< "ethdev" (default), "sim" or "ports" */
+    raft_sim_config_t sim;                   /**< used when transport is "sim" */
+    raft_bench_config_t bench;               /**< failover benchmark, "sim" or "ports" */
 } raft_config_t;
 
 extern raft_config_t global_config;
 
 int load_config(const char *filename);
+int load_config_into(const char *filename, raft_config_t *cfg);
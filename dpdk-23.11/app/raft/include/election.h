@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "packet.h"
+#include "timeout.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -16,23 +17,37 @@ typedef enum {
     STATE_LEADER
 } raft_state_t;
 
+/* State of one Raft group; every group has its own term and election timer */
 typedef struct {
     uint32_t self_id;
+    uint16_t group_id;
     uint32_t current_term;
     uint32_t voted_for;
     uint32_t vote_granted;
+    uint32_t leader_id;
     raft_state_t current_state;
     uint64_t last_heard_us;
+    uint64_t election_start_time;
+    struct raft_timer election_timer;
 } raft_node_t;
 
+/* Per-node state of all groups, selected before calling into this module */
+struct election_state;
+
+struct election_state *election_state_create(void);
+void election_state_free(struct election_state *st);
+void election_state_select(struct election_state *st);
 
 void raft_init(uint32_t self_id);
-void raft_tick(uint64_t now_ms);
 void raft_handle_packet(const struct raft_packet *pkt, uint16_t port);
-raft_state_t raft_get_state(void);
+void raft_handle_heartbeat_batch(const struct raft_heartbeat_batch *batch,
+                                 uint16_t len, uint16_t port);
+raft_state_t raft_get_state(uint16_t group_id);
+uint32_t raft_get_leader_count(void);
 void raft_send_heartbeat(void);
 uint32_t raft_get_node_id(void);
-uint32_t raft_get_term(void);
+uint32_t raft_get_term(uint16_t group_id);
+uint32_t raft_get_leader(uint16_t group_id);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,26 @@
+// include/instance.h
+#ifndef INSTANCE_H
+#define INSTANCE_H
+
+#include <stdint.h>
+#include "election.h"
+#include "membership.h"
+#include "timeout.h"
+
+/*
+ * One Raft node: the state of every module that is private to a node.
+ * A process normally hosts a single instance; the simulator hosts one
+ * per simulated node and selects the one it is about to drive.
+ */
+struct raft_instance {
+    uint32_t node_id;
+    struct election_state *election;
+    struct membership_state *membership;
+    struct timeout_state *timeout;
+};
+
+struct raft_instance *raft_instance_create(uint32_t node_id);
+void raft_instance_select(struct raft_instance *inst);
+void raft_instance_free(struct raft_instance *inst);
+
+#endif // INSTANCE_H
@@ -0,0 +1,48 @@
+// include/membership.h
+#ifndef MEMBERSHIP_H
+#define MEMBERSHIP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <rte_ether.h>
+#include "config.h"
+#include "packet.h"
+
+struct raft_peer {
+    bool member;                 // voting member of the current configuration
+    uint32_t ip;                 // network byte order
+    struct rte_ether_addr mac;   // kept after removal so the node can be told
+};
+
+/*
+ * Cluster membership. The table is never modified in place: a change
+ * publishes a new copy and the old one is freed through an RCU QSBR
+ * defer queue once every reader lcore has gone through a quiescent state.
+ */
+struct raft_peer_table {
+    uint32_t version;            // bumped by every membership change
+    uint32_t term;               // group 0 term of the leader that made or sent it
+    uint32_t member_num;         // number of voting members
+    struct raft_peer peers[MAX_NODES + 1]; // 1-based like config ip_map
+};
+
+/* Per-node membership state, selected before calling into this module */
+struct membership_state;
+
+struct membership_state *membership_state_create(void);
+void membership_state_free(struct membership_state *st);
+void membership_state_select(struct membership_state *st);
+
+int membership_init(uint32_t self_id);
+void membership_register_reader(void);
+void membership_quiescent(void);
+
+const struct raft_peer_table *membership_get(void);
+bool membership_is_member(uint32_t node_id);
+
+void membership_request_reload(void);
+void membership_tick(void);
+void membership_handle_sync(const struct raft_config_sync *sync, uint16_t len);
+void membership_handle_ack(const struct raft_config_ack *ack, uint16_t len);
+
+#endif // MEMBERSHIP_H
@@ -6,8 +6,28 @@
 #include <rte_udp.h>
 #include "packet.h"
 
+/*
+ * Transport carrying Raft payloads between nodes. The source node is the
+ * currently selected instance (raft_get_node_id()). The ethdev transport
+ * frames payloads as UDP on the selected port, the configured one unless
+ * several nodes share the process; the simulator provides an in-memory one.
+ */
+struct raft_transport {
+    const char *name;
+    void (*send)(const void *payload, uint16_t len, uint16_t dst_id);
+    void (*poll)(void);     /* receive and dispatch pending payloads */
+};
+
+extern const struct raft_transport ethdev_transport;
+
 void net_init(void);
+int net_port_init(uint16_t port_id);
+void net_select_port(uint16_t port_id);
+void net_port_flush(uint16_t port_id);
+void net_set_transport(const struct raft_transport *transport);
+void net_dispatch_payload(const void *payload, uint16_t len);
 void send_raft_packet(struct raft_packet *pkt, uint16_t dst_id);
+void send_raft_payload(const void *payload, uint16_t len, uint16_t dst_id);
 void process_packets(void);
 
 #endif
\ No newline at end of file
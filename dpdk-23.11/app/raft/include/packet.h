@@ -6,15 +6,63 @@
 #define RAFT_PORT 9999
 #define RAFT_PACKET_SIZE sizeof(struct raft_packet)
 
-// three message types for Raft protocol
+// message types for Raft protocol
 #define MSG_VOTE_REQUEST   1
 #define MSG_VOTE_RESPONSE  2
 #define MSG_HEARTBEAT      3
+#define MSG_HEARTBEAT_BATCH 4  // coalesced heartbeats of all groups led by sender
+#define MSG_CONFIG_SYNC    5   // full membership pushed by the leader of group 0
+#define MSG_CONFIG_ACK     6   // follower adopted a membership version
 
 struct raft_packet {
     uint8_t  msg_type;   // defined above
     uint32_t term;       // current term
     uint32_t node_id;    // this node's ID
+    uint16_t group_id;   // Raft group this message belongs to
 } __attribute__((packed));
 
-#endif // PACKET_H
\ No newline at end of file
+// one heartbeat inside a MSG_HEARTBEAT_BATCH packet
+struct raft_heartbeat_entry {
+    uint16_t group_id;
+    uint32_t term;
+} __attribute__((packed));
+
+// max entries per batch so that the packet fits a 1500 byte MTU
+#define RAFT_HB_BATCH_MAX 240
+
+struct raft_heartbeat_batch {
+    uint8_t  msg_type;   // MSG_HEARTBEAT_BATCH
+    uint32_t node_id;    // leader's ID
+    uint16_t count;      // number of valid entries
+    struct raft_heartbeat_entry entries[RAFT_HB_BATCH_MAX];
+} __attribute__((packed));
+
+#define RAFT_HB_BATCH_SIZE(n) \
+    (sizeof(struct raft_heartbeat_batch) - \
+     (RAFT_HB_BATCH_MAX - (n)) * sizeof(struct raft_heartbeat_entry))
+
+// one voting member inside a MSG_CONFIG_SYNC packet
+struct raft_config_entry {
+    uint32_t node_id;
+    uint32_t ip;         // network byte order
+    uint8_t  mac[6];
+} __attribute__((packed));
+
+#define RAFT_CONFIG_MAX_ENTRIES 16  // equal to MAX_NODES
+
+struct raft_config_sync {
+    uint8_t  msg_type;   // MSG_CONFIG_SYNC
+    uint32_t node_id;    // sender (leader of group 0)
+    uint32_t term;       // sender's term in group 0
+    uint32_t version;    // membership version
+    uint8_t  count;      // number of valid entries
+    struct raft_config_entry entries[RAFT_CONFIG_MAX_ENTRIES];
+} __attribute__((packed));
+
+struct raft_config_ack {
+    uint8_t  msg_type;   // MSG_CONFIG_ACK
+    uint32_t node_id;    // acknowledging node
+    uint32_t version;    // membership version now in use
+} __attribute__((packed));
+
+#endif // PACKET_H
@@ -0,0 +1,33 @@
+// include/ports.h
+#ifndef PORTS_H
+#define PORTS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "sim.h"
+
+/*
+ * Every node listed in config.json runs in this process on its own
+ * ethdev port (port_map), in real time: packets cross the NIC and
+ * whatever switches the ports, e.g. SR-IOV VFs of one NIC, or tap ports
+ * in a Linux bridge. The same calls as the simulator take nodes down and
+ * cut links, so the failover benchmark drives either one.
+ */
+
+int ports_init(const raft_config_t *cfg);
+void ports_fini(void);
+void ports_run_until(uint64_t end_us);
+uint64_t ports_now_us(void);
+void ports_set_hook(sim_hook_fn hook, void *arg);
+
+void ports_partition(const bool *side);   /* drop packets between side and the rest */
+void ports_heal(void);
+void ports_node_set_up(uint32_t node_id, bool up);
+int ports_node_restart(uint32_t node_id);
+
+uint32_t ports_leader(uint16_t group_id, uint32_t *term);
+int ports_node_raft_state(uint32_t node_id, uint16_t group_id,
+                          uint32_t *term, uint32_t *leader);
+
+#endif // PORTS_H
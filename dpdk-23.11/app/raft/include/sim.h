@@ -0,0 +1,50 @@
+// include/sim.h
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+/*
+ * Deterministic network simulator: every node listed in config.json runs
+ * as a raft_instance in this process, packets travel over in-memory
+ * links with configurable delay, jitter, loss and partitions, and all
+ * timers run on a virtual TSC. Given the same config and seed, a run
+ * produces the same events at the same virtual times.
+ */
+
+#define SIM_TSC_HZ 2000000000ULL   /* frequency of the virtual TSC */
+
+struct sim_stats {
+    uint64_t sent;
+    uint64_t delivered;
+    uint64_t lost;          /* random loss */
+    uint64_t cut;           /* dropped by a partition */
+    uint64_t down;          /* destination not running */
+};
+
+typedef void (*sim_hook_fn)(void *arg);
+
+int sim_init(const raft_config_t *cfg);
+void sim_fini(void);
+void sim_run_until(uint64_t end_us);
+uint64_t sim_now_us(void);
+void sim_set_hook(sim_hook_fn hook, void *arg);
+
+void sim_set_link(uint32_t src, uint32_t dst, uint32_t delay_us,
+                  uint32_t jitter_us, double loss);
+void sim_partition(const bool *side);   /* cut links between side and the rest */
+void sim_heal(void);
+void sim_node_set_up(uint32_t node_id, bool up);
+bool sim_node_is_up(uint32_t node_id);
+int sim_node_restart(uint32_t node_id);
+
+uint32_t sim_leader(uint16_t group_id, uint32_t *term);
+int sim_node_raft_state(uint32_t node_id, uint16_t group_id,
+                        uint32_t *term, uint32_t *leader);
+const struct sim_stats *sim_get_stats(void);
+
+int sim_main(void);
+
+#endif // SIM_H
@@ -3,17 +3,42 @@
 #define TIMEOUT_H
 
 #include <stdint.h>
-#include <rte_timer.h>
+#include <stdbool.h>
+#include <sys/queue.h>
 
-typedef void (*timeout_cb)(struct rte_timer *timer, void *arg);
+struct raft_timer;
+typedef void (*timeout_cb)(struct raft_timer *timer, void *arg);
 
+/* Timer armed on the timing wheel of the currently selected node */
+struct raft_timer {
+    LIST_ENTRY(raft_timer) next;
+    uint64_t expire_tick;
+    timeout_cb cb;
+    void *arg;
+    bool pending;
+};
+
+/* Timing wheel of one node, see timeout_state_select() */
+struct timeout_state;
+
+/* Clock source in cycles; the simulator installs a virtual one */
+typedef uint64_t (*timeout_clock_fn)(void);
 
 void timeout_init(uint32_t min_ms, uint32_t max_ms);
+void timeout_set_clock(timeout_clock_fn fn, uint64_t hz);
+uint64_t timeout_now_us(void);
+
+struct timeout_state *timeout_state_create(void);
+void timeout_state_free(struct timeout_state *ts);
+void timeout_state_select(struct timeout_state *ts);
 
-void timeout_start_election(struct rte_timer *t,
+void timeout_timer_init(struct raft_timer *t);
+void timeout_start(struct raft_timer *t, uint32_t ms, timeout_cb cb, void *arg);
+void timeout_start_election(struct raft_timer *t,
                             timeout_cb cb,
                             void *arg);
 
-void timeout_stop(struct rte_timer *t);
+void timeout_stop(struct raft_timer *t);
+void timeout_manage(void);
 
 #endif
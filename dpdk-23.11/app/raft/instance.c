@@ -0,0 +1,48 @@
+// instance.c
+#include "instance.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+void raft_instance_select(struct raft_instance *inst)
+{
+    election_state_select(inst->election);
+    membership_state_select(inst->membership);
+    timeout_state_select(inst->timeout);
+}
+
+/* Allocate, select and initialize node node_id; its timers start running */
+struct raft_instance *raft_instance_create(uint32_t node_id)
+{
+    struct raft_instance *inst = calloc(1, sizeof(*inst));
+    if (inst == NULL)
+        return NULL;
+
+    inst->node_id = node_id;
+    inst->election = election_state_create();
+    inst->membership = membership_state_create();
+    inst->timeout = timeout_state_create();
+    if (inst->election == NULL || inst->membership == NULL || inst->timeout == NULL)
+        goto fail;
+
+    raft_instance_select(inst);
+    raft_init(node_id);
+    if (membership_init(node_id) < 0)
+        goto fail;
+    return inst;
+
+fail:
+    printf("Failed to create Raft instance for node %u\n", node_id);
+    raft_instance_free(inst);
+    return NULL;
+}
+
+void raft_instance_free(struct raft_instance *inst)
+{
+    if (inst->election != NULL)
+        election_state_free(inst->election);
+    if (inst->membership != NULL)
+        membership_state_free(inst->membership);
+    if (inst->timeout != NULL)
+        timeout_state_free(inst->timeout);
+    free(inst);
+}
@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <signal.h>
 #include <rte_eal.h>
 #include <rte_launch.h>
 #include <rte_lcore.h>
@@ -11,11 +13,16 @@
 #include "packet.h"
 #include "config.h"
 #include "metadata.h"
+#include "membership.h"
+#include "instance.h"
+#include "timeout.h"
+#include "sim.h"
+#include "bench.h"
 
 // get current time
 static inline uint64_t monotonic_us(void)
 {
-    return rte_get_timer_cycles() * 1000000ULL / rte_get_timer_hz();
+    return timeout_now_us();
 }
 
 /* Time callback for metadata. */
@@ -26,6 +33,13 @@ static inline uint64_t monotonic_us(void)
 //     print_stats(st); //print metadata
 // }
 
+// SIGHUP re-reads config.json; the leader of group 0 then moves the
+// cluster to the new membership one server at a time
+static void sighup_handler(__rte_unused int sig)
+{
+    membership_request_reload();
+}
+
 // DPDK work thread main function
 static int lcore_main(__rte_unused void *arg)
 {
@@ -52,22 +66,25 @@ static int lcore_main(__rte_unused void *arg)
 
     uint64_t last_heartbeat = 0;
     printf("lcore_main running on lcore %u\n", rte_lcore_id());
+    membership_register_reader();
 
     for (;;)
     {
         process_packets(); //network
         
         rte_timer_manage();
+        timeout_manage(); // election timers
 
-        if (raft_get_state() == STATE_LEADER)
+        uint64_t now = monotonic_us();
+        if (now - last_heartbeat >= global_config.heartbeat_interval_ms * 1000ULL)
         {
-            uint64_t now = monotonic_us();
-            if (now - last_heartbeat >= global_config.heartbeat_interval_ms * 1000ULL)
-            {
-                raft_send_heartbeat();
-                last_heartbeat = now;
-            }
+            // one coalesced heartbeat round covers every group led here
+            raft_send_heartbeat();
+            membership_tick();
+            last_heartbeat = now;
         }
+        // no peer table pointer is held past this point
+        membership_quiescent();
         rte_pause();
     }
     return 0;
@@ -89,8 +106,28 @@ int main(int argc, char **argv)
     }
     // uint32_t id = atoi(argv[1]);
     rte_timer_subsystem_init();
+    if (strcmp(global_config.transport, "sim") == 0)
+    {
+        // all nodes of config.json in this process, on virtual time
+        int ret = global_config.bench.trials > 0 ? bench_main() : sim_main();
+        rte_eal_cleanup();
+        return ret < 0 ? EXIT_FAILURE : 0;
+    }
+    if (strcmp(global_config.transport, "ports") == 0)
+    {
+        // all nodes of config.json in this process, one port each
+        if (global_config.bench.trials == 0)
+            rte_exit(EXIT_FAILURE, "transport \"ports\" needs bench.trials > 0\n");
+        int ret = bench_main();
+        rte_eal_cleanup();
+        return ret < 0 ? EXIT_FAILURE : 0;
+    }
     net_init();
-    raft_init(global_config.node_id);
+    if (raft_instance_create(global_config.node_id) == NULL)
+    {
+        rte_exit(EXIT_FAILURE, "Failed to initialize Raft node\n");
+    }
+    signal(SIGHUP, sighup_handler);
     struct app_config_params app = {.port_id = global_config.port_id};
     struct stats_lcore_params st = {.app_params = &app};
     // struct stats_lcore_params st = { .app_params = &app };
@@ -0,0 +1,357 @@
+// membership.c
+#include "membership.h"
+#include "election.h"
+#include "networking.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <arpa/inet.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_rcu_qsbr.h>
+#include <rte_stdatomic.h>
+
+#define MEMBERSHIP_GROUP   0      /* group whose leader drives membership */
+#define DQ_SIZE            16     /* retired tables waiting for a grace period */
+
+/* shared by all nodes of the process */
+static struct rte_rcu_qsbr *qsv;
+static struct rte_rcu_qsbr_dq *dq;
+static volatile sig_atomic_t reload_requested;
+
+struct membership_state {
+    RTE_ATOMIC(struct raft_peer_table *) peer_table;
+    /* leader side of the single-server change protocol */
+    uint32_t acked_version[MAX_NODES + 1];
+    uint32_t acked_term;           /* group 0 term the acks were collected in */
+    raft_config_t target;          /* membership requested by the last reload */
+    bool target_pending;
+};
+
+static struct membership_state *ms;
+
+struct membership_state *membership_state_create(void)
+{
+    return calloc(1, sizeof(struct membership_state));
+}
+
+/* The caller guarantees that no reader still uses the node's table */
+void membership_state_free(struct membership_state *st)
+{
+    if (ms == st)
+        ms = NULL;
+    rte_free(rte_atomic_load_explicit(&st->peer_table, rte_memory_order_relaxed));
+    free(st);
+}
+
+void membership_state_select(struct membership_state *st)
+{
+    ms = st;
+}
+
+static void free_table(void *p, void *e, unsigned int n)
+{
+    (void)p;
+    (void)n;
+    rte_free(*(struct raft_peer_table **)e);
+}
+
+const struct raft_peer_table *membership_get(void)
+{
+    return rte_atomic_load_explicit(&ms->peer_table, rte_memory_order_acquire);
+}
+
+bool membership_is_member(uint32_t node_id)
+{
+    const struct raft_peer_table *t = membership_get();
+    return node_id >= 1 && node_id <= MAX_NODES && t->peers[node_id].member;
+}
+
+/* Make next the current table; the old one is reclaimed after a grace period */
+static int publish(const struct raft_peer_table *next)
+{
+    struct raft_peer_table *copy = rte_malloc("raft_peer_table", sizeof(*copy), 0);
+    if (copy == NULL)
+        return -1;
+    memcpy(copy, next, sizeof(*copy));
+
+    struct raft_peer_table *old = rte_atomic_exchange_explicit(&ms->peer_table, copy,
+                                                               rte_memory_order_release);
+    if (old != NULL && rte_rcu_qsbr_dq_enqueue(dq, &old) != 0)
+    {
+        /* queue full and nothing reclaimable: the old table leaks rather
+         * than being freed under a reader */
+        printf("[MEMBERSHIP] defer queue full, table version %u leaked\n", old->version);
+    }
+    printf("[MEMBERSHIP] Node %u now uses membership version %u (%u members)\n",
+           raft_get_node_id(), copy->version, copy->member_num);
+    return 0;
+}
+
+static void table_from_config(const raft_config_t *cfg, struct raft_peer_table *t)
+{
+    memset(t, 0, sizeof(*t));
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+    {
+        if (!cfg->member_map[id])
+            continue;
+        t->peers[id].member = true;
+        t->peers[id].ip = inet_addr(cfg->ip_map[id]);
+        rte_ether_addr_copy(&cfg->mac_map[id], &t->peers[id].mac);
+        t->member_num++;
+    }
+}
+
+static int rcu_init(void)
+{
+    size_t sz = rte_rcu_qsbr_get_memsize(RTE_MAX_LCORE);
+    qsv = rte_zmalloc("raft_membership_qsbr", sz, RTE_CACHE_LINE_SIZE);
+    if (qsv == NULL || rte_rcu_qsbr_init(qsv, RTE_MAX_LCORE) != 0)
+        return -1;
+
+    struct rte_rcu_qsbr_dq_parameters params = {
+        .name = "raft_membership_dq",
+        .size = DQ_SIZE,
+        .esize = sizeof(struct raft_peer_table *),
+        .trigger_reclaim_limit = DQ_SIZE / 2,
+        .max_reclaim_size = DQ_SIZE,
+        .free_fn = free_table,
+        .v = qsv,
+    };
+    dq = rte_rcu_qsbr_dq_create(&params);
+    if (dq == NULL)
+        return -1;
+    return 0;
+}
+
+/* Build the initial peer table of the selected node from global_config */
+int membership_init(uint32_t self_id)
+{
+    if (qsv == NULL && rcu_init() != 0)
+        return -1;
+
+    struct raft_peer_table initial;
+    table_from_config(&global_config, &initial);
+    if (self_id > MAX_NODES || !initial.peers[self_id].member)
+    {
+        printf("[MEMBERSHIP] node %u is missing from ip_map/mac_map\n", self_id);
+        return -1;
+    }
+    memset(ms->acked_version, 0, sizeof(ms->acked_version));
+    ms->target_pending = false;
+    return publish(&initial);
+}
+
+/* Every lcore reading the peer table must call this before its loop */
+void membership_register_reader(void)
+{
+    rte_rcu_qsbr_thread_register(qsv, rte_lcore_id());
+    rte_rcu_qsbr_thread_online(qsv, rte_lcore_id());
+}
+
+/* Called by readers once per loop iteration, outside any table access */
+void membership_quiescent(void)
+{
+    rte_rcu_qsbr_quiescent(qsv, rte_lcore_id());
+    rte_rcu_qsbr_dq_reclaim(dq, DQ_SIZE, NULL, NULL, NULL);
+}
+
+/* Signal-safe: the reload itself happens in membership_tick() */
+void membership_request_reload(void)
+{
+    reload_requested = 1;
+}
+
+static void send_sync(const struct raft_peer_table *t, uint32_t dst_id)
+{
+    struct raft_config_sync sync = {
+        .msg_type = MSG_CONFIG_SYNC,
+        .node_id = raft_get_node_id(),
+        .term = raft_get_term(MEMBERSHIP_GROUP),
+        .version = t->version,
+    };
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+    {
+        if (!t->peers[id].member)
+            continue;
+        struct raft_config_entry *e = &sync.entries[sync.count++];
+        e->node_id = id;
+        e->ip = t->peers[id].ip;
+        memcpy(e->mac, t->peers[id].mac.addr_bytes, RTE_ETHER_ADDR_LEN);
+    }
+    send_raft_payload(&sync, sizeof(sync), dst_id);
+}
+
+/* A change is committed once a majority of its own members adopted it */
+static bool committed(const struct raft_peer_table *t)
+{
+    uint32_t acks = 0;
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+    {
+        if (t->peers[id].member && ms->acked_version[id] >= t->version)
+            acks++;
+    }
+    return acks > t->member_num / 2;
+}
+
+/*
+ * Single-server changes: at most one node is added or removed per
+ * version and the next change waits for the previous one to commit, so
+ * any two consecutive configurations share a majority. Removals go
+ * first so that replacing a dead node never waits on it.
+ */
+static bool next_step(const struct raft_peer_table *cur, struct raft_peer_table *next)
+{
+    struct raft_peer_table want;
+    table_from_config(&ms->target, &want);
+
+    *next = *cur;
+    next->version = cur->version + 1;
+    next->term = raft_get_term(MEMBERSHIP_GROUP);
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+    {
+        if (cur->peers[id].member && !want.peers[id].member &&
+            id != raft_get_node_id())
+        {
+            next->peers[id].member = false;
+            next->member_num--;
+            printf("[MEMBERSHIP] RemoveServer %u\n", id);
+            return true;
+        }
+    }
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+    {
+        if (!want.peers[id].member)
+            continue;
+        if (cur->peers[id].member && cur->peers[id].ip == want.peers[id].ip &&
+            rte_is_same_ether_addr(&cur->peers[id].mac, &want.peers[id].mac))
+            continue;
+        if (!cur->peers[id].member)
+            next->member_num++;
+        next->peers[id] = want.peers[id];
+        printf("[MEMBERSHIP] AddServer %u\n", id);
+        return true;
+    }
+    return false;
+}
+
+void membership_tick(void)
+{
+    const struct raft_peer_table *cur = membership_get();
+    uint32_t self = raft_get_node_id();
+
+    if (reload_requested)
+    {
+        reload_requested = 0;
+        if (raft_get_state(MEMBERSHIP_GROUP) != STATE_LEADER)
+            printf("[MEMBERSHIP] reload ignored, not leader of group %u\n", MEMBERSHIP_GROUP);
+        else if (load_config_into("config.json", &ms->target) == 0)
+            ms->target_pending = true;
+    }
+
+    if (raft_get_state(MEMBERSHIP_GROUP) != STATE_LEADER)
+    {
+        ms->target_pending = false;
+        return;
+    }
+
+    /* acks collected under an older leader say nothing about this term */
+    if (ms->acked_term != raft_get_term(MEMBERSHIP_GROUP))
+    {
+        ms->acked_term = raft_get_term(MEMBERSHIP_GROUP);
+        memset(ms->acked_version, 0, sizeof(ms->acked_version));
+    }
+    ms->acked_version[self] = cur->version;
+
+    if (ms->target_pending && committed(cur))
+    {
+        struct raft_peer_table next;
+        if (!next_step(cur, &next))
+        {
+            ms->target_pending = false;
+            if (!ms->target.member_map[self])
+                printf("[MEMBERSHIP] RemoveServer %u skipped, a leader does not remove itself; "
+                       "membership version %u matches the rest of config.json\n",
+                       self, cur->version);
+            else
+                printf("[MEMBERSHIP] membership version %u matches config.json\n", cur->version);
+        }
+        else if (publish(&next) == 0)
+        {
+            ms->acked_version[self] = next.version;
+            /* a removed node must still learn that it is out */
+            for (uint32_t id = 1; id <= MAX_NODES; id++)
+            {
+                if (id != self && cur->peers[id].member && !next.peers[id].member)
+                    send_sync(&next, id);
+            }
+            cur = membership_get();
+        }
+    }
+
+    /* (re)send the current table to every member that has not adopted it */
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+    {
+        if (id != self && cur->peers[id].member && ms->acked_version[id] < cur->version)
+            send_sync(cur, id);
+    }
+}
+
+void membership_handle_sync(const struct raft_config_sync *sync, uint16_t len)
+{
+    if (len < sizeof(*sync) || sync->count > RAFT_CONFIG_MAX_ENTRIES)
+        return;
+
+    const struct raft_peer_table *cur = membership_get();
+    uint32_t self = raft_get_node_id();
+
+    /* only the leader of group 0 this node follows, in its term or a later one */
+    if (sync->node_id == 0 || sync->node_id != raft_get_leader(MEMBERSHIP_GROUP) ||
+        sync->term < raft_get_term(MEMBERSHIP_GROUP))
+        return;
+
+    /* newer version wins; a tie between two leaders goes to the later term */
+    if (sync->version > cur->version ||
+        (sync->version == cur->version && sync->term > cur->term))
+    {
+        struct raft_peer_table next = *cur;
+        next.version = sync->version;
+        next.term = sync->term;
+        next.member_num = 0;
+        for (uint32_t id = 1; id <= MAX_NODES; id++)
+            next.peers[id].member = false;
+        for (uint8_t i = 0; i < sync->count; i++)
+        {
+            const struct raft_config_entry *e = &sync->entries[i];
+            if (e->node_id < 1 || e->node_id > MAX_NODES || next.peers[e->node_id].member)
+                continue;
+            next.peers[e->node_id].member = true;
+            next.peers[e->node_id].ip = e->ip;
+            memcpy(next.peers[e->node_id].mac.addr_bytes, e->mac, RTE_ETHER_ADDR_LEN);
+            next.member_num++;
+        }
+        if (publish(&next) != 0)
+            return;
+        if (!next.peers[self].member)
+            printf("[MEMBERSHIP] Node %u was removed from the cluster\n", self);
+        cur = membership_get();
+    }
+
+    struct raft_config_ack ack = {
+        .msg_type = MSG_CONFIG_ACK,
+        .node_id = self,
+        .version = cur->version,
+    };
+    send_raft_payload(&ack, sizeof(ack), sync->node_id);
+}
+
+void membership_handle_ack(const struct raft_config_ack *ack, uint16_t len)
+{
+    if (len < sizeof(*ack) || ack->node_id < 1 || ack->node_id > MAX_NODES)
+        return;
+    if (raft_get_state(MEMBERSHIP_GROUP) != STATE_LEADER)
+        return;
+    if (ack->version > ms->acked_version[ack->node_id])
+        ms->acked_version[ack->node_id] = ack->version;
+}
@@ -2,11 +2,13 @@
 #include "networking.h"
 #include "election.h"
 #include "config.h"
+#include "membership.h"
 #include <stdlib.h>
 #include <rte_ethdev.h>
 #include <rte_ether.h>
 #include <rte_mbuf.h>
 #include <rte_ip.h>
+#include <rte_prefetch.h>
 #include <rte_timer.h>
 #include <rte_errno.h>
 #include <arpa/inet.h>
@@ -14,6 +16,15 @@
 
 #define MBUF_POOL_SIZE 4096
 #define BURST_SIZE 32
+#define RX_PREFETCH_OFFSET 4      /* headers prefetched ahead of classification */
+#define RX_BUCKETS (MSG_CONFIG_ACK + 1) /* one per message type, 0 for unknown types */
+
+/* Payloads of one message type taken from an RX burst */
+struct rx_bucket {
+    uint16_t n;
+    const void *data[BURST_SIZE];
+    uint16_t len[BURST_SIZE];
+};
 
 static struct rte_mempool *mbuf_pool;
 static const struct rte_eth_conf port_conf_default = {
@@ -22,66 +33,185 @@ static const struct rte_eth_conf port_conf_default = {
     .txmode = {.offloads = 0}
 };
 
-void net_init(void)
+static uint16_t cur_port;       /* port of the node being driven */
+
+/* Configure and start port_id with one RX and one TX queue */
+int net_port_init(uint16_t port_id)
 {
-    // pool initialization
-    mbuf_pool = rte_pktmbuf_pool_create("RAFT_MBUF_POOL", MBUF_POOL_SIZE,
-                                        0, 0, RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
     if (mbuf_pool == NULL)
-        rte_exit(EXIT_FAILURE, "Cannot create mbuf pool: %s\n", rte_strerror(rte_errno));
+    {
+        mbuf_pool = rte_pktmbuf_pool_create("RAFT_MBUF_POOL", MBUF_POOL_SIZE,
+                                            0, 0, RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+        if (mbuf_pool == NULL)
+        {
+            printf("Cannot create mbuf pool: %s\n", rte_strerror(rte_errno));
+            return -1;
+        }
+    }
     // ethdev initialization
-    // global_config.port_id = 0;
     int ret;
-    ret = rte_eth_dev_configure(global_config.port_id, 1, 1, &port_conf_default);
+    ret = rte_eth_dev_configure(port_id, 1, 1, &port_conf_default);
     if (ret < 0)
-        rte_exit(EXIT_FAILURE, "dev_configure err=%d\n", ret);
+    {
+        printf("dev_configure err=%d\n", ret);
+        return -1;
+    }
 
     // rx and tx queue setup
-    ret = rte_eth_rx_queue_setup(global_config.port_id, 0, 128,
-                                 rte_eth_dev_socket_id(global_config.port_id), NULL, mbuf_pool);
+    ret = rte_eth_rx_queue_setup(port_id, 0, 128,
+                                 rte_eth_dev_socket_id(port_id), NULL, mbuf_pool);
     if (ret < 0)
-        rte_exit(EXIT_FAILURE, "rx_queue_setup err=%d\n", ret);
-    ret = rte_eth_tx_queue_setup(global_config.port_id, 0, 512,
-                                 rte_eth_dev_socket_id(global_config.port_id), NULL);
+    {
+        printf("rx_queue_setup err=%d\n", ret);
+        return -1;
+    }
+    ret = rte_eth_tx_queue_setup(port_id, 0, 512,
+                                 rte_eth_dev_socket_id(port_id), NULL);
     if (ret < 0)
-        rte_exit(EXIT_FAILURE, "tx_queue_setup err=%d\n", ret);
+    {
+        printf("tx_queue_setup err=%d\n", ret);
+        return -1;
+    }
 
     // start the device
-    ret = rte_eth_dev_start(global_config.port_id);
+    ret = rte_eth_dev_start(port_id);
     if (ret < 0)
-        rte_exit(EXIT_FAILURE, "dev_start err=%d\n", ret);
+    {
+        printf("dev_start err=%d\n", ret);
+        return -1;
+    }
     struct rte_ether_addr actual_mac;
-    ret = rte_eth_macaddr_get(global_config.port_id, &actual_mac);
+    ret = rte_eth_macaddr_get(port_id, &actual_mac);
     if (ret != 0)
     {
-        printf("Failed to get MAC address for port %u: %s\n", global_config.port_id, rte_strerror(rte_errno));
+        printf("Failed to get MAC address for port %u: %s\n", port_id, rte_strerror(rte_errno));
     }
     else
     {
         printf("Actual MAC address for port %u: %02x:%02x:%02x:%02x:%02x:%02x\n",
-               global_config.port_id,
+               port_id,
                actual_mac.addr_bytes[0], actual_mac.addr_bytes[1], actual_mac.addr_bytes[2],
                actual_mac.addr_bytes[3], actual_mac.addr_bytes[4], actual_mac.addr_bytes[5]);
     }
+    return 0;
+}
+
+void net_init(void)
+{
+    if (net_port_init(global_config.port_id) < 0)
+        rte_exit(EXIT_FAILURE, "Cannot initialize port %u\n", global_config.port_id);
+    net_select_port(global_config.port_id);
+}
+
+/* The ethdev transport sends and receives on port_id from now on */
+void net_select_port(uint16_t port_id)
+{
+    cur_port = port_id;
+}
+
+/* Drop whatever is waiting on the RX queue of port_id */
+void net_port_flush(uint16_t port_id)
+{
+    struct rte_mbuf *bufs[BURST_SIZE];
+    uint16_t n;
+
+    while ((n = rte_eth_rx_burst(port_id, 0, bufs, BURST_SIZE)) > 0)
+        rte_pktmbuf_free_bulk(bufs, n);
+}
+
+static const struct raft_transport *transport = &ethdev_transport;
+
+void net_set_transport(const struct raft_transport *t)
+{
+    transport = t;
 }
 
 void send_raft_packet(struct raft_packet *pkt, uint16_t dst_id)
+{
+    send_raft_payload(pkt, sizeof(struct raft_packet), dst_id);
+}
+
+void send_raft_payload(const void *payload, uint16_t len, uint16_t dst_id)
+{
+    transport->send(payload, len, dst_id);
+}
+
+void process_packets(void)
+{
+    transport->poll();
+}
+
+/*
+ * Hand n received payloads of message type type to the module owning
+ * that type, so that each handler runs back to back over its batch.
+ */
+static void dispatch_batch(uint8_t type, const void *const *data,
+                           const uint16_t *len, uint16_t n)
+{
+    uint16_t i;
+
+    switch (type)
+    {
+    case MSG_HEARTBEAT_BATCH:
+        for (i = 0; i < n; i++)
+            raft_handle_heartbeat_batch(data[i], len[i], 0); // election.c
+        break;
+    case MSG_CONFIG_SYNC:
+        for (i = 0; i < n; i++)
+            membership_handle_sync(data[i], len[i]); // membership.c
+        break;
+    case MSG_CONFIG_ACK:
+        for (i = 0; i < n; i++)
+            membership_handle_ack(data[i], len[i]); // membership.c
+        break;
+    default:
+        for (i = 0; i < n; i++)
+        {
+            if (len[i] >= sizeof(struct raft_packet))
+                raft_handle_packet(data[i], 0); // election.c
+        }
+        break;
+    }
+}
+
+/* Hand a received Raft payload (UDP data) to the module owning its type */
+void net_dispatch_payload(const void *data, uint16_t payload_len)
+{
+    if (payload_len == 0)
+        return;
+    dispatch_batch(*(const uint8_t *)data, &data, &payload_len, 1);
+}
+
+static void ethdev_send(const void *payload, uint16_t len, uint16_t dst_id)
 {
     struct rte_mbuf *mbuf = rte_pktmbuf_alloc(mbuf_pool);
     if (!mbuf)
         return;
 
     // pkt data is the ptr of the mbuf
-    // rte_ether_hdr + rte_ipv4_hdr + rte_udp_hdr + raft_packet(payload)
-    char *pkt_data = rte_pktmbuf_append(mbuf, sizeof(struct raft_packet) +
+    // rte_ether_hdr + rte_ipv4_hdr + rte_udp_hdr + payload
+    char *pkt_data = rte_pktmbuf_append(mbuf, len +
                                                   sizeof(struct rte_udp_hdr) +
                                                   sizeof(struct rte_ipv4_hdr) +
                                                   sizeof(struct rte_ether_hdr));
+    if (!pkt_data)
+    {
+        rte_pktmbuf_free(mbuf);
+        return;
+    }
+
+    // addresses come from the RCU-protected peer table
+    const struct raft_peer_table *peers = membership_get();
+    if (dst_id < 1 || dst_id > MAX_NODES)
+    {
+        rte_pktmbuf_free(mbuf);
+        return;
+    }
 
     // eth_hdr is the first part of the packet
     struct rte_ether_hdr *eth_hdr = (struct rte_ether_hdr *)pkt_data;
-    rte_ether_addr_copy(&global_config.mac_map[raft_get_node_id()], &eth_hdr->src_addr); // src MAC
-    rte_ether_addr_copy(&global_config.mac_map[dst_id], &eth_hdr->dst_addr);             // dst MAC
+    rte_ether_addr_copy(&peers->peers[raft_get_node_id()].mac, &eth_hdr->src_addr); // src MAC
+    rte_ether_addr_copy(&peers->peers[dst_id].mac, &eth_hdr->dst_addr);             // dst MAC
     eth_hdr->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
 
     // IPv4 header
@@ -90,69 +220,101 @@ void send_raft_packet(struct raft_packet *pkt, uint16_t dst_id)
     ip_hdr->type_of_service = 0; // TODO: if QoS is needed reset this
     ip_hdr->total_length = rte_cpu_to_be_16(sizeof(struct rte_ipv4_hdr) +
                                             sizeof(struct rte_udp_hdr) +
-                                            sizeof(struct raft_packet));
+                                            len);
     ip_hdr->packet_id = rte_cpu_to_be_16(0);
     ip_hdr->fragment_offset = rte_cpu_to_be_16(0);
     ip_hdr->time_to_live = 64;
     ip_hdr->next_proto_id = IPPROTO_UDP; // 17 UDP protocol
-    const char *src_ip = global_config.ip_map[raft_get_node_id()];
-    const char *dst_ip = global_config.ip_map[dst_id];
-    if (!src_ip || !dst_ip)
-    {
-        rte_exit(EXIT_FAILURE, "Missing IP mapping for node %u or %u\n", raft_get_node_id(), dst_id);
-    }
-    ip_hdr->src_addr = inet_addr(src_ip);
-    ip_hdr->dst_addr = inet_addr(dst_ip);
+    ip_hdr->src_addr = peers->peers[raft_get_node_id()].ip;
+    ip_hdr->dst_addr = peers->peers[dst_id].ip;
 
     // UDP header
     struct rte_udp_hdr *udp_hdr = (struct rte_udp_hdr *)(ip_hdr + 1);
     udp_hdr->src_port = rte_cpu_to_be_16(RAFT_PORT);
     udp_hdr->dst_port = rte_cpu_to_be_16(RAFT_PORT);
-    udp_hdr->dgram_len = rte_cpu_to_be_16(sizeof(struct raft_packet) +
+    udp_hdr->dgram_len = rte_cpu_to_be_16(len +
                                           sizeof(struct rte_udp_hdr));
 
     // Packet payload
-    struct raft_packet *raft_data = (struct raft_packet *)(udp_hdr + 1);
-    memcpy(raft_data, pkt, sizeof(struct raft_packet));
+    memcpy(udp_hdr + 1, payload, len);
 
     // Calculate checksums after filling the payload
     ip_hdr->hdr_checksum = rte_ipv4_cksum(ip_hdr);
     udp_hdr->dgram_cksum = rte_ipv4_udptcp_cksum(ip_hdr, udp_hdr);
 
     // send the packet
-    rte_eth_tx_burst(global_config.port_id, 0, &mbuf, 1);
+    if (rte_eth_tx_burst(cur_port, 0, &mbuf, 1) == 0)
+        rte_pktmbuf_free(mbuf);
 }
 
-void process_packets(void)
+/* UDP payload of a Raft packet, NULL if m carries anything else */
+static inline const uint8_t *raft_payload(const struct rte_mbuf *m, uint16_t *len)
+{
+    const struct rte_ether_hdr *eth = rte_pktmbuf_mtod(m, const struct rte_ether_hdr *);
+    const struct rte_ipv4_hdr *ip = (const struct rte_ipv4_hdr *)(eth + 1);
+    const struct rte_udp_hdr *udp = (const struct rte_udp_hdr *)(ip + 1);
+
+    // all header checks folded into a single branch; the fields share
+    // one cache line, so reading them for a non-IPv4 frame is harmless
+    uint32_t mismatch = (eth->ether_type ^ rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4)) |
+                        (ip->version_ihl ^ RTE_IPV4_VHL_DEF) |
+                        (ip->next_proto_id ^ IPPROTO_UDP) |
+                        (udp->dst_port ^ rte_cpu_to_be_16(RAFT_PORT));
+    if (mismatch != 0)
+        return NULL;
+
+    uint16_t dgram_len = rte_be_to_cpu_16(udp->dgram_len);
+    if (dgram_len <= sizeof(struct rte_udp_hdr) ||
+        (const char *)udp + dgram_len > rte_pktmbuf_mtod(m, const char *) +
+                                        rte_pktmbuf_data_len(m))
+        return NULL;
+
+    *len = dgram_len - sizeof(struct rte_udp_hdr);
+    return (const uint8_t *)(udp + 1);
+}
+
+static void ethdev_poll(void)
 {
     struct rte_mbuf *rx_bufs[BURST_SIZE];
-    uint16_t nb_rx = rte_eth_rx_burst(global_config.port_id, 0, rx_bufs, BURST_SIZE);
+    struct rx_bucket buckets[RX_BUCKETS];
+    uint16_t nb_rx = rte_eth_rx_burst(cur_port, 0, rx_bufs, BURST_SIZE);
+    uint16_t i;
 
-    for (int i = 0; i < nb_rx; i++)
+    if (nb_rx == 0)
+        return;
+
+    for (i = 0; i < RX_BUCKETS; i++)
+        buckets[i].n = 0;
+    for (i = 0; i < nb_rx && i < RX_PREFETCH_OFFSET; i++)
+        rte_prefetch0(rte_pktmbuf_mtod(rx_bufs[i], void *));
+
+    // pass 1: sort the burst by message type
+    for (i = 0; i < nb_rx; i++)
     {
-        struct rte_ether_hdr *eth_hdr = rte_pktmbuf_mtod(rx_bufs[i], struct rte_ether_hdr *);
-        if (eth_hdr->ether_type != rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4))
-        {
-            rte_pktmbuf_free(rx_bufs[i]);
-            continue;
-        }
+        if (i + RX_PREFETCH_OFFSET < nb_rx)
+            rte_prefetch0(rte_pktmbuf_mtod(rx_bufs[i + RX_PREFETCH_OFFSET], void *));
 
-        struct rte_ipv4_hdr *ip_hdr = (struct rte_ipv4_hdr *)(eth_hdr + 1);
-        if (ip_hdr->next_proto_id != IPPROTO_UDP)
-        {
-            rte_pktmbuf_free(rx_bufs[i]);
+        uint16_t len;
+        const uint8_t *payload = raft_payload(rx_bufs[i], &len);
+        if (payload == NULL)
             continue;
-        }
 
-        struct rte_udp_hdr *udp_hdr = (struct rte_udp_hdr *)(ip_hdr + 1);
-        if (udp_hdr->dst_port != rte_cpu_to_be_16(RAFT_PORT))
-        {
-            rte_pktmbuf_free(rx_bufs[i]);
-            continue;
-        }
+        struct rx_bucket *b = &buckets[payload[0] < RX_BUCKETS ? payload[0] : 0];
+        b->data[b->n] = payload;
+        b->len[b->n++] = len;
+    }
 
-        struct raft_packet *raft_pkt = (struct raft_packet *)(udp_hdr + 1);
-        raft_handle_packet(raft_pkt, 0); // election.c
-        rte_pktmbuf_free(rx_bufs[i]);
+    // pass 2: one handler call site per message type
+    for (i = 0; i < RX_BUCKETS; i++)
+    {
+        if (buckets[i].n > 0)
+            dispatch_batch(i, buckets[i].data, buckets[i].len, buckets[i].n);
     }
-}
\ No newline at end of file
+    rte_pktmbuf_free_bulk(rx_bufs, nb_rx);
+}
+
+const struct raft_transport ethdev_transport = {
+    .name = "ethdev",
+    .send = ethdev_send,
+    .poll = ethdev_poll,
+};
\ No newline at end of file
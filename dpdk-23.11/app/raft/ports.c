@@ -0,0 +1,209 @@
+// ports.c
+#include "ports.h"
+#include "instance.h"
+#include "networking.h"
+#include <stdio.h>
+#include <string.h>
+#include <rte_ethdev.h>
+
+struct ports_node {
+    struct raft_instance *inst;   /* NULL if the id is not configured */
+    bool up;
+    bool started;                 /* port_id configured and started */
+    uint16_t port_id;
+    uint64_t last_heartbeat_us;
+};
+
+static struct {
+    struct ports_node nodes[MAX_NODES + 1];
+    bool cut[MAX_NODES + 1][MAX_NODES + 1];
+    sim_hook_fn hook;
+    void *hook_arg;
+} ports;
+
+/* A partition drops packets at the sender, before they reach the port */
+static void ports_send(const void *payload, uint16_t len, uint16_t dst_id)
+{
+    uint32_t src = raft_get_node_id();
+
+    if (dst_id < 1 || dst_id > MAX_NODES || ports.cut[src][dst_id])
+        return;
+    ethdev_transport.send(payload, len, dst_id);
+}
+
+static void ports_poll(void)
+{
+    ethdev_transport.poll();
+}
+
+static const struct raft_transport ports_transport = {
+    .name = "ports",
+    .send = ports_send,
+    .poll = ports_poll,
+};
+
+uint64_t ports_now_us(void)
+{
+    return timeout_now_us();
+}
+
+/* hook runs after every round over the running nodes, NULL for none */
+void ports_set_hook(sim_hook_fn hook, void *arg)
+{
+    ports.hook = hook;
+    ports.hook_arg = arg;
+}
+
+void ports_partition(const bool *side)
+{
+    for (uint32_t a = 1; a <= MAX_NODES; a++)
+        for (uint32_t b = 1; b <= MAX_NODES; b++)
+            ports.cut[a][b] = side[a] != side[b];
+}
+
+void ports_heal(void)
+{
+    memset(ports.cut, 0, sizeof(ports.cut));
+}
+
+/* A node that is down is not polled: its packets wait on its RX queue */
+void ports_node_set_up(uint32_t node_id, bool up)
+{
+    if (node_id >= 1 && node_id <= MAX_NODES && ports.nodes[node_id].inst != NULL)
+        ports.nodes[node_id].up = up;
+}
+
+/* Crash recovery: empty state, and the packets sent to the dead node are gone */
+int ports_node_restart(uint32_t node_id)
+{
+    if (node_id < 1 || node_id > MAX_NODES || ports.nodes[node_id].inst == NULL)
+        return -1;
+
+    struct ports_node *n = &ports.nodes[node_id];
+
+    net_port_flush(n->port_id);
+    raft_instance_free(n->inst);
+    n->inst = raft_instance_create(node_id);
+    if (n->inst == NULL)
+        return -1;
+    n->up = true;
+    n->last_heartbeat_us = ports_now_us();
+    return 0;
+}
+
+uint32_t ports_leader(uint16_t group_id, uint32_t *term)
+{
+    uint32_t leader = 0, best = 0;
+
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+    {
+        struct ports_node *n = &ports.nodes[id];
+        if (n->inst == NULL || !n->up)
+            continue;
+        raft_instance_select(n->inst);
+        if (raft_get_state(group_id) == STATE_LEADER && raft_get_term(group_id) >= best)
+        {
+            best = raft_get_term(group_id);
+            leader = id;
+        }
+    }
+    if (term != NULL)
+        *term = best;
+    return leader;
+}
+
+/* State of one group as seen by a running node, -1 if the node is down */
+int ports_node_raft_state(uint32_t node_id, uint16_t group_id,
+                          uint32_t *term, uint32_t *leader)
+{
+    if (node_id < 1 || node_id > MAX_NODES || !ports.nodes[node_id].up)
+        return -1;
+    raft_instance_select(ports.nodes[node_id].inst);
+    *term = raft_get_term(group_id);
+    *leader = raft_get_leader(group_id);
+    return raft_get_state(group_id);
+}
+
+/* One lcore polls every running node in turn, as lcore_main() does for one */
+void ports_run_until(uint64_t end_us)
+{
+    uint64_t hb_us = global_config.heartbeat_interval_ms * 1000ULL;
+
+    while (ports_now_us() < end_us)
+    {
+        for (uint32_t id = 1; id <= MAX_NODES; id++)
+        {
+            struct ports_node *n = &ports.nodes[id];
+            if (n->inst == NULL || !n->up)
+                continue;
+            raft_instance_select(n->inst);
+            net_select_port(n->port_id);
+            process_packets();
+            timeout_manage();
+            uint64_t now = ports_now_us();
+            if (now - n->last_heartbeat_us >= hb_us)
+            {
+                raft_send_heartbeat();
+                membership_tick();
+                n->last_heartbeat_us = now;
+            }
+        }
+        membership_quiescent();
+        if (ports.hook != NULL)
+            ports.hook(ports.hook_arg);
+    }
+}
+
+int ports_init(const raft_config_t *cfg)
+{
+    memset(&ports, 0, sizeof(ports));
+    net_set_transport(&ports_transport);
+
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+    {
+        if (!cfg->member_map[id])
+            continue;
+        uint16_t port_id = cfg->port_map[id];
+        if (!rte_eth_dev_is_valid_port(port_id))
+        {
+            printf("[PORTS] node %u: no port %u\n", id, port_id);
+            goto fail;
+        }
+        if (net_port_init(port_id) < 0)
+            goto fail;
+        ports.nodes[id].port_id = port_id;
+        ports.nodes[id].started = true;
+    }
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+    {
+        if (!cfg->member_map[id])
+            continue;
+        net_select_port(ports.nodes[id].port_id);
+        ports.nodes[id].inst = raft_instance_create(id);
+        if (ports.nodes[id].inst == NULL)
+            goto fail;
+        ports.nodes[id].up = true;
+        ports.nodes[id].last_heartbeat_us = ports_now_us();
+    }
+    // one lcore drives every node: it is the only peer table reader
+    membership_register_reader();
+    return 0;
+
+fail:
+    ports_fini();
+    return -1;
+}
+
+void ports_fini(void)
+{
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+    {
+        struct ports_node *n = &ports.nodes[id];
+        if (n->inst != NULL)
+            raft_instance_free(n->inst);
+        if (n->started)
+            rte_eth_dev_stop(n->port_id);
+        memset(n, 0, sizeof(*n));
+    }
+    net_set_transport(&ethdev_transport);
+}
@@ -0,0 +1,451 @@
+// sim.c
+#include "sim.h"
+#include "instance.h"
+#include "networking.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <rte_common.h>
+#include <rte_random.h>
+
+#define SIM_SAMPLE_US 1000   /* leader bookkeeping resolution */
+
+struct sim_msg {
+    uint64_t deliver_us;
+    uint64_t seq;            /* FIFO among packets due at the same time */
+    uint16_t src;
+    uint16_t dst;
+    uint16_t len;
+    uint8_t data[];
+};
+
+struct sim_link {
+    uint32_t delay_us;
+    uint32_t jitter_us;
+    double loss;
+    bool cut;
+};
+
+struct sim_node {
+    struct raft_instance *inst;   /* NULL if the id is not configured */
+    bool up;
+    uint64_t last_heartbeat_us;
+};
+
+struct sim_group_view {
+    uint32_t leader;
+    uint32_t term;
+    uint64_t first_leader_us;
+    uint32_t changes;
+};
+
+static struct {
+    uint64_t now_us;              /* virtual time */
+    uint64_t seq;
+    uint64_t next_sample_us;
+    uint32_t step_us;
+    struct sim_node nodes[MAX_NODES + 1];
+    struct sim_link links[MAX_NODES + 1][MAX_NODES + 1];
+    struct sim_msg **heap;        /* min-heap on (deliver_us, seq) */
+    uint32_t heap_len;
+    uint32_t heap_cap;
+    struct sim_stats stats;
+    struct sim_group_view groups[RAFT_MAX_GROUPS];
+    sim_hook_fn hook;
+    void *hook_arg;
+} sim;
+
+static uint64_t sim_clock(void)
+{
+    return sim.now_us * (SIM_TSC_HZ / 1000000ULL);
+}
+
+uint64_t sim_now_us(void)
+{
+    return sim.now_us;
+}
+
+const struct sim_stats *sim_get_stats(void)
+{
+    return &sim.stats;
+}
+
+/* hook runs after every delivered packet and every timer pass, NULL for none */
+void sim_set_hook(sim_hook_fn hook, void *arg)
+{
+    sim.hook = hook;
+    sim.hook_arg = arg;
+}
+
+static inline bool msg_before(const struct sim_msg *a, const struct sim_msg *b)
+{
+    return a->deliver_us < b->deliver_us ||
+           (a->deliver_us == b->deliver_us && a->seq < b->seq);
+}
+
+static int heap_push(struct sim_msg *m)
+{
+    if (sim.heap_len == sim.heap_cap)
+    {
+        uint32_t cap = sim.heap_cap ? sim.heap_cap * 2 : 1024;
+        struct sim_msg **h = realloc(sim.heap, cap * sizeof(*h));
+        if (h == NULL)
+            return -1;
+        sim.heap = h;
+        sim.heap_cap = cap;
+    }
+    uint32_t i = sim.heap_len++;
+    while (i > 0 && msg_before(m, sim.heap[(i - 1) / 2]))
+    {
+        sim.heap[i] = sim.heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    sim.heap[i] = m;
+    return 0;
+}
+
+static struct sim_msg *heap_pop(void)
+{
+    struct sim_msg *top = sim.heap[0];
+    struct sim_msg *last = sim.heap[--sim.heap_len];
+    uint32_t i = 0;
+
+    for (;;)
+    {
+        uint32_t c = 2 * i + 1;
+        if (c >= sim.heap_len)
+            break;
+        if (c + 1 < sim.heap_len && msg_before(sim.heap[c + 1], sim.heap[c]))
+            c++;
+        if (!msg_before(sim.heap[c], last))
+            break;
+        sim.heap[i] = sim.heap[c];
+        i = c;
+    }
+    if (sim.heap_len > 0)
+        sim.heap[i] = last;
+    return top;
+}
+
+static void sim_send(const void *payload, uint16_t len, uint16_t dst_id)
+{
+    uint32_t src = raft_get_node_id();
+    if (dst_id < 1 || dst_id > MAX_NODES)
+        return;
+
+    const struct sim_link *link = &sim.links[src][dst_id];
+    sim.stats.sent++;
+    if (link->cut)
+    {
+        sim.stats.cut++;
+        return;
+    }
+    if (link->loss > 0.0 && rte_drand() < link->loss)
+    {
+        sim.stats.lost++;
+        return;
+    }
+
+    struct sim_msg *m = malloc(sizeof(*m) + len);
+    if (m == NULL)
+        return;
+    m->deliver_us = sim.now_us + link->delay_us +
+                    (link->jitter_us ? rte_rand_max(link->jitter_us + 1) : 0);
+    m->seq = sim.seq++;
+    m->src = src;
+    m->dst = dst_id;
+    m->len = len;
+    memcpy(m->data, payload, len);
+    if (heap_push(m) != 0)
+        free(m);
+}
+
+/* Nothing to poll: sim_run_until() delivers packets in time order */
+static void sim_poll(void)
+{
+}
+
+static const struct raft_transport sim_transport = {
+    .name = "sim",
+    .send = sim_send,
+    .poll = sim_poll,
+};
+
+void sim_set_link(uint32_t src, uint32_t dst, uint32_t delay_us,
+                  uint32_t jitter_us, double loss)
+{
+    sim.links[src][dst].delay_us = delay_us;
+    sim.links[src][dst].jitter_us = jitter_us;
+    sim.links[src][dst].loss = loss;
+}
+
+void sim_partition(const bool *side)
+{
+    for (uint32_t a = 1; a <= MAX_NODES; a++)
+        for (uint32_t b = 1; b <= MAX_NODES; b++)
+            sim.links[a][b].cut = side[a] != side[b];
+}
+
+void sim_heal(void)
+{
+    for (uint32_t a = 1; a <= MAX_NODES; a++)
+        for (uint32_t b = 1; b <= MAX_NODES; b++)
+            sim.links[a][b].cut = false;
+}
+
+void sim_node_set_up(uint32_t node_id, bool up)
+{
+    if (node_id >= 1 && node_id <= MAX_NODES && sim.nodes[node_id].inst != NULL)
+        sim.nodes[node_id].up = up;
+}
+
+bool sim_node_is_up(uint32_t node_id)
+{
+    return node_id >= 1 && node_id <= MAX_NODES && sim.nodes[node_id].up;
+}
+
+/* Crash recovery: the node comes back with no memory of terms or votes */
+int sim_node_restart(uint32_t node_id)
+{
+    if (node_id < 1 || node_id > MAX_NODES || sim.nodes[node_id].inst == NULL)
+        return -1;
+
+    struct sim_node *n = &sim.nodes[node_id];
+
+    raft_instance_free(n->inst);
+    n->inst = raft_instance_create(node_id);
+    if (n->inst == NULL)
+        return -1;
+    n->up = true;
+    n->last_heartbeat_us = sim.now_us;
+    return 0;
+}
+
+uint32_t sim_leader(uint16_t group_id, uint32_t *term)
+{
+    uint32_t leader = 0, best = 0;
+
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+    {
+        struct sim_node *n = &sim.nodes[id];
+        if (n->inst == NULL || !n->up)
+            continue;
+        raft_instance_select(n->inst);
+        if (raft_get_state(group_id) == STATE_LEADER && raft_get_term(group_id) >= best)
+        {
+            best = raft_get_term(group_id);
+            leader = id;
+        }
+    }
+    if (term != NULL)
+        *term = best;
+    return leader;
+}
+
+/* State of one group as seen by a running node, -1 if the node is down */
+int sim_node_raft_state(uint32_t node_id, uint16_t group_id,
+                        uint32_t *term, uint32_t *leader)
+{
+    if (!sim_node_is_up(node_id))
+        return -1;
+    raft_instance_select(sim.nodes[node_id].inst);
+    *term = raft_get_term(group_id);
+    *leader = raft_get_leader(group_id);
+    return raft_get_state(group_id);
+}
+
+static void sample_leaders(void)
+{
+    for (uint32_t g = 0; g < global_config.group_num; g++)
+    {
+        struct sim_group_view *v = &sim.groups[g];
+        uint32_t term;
+        uint32_t leader = sim_leader(g, &term);
+
+        if (leader == 0 || (leader == v->leader && term == v->term))
+            continue;
+        if (v->leader == 0 && v->changes == 0)
+            v->first_leader_us = sim.now_us;
+        v->leader = leader;
+        v->term = term;
+        v->changes++;
+    }
+}
+
+static void deliver(struct sim_msg *m)
+{
+    struct sim_node *n = &sim.nodes[m->dst];
+
+    if (n->inst == NULL || !n->up)
+    {
+        sim.stats.down++;
+        return;
+    }
+    raft_instance_select(n->inst);
+    net_dispatch_payload(m->data, m->len);
+    sim.stats.delivered++;
+}
+
+static void apply_partition_schedule(void)
+{
+    const raft_sim_config_t *cfg = &global_config.sim;
+
+    if (cfg->partition_end_ms <= cfg->partition_start_ms)
+        return;
+    if (sim.now_us == cfg->partition_start_ms * 1000ULL)
+    {
+        printf("[SIM] %lu us: partition starts\n", sim.now_us);
+        sim_partition(cfg->partition_map);
+    }
+    else if (sim.now_us == cfg->partition_end_ms * 1000ULL)
+    {
+        printf("[SIM] %lu us: partition healed\n", sim.now_us);
+        sim_heal();
+    }
+}
+
+void sim_run_until(uint64_t end_us)
+{
+    uint64_t hb_us = global_config.heartbeat_interval_ms * 1000ULL;
+
+    while (sim.now_us < end_us)
+    {
+        uint64_t next = RTE_MIN(sim.now_us + sim.step_us, end_us);
+        // partition changes must land exactly on a step boundary
+        const raft_sim_config_t *cfg = &global_config.sim;
+        if (cfg->partition_end_ms > cfg->partition_start_ms)
+        {
+            if (sim.now_us < cfg->partition_start_ms * 1000ULL)
+                next = RTE_MIN(next, cfg->partition_start_ms * 1000ULL);
+            else if (sim.now_us < cfg->partition_end_ms * 1000ULL)
+                next = RTE_MIN(next, cfg->partition_end_ms * 1000ULL);
+        }
+
+        while (sim.heap_len > 0 && sim.heap[0]->deliver_us <= next)
+        {
+            struct sim_msg *m = heap_pop();
+            if (m->deliver_us > sim.now_us)
+                sim.now_us = m->deliver_us;
+            deliver(m);
+            free(m);
+            if (sim.hook != NULL)
+                sim.hook(sim.hook_arg);
+        }
+        sim.now_us = next;
+        apply_partition_schedule();
+
+        for (uint32_t id = 1; id <= MAX_NODES; id++)
+        {
+            struct sim_node *n = &sim.nodes[id];
+            if (n->inst == NULL || !n->up)
+                continue;
+            raft_instance_select(n->inst);
+            timeout_manage();
+            if (sim.now_us - n->last_heartbeat_us >= hb_us)
+            {
+                raft_send_heartbeat();
+                membership_tick();
+                n->last_heartbeat_us = sim.now_us;
+            }
+        }
+        membership_quiescent();
+        if (sim.hook != NULL)
+            sim.hook(sim.hook_arg);
+
+        if (sim.now_us >= sim.next_sample_us)
+        {
+            sample_leaders();
+            sim.next_sample_us = sim.now_us + SIM_SAMPLE_US;
+        }
+    }
+}
+
+int sim_init(const raft_config_t *cfg)
+{
+    memset(&sim, 0, sizeof(sim));
+    sim.step_us = cfg->sim.step_us;
+    rte_srand(cfg->sim.seed);
+    timeout_set_clock(sim_clock, SIM_TSC_HZ);
+    net_set_transport(&sim_transport);
+
+    for (uint32_t a = 1; a <= MAX_NODES; a++)
+        for (uint32_t b = 1; b <= MAX_NODES; b++)
+            sim_set_link(a, b, cfg->sim.delay_us, cfg->sim.jitter_us, cfg->sim.loss);
+
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+    {
+        if (!cfg->member_map[id])
+            continue;
+        sim.nodes[id].inst = raft_instance_create(id);
+        if (sim.nodes[id].inst == NULL)
+        {
+            sim_fini();
+            return -1;
+        }
+        sim.nodes[id].up = true;
+    }
+    // one lcore drives every node: it is the only peer table reader
+    membership_register_reader();
+    return 0;
+}
+
+void sim_fini(void)
+{
+    while (sim.heap_len > 0)
+        free(heap_pop());
+    free(sim.heap);
+    sim.heap = NULL;
+    sim.heap_cap = 0;
+    for (uint32_t id = 1; id <= MAX_NODES; id++)
+    {
+        if (sim.nodes[id].inst != NULL)
+            raft_instance_free(sim.nodes[id].inst);
+        sim.nodes[id].inst = NULL;
+    }
+    net_set_transport(&ethdev_transport);
+}
+
+static void print_report(void)
+{
+    const struct sim_stats *st = &sim.stats;
+    uint32_t with_leader = 0, changes = 0;
+    uint64_t first_min = UINT64_MAX, first_max = 0, first_sum = 0;
+
+    for (uint32_t g = 0; g < global_config.group_num; g++)
+    {
+        const struct sim_group_view *v = &sim.groups[g];
+        changes += v->changes;
+        if (v->changes == 0)
+            continue;
+        with_leader++;
+        first_min = RTE_MIN(first_min, v->first_leader_us);
+        first_max = RTE_MAX(first_max, v->first_leader_us);
+        first_sum += v->first_leader_us;
+    }
+
+    printf("[SIM] seed=%lu virtual_ms=%lu groups=%u\n",
+           global_config.sim.seed, sim.now_us / 1000, global_config.group_num);
+    printf("[SIM] packets sent=%lu delivered=%lu lost=%lu cut=%lu down=%lu\n",
+           st->sent, st->delivered, st->lost, st->cut, st->down);
+    printf("[SIM] groups_with_leader=%u leader_changes=%u\n", with_leader, changes);
+    if (with_leader > 0)
+        printf("[SIM] first_leader_us min=%lu avg=%lu max=%lu\n",
+               first_min, first_sum / with_leader, first_max);
+    for (uint32_t g = 0; g < RTE_MIN(global_config.group_num, 8u); g++)
+    {
+        uint32_t term;
+        uint32_t leader = sim_leader(g, &term);
+        printf("[SIM] group %u leader=%u term=%u\n", g, leader, term);
+    }
+}
+
+/* transport "sim": run every configured node in this process */
+int sim_main(void)
+{
+    if (sim_init(&global_config) < 0)
+        return -1;
+    sim_run_until(global_config.sim.duration_ms * 1000ULL);
+    print_report();
+    sim_fini();
+    return 0;
+}
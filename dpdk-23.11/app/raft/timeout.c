@@ -1,11 +1,32 @@
 // timeout.c
 #include "timeout.h"
+#include <stdlib.h>
 #include <rte_lcore.h>
 #include <rte_cycles.h>
 #include <rte_random.h>
-#include <stdio.h> 
+#include <stdio.h>
+
+/*
+ * Election timers live on a hashed timing wheel with 1 ms ticks: arming
+ * and cancelling are O(1) no matter how many Raft groups are hosted, and
+ * time is read through a pluggable clock so the simulator can run the
+ * same code on virtual time.
+ */
+#define WHEEL_SLOTS 1024          /* power of 2, covers ~1 s per round */
+#define WHEEL_MASK  (WHEEL_SLOTS - 1)
+#define TICK_US     1000
+
+LIST_HEAD(timer_list, raft_timer);
+
+struct timeout_state {
+    struct timer_list slots[WHEEL_SLOTS];
+    uint64_t cur_tick;            /* last tick processed */
+};
 
 static uint32_t g_min_ms, g_max_ms;
+static timeout_clock_fn g_clock;
+static uint64_t g_hz;
+static struct timeout_state *ts_cur;
 
 void timeout_init(uint32_t min_ms, uint32_t max_ms)
 {
@@ -13,6 +34,49 @@ void timeout_init(uint32_t min_ms, uint32_t max_ms)
     g_max_ms = max_ms;
 }
 
+void timeout_set_clock(timeout_clock_fn fn, uint64_t hz)
+{
+    g_clock = fn;
+    g_hz = hz;
+}
+
+uint64_t timeout_now_us(void)
+{
+    if (g_clock == NULL)
+        timeout_set_clock(rte_get_timer_cycles, rte_get_timer_hz());
+    uint64_t cycles = g_clock();
+    // split to avoid overflowing cycles * 10^6 after a long uptime
+    return cycles / g_hz * 1000000ULL + cycles % g_hz * 1000000ULL / g_hz;
+}
+
+static inline uint64_t now_tick(void)
+{
+    return timeout_now_us() / TICK_US;
+}
+
+struct timeout_state *timeout_state_create(void)
+{
+    struct timeout_state *ts = calloc(1, sizeof(*ts));
+    if (ts == NULL)
+        return NULL;
+    for (int i = 0; i < WHEEL_SLOTS; i++)
+        LIST_INIT(&ts->slots[i]);
+    ts->cur_tick = now_tick();
+    return ts;
+}
+
+void timeout_state_free(struct timeout_state *ts)
+{
+    if (ts_cur == ts)
+        ts_cur = NULL;
+    free(ts);
+}
+
+void timeout_state_select(struct timeout_state *ts)
+{
+    ts_cur = ts;
+}
+
 // generate a random number in the range [min, max]
 static inline uint32_t
 rand_in_range(uint32_t min, uint32_t max)
@@ -21,30 +85,68 @@ rand_in_range(uint32_t min, uint32_t max)
     return min + r % (max - min + 1);
 }
 
-void timeout_start_election(struct rte_timer *t,
+void timeout_timer_init(struct raft_timer *t)
+{
+    t->pending = false;
+    t->cb = NULL;
+    t->arg = NULL;
+}
+
+void timeout_start(struct raft_timer *t, uint32_t ms, timeout_cb cb, void *arg)
+{
+    uint64_t expire = now_tick() + (ms * 1000ULL + TICK_US - 1) / TICK_US;
+
+    timeout_stop(t);
+    // never land in a tick that has already been processed
+    if (expire <= ts_cur->cur_tick)
+        expire = ts_cur->cur_tick + 1;
+    t->expire_tick = expire;
+    t->cb = cb;
+    t->arg = arg;
+    t->pending = true;
+    LIST_INSERT_HEAD(&ts_cur->slots[expire & WHEEL_MASK], t, next);
+}
+
+void timeout_start_election(struct raft_timer *t,
                             timeout_cb cb,
                             void *arg)
 {
-    uint32_t ms = rand_in_range(g_min_ms, g_max_ms);
-
-    uint64_t cycles = (uint64_t)ms * rte_get_timer_hz() / 1000;
-    unsigned lcore = rte_get_main_lcore();
-    rte_timer_stop(t);
-    rte_timer_init(t);
-    int rc = rte_timer_reset(t,
-                             cycles,
-                             SINGLE,
-                             lcore,
-                             cb,
-                             arg);
-    if (rc != 0) {
-        printf("Timer reset failed on lcore %u (rc=%d)\n", lcore, rc);
-    } else {
-        printf("Election timer set for %u ms on lcore %u\n", ms, lcore);
-    }
+    timeout_start(t, rand_in_range(g_min_ms, g_max_ms), cb, arg);
+}
+
+void timeout_stop(struct raft_timer *t)
+{
+    if (!t->pending)
+        return;
+    LIST_REMOVE(t, next);
+    t->pending = false;
 }
 
-void timeout_stop(struct rte_timer *t)
+/* Fire every timer of the selected node whose tick has passed */
+void timeout_manage(void)
 {
-    rte_timer_stop(t);
+    uint64_t now = now_tick();
+
+    while (ts_cur->cur_tick < now)
+    {
+        struct timer_list *slot = &ts_cur->slots[++ts_cur->cur_tick & WHEEL_MASK];
+        struct timer_list expired = LIST_HEAD_INITIALIZER(expired);
+        struct raft_timer *t, *tmp;
+
+        // detach first: callbacks may re-arm or stop any timer
+        for (t = LIST_FIRST(slot); t != NULL; t = tmp)
+        {
+            tmp = LIST_NEXT(t, next);
+            if (t->expire_tick > ts_cur->cur_tick)
+                continue; // a later round of the wheel
+            LIST_REMOVE(t, next);
+            LIST_INSERT_HEAD(&expired, t, next);
+        }
+        while ((t = LIST_FIRST(&expired)) != NULL)
+        {
+            LIST_REMOVE(t, next);
+            t->pending = false;
+            t->cb(t, t->arg);
+        }
+    }
 }
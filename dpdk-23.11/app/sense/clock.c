@@ -0,0 +1,21 @@
+#include "clock.h"
+#include <rte_cycles.h>
+
+static sense_clock_fn clock_fn;   // NULL: the TSC
+static uint64_t clock_hz;
+
+void sense_clock_set(sense_clock_fn fn, uint64_t hz)
+{
+    clock_fn = fn;
+    clock_hz = hz;
+}
+
+uint64_t sense_clock_cycles(void)
+{
+    return clock_fn ? clock_fn() : rte_get_tsc_cycles();
+}
+
+uint64_t sense_clock_hz(void)
+{
+    return clock_fn ? clock_hz : rte_get_tsc_hz();
+}
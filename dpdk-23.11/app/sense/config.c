@@ -17,6 +17,38 @@ static int parse_mac(const char *mac_str, struct rte_ether_addr *mac) {
     return 0;
 }
 
+static uint32_t get_u32(json_t *obj, const char *key, uint32_t def)
+{
+    json_t *v = json_object_get(obj, key);
+    return json_is_integer(v) ? (uint32_t)json_integer_value(v) : def;
+}
+
+static void parse_sim(json_t *sim, sense_sim_config_t *cfg)
+{
+    json_t *seed = json_object_get(sim, "seed");
+    cfg->seed = json_is_integer(seed) ? (uint64_t)json_integer_value(seed) : 1;
+    cfg->duration_ms = get_u32(sim, "duration_ms", 10000);
+    cfg->step_us = get_u32(sim, "step_us", 100);
+    cfg->ping_interval_ms = get_u32(sim, "ping_interval_ms", 1000);
+    cfg->delay_us = get_u32(sim, "delay_us", 20);
+    cfg->jitter_us = get_u32(sim, "jitter_us", 10);
+    json_t *loss = json_object_get(sim, "loss");
+    cfg->loss = json_is_number(loss) ? json_number_value(loss) : 0.0;
+
+    json_t *part = json_object_get(sim, "partition_nodes");
+    for (size_t i = 0; i < json_array_size(part); i++) {
+        uint32_t id = (uint32_t)json_integer_value(json_array_get(part, i));
+        if (id >= 1 && id <= SENSE_MAX_NODES)
+            cfg->partition_map[id] = true;
+    }
+    cfg->partition_start_ms = get_u32(sim, "partition_start_ms", 0);
+    cfg->partition_end_ms = get_u32(sim, "partition_end_ms", 0);
+    if (cfg->step_us == 0)
+        cfg->step_us = 100;
+    if (cfg->ping_interval_ms == 0)
+        cfg->ping_interval_ms = 1000;
+}
+
 int sense_load_config(const char *filename)
 {
     json_error_t err;
@@ -66,6 +98,11 @@ int sense_load_config(const char *filename)
         }
     }
 
+    json_t *transport = json_object_get(root, "transport");
+    snprintf(sense_config.transport, sizeof(sense_config.transport), "%s",
+             json_is_string(transport) ? json_string_value(transport) : "ethdev");
+    parse_sim(json_object_get(root, "sim"), &sense_config.sim);
+
     json_t *collector = json_object_get(root, "collector");
     if (json_is_object(collector)) {
         json_t *ip = json_object_get(collector, "ip");
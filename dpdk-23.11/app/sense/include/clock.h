@@ -0,0 +1,12 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * Time source of the RTT measurements, in cycles. It is the TSC unless
+ * the simulator installs its virtual clock.
+ */
+typedef uint64_t (*sense_clock_fn)(void);
+
+void sense_clock_set(sense_clock_fn fn, uint64_t hz);
+uint64_t sense_clock_cycles(void);
+uint64_t sense_clock_hz(void);
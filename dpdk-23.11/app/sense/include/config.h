@@ -5,6 +5,20 @@
 
 #define SENSE_MAX_NODES 16
 
+// In-process simulator settings, the "sim" object of config.json
+typedef struct {
+    uint64_t seed;                  // seeds rte_rand for a reproducible run
+    uint32_t duration_ms;           // virtual time to simulate
+    uint32_t step_us;               // virtual time between polls
+    uint32_t ping_interval_ms;      // each node pings every peer this often
+    uint32_t delay_us;              // one-way delay of every link
+    uint32_t jitter_us;             // extra uniform delay in [0, jitter_us]
+    double loss;                    // drop probability per packet
+    bool partition_map[SENSE_MAX_NODES+1];  // nodes cut off from the rest ...
+    uint32_t partition_start_ms;    // ... from this virtual time ...
+    uint32_t partition_end_ms;      // ... until this one
+} sense_sim_config_t;
+
 typedef struct {
     uint32_t node_num;
     uint32_t node_id;
@@ -15,6 +29,8 @@ typedef struct {
     uint16_t collector_port;
     char collector_ip[16];
     struct rte_ether_addr collector_mac;
+    char transport[16];             // "ethdev" (default) or "sim"
+    sense_sim_config_t sim;         // used when transport is "sim"
 } sense_config_t;
 
 extern sense_config_t sense_config;
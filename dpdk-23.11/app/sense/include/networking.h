@@ -3,7 +3,23 @@
 
 struct sense_unified_snapshot;
 
+/*
+ * Transport carrying Sense payloads between nodes, from the node
+ * sense_config.node_id. The ethdev transport frames them as UDP on the
+ * configured port; the simulator provides an in-memory one.
+ */
+struct sense_transport {
+    const char *name;
+    void (*send)(const void *payload, uint16_t len, uint16_t dst_id);
+    void (*poll)(void);     // receive and dispatch pending payloads
+};
+
+extern const struct sense_transport ethdev_transport;
+
 void net_init(void);
+void net_set_transport(const struct sense_transport *transport);
+void net_dispatch_payloads(const uint8_t *const *payload, const uint16_t *len,
+                           uint16_t n, uint64_t rx_tsc);
 void process_rx(void);
 void send_ping_packet(uint32_t peer_id);
 void send_pong_packet(uint32_t dst_id, uint64_t echoed_ts, uint64_t tsc_hz);
@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+/*
+ * Deterministic network simulator: every node of config.json runs in this
+ * process with its own RTT statistics, Sense packets travel over in-memory
+ * links with configurable delay, jitter, loss and partitions, and RTTs are
+ * measured on a virtual TSC. Given the same config and seed, a run
+ * produces the same measurements.
+ */
+
+#define SIM_TSC_HZ 2000000000ULL   // frequency of the virtual TSC
+
+struct sim_stats {
+    uint64_t sent;
+    uint64_t delivered;
+    uint64_t lost;          // random loss
+    uint64_t cut;           // dropped by a partition
+};
+
+int sim_init(const sense_config_t *cfg);
+void sim_fini(void);
+void sim_run_until(uint64_t end_us);
+uint64_t sim_now_us(void);
+
+void sim_set_link(uint32_t src, uint32_t dst, uint32_t delay_us,
+                  uint32_t jitter_us, double loss);
+void sim_partition(const bool *side);   // cut links between side and the rest
+void sim_heal(void);
+
+// Select the statistics of a node, so the stats API reads them
+int sim_node_select(uint32_t node_id);
+const struct sim_stats *sim_get_stats(void);
+
+int sim_main(void);
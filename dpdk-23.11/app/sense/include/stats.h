@@ -37,6 +37,16 @@ struct sense_rtt_snapshot {
 // Initialize shared table (optionally readable by other processes)
 int sense_stats_init(uint32_t node_id, uint32_t node_num);
 
+// Statistics of one node. The process has one, set up by sense_stats_init();
+// the simulator creates one per simulated node and selects the node it drives.
+struct sense_stats_state;
+struct sense_stats_state *sense_stats_state_create(uint32_t node_id, uint32_t node_num);
+void sense_stats_state_free(struct sense_stats_state *s);
+void sense_stats_select(struct sense_stats_state *s);
+
+// Counters of a peer in the selected statistics, NULL if invalid
+const struct sense_rtt_entry *sense_stats_entry(uint32_t peer_id);
+
 // Record an RTT (called when packet is received)
 void sense_stats_update(uint32_t peer_id, double rtt_us);
 
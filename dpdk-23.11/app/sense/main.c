@@ -2,6 +2,7 @@
 #include "stats.h"
 #include "api.h"
 #include "networking.h"
+#include "sim.h"
 #include <rte_eal.h>
 #include <rte_timer.h>
 #include <rte_cycles.h>
@@ -9,6 +10,7 @@
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 static volatile int force_quit = 0;
 
@@ -63,6 +65,12 @@ int main(int argc, char **argv)
         rte_exit(EXIT_FAILURE, "EAL init failed\n");
 
     rte_timer_subsystem_init();
+    if (strcmp(sense_config.transport, "sim") == 0) {
+        // all nodes of config.json in this process, on virtual time
+        int ret = sim_main();
+        rte_eal_cleanup();
+        return ret < 0 ? EXIT_FAILURE : 0;
+    }
 
     if (sense_stats_init(sense_config.node_id, sense_config.node_num) != 0) {
         rte_exit(EXIT_FAILURE, "Failed to initialize RTT stats table\n");
@@ -4,6 +4,7 @@
 #include "stats.h"
 #include "api.h"
 #include "sense_mp.h"
+#include "clock.h"
 #include <rte_ethdev.h>
 #include <rte_ether.h>
 #include <rte_mbuf.h>
@@ -12,6 +13,7 @@
 #include <rte_errno.h>
 #include <rte_memzone.h>
 #include <rte_cycles.h>
+#include <rte_prefetch.h>
 #include <rte_flow.h>
 #include <arpa/inet.h>
 #include <string.h>
@@ -21,6 +23,7 @@
 
 #define MBUF_POOL_SIZE 4096
 #define BURST_SIZE 32
+#define RX_PREFETCH_OFFSET 4
 #define SENSE_TOTAL_QUEUES 2
 #define RAFT_NET_PORT 9999
 
@@ -108,10 +111,8 @@ static void send_udp_payload(const void *payload, size_t payload_len,
     rte_eth_tx_burst(sense_config.port_id, SENSE_PRIMARY_TXQ, &mbuf, 1);
 }
 
-static void send_raw_packet(const void *payload, size_t payload_len, uint16_t dst_id)
+static void ethdev_send(const void *payload, uint16_t payload_len, uint16_t dst_id)
 {
-    if (dst_id == 0 || dst_id > sense_config.node_num)
-        return;
     const char *dst_ip = sense_config.ip_map[dst_id];
     if (!dst_ip || dst_ip[0] == '\0')
         return;
@@ -121,13 +122,27 @@ static void send_raw_packet(const void *payload, size_t payload_len, uint16_t ds
                      SENSE_PORT);
 }
 
+static const struct sense_transport *transport = &ethdev_transport;
+
+void net_set_transport(const struct sense_transport *t)
+{
+    transport = t;
+}
+
+static void send_raw_packet(const void *payload, size_t payload_len, uint16_t dst_id)
+{
+    if (dst_id == 0 || dst_id > sense_config.node_num)
+        return;
+    transport->send(payload, (uint16_t)payload_len, dst_id);
+}
+
 void send_ping_packet(uint32_t peer_id)
 {
     struct sense_ping_packet pkt;
     pkt.msg_type = MSG_PING_RTT;
     pkt.src_id = sense_config.node_id;
-    pkt.send_ts = rte_get_tsc_cycles();
-    pkt.tsc_hz = rte_get_tsc_hz();
+    pkt.send_ts = sense_clock_cycles();
+    pkt.tsc_hz = sense_clock_hz();
     sense_stats_record_ping(peer_id);
     send_raw_packet(&pkt, sizeof(pkt), peer_id);
 }
@@ -243,69 +258,126 @@ void net_init(void)
     }
 }
 
-void process_rx(void)
+/* UDP payload of a Sense packet, NULL if m carries anything else */
+static inline const uint8_t *sense_payload(const struct rte_mbuf *m, uint16_t *len)
 {
-    struct rte_mbuf *rx_bufs[BURST_SIZE];
-    uint16_t n = rte_eth_rx_burst(sense_config.port_id, SENSE_PRIMARY_RXQ, rx_bufs, BURST_SIZE);
-    for (uint16_t i = 0; i < n; i++) {
-        struct rte_mbuf *m = rx_bufs[i];
-        char *data = rte_pktmbuf_mtod(m, char *);
+    const struct rte_ether_hdr *eth = rte_pktmbuf_mtod(m, const struct rte_ether_hdr *);
+    const struct rte_ipv4_hdr *ip = (const struct rte_ipv4_hdr *)(eth + 1);
+    const struct rte_udp_hdr *udp = (const struct rte_udp_hdr *)(ip + 1);
+
+    // header checks folded into one branch; all fields are in the first cache line
+    uint32_t mismatch = (eth->ether_type ^ rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4)) |
+                        (ip->version_ihl ^ RTE_IPV4_VHL_DEF) |
+                        (ip->next_proto_id ^ IPPROTO_UDP) |
+                        ((udp->dst_port != rte_cpu_to_be_16(SENSE_PORT)) &
+                         (udp->src_port != rte_cpu_to_be_16(SENSE_PORT)));
+    if (mismatch != 0)
+        return NULL;
+
+    uint16_t dgram_len = rte_be_to_cpu_16(udp->dgram_len);
+    if (dgram_len <= sizeof(struct rte_udp_hdr) ||
+        (const char *)udp + dgram_len > rte_pktmbuf_mtod(m, const char *) +
+                                        rte_pktmbuf_data_len(m))
+        return NULL;
+
+    *len = dgram_len - sizeof(struct rte_udp_hdr);
+    return (const uint8_t *)(udp + 1);
+}
 
-        struct rte_ether_hdr *eth = (struct rte_ether_hdr *)data;
-        if (eth->ether_type != rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4)) {
-            rte_pktmbuf_free(m);
-            continue;
-        }
-        struct rte_ipv4_hdr *ip = (struct rte_ipv4_hdr *)(eth + 1);
-        if (ip->next_proto_id != IPPROTO_UDP) {
-            rte_pktmbuf_free(m);
-            continue;
-        }
-        struct rte_udp_hdr *udp = (struct rte_udp_hdr *)(ip + 1);
-        if (udp->dst_port != rte_cpu_to_be_16(SENSE_PORT) &&
-            udp->src_port != rte_cpu_to_be_16(SENSE_PORT)) {
-            rte_pktmbuf_free(m);
+static void handle_pings(const uint8_t *const *ping, const uint16_t *len, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        const struct sense_ping_packet *pp = (const struct sense_ping_packet *)ping[i];
+        if (len[i] < sizeof(*pp) || pp->src_id == 0 || pp->src_id > sense_config.node_num)
             continue;
-        }
+        send_pong_packet(pp->src_id, pp->send_ts, pp->tsc_hz);
+    }
+}
 
-        uint8_t *payload = (uint8_t *)(udp + 1);
-        uint8_t mtype = payload[0];
-
-        if (mtype == MSG_PING_RTT) {
-            struct sense_ping_packet *pp = (struct sense_ping_packet *)payload;
-            uint32_t src_id = pp->src_id;
-            if (src_id == 0 || src_id > sense_config.node_num) {
-                rte_pktmbuf_free(m);
-                continue;
-            }
-            send_pong_packet(src_id, pp->send_ts, pp->tsc_hz);
-            rte_pktmbuf_free(m);
-            continue;
-        } else if (mtype == MSG_PONG_RTT) {
-            struct sense_pong_packet *rp = (struct sense_pong_packet *)payload;
-            uint32_t src_id = rp->src_id;
-            uint32_t dst_id = rp->dst_id;
-            if (dst_id != sense_config.node_id || src_id == 0 || src_id > sense_config.node_num) {
-                rte_pktmbuf_free(m);
-                continue;
-            }
-            uint64_t now = rte_get_tsc_cycles();
-            uint64_t rtt_cycles = now - rp->echoed_ts;
-            double rtt_us = (double)rtt_cycles * 1e6 / (double)rp->tsc_hz;
-
-            // write into a shared table
-            sense_stats_update(src_id, rtt_us);
-            // ring buffer
-            sense_samples_append(src_id, rtt_us);
-
-            printf("[SENSE] Node %u ⟵ RTT pong from %u | rtt=%.3f us\n",
-                   sense_config.node_id, src_id, rtt_us);
-            rte_pktmbuf_free(m);
+static void handle_pongs(const uint8_t *const *pong, const uint16_t *len, uint16_t n,
+                         uint64_t rx_tsc)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        const struct sense_pong_packet *rp = (const struct sense_pong_packet *)pong[i];
+        uint32_t src_id = rp->src_id;
+        if (len[i] < sizeof(*rp) || rp->dst_id != sense_config.node_id ||
+            src_id == 0 || src_id > sense_config.node_num)
             continue;
+        uint64_t rtt_cycles = rx_tsc - rp->echoed_ts;
+        double rtt_us = (double)rtt_cycles * 1e6 / (double)rp->tsc_hz;
+
+        // write into a shared table
+        sense_stats_update(src_id, rtt_us);
+        // ring buffer
+        sense_samples_append(src_id, rtt_us);
+
+        printf("[SENSE] Node %u ⟵ RTT pong from %u | rtt=%.3f us\n",
+               sense_config.node_id, src_id, rtt_us);
+    }
+}
+
+/*
+ * Classify the whole burst first, then run each handler over its batch.
+ * Pongs are timestamped once at burst arrival so that handling the ones
+ * ahead of them does not inflate their RTT.
+ */
+void net_dispatch_payloads(const uint8_t *const *payload, const uint16_t *len,
+                           uint16_t n, uint64_t rx_tsc)
+{
+    const uint8_t *ping[BURST_SIZE], *pong[BURST_SIZE];
+    uint16_t ping_len[BURST_SIZE], pong_len[BURST_SIZE];
+    uint16_t n_ping = 0, n_pong = 0;
+
+    for (uint16_t i = 0; i < n; i++) {
+        if (payload[i][0] == MSG_PING_RTT) {
+            ping[n_ping] = payload[i];
+            ping_len[n_ping++] = len[i];
+        } else if (payload[i][0] == MSG_PONG_RTT) {
+            pong[n_pong] = payload[i];
+            pong_len[n_pong++] = len[i];
         }
+    }
 
-        rte_pktmbuf_free(m);
+    // answer pings first: the peer's RTT includes our time to reply
+    handle_pings(ping, ping_len, n_ping);
+    handle_pongs(pong, pong_len, n_pong, rx_tsc);
+}
+
+static void ethdev_poll(void)
+{
+    struct rte_mbuf *rx_bufs[BURST_SIZE];
+    const uint8_t *payload[BURST_SIZE];
+    uint16_t len[BURST_SIZE];
+    uint16_t n_payload = 0;
+    uint16_t n = rte_eth_rx_burst(sense_config.port_id, SENSE_PRIMARY_RXQ, rx_bufs, BURST_SIZE);
+    if (n == 0)
+        return;
+    uint64_t rx_tsc = sense_clock_cycles();
+
+    for (uint16_t i = 0; i < n && i < RX_PREFETCH_OFFSET; i++)
+        rte_prefetch0(rte_pktmbuf_mtod(rx_bufs[i], void *));
+    for (uint16_t i = 0; i < n; i++) {
+        if (i + RX_PREFETCH_OFFSET < n)
+            rte_prefetch0(rte_pktmbuf_mtod(rx_bufs[i + RX_PREFETCH_OFFSET], void *));
+
+        payload[n_payload] = sense_payload(rx_bufs[i], &len[n_payload]);
+        if (payload[n_payload] != NULL)
+            n_payload++;
     }
+
+    net_dispatch_payloads(payload, len, n_payload, rx_tsc);
+    rte_pktmbuf_free_bulk(rx_bufs, n);
+}
+
+const struct sense_transport ethdev_transport = {
+    .name = "ethdev",
+    .send = ethdev_send,
+    .poll = ethdev_poll,
+};
+
+void process_rx(void)
+{
+    transport->poll();
 }
 
 void sense_publish_stats(const struct sense_unified_snapshot *snapshot)
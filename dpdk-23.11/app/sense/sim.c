@@ -0,0 +1,319 @@
+#include "sim.h"
+#include "clock.h"
+#include "networking.h"
+#include "stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <rte_common.h>
+#include <rte_random.h>
+
+struct sim_msg {
+    uint64_t deliver_us;
+    uint64_t seq;            // FIFO among packets due at the same time
+    uint16_t src;
+    uint16_t dst;
+    uint16_t len;
+    uint8_t data[];
+};
+
+struct sim_link {
+    uint32_t delay_us;
+    uint32_t jitter_us;
+    double loss;
+    bool cut;
+};
+
+struct sim_node {
+    struct sense_stats_state *stats;   // NULL if the id is not configured
+    uint64_t last_ping_us;
+};
+
+static struct {
+    uint64_t now_us;              // virtual time
+    uint64_t seq;
+    uint32_t step_us;
+    uint32_t node_num;
+    struct sim_node nodes[SENSE_MAX_NODES + 1];
+    struct sim_link links[SENSE_MAX_NODES + 1][SENSE_MAX_NODES + 1];
+    struct sim_msg **heap;        // min-heap on (deliver_us, seq)
+    uint32_t heap_len;
+    uint32_t heap_cap;
+    struct sim_stats stats;
+} sim;
+
+static uint64_t sim_clock(void)
+{
+    return sim.now_us * (SIM_TSC_HZ / 1000000ULL);
+}
+
+uint64_t sim_now_us(void)
+{
+    return sim.now_us;
+}
+
+const struct sim_stats *sim_get_stats(void)
+{
+    return &sim.stats;
+}
+
+static inline bool msg_before(const struct sim_msg *a, const struct sim_msg *b)
+{
+    return a->deliver_us < b->deliver_us ||
+           (a->deliver_us == b->deliver_us && a->seq < b->seq);
+}
+
+static int heap_push(struct sim_msg *m)
+{
+    if (sim.heap_len == sim.heap_cap) {
+        uint32_t cap = sim.heap_cap ? sim.heap_cap * 2 : 1024;
+        struct sim_msg **h = realloc(sim.heap, cap * sizeof(*h));
+        if (h == NULL)
+            return -1;
+        sim.heap = h;
+        sim.heap_cap = cap;
+    }
+    uint32_t i = sim.heap_len++;
+    while (i > 0 && msg_before(m, sim.heap[(i - 1) / 2])) {
+        sim.heap[i] = sim.heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    sim.heap[i] = m;
+    return 0;
+}
+
+static struct sim_msg *heap_pop(void)
+{
+    struct sim_msg *top = sim.heap[0];
+    struct sim_msg *last = sim.heap[--sim.heap_len];
+    uint32_t i = 0;
+
+    for (;;) {
+        uint32_t c = 2 * i + 1;
+        if (c >= sim.heap_len)
+            break;
+        if (c + 1 < sim.heap_len && msg_before(sim.heap[c + 1], sim.heap[c]))
+            c++;
+        if (!msg_before(sim.heap[c], last))
+            break;
+        sim.heap[i] = sim.heap[c];
+        i = c;
+    }
+    if (sim.heap_len > 0)
+        sim.heap[i] = last;
+    return top;
+}
+
+static void sim_send(const void *payload, uint16_t len, uint16_t dst_id)
+{
+    uint32_t src = sense_config.node_id;
+    if (dst_id > sim.node_num)
+        return;
+
+    const struct sim_link *link = &sim.links[src][dst_id];
+    sim.stats.sent++;
+    if (link->cut) {
+        sim.stats.cut++;
+        return;
+    }
+    if (link->loss > 0.0 && rte_drand() < link->loss) {
+        sim.stats.lost++;
+        return;
+    }
+
+    struct sim_msg *m = malloc(sizeof(*m) + len);
+    if (m == NULL)
+        return;
+    m->deliver_us = sim.now_us + link->delay_us +
+                    (link->jitter_us ? rte_rand_max(link->jitter_us + 1) : 0);
+    m->seq = sim.seq++;
+    m->src = src;
+    m->dst = dst_id;
+    m->len = len;
+    memcpy(m->data, payload, len);
+    if (heap_push(m) != 0)
+        free(m);
+}
+
+// Nothing to poll: sim_run_until() delivers packets in time order
+static void sim_poll(void)
+{
+}
+
+static const struct sense_transport sim_transport = {
+    .name = "sim",
+    .send = sim_send,
+    .poll = sim_poll,
+};
+
+void sim_set_link(uint32_t src, uint32_t dst, uint32_t delay_us,
+                  uint32_t jitter_us, double loss)
+{
+    sim.links[src][dst].delay_us = delay_us;
+    sim.links[src][dst].jitter_us = jitter_us;
+    sim.links[src][dst].loss = loss;
+}
+
+void sim_partition(const bool *side)
+{
+    for (uint32_t a = 1; a <= SENSE_MAX_NODES; a++)
+        for (uint32_t b = 1; b <= SENSE_MAX_NODES; b++)
+            sim.links[a][b].cut = side[a] != side[b];
+}
+
+void sim_heal(void)
+{
+    for (uint32_t a = 1; a <= SENSE_MAX_NODES; a++)
+        for (uint32_t b = 1; b <= SENSE_MAX_NODES; b++)
+            sim.links[a][b].cut = false;
+}
+
+int sim_node_select(uint32_t node_id)
+{
+    if (node_id == 0 || node_id > sim.node_num || sim.nodes[node_id].stats == NULL)
+        return -1;
+    sense_config.node_id = node_id;
+    sense_stats_select(sim.nodes[node_id].stats);
+    return 0;
+}
+
+static void deliver(struct sim_msg *m)
+{
+    const uint8_t *payload = m->data;
+
+    sim_node_select(m->dst);
+    net_dispatch_payloads(&payload, &m->len, 1, sim_clock());
+    sim.stats.delivered++;
+}
+
+static void apply_partition_schedule(void)
+{
+    const sense_sim_config_t *cfg = &sense_config.sim;
+
+    if (cfg->partition_end_ms <= cfg->partition_start_ms)
+        return;
+    if (sim.now_us == cfg->partition_start_ms * 1000ULL) {
+        printf("[SIM] %lu us: partition starts\n", sim.now_us);
+        sim_partition(cfg->partition_map);
+    } else if (sim.now_us == cfg->partition_end_ms * 1000ULL) {
+        printf("[SIM] %lu us: partition healed\n", sim.now_us);
+        sim_heal();
+    }
+}
+
+void sim_run_until(uint64_t end_us)
+{
+    const sense_sim_config_t *cfg = &sense_config.sim;
+    uint64_t ping_us = cfg->ping_interval_ms * 1000ULL;
+
+    while (sim.now_us < end_us) {
+        uint64_t next = RTE_MIN(sim.now_us + sim.step_us, end_us);
+        // partition changes must land exactly on a step boundary
+        if (cfg->partition_end_ms > cfg->partition_start_ms) {
+            if (sim.now_us < cfg->partition_start_ms * 1000ULL)
+                next = RTE_MIN(next, cfg->partition_start_ms * 1000ULL);
+            else if (sim.now_us < cfg->partition_end_ms * 1000ULL)
+                next = RTE_MIN(next, cfg->partition_end_ms * 1000ULL);
+        }
+
+        while (sim.heap_len > 0 && sim.heap[0]->deliver_us <= next) {
+            struct sim_msg *m = heap_pop();
+            if (m->deliver_us > sim.now_us)
+                sim.now_us = m->deliver_us;
+            deliver(m);
+            free(m);
+        }
+        sim.now_us = next;
+        apply_partition_schedule();
+
+        for (uint32_t id = 1; id <= sim.node_num; id++) {
+            struct sim_node *n = &sim.nodes[id];
+            if (sim.now_us - n->last_ping_us < ping_us)
+                continue;
+            sim_node_select(id);
+            for (uint32_t peer = 1; peer <= sim.node_num; peer++) {
+                if (peer != id)
+                    send_ping_packet(peer);
+            }
+            n->last_ping_us = sim.now_us;
+        }
+    }
+}
+
+int sim_init(const sense_config_t *cfg)
+{
+    memset(&sim, 0, sizeof(sim));
+    sim.step_us = cfg->sim.step_us;
+    sim.node_num = RTE_MIN(cfg->node_num, (uint32_t)SENSE_MAX_NODES);
+    rte_srand(cfg->sim.seed);
+    sense_clock_set(sim_clock, SIM_TSC_HZ);
+    net_set_transport(&sim_transport);
+
+    for (uint32_t a = 1; a <= SENSE_MAX_NODES; a++)
+        for (uint32_t b = 1; b <= SENSE_MAX_NODES; b++)
+            sim_set_link(a, b, cfg->sim.delay_us, cfg->sim.jitter_us, cfg->sim.loss);
+
+    for (uint32_t id = 1; id <= sim.node_num; id++) {
+        sim.nodes[id].stats = sense_stats_state_create(id, sim.node_num);
+        if (sim.nodes[id].stats == NULL) {
+            sim_fini();
+            return -1;
+        }
+        // first round of pings on the first step
+        sim.nodes[id].last_ping_us = -(uint64_t)cfg->sim.ping_interval_ms * 1000ULL;
+    }
+    return 0;
+}
+
+void sim_fini(void)
+{
+    while (sim.heap_len > 0)
+        free(heap_pop());
+    free(sim.heap);
+    sim.heap = NULL;
+    sim.heap_cap = 0;
+    for (uint32_t id = 1; id <= SENSE_MAX_NODES; id++) {
+        if (sim.nodes[id].stats != NULL)
+            sense_stats_state_free(sim.nodes[id].stats);
+        sim.nodes[id].stats = NULL;
+    }
+    net_set_transport(&ethdev_transport);
+    sense_clock_set(NULL, 0);
+}
+
+static void print_report(void)
+{
+    const struct sim_stats *s = &sim.stats;
+    uint32_t window_ms = (uint32_t)(sim.now_us / 1000) + 1;
+
+    printf("[SIM] seed=%lu virtual_ms=%lu nodes=%u\n",
+           sense_config.sim.seed, sim.now_us / 1000, sim.node_num);
+    printf("[SIM] packets sent=%lu delivered=%lu lost=%lu cut=%lu\n",
+           s->sent, s->delivered, s->lost, s->cut);
+    for (uint32_t id = 1; id <= sim.node_num; id++) {
+        sim_node_select(id);
+        for (uint32_t peer = 1; peer <= sim.node_num; peer++) {
+            const struct sense_rtt_entry *e = sense_stats_entry(peer);
+            if (peer == id || e == NULL)
+                continue;
+            printf("[SIM] %u -> %u ping_sent=%u pong_recv=%u loss=%u "
+                   "avg_rtt=%.3f us ewma_rtt=%.3f us\n",
+                   id, peer, e->ping_sent, e->pong_recv, e->loss_count,
+                   sense_get_rtt_avg(peer, window_ms), e->ewma_rtt_us);
+        }
+    }
+}
+
+// transport "sim": run every configured node in this process
+int sim_main(void)
+{
+    uint32_t node_id = sense_config.node_id;
+
+    if (sim_init(&sense_config) < 0)
+        return -1;
+    sim_run_until(sense_config.sim.duration_ms * 1000ULL);
+    print_report();
+    sim_fini();
+    sense_config.node_id = node_id;
+    return 0;
+}
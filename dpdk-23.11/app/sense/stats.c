@@ -1,17 +1,26 @@
 #include "stats.h"
 #include "config.h"
+#include "clock.h"
 #include <rte_memzone.h>
 #include <rte_eal.h>
 #include <rte_cycles.h>
 #include <rte_timer.h>
+#include <stdlib.h>
 #include <string.h>
 
-static struct sense_rtt_table *rtt_tbl = NULL;
-static struct sense_rtt_sample sample_ring[SENSE_MAX_NODES + 1][SENSE_MAX_SAMPLES];
-static uint16_t ring_head[SENSE_MAX_NODES + 1];
-static uint16_t ring_count[SENSE_MAX_NODES + 1];
+// RTT statistics of one node
+struct sense_stats_state {
+    struct sense_rtt_table *rtt_tbl;
+    struct sense_rtt_table own_tbl;     // used unless the table is in a memzone
+    struct sense_rtt_sample sample_ring[SENSE_MAX_NODES + 1][SENSE_MAX_SAMPLES];
+    uint16_t ring_head[SENSE_MAX_NODES + 1];
+    uint16_t ring_count[SENSE_MAX_NODES + 1];
+    struct sense_rtt_snapshot snapshot;
+};
+
+static struct sense_stats_state process_state;
+static struct sense_stats_state *st = &process_state;
 
-static struct sense_rtt_snapshot snapshot;
 static struct rte_timer snapshot_timer;
 static uint32_t snapshot_window_ms = 1000; // the window size for snapshot
 
@@ -28,18 +37,45 @@ int sense_stats_init(uint32_t node_id, uint32_t node_num)
             return -1;
     }
 
-    rtt_tbl = (struct sense_rtt_table *)mz->addr;
-    memset(rtt_tbl, 0, sizeof(*rtt_tbl));
-    rtt_tbl->node_id = node_id;
-    rtt_tbl->node_num = node_num;
-
-    memset(sample_ring, 0, sizeof(sample_ring));
-    memset(ring_head, 0, sizeof(ring_head));
-    memset(ring_count, 0, sizeof(ring_count));
-    memset(&snapshot, 0, sizeof(snapshot));
+    st = &process_state;
+    memset(st, 0, sizeof(*st));
+    st->rtt_tbl = (struct sense_rtt_table *)mz->addr;
+    memset(st->rtt_tbl, 0, sizeof(*st->rtt_tbl));
+    st->rtt_tbl->node_id = node_id;
+    st->rtt_tbl->node_num = node_num;
     return 0;
 }
 
+struct sense_stats_state *sense_stats_state_create(uint32_t node_id, uint32_t node_num)
+{
+    struct sense_stats_state *s = calloc(1, sizeof(*s));
+    if (s == NULL)
+        return NULL;
+    s->rtt_tbl = &s->own_tbl;
+    s->rtt_tbl->node_id = node_id;
+    s->rtt_tbl->node_num = node_num;
+    return s;
+}
+
+void sense_stats_state_free(struct sense_stats_state *s)
+{
+    if (st == s)
+        st = &process_state;
+    free(s);
+}
+
+void sense_stats_select(struct sense_stats_state *s)
+{
+    st = s;
+}
+
+const struct sense_rtt_entry *sense_stats_entry(uint32_t peer_id)
+{
+    if (!st->rtt_tbl || peer_id == 0 || peer_id > SENSE_MAX_NODES)
+        return NULL;
+    return &st->rtt_tbl->entries[peer_id];
+}
+
 static inline int peer_invalid(uint32_t peer_id)
 {
     return (peer_id == 0 || peer_id > SENSE_MAX_NODES);
@@ -47,10 +83,10 @@ static inline int peer_invalid(uint32_t peer_id)
 
 void sense_stats_record_ping(uint32_t peer_id)
 {
-    if (!rtt_tbl || peer_invalid(peer_id))
+    if (!st->rtt_tbl || peer_invalid(peer_id))
         return;
-    struct sense_rtt_entry *entry = &rtt_tbl->entries[peer_id];
-    entry->last_ping_tsc = rte_get_tsc_cycles();
+    struct sense_rtt_entry *entry = &st->rtt_tbl->entries[peer_id];
+    entry->last_ping_tsc = sense_clock_cycles();
     entry->ping_sent++;
     if (entry->ping_sent < entry->pong_recv) {
         entry->ping_sent = entry->pong_recv;
@@ -60,11 +96,11 @@ void sense_stats_record_ping(uint32_t peer_id)
 
 void sense_stats_update(uint32_t peer_id, double rtt_us)
 {
-    if (!rtt_tbl || peer_invalid(peer_id))
+    if (!st->rtt_tbl || peer_invalid(peer_id))
         return;
 
-    uint64_t now = rte_get_tsc_cycles();
-    struct sense_rtt_entry *entry = &rtt_tbl->entries[peer_id];
+    uint64_t now = sense_clock_cycles();
+    struct sense_rtt_entry *entry = &st->rtt_tbl->entries[peer_id];
     entry->last_rtt_us = rtt_us;
     if (entry->ewma_rtt_us <= 0.0) {
         entry->ewma_rtt_us = rtt_us;
@@ -85,31 +121,31 @@ void sense_samples_append(uint32_t peer_id, double rtt_us)
 {
     if (peer_invalid(peer_id))
         return;
-    uint16_t head = ring_head[peer_id];
-    sample_ring[peer_id][head].tsc = rte_get_tsc_cycles();
-    sample_ring[peer_id][head].rtt_us = (float)rtt_us;
-    ring_head[peer_id] = (uint16_t)((head + 1) % SENSE_MAX_SAMPLES);
-    if (ring_count[peer_id] < SENSE_MAX_SAMPLES)
-        ring_count[peer_id]++;
+    uint16_t head = st->ring_head[peer_id];
+    st->sample_ring[peer_id][head].tsc = sense_clock_cycles();
+    st->sample_ring[peer_id][head].rtt_us = (float)rtt_us;
+    st->ring_head[peer_id] = (uint16_t)((head + 1) % SENSE_MAX_SAMPLES);
+    if (st->ring_count[peer_id] < SENSE_MAX_SAMPLES)
+        st->ring_count[peer_id]++;
 }
 
 static double avg_in_window(uint32_t peer_id, uint32_t window_ms)
 {
-    if (ring_count[peer_id] == 0)
+    if (st->ring_count[peer_id] == 0)
         return -1.0;
 
-    uint64_t now = rte_get_tsc_cycles();
-    uint64_t hz = rte_get_tsc_hz();
+    uint64_t now = sense_clock_cycles();
+    uint64_t hz = sense_clock_hz();
     uint64_t window_cycles = (uint64_t)window_ms * hz / 1000ULL;
 
     double sum = 0.0;
     uint32_t cnt = 0;
 
     // 从最新样本往回走
-    int idx = ring_head[peer_id] - 1;
+    int idx = st->ring_head[peer_id] - 1;
     if (idx < 0) idx = SENSE_MAX_SAMPLES - 1;
-    for (uint16_t i = 0; i < ring_count[peer_id]; i++) {
-        const struct sense_rtt_sample *s = &sample_ring[peer_id][idx];
+    for (uint16_t i = 0; i < st->ring_count[peer_id]; i++) {
+        const struct sense_rtt_sample *s = &st->sample_ring[peer_id][idx];
         if (s->tsc == 0) break;
         if (now - s->tsc > window_cycles) break;
         sum += s->rtt_us;
@@ -132,14 +168,14 @@ void sense_get_rtt_avg_all(uint32_t window_ms, struct sense_rtt_snapshot *out)
     memset(out, 0, sizeof(*out));
     for (uint32_t p = 1; p <= SENSE_MAX_NODES; p++)
         out->avg_us[p] = avg_in_window(p, window_ms);
-    out->last_tsc = rte_get_tsc_cycles();
+    out->last_tsc = sense_clock_cycles();
 }
 
 static void snapshot_cb(__rte_unused struct rte_timer *t, __rte_unused void *arg)
 {
     for (uint32_t p = 1; p <= SENSE_MAX_NODES; p++)
-        snapshot.avg_us[p] = avg_in_window(p, snapshot_window_ms);
-    snapshot.last_tsc = rte_get_tsc_cycles();
+        st->snapshot.avg_us[p] = avg_in_window(p, snapshot_window_ms);
+    st->snapshot.last_tsc = rte_get_tsc_cycles();
 }
 
 int sense_snapshot_enable(uint32_t interval_ms, uint32_t window_ms)
@@ -156,13 +192,13 @@ int sense_snapshot_enable(uint32_t interval_ms, uint32_t window_ms)
 
 const struct sense_rtt_snapshot* sense_snapshot_get(void)
 {
-    return &snapshot;
+    return &st->snapshot;
 }
 
 int sense_stats_build_report(const struct sense_rtt_snapshot *snapshot_in,
                              struct sense_stats_report_packet *out)
 {
-    if (!snapshot_in || !out || !rtt_tbl)
+    if (!snapshot_in || !out || !st->rtt_tbl)
         return -1;
 
     memset(out, 0, sizeof(*out));
@@ -175,7 +211,7 @@ int sense_stats_build_report(const struct sense_rtt_snapshot *snapshot_in,
         entry->peer_id = peer;
         double avg = snapshot_in->avg_us[peer];
         entry->avg_rtt_us = (avg >= 0.0) ? (float)avg : -1.0f;
-        entry->loss_count = rtt_tbl->entries[peer].loss_count;
+        entry->loss_count = st->rtt_tbl->entries[peer].loss_count;
         peer_count++;
     }
     out->peer_count = (uint8_t)peer_count;
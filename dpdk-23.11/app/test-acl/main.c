@@ -41,6 +41,7 @@
 #define	OPT_ITER_NUM		"iter"
 #define	OPT_VERBOSE		"verbose"
 #define	OPT_IPV6		"ipv6"
+#define	OPT_COUNTERS		"counters"
 
 #define	TRACE_DEFAULT_NUM	0x10000
 #define	TRACE_STEP_MAX		0x1000
@@ -113,6 +114,7 @@ static struct {
 	uint32_t            iter_num;
 	uint32_t            verbose;
 	uint32_t            ipv6;
+	uint32_t            counters;
 	struct acl_alg      alg;
 	uint32_t            used_traces;
 	void               *traces;
@@ -994,6 +996,10 @@ acx_init(void)
 				"for ACL context\n", config.alg.name);
 	}
 
+	/* count rule hits if asked for. */
+	if (config.counters != 0)
+		rte_acl_set_ctx_counters(config.acx, 1);
+
 	/* add ACL rules. */
 	f = fopen(config.rule_file, "r");
 	if (f == NULL)
@@ -1194,7 +1200,8 @@ print_usage(const char *prgname)
 		"[--" OPT_ITER_NUM "=<number of iterations to perform>]\n"
 		"[--" OPT_VERBOSE "=<verbose level>]\n"
 		"[--" OPT_SEARCH_ALG "=%s]\n"
-		"[--" OPT_IPV6 "(=4B | 8B) <IPv6 rules and trace files>]\n",
+		"[--" OPT_IPV6 "(=4B | 8B) <IPv6 rules and trace files>]\n"
+		"[--" OPT_COUNTERS " <count rule hits>]\n",
 		prgname, RTE_ACL_RESULTS_MULTIPLIER,
 		(uint32_t)RTE_ACL_MAX_CATEGORIES,
 		buf);
@@ -1217,6 +1224,7 @@ dump_config(FILE *f)
 	fprintf(f, "%s:%u(%s)\n", OPT_SEARCH_ALG, config.alg.alg,
 		config.alg.name);
 	fprintf(f, "%s:%u\n", OPT_IPV6, config.ipv6);
+	fprintf(f, "%s:%u\n", OPT_COUNTERS, config.counters);
 }
 
 static void
@@ -1246,6 +1254,7 @@ get_input_opts(int argc, char **argv)
 		{OPT_VERBOSE, 1, 0, 0},
 		{OPT_SEARCH_ALG, 1, 0, 0},
 		{OPT_IPV6, 2, 0, 0},
+		{OPT_COUNTERS, 0, 0, 0},
 		{NULL, 0, 0, 0}
 	};
 
@@ -1297,6 +1306,8 @@ get_input_opts(int argc, char **argv)
 			config.ipv6 = IPV6_FRMT_U32;
 			if (optarg != NULL)
 				get_ipv6_opt(optarg, lgopts[opt_idx].name);
+		} else if (strcmp(lgopts[opt_idx].name, OPT_COUNTERS) == 0) {
+			config.counters = 1;
 		}
 	}
 	config.trace_sz = config.ipv6 ? sizeof(struct ipv6_5tuple) :
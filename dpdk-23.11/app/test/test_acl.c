@@ -23,6 +23,10 @@ test_acl(void)
 #else
 #include <rte_acl.h>
 #include <rte_common.h>
+#include <rte_malloc.h>
+#include <rte_random.h>
+#include <rte_rcu_qsbr.h>
+#include <rte_service.h>
 
 #include "test_acl.h"
 
@@ -402,6 +406,124 @@ test_classify_buid(struct rte_acl_ctx *acx,
 	return 0;
 }
 
+/*
+ * Test rule hit counters: classify results unchanged for all methods,
+ * and with each method, each rule hit as many times as it is returned.
+ */
+static int
+test_rule_counters(void)
+{
+	struct rte_acl_ctx *acx;
+	const uint32_t dim = RTE_DIM(acl_test_data);
+	const uint8_t *data[RTE_DIM(acl_test_data)];
+	const uint8_t *same[RTE_DIM(acl_test_data)];
+	uint32_t results[RTE_DIM(acl_test_data) * RTE_ACL_MAX_CATEGORIES];
+	uint64_t hits[RTE_DIM(acl_test_rules)];
+	uint64_t expect[RTE_DIM(acl_test_rules)];
+	uint32_t i, j, k;
+	int ret;
+
+	static const enum rte_acl_classify_alg alg[] = {
+		RTE_ACL_CLASSIFY_SCALAR,
+		RTE_ACL_CLASSIFY_SSE,
+		RTE_ACL_CLASSIFY_AVX2,
+		RTE_ACL_CLASSIFY_NEON,
+		RTE_ACL_CLASSIFY_ALTIVEC,
+		RTE_ACL_CLASSIFY_AVX512X16,
+		RTE_ACL_CLASSIFY_AVX512X32,
+	};
+
+	acx = rte_acl_create(&acl_param);
+	if (acx == NULL) {
+		printf("Line %i: Error creating ACL context!\n", __LINE__);
+		return -1;
+	}
+
+	ret = test_classify_buid(acx, acl_test_rules, RTE_DIM(acl_test_rules));
+	if (ret != 0 || rte_acl_get_rule_counters(acx, hits,
+			RTE_DIM(hits)) != -ENOTSUP) {
+		printf("Line %i: Error getting counters!\n", __LINE__);
+		goto err;
+	}
+
+	rte_acl_reset(acx);
+	if (rte_acl_set_ctx_counters(acx, 1) != 0 ||
+			test_classify_buid(acx, acl_test_rules,
+				RTE_DIM(acl_test_rules)) != 0 ||
+			test_classify_run(acx, acl_test_data, dim) != 0) {
+		printf("Line %i: Error classifying with counters!\n",
+			__LINE__);
+		goto err;
+	}
+
+	bswap_test_data(acl_test_data, dim, 1);
+	for (i = 0; i != dim; i++)
+		data[i] = (uint8_t *)&acl_test_data[i];
+
+	/* each method has its own way of counting */
+	for (k = 0; k != RTE_DIM(alg); k++) {
+		ret = rte_acl_set_ctx_classify(acx, alg[k]);
+		if (ret == -ENOTSUP) {
+			ret = 0;
+			continue;
+		}
+		if (ret != 0 || rte_acl_reset_rule_counters(acx) != 0) {
+			printf("Line %i: Error resetting counters!\n",
+				__LINE__);
+			ret = -1;
+			break;
+		}
+
+		ret = rte_acl_classify(acx, data, results, dim,
+			RTE_ACL_MAX_CATEGORIES);
+
+		memset(expect, 0, sizeof(expect));
+		for (i = 0; i != RTE_DIM(results); i++) {
+			for (j = 0; j != RTE_DIM(acl_test_rules); j++) {
+				if (results[i] ==
+						acl_test_rules[j].data.userdata)
+					expect[j]++;
+			}
+		}
+
+		/* a burst of the same match, as with a hot rule */
+		for (i = 0; i != dim && results[i * RTE_ACL_MAX_CATEGORIES] == 0;
+				i++)
+			;
+		for (j = 0; j != dim; j++)
+			same[j] = data[i % dim];
+		if (ret == 0)
+			ret = rte_acl_classify(acx, same, results, dim, 1);
+		for (i = 0; i != dim; i++) {
+			for (j = 0; j != RTE_DIM(acl_test_rules); j++) {
+				if (results[i] ==
+						acl_test_rules[j].data.userdata)
+					expect[j]++;
+			}
+		}
+
+		if (ret != 0 || rte_acl_get_rule_counters(acx, hits,
+				RTE_DIM(hits)) != (int)RTE_DIM(acl_test_rules) ||
+				memcmp(hits, expect, sizeof(hits)) != 0) {
+			printf("Line %i: Error in rule counters (alg=%d)!\n",
+				__LINE__, alg[k]);
+			ret = -1;
+			break;
+		}
+		ret = 0;
+	}
+	bswap_test_data(acl_test_data, dim, 0);
+	if (ret != 0)
+		goto err;
+
+	rte_acl_free(acx);
+	return 0;
+
+err:
+	rte_acl_free(acx);
+	return -1;
+}
+
 #define	TEST_CLASSIFY_ITER	4
 
 /*
@@ -595,6 +717,207 @@ test_build_ports_range(void)
 	return ret;
 }
 
+#define	PART_TEST_RULES	0x600
+#define	PART_TEST_DATA	64
+
+static struct rte_acl_ipv4vlan_rule part_test_rules[PART_TEST_RULES];
+
+static uint32_t
+part_test_mask(uint32_t len)
+{
+	return (len == 0) ? 0 : UINT32_MAX << (32 - len);
+}
+
+/*
+ * Generate rules narrow either in source or destination address,
+ * so that the two kinds of rules multiply each other nodes.
+ */
+static void
+gen_part_rules(struct rte_acl_ipv4vlan_rule rules[], uint32_t num)
+{
+	static const uint32_t narrow[] = {24, 28, 32};
+	static const uint32_t wide[] = {0, 8, 12, 16};
+	static const uint8_t proto[] = {IPPROTO_TCP, IPPROTO_UDP, 0};
+	uint32_t i, n, w;
+	struct rte_acl_ipv4vlan_rule *r;
+
+	for (i = 0; i != num; i++) {
+		r = rules + i;
+		memset(r, 0, sizeof(*r));
+
+		/* higher index rules have higher priority */
+		r->data.userdata = i + 1;
+		r->data.priority = i + 1;
+		r->data.category_mask = ACL_ALLOW_MASK;
+
+		r->proto = proto[rte_rand_max(RTE_DIM(proto))];
+		r->proto_mask = (r->proto != 0) ? UINT8_MAX : 0;
+
+		n = narrow[rte_rand_max(RTE_DIM(narrow))];
+		w = wide[rte_rand_max(RTE_DIM(wide))];
+		r->src_mask_len = (i & 1) ? n : w;
+		r->dst_mask_len = (i & 1) ? w : n;
+		r->src_addr = rte_rand() & part_test_mask(r->src_mask_len);
+		r->dst_addr = rte_rand() & part_test_mask(r->dst_mask_len);
+
+		r->src_port_high = UINT16_MAX;
+		r->dst_port_high = UINT16_MAX;
+		if (rte_rand_max(2) != 0) {
+			r->dst_port_low = rte_rand_max(UINT16_MAX);
+			r->dst_port_high = RTE_MIN(r->dst_port_low +
+				rte_rand_max(4000), (uint64_t)UINT16_MAX);
+		}
+	}
+}
+
+/*
+ * Generate packets matching the addresses of random rules,
+ * and find the highest priority rule they match.
+ */
+static void
+gen_part_data(const struct rte_acl_ipv4vlan_rule rules[], uint32_t num,
+	struct ipv4_7tuple tdata[], uint32_t dim)
+{
+	uint32_t i, j, sm, dm;
+	const struct rte_acl_ipv4vlan_rule *r;
+	struct ipv4_7tuple *t;
+
+	for (i = 0; i != dim; i++) {
+		t = tdata + i;
+		memset(t, 0, sizeof(*t));
+
+		r = rules + rte_rand_max(num);
+		t->proto = (rte_rand_max(2) != 0) ? IPPROTO_TCP : IPPROTO_UDP;
+		t->ip_src = r->src_addr | (rte_rand() &
+			~part_test_mask(r->src_mask_len));
+		t->ip_dst = r->dst_addr | (rte_rand() &
+			~part_test_mask(r->dst_mask_len));
+		t->port_src = rte_rand_max(UINT16_MAX + 1);
+		t->port_dst = rte_rand_max(UINT16_MAX + 1);
+
+		for (j = num; j-- != 0; ) {
+			r = rules + j;
+			sm = part_test_mask(r->src_mask_len);
+			dm = part_test_mask(r->dst_mask_len);
+			if ((t->proto & r->proto_mask) == r->proto &&
+					((t->ip_src ^ r->src_addr) & sm) == 0 &&
+					((t->ip_dst ^ r->dst_addr) & dm) == 0 &&
+					t->port_dst >= r->dst_port_low &&
+					t->port_dst <= r->dst_port_high) {
+				t->allow = r->data.userdata;
+				break;
+			}
+		}
+	}
+}
+
+/*
+ * Build the context, getting the number of rule sets the rules were
+ * partitioned in from the debug log of the last build phase.
+ */
+static int
+test_build_parts(struct rte_acl_ctx *acx, const struct rte_acl_config *cfg,
+	uint32_t *num_parts)
+{
+	static const char tag[] = "rule sets: ";
+	uint32_t global_level;
+	FILE *f, *log;
+	char *buf, *p;
+	size_t sz;
+	int level, ret;
+
+	buf = NULL;
+	f = open_memstream(&buf, &sz);
+	if (f == NULL)
+		return -ENOMEM;
+
+	log = rte_log_get_stream();
+	level = rte_log_get_level(RTE_LOGTYPE_ACL);
+	global_level = rte_log_get_global_level();
+	rte_openlog_stream(f);
+	rte_log_set_global_level(RTE_LOG_DEBUG);
+	rte_log_set_level(RTE_LOGTYPE_ACL, RTE_LOG_DEBUG);
+
+	ret = rte_acl_build(acx, cfg);
+
+	rte_log_set_level(RTE_LOGTYPE_ACL, level);
+	rte_log_set_global_level(global_level);
+	rte_openlog_stream(log);
+	fclose(f);
+
+	*num_parts = 0;
+	for (p = buf; (p = strstr(p, tag)) != NULL; p += sizeof(tag) - 1)
+		*num_parts = strtoul(p + sizeof(tag) - 1, NULL, 10);
+	free(buf);
+	return ret;
+}
+
+/*
+ * Test the build of a big rule set under memory limits, which makes the
+ * rules partitioned in several sets, against a linear search of the rules.
+ */
+static int
+test_build_partition(void)
+{
+	static const size_t mem_sizes[] = {0, 0x800000, 0x400000};
+	struct ipv4_7tuple test_data[PART_TEST_DATA];
+	struct rte_acl_config cfg;
+	struct rte_acl_param prm;
+	struct rte_acl_ctx *acx;
+	uint32_t i, num_parts;
+	int32_t ret;
+
+	prm = acl_param;
+	prm.name = "acl_part";
+	acx = rte_acl_create(&prm);
+	if (acx == NULL) {
+		printf("Line %i: Error creating ACL context!\n", __LINE__);
+		return -1;
+	}
+
+	gen_part_rules(part_test_rules, RTE_DIM(part_test_rules));
+	gen_part_data(part_test_rules, RTE_DIM(part_test_rules), test_data,
+		RTE_DIM(test_data));
+
+	ret = rte_acl_ipv4vlan_add_rules(acx, part_test_rules,
+		RTE_DIM(part_test_rules));
+	if (ret != 0)
+		printf("Line %i: Adding rules to ACL context failed!\n",
+			__LINE__);
+
+	for (i = 0; ret == 0 && i != RTE_DIM(mem_sizes); i++) {
+
+		memset(&cfg, 0, sizeof(cfg));
+		acl_ipv4vlan_config(&cfg, ipv4_7tuple_layout,
+			RTE_ACL_MAX_CATEGORIES);
+		cfg.max_size = mem_sizes[i];
+
+		ret = test_build_parts(acx, &cfg, &num_parts);
+		if (ret != 0) {
+			printf("Line %i: Building ACL context failed, "
+				"max_size=%zu!\n", __LINE__, mem_sizes[i]);
+			break;
+		}
+
+		/* only a size limit makes the rules partitioned */
+		if ((mem_sizes[i] == 0) != (num_parts == 1)) {
+			printf("Line %i: Wrong number of rule sets: %u, "
+				"max_size=%zu!\n", __LINE__, num_parts,
+				mem_sizes[i]);
+			ret = -1;
+			break;
+		}
+
+		ret = test_classify_run(acx, test_data, RTE_DIM(test_data));
+		if (ret != 0)
+			printf("%s failed at line %i, max_size=%zu\n",
+				__func__, __LINE__, mem_sizes[i]);
+	}
+
+	rte_acl_free(acx);
+	return ret;
+}
+
 static void
 convert_rule(const struct rte_acl_ipv4vlan_rule *ri,
 	struct acl_ipv4vlan_rule *ro)
@@ -1609,6 +1932,320 @@ test_misc(void)
 	return 0;
 }
 
+/*
+ * Check the classify results of a versioned context, against the
+ * expected ones or against no match at all.
+ */
+static int
+test_vctx_check(struct rte_acl_vctx *vctx, struct rte_rcu_qsbr *v,
+	int empty)
+{
+	int32_t ret;
+	uint32_t i, allow, deny;
+	const uint32_t dim = RTE_DIM(acl_test_data);
+	const uint8_t *data[RTE_DIM(acl_test_data)];
+	uint32_t results[RTE_DIM(acl_test_data) * RTE_ACL_MAX_CATEGORIES];
+
+	bswap_test_data(acl_test_data, dim, 1);
+	for (i = 0; i != dim; i++)
+		data[i] = (uint8_t *)&acl_test_data[i];
+
+	rte_rcu_qsbr_thread_online(v, 0);
+	ret = rte_acl_vctx_classify(vctx, data, results, dim,
+		RTE_ACL_MAX_CATEGORIES);
+	rte_rcu_qsbr_thread_offline(v, 0);
+
+	bswap_test_data(acl_test_data, dim, 0);
+
+	if (ret != 0) {
+		printf("Line %i: vctx classify failed!\n", __LINE__);
+		return ret;
+	}
+
+	for (i = 0; i != dim; i++) {
+		allow = empty ? 0 : acl_test_data[i].allow;
+		deny = empty ? 0 : acl_test_data[i].deny;
+		if (results[i * RTE_ACL_MAX_CATEGORIES + ACL_ALLOW] != allow ||
+				results[i * RTE_ACL_MAX_CATEGORIES + ACL_DENY] !=
+				deny) {
+			printf("Line %i: Error in results at %u "
+				"(expected %u/%u got %u/%u)!\n",
+				__LINE__, i, allow, deny,
+				results[i * RTE_ACL_MAX_CATEGORIES + ACL_ALLOW],
+				results[i * RTE_ACL_MAX_CATEGORIES + ACL_DENY]);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static int
+test_vctx_add(struct rte_acl_vctx *vctx)
+{
+	uint32_t i;
+	int32_t ret;
+	struct acl_ipv4vlan_rule rv;
+
+	for (i = 0, ret = 0; i != RTE_DIM(acl_test_rules) && ret == 0; i++) {
+		acl_ipv4vlan_convert_rule(acl_test_rules + i, &rv);
+		ret = rte_acl_vctx_add_rules(vctx, (struct rte_acl_rule *)&rv,
+			1);
+	}
+
+	return ret;
+}
+
+/*
+ * Test versioned context: rules staged, committed either directly
+ * or by the service, and classify switching to the new rules.
+ */
+static int
+test_vctx(void)
+{
+	struct rte_acl_vctx_param param;
+	struct rte_acl_vctx *vctx;
+	struct rte_rcu_qsbr *v;
+	struct acl_ipv4vlan_rule rv;
+	uint32_t i, ud, uds[2], service_id;
+	size_t sz;
+	int ret;
+
+	sz = rte_rcu_qsbr_get_memsize(1);
+	v = rte_zmalloc(NULL, sz, RTE_CACHE_LINE_SIZE);
+	if (v == NULL || rte_rcu_qsbr_init(v, 1) != 0 ||
+			rte_rcu_qsbr_thread_register(v, 0) != 0) {
+		printf("Line %i: Error creating RCU QSBR variable!\n",
+			__LINE__);
+		rte_free(v);
+		return -1;
+	}
+
+	memset(&param, 0, sizeof(param));
+	param.name = "acl_vctx";
+	param.socket_id = SOCKET_ID_ANY;
+	param.rule_size = RTE_ACL_IPV4VLAN_RULE_SZ;
+	param.max_rule_num = RTE_DIM(acl_test_rules);
+	param.num_shards = RTE_ACL_VCTX_MAX_SHARDS + 1;
+	param.flags = RTE_ACL_VCTX_F_SERVICE;
+	param.v = v;
+	acl_ipv4vlan_config(&param.cfg, ipv4_7tuple_layout,
+		RTE_ACL_MAX_CATEGORIES);
+
+	vctx = rte_acl_vctx_create(&param);
+	if (vctx != NULL || rte_errno != EINVAL) {
+		printf("Line %i: Created vctx with too many shards!\n",
+			__LINE__);
+		goto err;
+	}
+
+	param.num_shards = 4;
+	vctx = rte_acl_vctx_create(&param);
+	if (vctx == NULL) {
+		printf("Line %i: Error creating vctx!\n", __LINE__);
+		goto err;
+	}
+
+	/* nothing visible before the commit */
+	if (test_vctx_add(vctx) != 0 || rte_acl_vctx_pending(vctx) <= 0 ||
+			test_vctx_check(vctx, v, 1) != 0) {
+		printf("Line %i: Error staging rules!\n", __LINE__);
+		goto err;
+	}
+
+	if (rte_acl_vctx_commit(vctx) != 0 ||
+			rte_acl_vctx_pending(vctx) != 0 ||
+			test_vctx_check(vctx, v, 0) != 0) {
+		printf("Line %i: Error committing rules!\n", __LINE__);
+		goto err;
+	}
+
+	/* context full, then duplicate and unknown userdata */
+	acl_ipv4vlan_convert_rule(acl_test_rules, &rv);
+	rv.data.userdata = UINT32_MAX;
+	if (rte_acl_vctx_add_rules(vctx, (struct rte_acl_rule *)&rv, 1) !=
+			-ENOMEM) {
+		printf("Line %i: Added rule to a full vctx!\n", __LINE__);
+		goto err;
+	}
+
+	ud = acl_test_rules[0].data.userdata;
+	if (rte_acl_vctx_del_rules(vctx, &ud, 1) != 0 ||
+			rte_acl_vctx_del_rules(vctx, &ud, 1) != -ENOENT) {
+		printf("Line %i: Error deleting rule!\n", __LINE__);
+		goto err;
+	}
+
+	/* nothing deleted when one userdata is unknown */
+	uds[0] = acl_test_rules[1].data.userdata;
+	uds[1] = ud;
+	if (rte_acl_vctx_del_rules(vctx, uds, RTE_DIM(uds)) != -ENOENT) {
+		printf("Line %i: Deleted unknown rule!\n", __LINE__);
+		goto err;
+	}
+	acl_ipv4vlan_convert_rule(acl_test_rules + 1, &rv);
+	if (rte_acl_vctx_add_rules(vctx, (struct rte_acl_rule *)&rv, 1) !=
+			-EEXIST) {
+		printf("Line %i: Added duplicate rule!\n", __LINE__);
+		goto err;
+	}
+
+	/* delete everything, the service committing */
+	for (i = 1; i != RTE_DIM(acl_test_rules); i++) {
+		ud = acl_test_rules[i].data.userdata;
+		if (rte_acl_vctx_del_rules(vctx, &ud, 1) != 0) {
+			printf("Line %i: Error deleting rule!\n", __LINE__);
+			goto err;
+		}
+	}
+
+	if (rte_acl_vctx_service_id_get(vctx, &service_id) != 0 ||
+			rte_service_runstate_set(service_id, 1) != 0) {
+		printf("Line %i: Error getting vctx service!\n", __LINE__);
+		goto err;
+	}
+
+	ret = test_vctx_check(vctx, v, 0);
+	ret |= rte_service_run_iter_on_app_lcore(service_id, 1);
+	ret |= rte_acl_vctx_pending(vctx);
+	ret |= test_vctx_check(vctx, v, 1);
+	if (ret != 0) {
+		printf("Line %i: Error committing from service!\n", __LINE__);
+		goto err;
+	}
+
+	/* and back */
+	if (test_vctx_add(vctx) != 0 ||
+			rte_service_run_iter_on_app_lcore(service_id, 1) != 0 ||
+			test_vctx_check(vctx, v, 0) != 0) {
+		printf("Line %i: Error committing from service!\n", __LINE__);
+		goto err;
+	}
+
+	rte_acl_vctx_free(vctx);
+	rte_free(v);
+	return 0;
+
+err:
+	rte_acl_vctx_free(vctx);
+	rte_free(v);
+	return -1;
+}
+
+/* run the service, returning the number of commit failures it logged */
+static int
+test_vctx_service_fails(uint32_t service_id)
+{
+	uint32_t global_level;
+	FILE *f, *log;
+	char *buf, *p;
+	size_t sz;
+	int level, n;
+
+	buf = NULL;
+	f = open_memstream(&buf, &sz);
+	if (f == NULL)
+		return -1;
+
+	log = rte_log_get_stream();
+	level = rte_log_get_level(RTE_LOGTYPE_ACL);
+	global_level = rte_log_get_global_level();
+	rte_openlog_stream(f);
+	rte_log_set_global_level(RTE_LOG_ERR);
+	rte_log_set_level(RTE_LOGTYPE_ACL, RTE_LOG_ERR);
+
+	n = rte_service_run_iter_on_app_lcore(service_id, 1);
+
+	rte_log_set_level(RTE_LOGTYPE_ACL, level);
+	rte_log_set_global_level(global_level);
+	rte_openlog_stream(log);
+	fclose(f);
+
+	for (p = buf; n == 0 && (p = strstr(p, "commit failed")) != NULL; p++)
+		n--;
+	free(buf);
+	return -n;
+}
+
+/*
+ * Test versioned context commit failing, the shards exceeding
+ * their max size: the service doesn't retry until the rules change.
+ */
+static int
+test_vctx_commit_error(void)
+{
+	struct rte_acl_vctx_param param;
+	struct rte_acl_vctx *vctx;
+	uint32_t i, ud, service_id;
+
+	memset(&param, 0, sizeof(param));
+	param.name = "acl_vctx_err";
+	param.socket_id = SOCKET_ID_ANY;
+	param.rule_size = RTE_ACL_IPV4VLAN_RULE_SZ;
+	param.max_rule_num = RTE_DIM(acl_test_rules);
+	param.num_shards = 1;
+	param.flags = RTE_ACL_VCTX_F_SERVICE;
+	acl_ipv4vlan_config(&param.cfg, ipv4_7tuple_layout,
+		RTE_ACL_MAX_CATEGORIES);
+	param.cfg.max_size = 1;
+
+	vctx = rte_acl_vctx_create(&param);
+	if (vctx == NULL) {
+		printf("Line %i: Error creating vctx!\n", __LINE__);
+		return -1;
+	}
+
+	if (rte_acl_vctx_service_id_get(vctx, &service_id) != 0 ||
+			rte_service_runstate_set(service_id, 1) != 0) {
+		printf("Line %i: Error getting vctx service!\n", __LINE__);
+		goto err;
+	}
+
+	if (test_vctx_add(vctx) != 0) {
+		printf("Line %i: Error staging rules!\n", __LINE__);
+		goto err;
+	}
+
+	/* failed commit, the service stays idle */
+	if (test_vctx_service_fails(service_id) != 1 ||
+			rte_acl_vctx_error(vctx) != -ERANGE ||
+			test_vctx_service_fails(service_id) != 0 ||
+			rte_acl_vctx_pending(vctx) != 1) {
+		printf("Line %i: Service retried failed commit!\n", __LINE__);
+		goto err;
+	}
+
+	/* while a direct commit does */
+	if (rte_acl_vctx_commit(vctx) != -ERANGE) {
+		printf("Line %i: Committed too big shard!\n", __LINE__);
+		goto err;
+	}
+
+	/* the rules change, the service commits again */
+	for (i = 0; i != RTE_DIM(acl_test_rules); i++) {
+		ud = acl_test_rules[i].data.userdata;
+		if (rte_acl_vctx_del_rules(vctx, &ud, 1) != 0) {
+			printf("Line %i: Error deleting rule!\n", __LINE__);
+			goto err;
+		}
+	}
+
+	if (rte_acl_vctx_error(vctx) != 0 ||
+			test_vctx_service_fails(service_id) != 0 ||
+			rte_acl_vctx_pending(vctx) != 0 ||
+			rte_acl_vctx_error(vctx) != 0) {
+		printf("Line %i: Service didn't commit!\n", __LINE__);
+		goto err;
+	}
+
+	rte_acl_vctx_free(vctx);
+	return 0;
+
+err:
+	rte_acl_vctx_free(vctx);
+	return -1;
+}
+
 static uint32_t
 get_u32_range_max(void)
 {
@@ -1737,12 +2374,20 @@ test_acl(void)
 		return -1;
 	if (test_classify() < 0)
 		return -1;
+	if (test_rule_counters() < 0)
+		return -1;
 	if (test_build_ports_range() < 0)
 		return -1;
+	if (test_build_partition() < 0)
+		return -1;
 	if (test_convert() < 0)
 		return -1;
 	if (test_u32_range() < 0)
 		return -1;
+	if (test_vctx() < 0)
+		return -1;
+	if (test_vctx_commit_error() < 0)
+		return -1;
 
 	return 0;
 }
@@ -9,7 +9,12 @@
 
 #include <rte_ip.h>
 #include <rte_log.h>
+#include <rte_errno.h>
+#include <rte_rib.h>
 #include <rte_fib.h>
+#include <rte_malloc.h>
+#include <rte_random.h>
+#include <rte_vect.h>
 
 #include "test.h"
 
@@ -21,6 +26,12 @@ static int32_t test_free_null(void);
 static int32_t test_add_del_invalid(void);
 static int32_t test_get_invalid(void);
 static int32_t test_lookup(void);
+static int32_t test_modify_bulk(void);
+static int32_t test_modify_bulk_tbl8(void);
+static int32_t test_modify_bulk_rollback(void);
+static int32_t test_rcu_qsbr(void);
+static int32_t test_poptrie(void);
+static int32_t test_poptrie_avx512(void);
 
 #define MAX_ROUTES	(1 << 16)
 #define MAX_TBL8	(1 << 15)
@@ -62,7 +73,19 @@ test_create_invalid(void)
 		"Call succeeded with invalid parameters\n");
 	config.max_routes = MAX_ROUTES;
 
-	config.type = RTE_FIB_DIR24_8 + 1;
+	config.type = RTE_FIB_POPTRIE + 1;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	config.type = RTE_FIB_POPTRIE;
+	config.poptrie.num_nodes = 0;
+	config.poptrie.num_leaves = MAX_TBL8;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+	config.poptrie.num_nodes = MAX_TBL8;
+	config.poptrie.num_leaves = 0;
 	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
 	RTE_TEST_ASSERT(fib == NULL,
 		"Call succeeded with invalid parameters\n");
@@ -373,6 +396,621 @@ test_lookup(void)
 		"Check_fib fails for DIR24_8_8B type\n");
 	rte_fib_free(fib);
 
+	config.type = RTE_FIB_POPTRIE;
+	config.poptrie.num_nodes = MAX_TBL8;
+	config.poptrie.num_leaves = MAX_TBL8;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+	ret = check_fib(fib);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Check_fib fails for POPTRIE type\n");
+	ret = rte_fib_select_lookup(fib, RTE_FIB_LOOKUP_POPTRIE_SCALAR);
+	RTE_TEST_ASSERT(ret == 0, "Failed to select lookup function\n");
+	ret = check_fib(fib);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Check_fib fails for POPTRIE_SCALAR lookup\n");
+	rte_fib_free(fib);
+
+	return TEST_SUCCESS;
+}
+
+#define BULK_ROUTES	2048
+#define BULK_LOOKUPS	4096
+
+/*
+ * Generate routes in 10.0.0.0/14 with random depths, so that they
+ * overlap a lot, applying them to the reference FIB one by one.
+ * Deletes are only generated for routes of the reference FIB.
+ */
+static void
+generate_bulk_routes(struct rte_fib *ref, struct rte_fib_route *routes,
+	unsigned int n)
+{
+	struct rte_rib *rib = rte_fib_get_rib(ref);
+	uint32_t ip;
+	uint8_t depth;
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		depth = rte_rand_max(RTE_FIB_MAXDEPTH + 1);
+		ip = RTE_IPV4(10, 0, 0, 0) | (rte_rand() & 0x3ffff) << 6 |
+			(rte_rand() & 0x3f);
+		ip &= rte_rib_depth_to_mask(depth);
+
+		routes[i].ip = ip;
+		routes[i].depth = depth;
+		if ((rte_rib_lookup_exact(rib, ip, depth) != NULL) &&
+				(rte_rand_max(3) == 0)) {
+			routes[i].op = RTE_FIB_DEL;
+			routes[i].next_hop = 0;
+			rte_fib_delete(ref, ip, depth);
+		} else {
+			routes[i].op = RTE_FIB_ADD;
+			routes[i].next_hop = rte_rand_max(1 << 16);
+			rte_fib_add(ref, ip, depth, routes[i].next_hop);
+		}
+	}
+}
+
+static int
+check_bulk_lookup(struct rte_fib *fib, struct rte_fib *ref,
+	const struct rte_fib_route *routes, unsigned int n)
+{
+	uint32_t ips[BULK_LOOKUPS];
+	uint64_t nhs[BULK_LOOKUPS], ref_nhs[BULK_LOOKUPS];
+	unsigned int i;
+	int ret;
+
+	/* around the first and last address of the routes */
+	for (i = 0; i < BULK_LOOKUPS / 2; i += 2) {
+		ips[i] = routes[i % n].ip - 1;
+		ips[i + 1] = routes[i % n].ip +
+			(uint32_t)(1ULL << (32 - routes[i % n].depth));
+	}
+	for (; i < BULK_LOOKUPS; i++)
+		ips[i] = RTE_IPV4(10, 0, 0, 0) | (rte_rand() & 0x3ffffff);
+
+	ret = rte_fib_lookup_bulk(fib, ips, nhs, BULK_LOOKUPS);
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+	ret = rte_fib_lookup_bulk(ref, ips, ref_nhs, BULK_LOOKUPS);
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+
+	for (i = 0; i < BULK_LOOKUPS; i++)
+		RTE_TEST_ASSERT(nhs[i] == ref_nhs[i],
+			"Wrong nexthop for %#x\n", ips[i]);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Apply random route updates in bulk, and check that the lookups
+ * match the ones of a RIB based FIB updated route by route.
+ */
+int32_t
+test_modify_bulk(void)
+{
+	struct rte_fib *fib = NULL, *pop = NULL, *ref = NULL;
+	struct rte_fib_conf config;
+	struct rte_fib_route *routes;
+	unsigned int i, ret;
+
+	routes = rte_malloc(NULL, sizeof(*routes) * BULK_ROUTES, 0);
+	RTE_TEST_ASSERT(routes != NULL, "Failed to allocate routes\n");
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 100;
+	config.type = RTE_FIB_DUMMY;
+	ref = rte_fib_create("test_modify_bulk_ref", SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(ref != NULL, "Failed to create FIB\n");
+
+	config.type = RTE_FIB_DIR24_8;
+	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_4B;
+	config.dir24_8.num_tbl8 = MAX_TBL8;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	config.type = RTE_FIB_POPTRIE;
+	config.poptrie.num_nodes = MAX_TBL8;
+	config.poptrie.num_leaves = MAX_TBL8;
+	pop = rte_fib_create("test_modify_bulk_pop", SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(pop != NULL, "Failed to create FIB\n");
+
+	for (i = 0; i < 4; i++) {
+		generate_bulk_routes(ref, routes, BULK_ROUTES);
+		ret = rte_fib_modify_bulk(fib, routes, BULK_ROUTES);
+		RTE_TEST_ASSERT(ret == BULK_ROUTES,
+			"Failed to apply routes: %u, %d\n", ret, rte_errno);
+		RTE_TEST_ASSERT(check_bulk_lookup(fib, ref, routes,
+			BULK_ROUTES) == TEST_SUCCESS,
+			"Lookup and check fails\n");
+		ret = rte_fib_modify_bulk(pop, routes, BULK_ROUTES);
+		RTE_TEST_ASSERT(ret == BULK_ROUTES,
+			"Failed to apply routes: %u, %d\n", ret, rte_errno);
+		RTE_TEST_ASSERT(check_bulk_lookup(pop, ref, routes,
+			BULK_ROUTES) == TEST_SUCCESS,
+			"Lookup and check fails\n");
+	}
+
+	/* routes are applied up to the first invalid one */
+	routes[0].ip = RTE_IPV4(192, 0, 2, 0);
+	routes[0].depth = 24;
+	routes[0].op = RTE_FIB_ADD;
+	routes[0].next_hop = 1;
+	routes[1].ip = RTE_IPV4(192, 0, 2, 0);
+	routes[1].depth = RTE_FIB_MAXDEPTH + 1;
+	routes[1].op = RTE_FIB_ADD;
+	routes[1].next_hop = 2;
+	ret = rte_fib_modify_bulk(fib, routes, 2);
+	RTE_TEST_ASSERT((ret == 1) && (rte_errno == EINVAL),
+		"Call succeeded with invalid parameters\n");
+	routes[1].depth = 24;
+	routes[1].op = RTE_FIB_DEL;
+	routes[2] = routes[1];
+	ret = rte_fib_modify_bulk(fib, routes + 1, 2);
+	RTE_TEST_ASSERT((ret == 1) && (rte_errno == ENOENT),
+		"Deleted a missing route\n");
+
+	rte_fib_free(pop);
+	rte_fib_free(fib);
+	rte_fib_free(ref);
+	rte_free(routes);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * rte_fib_modify_bulk tests with all the tbl8 groups in use by /25 routes:
+ *  - Delete a route and add another one in the same chunk, and check
+ *    that the tbl8 group released by the former is used by the latter
+ *  - Add RCU QSBR variable and register a reader, delete a route
+ *  - Check that a chunk needing the tbl8 group still in use by the
+ *    reader fails and leaves the FIB and its RIB unchanged
+ *  - Check that the chunk succeeds once the reader is quiescent
+ */
+int32_t
+test_modify_bulk_tbl8(void)
+{
+	struct rte_fib *fib = NULL;
+	struct rte_fib_conf config;
+	struct rte_fib_rcu_config rcu_cfg = {0};
+	struct rte_fib_route routes[3];
+	struct rte_rcu_qsbr *qsv;
+	struct rte_rib *rib;
+	uint32_t ip[3], nb_tbl8 = 64;
+	uint64_t nh[3];
+	size_t sz;
+	unsigned int i;
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 100;
+	config.type = RTE_FIB_DIR24_8;
+	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_4B;
+	config.dir24_8.num_tbl8 = nb_tbl8;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+	rib = rte_fib_get_rib(fib);
+
+	for (i = 0; i < nb_tbl8; i++) {
+		ret = rte_fib_add(fib, RTE_IPV4(20, 0, i, 0), 25, i);
+		RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+	}
+
+	routes[0].ip = RTE_IPV4(20, 0, 0, 0);
+	routes[0].depth = 25;
+	routes[0].op = RTE_FIB_DEL;
+	routes[1].ip = RTE_IPV4(10, 0, 0, 0);
+	routes[1].depth = 25;
+	routes[1].op = RTE_FIB_ADD;
+	routes[1].next_hop = 1;
+	ret = rte_fib_modify_bulk(fib, routes, 2);
+	RTE_TEST_ASSERT(ret == 2, "Failed to apply routes: %u, %d\n",
+		ret, rte_errno);
+	ip[0] = RTE_IPV4(20, 0, 0, 1);
+	ip[1] = RTE_IPV4(10, 0, 0, 1);
+	rte_fib_lookup_bulk(fib, ip, nh, 2);
+	RTE_TEST_ASSERT((nh[0] == config.default_nh) && (nh[1] == 1),
+		"Failed to get proper nexthop\n");
+
+	sz = rte_rcu_qsbr_get_memsize(1);
+	qsv = rte_zmalloc_socket(NULL, sz, RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	RTE_TEST_ASSERT(qsv != NULL, "Failed to allocate QSBR variable\n");
+	ret = rte_rcu_qsbr_init(qsv, 1);
+	RTE_TEST_ASSERT(ret == 0, "Failed to init QSBR variable\n");
+	rcu_cfg.v = qsv;
+	rcu_cfg.mode = RTE_FIB_QSBR_MODE_DQ;
+	ret = rte_fib_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add QSBR variable\n");
+
+	/* Register pseudo reader */
+	ret = rte_rcu_qsbr_thread_register(qsv, 0);
+	RTE_TEST_ASSERT(ret == 0, "Failed to register reader\n");
+	rte_rcu_qsbr_thread_online(qsv, 0);
+
+	ret = rte_fib_delete(fib, RTE_IPV4(20, 0, 1, 0), 25);
+	RTE_TEST_ASSERT(ret == 0, "Failed to delete a route\n");
+
+	/* the new /25 needs the tbl8 group still in use by the reader */
+	routes[0].ip = RTE_IPV4(20, 0, 2, 0);
+	routes[0].depth = 25;
+	routes[0].op = RTE_FIB_ADD;
+	routes[0].next_hop = 200;
+	routes[1].ip = RTE_IPV4(30, 0, 0, 0);
+	routes[1].depth = 16;
+	routes[1].op = RTE_FIB_ADD;
+	routes[1].next_hop = 201;
+	routes[2].ip = RTE_IPV4(40, 0, 0, 0);
+	routes[2].depth = 25;
+	routes[2].op = RTE_FIB_ADD;
+	routes[2].next_hop = 202;
+	ret = rte_fib_modify_bulk(fib, routes, 3);
+	RTE_TEST_ASSERT((ret == 0) && (rte_errno == ENOSPC),
+		"Reused a tbl8 group in use\n");
+	RTE_TEST_ASSERT((rte_rib_lookup_exact(rib, routes[1].ip, 16) ==
+		NULL) && (rte_rib_lookup_exact(rib, routes[2].ip, 25) ==
+		NULL), "Failed routes left in the RIB\n");
+	for (i = 0; i < 3; i++)
+		ip[i] = routes[i].ip + 1;
+	rte_fib_lookup_bulk(fib, ip, nh, 3);
+	RTE_TEST_ASSERT((nh[0] == 2) && (nh[1] == config.default_nh) &&
+		(nh[2] == config.default_nh),
+		"Failed to get proper nexthop\n");
+
+	/* Reader quiescent */
+	rte_rcu_qsbr_quiescent(qsv, 0);
+
+	ret = rte_fib_modify_bulk(fib, routes, 3);
+	RTE_TEST_ASSERT(ret == 3, "Failed to apply routes: %u, %d\n",
+		ret, rte_errno);
+	rte_fib_lookup_bulk(fib, ip, nh, 3);
+	RTE_TEST_ASSERT((nh[0] == 200) && (nh[1] == 201) && (nh[2] == 202),
+		"Failed to get proper nexthop\n");
+
+	rte_rcu_qsbr_thread_offline(qsv, 0);
+	rte_rcu_qsbr_thread_unregister(qsv, 0);
+
+	rte_fib_free(fib);
+	rte_free(qsv);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * rte_fib_modify_bulk test running out of tbl8 groups while installing a
+ * chunk, without RCU. All the tbl8 groups but two are in use by /25
+ * routes, and two /16 routes have a /25 with the same next hop inside
+ * them, which needs no tbl8 group:
+ *  - Give the second of these /25 its own next hop, which takes one of
+ *    the free tbl8 groups
+ *  - Change the next hop of 10.0.0.0/16 in the same chunk: the edge of
+ *    its /25 needs two free tbl8 groups, so the chunk fails
+ *  - Check that the rollback restored every entry and was reported as
+ *    successful
+ */
+int32_t
+test_modify_bulk_rollback(void)
+{
+	struct rte_fib *fib = NULL;
+	struct rte_fib_conf config;
+	struct rte_fib_route routes[2];
+	uint32_t ip[] = {RTE_IPV4(10, 0, 0, 1), RTE_IPV4(10, 0, 1, 1),
+		RTE_IPV4(10, 0, 1, 200), RTE_IPV4(10, 1, 1, 1),
+		RTE_IPV4(10, 1, 1, 200), RTE_IPV4(20, 0, 61, 1)};
+	uint64_t nh_exp[] = {1, 1, 1, 2, 2, 61};
+	uint64_t nh[RTE_DIM(ip)];
+	uint32_t nb_tbl8 = 64;
+	unsigned int i;
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 100;
+	config.type = RTE_FIB_DIR24_8;
+	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_4B;
+	config.dir24_8.num_tbl8 = nb_tbl8;
+	fib = rte_fib_create("test_bulk_rollback", SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	for (i = 0; i < nb_tbl8 - 2; i++) {
+		ret = rte_fib_add(fib, RTE_IPV4(20, 0, i, 0), 25, i);
+		RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+	}
+	ret = rte_fib_add(fib, RTE_IPV4(10, 0, 0, 0), 16, 1);
+	ret |= rte_fib_add(fib, RTE_IPV4(10, 0, 1, 0), 25, 1);
+	ret |= rte_fib_add(fib, RTE_IPV4(10, 1, 0, 0), 16, 2);
+	ret |= rte_fib_add(fib, RTE_IPV4(10, 1, 1, 0), 25, 2);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add routes\n");
+
+	routes[0].ip = RTE_IPV4(10, 1, 1, 0);
+	routes[0].depth = 25;
+	routes[0].op = RTE_FIB_ADD;
+	routes[0].next_hop = 5;
+	routes[1].ip = RTE_IPV4(10, 0, 0, 0);
+	routes[1].depth = 16;
+	routes[1].op = RTE_FIB_ADD;
+	routes[1].next_hop = 6;
+	ret = rte_fib_modify_bulk(fib, routes, 2);
+	RTE_TEST_ASSERT((ret == 0) && (rte_errno == ENOSPC),
+		"Failed to revert routes: %u, %d\n", ret, rte_errno);
+
+	rte_fib_lookup_bulk(fib, ip, nh, RTE_DIM(ip));
+	for (i = 0; i < RTE_DIM(ip); i++)
+		RTE_TEST_ASSERT(nh[i] == nh_exp[i],
+			"Failed to restore nexthop of ip %u: %" PRIu64 "\n",
+			i, nh[i]);
+
+	/* the tbl8 groups released by the rollback are usable again */
+	routes[1].next_hop = 1;
+	ret = rte_fib_modify_bulk(fib, routes, 2);
+	RTE_TEST_ASSERT(ret == 2, "Failed to apply routes: %u, %d\n",
+		ret, rte_errno);
+	nh_exp[3] = 5;
+	rte_fib_lookup_bulk(fib, ip, nh, RTE_DIM(ip));
+	for (i = 0; i < RTE_DIM(ip); i++)
+		RTE_TEST_ASSERT(nh[i] == nh_exp[i],
+			"Failed to get proper nexthop of ip %u: %" PRIu64 "\n",
+			i, nh[i]);
+
+	rte_fib_free(fib);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * rte_fib_rcu_qsbr_add tests. Reader and writer are in the same thread.
+ *  - Add RCU QSBR variable to a FIB, with invalid and valid parameters
+ *  - Use all the tbl8 groups with routes deeper than 24
+ *  - Register a reader, and delete the routes
+ *  - Check that the tbl8 groups are not reused until the reader
+ *    reports a quiescent state
+ */
+int32_t
+test_rcu_qsbr(void)
+{
+	struct rte_fib *fib = NULL;
+	struct rte_fib_conf config;
+	struct rte_fib_rcu_config rcu_cfg = {0};
+	struct rte_rcu_qsbr *qsv;
+	uint32_t ip, nb_tbl8 = 64;
+	uint64_t nh;
+	size_t sz;
+	unsigned int i;
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 100;
+	config.type = RTE_FIB_DIR24_8;
+	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_4B;
+	config.dir24_8.num_tbl8 = nb_tbl8;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	sz = rte_rcu_qsbr_get_memsize(1);
+	qsv = rte_zmalloc_socket(NULL, sz, RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	RTE_TEST_ASSERT(qsv != NULL, "Failed to allocate QSBR variable\n");
+	ret = rte_rcu_qsbr_init(qsv, 1);
+	RTE_TEST_ASSERT(ret == 0, "Failed to init QSBR variable\n");
+
+	ret = rte_fib_rcu_qsbr_add(NULL, &rcu_cfg);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with invalid parameters\n");
+	rcu_cfg.v = qsv;
+	rcu_cfg.mode = RTE_FIB_QSBR_MODE_SYNC + 1;
+	ret = rte_fib_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with invalid parameters\n");
+	rcu_cfg.mode = RTE_FIB_QSBR_MODE_DQ;
+	ret = rte_fib_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add QSBR variable\n");
+	ret = rte_fib_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(ret == -EEXIST, "QSBR variable added twice\n");
+
+	for (i = 0; i < nb_tbl8; i++) {
+		ip = RTE_IPV4(192, 0, i, 100);
+		ret = rte_fib_add(fib, ip, 28, i);
+		RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+	}
+
+	/* Register pseudo reader */
+	ret = rte_rcu_qsbr_thread_register(qsv, 0);
+	RTE_TEST_ASSERT(ret == 0, "Failed to register reader\n");
+	rte_rcu_qsbr_thread_online(qsv, 0);
+
+	for (i = 0; i < nb_tbl8; i++) {
+		ip = RTE_IPV4(192, 0, i, 100);
+		ret = rte_fib_delete(fib, ip, 28);
+		RTE_TEST_ASSERT(ret == 0, "Failed to delete a route\n");
+		rte_fib_lookup_bulk(fib, &ip, &nh, 1);
+		RTE_TEST_ASSERT(nh == config.default_nh,
+			"Failed to get proper nexthop\n");
+	}
+
+	/* tbl8 groups are still in use by the reader */
+	ip = RTE_IPV4(198, 51, 100, 100);
+	ret = rte_fib_add(fib, ip, 28, 1);
+	RTE_TEST_ASSERT(ret == -ENOSPC, "Reused a tbl8 group in use\n");
+
+	/* Reader quiescent */
+	rte_rcu_qsbr_quiescent(qsv, 0);
+
+	ret = rte_fib_add(fib, ip, 28, 1);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+	rte_fib_lookup_bulk(fib, &ip, &nh, 1);
+	RTE_TEST_ASSERT(nh == 1, "Failed to get proper nexthop\n");
+
+	rte_rcu_qsbr_thread_offline(qsv, 0);
+	rte_rcu_qsbr_thread_unregister(qsv, 0);
+
+	rte_fib_free(fib);
+	rte_free(qsv);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Poptrie specific tests, /32 routes of distinct /16 needing 3 nodes:
+ *  - Use all the nodes, and check that a failed update leaves
+ *    the FIB and its RIB unchanged
+ *  - Add RCU QSBR variable and register a reader
+ *  - Check that the nodes of a deleted route are not reused until
+ *    the reader reports a quiescent state
+ */
+int32_t
+test_poptrie(void)
+{
+	struct rte_fib *fib = NULL;
+	struct rte_fib_conf config;
+	struct rte_fib_rcu_config rcu_cfg = {0};
+	struct rte_rcu_qsbr *qsv;
+	uint32_t ip, nb_routes = 16;
+	uint64_t nh;
+	size_t sz;
+	unsigned int i;
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 100;
+	config.type = RTE_FIB_POPTRIE;
+	config.poptrie.num_nodes = nb_routes * 3;
+	config.poptrie.num_leaves = MAX_TBL8;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	ret = rte_fib_add(fib, RTE_IPV4(10, 0, 0, 0), 8, 1U << 31);
+	RTE_TEST_ASSERT(ret == -EINVAL,
+		"Call succeeded with invalid parameters\n");
+
+	for (i = 0; i < nb_routes; i++) {
+		ip = RTE_IPV4(10, i, 0, 1);
+		ret = rte_fib_add(fib, ip, 32, i);
+		RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+	}
+	ip = RTE_IPV4(10, i, 0, 1);
+	ret = rte_fib_add(fib, ip, 32, i);
+	RTE_TEST_ASSERT(ret == -ENOSPC, "Added a route without nodes left\n");
+	RTE_TEST_ASSERT(rte_rib_lookup_exact(rte_fib_get_rib(fib), ip, 32) ==
+		NULL, "Failed route left in the RIB\n");
+	rte_fib_lookup_bulk(fib, &ip, &nh, 1);
+	RTE_TEST_ASSERT(nh == config.default_nh,
+		"Failed to get proper nexthop\n");
+
+	sz = rte_rcu_qsbr_get_memsize(1);
+	qsv = rte_zmalloc_socket(NULL, sz, RTE_CACHE_LINE_SIZE, SOCKET_ID_ANY);
+	RTE_TEST_ASSERT(qsv != NULL, "Failed to allocate QSBR variable\n");
+	ret = rte_rcu_qsbr_init(qsv, 1);
+	RTE_TEST_ASSERT(ret == 0, "Failed to init QSBR variable\n");
+	rcu_cfg.v = qsv;
+	rcu_cfg.mode = RTE_FIB_QSBR_MODE_DQ;
+	ret = rte_fib_rcu_qsbr_add(fib, &rcu_cfg);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add QSBR variable\n");
+
+	/* Register pseudo reader */
+	ret = rte_rcu_qsbr_thread_register(qsv, 0);
+	RTE_TEST_ASSERT(ret == 0, "Failed to register reader\n");
+	rte_rcu_qsbr_thread_online(qsv, 0);
+
+	ret = rte_fib_delete(fib, RTE_IPV4(10, 0, 0, 1), 32);
+	RTE_TEST_ASSERT(ret == 0, "Failed to delete a route\n");
+
+	/* nodes are still in use by the reader */
+	ret = rte_fib_add(fib, ip, 32, i);
+	RTE_TEST_ASSERT(ret == -ENOSPC, "Reused a node in use\n");
+
+	/* Reader quiescent */
+	rte_rcu_qsbr_quiescent(qsv, 0);
+
+	ret = rte_fib_add(fib, ip, 32, i);
+	RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+	for (i = 0; i <= nb_routes; i++) {
+		ip = RTE_IPV4(10, i, 0, 1);
+		rte_fib_lookup_bulk(fib, &ip, &nh, 1);
+		RTE_TEST_ASSERT(nh == ((i == 0) ? config.default_nh : i),
+			"Failed to get proper nexthop\n");
+	}
+
+	rte_rcu_qsbr_thread_offline(qsv, 0);
+	rte_rcu_qsbr_thread_unregister(qsv, 0);
+
+	rte_fib_free(fib);
+	rte_free(qsv);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Check the lookup selected as RTE_FIB_LOOKUP_POPTRIE_VECTOR_AVX512
+ * against the scalar one, on random overlapping routes, for a number
+ * of addresses that is not a multiple of the vector width.
+ */
+int32_t
+test_poptrie_avx512(void)
+{
+	struct rte_fib *fib = NULL, *ref = NULL;
+	struct rte_fib_conf config;
+	struct rte_fib_route *routes;
+	uint16_t simd_bitwidth = rte_vect_get_max_simd_bitwidth();
+	uint32_t ips[BULK_LOOKUPS - 1];
+	uint64_t nhs[BULK_LOOKUPS - 1], vec_nhs[BULK_LOOKUPS - 1];
+	unsigned int i;
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 100;
+	config.type = RTE_FIB_POPTRIE;
+	config.poptrie.num_nodes = MAX_TBL8;
+	config.poptrie.num_leaves = MAX_TBL8;
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	rte_vect_set_max_simd_bitwidth(RTE_VECT_SIMD_512);
+	ret = rte_fib_select_lookup(fib, RTE_FIB_LOOKUP_POPTRIE_VECTOR_AVX512);
+	rte_vect_set_max_simd_bitwidth(simd_bitwidth);
+	if (ret != 0) {
+		rte_fib_free(fib);
+		return TEST_SKIPPED;
+	}
+
+	routes = rte_malloc(NULL, sizeof(*routes) * BULK_ROUTES, 0);
+	RTE_TEST_ASSERT(routes != NULL, "Failed to allocate routes\n");
+
+	config.type = RTE_FIB_DUMMY;
+	ref = rte_fib_create("test_poptrie_vec_ref", SOCKET_ID_ANY,
+		&config);
+	RTE_TEST_ASSERT(ref != NULL, "Failed to create FIB\n");
+
+	generate_bulk_routes(ref, routes, BULK_ROUTES);
+	ret = rte_fib_modify_bulk(fib, routes, BULK_ROUTES);
+	RTE_TEST_ASSERT(ret == BULK_ROUTES,
+		"Failed to apply routes: %d, %d\n", ret, rte_errno);
+
+	/* around the routes, then anywhere */
+	for (i = 0; i < RTE_DIM(ips) / 2; i++)
+		ips[i] = routes[i % BULK_ROUTES].ip + (uint32_t)rte_rand_max(
+			1ULL << (32 - routes[i % BULK_ROUTES].depth)) - 1;
+	for (; i < RTE_DIM(ips); i++)
+		ips[i] = rte_rand();
+
+	ret = rte_fib_lookup_bulk(fib, ips, vec_nhs, RTE_DIM(ips));
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+	ret = rte_fib_select_lookup(fib, RTE_FIB_LOOKUP_POPTRIE_SCALAR);
+	RTE_TEST_ASSERT(ret == 0, "Failed to select lookup function\n");
+	ret = rte_fib_lookup_bulk(fib, ips, nhs, RTE_DIM(ips));
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+
+	for (i = 0; i < RTE_DIM(ips); i++)
+		RTE_TEST_ASSERT(vec_nhs[i] == nhs[i],
+			"Wrong nexthop for %#x: %#" PRIx64 " instead of %#"
+			PRIx64 "\n", ips[i], vec_nhs[i], nhs[i]);
+
+	rte_fib_free(ref);
+	rte_fib_free(fib);
+	rte_free(routes);
+
 	return TEST_SUCCESS;
 }
 
@@ -386,6 +1024,12 @@ static struct unit_test_suite fib_fast_tests = {
 	TEST_CASE(test_add_del_invalid),
 	TEST_CASE(test_get_invalid),
 	TEST_CASE(test_lookup),
+	TEST_CASE(test_modify_bulk),
+	TEST_CASE(test_modify_bulk_tbl8),
+	TEST_CASE(test_modify_bulk_rollback),
+	TEST_CASE(test_rcu_qsbr),
+	TEST_CASE(test_poptrie),
+	TEST_CASE(test_poptrie_avx512),
 	TEST_CASES_END()
 	}
 };
@@ -5,12 +5,15 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdlib.h>
 
 #include <rte_memory.h>
 #include <rte_log.h>
 #include <rte_rib6.h>
 #include <rte_fib6.h>
+#include <rte_random.h>
+#include <rte_vect.h>
 
 #include "test.h"
 
@@ -22,6 +25,7 @@ static int32_t test_free_null(void);
 static int32_t test_add_del_invalid(void);
 static int32_t test_get_invalid(void);
 static int32_t test_lookup(void);
+static int32_t test_poptrie_avx512(void);
 
 #define MAX_ROUTES	(1 << 16)
 /** Maximum number of tbl8 for 2-byte entries */
@@ -64,7 +68,14 @@ test_create_invalid(void)
 		"Call succeeded with invalid parameters\n");
 	config.max_routes = MAX_ROUTES;
 
-	config.type = RTE_FIB6_TRIE + 1;
+	config.type = RTE_FIB6_POPTRIE + 1;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib == NULL,
+		"Call succeeded with invalid parameters\n");
+
+	config.type = RTE_FIB6_POPTRIE;
+	config.poptrie.num_nodes = 0;
+	config.poptrie.num_leaves = MAX_TBL8;
 	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
 	RTE_TEST_ASSERT(fib == NULL,
 		"Call succeeded with invalid parameters\n");
@@ -382,6 +393,123 @@ test_lookup(void)
 		"Check_fib fails for TRIE_8B type\n");
 	rte_fib6_free(fib);
 
+	config.type = RTE_FIB6_POPTRIE;
+	config.poptrie.num_nodes = MAX_TBL8;
+	config.poptrie.num_leaves = MAX_TBL8;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+	ret = check_fib(fib);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Check_fib fails for POPTRIE type\n");
+	ret = rte_fib6_select_lookup(fib, RTE_FIB6_LOOKUP_POPTRIE_SCALAR);
+	RTE_TEST_ASSERT(ret == 0, "Failed to select lookup function\n");
+	ret = check_fib(fib);
+	RTE_TEST_ASSERT(ret == TEST_SUCCESS,
+		"Check_fib fails for POPTRIE_SCALAR lookup\n");
+	rte_fib6_free(fib);
+
+	return TEST_SUCCESS;
+}
+
+#define POPTRIE_ROUTES	512
+#define POPTRIE_LOOKUPS	4095
+
+/* Mask of the byte i of an address for the given depth */
+static inline uint8_t
+depth_mask(unsigned int i, uint8_t depth)
+{
+	if (depth >= 8 * (i + 1))
+		return 0xff;
+	if (depth <= 8 * i)
+		return 0;
+	return 0xff << (8 * (i + 1) - depth);
+}
+
+/* Random address within the prefix */
+static void
+random_in_prefix(uint8_t ip[RTE_FIB6_IPV6_ADDR_SIZE],
+	const uint8_t prefix[RTE_FIB6_IPV6_ADDR_SIZE], uint8_t depth)
+{
+	unsigned int i;
+	uint8_t msk;
+
+	for (i = 0; i < RTE_FIB6_IPV6_ADDR_SIZE; i++) {
+		msk = depth_mask(i, depth);
+		ip[i] = (prefix[i] & msk) | ((uint8_t)rte_rand() & ~msk);
+	}
+}
+
+/*
+ * Check the lookup selected as RTE_FIB6_LOOKUP_POPTRIE_VECTOR_AVX512
+ * against the scalar one, on random overlapping routes, for a number
+ * of addresses that is not a multiple of the vector width.
+ */
+int32_t
+test_poptrie_avx512(void)
+{
+	static uint8_t prefixes[POPTRIE_ROUTES][RTE_FIB6_IPV6_ADDR_SIZE];
+	static uint8_t depths[POPTRIE_ROUTES];
+	static uint8_t ips[POPTRIE_LOOKUPS][RTE_FIB6_IPV6_ADDR_SIZE];
+	static uint64_t nhs[POPTRIE_LOOKUPS], vec_nhs[POPTRIE_LOOKUPS];
+	struct rte_fib6 *fib = NULL;
+	struct rte_fib6_conf config;
+	uint16_t simd_bitwidth = rte_vect_get_max_simd_bitwidth();
+	const uint8_t base[RTE_FIB6_IPV6_ADDR_SIZE] = {
+		0x20, 0x01, 0x0d, 0xb8
+	};
+	unsigned int i, j;
+	int ret;
+
+	config.max_routes = MAX_ROUTES;
+	config.rib_ext_sz = 0;
+	config.default_nh = 100;
+	config.type = RTE_FIB6_POPTRIE;
+	config.poptrie.num_nodes = 1 << 17;
+	config.poptrie.num_leaves = 1 << 17;
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &config);
+	RTE_TEST_ASSERT(fib != NULL, "Failed to create FIB\n");
+
+	rte_vect_set_max_simd_bitwidth(RTE_VECT_SIMD_512);
+	ret = rte_fib6_select_lookup(fib,
+		RTE_FIB6_LOOKUP_POPTRIE_VECTOR_AVX512);
+	rte_vect_set_max_simd_bitwidth(simd_bitwidth);
+	if (ret != 0) {
+		rte_fib6_free(fib);
+		return TEST_SKIPPED;
+	}
+
+	/* in 2001:db8::/32, half of them in 2001:db8::/38 */
+	for (i = 0; i < POPTRIE_ROUTES; i++) {
+		depths[i] = 32 + rte_rand_max(RTE_FIB6_MAXDEPTH - 32 + 1);
+		random_in_prefix(prefixes[i], base, (i & 1) ? 38 : 32);
+		for (j = 0; j < RTE_FIB6_IPV6_ADDR_SIZE; j++)
+			prefixes[i][j] &= depth_mask(j, depths[i]);
+		ret = rte_fib6_add(fib, prefixes[i], depths[i],
+			rte_rand_max(1 << 16));
+		RTE_TEST_ASSERT(ret == 0, "Failed to add a route\n");
+	}
+
+	/* within the routes, then anywhere in 2001:db8::/32 */
+	for (i = 0; i < POPTRIE_LOOKUPS / 2; i++)
+		random_in_prefix(ips[i], prefixes[i % POPTRIE_ROUTES],
+			depths[i % POPTRIE_ROUTES]);
+	for (; i < POPTRIE_LOOKUPS; i++)
+		random_in_prefix(ips[i], base, 32);
+
+	ret = rte_fib6_lookup_bulk(fib, ips, vec_nhs, POPTRIE_LOOKUPS);
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+	ret = rte_fib6_select_lookup(fib, RTE_FIB6_LOOKUP_POPTRIE_SCALAR);
+	RTE_TEST_ASSERT(ret == 0, "Failed to select lookup function\n");
+	ret = rte_fib6_lookup_bulk(fib, ips, nhs, POPTRIE_LOOKUPS);
+	RTE_TEST_ASSERT(ret == 0, "Failed to lookup\n");
+
+	for (i = 0; i < POPTRIE_LOOKUPS; i++)
+		RTE_TEST_ASSERT(vec_nhs[i] == nhs[i],
+			"Wrong nexthop at %u: %#" PRIx64 " instead of %#"
+			PRIx64 "\n", i, vec_nhs[i], nhs[i]);
+
+	rte_fib6_free(fib);
+
 	return TEST_SUCCESS;
 }
 
@@ -395,6 +523,7 @@ static struct unit_test_suite fib6_fast_tests = {
 	TEST_CASE(test_add_del_invalid),
 	TEST_CASE(test_get_invalid),
 	TEST_CASE(test_lookup),
+	TEST_CASE(test_poptrie_avx512),
 	TEST_CASES_END()
 	}
 };
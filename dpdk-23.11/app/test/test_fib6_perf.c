@@ -10,6 +10,8 @@
 #include <rte_cycles.h>
 #include <rte_random.h>
 #include <rte_memory.h>
+#include <rte_malloc.h>
+#include <rte_vect.h>
 #include <rte_fib6.h>
 
 #include "test.h"
@@ -26,6 +28,8 @@
 #define ITERATIONS (1 << 10)
 #define BATCH_SIZE 100000
 #define NUMBER_TBL8S                                           (1 << 16)
+#define POPTRIE_NUM_NODES (1 << 16)
+#define POPTRIE_NUM_LEAVES (1 << 16)
 
 static void
 print_route_distribution(const struct rules_tbl_entry *table, uint32_t n)
@@ -63,39 +67,88 @@ get_max_nh(uint8_t nh_sz)
 	return ((1ULL << (bits_in_nh(nh_sz) - 1)) - 1);
 }
 
-static int
-test_fib6_perf(void)
+/* lookup functions to measure, those not matching the FIB type are skipped */
+static const struct {
+	enum rte_fib6_lookup_type type;
+	const char *name;
+} lookup_types[] = {
+	{ RTE_FIB6_LOOKUP_TRIE_SCALAR, "TRIE scalar" },
+	{ RTE_FIB6_LOOKUP_TRIE_VECTOR_AVX512, "TRIE AVX512" },
+	{ RTE_FIB6_LOOKUP_POPTRIE_SCALAR, "POPTRIE scalar" },
+	{ RTE_FIB6_LOOKUP_POPTRIE_VECTOR_AVX512, "POPTRIE AVX512" },
+};
+
+/* Memory allocated from the DPDK heaps of all sockets. */
+static size_t
+heap_allocated(void)
 {
-	struct rte_fib6 *fib = NULL;
-	struct rte_fib6_conf conf;
+	struct rte_malloc_socket_stats stats;
+	unsigned int i;
+	size_t sz = 0;
+
+	for (i = 0; i < rte_socket_count(); i++)
+		if (rte_malloc_get_socket_stats(rte_socket_id_by_idx(i),
+				&stats) == 0)
+			sz += stats.heap_allocsz_bytes;
+	return sz;
+}
+
+static void
+test_fib6_perf_lookup(struct rte_fib6 *fib, const char *name)
+{
+	static uint8_t ip_batch[NUM_IPS_ENTRIES][16];
+	static uint64_t next_hops[NUM_IPS_ENTRIES];
 	uint64_t begin, total_time;
 	unsigned int i, j;
-	uint64_t next_hop_add;
-	int status = 0;
 	int64_t count = 0;
-	uint8_t ip_batch[NUM_IPS_ENTRIES][16];
-	uint64_t next_hops[NUM_IPS_ENTRIES];
+	double cycles;
 
-	conf.type = RTE_FIB6_TRIE;
-	conf.default_nh = 0;
-	conf.max_routes = 1000000;
-	conf.rib_ext_sz = 0;
-	conf.trie.nh_sz = RTE_FIB6_TRIE_4B;
-	conf.trie.num_tbl8 = RTE_MIN(get_max_nh(conf.trie.nh_sz), 1000000U);
+	for (i = 0; i < NUM_IPS_ENTRIES; i++)
+		memcpy(ip_batch[i], large_ips_table[i].ip, 16);
 
-	rte_srand(rte_rdtsc());
+	total_time = 0;
+	for (i = 0; i < ITERATIONS; i++) {
 
-	printf("No. routes = %u\n", (unsigned int) NUM_ROUTE_ENTRIES);
+		/* Lookup per batch */
+		begin = rte_rdtsc();
+		rte_fib6_lookup_bulk(fib, ip_batch, next_hops, NUM_IPS_ENTRIES);
+		total_time += rte_rdtsc() - begin;
 
-	print_route_distribution(large_route_table,
-		(uint32_t)NUM_ROUTE_ENTRIES);
+		for (j = 0; j < NUM_IPS_ENTRIES; j++)
+			if (next_hops[j] == 0)
+				count++;
+	}
+	cycles = (double)total_time / ((double)ITERATIONS * BATCH_SIZE);
+	printf("BULK FIB Lookup %s: %.1f cycles, %.1f Mlookups/s "
+		"(fails = %.1f%%)\n", name, cycles,
+		(double)rte_get_tsc_hz() / cycles / 1e6,
+		(count * 100.0) / (double)(ITERATIONS * BATCH_SIZE));
+}
 
-	/* Only generate IPv6 address of each item in large IPS table,
-	 * here next_hop is not needed.
-	 */
-	generate_large_ips_table(0);
+static int
+test_fib6_perf_type(struct rte_fib6_conf *conf, const char *name)
+{
+	struct rte_fib6 *fib = NULL;
+	struct rte_fib6_conf rib_conf;
+	uint64_t begin, total_time;
+	unsigned int i;
+	uint64_t next_hop_add;
+	int status = 0;
+	size_t mem, rib_mem;
+
+	printf("\n%s:\n", name);
+
+	/* memory of the RIB alone, to be left out of the FIB one */
+	rib_conf = *conf;
+	rib_conf.type = RTE_FIB6_DUMMY;
+	mem = heap_allocated();
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &rib_conf);
+	TEST_FIB_ASSERT(fib != NULL);
+	rib_mem = heap_allocated() - mem;
+	rte_fib6_free(fib);
 
-	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, &conf);
+	mem = heap_allocated();
+	fib = rte_fib6_create(__func__, SOCKET_ID_ANY, conf);
 	TEST_FIB_ASSERT(fib != NULL);
 
 	/* Measure add. */
@@ -114,27 +167,14 @@ test_fib6_perf(void)
 	printf("Average FIB Add: %g cycles\n",
 			(double)total_time / NUM_ROUTE_ENTRIES);
 
-	/* Measure bulk Lookup */
-	total_time = 0;
-	count = 0;
-
-	for (i = 0; i < NUM_IPS_ENTRIES; i++)
-		memcpy(ip_batch[i], large_ips_table[i].ip, 16);
-
-	for (i = 0; i < ITERATIONS; i++) {
+	printf("FIB memory: %.1f MB, RIB excluded\n",
+		(double)(heap_allocated() - mem - rib_mem) / (1 << 20));
 
-		/* Lookup per batch */
-		begin = rte_rdtsc();
-		rte_fib6_lookup_bulk(fib, ip_batch, next_hops, NUM_IPS_ENTRIES);
-		total_time += rte_rdtsc() - begin;
-
-		for (j = 0; j < NUM_IPS_ENTRIES; j++)
-			if (next_hops[j] == 0)
-				count++;
+	/* Measure bulk Lookup */
+	for (i = 0; i < RTE_DIM(lookup_types); i++) {
+		if (rte_fib6_select_lookup(fib, lookup_types[i].type) == 0)
+			test_fib6_perf_lookup(fib, lookup_types[i].name);
 	}
-	printf("BULK FIB Lookup: %.1f cycles (fails = %.1f%%)\n",
-			(double)total_time / ((double)ITERATIONS * BATCH_SIZE),
-			(count * 100.0) / (double)(ITERATIONS * BATCH_SIZE));
 
 	/* Delete */
 	status = 0;
@@ -156,4 +196,45 @@ test_fib6_perf(void)
 	return 0;
 }
 
+static int
+test_fib6_perf(void)
+{
+	struct rte_fib6_conf conf;
+	uint16_t simd_bitwidth = rte_vect_get_max_simd_bitwidth();
+	int ret;
+
+	rte_srand(rte_rdtsc());
+
+	printf("No. routes = %u\n", (unsigned int) NUM_ROUTE_ENTRIES);
+
+	print_route_distribution(large_route_table,
+		(uint32_t)NUM_ROUTE_ENTRIES);
+
+	/* Only generate IPv6 address of each item in large IPS table,
+	 * here next_hop is not needed.
+	 */
+	generate_large_ips_table(0);
+
+	/* let the AVX512 lookups be selected if the CPU allows it */
+	rte_vect_set_max_simd_bitwidth(RTE_VECT_SIMD_512);
+
+	conf.type = RTE_FIB6_TRIE;
+	conf.default_nh = 0;
+	conf.max_routes = 1000000;
+	conf.rib_ext_sz = 0;
+	conf.trie.nh_sz = RTE_FIB6_TRIE_4B;
+	conf.trie.num_tbl8 = RTE_MIN(get_max_nh(conf.trie.nh_sz), 1000000U);
+	ret = test_fib6_perf_type(&conf, "TRIE");
+
+	conf.type = RTE_FIB6_POPTRIE;
+	conf.poptrie.num_nodes = POPTRIE_NUM_NODES;
+	conf.poptrie.num_leaves = POPTRIE_NUM_LEAVES;
+	if (ret == 0)
+		ret = test_fib6_perf_type(&conf, "POPTRIE");
+
+	rte_vect_set_max_simd_bitwidth(simd_bitwidth);
+
+	return ret;
+}
+
 REGISTER_PERF_TEST(fib6_perf_autotest, test_fib6_perf);
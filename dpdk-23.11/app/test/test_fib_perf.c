@@ -12,6 +12,8 @@
 #include <rte_random.h>
 #include <rte_branch_prediction.h>
 #include <rte_ip.h>
+#include <rte_malloc.h>
+#include <rte_vect.h>
 #include <rte_fib.h>
 
 #include "test.h"
@@ -30,6 +32,9 @@
 
 #define MAX_RULE_NUM (1200000)
 
+#define POPTRIE_NUM_NODES (1 << 20)
+#define POPTRIE_NUM_LEAVES (1 << 22)
+
 struct route_rule {
 	uint32_t ip;
 	uint8_t depth;
@@ -316,34 +321,95 @@ print_route_distribution(const struct route_rule *table, uint32_t n)
 	printf("\n");
 }
 
-static int
-test_fib_perf(void)
+/* lookup functions to measure, those not matching the FIB type are skipped */
+static const struct {
+	enum rte_fib_lookup_type type;
+	const char *name;
+} lookup_types[] = {
+	{ RTE_FIB_LOOKUP_DIR24_8_SCALAR_MACRO, "DIR24_8 scalar macro" },
+	{ RTE_FIB_LOOKUP_DIR24_8_SCALAR_INLINE, "DIR24_8 scalar inline" },
+	{ RTE_FIB_LOOKUP_DIR24_8_SCALAR_UNI, "DIR24_8 scalar uni" },
+	{ RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX512, "DIR24_8 AVX512" },
+	{ RTE_FIB_LOOKUP_POPTRIE_SCALAR, "POPTRIE scalar" },
+	{ RTE_FIB_LOOKUP_POPTRIE_VECTOR_AVX512, "POPTRIE AVX512" },
+};
+
+/* Memory allocated from the DPDK heaps of all sockets. */
+static size_t
+heap_allocated(void)
 {
-	struct rte_fib *fib = NULL;
-	struct rte_fib_conf config;
+	struct rte_malloc_socket_stats stats;
+	unsigned int i;
+	size_t sz = 0;
+
+	for (i = 0; i < rte_socket_count(); i++)
+		if (rte_malloc_get_socket_stats(rte_socket_id_by_idx(i),
+				&stats) == 0)
+			sz += stats.heap_allocsz_bytes;
+	return sz;
+}
 
-	config.max_routes = 2000000;
-	config.rib_ext_sz = 0;
-	config.type = RTE_FIB_DIR24_8;
-	config.default_nh = 0;
-	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_4B;
-	config.dir24_8.num_tbl8 = 65535;
+static void
+test_fib_perf_lookup(struct rte_fib *fib, const char *name)
+{
 	uint64_t begin, total_time;
 	unsigned int i, j;
-	uint32_t next_hop_add = 0xAA;
-	int status = 0;
 	int64_t count = 0;
+	double cycles;
 
-	rte_srand(rte_rdtsc());
+	total_time = 0;
+	for (i = 0; i < ITERATIONS; i++) {
+		static uint32_t ip_batch[BATCH_SIZE];
+		uint64_t next_hops[BULK_SIZE];
 
-	generate_large_route_rule_table();
+		/* Create array of random IP addresses */
+		for (j = 0; j < BATCH_SIZE; j++)
+			ip_batch[j] = rte_rand();
 
-	printf("No. routes = %u\n", (unsigned int) NUM_ROUTE_ENTRIES);
+		/* Lookup per batch */
+		begin = rte_rdtsc();
+		for (j = 0; j < BATCH_SIZE; j += BULK_SIZE) {
+			uint32_t k;
+			rte_fib_lookup_bulk(fib, &ip_batch[j], next_hops,
+				BULK_SIZE);
+			for (k = 0; k < BULK_SIZE; k++)
+				if (unlikely(!(next_hops[k] != 0)))
+					count++;
+		}
 
-	print_route_distribution(large_route_table,
-		(uint32_t) NUM_ROUTE_ENTRIES);
+		total_time += rte_rdtsc() - begin;
+	}
+	cycles = (double)total_time / ((double)ITERATIONS * BATCH_SIZE);
+	printf("BULK FIB Lookup %s: %.1f cycles, %.1f Mlookups/s "
+		"(fails = %.1f%%)\n", name, cycles,
+		(double)rte_get_tsc_hz() / cycles / 1e6,
+		(count * 100.0) / (double)(ITERATIONS * BATCH_SIZE));
+}
 
-	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &config);
+static int
+test_fib_perf_type(struct rte_fib_conf *config, const char *name)
+{
+	struct rte_fib *fib = NULL;
+	struct rte_fib_conf rib_config;
+	uint64_t begin, total_time;
+	unsigned int i;
+	uint32_t next_hop_add = 0xAA;
+	int status = 0;
+	size_t mem, rib_mem;
+
+	printf("\n%s:\n", name);
+
+	/* memory of the RIB alone, to be left out of the FIB one */
+	rib_config = *config;
+	rib_config.type = RTE_FIB_DUMMY;
+	mem = heap_allocated();
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, &rib_config);
+	TEST_FIB_ASSERT(fib != NULL);
+	rib_mem = heap_allocated() - mem;
+	rte_fib_free(fib);
+
+	mem = heap_allocated();
+	fib = rte_fib_create(__func__, SOCKET_ID_ANY, config);
 	TEST_FIB_ASSERT(fib != NULL);
 
 	/* Measure add. */
@@ -362,33 +428,14 @@ test_fib_perf(void)
 	printf("Average FIB Add: %g cycles\n",
 			(double)total_time / NUM_ROUTE_ENTRIES);
 
-	/* Measure bulk Lookup */
-	total_time = 0;
-	count = 0;
-	for (i = 0; i < ITERATIONS; i++) {
-		static uint32_t ip_batch[BATCH_SIZE];
-		uint64_t next_hops[BULK_SIZE];
-
-		/* Create array of random IP addresses */
-		for (j = 0; j < BATCH_SIZE; j++)
-			ip_batch[j] = rte_rand();
-
-		/* Lookup per batch */
-		begin = rte_rdtsc();
-		for (j = 0; j < BATCH_SIZE; j += BULK_SIZE) {
-			uint32_t k;
-			rte_fib_lookup_bulk(fib, &ip_batch[j], next_hops,
-				BULK_SIZE);
-			for (k = 0; k < BULK_SIZE; k++)
-				if (unlikely(!(next_hops[k] != 0)))
-					count++;
-		}
+	printf("FIB memory: %.1f MB, RIB excluded\n",
+		(double)(heap_allocated() - mem - rib_mem) / (1 << 20));
 
-		total_time += rte_rdtsc() - begin;
+	/* Measure bulk Lookup */
+	for (i = 0; i < RTE_DIM(lookup_types); i++) {
+		if (rte_fib_select_lookup(fib, lookup_types[i].type) == 0)
+			test_fib_perf_lookup(fib, lookup_types[i].name);
 	}
-	printf("BULK FIB Lookup: %.1f cycles (fails = %.1f%%)\n",
-			(double)total_time / ((double)ITERATIONS * BATCH_SIZE),
-			(count * 100.0) / (double)(ITERATIONS * BATCH_SIZE));
 
 	/* Delete */
 	status = 0;
@@ -399,7 +446,7 @@ test_fib_perf(void)
 				large_route_table[i].depth);
 	}
 
-	total_time += rte_rdtsc() - begin;
+	total_time = rte_rdtsc() - begin;
 
 	printf("Average FIB Delete: %g cycles\n",
 			(double)total_time / NUM_ROUTE_ENTRIES);
@@ -409,4 +456,42 @@ test_fib_perf(void)
 	return 0;
 }
 
+static int
+test_fib_perf(void)
+{
+	struct rte_fib_conf config;
+	uint16_t simd_bitwidth = rte_vect_get_max_simd_bitwidth();
+	int ret;
+
+	rte_srand(rte_rdtsc());
+
+	generate_large_route_rule_table();
+
+	printf("No. routes = %u\n", (unsigned int) NUM_ROUTE_ENTRIES);
+
+	print_route_distribution(large_route_table,
+		(uint32_t) NUM_ROUTE_ENTRIES);
+
+	/* let the AVX512 lookups be selected if the CPU allows it */
+	rte_vect_set_max_simd_bitwidth(RTE_VECT_SIMD_512);
+
+	config.max_routes = 2000000;
+	config.rib_ext_sz = 0;
+	config.type = RTE_FIB_DIR24_8;
+	config.default_nh = 0;
+	config.dir24_8.nh_sz = RTE_FIB_DIR24_8_4B;
+	config.dir24_8.num_tbl8 = 65535;
+	ret = test_fib_perf_type(&config, "DIR24_8");
+
+	config.type = RTE_FIB_POPTRIE;
+	config.poptrie.num_nodes = POPTRIE_NUM_NODES;
+	config.poptrie.num_leaves = POPTRIE_NUM_LEAVES;
+	if (ret == 0)
+		ret = test_fib_perf_type(&config, "POPTRIE");
+
+	rte_vect_set_max_simd_bitwidth(simd_bitwidth);
+
+	return ret;
+}
+
 REGISTER_PERF_TEST(fib_perf_autotest, test_fib_perf);
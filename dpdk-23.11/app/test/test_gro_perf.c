@@ -0,0 +1,538 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <rte_byteorder.h>
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_ether.h>
+#include <rte_gro.h>
+#include <rte_ip.h>
+#include <rte_mbuf.h>
+#include <rte_tcp.h>
+#include <rte_udp.h>
+#include <rte_vxlan.h>
+
+#include "test.h"
+
+#define NB_FLOWS	4
+#define PKTS_PER_FLOW	8
+#define BURST_SIZE	(NB_FLOWS * PKTS_PER_FLOW)
+#define NB_ITERATIONS	10000
+
+/* Flow counts of the timeout mode test, and packets per flow */
+#define MAX_CTX_FLOWS	4096
+#define CTX_PKTS_PER_FLOW	2
+#define NB_CTX_ITERATIONS	16
+
+#define NB_MBUFS	(CTX_PKTS_PER_FLOW * MAX_CTX_FLOWS + 4 * BURST_SIZE)
+
+/* Payload of each packet, a multiple of 8 for IP fragments */
+#define PAYLOAD_LEN	1232
+
+#define VXLAN_HDR_LEN	(sizeof(struct rte_udp_hdr) + \
+		sizeof(struct rte_vxlan_hdr) + sizeof(struct rte_ether_hdr))
+#define IPV6_FRAG_LEN	(sizeof(struct rte_ipv6_hdr) + RTE_IPV6_FRAG_HDR_SIZE)
+
+/* 2001:0200::/48 is IANA reserved range for IPv6 benchmarking (RFC5180) */
+static const uint8_t ip6_addr[16] = {32, 1, 2, 0};
+
+/* use RFC5735 / RFC2544 reserved network test addresses */
+#define IP_SRC_ADDR(x) ((198U << 24) | (18 << 16) | (0 << 8) | (x))
+#define IP_DST_ADDR(x) ((198U << 24) | (18 << 16) | (1 << 15) | (x))
+
+struct gro_perf_case {
+	const char *name;
+	uint64_t gro_type;
+	/* Build the packet 'idx' of 'flow' */
+	struct rte_mbuf *(*build)(uint32_t flow, uint32_t idx);
+	/* Check a packet merged from PKTS_PER_FLOW packets */
+	int (*check)(struct rte_mbuf *pkt);
+};
+
+static struct rte_mempool *pkt_pool;
+static struct rte_mbuf *tmpl[BURST_SIZE];
+static struct rte_mbuf *ctx_pkts[CTX_PKTS_PER_FLOW * MAX_CTX_FLOWS];
+
+static const uint16_t ctx_flow_nums[] = {64, 256, 1024, 4096};
+
+static void
+fill_ipv6_hdr(struct rte_ipv6_hdr *ip6, uint32_t flow, uint8_t proto,
+		uint16_t payload_len)
+{
+	ip6->vtc_flow = rte_cpu_to_be_32(6 << 28);
+	ip6->payload_len = rte_cpu_to_be_16(payload_len);
+	ip6->proto = proto;
+	ip6->hop_limits = 64;
+	memcpy(ip6->src_addr, ip6_addr, sizeof(ip6->src_addr));
+	memcpy(ip6->dst_addr, ip6_addr, sizeof(ip6->dst_addr));
+	ip6->src_addr[15] = flow;
+	ip6->dst_addr[15] = 0xff;
+}
+
+static void
+fill_ipv4_hdr(struct rte_ipv4_hdr *ip, uint32_t flow, uint8_t proto,
+		uint16_t total_length, uint16_t fragment_offset)
+{
+	ip->version_ihl = RTE_IPV4_VHL_DEF;
+	ip->total_length = rte_cpu_to_be_16(total_length);
+	ip->packet_id = rte_cpu_to_be_16(flow);
+	ip->fragment_offset = rte_cpu_to_be_16(fragment_offset);
+	ip->time_to_live = 64;
+	ip->next_proto_id = proto;
+	ip->src_addr = rte_cpu_to_be_32(IP_SRC_ADDR(flow));
+	ip->dst_addr = rte_cpu_to_be_32(IP_DST_ADDR(flow));
+}
+
+static struct rte_mbuf *
+alloc_pkt(uint16_t len)
+{
+	struct rte_mbuf *m;
+	char *data;
+
+	m = rte_pktmbuf_alloc(pkt_pool);
+	if (m == NULL)
+		return NULL;
+	data = rte_pktmbuf_append(m, len);
+	if (data == NULL) {
+		rte_pktmbuf_free(m);
+		return NULL;
+	}
+	memset(data, 0, len);
+
+	return m;
+}
+
+/* Outer Ethernet, IPv6, UDP and VxLAN headers, followed by inner Ethernet */
+static void
+fill_vxlan6_hdrs(struct rte_mbuf *m, uint32_t flow)
+{
+	struct rte_ether_hdr *eth;
+	struct rte_udp_hdr *udp;
+	struct rte_vxlan_hdr *vxlan;
+	uint16_t len = m->pkt_len - sizeof(*eth) - sizeof(struct rte_ipv6_hdr);
+
+	eth = rte_pktmbuf_mtod(m, struct rte_ether_hdr *);
+	eth->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+	fill_ipv6_hdr((struct rte_ipv6_hdr *)(eth + 1), 0, IPPROTO_UDP, len);
+
+	udp = rte_pktmbuf_mtod_offset(m, struct rte_udp_hdr *,
+			sizeof(*eth) + sizeof(struct rte_ipv6_hdr));
+	udp->src_port = rte_cpu_to_be_16(49152 + flow);
+	udp->dst_port = rte_cpu_to_be_16(RTE_VXLAN_DEFAULT_PORT);
+	udp->dgram_len = rte_cpu_to_be_16(len);
+
+	vxlan = (struct rte_vxlan_hdr *)(udp + 1);
+	vxlan->vx_flags = rte_cpu_to_be_32(0x08000000);
+	vxlan->vx_vni = rte_cpu_to_be_32(100 << 8);
+
+	eth = (struct rte_ether_hdr *)(vxlan + 1);
+	eth->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
+
+	m->outer_l2_len = sizeof(struct rte_ether_hdr);
+	m->outer_l3_len = sizeof(struct rte_ipv6_hdr);
+	m->l2_len = VXLAN_HDR_LEN;
+}
+
+static struct rte_mbuf *
+build_tcp4(uint32_t flow, uint32_t idx)
+{
+	struct rte_ether_hdr *eth;
+	struct rte_ipv4_hdr *ip;
+	struct rte_tcp_hdr *tcp;
+	struct rte_mbuf *m;
+	uint16_t ip_len = sizeof(*ip) + sizeof(*tcp) + PAYLOAD_LEN;
+
+	m = alloc_pkt(sizeof(*eth) + ip_len);
+	if (m == NULL)
+		return NULL;
+
+	eth = rte_pktmbuf_mtod(m, struct rte_ether_hdr *);
+	eth->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
+	ip = (struct rte_ipv4_hdr *)(eth + 1);
+	fill_ipv4_hdr(ip, 0, IPPROTO_TCP, ip_len, RTE_IPV4_HDR_DF_FLAG);
+	tcp = (struct rte_tcp_hdr *)(ip + 1);
+	tcp->src_port = rte_cpu_to_be_16(1024 + flow);
+	tcp->dst_port = rte_cpu_to_be_16(80);
+	tcp->sent_seq = rte_cpu_to_be_32(1 + idx * PAYLOAD_LEN);
+	tcp->recv_ack = rte_cpu_to_be_32(1);
+	tcp->data_off = (sizeof(*tcp) / 4) << 4;
+	tcp->tcp_flags = RTE_TCP_ACK_FLAG;
+
+	m->l2_len = sizeof(*eth);
+	m->l3_len = sizeof(*ip);
+	m->l4_len = sizeof(*tcp);
+	m->packet_type = RTE_PTYPE_L2_ETHER | RTE_PTYPE_L3_IPV4 |
+		RTE_PTYPE_L4_TCP;
+
+	return m;
+}
+
+static struct rte_mbuf *
+build_udp6(uint32_t flow, uint32_t idx)
+{
+	struct rte_ether_hdr *eth;
+	struct rte_ipv6_hdr *ip6;
+	struct rte_ipv6_fragment_ext *frag;
+	struct rte_mbuf *m;
+	uint16_t mf = idx < PKTS_PER_FLOW - 1;
+
+	m = alloc_pkt(sizeof(*eth) + IPV6_FRAG_LEN + PAYLOAD_LEN);
+	if (m == NULL)
+		return NULL;
+
+	eth = rte_pktmbuf_mtod(m, struct rte_ether_hdr *);
+	eth->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+	ip6 = (struct rte_ipv6_hdr *)(eth + 1);
+	fill_ipv6_hdr(ip6, flow, IPPROTO_FRAGMENT,
+			RTE_IPV6_FRAG_HDR_SIZE + PAYLOAD_LEN);
+	frag = (struct rte_ipv6_fragment_ext *)(ip6 + 1);
+	frag->next_header = IPPROTO_UDP;
+	frag->frag_data = rte_cpu_to_be_16(
+			RTE_IPV6_SET_FRAG_DATA(idx * PAYLOAD_LEN, mf));
+	frag->id = rte_cpu_to_be_32(flow);
+
+	m->l2_len = sizeof(*eth);
+	m->l3_len = IPV6_FRAG_LEN;
+	m->packet_type = RTE_PTYPE_L2_ETHER | RTE_PTYPE_L3_IPV6_EXT |
+		RTE_PTYPE_L4_UDP;
+
+	return m;
+}
+
+static int
+check_udp6(struct rte_mbuf *pkt)
+{
+	const struct rte_ipv6_hdr *ip6;
+	const struct rte_ipv6_fragment_ext *frag;
+
+	TEST_ASSERT_EQUAL(pkt->pkt_len, sizeof(struct rte_ether_hdr) +
+			IPV6_FRAG_LEN + PKTS_PER_FLOW * PAYLOAD_LEN,
+			"Wrong merged UDP/IPv6 length %u", pkt->pkt_len);
+	ip6 = rte_pktmbuf_mtod_offset(pkt, struct rte_ipv6_hdr *,
+			sizeof(struct rte_ether_hdr));
+	frag = (const struct rte_ipv6_fragment_ext *)(ip6 + 1);
+	TEST_ASSERT_EQUAL(rte_be_to_cpu_16(ip6->payload_len),
+			RTE_IPV6_FRAG_HDR_SIZE + PKTS_PER_FLOW * PAYLOAD_LEN,
+			"Wrong IPv6 payload length");
+	TEST_ASSERT_EQUAL(rte_be_to_cpu_16(frag->frag_data), 0,
+			"Merged packet is still a fragment");
+
+	return TEST_SUCCESS;
+}
+
+static struct rte_mbuf *
+build_vxlan6_tcp4(uint32_t flow, uint32_t idx)
+{
+	struct rte_ipv4_hdr *ip;
+	struct rte_tcp_hdr *tcp;
+	struct rte_mbuf *m;
+	uint16_t inner_len;
+
+	inner_len = sizeof(*ip) + sizeof(*tcp) + PAYLOAD_LEN;
+	m = alloc_pkt(sizeof(struct rte_ether_hdr) +
+			sizeof(struct rte_ipv6_hdr) + VXLAN_HDR_LEN +
+			inner_len);
+	if (m == NULL)
+		return NULL;
+	fill_vxlan6_hdrs(m, flow);
+
+	ip = rte_pktmbuf_mtod_offset(m, struct rte_ipv4_hdr *,
+			m->outer_l2_len + m->outer_l3_len + m->l2_len);
+	fill_ipv4_hdr(ip, flow, IPPROTO_TCP, inner_len, RTE_IPV4_HDR_DF_FLAG);
+	tcp = (struct rte_tcp_hdr *)(ip + 1);
+	tcp->src_port = rte_cpu_to_be_16(1024 + flow);
+	tcp->dst_port = rte_cpu_to_be_16(80);
+	tcp->sent_seq = rte_cpu_to_be_32(1 + idx * PAYLOAD_LEN);
+	tcp->recv_ack = rte_cpu_to_be_32(1);
+	tcp->data_off = (sizeof(*tcp) / 4) << 4;
+	tcp->tcp_flags = RTE_TCP_ACK_FLAG;
+
+	m->l3_len = sizeof(*ip);
+	m->l4_len = sizeof(*tcp);
+	m->packet_type = RTE_PTYPE_L2_ETHER | RTE_PTYPE_L3_IPV6 |
+		RTE_PTYPE_L4_UDP | RTE_PTYPE_TUNNEL_VXLAN |
+		RTE_PTYPE_INNER_L2_ETHER | RTE_PTYPE_INNER_L3_IPV4 |
+		RTE_PTYPE_INNER_L4_TCP;
+
+	return m;
+}
+
+static struct rte_mbuf *
+build_vxlan6_udp4(uint32_t flow, uint32_t idx)
+{
+	struct rte_ipv4_hdr *ip;
+	struct rte_mbuf *m;
+	uint16_t frag_off;
+
+	m = alloc_pkt(sizeof(struct rte_ether_hdr) +
+			sizeof(struct rte_ipv6_hdr) + VXLAN_HDR_LEN +
+			sizeof(*ip) + PAYLOAD_LEN);
+	if (m == NULL)
+		return NULL;
+	fill_vxlan6_hdrs(m, flow);
+
+	frag_off = (idx * PAYLOAD_LEN) >> 3;
+	if (idx < PKTS_PER_FLOW - 1)
+		frag_off |= RTE_IPV4_HDR_MF_FLAG;
+	ip = rte_pktmbuf_mtod_offset(m, struct rte_ipv4_hdr *,
+			m->outer_l2_len + m->outer_l3_len + m->l2_len);
+	fill_ipv4_hdr(ip, flow, IPPROTO_UDP, sizeof(*ip) + PAYLOAD_LEN,
+			frag_off);
+
+	m->l3_len = sizeof(*ip);
+	m->packet_type = RTE_PTYPE_L2_ETHER | RTE_PTYPE_L3_IPV6 |
+		RTE_PTYPE_L4_UDP | RTE_PTYPE_TUNNEL_VXLAN |
+		RTE_PTYPE_INNER_L2_ETHER | RTE_PTYPE_INNER_L3_IPV4 |
+		RTE_PTYPE_INNER_L4_UDP;
+
+	return m;
+}
+
+static int
+check_vxlan6(struct rte_mbuf *pkt)
+{
+	const struct rte_ipv6_hdr *ip6;
+	const struct rte_udp_hdr *udp;
+	uint32_t hdr_len;
+
+	hdr_len = pkt->outer_l2_len + pkt->outer_l3_len + pkt->l2_len +
+		pkt->l3_len + pkt->l4_len;
+	TEST_ASSERT_EQUAL(pkt->pkt_len,
+			hdr_len + PKTS_PER_FLOW * PAYLOAD_LEN,
+			"Wrong merged VxLAN length %u", pkt->pkt_len);
+	ip6 = rte_pktmbuf_mtod_offset(pkt, struct rte_ipv6_hdr *,
+			pkt->outer_l2_len);
+	udp = (const struct rte_udp_hdr *)(ip6 + 1);
+	TEST_ASSERT_EQUAL(rte_be_to_cpu_16(ip6->payload_len),
+			pkt->pkt_len - pkt->outer_l2_len - pkt->outer_l3_len,
+			"Wrong outer IPv6 payload length");
+	TEST_ASSERT_EQUAL(rte_be_to_cpu_16(udp->dgram_len),
+			pkt->pkt_len - pkt->outer_l2_len - pkt->outer_l3_len,
+			"Wrong outer UDP length");
+
+	return TEST_SUCCESS;
+}
+
+static const struct gro_perf_case perf_cases[] = {
+	{ "UDP/IPv6", RTE_GRO_UDP_IPV6, build_udp6, check_udp6 },
+	{ "VxLAN IPv6 TCP/IPv4", RTE_GRO_IPV6_VXLAN_TCP_IPV4,
+		build_vxlan6_tcp4, check_vxlan6 },
+	{ "VxLAN IPv6 UDP/IPv4", RTE_GRO_IPV6_VXLAN_UDP_IPV4,
+		build_vxlan6_udp4, check_vxlan6 },
+};
+
+static void
+free_pkts(struct rte_mbuf **pkts, uint16_t nb_pkts)
+{
+	uint16_t i;
+
+	for (i = 0; i < nb_pkts; i++)
+		rte_pktmbuf_free(pkts[i]);
+}
+
+/* Copy the templates, packets of all flows being interleaved */
+static int
+copy_burst(struct rte_mbuf **pkts)
+{
+	uint32_t i;
+
+	for (i = 0; i < BURST_SIZE; i++) {
+		pkts[i] = rte_pktmbuf_copy(tmpl[i], pkt_pool, 0, UINT32_MAX);
+		if (pkts[i] == NULL) {
+			free_pkts(pkts, i);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int
+check_merged(const struct gro_perf_case *tc, struct rte_mbuf **pkts,
+		uint16_t nb_pkts)
+{
+	uint16_t i;
+
+	TEST_ASSERT_EQUAL(nb_pkts, NB_FLOWS,
+			"%s: %u packets after GRO, expected %u", tc->name,
+			nb_pkts, NB_FLOWS);
+	for (i = 0; i < nb_pkts; i++)
+		if (tc->check(pkts[i]) != TEST_SUCCESS)
+			return TEST_FAILED;
+
+	return TEST_SUCCESS;
+}
+
+static int
+gro_perf_run(const struct gro_perf_case *tc)
+{
+	struct rte_gro_param param = {
+		.gro_types = tc->gro_type,
+		.max_flow_num = NB_FLOWS,
+		.max_item_per_flow = PKTS_PER_FLOW,
+		.socket_id = SOCKET_ID_ANY,
+	};
+	struct rte_mbuf *pkts[BURST_SIZE];
+	uint64_t burst_cycles = 0, ctx_cycles = 0, start;
+	uint16_t nb_pkts;
+	uint32_t i, n;
+	void *ctx;
+	int ret = TEST_FAILED;
+
+	for (i = 0; i < BURST_SIZE; i++) {
+		tmpl[i] = tc->build(i % NB_FLOWS, i / NB_FLOWS);
+		if (tmpl[i] == NULL) {
+			free_pkts(tmpl, i);
+			return TEST_FAILED;
+		}
+	}
+
+	ctx = rte_gro_ctx_create(&param);
+	if (ctx == NULL)
+		goto out;
+
+	for (n = 0; n < NB_ITERATIONS; n++) {
+		/* Lightweight mode */
+		if (copy_burst(pkts) < 0)
+			goto out;
+		start = rte_rdtsc_precise();
+		nb_pkts = rte_gro_reassemble_burst(pkts, BURST_SIZE, &param);
+		burst_cycles += rte_rdtsc_precise() - start;
+		if (n == 0 && check_merged(tc, pkts, nb_pkts) != TEST_SUCCESS) {
+			free_pkts(pkts, nb_pkts);
+			goto out;
+		}
+		free_pkts(pkts, nb_pkts);
+
+		/* Heavyweight mode */
+		if (copy_burst(pkts) < 0)
+			goto out;
+		start = rte_rdtsc_precise();
+		nb_pkts = rte_gro_reassemble(pkts, BURST_SIZE, ctx);
+		nb_pkts += rte_gro_timeout_flush(ctx, 0, tc->gro_type,
+				&pkts[nb_pkts], BURST_SIZE - nb_pkts);
+		ctx_cycles += rte_rdtsc_precise() - start;
+		if (n == 0 && check_merged(tc, pkts, nb_pkts) != TEST_SUCCESS) {
+			free_pkts(pkts, nb_pkts);
+			goto out;
+		}
+		free_pkts(pkts, nb_pkts);
+	}
+
+	printf("| %-20s | %-7u | %-8u | %-17.1f | %-17.1f |\n", tc->name,
+			BURST_SIZE, NB_FLOWS,
+			(double)burst_cycles / (NB_ITERATIONS * BURST_SIZE),
+			(double)ctx_cycles / (NB_ITERATIONS * BURST_SIZE));
+	ret = TEST_SUCCESS;
+out:
+	rte_gro_ctx_destroy(ctx);
+	free_pkts(tmpl, BURST_SIZE);
+	return ret;
+}
+
+/*
+ * Reassemble TCP/IPv4 packets of many concurrent flows in timeout mode,
+ * to check the per packet cost doesn't depend on the number of flows.
+ */
+static int
+gro_perf_ctx_run(uint16_t nb_flows)
+{
+	struct rte_gro_param param = {
+		.gro_types = RTE_GRO_TCP_IPV4,
+		.max_flow_num = nb_flows,
+		.max_item_per_flow = 1,
+		.socket_id = SOCKET_ID_ANY,
+	};
+	uint32_t nb_pkts = CTX_PKTS_PER_FLOW * nb_flows;
+	uint64_t cycles = 0, start;
+	uint32_t i, n;
+	uint16_t nb_out;
+	void *ctx;
+	int ret = TEST_FAILED;
+
+	ctx = rte_gro_ctx_create(&param);
+	if (ctx == NULL)
+		return TEST_FAILED;
+
+	for (n = 0; n < NB_CTX_ITERATIONS; n++) {
+		for (i = 0; i < nb_pkts; i++) {
+			ctx_pkts[i] = build_tcp4(i % nb_flows, i / nb_flows);
+			if (ctx_pkts[i] == NULL) {
+				free_pkts(ctx_pkts, i);
+				goto out;
+			}
+		}
+
+		start = rte_rdtsc_precise();
+		for (i = 0; i < nb_pkts; i += BURST_SIZE)
+			if (rte_gro_reassemble(&ctx_pkts[i], BURST_SIZE, ctx)
+					!= 0) {
+				printf("TCP/IPv4 packets not stored\n");
+				goto out;
+			}
+		cycles += rte_rdtsc_precise() - start;
+
+		nb_out = rte_gro_timeout_flush(ctx, 0, RTE_GRO_TCP_IPV4,
+				ctx_pkts, nb_flows);
+		free_pkts(ctx_pkts, nb_out);
+		if (nb_out != nb_flows) {
+			printf("%u packets flushed, expected %u\n", nb_out,
+					nb_flows);
+			goto out;
+		}
+	}
+
+	printf("| %-8u | %-17.1f |\n", nb_flows,
+			(double)cycles / (NB_CTX_ITERATIONS * nb_pkts));
+	ret = TEST_SUCCESS;
+out:
+	/* drop the packets stored on failure */
+	nb_out = rte_gro_timeout_flush(ctx, 0, RTE_GRO_TCP_IPV4,
+			ctx_pkts, nb_flows);
+	free_pkts(ctx_pkts, nb_out);
+	rte_gro_ctx_destroy(ctx);
+	return ret;
+}
+
+static int
+test_gro_perf(void)
+{
+	uint32_t i;
+	int ret = TEST_SUCCESS;
+
+	pkt_pool = rte_pktmbuf_pool_create("gro_perf_pool", NB_MBUFS, 0, 0,
+			RTE_MBUF_DEFAULT_BUF_SIZE, SOCKET_ID_ANY);
+	if (pkt_pool == NULL) {
+		printf("[%s] Failed to create pkt pool\n", __func__);
+		return TEST_FAILED;
+	}
+
+	printf("Cycles per input packet, merging %u packets per flow\n",
+			PKTS_PER_FLOW);
+	printf("| %-20s | %-7s | %-8s | %-17s | %-17s |\n", "GRO type",
+			"Pkts in", "Pkts out", "Burst mode cycles",
+			"Ctx mode cycles");
+	for (i = 0; i < RTE_DIM(perf_cases); i++) {
+		ret = gro_perf_run(&perf_cases[i]);
+		if (ret != TEST_SUCCESS)
+			goto out;
+	}
+
+	printf("\nTCP/IPv4 timeout mode cycles per input packet\n");
+	printf("| %-8s | %-17s |\n", "Flows", "Ctx mode cycles");
+	for (i = 0; i < RTE_DIM(ctx_flow_nums); i++) {
+		ret = gro_perf_ctx_run(ctx_flow_nums[i]);
+		if (ret != TEST_SUCCESS)
+			break;
+	}
+out:
+
+	rte_mempool_free(pkt_pool);
+	return ret;
+}
+
+REGISTER_PERF_TEST(gro_perf_autotest, test_gro_perf);
@@ -0,0 +1,618 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "test.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include <rte_ethdev.h>
+#include <rte_ether.h>
+#include <rte_gre.h>
+#include <rte_gso.h>
+#include <rte_ip.h>
+#include <rte_mbuf.h>
+#include <rte_tcp.h>
+#include <rte_udp.h>
+#include <rte_vxlan.h>
+
+#define NUM_MBUFS 256
+#define BURST 32
+#define SEGS_MAX 64
+
+#define PAYLOAD_LEN 3000	/* more than one input mbuf */
+#define GSO_SIZE 1400
+#define TCP_SEQ 0x12345678
+#define OUTER_IP_ID 0x100
+
+static struct rte_mempool *pkt_pool, *direct_pool, *indirect_pool;
+
+static int
+testsuite_setup(void)
+{
+	pkt_pool = rte_pktmbuf_pool_create("GSO_MBUF_POOL", NUM_MBUFS, BURST,
+		0, RTE_MBUF_DEFAULT_BUF_SIZE, SOCKET_ID_ANY);
+	direct_pool = rte_pktmbuf_pool_create("GSO_D_MBUF_POOL", NUM_MBUFS,
+		BURST, 0, RTE_MBUF_DEFAULT_BUF_SIZE, SOCKET_ID_ANY);
+	indirect_pool = rte_pktmbuf_pool_create("GSO_I_MBUF_POOL", NUM_MBUFS,
+		BURST, 0, 0, SOCKET_ID_ANY);
+	if (pkt_pool == NULL || direct_pool == NULL || indirect_pool == NULL) {
+		printf("%s: Error creating mempools\n", __func__);
+		return TEST_FAILED;
+	}
+	return TEST_SUCCESS;
+}
+
+static void
+testsuite_teardown(void)
+{
+	rte_mempool_free(pkt_pool);
+	rte_mempool_free(direct_pool);
+	rte_mempool_free(indirect_pool);
+	pkt_pool = NULL;
+	direct_pool = NULL;
+	indirect_pool = NULL;
+}
+
+/* Byte k of the data following the headers of the input packet */
+static inline uint8_t
+pattern(uint32_t k)
+{
+	return (k ^ (k >> 8)) & 0xff;
+}
+
+/*
+ * Build a packet whose first hdr_len bytes are hdr, followed by len bytes
+ * of pattern(), chained over as many mbufs as needed.
+ */
+static struct rte_mbuf *
+build_pkt(const uint8_t *hdr, uint16_t hdr_len, uint16_t len)
+{
+	struct rte_mbuf *pkt, *m;
+	uint16_t n, k = 0;
+	uint8_t *p;
+
+	pkt = rte_pktmbuf_alloc(pkt_pool);
+	if (pkt == NULL)
+		return NULL;
+	p = (uint8_t *)rte_pktmbuf_append(pkt, hdr_len);
+	if (p == NULL)
+		goto fail;
+	memcpy(p, hdr, hdr_len);
+
+	m = pkt;
+	while (k != len) {
+		n = RTE_MIN(rte_pktmbuf_tailroom(m), len - k);
+		if (n == 0) {
+			m = rte_pktmbuf_alloc(pkt_pool);
+			if (m == NULL || rte_pktmbuf_chain(pkt, m) != 0) {
+				rte_pktmbuf_free(m);
+				goto fail;
+			}
+			continue;
+		}
+		p = (uint8_t *)rte_pktmbuf_append(m, n);
+		/* append on a chained mbuf does not update the head */
+		if (m != pkt)
+			pkt->pkt_len += n;
+		for (; n != 0; n--, k++)
+			*p++ = pattern(k);
+	}
+	return pkt;
+
+fail:
+	rte_pktmbuf_free(pkt);
+	return NULL;
+}
+
+/* Check that seg carries len bytes of pattern() from k, at offset off */
+static int
+check_data(const struct rte_mbuf *seg, uint32_t off, uint32_t k, uint32_t len)
+{
+	uint8_t buf[GSO_SIZE];
+	const uint8_t *p;
+	uint32_t i;
+
+	p = rte_pktmbuf_read(seg, off, len, buf);
+	RTE_TEST_ASSERT_NOT_NULL(p, "Cannot read %u bytes at %u", len, off);
+	for (i = 0; i != len; i++)
+		RTE_TEST_ASSERT_EQUAL(p[i], (pattern(k + i)),
+			"Wrong data byte %u of segment, input byte %u",
+			off + i, k + i);
+	return TEST_SUCCESS;
+}
+
+/* Free the segments, then check that every mbuf went back to its pool */
+static int
+free_segs(struct rte_mbuf **segs, int nb, int ret)
+{
+	int i;
+
+	for (i = 0; i < nb; i++)
+		rte_pktmbuf_free(segs[i]);
+	if (ret != TEST_SUCCESS)
+		return ret;
+	RTE_TEST_ASSERT_EQUAL(rte_mempool_in_use_count(pkt_pool), 0,
+		"Input mbufs leaked");
+	RTE_TEST_ASSERT_EQUAL(rte_mempool_in_use_count(direct_pool), 0,
+		"Header mbufs leaked");
+	RTE_TEST_ASSERT_EQUAL(rte_mempool_in_use_count(indirect_pool), 0,
+		"Indirect mbufs leaked");
+	return TEST_SUCCESS;
+}
+
+static void
+fill_ipv6(struct rte_ipv6_hdr *ip6, uint8_t proto, uint16_t payload_len)
+{
+	static const uint8_t src[16] = {0x20, 0x01, 0x0d, 0xb8, [15] = 1};
+	static const uint8_t dst[16] = {0x20, 0x01, 0x0d, 0xb8, [15] = 2};
+
+	ip6->vtc_flow = rte_cpu_to_be_32(6 << 28);
+	ip6->payload_len = rte_cpu_to_be_16(payload_len);
+	ip6->proto = proto;
+	ip6->hop_limits = 64;
+	memcpy(ip6->src_addr, src, sizeof(src));
+	memcpy(ip6->dst_addr, dst, sizeof(dst));
+}
+
+static void
+fill_tcp(struct rte_tcp_hdr *tcp)
+{
+	memset(tcp, 0, sizeof(*tcp));
+	tcp->src_port = rte_cpu_to_be_16(5000);
+	tcp->dst_port = rte_cpu_to_be_16(80);
+	tcp->sent_seq = rte_cpu_to_be_32(TCP_SEQ);
+	tcp->data_off = (sizeof(*tcp) / 4) << 4;
+	tcp->tcp_flags = RTE_TCP_ACK_FLAG | RTE_TCP_PSH_FLAG | RTE_TCP_FIN_FLAG;
+}
+
+/*
+ * Check the TCP header at l4 of every segment: the sequence numbers
+ * follow the data, only the last segment keeps PSH and FIN, and the
+ * data matches the input from the first byte after the headers.
+ */
+static int
+check_tcp_segs(struct rte_mbuf **segs, int nb, uint16_t hdr_len, uint16_t l4)
+{
+	const struct rte_tcp_hdr *tcp;
+	uint32_t data = 0, len;
+	uint8_t fin_psh;
+	int i;
+
+	for (i = 0; i < nb; i++) {
+		tcp = rte_pktmbuf_mtod_offset(segs[i], struct rte_tcp_hdr *,
+			l4);
+		RTE_TEST_ASSERT_EQUAL(rte_be_to_cpu_32(tcp->sent_seq),
+			(TCP_SEQ + data), "Wrong seq in segment %d", i);
+		fin_psh = tcp->tcp_flags &
+			(RTE_TCP_PSH_FLAG | RTE_TCP_FIN_FLAG);
+		RTE_TEST_ASSERT_EQUAL(fin_psh, (i == nb - 1 ?
+			(RTE_TCP_PSH_FLAG | RTE_TCP_FIN_FLAG) : 0),
+			"Wrong PSH/FIN in segment %d", i);
+		RTE_TEST_ASSERT(tcp->tcp_flags & RTE_TCP_ACK_FLAG,
+			"ACK lost in segment %d", i);
+
+		len = segs[i]->pkt_len - hdr_len;
+		if (check_data(segs[i], hdr_len, data, len) != TEST_SUCCESS)
+			return TEST_FAILED;
+		data += len;
+	}
+	RTE_TEST_ASSERT_EQUAL(data, PAYLOAD_LEN, "Segments carry %u bytes",
+		data);
+	return TEST_SUCCESS;
+}
+
+/* Common checks of the segments of any packet */
+static int
+check_segs(struct rte_mbuf **segs, int nb, uint64_t ol_flags, uint16_t l3,
+	uint16_t gso_size)
+{
+	const struct rte_ipv6_hdr *ip6;
+	int i;
+
+	RTE_TEST_ASSERT(nb > 1, "Packet not segmented: %d", nb);
+	for (i = 0; i < nb; i++) {
+		RTE_TEST_ASSERT(segs[i]->pkt_len <= gso_size,
+			"Segment %d is %u bytes", i, segs[i]->pkt_len);
+		/* checksum requests are kept, segmentation ones dropped */
+		RTE_TEST_ASSERT_EQUAL(segs[i]->ol_flags, (ol_flags &
+			~(RTE_MBUF_F_TX_TCP_SEG | RTE_MBUF_F_TX_UDP_SEG)),
+			"Wrong ol_flags 0x%" PRIx64 " in segment %d",
+			segs[i]->ol_flags, i);
+		ip6 = rte_pktmbuf_mtod_offset(segs[i], struct rte_ipv6_hdr *,
+			l3);
+		RTE_TEST_ASSERT_EQUAL(rte_be_to_cpu_16(ip6->payload_len),
+			(segs[i]->pkt_len - l3 - sizeof(*ip6)),
+			"Wrong IPv6 payload_len in segment %d", i);
+	}
+	return TEST_SUCCESS;
+}
+
+static int
+test_gso_tcp6(void)
+{
+	struct {
+		struct rte_ether_hdr eth;
+		struct rte_ipv6_hdr ip6;
+		struct rte_tcp_hdr tcp;
+	} __rte_packed hdr;
+	struct rte_gso_ctx ctx = {
+		.direct_pool = direct_pool,
+		.indirect_pool = indirect_pool,
+		.gso_types = RTE_ETH_TX_OFFLOAD_TCP_TSO,
+		.gso_size = GSO_SIZE,
+	};
+	struct rte_mbuf *pkt, *segs[SEGS_MAX];
+	uint64_t ol_flags;
+	int nb, ret;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.eth.ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+	fill_ipv6(&hdr.ip6, IPPROTO_TCP, sizeof(hdr.tcp) + PAYLOAD_LEN);
+	fill_tcp(&hdr.tcp);
+
+	pkt = build_pkt((const uint8_t *)&hdr, sizeof(hdr), PAYLOAD_LEN);
+	RTE_TEST_ASSERT_NOT_NULL(pkt, "Cannot build packet");
+	ol_flags = RTE_MBUF_F_TX_TCP_SEG | RTE_MBUF_F_TX_IPV6 |
+		RTE_MBUF_F_TX_TCP_CKSUM;
+	pkt->ol_flags = ol_flags;
+	pkt->l2_len = sizeof(hdr.eth);
+	pkt->l3_len = sizeof(hdr.ip6);
+	pkt->l4_len = sizeof(hdr.tcp);
+
+	nb = rte_gso_segment(pkt, &ctx, segs, RTE_DIM(segs));
+	rte_pktmbuf_free(pkt);
+	RTE_TEST_ASSERT_EQUAL(nb, 3, "TCP/IPv6 packet in %d segments", nb);
+
+	ret = check_segs(segs, nb, ol_flags, sizeof(hdr.eth), GSO_SIZE);
+	if (ret == TEST_SUCCESS)
+		ret = check_tcp_segs(segs, nb, sizeof(hdr),
+			offsetof(typeof(hdr), tcp));
+	return free_segs(segs, nb, ret);
+}
+
+/*
+ * UDP/IPv6 packets become IPv6 fragments: check the fragment header of
+ * each segment, with or without an extension header before it.
+ */
+static int
+test_gso_udp6_ext(bool hop_by_hop)
+{
+	uint8_t hdr[128];
+	struct rte_gso_ctx ctx = {
+		.direct_pool = direct_pool,
+		.indirect_pool = indirect_pool,
+		.gso_types = RTE_ETH_TX_OFFLOAD_UDP_TSO,
+		.gso_size = GSO_SIZE,
+	};
+	const struct rte_ipv6_fragment_ext *frag;
+	const struct rte_udp_hdr *udp;
+	struct rte_udp_hdr udp_copy;
+	struct rte_ether_hdr *eth;
+	struct rte_udp_hdr *u;
+	struct rte_mbuf *pkt, *segs[SEGS_MAX];
+	uint16_t l3, l3_len, hdr_len, nh_off, frag_data;
+	uint32_t data = 0, frag_len, skip;
+	uint64_t ol_flags;
+	rte_be32_t id = 0;
+	uint8_t nh;
+	int i, nb, ret;
+
+	/* the UDP header is fragmented along with the data */
+	l3 = sizeof(struct rte_ether_hdr);
+	l3_len = sizeof(struct rte_ipv6_hdr) + (hop_by_hop ? 8 : 0);
+	hdr_len = l3 + l3_len;
+	nh_off = hop_by_hop ? l3 + sizeof(struct rte_ipv6_hdr) :
+		l3 + offsetof(struct rte_ipv6_hdr, proto);
+
+	memset(hdr, 0, sizeof(hdr));
+	eth = (struct rte_ether_hdr *)hdr;
+	eth->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+	fill_ipv6((struct rte_ipv6_hdr *)(hdr + l3),
+		hop_by_hop ? IPPROTO_HOPOPTS : IPPROTO_UDP,
+		l3_len - sizeof(struct rte_ipv6_hdr) +
+		sizeof(struct rte_udp_hdr) + PAYLOAD_LEN);
+	if (hop_by_hop) {
+		/* next header, length 0, a PadN option filling the rest */
+		hdr[nh_off] = IPPROTO_UDP;
+		hdr[nh_off + 2] = 1;
+		hdr[nh_off + 3] = 4;
+	}
+	u = (struct rte_udp_hdr *)(hdr + hdr_len);
+	u->src_port = rte_cpu_to_be_16(5000);
+	u->dst_port = rte_cpu_to_be_16(5001);
+	u->dgram_len = rte_cpu_to_be_16(sizeof(*u) + PAYLOAD_LEN);
+
+	pkt = build_pkt(hdr, hdr_len + sizeof(*u), PAYLOAD_LEN);
+	RTE_TEST_ASSERT_NOT_NULL(pkt, "Cannot build packet");
+	ol_flags = RTE_MBUF_F_TX_UDP_SEG | RTE_MBUF_F_TX_IPV6;
+	pkt->ol_flags = ol_flags;
+	pkt->l2_len = l3;
+	pkt->l3_len = l3_len;
+	pkt->l4_len = sizeof(*u);
+
+	nb = rte_gso_segment(pkt, &ctx, segs, RTE_DIM(segs));
+	rte_pktmbuf_free(pkt);
+	RTE_TEST_ASSERT_EQUAL(nb, 3, "UDP/IPv6 packet in %d segments", nb);
+
+	ret = check_segs(segs, nb, ol_flags, l3, GSO_SIZE);
+	for (i = 0; ret == TEST_SUCCESS && i < nb; i++) {
+		nh = *rte_pktmbuf_mtod_offset(segs[i], uint8_t *, nh_off);
+		frag = rte_pktmbuf_mtod_offset(segs[i],
+			struct rte_ipv6_fragment_ext *, hdr_len);
+		frag_data = rte_be_to_cpu_16(frag->frag_data);
+		frag_len = segs[i]->pkt_len - hdr_len - RTE_IPV6_FRAG_HDR_SIZE;
+
+		if (nh != IPPROTO_FRAGMENT || frag->next_header != IPPROTO_UDP) {
+			printf("Segment %d: next headers %u, %u\n", i, nh,
+				frag->next_header);
+			ret = TEST_FAILED;
+		} else if (segs[i]->l3_len != l3_len + RTE_IPV6_FRAG_HDR_SIZE) {
+			printf("Segment %d: l3_len %u\n", i, segs[i]->l3_len);
+			ret = TEST_FAILED;
+		} else if ((uint32_t)(RTE_IPV6_GET_FO(frag_data) <<
+				RTE_IPV6_EHDR_FO_SHIFT) != data) {
+			printf("Segment %d: fragment offset %u, expected %u\n",
+				i, RTE_IPV6_GET_FO(frag_data) <<
+				RTE_IPV6_EHDR_FO_SHIFT, data);
+			ret = TEST_FAILED;
+		} else if (RTE_IPV6_GET_MF(frag_data) != (i < nb - 1)) {
+			printf("Segment %d: M flag %u\n", i,
+				RTE_IPV6_GET_MF(frag_data));
+			ret = TEST_FAILED;
+		} else if (i < nb - 1 && frag_len % RTE_IPV6_EHDR_FO_ALIGN) {
+			printf("Segment %d: %u bytes, not a multiple of 8\n",
+				i, frag_len);
+			ret = TEST_FAILED;
+		} else if (i > 0 && frag->id != id) {
+			printf("Segment %d: fragment id changed\n", i);
+			ret = TEST_FAILED;
+		}
+		if (ret != TEST_SUCCESS)
+			break;
+		id = frag->id;
+
+		/* the first fragment starts with the unchanged UDP header */
+		skip = 0;
+		if (i == 0) {
+			udp = rte_pktmbuf_read(segs[i],
+				hdr_len + RTE_IPV6_FRAG_HDR_SIZE,
+				sizeof(udp_copy), &udp_copy);
+			if (udp == NULL || udp->dgram_len != u->dgram_len) {
+				printf("UDP header changed\n");
+				ret = TEST_FAILED;
+				break;
+			}
+			skip = sizeof(*u);
+		}
+		ret = check_data(segs[i],
+			hdr_len + RTE_IPV6_FRAG_HDR_SIZE + skip,
+			data + skip - sizeof(*u), frag_len - skip);
+		data += frag_len;
+	}
+	if (ret == TEST_SUCCESS && data != sizeof(*u) + PAYLOAD_LEN) {
+		printf("Fragments carry %u bytes\n", data);
+		ret = TEST_FAILED;
+	}
+	return free_segs(segs, nb, ret);
+}
+
+static int
+test_gso_udp6(void)
+{
+	int ret;
+
+	ret = test_gso_udp6_ext(false);
+	if (ret == TEST_SUCCESS)
+		ret = test_gso_udp6_ext(true);
+	return ret;
+}
+
+/* TCP/IPv6 in VXLAN or GRE, over IPv4 or IPv6 */
+static int
+test_gso_tunnel_tcp6_one(bool outer_ipv6, bool vxlan)
+{
+	uint8_t hdr[256];
+	struct rte_gso_ctx ctx = {
+		.direct_pool = direct_pool,
+		.indirect_pool = indirect_pool,
+		.gso_types = vxlan ? RTE_ETH_TX_OFFLOAD_VXLAN_TNL_TSO :
+			RTE_ETH_TX_OFFLOAD_GRE_TNL_TSO,
+		.gso_size = GSO_SIZE,
+	};
+	const struct rte_ipv4_hdr *ip4;
+	const struct rte_udp_hdr *udp;
+	struct rte_ether_hdr *eth;
+	struct rte_ipv4_hdr *outer4;
+	struct rte_mbuf *pkt, *segs[SEGS_MAX];
+	uint16_t outer_l3, outer_l3_len, l4, tnl_len, len, inner_l3, hdr_len;
+	uint64_t ol_flags;
+	int i, nb, ret;
+
+	memset(hdr, 0, sizeof(hdr));
+	outer_l3 = sizeof(struct rte_ether_hdr);
+	outer_l3_len = outer_ipv6 ? sizeof(struct rte_ipv6_hdr) :
+		sizeof(struct rte_ipv4_hdr);
+	l4 = outer_l3 + outer_l3_len;
+	tnl_len = vxlan ? sizeof(struct rte_udp_hdr) +
+		sizeof(struct rte_vxlan_hdr) : sizeof(struct rte_gre_hdr);
+	inner_l3 = l4 + tnl_len + sizeof(struct rte_ether_hdr);
+	hdr_len = inner_l3 + sizeof(struct rte_ipv6_hdr) +
+		sizeof(struct rte_tcp_hdr);
+	len = hdr_len + PAYLOAD_LEN;
+
+	eth = (struct rte_ether_hdr *)hdr;
+	eth->ether_type = rte_cpu_to_be_16(outer_ipv6 ? RTE_ETHER_TYPE_IPV6 :
+		RTE_ETHER_TYPE_IPV4);
+	if (outer_ipv6) {
+		fill_ipv6((struct rte_ipv6_hdr *)(hdr + outer_l3),
+			vxlan ? IPPROTO_UDP : IPPROTO_GRE,
+			len - l4);
+	} else {
+		outer4 = (struct rte_ipv4_hdr *)(hdr + outer_l3);
+		outer4->version_ihl = RTE_IPV4_VHL_DEF;
+		outer4->total_length = rte_cpu_to_be_16(len - outer_l3);
+		outer4->packet_id = rte_cpu_to_be_16(OUTER_IP_ID);
+		outer4->time_to_live = 64;
+		outer4->next_proto_id = vxlan ? IPPROTO_UDP : IPPROTO_GRE;
+	}
+	if (vxlan) {
+		struct rte_udp_hdr *u = (struct rte_udp_hdr *)(hdr + l4);
+		struct rte_vxlan_hdr *vx = (struct rte_vxlan_hdr *)(u + 1);
+
+		u->dst_port = rte_cpu_to_be_16(RTE_VXLAN_DEFAULT_PORT);
+		u->dgram_len = rte_cpu_to_be_16(len - l4);
+		vx->vx_flags = rte_cpu_to_be_32(0x08000000);
+	} else {
+		struct rte_gre_hdr *gre = (struct rte_gre_hdr *)(hdr + l4);
+
+		gre->proto = rte_cpu_to_be_16(RTE_ETHER_TYPE_TEB);
+	}
+	eth = (struct rte_ether_hdr *)(hdr + inner_l3) - 1;
+	eth->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+	fill_ipv6((struct rte_ipv6_hdr *)(hdr + inner_l3), IPPROTO_TCP,
+		sizeof(struct rte_tcp_hdr) + PAYLOAD_LEN);
+	fill_tcp((struct rte_tcp_hdr *)(hdr + inner_l3 +
+		sizeof(struct rte_ipv6_hdr)));
+
+	pkt = build_pkt(hdr, hdr_len, PAYLOAD_LEN);
+	RTE_TEST_ASSERT_NOT_NULL(pkt, "Cannot build packet");
+	ol_flags = RTE_MBUF_F_TX_TCP_SEG | RTE_MBUF_F_TX_IPV6 |
+		RTE_MBUF_F_TX_TCP_CKSUM |
+		(vxlan ? RTE_MBUF_F_TX_TUNNEL_VXLAN : RTE_MBUF_F_TX_TUNNEL_GRE) |
+		(outer_ipv6 ? RTE_MBUF_F_TX_OUTER_IPV6 :
+			RTE_MBUF_F_TX_OUTER_IPV4 | RTE_MBUF_F_TX_OUTER_IP_CKSUM);
+	pkt->ol_flags = ol_flags;
+	pkt->outer_l2_len = outer_l3;
+	pkt->outer_l3_len = outer_l3_len;
+	pkt->l2_len = inner_l3 - l4;
+	pkt->l3_len = sizeof(struct rte_ipv6_hdr);
+	pkt->l4_len = sizeof(struct rte_tcp_hdr);
+
+	nb = rte_gso_segment(pkt, &ctx, segs, RTE_DIM(segs));
+	rte_pktmbuf_free(pkt);
+	RTE_TEST_ASSERT_EQUAL(nb, 3, "Tunnel packet in %d segments", nb);
+
+	/* inner IPv6 and TCP */
+	ret = check_segs(segs, nb, ol_flags, inner_l3, GSO_SIZE);
+	if (ret == TEST_SUCCESS)
+		ret = check_tcp_segs(segs, nb, hdr_len,
+			inner_l3 + sizeof(struct rte_ipv6_hdr));
+
+	/* outer headers */
+	for (i = 0; ret == TEST_SUCCESS && i < nb; i++) {
+		if (outer_ipv6) {
+			const struct rte_ipv6_hdr *ip6 =
+				rte_pktmbuf_mtod_offset(segs[i],
+					struct rte_ipv6_hdr *, outer_l3);
+
+			if (rte_be_to_cpu_16(ip6->payload_len) !=
+					segs[i]->pkt_len - l4) {
+				printf("Segment %d: outer payload_len %u\n",
+					i, rte_be_to_cpu_16(ip6->payload_len));
+				ret = TEST_FAILED;
+			}
+		} else {
+			ip4 = rte_pktmbuf_mtod_offset(segs[i],
+				struct rte_ipv4_hdr *, outer_l3);
+			if (rte_be_to_cpu_16(ip4->total_length) !=
+					segs[i]->pkt_len - outer_l3 ||
+					rte_be_to_cpu_16(ip4->packet_id) !=
+					OUTER_IP_ID + i) {
+				printf("Segment %d: outer length %u, id %u\n",
+					i, rte_be_to_cpu_16(ip4->total_length),
+					rte_be_to_cpu_16(ip4->packet_id));
+				ret = TEST_FAILED;
+			}
+		}
+		if (ret == TEST_SUCCESS && vxlan) {
+			udp = rte_pktmbuf_mtod_offset(segs[i],
+				struct rte_udp_hdr *, l4);
+			if (rte_be_to_cpu_16(udp->dgram_len) !=
+					segs[i]->pkt_len - l4) {
+				printf("Segment %d: outer dgram_len %u\n",
+					i, rte_be_to_cpu_16(udp->dgram_len));
+				ret = TEST_FAILED;
+			}
+		}
+	}
+	if (ret != TEST_SUCCESS)
+		printf("Failed with %s over IPv%d\n", vxlan ? "VXLAN" : "GRE",
+			outer_ipv6 ? 6 : 4);
+	return free_segs(segs, nb, ret);
+}
+
+static int
+test_gso_tunnel_tcp6(void)
+{
+	int ret;
+
+	ret = test_gso_tunnel_tcp6_one(false, true);
+	if (ret == TEST_SUCCESS)
+		ret = test_gso_tunnel_tcp6_one(true, true);
+	if (ret == TEST_SUCCESS)
+		ret = test_gso_tunnel_tcp6_one(true, false);
+	return ret;
+}
+
+/* Headers alone must fit in gso_size with room for data */
+static int
+test_gso_ipv6_too_small(void)
+{
+	struct {
+		struct rte_ether_hdr eth;
+		struct rte_ipv6_hdr ip6;
+		struct rte_tcp_hdr tcp;
+	} __rte_packed hdr;
+	struct rte_gso_ctx ctx = {
+		.direct_pool = direct_pool,
+		.indirect_pool = indirect_pool,
+		.gso_types = RTE_ETH_TX_OFFLOAD_TCP_TSO,
+		.gso_size = sizeof(hdr),
+	};
+	struct rte_mbuf *pkt, *segs[SEGS_MAX];
+	uint64_t ol_flags;
+	int nb;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.eth.ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+	fill_ipv6(&hdr.ip6, IPPROTO_TCP, sizeof(hdr.tcp) + PAYLOAD_LEN);
+	fill_tcp(&hdr.tcp);
+
+	pkt = build_pkt((const uint8_t *)&hdr, sizeof(hdr), PAYLOAD_LEN);
+	RTE_TEST_ASSERT_NOT_NULL(pkt, "Cannot build packet");
+	ol_flags = RTE_MBUF_F_TX_TCP_SEG | RTE_MBUF_F_TX_IPV6;
+	pkt->ol_flags = ol_flags;
+	pkt->l2_len = sizeof(hdr.eth);
+	pkt->l3_len = sizeof(hdr.ip6);
+	pkt->l4_len = sizeof(hdr.tcp);
+
+	nb = rte_gso_segment(pkt, &ctx, segs, RTE_DIM(segs));
+	RTE_TEST_ASSERT_EQUAL(nb, -EINVAL, "Segmented in %d", nb);
+	RTE_TEST_ASSERT_EQUAL(pkt->ol_flags, ol_flags,
+		"ol_flags not restored after a failure");
+	rte_pktmbuf_free(pkt);
+	return free_segs(segs, 0, TEST_SUCCESS);
+}
+
+static struct unit_test_suite gso_testsuite  = {
+	.suite_name = "GSO Unit Test Suite",
+	.setup = testsuite_setup,
+	.teardown = testsuite_teardown,
+	.unit_test_cases = {
+		TEST_CASE(test_gso_tcp6),
+		TEST_CASE(test_gso_udp6),
+		TEST_CASE(test_gso_tunnel_tcp6),
+		TEST_CASE(test_gso_ipv6_too_small),
+
+		TEST_CASES_END() /**< NULL terminate unit test array */
+	}
+};
+
+static int
+test_gso(void)
+{
+	return unit_test_suite_runner(&gso_testsuite);
+}
+
+REGISTER_FAST_TEST(gso_autotest, true, true, test_gso);
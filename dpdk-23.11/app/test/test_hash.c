@@ -2183,6 +2183,414 @@ test_hash_rcu_qsbr_sync_mode(uint8_t ext_bkt)
 
 }
 
+#define RESIZE_MIN_ENTRIES	64
+#define RESIZE_NUM_KEYS		4096
+
+/* Check that keys [first, last) are found with their data, in bursts */
+static int
+resize_check_keys(const struct rte_hash *handle, uint32_t *keys,
+		  uint32_t first, uint32_t last)
+{
+	const void *key_ptrs[RTE_HASH_LOOKUP_BULK_MAX];
+	void *data[RTE_HASH_LOOKUP_BULK_MAX];
+	uint64_t hit_mask;
+	uint32_t i, j, n;
+	int ret;
+
+	for (i = first; i < last; i += n) {
+		n = RTE_MIN(last - i, (uint32_t)RTE_HASH_LOOKUP_BULK_MAX);
+		for (j = 0; j < n; j++)
+			key_ptrs[j] = &keys[i + j];
+		ret = rte_hash_lookup_bulk_data(handle, key_ptrs, n,
+						&hit_mask, data);
+		if (ret != (int)n) {
+			printf("%d of %u keys from %u found\n", ret, n, i);
+			return -1;
+		}
+		for (j = 0; j < n; j++) {
+			if ((uintptr_t)data[j] != keys[i + j]) {
+				printf("key %u has wrong data\n", keys[i + j]);
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+/*
+ * Resizable table:
+ *  - Add many more keys than the initial size, the table must grow
+ *  - Delete most keys, the table must shrink
+ *  - Add the keys again and resize explicitly, looking all keys up
+ *    while they move between the tables
+ *  - Check keys and data after each step
+ */
+static int
+test_hash_resize(uint32_t extra_flag)
+{
+	struct rte_hash *handle = NULL;
+	struct rte_hash_rcu_config rcu_cfg = {0};
+	struct rte_rcu_qsbr *qsv = NULL;
+	struct rte_hash_parameters params = {
+		.name = "test_hash_resize",
+		.entries = RESIZE_MIN_ENTRIES,
+		.key_len = sizeof(uint32_t),
+		.hash_func = rte_jhash,
+		.socket_id = 0,
+		.extra_flag = RTE_HASH_EXTRA_FLAGS_RESIZABLE | extra_flag,
+	};
+	static uint32_t keys[RESIZE_NUM_KEYS];
+	uint32_t i, iter = 0, found = 0;
+	const void *next_key;
+	void *next_data;
+	int32_t ret, max_key_id;
+	size_t sz;
+
+	printf("\n# Running resizable table test, flags 0x%x\n", extra_flag);
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+	max_key_id = rte_hash_max_key_id(handle);
+
+	if (extra_flag & RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF) {
+		/* Lock free readers need RCU to release the old table */
+		RETURN_IF_ERROR(rte_hash_resize(handle, 128) != -ENOTSUP,
+				"resize without RCU should fail");
+		sz = rte_rcu_qsbr_get_memsize(RTE_MAX_LCORE);
+		qsv = rte_zmalloc(NULL, sz, RTE_CACHE_LINE_SIZE);
+		RETURN_IF_ERROR(qsv == NULL, "RCU QSBR allocation failed");
+		rte_rcu_qsbr_init(qsv, RTE_MAX_LCORE);
+		rcu_cfg.v = qsv;
+		rcu_cfg.mode = RTE_HASH_QSBR_MODE_DQ;
+		ret = rte_hash_rcu_qsbr_add(handle, &rcu_cfg);
+		if (ret != 0)
+			rte_free(qsv);
+		RETURN_IF_ERROR(ret != 0, "attach RCU QSBR failed");
+	}
+
+	for (i = 0; i < RESIZE_NUM_KEYS; i++) {
+		keys[i] = i * 2654435761u + 1;
+		ret = rte_hash_add_key_data(handle, &keys[i],
+					    (void *)(uintptr_t)keys[i]);
+		RETURN_IF_ERROR(ret != 0, "add key %u failed (%d)", i, ret);
+	}
+	RETURN_IF_ERROR(resize_check_keys(handle, keys, 0, RESIZE_NUM_KEYS),
+			"lookup after growing failed");
+	RETURN_IF_ERROR(rte_hash_count(handle) != RESIZE_NUM_KEYS,
+			"wrong count %d", rte_hash_count(handle));
+
+	for (i = RESIZE_MIN_ENTRIES / 4; i < RESIZE_NUM_KEYS; i++) {
+		ret = rte_hash_del_key(handle, &keys[i]);
+		RETURN_IF_ERROR(ret < 0, "delete key %u failed (%d)", i, ret);
+	}
+	while (rte_hash_resize_step(handle, UINT32_MAX) > 0)
+		;
+	/* Automatic shrinking keeps some headroom, finish explicitly */
+	RETURN_IF_ERROR(rte_hash_max_key_id(handle) - max_key_id >
+			3 * RESIZE_MIN_ENTRIES, "table did not shrink");
+	ret = rte_hash_resize(handle, RESIZE_MIN_ENTRIES);
+	RETURN_IF_ERROR(ret != 0, "resize failed (%d)", ret);
+	while (rte_hash_resize_step(handle, UINT32_MAX) > 0)
+		;
+	RETURN_IF_ERROR(rte_hash_max_key_id(handle) != max_key_id,
+			"table did not shrink (max key id %d)",
+			rte_hash_max_key_id(handle));
+	RETURN_IF_ERROR(rte_hash_count(handle) != RESIZE_MIN_ENTRIES / 4,
+			"wrong count %d", rte_hash_count(handle));
+	RETURN_IF_ERROR(resize_check_keys(handle, keys, 0,
+			RESIZE_MIN_ENTRIES / 4), "lookup after shrinking failed");
+	for (i = RESIZE_MIN_ENTRIES / 4; i < RESIZE_NUM_KEYS; i++)
+		RETURN_IF_ERROR(rte_hash_lookup(handle, &keys[i]) != -ENOENT,
+				"deleted key %u found", i);
+
+	for (i = RESIZE_MIN_ENTRIES / 4; i < RESIZE_NUM_KEYS; i++) {
+		ret = rte_hash_add_key_data(handle, &keys[i],
+					    (void *)(uintptr_t)keys[i]);
+		RETURN_IF_ERROR(ret != 0, "add key %u failed (%d)", i, ret);
+	}
+	while (rte_hash_resize_step(handle, UINT32_MAX) > 0)
+		;
+	RETURN_IF_ERROR(rte_hash_resize(handle, RESIZE_NUM_KEYS / 2) != -ENOSPC,
+			"shrinking below the number of keys should fail");
+	ret = rte_hash_resize(handle, RESIZE_NUM_KEYS * 4);
+	RETURN_IF_ERROR(ret != 0, "resize failed (%d)", ret);
+	RETURN_IF_ERROR(rte_hash_resize(handle, RESIZE_NUM_KEYS * 4) != -EBUSY,
+			"second resize should wait for the first one");
+	do {
+		RETURN_IF_ERROR(resize_check_keys(handle, keys, 0,
+				RESIZE_NUM_KEYS), "lookup while resizing failed");
+		ret = rte_hash_resize_step(handle, 64);
+	} while (ret > 0);
+	RETURN_IF_ERROR(ret != 0, "resize step failed (%d)", ret);
+	RETURN_IF_ERROR(rte_hash_count(handle) != RESIZE_NUM_KEYS,
+			"wrong count %d", rte_hash_count(handle));
+
+	while (rte_hash_iterate(handle, &next_key, &next_data, &iter) >= 0) {
+		RETURN_IF_ERROR((uintptr_t)next_data != *(const uint32_t *)next_key,
+				"iterate returned wrong data");
+		found++;
+	}
+	RETURN_IF_ERROR(found != RESIZE_NUM_KEYS, "iterate found %u keys",
+			found);
+
+	rte_hash_free(handle);
+	rte_free(qsv);
+
+	/* Locked readers cannot run while writers move keys */
+	params.extra_flag = RTE_HASH_EXTRA_FLAGS_RESIZABLE |
+			    RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY;
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle != NULL, "creation should have failed");
+
+	return 0;
+}
+
+#define ADD_BULK_NUM_KEYS	RTE_HASH_LOOKUP_BULK_MAX
+#define ADD_BULK_NUM_UNIQUE	48
+
+/*
+ * Bulk add:
+ *  - Add a burst holding every key more than once, the last
+ *    occurrence of each key must win
+ *  - Check positions against single key lookups
+ *  - Fill a table whose keys all go to the same bucket,
+ *    the keys that do not fit must fail with -ENOSPC
+ */
+static int
+test_hash_add_bulk(void)
+{
+	struct rte_hash *handle;
+	struct rte_hash_parameters params = {
+		.entries = 64,
+		.key_len = sizeof(uint32_t),
+		.socket_id = 0,
+	};
+	/* Without locks, and with the writer lock held for the burst */
+	const uint32_t flags[] = {0, RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY |
+		RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD};
+	uint32_t keys[ADD_BULK_NUM_KEYS];
+	const void *key_ptrs[ADD_BULK_NUM_KEYS];
+	void *data[ADD_BULK_NUM_KEYS];
+	hash_sig_t sig[ADD_BULK_NUM_KEYS];
+	int32_t positions[ADD_BULK_NUM_KEYS];
+	void *found;
+	uint32_t i, f, last;
+	int ret, pos;
+
+	for (f = 0; f < RTE_DIM(flags); f++) {
+		params.name = "test_hash_add_bulk";
+		params.hash_func = rte_jhash;
+		params.hash_func_init_val = 0;
+		params.extra_flag = flags[f];
+		handle = rte_hash_create(&params);
+		RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+		for (i = 0; i < ADD_BULK_NUM_KEYS; i++) {
+			keys[i] = i % ADD_BULK_NUM_UNIQUE;
+			key_ptrs[i] = &keys[i];
+			data[i] = (void *)(uintptr_t)i;
+			sig[i] = rte_hash_hash(handle, &keys[i]);
+		}
+
+		ret = rte_hash_add_bulk(handle, key_ptrs, sig, data,
+					ADD_BULK_NUM_KEYS, positions);
+		RETURN_IF_ERROR(ret != ADD_BULK_NUM_KEYS,
+				"%d of %u keys added", ret, ADD_BULK_NUM_KEYS);
+		RETURN_IF_ERROR(rte_hash_count(handle) != ADD_BULK_NUM_UNIQUE,
+				"%d keys in the table", rte_hash_count(handle));
+
+		for (i = 0; i < ADD_BULK_NUM_KEYS; i++) {
+			pos = rte_hash_lookup_data(handle, &keys[i], &found);
+			RETURN_IF_ERROR(pos != positions[i],
+					"key %u at position %d, added at %d",
+					keys[i], pos, positions[i]);
+			/* The last occurrence of the key sets its data */
+			last = keys[i] + ADD_BULK_NUM_UNIQUE;
+			if (last >= ADD_BULK_NUM_KEYS)
+				last = keys[i];
+			RETURN_IF_ERROR((uintptr_t)found != last,
+					"key %u has wrong data", keys[i]);
+		}
+		rte_hash_free(handle);
+
+		/* Every key hashes to the same bucket */
+		params.name = "test_hash_add_bulk_full";
+		params.hash_func = pseudo_hash;
+		handle = rte_hash_create(&params);
+		RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+		for (i = 0; i < ADD_BULK_NUM_KEYS; i++)
+			keys[i] = i;
+		ret = rte_hash_add_bulk(handle, key_ptrs, NULL, NULL,
+					ADD_BULK_NUM_KEYS, positions);
+		RETURN_IF_ERROR(ret <= 0 || ret >= ADD_BULK_NUM_KEYS,
+				"%d keys added to one bucket", ret);
+		for (i = 0; i < ADD_BULK_NUM_KEYS; i++) {
+			pos = rte_hash_lookup(handle, &keys[i]);
+			/* Once the bucket is full, every other key fails */
+			if (i < (uint32_t)ret)
+				RETURN_IF_ERROR(pos != positions[i],
+						"key %u not found at its position", i);
+			else
+				RETURN_IF_ERROR(positions[i] != -ENOSPC ||
+						pos != -ENOENT,
+						"key %u should not have been added", i);
+		}
+		rte_hash_free(handle);
+	}
+
+	return 0;
+}
+
+#define AGING_NUM_KEYS		256
+#define AGING_TTL_MS		100
+
+/* Run rte_hash_age() over the whole table in small slices */
+static int
+aging_pass(struct rte_hash *handle, uint64_t ttl, uint32_t *keys_found)
+{
+	int32_t positions[8];
+	void *data[RTE_DIM(positions)];
+	uint32_t next = 0;
+	int ret, i, nb_expired = 0;
+
+	do {
+		ret = rte_hash_age(handle, ttl, &next, 16, positions, data,
+				   RTE_DIM(positions));
+		if (ret < 0)
+			return ret;
+		for (i = 0; i < ret; i++) {
+			if (positions[i] < 0)
+				return -1;
+			keys_found[nb_expired++] = (uintptr_t)data[i];
+		}
+	} while (next != 0);
+
+	return nb_expired;
+}
+
+/*
+ * Aging:
+ *  - Add keys and let them get old
+ *  - Look up every other key, with single and bulk lookups
+ *  - Age the table in slices, only the keys not looked up must expire
+ *  - Check the expired entries and the keys left in the table
+ *  - Add a key long after the last aging pass, it must not expire in the
+ *    next one, even if looked up in between
+ */
+static int
+test_hash_aging(uint32_t extra_flag)
+{
+	struct rte_hash *handle;
+	struct rte_hash_rcu_config rcu_cfg = {0};
+	struct rte_rcu_qsbr *qsv = NULL;
+	struct rte_hash_parameters params = {
+		.name = "test_hash_aging",
+		.entries = AGING_NUM_KEYS * 2,
+		.key_len = sizeof(uint32_t),
+		.hash_func = rte_jhash,
+		.socket_id = 0,
+		.extra_flag = RTE_HASH_EXTRA_FLAGS_AGING | extra_flag,
+	};
+	const uint64_t ttl = rte_get_timer_hz() * AGING_TTL_MS / 1000;
+	uint32_t keys[AGING_NUM_KEYS], expired[AGING_NUM_KEYS + 1];
+	uint32_t late_key = AGING_NUM_KEYS;
+	const void *key_ptrs[RTE_HASH_LOOKUP_BULK_MAX];
+	void *data[RTE_HASH_LOOKUP_BULK_MAX];
+	uint64_t hit_mask;
+	uint32_t i, n, next = 0;
+	int32_t pos;
+	int ret;
+	size_t sz;
+
+	printf("\n# Running aging test, flags 0x%x\n", extra_flag);
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	if (extra_flag & RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF) {
+		sz = rte_rcu_qsbr_get_memsize(RTE_MAX_LCORE);
+		qsv = rte_zmalloc(NULL, sz, RTE_CACHE_LINE_SIZE);
+		RETURN_IF_ERROR(qsv == NULL, "RCU QSBR allocation failed");
+		rte_rcu_qsbr_init(qsv, RTE_MAX_LCORE);
+		rcu_cfg.v = qsv;
+		rcu_cfg.mode = RTE_HASH_QSBR_MODE_DQ;
+		ret = rte_hash_rcu_qsbr_add(handle, &rcu_cfg);
+		if (ret != 0)
+			rte_free(qsv);
+		RETURN_IF_ERROR(ret != 0, "attach RCU QSBR failed");
+	}
+
+	for (i = 0; i < AGING_NUM_KEYS; i++) {
+		keys[i] = i;
+		ret = rte_hash_add_key_data(handle, &keys[i],
+					    (void *)(uintptr_t)keys[i]);
+		RETURN_IF_ERROR(ret != 0, "add key %u failed (%d)", i, ret);
+	}
+
+	rte_delay_ms(2 * AGING_TTL_MS);
+	/* Advances the aging clock, nothing is that old */
+	ret = aging_pass(handle, UINT64_MAX, expired);
+	RETURN_IF_ERROR(ret != 0, "%d keys expired with infinite ttl", ret);
+
+	for (i = 0; i < AGING_NUM_KEYS; i += 4) {
+		pos = rte_hash_lookup(handle, &keys[i]);
+		RETURN_IF_ERROR(pos < 0, "key %u not found", i);
+	}
+	for (i = 2, n = 0; i < AGING_NUM_KEYS; i += 4)
+		key_ptrs[n++] = &keys[i];
+	ret = rte_hash_lookup_bulk_data(handle, key_ptrs, n, &hit_mask, data);
+	RETURN_IF_ERROR(ret != (int)n, "%d of %u keys found", ret, n);
+
+	ret = aging_pass(handle, ttl, expired);
+	RETURN_IF_ERROR(ret != AGING_NUM_KEYS / 2, "%d keys expired", ret);
+	for (i = 0; i < (uint32_t)ret; i++)
+		RETURN_IF_ERROR((expired[i] & 1) == 0,
+				"key %u expired after a lookup", expired[i]);
+
+	RETURN_IF_ERROR(rte_hash_count(handle) != AGING_NUM_KEYS / 2,
+			"%d keys left", rte_hash_count(handle));
+	for (i = 0; i < AGING_NUM_KEYS; i++) {
+		pos = rte_hash_lookup(handle, &keys[i]);
+		RETURN_IF_ERROR((i & 1) ? pos != -ENOENT : pos < 0,
+				"key %u %s", i, (i & 1) ? "did not expire" :
+				"expired");
+	}
+
+	/* The aging clock is now stale, a new key must get the current time */
+	rte_delay_ms(2 * AGING_TTL_MS);
+	ret = rte_hash_add_key_data(handle, &late_key,
+				    (void *)(uintptr_t)late_key);
+	RETURN_IF_ERROR(ret != 0, "add key %u failed (%d)", late_key, ret);
+	pos = rte_hash_lookup(handle, &late_key);
+	RETURN_IF_ERROR(pos < 0, "key %u not found", late_key);
+
+	ret = aging_pass(handle, ttl, expired);
+	RETURN_IF_ERROR(ret != AGING_NUM_KEYS / 2, "%d keys expired", ret);
+	for (i = 0; i < (uint32_t)ret; i++)
+		RETURN_IF_ERROR(expired[i] == late_key,
+				"key %u expired just after its add", late_key);
+	RETURN_IF_ERROR(rte_hash_count(handle) != 1,
+			"%d keys left", rte_hash_count(handle));
+
+	/* A call must be able to delete something */
+	ret = rte_hash_age(handle, ttl, &next, 1, &pos, NULL, 0);
+	RETURN_IF_ERROR(ret != -EINVAL, "aging with no output accepted");
+
+	rte_hash_free(handle);
+	rte_free(qsv);
+
+	/* Aging must be enabled at creation */
+	params.extra_flag = extra_flag;
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+	ret = rte_hash_age(handle, ttl, &next, 1, &pos, NULL, 1);
+	RETURN_IF_ERROR(ret != -EINVAL, "aging without timestamps accepted");
+	rte_hash_free(handle);
+
+	return 0;
+}
+
 /*
  * Do all unit and performance tests.
  */
@@ -2261,6 +2669,28 @@ test_hash(void)
 	if (test_hash_rcu_qsbr_sync_mode(1) < 0)
 		return -1;
 
+	if (test_hash_resize(0) < 0)
+		return -1;
+
+	if (test_hash_resize(RTE_HASH_EXTRA_FLAGS_EXT_TABLE) < 0)
+		return -1;
+
+	if (test_hash_resize(RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF |
+			     RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD) < 0)
+		return -1;
+
+	if (test_hash_add_bulk() < 0)
+		return -1;
+
+	if (test_hash_aging(0) < 0)
+		return -1;
+
+	if (test_hash_aging(RTE_HASH_EXTRA_FLAGS_EXT_TABLE) < 0)
+		return -1;
+
+	if (test_hash_aging(RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF) < 0)
+		return -1;
+
 	return 0;
 }
 
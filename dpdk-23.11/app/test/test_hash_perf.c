@@ -31,6 +31,7 @@
 
 enum operations {
 	OP_ADD = 0,
+	OP_ADD_MULTI,
 	OP_LOOKUP,
 	OP_LOOKUP_MULTI,
 	OP_DELETE,
@@ -308,6 +309,47 @@ timed_adds(unsigned int with_hash, unsigned int with_data,
 	return 0;
 }
 
+static int
+timed_adds_multi(unsigned int with_hash, unsigned int with_data,
+				unsigned int table_index, unsigned int ext)
+{
+	unsigned i, j, n;
+	const void *keys_burst[BURST_SIZE];
+	void *data_burst[BURST_SIZE];
+	int32_t ret;
+	unsigned int keys_to_add;
+	if (!ext)
+		keys_to_add = KEYS_TO_ADD * ADD_PERCENT;
+	else
+		keys_to_add = KEYS_TO_ADD;
+
+	const uint64_t start_tsc = rte_rdtsc();
+
+	for (i = 0; i < keys_to_add; i += n) {
+		n = RTE_MIN(keys_to_add - i, (unsigned int)BURST_SIZE);
+		for (j = 0; j < n; j++) {
+			keys_burst[j] = keys[i + j];
+			data_burst[j] = (void *) ((uintptr_t) signatures[i + j]);
+		}
+		ret = rte_hash_add_bulk(h[table_index], keys_burst,
+					with_hash ? &signatures[i] : NULL,
+					with_data ? data_burst : NULL,
+					n, &positions[i]);
+		if (ret != (int32_t)n) {
+			printf("Failed to add key burst at %u\n", i);
+			return -1;
+		}
+	}
+
+	const uint64_t end_tsc = rte_rdtsc();
+	const uint64_t time_taken = end_tsc - start_tsc;
+
+	cycles[table_index][OP_ADD_MULTI][with_hash][with_data] =
+		time_taken/keys_to_add;
+
+	return 0;
+}
+
 static int
 timed_lookups(unsigned int with_hash, unsigned int with_data,
 				unsigned int table_index, unsigned int ext)
@@ -604,6 +646,10 @@ run_all_tbl_perf_tests(unsigned int with_pushes, unsigned int with_locks,
 				if (timed_deletes(with_hash, with_data, i, ext) < 0)
 					return -1;
 
+				if (timed_adds_multi(with_hash, with_data,
+						i, ext) < 0)
+					return -1;
+
 				/* Print a dot to show progress on operations */
 				printf(".");
 				fflush(stdout);
@@ -627,8 +673,9 @@ run_all_tbl_perf_tests(unsigned int with_pushes, unsigned int with_locks,
 			else
 				printf("\nWithout pre-computed hash values\n");
 
-			printf("\n%-18s%-18s%-18s%-18s%-18s\n",
-			"Keysize", "Add", "Lookup", "Lookup_bulk", "Delete");
+			printf("\n%-18s%-18s%-18s%-18s%-18s%-18s\n",
+			"Keysize", "Add", "Add_bulk", "Lookup", "Lookup_bulk",
+			"Delete");
 			for (i = 0; i < NUM_KEYSIZES; i++) {
 				printf("%-18d", hashtest_key_lens[i]);
 				for (j = 0; j < NUM_OPERATIONS; j++)
@@ -488,6 +488,108 @@ test_ip_frag(void)
 	return result;
 }
 
+#define SHARED_NB_SHARDS	4
+#define SHARED_NB_PKTS		4
+
+/* Fragment datagrams and reassemble them in reverse order, interleaved */
+static int
+test_ip_frag_shared_reassemble(struct rte_ip_frag_shared_tbl *tbl, int ipv)
+{
+	struct rte_ip_frag_death_row dr = { .cnt = 0 };
+	struct rte_mbuf *frags[SHARED_NB_PKTS][BURST];
+	int32_t nb_frags[SHARED_NB_PKTS];
+	struct rte_ipv6_fragment_ext *frag_hdr;
+	struct rte_mbuf *b, *out;
+	uint32_t pkt_len = 0;
+	int32_t i, j, max_frags = 0, nb_reassembled = 0;
+
+	for (i = 0; i < SHARED_NB_PKTS; i++) {
+		b = rte_pktmbuf_alloc(pkt_pool);
+		RTE_TEST_ASSERT_NOT_EQUAL(b, NULL, "Failed to allocate pkt.");
+
+		if (ipv == 4) {
+			v4_allocate_packet_of(b, 0x41414141, 1400, 0, 0, 0,
+					      64, IPPROTO_ICMP, i, false,
+					      false, false);
+			nb_frags[i] = rte_ipv4_fragment_packet(b, frags[i],
+					BURST, 600, direct_pool, indirect_pool);
+		} else {
+			v6_allocate_packet_of(b, 0x41414141, 1400, 64,
+					      IPPROTO_ICMP, i);
+			nb_frags[i] = rte_ipv6_fragment_packet(b, frags[i],
+					BURST, RTE_IPV6_MIN_MTU, direct_pool,
+					indirect_pool);
+		}
+		pkt_len = b->pkt_len;
+		rte_pktmbuf_free(b);
+
+		RTE_TEST_ASSERT(nb_frags[i] > 1, "Failed to fragment IPv%d pkt",
+				ipv);
+		max_frags = RTE_MAX(max_frags, nb_frags[i]);
+	}
+
+	for (j = max_frags - 1; j >= 0; j--) {
+		for (i = 0; i < SHARED_NB_PKTS; i++) {
+			if (j >= nb_frags[i])
+				continue;
+			b = frags[i][j];
+			b->l2_len = 0;
+			if (ipv == 4) {
+				b->l3_len = sizeof(struct rte_ipv4_hdr);
+				out = rte_ipv4_frag_shared_reassemble_packet(
+					tbl, &dr, b, rte_rdtsc(),
+					rte_pktmbuf_mtod(b,
+						struct rte_ipv4_hdr *));
+			} else {
+				b->l3_len = sizeof(struct rte_ipv6_hdr) +
+					sizeof(*frag_hdr);
+				frag_hdr = rte_pktmbuf_mtod_offset(b,
+					struct rte_ipv6_fragment_ext *,
+					sizeof(struct rte_ipv6_hdr));
+				/* the fragmentation always uses ID 0 */
+				frag_hdr->id = rte_cpu_to_be_32(i);
+				out = rte_ipv6_frag_shared_reassemble_packet(
+					tbl, &dr, b, rte_rdtsc(),
+					rte_pktmbuf_mtod(b,
+						struct rte_ipv6_hdr *),
+					frag_hdr);
+			}
+			if (out == NULL)
+				continue;
+
+			nb_reassembled++;
+			RTE_TEST_ASSERT_EQUAL(out->pkt_len, pkt_len,
+				"Wrong IPv%d reassembled pkt length %u",
+				ipv, out->pkt_len);
+			rte_pktmbuf_free(out);
+		}
+	}
+
+	RTE_TEST_ASSERT_EQUAL(dr.cnt, 0, "IPv%d fragments dropped", ipv);
+	RTE_TEST_ASSERT_EQUAL(nb_reassembled, SHARED_NB_PKTS,
+		"%d IPv%d pkts reassembled", nb_reassembled, ipv);
+
+	return TEST_SUCCESS;
+}
+
+static int
+test_ip_frag_shared(void)
+{
+	struct rte_ip_frag_shared_tbl *tbl;
+	int ret;
+
+	tbl = rte_ip_frag_shared_table_create(SHARED_NB_SHARDS, 16, 4,
+			4 * SHARED_NB_PKTS, rte_get_tsc_hz(), SOCKET_ID_ANY);
+	RTE_TEST_ASSERT_NOT_EQUAL(tbl, NULL, "Failed to create shared table");
+
+	ret = test_ip_frag_shared_reassemble(tbl, 4);
+	if (ret == TEST_SUCCESS)
+		ret = test_ip_frag_shared_reassemble(tbl, 6);
+
+	rte_ip_frag_shared_table_destroy(tbl);
+	return ret;
+}
+
 static struct unit_test_suite ipfrag_testsuite  = {
 	.suite_name = "IP Frag Unit Test Suite",
 	.setup = testsuite_setup,
@@ -495,6 +597,8 @@ static struct unit_test_suite ipfrag_testsuite  = {
 	.unit_test_cases = {
 		TEST_CASE_ST(ut_setup, ut_teardown,
 			     test_ip_frag),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			     test_ip_frag_shared),
 
 		TEST_CASES_END() /**< NULL terminate unit test array */
 	}
@@ -53,6 +53,86 @@ static int test_latency_update(void)
 	return TEST_SUCCESS;
 }
 
+/* Test case to check latency histograms after forwarding packets */
+static int test_latencystats_hist(void)
+{
+	struct rte_latencystats_hist hist, all, merged;
+	struct rte_mbuf *pbuf[LATENCY_NUM_PACKETS] = { };
+	struct rte_mempool *mp;
+	char poolname[] = "mbuf_pool";
+	uint64_t count, p50, p99;
+	unsigned int i;
+	int ret;
+
+	ret = test_get_mbuf_from_pool(&mp, pbuf, poolname);
+	if (ret < 0) {
+		printf("allocate mbuf pool Failed\n");
+		return TEST_FAILED;
+	}
+	ret = test_dev_start(portid, mp);
+	if (ret < 0) {
+		printf("test_dev_start(%hu, %p) failed, error code: %d\n",
+			portid, mp, ret);
+		return TEST_FAILED;
+	}
+
+	/* Packets are timestamped on Rx, their latency measured on next Tx */
+	ret = test_packet_forward(pbuf, portid, QUEUE_ID);
+	if (ret >= 0)
+		ret = test_packet_forward(pbuf, portid, QUEUE_ID);
+
+	rte_eth_dev_stop(portid);
+	test_put_mbuf_to_pool(mp, pbuf);
+	TEST_ASSERT(ret >= 0, "Test Failed: send pkts failed");
+
+	ret = rte_latencystats_hist_get(portid, QUEUE_ID, &hist);
+	TEST_ASSERT_SUCCESS(ret, "Test Failed: rte_latencystats_hist_get failed");
+	TEST_ASSERT(hist.count > 0, "Test Failed: no latency sample");
+
+	count = 0;
+	for (i = 0; i < RTE_LATENCYSTATS_HIST_BUCKETS; i++)
+		count += hist.buckets[i];
+	TEST_ASSERT_EQUAL(count, hist.count,
+		"Test Failed: buckets do not hold all samples");
+	TEST_ASSERT(hist.min_ns <= hist.sum_ns / hist.count &&
+		hist.sum_ns / hist.count <= hist.max_ns,
+		"Test Failed: average out of bounds");
+
+	p50 = rte_latencystats_hist_percentile(&hist, 50);
+	p99 = rte_latencystats_hist_percentile(&hist, 99);
+	TEST_ASSERT(hist.min_ns <= p50 && p50 <= p99 && p99 <= hist.max_ns,
+		"Test Failed: percentiles out of order");
+
+	ret = rte_latencystats_hist_get(portid, RTE_LATENCYSTATS_ALL_QUEUES, &all);
+	TEST_ASSERT(ret == 0 && all.count == hist.count,
+		"Test Failed: histogram of all queues differs");
+
+	/* Merging a histogram with itself keeps its distribution */
+	merged = hist;
+	rte_latencystats_hist_merge(&merged, &hist);
+	TEST_ASSERT(merged.count == 2 * hist.count &&
+		merged.min_ns == hist.min_ns && merged.max_ns == hist.max_ns,
+		"Test Failed: histogram merge");
+	TEST_ASSERT_EQUAL(rte_latencystats_hist_percentile(&merged, 50), p50,
+		"Test Failed: percentile changed by merge");
+
+	/* Buckets are ordered, with a relative width below 1/16 */
+	for (i = 1; i < RTE_LATENCYSTATS_HIST_BUCKETS; i++) {
+		uint64_t low = rte_latencystats_hist_bucket_ns(i - 1);
+		uint64_t high = rte_latencystats_hist_bucket_ns(i);
+
+		TEST_ASSERT(low < high && (high - low) * 16 <= RTE_MAX(low, 16u),
+			"Test Failed: bucket %u bounds", i);
+	}
+
+	ret = rte_latencystats_hist_get(portid, RTE_MAX_QUEUES_PER_PORT, &hist);
+	TEST_ASSERT(ret == -EINVAL, "Test Failed: histogram of invalid queue");
+	ret = rte_latencystats_hist_get(portid, QUEUE_ID, NULL);
+	TEST_ASSERT(ret == -EINVAL, "Test Failed: histogram without storage");
+
+	return TEST_SUCCESS;
+}
+
 /* Test case to uninit latency stats */
 static int test_latency_uninit(void)
 {
@@ -194,17 +274,22 @@ unit_test_suite latencystats_testsuite = {
 		 */
 		TEST_CASE_ST(test_latency_packet_forward, NULL,
 				test_latency_update),
-		/* Test Case 3: To check whether latency stats names
+
+		/* Test Case 3: Forward timestamped packets and check
+		 * the latency histograms
+		 */
+		TEST_CASE_ST(NULL, NULL, test_latencystats_hist),
+		/* Test Case 4: To check whether latency stats names
 		 * are retrieved
 		 */
 		TEST_CASE_ST(NULL, NULL, test_latencystats_get_names),
 
-		/* Test Case 4: To check whether latency stats
+		/* Test Case 5: To check whether latency stats
 		 * values are retrieved
 		 */
 		TEST_CASE_ST(NULL, NULL, test_latencystats_get),
 
-		/* Test Case 5: To check uninit of latency test */
+		/* Test Case 6: To check uninit of latency test */
 		TEST_CASE_ST(NULL, NULL, test_latency_uninit),
 
 		TEST_CASES_END()
@@ -11,6 +11,8 @@
 
 #include <rte_memory.h>
 #include <rte_lpm6.h>
+#include <rte_random.h>
+#include <rte_vect.h>
 
 #include "test_lpm6_data.h"
 
@@ -52,6 +54,7 @@ static int32_t test25(void);
 static int32_t test26(void);
 static int32_t test27(void);
 static int32_t test28(void);
+static int32_t test29(void);
 
 rte_lpm6_test tests6[] = {
 /* Test Cases */
@@ -84,6 +87,7 @@ rte_lpm6_test tests6[] = {
 	test26,
 	test27,
 	test28,
+	test29,
 };
 
 #define MAX_DEPTH                                                    128
@@ -1771,6 +1775,83 @@ test28(void)
 	return PASS;
 }
 
+/*
+ * Adds nested rules of mixed depths and looks up a batch covering several
+ * full vector passes and a partial one through the lookup_bulk function,
+ * with both the scalar and the vector implementation when available.
+ * Checks that the results are the same as the single lookups.
+ */
+#define BULK_NUM_IPS	53
+
+int32_t
+test29(void)
+{
+	struct rte_lpm6 *lpm = NULL;
+	struct rte_lpm6_config config;
+	const uint8_t depths[] = {16, 24, 25, 32, 40, 48, 64, 65, 100, 128};
+	const uint16_t bitwidths[] = {RTE_VECT_SIMD_256, RTE_VECT_SIMD_512};
+	uint8_t ip_batch[BULK_NUM_IPS][16];
+	uint8_t ip[16];
+	int32_t next_hop_return[BULK_NUM_IPS];
+	uint32_t next_hop;
+	uint16_t bitwidth;
+	unsigned int i, j, d;
+	int32_t status;
+
+	config.max_rules = MAX_RULES;
+	config.number_tbl8s = NUMBER_TBL8S;
+	config.flags = 0;
+
+	lpm = rte_lpm6_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	/* Every rule is nested in the previous one, except for the last bit */
+	IPv6(ip, 32, 1, 13, 184, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+	for (d = 0; d < RTE_DIM(depths); d++) {
+		ip[(depths[d] - 1) / 8] ^= 1 << (7 - (depths[d] - 1) % 8);
+		status = rte_lpm6_add(lpm, ip, depths[d], depths[d]);
+		TEST_LPM_ASSERT(status == 0);
+	}
+
+	/* Addresses under each rule and its siblings, some missing all */
+	for (i = 0; i < BULK_NUM_IPS; i++) {
+		for (j = 0; j < 16; j++)
+			ip_batch[i][j] = rte_rand();
+		if (i % 7 == 6)
+			continue;
+		d = depths[i % RTE_DIM(depths)] - i % 2;
+		memcpy(ip_batch[i], ip, d / 8);
+		if (d % 8 != 0)
+			ip_batch[i][d / 8] = (ip[d / 8] & (0xff << (8 - d % 8))) |
+				(ip_batch[i][d / 8] & (0xff >> d % 8));
+	}
+
+	bitwidth = rte_vect_get_max_simd_bitwidth();
+	for (i = 0; i < RTE_DIM(bitwidths); i++) {
+		/* the bitwidth can't be changed when forced by the user */
+		if (rte_vect_set_max_simd_bitwidth(bitwidths[i]) != 0 && i != 0)
+			break;
+
+		for (j = 0; j < BULK_NUM_IPS; j++)
+			next_hop_return[j] = -2;
+		status = rte_lpm6_lookup_bulk_func(lpm, ip_batch,
+				next_hop_return, BULK_NUM_IPS);
+		TEST_LPM_ASSERT(status == 0);
+
+		for (j = 0; j < BULK_NUM_IPS; j++) {
+			status = rte_lpm6_lookup(lpm, ip_batch[j], &next_hop);
+			TEST_LPM_ASSERT((status == 0) ?
+				next_hop_return[j] == (int32_t)next_hop :
+				next_hop_return[j] == -1);
+		}
+	}
+	rte_vect_set_max_simd_bitwidth(bitwidth);
+
+	rte_lpm6_free(lpm);
+
+	return PASS;
+}
+
 /*
  * Do all unit tests.
  */
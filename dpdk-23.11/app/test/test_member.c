@@ -951,6 +951,156 @@ test_member_sketch(void)
 	return 0;
 }
 
+#define SKETCH_MERGE_KEYS 200
+#define SKETCH_MERGE_LARGEST_KEY 1000
+
+static int
+sketch_merge_check(const struct rte_member_setsum *ss,
+		   const struct rte_member_setsum *ref, const char *desc)
+{
+	uint64_t count, ref_count, counts[TOP_K];
+	uint32_t i;
+
+	for (i = 0; i < SKETCH_MERGE_KEYS; i++) {
+		rte_member_query_count(ss, &i, &count);
+		rte_member_query_count(ref, &i, &ref_count);
+		if (count != ref_count) {
+			printf("%s: key %u count %"PRIu64" expected %"PRIu64"\n",
+				desc, i, count, ref_count);
+			return -1;
+		}
+	}
+
+	if (rte_member_report_heavyhitter(ss, heavy_hitters, counts) < 1 ||
+			*(uint32_t *)heavy_hitters[0] != 0) {
+		printf("%s: largest key missing from the top-k\n", desc);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Sequence of operations for sketch merge
+ *
+ * - count the keys in two mergeable sketches and in a reference one
+ * - merge the sketches, directly and serialized, check the counts
+ * - check incompatible sketches and bad buffers are rejected
+ * - decay the merged sketch, check the counts
+ */
+static int
+test_member_sketch_merge(void)
+{
+	struct rte_member_setsum *ss[4] = {NULL};
+	struct rte_member_parameters prm = params;
+	const char *names[] = {"sketch_merge_0", "sketch_merge_1",
+		"sketch_ref", "sketch_serialized"};
+	uint64_t count, ref_count;
+	uint8_t *buf = NULL;
+	uint32_t i, j;
+	int len, ret = -1;
+
+	prm.type = RTE_MEMBER_TYPE_SKETCH;
+	prm.key_len = sizeof(uint32_t);
+	prm.error_rate = 0.01;
+	prm.sample_rate = 1;
+	prm.top_k = TOP_K;
+	prm.extra_flag = RTE_MEMBER_SKETCH_MERGEABLE;
+
+	for (i = 0; i < RTE_DIM(ss); i++) {
+		prm.name = names[i];
+		ss[i] = rte_member_create(&prm);
+		if (ss[i] == NULL) {
+			printf("Creation of %s failed\n", names[i]);
+			goto out;
+		}
+	}
+
+	/* each key half counted by each sketch, all by the reference */
+	for (i = 0; i < SKETCH_MERGE_KEYS; i++) {
+		for (j = 0; j < SKETCH_MERGE_LARGEST_KEY / (i + 1); j++) {
+			rte_member_add(ss[j & 1], &i, 1);
+			rte_member_add(ss[2], &i, 1);
+		}
+	}
+
+	if (rte_member_merge(ss[0], ss[1]) != 0) {
+		printf("Sketch merge failed\n");
+		goto out;
+	}
+	if (sketch_merge_check(ss[0], ss[2], "merge") < 0)
+		goto out;
+
+	len = rte_member_serialize(ss[2], NULL, 0);
+	if (len <= 0) {
+		printf("Sketch serialized size failed\n");
+		goto out;
+	}
+	buf = rte_malloc(NULL, len, 0);
+	if (buf == NULL) {
+		printf("RTE_MALLOC failed\n");
+		goto out;
+	}
+	if (rte_member_serialize(ss[2], buf, len - 1) != -ENOSPC ||
+			rte_member_serialize(ss[2], buf, len) != len) {
+		printf("Sketch serialize failed\n");
+		goto out;
+	}
+	if (rte_member_merge_serialized(ss[3], buf, len) != 0) {
+		printf("Serialized sketch merge failed\n");
+		goto out;
+	}
+	if (sketch_merge_check(ss[3], ss[2], "serialized merge") < 0)
+		goto out;
+
+	if (rte_member_merge_serialized(ss[3], buf, len - 1) != -EINVAL) {
+		printf("Truncated serialized sketch merged\n");
+		goto out;
+	}
+	buf[0] ^= 1;
+	if (rte_member_merge_serialized(ss[3], buf, len) != -EINVAL) {
+		printf("Corrupted serialized sketch merged\n");
+		goto out;
+	}
+
+	/* sketches with different seeds can't be merged */
+	rte_member_free(ss[3]);
+	prm.name = names[3];
+	prm.prim_hash_seed++;
+	ss[3] = rte_member_create(&prm);
+	if (ss[3] == NULL) {
+		printf("Creation of %s failed\n", names[3]);
+		goto out;
+	}
+	if (rte_member_merge(ss[3], ss[2]) != -EINVAL) {
+		printf("Sketches with different seeds merged\n");
+		goto out;
+	}
+
+	if (rte_member_decay(ss[0], 1.5) != -EINVAL ||
+			rte_member_decay(ss[0], 0.5) != 0) {
+		printf("Sketch decay failed\n");
+		goto out;
+	}
+	for (i = 0; i < SKETCH_MERGE_KEYS; i++) {
+		rte_member_query_count(ss[0], &i, &count);
+		rte_member_query_count(ss[2], &i, &ref_count);
+		if (count != ref_count / 2) {
+			printf("Decayed key %u count %"PRIu64" expected %"PRIu64"\n",
+				i, count, ref_count / 2);
+			goto out;
+		}
+	}
+
+	printf("Sketch merge test passed\n");
+	ret = 0;
+out:
+	rte_free(buf);
+	for (i = 0; i < RTE_DIM(ss); i++)
+		rte_member_free(ss[i]);
+	return ret;
+}
+
 static int
 test_member(void)
 {
@@ -990,6 +1140,10 @@ test_member(void)
 		perform_free();
 		return -1;
 	}
+	if (test_member_sketch_merge() < 0) {
+		perform_free();
+		return -1;
+	}
 	perform_free();
 	return 0;
 }
@@ -115,9 +115,12 @@ test_setup(void)
 		goto fail;
 	}
 
-	/* Make a pool for cloned packets */
+	/*
+	 * Make a pool for cloned packets, attach needs three per packet
+	 * and the original packet.
+	 */
 	mp = rte_pktmbuf_pool_create_by_ops("pcapng_test_pool",
-					    MAX_BURST, 0, 0,
+					    3 * MAX_BURST + 1, 0, 0,
 					    rte_pcapng_mbuf_size(pkt_len) + 128,
 					    SOCKET_ID_ANY, "ring_mp_sc");
 	if (mp == NULL) {
@@ -134,7 +137,7 @@ fail:
 }
 
 static int
-fill_pcapng_file(rte_pcapng_t *pcapng, unsigned int num_packets)
+fill_pcapng_file(rte_pcapng_t *pcapng, unsigned int num_packets, bool attach)
 {
 	struct dummy_mbuf mbfs;
 	struct rte_mbuf *orig;
@@ -146,6 +149,15 @@ fill_pcapng_file(rte_pcapng_t *pcapng, unsigned int num_packets)
 	mbuf1_prepare(&mbfs, pkt_len);
 	orig  = &mbfs.mb[0];
 
+	/* indirect mbufs can only reference data of a pool mbuf */
+	if (attach) {
+		orig = rte_pktmbuf_copy(orig, mp, 0, UINT32_MAX);
+		if (orig == NULL) {
+			fprintf(stderr, "Cannot copy original packet\n");
+			return -1;
+		}
+	}
+
 	for (count = 0; count < num_packets; count += burst_size) {
 		struct rte_mbuf *clones[MAX_BURST];
 		unsigned int i;
@@ -155,11 +167,20 @@ fill_pcapng_file(rte_pcapng_t *pcapng, unsigned int num_packets)
 		for (i = 0; i < burst_size; i++) {
 			struct rte_mbuf *mc;
 
-			mc = rte_pcapng_copy(port_id, 0, orig, mp, pkt_len,
-					     RTE_PCAPNG_DIRECTION_IN, NULL);
+			if (attach)
+				mc = rte_pcapng_attach(port_id, 0, orig, mp,
+						       pkt_len,
+						       RTE_PCAPNG_DIRECTION_IN,
+						       NULL);
+			else
+				mc = rte_pcapng_copy(port_id, 0, orig, mp,
+						     pkt_len,
+						     RTE_PCAPNG_DIRECTION_IN,
+						     NULL);
 			if (mc == NULL) {
 				fprintf(stderr, "Cannot copy packet\n");
-				return -1;
+				rte_pktmbuf_free_bulk(clones, i);
+				goto fail;
 			}
 			clones[i] = mc;
 		}
@@ -171,14 +192,28 @@ fill_pcapng_file(rte_pcapng_t *pcapng, unsigned int num_packets)
 		if (len <= 0) {
 			fprintf(stderr, "Write of packets failed: %s\n",
 				rte_strerror(rte_errno));
-			return -1;
+			goto fail;
+		}
+
+		/* all references to the original are gone */
+		if (rte_mbuf_refcnt_read(orig) != 1) {
+			fprintf(stderr, "Packet reference count %u after write\n",
+				rte_mbuf_refcnt_read(orig));
+			goto fail;
 		}
 
 		/* Leave a small gap between packets to test for time wrap */
 		usleep(rte_rand_max(MAX_GAP_US));
 	}
 
+	if (attach)
+		rte_pktmbuf_free(orig);
 	return count;
+
+fail:
+	if (attach)
+		rte_pktmbuf_free(orig);
+	return -1;
 }
 
 static char *
@@ -375,7 +410,7 @@ fail:
 }
 
 static int
-test_write_packets(void)
+write_packets(bool attach)
 {
 	char file_name[] = "/tmp/pcapng_test_XXXXXX.pcapng";
 	static rte_pcapng_t *pcapng;
@@ -405,7 +440,7 @@ test_write_packets(void)
 		goto fail;
 	}
 
-	count = fill_pcapng_file(pcapng, TOTAL_PACKETS);
+	count = fill_pcapng_file(pcapng, TOTAL_PACKETS, attach);
 	if (count < 0)
 		goto fail;
 
@@ -431,6 +466,18 @@ fail:
 	return -1;
 }
 
+static int
+test_write_packets(void)
+{
+	return write_packets(false);
+}
+
+static int
+test_attach_packets(void)
+{
+	return write_packets(true);
+}
+
 static void
 test_cleanup(void)
 {
@@ -446,6 +493,7 @@ unit_test_suite test_pcapng_suite  = {
 	.unit_test_cases = {
 		TEST_CASE(test_add_interface),
 		TEST_CASE(test_write_packets),
+		TEST_CASE(test_attach_packets),
 		TEST_CASES_END()
 	}
 };
@@ -2,14 +2,17 @@
  * Copyright(c) 2018 Intel Corporation
  */
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <stdint.h>
 #include <limits.h>
 
 #include <ethdev_driver.h>
 #include <rte_pdump.h>
+#include "rte_cycles.h"
 #include "rte_eal.h"
 #include "rte_lcore.h"
+#include "rte_mbuf.h"
 #include "rte_mempool.h"
 #include "rte_ring.h"
 
@@ -20,6 +23,8 @@
 
 #define launch_p(ARGV) process_dup(ARGV, RTE_DIM(ARGV), __func__)
 
+#define PKT_LEN 64
+
 struct rte_ring *ring_server;
 uint16_t portid;
 uint16_t flag_for_send_pkts = 1;
@@ -27,6 +32,7 @@ uint16_t flag_for_send_pkts = 1;
 int
 test_pdump_init(void)
 {
+	uint64_t triggers, count;
 	int ret = 0;
 
 	ret = rte_pdump_init();
@@ -34,6 +40,18 @@ test_pdump_init(void)
 		printf("rte_pdump_init failed\n");
 		return -1;
 	}
+
+	ret = rte_pdump_trigger_count(&triggers);
+	if (ret < 0) {
+		printf("rte_pdump_trigger_count failed\n");
+		return -1;
+	}
+	ret = rte_pdump_trigger();
+	if (ret < 0 || rte_pdump_trigger_count(&count) < 0 ||
+	    count != triggers + 1) {
+		printf("rte_pdump_trigger failed\n");
+		return -1;
+	}
 	ret = test_ring_setup(&ring_server, &portid);
 	if (ret < 0) {
 		printf("test_ring_setup failed\n");
@@ -43,6 +61,111 @@ test_pdump_init(void)
 	return ret;
 }
 
+static unsigned int
+pdump_cache_len(struct rte_mempool *mp)
+{
+	struct rte_mempool_cache *cache;
+
+	cache = rte_mempool_default_cache(mp, rte_lcore_id());
+	return cache == NULL ? 0 : cache->len;
+}
+
+/*
+ * Capture by reference the packets forwarded by the primary process,
+ * and check that freeing the captured packets drops the references on
+ * the original packets and puts the capture mbufs back in their pool,
+ * without going through the mempool cache of this lcore which the
+ * primary process also uses.
+ */
+static int
+run_pdump_zero_copy_test(uint32_t flags, struct rte_ring *ring,
+			 struct rte_mempool *mp)
+{
+	struct rte_mbuf *pkts[RING_SIZE];
+	struct rte_mbuf *orig[RING_SIZE];
+	struct rte_mempool *mp_orig;
+	unsigned int avail, avail_orig, cache_len, cache_len_orig;
+	unsigned int i, n, wait;
+	struct rte_mbuf *seg;
+
+	mp_orig = rte_mempool_lookup("mbuf_pool_server");
+	if (mp_orig == NULL) {
+		printf("rte_mempool_lookup failed\n");
+		return -1;
+	}
+
+	/* drop the packets captured by previous tests */
+	while ((n = rte_ring_dequeue_burst(ring, (void **)pkts,
+					   RTE_DIM(pkts), NULL)) != 0)
+		rte_pdump_free_bulk(pkts, n);
+
+	avail = rte_mempool_avail_count(mp);
+	avail_orig = rte_mempool_avail_count(mp_orig);
+	cache_len = pdump_cache_len(mp);
+	cache_len_orig = pdump_cache_len(mp_orig);
+
+	if (rte_pdump_enable(portid, QUEUE_ID, flags, ring, mp, NULL) < 0) {
+		printf("rte_pdump_enable zero copy failed\n");
+		return -1;
+	}
+	for (wait = 0; wait < 1000 && rte_ring_count(ring) < NUM_PACKETS;
+	     wait++)
+		rte_delay_ms(1);
+	if (rte_pdump_disable(portid, QUEUE_ID, flags) < 0) {
+		printf("rte_pdump_disable zero copy failed\n");
+		return -1;
+	}
+	/* let a callback in progress complete */
+	rte_delay_ms(10);
+
+	n = rte_ring_dequeue_burst(ring, (void **)pkts, RTE_DIM(pkts), NULL);
+	if (n == 0) {
+		printf("no packet captured\n");
+		return -1;
+	}
+	for (i = 0; i < n; i++) {
+		for (seg = pkts[i]; seg != NULL; seg = seg->next) {
+			if (RTE_MBUF_CLONED(seg))
+				break;
+		}
+		if (seg == NULL) {
+			printf("packet %u captured by copy\n", i);
+			rte_pdump_free_bulk(pkts, n);
+			return -1;
+		}
+		orig[i] = rte_mbuf_from_indirect(seg);
+		if (orig[i]->pool != mp_orig ||
+		    rte_mbuf_refcnt_read(orig[i]) < 2) {
+			printf("packet %u not referenced\n", i);
+			rte_pdump_free_bulk(pkts, n);
+			return -1;
+		}
+	}
+
+	/* one at a time, as large bursts bypass the mempool cache anyway */
+	for (i = 0; i < n; i++)
+		rte_pdump_free_bulk(&pkts[i], 1);
+
+	for (i = 0; i < n; i++) {
+		if (rte_mbuf_refcnt_read(orig[i]) != 1) {
+			printf("packet %u still referenced\n", i);
+			return -1;
+		}
+	}
+	if (rte_mempool_avail_count(mp) != avail ||
+	    rte_mempool_avail_count(mp_orig) != avail_orig) {
+		printf("mbufs not back in their pool\n");
+		return -1;
+	}
+	if (pdump_cache_len(mp) != cache_len ||
+	    pdump_cache_len(mp_orig) != cache_len_orig) {
+		printf("mbufs freed through the lcore cache\n");
+		return -1;
+	}
+
+	return 0;
+}
+
 int
 run_pdump_client_tests(void)
 {
@@ -111,6 +234,34 @@ run_pdump_client_tests(void)
 			printf("\n***** flags = RTE_PDUMP_FLAG_RXTX *****\n");
 		}
 	}
+
+	printf("\n***** flags = RTE_PDUMP_FLAG_RXTX | RTE_PDUMP_FLAG_ZERO_COPY *****\n");
+	flags = RTE_PDUMP_FLAG_RXTX | RTE_PDUMP_FLAG_ZERO_COPY;
+	ret = rte_pdump_enable(portid, QUEUE_ID, flags, ring_client, mp, NULL);
+	if (ret < 0) {
+		printf("rte_pdump_enable zero copy failed\n");
+		return -1;
+	}
+	printf("pdump_enable zero copy success\n");
+
+	ret = rte_pdump_disable(portid, QUEUE_ID, flags);
+	if (ret < 0) {
+		printf("rte_pdump_disable zero copy failed\n");
+		return -1;
+	}
+	printf("pdump_disable zero copy success\n");
+
+	printf("\n***** zero copy capture *****\n");
+	ret = run_pdump_zero_copy_test(flags, ring_client, mp);
+	if (ret == 0)
+		ret = run_pdump_zero_copy_test(flags | RTE_PDUMP_FLAG_PCAPNG,
+					       ring_client, mp);
+	if (ret < 0) {
+		printf("zero copy capture failed\n");
+		return -1;
+	}
+	printf("zero copy capture success\n");
+
 	if (ring_client != NULL)
 		test_ring_free(ring_client);
 	if (mp != NULL)
@@ -143,11 +294,16 @@ send_pkts(void *empty __rte_unused)
 	struct rte_mbuf *pbuf[NUM_PACKETS] = { };
 	struct rte_mempool *mp;
 	char poolname[] = "mbuf_pool_server";
+	unsigned int i;
 
 	ret = test_get_mbuf_from_pool(&mp, pbuf, poolname);
 	if (ret < 0)
 		printf("get_mbuf_from_pool failed\n");
 
+	/* give the packets data to be referenced by zero copy capture */
+	for (i = 0; ret >= 0 && i < NUM_PACKETS; i++)
+		rte_pktmbuf_append(pbuf[i], PKT_LEN);
+
 	ret = test_dev_start(portid, mp);
 	if (ret < 0)
 		printf("test_dev_start(%hu, %p) failed, error code: %d\n",
@@ -206,8 +362,9 @@ test_pdump(void)
 	int ret = 0;
 	if (rte_eal_process_type() == RTE_PROC_PRIMARY) {
 		printf("IN PRIMARY PROCESS\n");
+		/* also fails on the exit status of the secondary process */
 		ret = run_pdump_server_tests();
-		if (ret < 0)
+		if (ret != 0)
 			return TEST_FAILED;
 	} else if (rte_eal_process_type() == RTE_PROC_SECONDARY) {
 		printf("IN SECONDARY PROCESS\n");
@@ -10,10 +10,13 @@
 
 #include <rte_cycles.h>
 #include <rte_errno.h>
+#include <rte_launch.h>
 #include <rte_mbuf.h>
+#include <rte_pause.h>
 #include <rte_reorder.h>
 #include <rte_lcore.h>
 #include <rte_malloc.h>
+#include <rte_stdatomic.h>
 
 #define BURST 32
 #define REORDER_BUFFER_SIZE 16384
@@ -485,6 +488,385 @@ exit:
 	return ret;
 }
 
+static int
+test_reorder_adaptive_window(void)
+{
+	struct rte_mempool *p = test_params->p;
+	const struct rte_reorder_conf conf = {
+		.size = 4,
+		.max_size = 16,
+	};
+	struct rte_reorder_conf bad_conf = conf;
+	struct rte_reorder_buffer *b = NULL;
+	const unsigned int num_bufs = 8;
+	const uint32_t seqn[] = {0, 1, 2, 3, 5, 4, 17, 100};
+	struct rte_mbuf *bufs[num_bufs];
+	struct rte_mbuf *robufs[num_bufs];
+	unsigned int i, cnt;
+	int ret = 0;
+
+	bad_conf.max_size = 2;
+	b = rte_reorder_create_with_conf("test_adaptive", rte_socket_id(), &bad_conf);
+	TEST_ASSERT((b == NULL) && (rte_errno == EINVAL),
+			"No error on create with max size below size");
+	bad_conf.max_size = 12;
+	b = rte_reorder_create_with_conf("test_adaptive", rte_socket_id(), &bad_conf);
+	TEST_ASSERT((b == NULL) && (rte_errno == EINVAL),
+			"No error on create with invalid max size");
+
+	b = rte_reorder_create_with_conf("test_adaptive", rte_socket_id(), &conf);
+	TEST_ASSERT_NOT_NULL(b, "Failed to create reorder buffer");
+
+	for (i = 0; i < num_bufs; i++) {
+		bufs[i] = rte_pktmbuf_alloc(p);
+		if (bufs[i] == NULL) {
+			printf("Packet allocation failed\n");
+			ret = -1;
+			goto exit;
+		}
+		*rte_reorder_seqn(bufs[i]) = seqn[i];
+	}
+
+	/* Window full, then early packet: window doubles instead of skipping 4 */
+	for (i = 0; i < 6; i++) {
+		ret = rte_reorder_insert(b, bufs[i]);
+		if (ret != 0) {
+			printf("%s:%d: Error inserting packet %u\n",
+					__func__, __LINE__, seqn[i]);
+			ret = -1;
+			goto exit;
+		}
+		bufs[i] = NULL;
+	}
+	if (rte_reorder_window_get(b) != 8) {
+		printf("%s:%d: Window not grown to 8: %u\n",
+				__func__, __LINE__, rte_reorder_window_get(b));
+		ret = -1;
+		goto exit;
+	}
+
+	cnt = rte_reorder_drain(b, robufs, num_bufs);
+	for (i = 0; i < cnt; i++) {
+		if (*rte_reorder_seqn(robufs[i]) != i) {
+			printf("%s:%d: Packet %u out of order\n", __func__, __LINE__, i);
+			ret = -1;
+		}
+		rte_pktmbuf_free(robufs[i]);
+	}
+	if (ret != 0 || cnt != 6) {
+		printf("%s:%d: Drained %u packets instead of 6\n",
+				__func__, __LINE__, cnt);
+		ret = -1;
+		goto exit;
+	}
+
+	/* Window grows up to its maximum */
+	ret = rte_reorder_insert(b, bufs[6]);
+	if (ret != 0 || rte_reorder_window_get(b) != 16) {
+		printf("%s:%d: Window not grown to max size\n", __func__, __LINE__);
+		ret = -1;
+		goto exit;
+	}
+	bufs[6] = NULL;
+
+	ret = rte_reorder_insert(b, bufs[7]);
+	if (!((ret == -1) && (rte_errno == ERANGE))) {
+		printf("%s:%d: No error inserting packet out of range\n",
+				__func__, __LINE__);
+		ret = -1;
+		goto exit;
+	}
+
+	/* Reset restores the initial window */
+	rte_reorder_reset(b);
+	if (rte_reorder_window_get(b) != conf.size) {
+		printf("%s:%d: Window not restored on reset\n", __func__, __LINE__);
+		ret = -1;
+		goto exit;
+	}
+
+	ret = 0;
+exit:
+	rte_reorder_free(b);
+	for (i = 0; i < num_bufs; i++)
+		rte_pktmbuf_free(bufs[i]);
+
+	return ret;
+}
+
+static int
+test_reorder_mp_insert(void)
+{
+	struct rte_mempool *p = test_params->p;
+	const struct rte_reorder_conf conf = {
+		.size = 8,
+		.flags = RTE_REORDER_F_MP_INSERT,
+	};
+	struct rte_reorder_buffer *b = NULL;
+	const unsigned int num_bufs = 12;
+	const uint32_t seqn[] = {7, 5, 6, 4, 2, 0, 1, 3, 16, 8, 16, 100};
+	struct rte_mbuf *bufs[num_bufs];
+	struct rte_mbuf *robufs[num_bufs];
+	unsigned int i, cnt;
+	int ret = 0;
+
+	b = rte_reorder_create_with_conf("test_mp_insert", rte_socket_id(), &conf);
+	TEST_ASSERT_NOT_NULL(b, "Failed to create reorder buffer");
+
+	for (i = 0; i < num_bufs; i++) {
+		bufs[i] = rte_pktmbuf_alloc(p);
+		if (bufs[i] == NULL) {
+			printf("Packet allocation failed\n");
+			ret = -1;
+			goto exit;
+		}
+		*rte_reorder_seqn(bufs[i]) = seqn[i];
+	}
+
+	/* Packets 0 to 7 but 3 */
+	cnt = rte_reorder_insert_bulk(b, bufs, 7);
+	if (cnt != 7) {
+		printf("%s:%d: Inserted %u packets instead of 7\n",
+				__func__, __LINE__, cnt);
+		ret = -1;
+		goto exit;
+	}
+	for (i = 0; i < cnt; i++)
+		bufs[i] = NULL;
+
+	cnt = rte_reorder_drain(b, robufs, num_bufs);
+	for (i = 0; i < cnt; i++) {
+		if (*rte_reorder_seqn(robufs[i]) != i) {
+			printf("%s:%d: Packet %u out of order\n", __func__, __LINE__, i);
+			ret = -1;
+		}
+		rte_pktmbuf_free(robufs[i]);
+	}
+	if (ret != 0 || cnt != 3) {
+		printf("%s:%d: Drained %u packets instead of 3\n",
+				__func__, __LINE__, cnt);
+		ret = -1;
+		goto exit;
+	}
+
+	ret = rte_reorder_insert(b, bufs[7]);
+	if (ret != 0) {
+		printf("%s:%d: Error inserting packet 3\n", __func__, __LINE__);
+		ret = -1;
+		goto exit;
+	}
+	bufs[7] = NULL;
+
+	cnt = rte_reorder_drain(b, robufs, num_bufs);
+	for (i = 0; i < cnt; i++) {
+		if (*rte_reorder_seqn(robufs[i]) != i + 3) {
+			printf("%s:%d: Packet %u out of order\n",
+					__func__, __LINE__, i + 3);
+			ret = -1;
+		}
+		rte_pktmbuf_free(robufs[i]);
+	}
+	if (ret != 0 || cnt != 5) {
+		printf("%s:%d: Drained %u packets instead of 5\n",
+				__func__, __LINE__, cnt);
+		ret = -1;
+		goto exit;
+	}
+
+	/* Early packet is refused until a drain skips missing packet 8 */
+	ret = rte_reorder_insert(b, bufs[8]);
+	if (!((ret == -1) && (rte_errno == ENOSPC))) {
+		printf("%s:%d: No error inserting early packet\n", __func__, __LINE__);
+		ret = -1;
+		goto exit;
+	}
+	cnt = rte_reorder_drain(b, robufs, num_bufs);
+	ret = rte_reorder_insert(b, bufs[8]);
+	if (cnt != 0 || ret != 0) {
+		printf("%s:%d: Error inserting early packet after drain\n",
+				__func__, __LINE__);
+		ret = -1;
+		goto exit;
+	}
+	bufs[8] = NULL;
+
+	/* Skipped packet and duplicate are late */
+	for (i = 9; i < num_bufs; i++) {
+		ret = rte_reorder_insert(b, bufs[i]);
+		if (!((ret == -1) && (rte_errno == ERANGE))) {
+			printf("%s:%d: No error inserting late packet %u\n",
+					__func__, __LINE__, seqn[i]);
+			ret = -1;
+			goto exit;
+		}
+	}
+
+	cnt = rte_reorder_drain_up_to_seqn(b, robufs, num_bufs, 17);
+	for (i = 0; i < cnt; i++)
+		rte_pktmbuf_free(robufs[i]);
+	if (cnt != 1) {
+		printf("%s:%d: Drained %u packets instead of 1\n",
+				__func__, __LINE__, cnt);
+		ret = -1;
+		goto exit;
+	}
+
+	/* Empty again, sequence can restart */
+	ret = rte_reorder_min_seqn_set(b, 100);
+	if (ret != 0) {
+		printf("%s:%d: Error in setting min sequence number\n",
+				__func__, __LINE__);
+		ret = -1;
+		goto exit;
+	}
+	ret = rte_reorder_insert(b, bufs[11]);
+	if (ret != 0) {
+		printf("%s:%d: Error inserting packet with valid seqn\n",
+				__func__, __LINE__);
+		ret = -1;
+		goto exit;
+	}
+	bufs[11] = NULL;
+
+	ret = 0;
+exit:
+	rte_reorder_free(b);
+	for (i = 0; i < num_bufs; i++)
+		rte_pktmbuf_free(bufs[i]);
+
+	return ret;
+}
+
+#define MP_NUM_PKTS (1 << 18)
+#define MP_WORKER_BURST 8
+
+static struct {
+	struct rte_reorder_buffer *b;
+	RTE_ATOMIC(uint32_t) next_seqn;
+	RTE_ATOMIC(uint32_t) nb_late;
+	RTE_ATOMIC(uint32_t) nb_workers_done;
+	RTE_ATOMIC(uint32_t) nb_errors;
+} mp_params;
+
+static int
+test_reorder_mp_worker(__rte_unused void *arg)
+{
+	struct rte_mbuf *bufs[MP_WORKER_BURST];
+	unsigned int i, n, cnt;
+	uint32_t seqn;
+
+	for (;;) {
+		seqn = rte_atomic_fetch_add_explicit(&mp_params.next_seqn,
+				MP_WORKER_BURST, rte_memory_order_relaxed);
+		if (seqn >= MP_NUM_PKTS)
+			break;
+
+		if (rte_pktmbuf_alloc_bulk(test_params->p, bufs,
+				MP_WORKER_BURST) != 0) {
+			rte_atomic_fetch_add_explicit(&mp_params.nb_errors, 1,
+					rte_memory_order_relaxed);
+			break;
+		}
+		/* Complete the burst in reverse order */
+		for (i = 0; i < MP_WORKER_BURST; i++)
+			*rte_reorder_seqn(bufs[i]) = seqn + MP_WORKER_BURST - 1 - i;
+
+		for (n = 0; n < MP_WORKER_BURST; n += cnt) {
+			cnt = rte_reorder_insert_bulk(mp_params.b, &bufs[n],
+					MP_WORKER_BURST - n);
+			if (n + cnt == MP_WORKER_BURST)
+				break;
+			if (rte_errno == ENOSPC) {
+				rte_pause();
+				continue;
+			}
+			/* Skipped as lost while this worker was descheduled */
+			rte_pktmbuf_free(bufs[n + cnt]);
+			rte_atomic_fetch_add_explicit(&mp_params.nb_late, 1,
+					rte_memory_order_relaxed);
+			cnt++;
+		}
+	}
+
+	rte_atomic_fetch_add_explicit(&mp_params.nb_workers_done, 1,
+			rte_memory_order_release);
+	return 0;
+}
+
+static int
+test_reorder_mp_drain(struct rte_mbuf **robufs, unsigned int cnt,
+		uint32_t *next_seqn)
+{
+	unsigned int i;
+	int ret = 0;
+
+	for (i = 0; i < cnt; i++) {
+		if (*rte_reorder_seqn(robufs[i]) < *next_seqn)
+			ret = -1;
+		*next_seqn = *rte_reorder_seqn(robufs[i]) + 1;
+		rte_pktmbuf_free(robufs[i]);
+	}
+
+	return ret;
+}
+
+static int
+test_reorder_mp_lcores(void)
+{
+	const struct rte_reorder_conf conf = {
+		.size = 64,
+		.max_size = 1024,
+		.flags = RTE_REORDER_F_MP_INSERT,
+	};
+	struct rte_mbuf *robufs[BURST];
+	unsigned int nb_workers, nb_drained = 0, cnt;
+	uint32_t next_seqn = 0;
+	int ret = 0;
+
+	nb_workers = rte_lcore_count() - 1;
+	if (nb_workers == 0) {
+		printf("Multi-producer reorder test needs at least 2 lcores\n");
+		return TEST_SKIPPED;
+	}
+
+	memset(&mp_params, 0, sizeof(mp_params));
+	mp_params.b = rte_reorder_create_with_conf("test_mp_lcores",
+			rte_socket_id(), &conf);
+	TEST_ASSERT_NOT_NULL(mp_params.b, "Failed to create reorder buffer");
+
+	rte_eal_mp_remote_launch(test_reorder_mp_worker, NULL, SKIP_MAIN);
+
+	while (rte_atomic_load_explicit(&mp_params.nb_workers_done,
+			rte_memory_order_acquire) != nb_workers) {
+		cnt = rte_reorder_drain(mp_params.b, robufs, BURST);
+		nb_drained += cnt;
+		if (test_reorder_mp_drain(robufs, cnt, &next_seqn) != 0)
+			ret = -1;
+	}
+	rte_eal_mp_wait_lcore();
+
+	do {
+		cnt = rte_reorder_drain_up_to_seqn(mp_params.b, robufs, BURST,
+				MP_NUM_PKTS);
+		nb_drained += cnt;
+		if (test_reorder_mp_drain(robufs, cnt, &next_seqn) != 0)
+			ret = -1;
+	} while (cnt != 0);
+
+	printf("%u packets reordered by %u workers, %u late, window %u\n",
+		nb_drained, nb_workers, mp_params.nb_late,
+		rte_reorder_window_get(mp_params.b));
+
+	rte_reorder_free(mp_params.b);
+
+	TEST_ASSERT_SUCCESS(ret, "Packets drained out of order");
+	TEST_ASSERT_EQUAL(mp_params.nb_errors, 0, "Packet allocation failed");
+	TEST_ASSERT_EQUAL(nb_drained + mp_params.nb_late, MP_NUM_PKTS,
+			"Packets lost by reorder buffer");
+
+	return 0;
+}
+
 static int
 test_setup(void)
 {
@@ -537,6 +919,9 @@ static struct unit_test_suite reorder_test_suite  = {
 		TEST_CASE(test_reorder_drain),
 		TEST_CASE(test_reorder_drain_up_to_seqn),
 		TEST_CASE(test_reorder_set_seqn),
+		TEST_CASE(test_reorder_adaptive_window),
+		TEST_CASE(test_reorder_mp_insert),
+		TEST_CASE(test_reorder_mp_lcores),
 		TEST_CASES_END()
 	}
 };
@@ -7,6 +7,10 @@
 #include <rte_ip.h>
 #include <rte_random.h>
 #include <rte_malloc.h>
+#include <rte_mbuf.h>
+#include <rte_ether.h>
+#include <rte_udp.h>
+#include <rte_vect.h>
 
 #include "test.h"
 
@@ -935,6 +939,300 @@ test_adjust_tuple_mult_reta(void)
 	return TEST_SUCCESS;
 }
 
+#define SOFTRSS_NB_MBUF	256
+#define SOFTRSS_NB_RAND	100
+
+static const enum rte_thash_softrss_alg softrss_algs[] = {
+	RTE_THASH_SOFTRSS_SCALAR,
+	RTE_THASH_SOFTRSS_CLMUL,
+	RTE_THASH_SOFTRSS_GFNI,
+};
+
+/* Build an UDP packet, addresses and ports are in network byte order */
+static struct rte_mbuf *
+softrss_build_pkt(struct rte_mempool *mp, const uint8_t *src,
+	const uint8_t *dst, uint32_t addr_len, uint16_t sport, uint16_t dport,
+	uint32_t nb_vlan, int frag)
+{
+	struct rte_mbuf *m;
+	struct rte_ether_hdr *eth;
+	struct rte_vlan_hdr *vlan;
+	struct rte_ipv4_hdr *ipv4;
+	struct rte_ipv6_hdr *ipv6;
+	struct rte_udp_hdr *udp;
+	uint16_t *proto;
+	uint32_t i, l3_len, len;
+	char *hdr;
+
+	l3_len = (addr_len == sizeof(ipv4->src_addr)) ? sizeof(*ipv4) :
+		sizeof(*ipv6);
+	len = sizeof(*eth) + nb_vlan * sizeof(*vlan) + l3_len + sizeof(*udp);
+
+	m = rte_pktmbuf_alloc(mp);
+	if (m == NULL)
+		return NULL;
+	hdr = rte_pktmbuf_append(m, len);
+	if (hdr == NULL) {
+		rte_pktmbuf_free(m);
+		return NULL;
+	}
+	memset(hdr, 0, len);
+
+	eth = (struct rte_ether_hdr *)hdr;
+	proto = &eth->ether_type;
+	hdr += sizeof(*eth);
+	for (i = 0; i < nb_vlan; i++) {
+		*proto = rte_cpu_to_be_16(i == 0 ? RTE_ETHER_TYPE_QINQ :
+			RTE_ETHER_TYPE_VLAN);
+		vlan = (struct rte_vlan_hdr *)hdr;
+		vlan->vlan_tci = rte_cpu_to_be_16(i + 1);
+		proto = &vlan->eth_proto;
+		hdr += sizeof(*vlan);
+	}
+
+	if (l3_len == sizeof(*ipv4)) {
+		*proto = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
+		ipv4 = (struct rte_ipv4_hdr *)hdr;
+		ipv4->version_ihl = RTE_IPV4_VHL_DEF;
+		ipv4->next_proto_id = IPPROTO_UDP;
+		ipv4->fragment_offset = frag ?
+			rte_cpu_to_be_16(RTE_IPV4_HDR_MF_FLAG) : 0;
+		memcpy(&ipv4->src_addr, src, addr_len);
+		memcpy(&ipv4->dst_addr, dst, addr_len);
+	} else {
+		*proto = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+		ipv6 = (struct rte_ipv6_hdr *)hdr;
+		ipv6->vtc_flow = rte_cpu_to_be_32(0x60000000);
+		ipv6->proto = IPPROTO_UDP;
+		memcpy(ipv6->src_addr, src, addr_len);
+		memcpy(ipv6->dst_addr, dst, addr_len);
+	}
+	hdr += l3_len;
+
+	udp = (struct rte_udp_hdr *)hdr;
+	udp->src_port = sport;
+	udp->dst_port = dport;
+
+	return m;
+}
+
+static int
+softrss_check_tbl(struct rte_mempool *mp, enum rte_thash_softrss_alg alg,
+	uint32_t flags)
+{
+	struct rte_thash_softrss *ctx;
+	struct rte_ether_hdr *eth;
+	struct rte_mbuf *pkts[RTE_DIM(v4_tbl) + RTE_DIM(v6_tbl) + 3] = { 0 };
+	uint32_t expected[RTE_DIM(pkts)];
+	uint32_t i, n = 0, src, dst;
+	uint16_t sport, dport, nb;
+	int ret = -TEST_FAILED;
+
+	ctx = rte_thash_softrss_create(default_rss_key,
+		RTE_DIM(default_rss_key), flags, SOCKET_ID_ANY);
+	RTE_TEST_ASSERT_NOT_NULL(ctx, "Can not create softrss context");
+
+	if (rte_thash_softrss_set_alg(ctx, alg) != 0) {
+		rte_thash_softrss_free(ctx);
+		return TEST_SKIPPED;
+	}
+
+	for (i = 0; i < RTE_DIM(v4_tbl); i++) {
+		src = rte_cpu_to_be_32(v4_tbl[i].src_ip);
+		dst = rte_cpu_to_be_32(v4_tbl[i].dst_ip);
+		sport = rte_cpu_to_be_16(v4_tbl[i].src_port);
+		dport = rte_cpu_to_be_16(v4_tbl[i].dst_port);
+		expected[n] = (flags & RTE_THASH_SOFTRSS_L4) ?
+			v4_tbl[i].hash_l3l4 : v4_tbl[i].hash_l3;
+		pkts[n++] = softrss_build_pkt(mp, (uint8_t *)&src,
+			(uint8_t *)&dst, sizeof(src), sport, dport, i % 3, 0);
+	}
+	for (i = 0; i < RTE_DIM(v6_tbl); i++) {
+		expected[n] = (flags & RTE_THASH_SOFTRSS_L4) ?
+			v6_tbl[i].hash_l3l4 : v6_tbl[i].hash_l3;
+		pkts[n++] = softrss_build_pkt(mp, v6_tbl[i].src_ip,
+			v6_tbl[i].dst_ip, sizeof(v6_tbl[i].src_ip),
+			rte_cpu_to_be_16(v6_tbl[i].src_port),
+			rte_cpu_to_be_16(v6_tbl[i].dst_port), i % 3, 0);
+	}
+
+	/* ports of fragments are never hashed */
+	src = rte_cpu_to_be_32(v4_tbl[0].src_ip);
+	dst = rte_cpu_to_be_32(v4_tbl[0].dst_ip);
+	expected[n] = v4_tbl[0].hash_l3;
+	pkts[n++] = softrss_build_pkt(mp, (uint8_t *)&src, (uint8_t *)&dst,
+		sizeof(src), rte_cpu_to_be_16(v4_tbl[0].src_port),
+		rte_cpu_to_be_16(v4_tbl[0].dst_port), 1, 1);
+
+	/* headers truncated before the ports */
+	expected[n] = v4_tbl[1].hash_l3;
+	src = rte_cpu_to_be_32(v4_tbl[1].src_ip);
+	dst = rte_cpu_to_be_32(v4_tbl[1].dst_ip);
+	pkts[n] = softrss_build_pkt(mp, (uint8_t *)&src, (uint8_t *)&dst,
+		sizeof(src), 0, 0, 0, 0);
+	if (pkts[n] != NULL)
+		rte_pktmbuf_trim(pkts[n], sizeof(struct rte_udp_hdr));
+	n++;
+
+	/* not an IP packet */
+	pkts[n] = rte_pktmbuf_alloc(mp);
+	if (pkts[n] != NULL) {
+		eth = (struct rte_ether_hdr *)rte_pktmbuf_append(pkts[n],
+			RTE_ETHER_MIN_LEN);
+		if (eth != NULL) {
+			memset(eth, 0, RTE_ETHER_MIN_LEN);
+			eth->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_ARP);
+		} else {
+			rte_pktmbuf_free(pkts[n]);
+			pkts[n] = NULL;
+		}
+	}
+	n++;
+
+	for (i = 0; i < n; i++) {
+		if (pkts[i] == NULL) {
+			printf("Can not allocate packet\n");
+			goto out;
+		}
+	}
+
+	nb = rte_thash_softrss_bulk(ctx, pkts, n);
+	if (nb != n - 1) {
+		printf("alg %d: %u packets hashed, expected %u\n",
+			alg, nb, n - 1);
+		goto out;
+	}
+	for (i = 0; i < n - 1; i++) {
+		if (!(pkts[i]->ol_flags & RTE_MBUF_F_RX_RSS_HASH) ||
+				(pkts[i]->hash.rss != expected[i])) {
+			printf("alg %d: wrong hash 0x%08x for packet %u, "
+				"expected 0x%08x\n", alg, pkts[i]->hash.rss,
+				i, expected[i]);
+			goto out;
+		}
+	}
+	if (pkts[n - 1]->ol_flags & RTE_MBUF_F_RX_RSS_HASH) {
+		printf("alg %d: non IP packet hashed\n", alg);
+		goto out;
+	}
+
+	ret = TEST_SUCCESS;
+out:
+	rte_pktmbuf_free_bulk(pkts, n);
+	rte_thash_softrss_free(ctx);
+	return ret;
+}
+
+static int
+test_softrss_bulk(void)
+{
+	struct rte_mempool *mp;
+	uint16_t simd_bitwidth = rte_vect_get_max_simd_bitwidth();
+	uint32_t i, nb_run = 0;
+	int ret = TEST_SUCCESS;
+
+	RTE_TEST_ASSERT_NULL(rte_thash_softrss_create(NULL,
+		RTE_DIM(default_rss_key), 0, SOCKET_ID_ANY),
+		"Call succeeded with invalid parameters\n");
+	RTE_TEST_ASSERT_NULL(rte_thash_softrss_create(default_rss_key,
+		RTE_THASH_SOFTRSS_KEY_LEN_MIN - 1, 0, SOCKET_ID_ANY),
+		"Call succeeded with invalid parameters\n");
+	RTE_TEST_ASSERT_NULL(rte_thash_softrss_create(default_rss_key,
+		RTE_DIM(default_rss_key), ~RTE_THASH_SOFTRSS_L4, SOCKET_ID_ANY),
+		"Call succeeded with invalid parameters\n");
+
+	mp = rte_pktmbuf_pool_create("softrss_pool", SOFTRSS_NB_MBUF, 0, 0,
+		RTE_MBUF_DEFAULT_BUF_SIZE, SOCKET_ID_ANY);
+	RTE_TEST_ASSERT_NOT_NULL(mp, "Can not create mbuf pool");
+
+	/* let the 512-bit implementation be selected if the CPU allows it */
+	rte_vect_set_max_simd_bitwidth(RTE_VECT_SIMD_512);
+
+	for (i = 0; i < RTE_DIM(softrss_algs) && ret != -TEST_FAILED; i++) {
+		ret = softrss_check_tbl(mp, softrss_algs[i], 0);
+		if (ret == TEST_SUCCESS)
+			ret = softrss_check_tbl(mp, softrss_algs[i],
+				RTE_THASH_SOFTRSS_L4);
+		if (ret == TEST_SUCCESS)
+			nb_run++;
+	}
+	printf("%s: %u implementations tested\n", __func__, nb_run);
+
+	rte_vect_set_max_simd_bitwidth(simd_bitwidth);
+	rte_mempool_free(mp);
+
+	return (ret == -TEST_FAILED || nb_run == 0) ? -TEST_FAILED :
+		TEST_SUCCESS;
+}
+
+static int
+test_softrss_bulk_rand(void)
+{
+	struct rte_mempool *mp;
+	struct rte_thash_softrss *ctx;
+	struct rte_mbuf *pkts[SOFTRSS_NB_RAND] = { 0 };
+	uint32_t ref[SOFTRSS_NB_RAND];
+	uint16_t simd_bitwidth = rte_vect_get_max_simd_bitwidth();
+	uint8_t src[16], dst[16];
+	uint32_t i, j, addr_len;
+	int ret = -TEST_FAILED;
+
+	mp = rte_pktmbuf_pool_create("softrss_pool", SOFTRSS_NB_MBUF, 0, 0,
+		RTE_MBUF_DEFAULT_BUF_SIZE, SOCKET_ID_ANY);
+	RTE_TEST_ASSERT_NOT_NULL(mp, "Can not create mbuf pool");
+
+	ctx = rte_thash_softrss_create(big_rss_key, RTE_DIM(big_rss_key),
+		RTE_THASH_SOFTRSS_L4, SOCKET_ID_ANY);
+	if (ctx == NULL)
+		goto out;
+
+	/* mix of address families, tags and fragments in every window */
+	for (i = 0; i < RTE_DIM(pkts); i++) {
+		for (j = 0; j < RTE_DIM(src); j++) {
+			src[j] = rte_rand();
+			dst[j] = rte_rand();
+		}
+		addr_len = (rte_rand() & 1) ? 16 : 4;
+		pkts[i] = softrss_build_pkt(mp, src, dst, addr_len, rte_rand(),
+			rte_rand(), rte_rand_max(3), rte_rand_max(4) == 0);
+		if (pkts[i] == NULL)
+			goto out;
+	}
+
+	rte_vect_set_max_simd_bitwidth(RTE_VECT_SIMD_512);
+
+	for (i = 0; i < RTE_DIM(softrss_algs); i++) {
+		if (rte_thash_softrss_set_alg(ctx, softrss_algs[i]) != 0)
+			continue;
+		for (j = 0; j < RTE_DIM(pkts); j++)
+			pkts[j]->ol_flags = 0;
+		if (rte_thash_softrss_bulk(ctx, pkts, RTE_DIM(pkts)) !=
+				RTE_DIM(pkts)) {
+			printf("alg %d: not all packets hashed\n",
+				softrss_algs[i]);
+			goto out;
+		}
+		for (j = 0; j < RTE_DIM(pkts); j++) {
+			if (softrss_algs[i] == RTE_THASH_SOFTRSS_SCALAR)
+				ref[j] = pkts[j]->hash.rss;
+			else if (pkts[j]->hash.rss != ref[j]) {
+				printf("alg %d: hash mismatch for packet %u\n",
+					softrss_algs[i], j);
+				goto out;
+			}
+		}
+	}
+
+	ret = TEST_SUCCESS;
+out:
+	rte_vect_set_max_simd_bitwidth(simd_bitwidth);
+	for (i = 0; i < RTE_DIM(pkts); i++)
+		rte_pktmbuf_free(pkts[i]);
+	rte_thash_softrss_free(ctx);
+	rte_mempool_free(mp);
+	return ret;
+}
+
 static struct unit_test_suite thash_tests = {
 	.suite_name = "thash autotest",
 	.setup = NULL,
@@ -956,6 +1254,8 @@ static struct unit_test_suite thash_tests = {
 	TEST_CASE(test_predictable_rss_multirange),
 	TEST_CASE(test_adjust_tuple),
 	TEST_CASE(test_adjust_tuple_mult_reta),
+	TEST_CASE(test_softrss_bulk),
+	TEST_CASE(test_softrss_bulk_rand),
 	TEST_CASES_END()
 	}
 };
@@ -8,9 +8,13 @@
 #include <math.h>
 
 #include <rte_cycles.h>
+#include <rte_ether.h>
 #include <rte_malloc.h>
+#include <rte_mbuf.h>
 #include <rte_random.h>
 #include <rte_thash.h>
+#include <rte_udp.h>
+#include <rte_vect.h>
 
 #include "test.h"
 
@@ -124,6 +128,122 @@ run_thash_test(unsigned int tuple_len)
 		(double)(tsc_diff) / (double)(ITERATIONS * BATCH_SZ), len);
 }
 
+#define SOFTRSS_NB_PKTS		256
+#define SOFTRSS_BURST		32
+#define SOFTRSS_ITERATIONS	(1 << 12)
+
+static const char * const softrss_alg_names[] = {
+	[RTE_THASH_SOFTRSS_SCALAR] = "scalar",
+	[RTE_THASH_SOFTRSS_CLMUL] = "clmul",
+	[RTE_THASH_SOFTRSS_GFNI] = "gfni",
+};
+
+/* Fill the packets with random IPv4 or IPv6 UDP headers */
+static int
+softrss_fill_pkts(struct rte_mbuf **pkts, int ipv6)
+{
+	struct rte_ether_hdr *eth;
+	struct rte_ipv4_hdr *ipv4;
+	struct rte_ipv6_hdr *ipv6_hdr;
+	struct rte_udp_hdr *udp;
+	uint32_t i, j, l3_len, len;
+	char *hdr;
+
+	l3_len = ipv6 ? sizeof(*ipv6_hdr) : sizeof(*ipv4);
+	len = sizeof(*eth) + l3_len + sizeof(*udp);
+
+	for (i = 0; i < SOFTRSS_NB_PKTS; i++) {
+		rte_pktmbuf_reset(pkts[i]);
+		hdr = rte_pktmbuf_append(pkts[i], len);
+		if (hdr == NULL)
+			return -1;
+		memset(hdr, 0, len);
+		eth = (struct rte_ether_hdr *)hdr;
+		if (ipv6) {
+			eth->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6);
+			ipv6_hdr = (struct rte_ipv6_hdr *)(eth + 1);
+			ipv6_hdr->proto = IPPROTO_UDP;
+			for (j = 0; j < sizeof(ipv6_hdr->src_addr); j++) {
+				ipv6_hdr->src_addr[j] = rte_rand();
+				ipv6_hdr->dst_addr[j] = rte_rand();
+			}
+		} else {
+			eth->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
+			ipv4 = (struct rte_ipv4_hdr *)(eth + 1);
+			ipv4->version_ihl = RTE_IPV4_VHL_DEF;
+			ipv4->next_proto_id = IPPROTO_UDP;
+			ipv4->src_addr = rte_rand();
+			ipv4->dst_addr = rte_rand();
+		}
+		udp = (struct rte_udp_hdr *)(hdr + sizeof(*eth) + l3_len);
+		udp->src_port = rte_rand();
+		udp->dst_port = rte_rand();
+	}
+
+	return 0;
+}
+
+static void
+run_softrss_bulk_test(struct rte_mbuf **pkts, int ipv6)
+{
+	struct rte_thash_softrss *ctx;
+	uint64_t start_tsc, end_tsc;
+	unsigned int alg, i, j;
+
+	ctx = rte_thash_softrss_create(default_rss_key,
+		RTE_DIM(default_rss_key), RTE_THASH_SOFTRSS_L4, SOCKET_ID_ANY);
+	if (ctx == NULL || softrss_fill_pkts(pkts, ipv6) != 0) {
+		printf("Can not prepare softrss test\n");
+		rte_thash_softrss_free(ctx);
+		return;
+	}
+
+	for (alg = 0; alg < RTE_DIM(softrss_alg_names); alg++) {
+		if (rte_thash_softrss_set_alg(ctx, alg) != 0)
+			continue;
+
+		start_tsc = rte_rdtsc_precise();
+		for (i = 0; i < SOFTRSS_ITERATIONS; i++)
+			for (j = 0; j < SOFTRSS_NB_PKTS; j += SOFTRSS_BURST)
+				rte_thash_softrss_bulk(ctx, &pkts[j],
+					SOFTRSS_BURST);
+		end_tsc = rte_rdtsc_precise();
+
+		printf("Average rte_thash_softrss_bulk (%s) takes \t%.1f "
+			"cycles per %s packet\n", softrss_alg_names[alg],
+			(double)(end_tsc - start_tsc) /
+			(double)(SOFTRSS_ITERATIONS * SOFTRSS_NB_PKTS),
+			ipv6 ? "IPv6" : "IPv4");
+	}
+
+	rte_thash_softrss_free(ctx);
+}
+
+static void
+run_softrss_test(void)
+{
+	struct rte_mempool *mp;
+	struct rte_mbuf *pkts[SOFTRSS_NB_PKTS];
+	uint16_t simd_bitwidth = rte_vect_get_max_simd_bitwidth();
+
+	mp = rte_pktmbuf_pool_create("softrss_perf_pool", SOFTRSS_NB_PKTS, 0,
+		0, RTE_MBUF_DEFAULT_BUF_SIZE, SOCKET_ID_ANY);
+	if (mp == NULL)
+		return;
+	if (rte_pktmbuf_alloc_bulk(mp, pkts, SOFTRSS_NB_PKTS) != 0) {
+		rte_mempool_free(mp);
+		return;
+	}
+
+	rte_vect_set_max_simd_bitwidth(RTE_VECT_SIMD_512);
+	run_softrss_bulk_test(pkts, 0);
+	run_softrss_bulk_test(pkts, 1);
+	rte_vect_set_max_simd_bitwidth(simd_bitwidth);
+
+	rte_pktmbuf_free_bulk(pkts, SOFTRSS_NB_PKTS);
+	rte_mempool_free(mp);
+}
+
 static int
 test_thash_perf(void)
 {
@@ -131,6 +251,7 @@ test_thash_perf(void)
 	run_thash_test(IPV4_4_TUPLE_LEN);
 	run_thash_test(IPV6_2_TUPLE_LEN);
 	run_thash_test(IPV6_4_TUPLE_LEN);
+	run_softrss_test();
 
 	return 0;
 }
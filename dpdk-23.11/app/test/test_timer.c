@@ -490,6 +490,135 @@ timer_basic_main_loop(__rte_unused void *arg)
 	return 0;
 }
 
+#define WHEEL_NB_TIMER 1024
+
+struct wheel_timer_info {
+	struct rte_timer tim;
+	unsigned int count;
+	int expected;   /* callback runs expected, -1 for periodic */
+};
+
+static struct wheel_timer_info wheel_tims[WHEEL_NB_TIMER + 2];
+static unsigned int wheel_early;
+
+static void
+timer_wheel_cb(struct rte_timer *tim)
+{
+	struct wheel_timer_info *info =
+		container_of(tim, struct wheel_timer_info, tim);
+
+	if (rte_get_timer_cycles() < tim->expire)
+		wheel_early++;
+	info->count++;
+}
+
+static void
+timer_wheel_stop_cb(struct rte_timer *tim, void *arg)
+{
+	unsigned int *nb_stopped = arg;
+
+	RTE_SET_USED(tim);
+	(*nb_stopped)++;
+}
+
+static int
+test_timer_wheel(void)
+{
+	struct rte_timer_data_conf conf = {
+		.backend = RTE_TIMER_BACKEND_WHEEL,
+		/* 10 us slots, levels span 2.56 ms, 655 ms and 168 s */
+		.wheel_resolution = rte_get_timer_hz() / 100000,
+	};
+	struct wheel_timer_info *periodic = &wheel_tims[WHEEL_NB_TIMER];
+	struct wheel_timer_info *far = &wheel_tims[WHEEL_NB_TIMER + 1];
+	unsigned int lcore_id = rte_lcore_id();
+	uint64_t hz = rte_get_timer_hz();
+	uint64_t deadline;
+	unsigned int i, nb_stopped = 0, nb_done;
+	uint32_t id;
+	int ret = TEST_FAILED;
+
+	conf.backend = (enum rte_timer_backend)-1;
+	if (rte_timer_data_alloc_conf(&id, &conf) != -EINVAL) {
+		printf("Invalid timer data configuration accepted\n");
+		return TEST_FAILED;
+	}
+	conf.backend = RTE_TIMER_BACKEND_WHEEL;
+	if (rte_timer_data_alloc_conf(&id, &conf) != 0) {
+		printf("Cannot allocate timer data with a wheel\n");
+		return TEST_FAILED;
+	}
+
+	memset(wheel_tims, 0, sizeof(wheel_tims));
+	wheel_early = 0;
+	for (i = 0; i < RTE_DIM(wheel_tims); i++)
+		rte_timer_init(&wheel_tims[i].tim);
+
+	/* up to 300 ms, so that all levels up to the third are used */
+	for (i = 0; i < WHEEL_NB_TIMER; i++) {
+		wheel_tims[i].expected = 1;
+		rte_timer_alt_reset(id, &wheel_tims[i].tim,
+			rte_rand_max(hz * 3 / 10), SINGLE, lcore_id, NULL,
+			NULL);
+	}
+	rte_timer_alt_reset(id, &periodic->tim, hz / 1000, PERIODICAL,
+		lcore_id, NULL, NULL);
+	periodic->expected = -1;
+	/* a year, beyond the wheel span */
+	rte_timer_alt_reset(id, &far->tim, hz * 3600 * 24 * 365, SINGLE,
+		lcore_id, NULL, NULL);
+
+	for (i = 0; i < WHEEL_NB_TIMER; i += 4) {
+		if (rte_timer_alt_stop(id, &wheel_tims[i].tim) != 0)
+			goto out;
+		wheel_tims[i].expected = 0;
+		rte_timer_alt_reset(id, &wheel_tims[i + 1].tim,
+			rte_rand_max(hz / 10), SINGLE, lcore_id, NULL, NULL);
+	}
+
+	deadline = rte_get_timer_cycles() + 2 * hz;
+	do {
+		rte_timer_alt_manage(id, NULL, 0, timer_wheel_cb);
+		nb_done = 0;
+		for (i = 0; i < WHEEL_NB_TIMER; i++)
+			nb_done += !rte_timer_pending(&wheel_tims[i].tim);
+	} while (nb_done != WHEEL_NB_TIMER &&
+			rte_get_timer_cycles() < deadline);
+
+	for (i = 0; i < WHEEL_NB_TIMER; i++) {
+		if (wheel_tims[i].count != (unsigned int)wheel_tims[i].expected) {
+			printf("Wheel timer %u ran %u times, expected %d\n", i,
+				wheel_tims[i].count, wheel_tims[i].expected);
+			goto out;
+		}
+	}
+	if (wheel_early != 0) {
+		printf("%u wheel timers ran before their expiry time\n",
+			wheel_early);
+		goto out;
+	}
+	if (periodic->count < 10 || far->count != 0 ||
+			!rte_timer_pending(&far->tim)) {
+		printf("Wheel periodic timer ran %u times, far timer %u times\n",
+			periodic->count, far->count);
+		goto out;
+	}
+
+	rte_timer_stop_all(id, &lcore_id, 1, timer_wheel_stop_cb, &nb_stopped);
+	if (nb_stopped != 2 || rte_timer_pending(&far->tim) ||
+			rte_timer_pending(&periodic->tim)) {
+		printf("Wheel stop all stopped %u timers\n", nb_stopped);
+		goto out;
+	}
+
+	ret = TEST_SUCCESS;
+out:
+	for (i = 0; i < RTE_DIM(wheel_tims); i++)
+		rte_timer_alt_stop(id, &wheel_tims[i].tim);
+	rte_timer_data_dealloc(id);
+	return ret;
+}
+
 static int
 timer_sanity_check(void)
 {
@@ -534,6 +663,10 @@ test_timer(void)
 	uint64_t cur_time;
 	uint64_t hz;
 
+	printf("Start timer wheel tests\n");
+	if (test_timer_wheel() != TEST_SUCCESS)
+		return TEST_FAILED;
+
 	if (rte_lcore_count() < 2) {
 		printf("Not enough cores for timer_autotest, expecting at least 2\n");
 		return TEST_SKIPPED;
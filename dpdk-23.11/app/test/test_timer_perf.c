@@ -27,12 +27,103 @@ timer_cb(struct rte_timer *t __rte_unused, void *param __rte_unused)
 
 #define DELAY_SECONDS 1
 
+static void
+timer_alt_cb(struct rte_timer *t __rte_unused)
+{
+	outstanding_count--;
+}
+
 #ifdef RTE_EXEC_ENV_LINUX
 #define do_delay() usleep(10)
 #else
 #define do_delay() rte_pause()
 #endif
 
+static void
+print_perf(const char *what, unsigned int n, uint64_t cycles)
+{
+	printf("%-12s %u timers: %"PRIu64" cycles per timer\n", what, n,
+			(cycles + n / 2) / n);
+}
+
+/* compare the skiplist and the wheel with many timers spread over a second */
+static int
+test_timer_perf_backends(void)
+{
+	static const char * const names[] = {
+		[RTE_TIMER_BACKEND_SKIPLIST] = "skiplist",
+		[RTE_TIMER_BACKEND_WHEEL] = "wheel",
+	};
+	struct rte_timer_data_conf conf = { 0 };
+	const uint64_t ticks = rte_get_timer_hz() * DELAY_SECONDS;
+	unsigned int lcore_id = rte_lcore_id();
+	uint64_t start_tsc, end_tsc, delay_start;
+	struct rte_timer *tms;
+	unsigned int i, b;
+	uint32_t id;
+	int ret = 0;
+
+	tms = rte_malloc(NULL, sizeof(*tms) * MAX_ITERATIONS, 0);
+	if (tms == NULL)
+		return -1;
+
+	for (b = 0; b < RTE_DIM(names) && ret == 0; b++) {
+		conf.backend = b;
+		if (rte_timer_data_alloc_conf(&id, &conf) != 0) {
+			printf("Cannot allocate %s timer data\n", names[b]);
+			ret = -1;
+			break;
+		}
+		printf("\nBackend %s\n", names[b]);
+
+		for (i = 0; i < MAX_ITERATIONS; i++)
+			rte_timer_init(&tms[i]);
+
+		start_tsc = rte_rdtsc();
+		for (i = 0; i < MAX_ITERATIONS; i++)
+			rte_timer_alt_reset(id, &tms[i], rte_rand_max(ticks),
+					SINGLE, lcore_id, NULL, NULL);
+		end_tsc = rte_rdtsc();
+		print_perf("Starting", MAX_ITERATIONS, end_tsc - start_tsc);
+
+		/* pending timers pushed back, as done by TCP retransmission */
+		start_tsc = rte_rdtsc();
+		for (i = 0; i < MAX_ITERATIONS; i++)
+			rte_timer_alt_reset(id, &tms[i], rte_rand_max(ticks),
+					SINGLE, lcore_id, NULL, NULL);
+		end_tsc = rte_rdtsc();
+		print_perf("Resetting", MAX_ITERATIONS, end_tsc - start_tsc);
+
+		start_tsc = rte_rdtsc();
+		for (i = 0; i < MAX_ITERATIONS; i += 2)
+			rte_timer_alt_stop(id, &tms[i]);
+		end_tsc = rte_rdtsc();
+		print_perf("Stopping", MAX_ITERATIONS / 2, end_tsc - start_tsc);
+
+		outstanding_count = MAX_ITERATIONS / 2;
+		delay_start = rte_get_timer_cycles();
+		while (rte_get_timer_cycles() < delay_start + ticks)
+			do_delay();
+
+		start_tsc = rte_rdtsc();
+		while (outstanding_count > 0)
+			rte_timer_alt_manage(id, NULL, 0, timer_alt_cb);
+		end_tsc = rte_rdtsc();
+		print_perf("Expiring", MAX_ITERATIONS / 2, end_tsc - start_tsc);
+
+		if (outstanding_count != 0) {
+			printf("Error: outstanding callback count = %d\n",
+					outstanding_count);
+			ret = -1;
+		}
+
+		rte_timer_data_dealloc(id);
+	}
+
+	rte_free(tms);
+	return ret;
+}
+
 static int
 test_timer_perf(void)
 {
@@ -128,7 +219,8 @@ test_timer_perf(void)
 			(end_tsc - start_tsc + iterations/2) / iterations);
 
 	rte_free(tms);
-	return 0;
+
+	return test_timer_perf_backends();
 }
 
 REGISTER_PERF_TEST(timer_perf_autotest, test_timer_perf);
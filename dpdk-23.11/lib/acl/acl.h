@@ -101,6 +101,15 @@ struct rte_acl_match_results {
 	int32_t priority[RTE_ACL_MAX_CATEGORIES];
 };
 
+/*
+ * Hit counter of a rule, along with its userdata
+ * so that classify touches a single cache line per match.
+ */
+struct rte_acl_rule_cnt {
+	uint64_t hits;
+	uint32_t userdata;
+} __rte_aligned(16);
+
 struct rte_acl_node {
 	uint64_t node_index;  /* index for this node */
 	uint32_t level;       /* level 0-n in the trie */
@@ -174,6 +183,17 @@ struct rte_acl_ctx {
 	uint32_t            max_rules;
 	uint32_t            rule_sz;
 	uint32_t            num_rules;
+	uint32_t            cnt_enabled; /* count rule hits on next build. */
+	/*
+	 * When counting rule hits, match results hold the rule index + 1,
+	 * translated back to the rule userdata after classify.
+	 * Kept out of the fields cleared by a build: they are set and
+	 * cleared with the tailq lock held, for the telemetry readers.
+	 */
+	uint32_t            cnt_num;      /* number of rules + 1. */
+	void               *cnt_mem;
+	struct rte_acl_rule_cnt *cnt[RTE_MAX_LCORE + 1];
+	/* by rule index + 1, per lcore, last one shared by others. */
 	uint32_t            num_categories;
 	uint32_t            num_tries;
 	uint32_t            match_index;
@@ -217,6 +237,14 @@ int
 rte_acl_classify_avx512x32(const struct rte_acl_ctx *ctx, const uint8_t **data,
 	uint32_t *results, uint32_t num, uint32_t categories);
 
+/*
+ * Account rule hits and translate the results of a counting context,
+ * returns the number of results processed.
+ */
+uint32_t
+rte_acl_count_avx2(struct rte_acl_rule_cnt *cnt, uint32_t *results,
+	uint32_t num);
+
 int
 rte_acl_classify_neon(const struct rte_acl_ctx *ctx, const uint8_t **data,
 	uint32_t *results, uint32_t num, uint32_t categories);
@@ -3,6 +3,7 @@
  */
 
 #include <rte_acl.h>
+#include <rte_eal_memconfig.h>
 #include "tb_mem.h"
 #include "acl.h"
 
@@ -19,6 +20,14 @@
 #define NODE_MAX	0x4000
 #define NODE_MIN	0x800
 
+/*
+ * When the RT structures exceed max_size, rule sets at least that big are
+ * partitioned by shape in up to ACL_PART_MAX sets, before building the tries.
+ */
+#define ACL_PART_MIN_RULES	0x400
+#define ACL_PART_MAX		(RTE_ACL_MAX_TRIES / 2)
+#define ACL_PART_CLASS_MAX	64
+
 /* TALLY are statistics per field */
 enum {
 	TALLY_0 = 0,        /* number of rules that are 0% or more wild. */
@@ -80,6 +89,7 @@ struct acl_build_context {
 	uint32_t                  src_mask;
 	uint32_t                  num_build_rules;
 	uint32_t                  num_tries;
+	uint32_t                  num_parts;
 	struct tb_mem_pool        pool;
 	struct rte_acl_trie       tries[RTE_ACL_MAX_TRIES];
 	struct rte_acl_bld_trie   bld_tries[RTE_ACL_MAX_TRIES];
@@ -772,10 +782,33 @@ acl_merge_trie(struct acl_build_context *context,
  *  - free allocated RT memory.
  *  - reset all RT related fields to zero.
  */
+/*
+ * Detach the rule hit counters with the tailq lock held, so that the
+ * telemetry handlers never read them while they are freed.
+ */
+static void
+acl_cnt_free(struct rte_acl_ctx *ctx)
+{
+	void *mem;
+
+	if (ctx->cnt_mem == NULL)
+		return;
+
+	rte_mcfg_tailq_write_lock();
+	mem = ctx->cnt_mem;
+	ctx->cnt_mem = NULL;
+	ctx->cnt_num = 0;
+	memset(ctx->cnt, 0, sizeof(ctx->cnt));
+	rte_mcfg_tailq_write_unlock();
+
+	rte_free(mem);
+}
+
 static void
 acl_build_reset(struct rte_acl_ctx *ctx)
 {
 	rte_free(ctx->mem);
+	acl_cnt_free(ctx);
 	memset(&ctx->num_categories, 0,
 		sizeof(*ctx) - offsetof(struct rte_acl_ctx, num_categories));
 }
@@ -945,7 +978,7 @@ static struct rte_acl_node *
 build_trie(struct acl_build_context *context, struct rte_acl_build_rule *head,
 	struct rte_acl_build_rule **last, uint32_t *count)
 {
-	uint32_t n, m;
+	uint32_t n, m, res;
 	int field_index, node_count;
 	struct rte_acl_node *trie;
 	struct rte_acl_build_rule *prev, *rule;
@@ -1038,9 +1071,16 @@ build_trie(struct acl_build_context *context, struct rte_acl_build_rule *head,
 			end->mrt = acl_build_alloc(context, 1,
 				sizeof(*end->mrt));
 
+		/* when counting hits, the result is the rule index + 1 */
+		res = rule->f->data.userdata;
+		if (context->acx->cnt_enabled != 0)
+			res = ((uintptr_t)rule->f -
+				(uintptr_t)context->acx->rules) /
+				context->acx->rule_sz + 1;
+
 		for (m = context->cfg.num_categories; 0 != m--; ) {
 			if (rule->f->data.category_mask & (1U << m)) {
-				end->mrt->results[m] = rule->f->data.userdata;
+				end->mrt->results[m] = res;
 				end->mrt->priority[m] = rule->f->data.priority;
 			} else {
 				end->mrt->results[m] = 0;
@@ -1313,6 +1353,133 @@ acl_build_index(const struct rte_acl_config *config, uint32_t *data_index)
 	return m;
 }
 
+/*
+ * Get the shape of a rule: the mask of its fields which are mostly wild.
+ */
+static uint64_t
+acl_rule_shape(const struct rte_acl_build_rule *rule,
+	const struct rte_acl_config *config)
+{
+	uint32_t n;
+	uint64_t shape;
+
+	shape = 0;
+	for (n = 0; n != config->num_fields; n++) {
+		if (rule->wildness[config->defs[n].field_index] >=
+				wild_limits[TALLY_50])
+			shape |= RTE_BIT64(n);
+	}
+
+	return shape;
+}
+
+/*
+ * Cost of moving the rules of a class to a set of another shape:
+ * the number of their fields no more mostly wild in the set.
+ */
+static uint64_t
+acl_part_cost(uint64_t shape, uint32_t num, uint64_t merged)
+{
+	return (uint64_t)num * rte_popcount64(shape & ~merged);
+}
+
+/*
+ * Partition a big rule set, in a TupleMerge fashion: rules are first
+ * grouped by their shape, then the closest groups are merged until there
+ * are at most num_parts of them. Rules narrow in different fields, which
+ * multiply each other nodes, are so built in different tries.
+ * Returns the number of rule sets.
+ */
+static uint32_t
+acl_part_rules(struct acl_build_context *context,
+	struct rte_acl_build_rule *head,
+	struct rte_acl_build_rule *rule_sets[RTE_ACL_MAX_TRIES])
+{
+	uint32_t i, j, k, mi, mj, num;
+	uint64_t c, mc, w, shape[ACL_PART_CLASS_MAX];
+	uint32_t cnt[ACL_PART_CLASS_MAX];
+	struct rte_acl_build_rule *next, *rule;
+	struct rte_acl_build_rule *list[ACL_PART_CLASS_MAX];
+	struct rte_acl_config *config;
+
+	rule_sets[0] = head;
+	if (context->num_parts < 2)
+		return 1;
+
+	num = 0;
+	for (rule = head; rule != NULL; rule = next) {
+		next = rule->next;
+		w = acl_rule_shape(rule, &context->cfg);
+
+		for (k = 0; k != num && shape[k] != w; k++)
+			;
+
+		/* too many classes, join the closest one */
+		if (k == RTE_DIM(shape)) {
+			for (i = 0, k = 0; i != num; i++) {
+				if (rte_popcount64(shape[i] & w) >
+						rte_popcount64(shape[k] & w))
+					k = i;
+			}
+			shape[k] &= w;
+		} else if (k == num) {
+			shape[k] = w;
+			cnt[k] = 0;
+			list[k] = NULL;
+			num++;
+		}
+
+		rule->next = list[k];
+		list[k] = rule;
+		cnt[k]++;
+	}
+
+	/* merge the classes costing the least, until few enough remain */
+	while (num > context->num_parts) {
+		mc = UINT64_MAX;
+		mi = 0;
+		mj = 1;
+		for (i = 0; i != num; i++) {
+			for (j = i + 1; j != num; j++) {
+				w = shape[i] & shape[j];
+				c = acl_part_cost(shape[i], cnt[i], w) +
+					acl_part_cost(shape[j], cnt[j], w);
+				if (c < mc || (c == mc &&
+						cnt[i] + cnt[j] <
+						cnt[mi] + cnt[mj])) {
+					mc = c;
+					mi = i;
+					mj = j;
+				}
+			}
+		}
+
+		for (rule = list[mj]; rule->next != NULL; rule = rule->next)
+			;
+		rule->next = list[mi];
+		list[mi] = list[mj];
+		cnt[mi] += cnt[mj];
+		shape[mi] &= shape[mj];
+
+		num--;
+		list[mj] = list[num];
+		cnt[mj] = cnt[num];
+		shape[mj] = shape[num];
+	}
+
+	/* each set gets its own config, as fields are dropped per trie */
+	for (k = 0; k != num; k++) {
+		config = acl_build_alloc(context, 1, sizeof(*config));
+		memcpy(config, &context->cfg, sizeof(*config));
+		for (rule = list[k]; rule != NULL; rule = rule->next)
+			rule->config = config;
+		rule_sets[k] = list[k];
+	}
+
+	context->num_parts = num;
+	return num;
+}
+
 static struct rte_acl_build_rule *
 build_one_trie(struct acl_build_context *context,
 	struct rte_acl_build_rule *rule_sets[RTE_ACL_MAX_TRIES],
@@ -1365,9 +1532,10 @@ acl_build_tries(struct acl_build_context *context,
 	/* calc wildness of each field of each rule */
 	acl_calc_wildness(head, config);
 
-	for (n = 0;; n = num_tries) {
+	/* partition big rule sets */
+	num_tries = acl_part_rules(context, head, rule_sets);
 
-		num_tries = n + 1;
+	for (n = 0; n != num_tries; n++) {
 
 		last = build_one_trie(context, rule_sets, n, context->node_max);
 		if (context->bld_tries[n].trie == NULL) {
@@ -1375,9 +1543,9 @@ acl_build_tries(struct acl_build_context *context,
 			return -ENOMEM;
 		}
 
-		/* Build of the last trie completed. */
+		/* Build of the trie completed. */
 		if (last == NULL)
-			break;
+			continue;
 
 		if (num_tries == RTE_DIM(context->tries)) {
 			RTE_LOG(ERR, ACL,
@@ -1400,6 +1568,8 @@ acl_build_tries(struct acl_build_context *context,
 				head = head->next)
 			head->config = config;
 
+		num_tries++;
+
 		/*
 		 * Rebuild the trie for the reduced rule-set.
 		 * Don't try to split it any further.
@@ -1423,10 +1593,12 @@ acl_build_log(const struct acl_build_context *ctx)
 
 	RTE_LOG(DEBUG, ACL, "Build phase for ACL \"%s\":\n"
 		"node limit for tree split: %u\n"
+		"rule sets: %u\n"
 		"nodes created: %u\n"
 		"memory consumed: %zu\n",
 		ctx->acx->name,
 		ctx->node_max,
+		ctx->num_parts,
 		ctx->num_nodes,
 		ctx->pool.alloc);
 
@@ -1505,7 +1677,7 @@ acl_set_data_indexes(struct rte_acl_ctx *ctx)
  */
 static int
 acl_bld(struct acl_build_context *bcx, struct rte_acl_ctx *ctx,
-	const struct rte_acl_config *cfg, uint32_t node_max)
+	const struct rte_acl_config *cfg, uint32_t node_max, uint32_t num_parts)
 {
 	int32_t rc;
 
@@ -1518,6 +1690,7 @@ acl_bld(struct acl_build_context *bcx, struct rte_acl_ctx *ctx,
 	bcx->category_mask = RTE_LEN2MASK(bcx->cfg.num_categories,
 		typeof(bcx->category_mask));
 	bcx->node_max = node_max;
+	bcx->num_parts = num_parts;
 
 	rc = sigsetjmp(bcx->pool.fail, 0);
 
@@ -1618,11 +1791,54 @@ get_first_load_size(const struct rte_acl_config *cfg)
 	return (ofs < max_ofs) ? sizeof(uint32_t) : sizeof(uint8_t);
 }
 
+/*
+ * Allocate the rule hit counters: one array per enabled lcore and a shared
+ * one, indexed by rule index + 1, the first entry absorbing the no matches.
+ * Each array starts on its own cache line, so lcores never write to the
+ * same line.
+ */
+static int
+acl_cnt_alloc(struct rte_acl_ctx *ctx)
+{
+	uint32_t i, k, lc, n;
+	size_t sz;
+	uint8_t *mem;
+	struct rte_acl_rule_cnt *cnt;
+	const struct rte_acl_rule *rule;
+
+	n = ctx->num_rules + 1;
+	k = rte_lcore_count() + 1;
+	sz = RTE_ALIGN_CEIL(n * sizeof(cnt[0]), RTE_CACHE_LINE_SIZE);
+	mem = rte_zmalloc_socket(ctx->name, k * sz, RTE_CACHE_LINE_SIZE,
+		ctx->socket_id);
+	if (mem == NULL)
+		return -ENOMEM;
+
+	cnt = (struct rte_acl_rule_cnt *)mem;
+	for (i = 0; i != ctx->num_rules; i++) {
+		rule = (const struct rte_acl_rule *)
+			((uintptr_t)ctx->rules + i * ctx->rule_sz);
+		cnt[i + 1].userdata = rule->data.userdata;
+	}
+	for (i = 1; i != k; i++)
+		memcpy(mem + i * sz, mem, n * sizeof(cnt[0]));
+
+	rte_mcfg_tailq_write_lock();
+	i = 0;
+	RTE_LCORE_FOREACH(lc)
+		ctx->cnt[lc] = (struct rte_acl_rule_cnt *)(mem + i++ * sz);
+	ctx->cnt[RTE_MAX_LCORE] = (struct rte_acl_rule_cnt *)(mem + i * sz);
+	ctx->cnt_num = n;
+	ctx->cnt_mem = mem;
+	rte_mcfg_tailq_write_unlock();
+	return 0;
+}
+
 int
 rte_acl_build(struct rte_acl_ctx *ctx, const struct rte_acl_config *cfg)
 {
 	int32_t rc;
-	uint32_t n;
+	uint32_t n, num_parts, max_parts;
 	size_t max_size;
 	struct acl_build_context bcx;
 
@@ -1640,10 +1856,13 @@ rte_acl_build(struct rte_acl_ctx *ctx, const struct rte_acl_config *cfg)
 		max_size = cfg->max_size;
 	}
 
-	for (rc = -ERANGE; n >= NODE_MIN && rc == -ERANGE; n /= 2) {
+	num_parts = 1;
+	max_parts = ACL_PART_MAX;
+
+	for (rc = -ERANGE; n >= NODE_MIN && rc == -ERANGE; ) {
 
 		/* perform build phase. */
-		rc = acl_bld(&bcx, ctx, cfg, n);
+		rc = acl_bld(&bcx, ctx, cfg, n, num_parts);
 
 		if (rc == 0) {
 			/* allocate and fill run-time  structures. */
@@ -1660,6 +1879,12 @@ rte_acl_build(struct rte_acl_ctx *ctx, const struct rte_acl_config *cfg)
 
 				/* copy in build config. */
 				ctx->config = *cfg;
+
+				if (ctx->cnt_enabled != 0) {
+					rc = acl_cnt_alloc(ctx);
+					if (rc != 0)
+						acl_build_reset(ctx);
+				}
 			}
 		}
 
@@ -1667,6 +1892,26 @@ rte_acl_build(struct rte_acl_ctx *ctx, const struct rte_acl_config *cfg)
 
 		/* cleanup after build. */
 		tb_free_pool(&bcx.pool);
+
+		/*
+		 * RT structures are too big: first partition the rules in more
+		 * sets, then split the tries at a smaller number of nodes.
+		 */
+		if (rc == -ERANGE) {
+			if (bcx.num_parts == num_parts &&
+					num_parts < max_parts &&
+					bcx.num_rules >= ACL_PART_MIN_RULES)
+				num_parts *= 2;
+			else
+				n /= 2;
+
+		/* the partitions need too many tries, use less of them */
+		} else if (rc != 0 && num_parts > 1) {
+			num_parts /= 2;
+			max_parts = num_parts;
+			n /= 2;
+			rc = -ERANGE;
+		}
 	}
 
 	return rc;
@@ -23,3 +23,41 @@ rte_acl_classify_avx2(const struct rte_acl_ctx *ctx, const uint8_t **data,
 		return rte_acl_classify_scalar(ctx, data, results, num,
 			categories);
 }
+
+/*
+ * Account rule hits and translate the results of a counting context,
+ * 8 results at a time: the userdata are gathered, and when the 8 lanes
+ * hold the same rule, as with hot rules or no match, its counter is
+ * increased once. Otherwise each lane increments its own counter: they
+ * are private to the lcore and mostly cached, which is cheaper than
+ * merging the duplicate lanes and a gather/scatter of the counters.
+ */
+uint32_t
+rte_acl_count_avx2(struct rte_acl_rule_cnt *cnt, uint32_t *results,
+	uint32_t num)
+{
+	uint32_t i, j, r;
+	__m256i idx, ud;
+
+	for (i = 0; i + 8 <= num; i += 8) {
+
+		idx = _mm256_loadu_si256((const __m256i *)(results + i));
+
+		/* counters are 4 dwords long, userdata being the third */
+		ud = _mm256_i32gather_epi32((const int *)&cnt->userdata,
+			_mm256_slli_epi32(idx, 2), sizeof(uint32_t));
+
+		r = results[i];
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(idx,
+				_mm256_set1_epi32(r))) == -1)
+			cnt[r].hits += 8;
+		else {
+			for (j = 0; j != 8; j++)
+				cnt[results[i + j]].hits++;
+		}
+
+		_mm256_storeu_si256((__m256i *)(results + i), ud);
+	}
+
+	return i;
+}
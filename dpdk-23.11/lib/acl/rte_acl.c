@@ -5,7 +5,9 @@
 #include <rte_eal_memconfig.h>
 #include <rte_string_fns.h>
 #include <rte_acl.h>
+#include <rte_lcore.h>
 #include <rte_tailq.h>
+#include <rte_telemetry.h>
 
 #include "acl.h"
 
@@ -64,6 +66,14 @@ rte_acl_classify_sse(__rte_unused const struct rte_acl_ctx *ctx,
 {
 	return -ENOTSUP;
 }
+
+uint32_t
+rte_acl_count_avx2(__rte_unused struct rte_acl_rule_cnt *cnt,
+	__rte_unused uint32_t *results,
+	__rte_unused uint32_t num)
+{
+	return 0;
+}
 #endif
 
 #ifndef RTE_ARCH_ARM
@@ -282,16 +292,84 @@ rte_acl_set_ctx_classify(struct rte_acl_ctx *ctx, enum rte_acl_classify_alg alg)
 	return 0;
 }
 
+/*
+ * Translate the rule indexes returned by a context counting rule hits
+ * back into userdata, accounting the hits.
+ */
+static inline void
+acl_cnt_results(const struct rte_acl_ctx *ctx, uint32_t *results,
+	uint32_t num, enum rte_acl_classify_alg alg)
+{
+	uint32_t i, lc, r[4];
+	struct rte_acl_rule_cnt *cnt;
+
+	lc = rte_lcore_id();
+	cnt = (lc < RTE_MAX_LCORE) ? ctx->cnt[lc] : NULL;
+
+	if (cnt == NULL) {
+		cnt = ctx->cnt[RTE_MAX_LCORE];
+		for (i = 0; i != num; i++) {
+			if (results[i] != 0)
+				__atomic_fetch_add(&cnt[results[i]].hits, 1,
+					__ATOMIC_RELAXED);
+			results[i] = cnt[results[i]].userdata;
+		}
+		return;
+	}
+
+	/* these methods are only selected on AVX2 capable CPUs */
+	if (alg == RTE_ACL_CLASSIFY_AVX2 ||
+			alg == RTE_ACL_CLASSIFY_AVX512X16 ||
+			alg == RTE_ACL_CLASSIFY_AVX512X32) {
+		i = rte_acl_count_avx2(cnt, results, num);
+		results += i;
+		num -= i;
+	}
+
+	/*
+	 * 4 results at a time, a group of the same rule, as with hot rules
+	 * or no match, increments its counter once rather than chaining
+	 * 4 increments of it.
+	 */
+	for (; num >= 4; num -= 4, results += 4) {
+		r[0] = results[0];
+		r[1] = results[1];
+		r[2] = results[2];
+		r[3] = results[3];
+		results[0] = cnt[r[0]].userdata;
+		results[1] = cnt[r[1]].userdata;
+		results[2] = cnt[r[2]].userdata;
+		results[3] = cnt[r[3]].userdata;
+		if (r[0] == r[1] && r[2] == r[3] && r[0] == r[2])
+			cnt[r[0]].hits += 4;
+		else {
+			cnt[r[0]].hits++;
+			cnt[r[1]].hits++;
+			cnt[r[2]].hits++;
+			cnt[r[3]].hits++;
+		}
+	}
+	for (i = 0; i != num; i++) {
+		cnt[results[i]].hits++;
+		results[i] = cnt[results[i]].userdata;
+	}
+}
+
 int
 rte_acl_classify_alg(const struct rte_acl_ctx *ctx, const uint8_t **data,
 	uint32_t *results, uint32_t num, uint32_t categories,
 	enum rte_acl_classify_alg alg)
 {
+	int rc;
+
 	if (categories != 1 &&
 			((RTE_ACL_RESULTS_MULTIPLIER - 1) & categories) != 0)
 		return -EINVAL;
 
-	return classify_fns[alg](ctx, data, results, num, categories);
+	rc = classify_fns[alg](ctx, data, results, num, categories);
+	if (rc == 0 && ctx->cnt_mem != NULL)
+		acl_cnt_results(ctx, results, num * categories, alg);
+	return rc;
 }
 
 int
@@ -354,6 +432,7 @@ rte_acl_free(struct rte_acl_ctx *ctx)
 	rte_mcfg_tailq_write_unlock();
 
 	rte_free(ctx->mem);
+	rte_free(ctx->cnt_mem);
 	rte_free(ctx);
 	rte_free(te);
 }
@@ -519,6 +598,8 @@ rte_acl_dump(const struct rte_acl_ctx *ctx)
 	printf("  num_rules=%"PRIu32"\n", ctx->num_rules);
 	printf("  num_categories=%"PRIu32"\n", ctx->num_categories);
 	printf("  num_tries=%"PRIu32"\n", ctx->num_tries);
+	printf("  rule_counters=%s\n",
+		(ctx->cnt_mem != NULL) ? "on" : "off");
 }
 
 /*
@@ -540,3 +621,205 @@ rte_acl_list_dump(void)
 	}
 	rte_mcfg_tailq_read_unlock();
 }
+
+int
+rte_acl_set_ctx_counters(struct rte_acl_ctx *ctx, int enable)
+{
+	if (ctx == NULL)
+		return -EINVAL;
+
+	ctx->cnt_enabled = (enable != 0);
+	return 0;
+}
+
+int
+rte_acl_get_rule_counters(const struct rte_acl_ctx *ctx, uint64_t *hits,
+	uint32_t num)
+{
+	uint32_t i, lc, n;
+	const struct rte_acl_rule_cnt *cnt;
+
+	if (ctx == NULL || (hits == NULL && num != 0))
+		return -EINVAL;
+	if (ctx->cnt_mem == NULL)
+		return -ENOTSUP;
+
+	n = RTE_MIN(num, ctx->cnt_num - 1);
+	memset(hits, 0, n * sizeof(hits[0]));
+
+	for (lc = 0; lc != RTE_DIM(ctx->cnt); lc++) {
+		cnt = ctx->cnt[lc];
+		if (cnt == NULL)
+			continue;
+		for (i = 0; i != n; i++)
+			hits[i] += __atomic_load_n(&cnt[i + 1].hits,
+				__ATOMIC_RELAXED);
+	}
+
+	return ctx->cnt_num - 1;
+}
+
+int
+rte_acl_reset_rule_counters(struct rte_acl_ctx *ctx)
+{
+	uint32_t i, lc;
+
+	if (ctx == NULL)
+		return -EINVAL;
+	if (ctx->cnt_mem == NULL)
+		return -ENOTSUP;
+
+	for (lc = 0; lc != RTE_DIM(ctx->cnt); lc++) {
+		if (ctx->cnt[lc] == NULL)
+			continue;
+		for (i = 0; i != ctx->cnt_num; i++)
+			__atomic_store_n(&ctx->cnt[lc][i].hits, 0,
+				__ATOMIC_RELAXED);
+	}
+	return 0;
+}
+
+static int
+acl_handle_list(const char *cmd __rte_unused,
+		const char *params __rte_unused, struct rte_tel_data *d)
+{
+	struct rte_acl_list *acl_list;
+	struct rte_tailq_entry *te;
+
+	acl_list = RTE_TAILQ_CAST(rte_acl_tailq.head, rte_acl_list);
+
+	rte_tel_data_start_array(d, RTE_TEL_STRING_VAL);
+
+	rte_mcfg_tailq_read_lock();
+	TAILQ_FOREACH(te, acl_list, next)
+		rte_tel_data_add_array_string(d,
+			((struct rte_acl_ctx *)te->data)->name);
+	rte_mcfg_tailq_read_unlock();
+
+	return 0;
+}
+
+/* find a context by name, the tailq lock being held */
+static const struct rte_acl_ctx *
+acl_tel_find(const char *name)
+{
+	struct rte_acl_list *acl_list;
+	struct rte_tailq_entry *te;
+	const struct rte_acl_ctx *ctx;
+
+	acl_list = RTE_TAILQ_CAST(rte_acl_tailq.head, rte_acl_list);
+
+	TAILQ_FOREACH(te, acl_list, next) {
+		ctx = te->data;
+		if (strncmp(name, ctx->name, sizeof(ctx->name)) == 0)
+			return ctx;
+	}
+	return NULL;
+}
+
+static int
+acl_handle_info(const char *cmd __rte_unused, const char *params,
+		struct rte_tel_data *d)
+{
+	const struct rte_acl_ctx *ctx;
+
+	if (params == NULL || strlen(params) == 0)
+		return -EINVAL;
+
+	rte_mcfg_tailq_read_lock();
+
+	ctx = acl_tel_find(params);
+	if (ctx == NULL) {
+		rte_mcfg_tailq_read_unlock();
+		return -ENOENT;
+	}
+
+	rte_tel_data_start_dict(d);
+	rte_tel_data_add_dict_string(d, "name", ctx->name);
+	rte_tel_data_add_dict_int(d, "socket_id", ctx->socket_id);
+	rte_tel_data_add_dict_uint(d, "alg", ctx->alg);
+	rte_tel_data_add_dict_uint(d, "max_rules", ctx->max_rules);
+	rte_tel_data_add_dict_uint(d, "num_rules", ctx->num_rules);
+	rte_tel_data_add_dict_uint(d, "num_categories", ctx->num_categories);
+	rte_tel_data_add_dict_uint(d, "num_tries", ctx->num_tries);
+	rte_tel_data_add_dict_uint(d, "mem_sz", ctx->mem_sz);
+	rte_tel_data_add_dict_uint(d, "rule_counters",
+		ctx->cnt_mem != NULL);
+
+	rte_mcfg_tailq_read_unlock();
+	return 0;
+}
+
+static int
+acl_handle_counters(const char *cmd __rte_unused, const char *params,
+		struct rte_tel_data *d)
+{
+	const struct rte_acl_ctx *ctx;
+	struct rte_tel_data *hits;
+	char name[RTE_ACL_NAMESIZE];
+	uint64_t cnt[RTE_TEL_MAX_ARRAY_ENTRIES];
+	unsigned long first;
+	uint32_t i, j, n;
+	char *p;
+
+	if (params == NULL || strlen(params) == 0)
+		return -EINVAL;
+
+	/* <name>[,<first rule>] */
+	strlcpy(name, params, sizeof(name));
+	first = 0;
+	p = strchr(name, ',');
+	if (p != NULL) {
+		*p++ = 0;
+		first = strtoul(p, &p, 0);
+		if (*p != 0)
+			return -EINVAL;
+	}
+
+	rte_mcfg_tailq_read_lock();
+
+	ctx = acl_tel_find(name);
+	if (ctx == NULL || ctx->cnt_mem == NULL) {
+		rte_mcfg_tailq_read_unlock();
+		return (ctx == NULL) ? -ENOENT : -ENOTSUP;
+	}
+
+	n = 0;
+	if (first < ctx->cnt_num - 1)
+		n = RTE_MIN(ctx->cnt_num - 1 - first, RTE_DIM(cnt));
+	memset(cnt, 0, n * sizeof(cnt[0]));
+	for (i = 0; i != RTE_DIM(ctx->cnt); i++) {
+		if (ctx->cnt[i] == NULL)
+			continue;
+		for (j = 0; j != n; j++)
+			cnt[j] += __atomic_load_n(
+				&ctx->cnt[i][first + 1 + j].hits,
+				__ATOMIC_RELAXED);
+	}
+
+	rte_tel_data_start_dict(d);
+	rte_tel_data_add_dict_uint(d, "num_rules", ctx->cnt_num - 1);
+	rte_tel_data_add_dict_uint(d, "first", first);
+
+	rte_mcfg_tailq_read_unlock();
+
+	hits = rte_tel_data_alloc();
+	if (hits == NULL)
+		return -ENOMEM;
+	rte_tel_data_start_array(hits, RTE_TEL_UINT_VAL);
+	for (i = 0; i != n; i++)
+		rte_tel_data_add_array_uint(hits, cnt[i]);
+	rte_tel_data_add_dict_container(d, "hits", hits, 0);
+
+	return 0;
+}
+
+RTE_INIT(acl_init_telemetry)
+{
+	rte_telemetry_register_cmd("/acl/list", acl_handle_list,
+		"Returns list of ACL contexts. Takes no parameters");
+	rte_telemetry_register_cmd("/acl/info", acl_handle_info,
+		"Returns ACL context info. Parameters: name");
+	rte_telemetry_register_cmd("/acl/counters", acl_handle_counters,
+		"Returns ACL rule hit counters, by order of addition, from the given rule on. Parameters: name[,first rule]");
+}
@@ -12,6 +12,7 @@
  */
 
 #include <rte_acl_osdep.h>
+#include <rte_compat.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -340,6 +341,70 @@ extern int
 rte_acl_set_ctx_classify(struct rte_acl_ctx *ctx,
 	enum rte_acl_classify_alg alg);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Enable or disable the counting of rule hits for a given ACL context.
+ * The setting takes effect at the next rte_acl_build(): the classify
+ * functions then account, per lcore, the number of times each rule is
+ * the match returned for a category.
+ * This function is not multi-thread safe.
+ *
+ * @param ctx
+ *   ACL context to change counting mode for.
+ * @param enable
+ *   Non zero to count rule hits.
+ * @return
+ *   - -EINVAL if the parameters are invalid.
+ *   - Zero if operation completed successfully.
+ */
+__rte_experimental
+int
+rte_acl_set_ctx_counters(struct rte_acl_ctx *ctx, int enable);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the hit counters of the rules of an ACL context built with
+ * counting enabled, summed over all lcores.
+ *
+ * @param ctx
+ *   ACL context to get counters from.
+ * @param hits
+ *   Array to return the hits of each rule, in the order the rules
+ *   were added to the context.
+ * @param num
+ *   Number of elements in the hits array.
+ * @return
+ *   - Number of rules of the build on success, which can exceed num.
+ *   - -ENOTSUP if the context was not built with counting enabled.
+ *   - -EINVAL if the parameters are invalid.
+ */
+__rte_experimental
+int
+rte_acl_get_rule_counters(const struct rte_acl_ctx *ctx, uint64_t *hits,
+	uint32_t num);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Reset the rule hit counters of an ACL context.
+ * The hits accounted by classify calls in progress may be lost.
+ *
+ * @param ctx
+ *   ACL context to reset counters of.
+ * @return
+ *   - -ENOTSUP if the context was not built with counting enabled.
+ *   - -EINVAL if the parameters are invalid.
+ *   - Zero if operation completed successfully.
+ */
+__rte_experimental
+int
+rte_acl_reset_rule_counters(struct rte_acl_ctx *ctx);
+
 /**
  * Dump an ACL context structure to the console.
  *
@@ -355,6 +420,241 @@ rte_acl_dump(const struct rte_acl_ctx *ctx);
 void
 rte_acl_list_dump(void);
 
+/** Max number of sub-contexts of a versioned ACL context. */
+#define RTE_ACL_VCTX_MAX_SHARDS	64
+
+/** Register a service committing the pending updates of the context. */
+#define RTE_ACL_VCTX_F_SERVICE	(1 << 0)
+
+/**
+ * Versioned ACL context.
+ *
+ * Rules are spread over several ordinary ACL contexts (shards), by hash
+ * of their userdata. Rule updates are staged, then only the shards they
+ * touch are rebuilt and all shards are switched atomically to the new
+ * version. The memory of the replaced version is reclaimed once the
+ * readers reported a quiescent state on the RCU QSBR variable.
+ * Classification searches every shard, so the number of shards trades
+ * update cost for classify cost.
+ */
+struct rte_acl_vctx;
+
+struct rte_rcu_qsbr;
+
+/**
+ * Parameters used when creating a versioned ACL context.
+ */
+struct rte_acl_vctx_param {
+	const char *name;         /**< Name of the context. */
+	int         socket_id;    /**< Socket ID to allocate memory for. */
+	uint32_t    rule_size;    /**< Size of each rule. */
+	uint32_t    max_rule_num; /**< Maximum number of rules. */
+	uint32_t    num_shards;
+	/**< Number of sub-contexts, up to RTE_ACL_VCTX_MAX_SHARDS, 0 means 1. */
+	uint32_t    flags;        /**< RTE_ACL_VCTX_F_* flags. */
+	struct rte_rcu_qsbr *v;
+	/**<
+	 * RCU QSBR variable the classifying threads report to,
+	 * NULL if the application guarantees no classify runs
+	 * concurrently with updates.
+	 */
+	struct rte_acl_config cfg; /**< Build configuration of the shards. */
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create a new versioned ACL context, with no rules.
+ *
+ * @param param
+ *   Parameters used to create and initialise the context.
+ * @return
+ *   Pointer to the context, or NULL on error, with error code set in
+ *   rte_errno. Possible rte_errno errors include:
+ *   - EINVAL - invalid parameter passed to function
+ *   - ENOMEM - unable to allocate memory
+ */
+__rte_experimental
+struct rte_acl_vctx *
+rte_acl_vctx_create(const struct rte_acl_vctx_param *param);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * De-allocate all memory used by a versioned ACL context,
+ * unregistering its service if any.
+ * No classify should be in progress on the context.
+ *
+ * @param vctx
+ *   Context to free. If NULL, no operation is performed.
+ */
+__rte_experimental
+void
+rte_acl_vctx_free(struct rte_acl_vctx *vctx);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Stage rules to be added to a versioned ACL context. The rules are
+ * classified against after the next commit.
+ * The userdata of each rule identifies it and must be non zero
+ * and unique within the context.
+ * This function is multi-thread safe.
+ *
+ * @param vctx
+ *   Context to add rules to.
+ * @param rules
+ *   Array of rules, in the format of rte_acl_add_rules().
+ * @param num
+ *   Number of elements in the input array of rules.
+ * @return
+ *   - -ENOMEM if there is no space in the context for these rules.
+ *   - -EEXIST if a userdata is already in use.
+ *   - -EINVAL if the parameters are invalid.
+ *   - Zero if operation completed successfully, in which case all
+ *     the rules were staged, none otherwise.
+ */
+__rte_experimental
+int
+rte_acl_vctx_add_rules(struct rte_acl_vctx *vctx,
+	const struct rte_acl_rule *rules, uint32_t num);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Stage rules to be deleted from a versioned ACL context.
+ * This function is multi-thread safe.
+ *
+ * @param vctx
+ *   Context to delete rules from.
+ * @param userdata
+ *   Array of userdata of the rules to delete.
+ * @param num
+ *   Number of elements in the userdata array.
+ * @return
+ *   - -ENOENT if a userdata is not in use, no rule being deleted.
+ *   - -EINVAL if the parameters are invalid.
+ *   - Zero if operation completed successfully.
+ */
+__rte_experimental
+int
+rte_acl_vctx_del_rules(struct rte_acl_vctx *vctx, const uint32_t *userdata,
+	uint32_t num);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Rebuild the shards affected by the staged updates and switch the
+ * context to the new version. When a RCU QSBR variable was given,
+ * wait for the readers to stop using the previous version before
+ * freeing it.
+ * This function is multi-thread safe, it is also run by the service
+ * of the context if any. After a failed commit, the service logs the
+ * error and doesn't retry until rules are added or deleted.
+ *
+ * @param vctx
+ *   Context to commit.
+ * @return
+ *   - -ENOMEM if couldn't allocate enough memory, the updates staying
+ *     pending.
+ *   - -EINVAL if the parameters are invalid.
+ *   - Negative error code of rte_acl_build() if a shard failed to build.
+ *   - Zero if operation completed successfully.
+ */
+__rte_experimental
+int
+rte_acl_vctx_commit(struct rte_acl_vctx *vctx);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the number of shards having staged updates not committed yet.
+ *
+ * @param vctx
+ *   Versioned ACL context.
+ * @return
+ *   Number of shards to rebuild, -EINVAL if the parameters are invalid.
+ */
+__rte_experimental
+int
+rte_acl_vctx_pending(const struct rte_acl_vctx *vctx);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the error of the last commit, kept until a commit succeeds or
+ * rules are added or deleted.
+ *
+ * @param vctx
+ *   Versioned ACL context.
+ * @return
+ *   Negative error code of the last commit, zero if it succeeded,
+ *   -EINVAL if the parameters are invalid.
+ */
+__rte_experimental
+int
+rte_acl_vctx_error(const struct rte_acl_vctx *vctx);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the id of the service committing the updates of the context,
+ * registered when the context was created with RTE_ACL_VCTX_F_SERVICE.
+ * The application maps it to a service core and starts it.
+ *
+ * @param vctx
+ *   Versioned ACL context.
+ * @param service_id
+ *   Pointer to return the service id.
+ * @return
+ *   - -ESRCH if the context has no service.
+ *   - -EINVAL if the parameters are invalid.
+ *   - Zero if operation completed successfully.
+ */
+__rte_experimental
+int
+rte_acl_vctx_service_id_get(const struct rte_acl_vctx *vctx,
+	uint32_t *service_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Perform search for a matching rule for each input data buffer against
+ * the current version of a versioned ACL context, as rte_acl_classify()
+ * does. The thread must be registered with the RCU QSBR variable of the
+ * context, and not report a quiescent state while the call is in
+ * progress.
+ *
+ * @param vctx
+ *   Versioned ACL context to search with.
+ * @param data
+ *   Array of pointers to input data buffers to perform search.
+ * @param results
+ *   Array of search results, *categories* results per each input data
+ *   buffer, being the userdata of the matching rules.
+ * @param num
+ *   Number of elements in the input data buffers array.
+ * @param categories
+ *   Number of maximum possible matches for each input buffer, one possible
+ *   match per category.
+ * @return
+ *   zero on successful completion.
+ *   -EINVAL for incorrect arguments.
+ */
+__rte_experimental
+int
+rte_acl_vctx_classify(const struct rte_acl_vctx *vctx, const uint8_t **data,
+	uint32_t *results, uint32_t num, uint32_t categories);
+
 #ifdef __cplusplus
 }
 #endif
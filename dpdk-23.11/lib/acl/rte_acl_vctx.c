@@ -0,0 +1,549 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <rte_acl.h>
+#include <rte_bitops.h>
+#include <rte_hash.h>
+#include <rte_jhash.h>
+#include <rte_rcu_qsbr.h>
+#include <rte_service_component.h>
+#include <rte_spinlock.h>
+
+/* number of inputs classified at once against each shard */
+#define ACL_VCTX_BURST	64
+
+/* user data and priority of a rule, indexed by its shard internal userdata */
+struct acl_vmeta {
+	uint32_t userdata;
+	int32_t priority;
+};
+
+/* built shard, immutable once visible to the readers */
+struct acl_vshard {
+	struct rte_acl_ctx *ctx;
+	uint32_t num_rules;
+	struct acl_vmeta meta[];
+};
+
+/* shards seen by the readers, switched as a whole */
+struct acl_version {
+	struct acl_vshard *shard[RTE_ACL_VCTX_MAX_SHARDS];
+};
+
+struct rte_acl_vctx {
+	struct acl_version *cur;      /* current version */
+	uint32_t num_shards;
+	int socket_id;
+	uint32_t rule_size;
+	uint32_t max_rule_num;
+	uint32_t flags;
+	uint32_t service_id;
+	struct rte_rcu_qsbr *v;
+	struct rte_acl_config cfg;
+	rte_spinlock_t build_lock;    /* serializes commits */
+	rte_spinlock_t lock;          /* protects the staged rules */
+	uint64_t dirty;               /* shards having staged updates */
+	uint32_t num_upd;             /* number of staged updates */
+	int32_t err;                  /* last commit error, until an update */
+	uint32_t gen;                 /* for unique shard names */
+	uint32_t num_rules;
+	struct rte_hash *idx;         /* userdata to staged rule index */
+	uint8_t *rules;               /* staged rules */
+	char name[RTE_ACL_NAMESIZE];
+};
+
+static inline uint32_t
+acl_vctx_shard(const struct rte_acl_vctx *vctx, uint32_t userdata)
+{
+	return rte_jhash_1word(userdata, 0) % vctx->num_shards;
+}
+
+static inline struct rte_acl_rule *
+acl_vctx_rule(const struct rte_acl_vctx *vctx, uint32_t i)
+{
+	return (struct rte_acl_rule *)(vctx->rules + (size_t)i * vctx->rule_size);
+}
+
+static void
+acl_vshard_free(struct acl_vshard *sh)
+{
+	if (sh == NULL)
+		return;
+	rte_acl_free(sh->ctx);
+	rte_free(sh);
+}
+
+static struct acl_vshard *
+acl_vshard_alloc(struct rte_acl_vctx *vctx, uint32_t num)
+{
+	struct acl_vshard *sh;
+	struct rte_acl_param prm;
+	char name[RTE_ACL_NAMESIZE];
+
+	sh = rte_zmalloc_socket(NULL, sizeof(*sh) + num * sizeof(sh->meta[0]),
+		RTE_CACHE_LINE_SIZE, vctx->socket_id);
+	if (sh == NULL)
+		return NULL;
+
+	/* rte_acl_create() returns the existing context on name clash */
+	snprintf(name, sizeof(name), "VACL%p_%x", vctx, vctx->gen++);
+	prm.name = name;
+	prm.socket_id = vctx->socket_id;
+	prm.rule_size = vctx->rule_size;
+	prm.max_rule_num = num;
+
+	sh->ctx = rte_acl_create(&prm);
+	if (sh->ctx == NULL) {
+		rte_free(sh);
+		return NULL;
+	}
+	return sh;
+}
+
+/*
+ * Add a staged rule to the shard being built, its userdata replaced by
+ * its index in the shard, so the result of the shard classify directly
+ * points to the rule meta data.
+ */
+static int
+acl_vshard_add(struct rte_acl_vctx *vctx, struct acl_vshard *sh,
+	const struct rte_acl_rule *rule)
+{
+	uint8_t buf[RTE_ACL_RULE_SZ(RTE_ACL_MAX_FIELDS)];
+	struct rte_acl_rule *r;
+
+	r = (struct rte_acl_rule *)buf;
+	memcpy(r, rule, vctx->rule_size);
+	sh->meta[sh->num_rules].userdata = rule->data.userdata;
+	sh->meta[sh->num_rules].priority = rule->data.priority;
+	r->data.userdata = ++sh->num_rules;
+
+	return rte_acl_add_rules(sh->ctx, r, 1);
+}
+
+static int
+acl_vctx_do_commit(struct rte_acl_vctx *vctx)
+{
+	uint32_t i, s;
+	uint64_t dirty;
+	int32_t rc;
+	uint32_t cnt[RTE_ACL_VCTX_MAX_SHARDS];
+	struct acl_vshard *upd[RTE_ACL_VCTX_MAX_SHARDS];
+	struct acl_version *old, *ver;
+	const struct rte_acl_rule *r;
+	uint32_t num_upd;
+
+	ver = rte_zmalloc_socket(NULL, sizeof(*ver), RTE_CACHE_LINE_SIZE,
+		vctx->socket_id);
+	if (ver == NULL)
+		return -ENOMEM;
+
+	memset(cnt, 0, sizeof(cnt));
+	memset(upd, 0, sizeof(upd));
+	rc = 0;
+
+	/* snapshot the staged rules of the dirty shards */
+	rte_spinlock_lock(&vctx->lock);
+
+	dirty = vctx->dirty;
+	num_upd = vctx->num_upd;
+	for (i = 0; i != vctx->num_rules; i++) {
+		s = acl_vctx_shard(vctx, acl_vctx_rule(vctx, i)->data.userdata);
+		cnt[s] += (dirty >> s) & 1;
+	}
+
+	for (s = 0; s != vctx->num_shards && rc == 0; s++) {
+		if (cnt[s] != 0) {
+			upd[s] = acl_vshard_alloc(vctx, cnt[s]);
+			if (upd[s] == NULL)
+				rc = -ENOMEM;
+		}
+	}
+
+	for (i = 0; i != vctx->num_rules && rc == 0; i++) {
+		r = acl_vctx_rule(vctx, i);
+		s = acl_vctx_shard(vctx, r->data.userdata);
+		if ((dirty >> s) & 1)
+			rc = acl_vshard_add(vctx, upd[s], r);
+	}
+
+	if (rc == 0)
+		vctx->dirty &= ~dirty;
+
+	rte_spinlock_unlock(&vctx->lock);
+
+	/* build them while the updates keep on being staged */
+	for (s = 0; s != vctx->num_shards && rc == 0; s++) {
+		if (upd[s] != NULL)
+			rc = rte_acl_build(upd[s]->ctx, &vctx->cfg);
+	}
+
+	if (rc != 0) {
+		for (s = 0; s != vctx->num_shards; s++)
+			acl_vshard_free(upd[s]);
+		rte_free(ver);
+		rte_spinlock_lock(&vctx->lock);
+		vctx->dirty |= dirty;
+		/* an update staged meanwhile may fix the build */
+		if (vctx->num_upd == num_upd)
+			__atomic_store_n(&vctx->err, rc, __ATOMIC_RELAXED);
+		rte_spinlock_unlock(&vctx->lock);
+		return rc;
+	}
+
+	old = vctx->cur;
+	for (s = 0; s != vctx->num_shards; s++)
+		ver->shard[s] = ((dirty >> s) & 1) ? upd[s] : old->shard[s];
+
+	__atomic_store_n(&vctx->cur, ver, __ATOMIC_RELEASE);
+
+	if (vctx->v != NULL)
+		rte_rcu_qsbr_synchronize(vctx->v, RTE_QSBR_THRID_INVALID);
+
+	for (s = 0; s != vctx->num_shards; s++) {
+		if ((dirty >> s) & 1)
+			acl_vshard_free(old->shard[s]);
+	}
+	rte_free(old);
+
+	__atomic_store_n(&vctx->err, 0, __ATOMIC_RELAXED);
+	return 0;
+}
+
+static int32_t
+acl_vctx_service_run(void *arg)
+{
+	struct rte_acl_vctx *vctx = arg;
+	int32_t rc;
+
+	/* don't retry a failed commit until the rules change */
+	if (__atomic_load_n(&vctx->dirty, __ATOMIC_RELAXED) == 0 ||
+			__atomic_load_n(&vctx->err, __ATOMIC_RELAXED) != 0 ||
+			rte_spinlock_trylock(&vctx->build_lock) == 0)
+		return -EAGAIN;
+
+	rc = acl_vctx_do_commit(vctx);
+	rte_spinlock_unlock(&vctx->build_lock);
+
+	if (rc != 0)
+		RTE_LOG(ERR, ACL, "%s(%s): commit failed, error code: %d\n",
+			__func__, vctx->name, rc);
+	return rc;
+}
+
+struct rte_acl_vctx *
+rte_acl_vctx_create(const struct rte_acl_vctx_param *param)
+{
+	struct rte_acl_vctx *vctx;
+	struct rte_hash_parameters hprm = {0};
+	struct rte_service_spec spec = {0};
+	char name[RTE_HASH_NAMESIZE];
+
+	if (param == NULL || param->name == NULL ||
+			param->num_shards > RTE_ACL_VCTX_MAX_SHARDS ||
+			param->rule_size < sizeof(struct rte_acl_rule) ||
+			param->rule_size > RTE_ACL_RULE_SZ(RTE_ACL_MAX_FIELDS) ||
+			param->max_rule_num == 0 ||
+			param->cfg.num_categories == 0 ||
+			param->cfg.num_categories > RTE_ACL_MAX_CATEGORIES ||
+			(param->flags & ~RTE_ACL_VCTX_F_SERVICE) != 0) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	vctx = rte_zmalloc_socket(NULL, sizeof(*vctx), RTE_CACHE_LINE_SIZE,
+		param->socket_id);
+	if (vctx == NULL) {
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	vctx->num_shards = RTE_MAX(param->num_shards, 1U);
+	vctx->socket_id = param->socket_id;
+	vctx->rule_size = param->rule_size;
+	vctx->max_rule_num = param->max_rule_num;
+	vctx->flags = param->flags;
+	vctx->v = param->v;
+	vctx->cfg = param->cfg;
+	rte_spinlock_init(&vctx->build_lock);
+	rte_spinlock_init(&vctx->lock);
+	strlcpy(vctx->name, param->name, sizeof(vctx->name));
+
+	vctx->cur = rte_zmalloc_socket(NULL, sizeof(*vctx->cur),
+		RTE_CACHE_LINE_SIZE, param->socket_id);
+	vctx->rules = rte_zmalloc_socket(NULL,
+		(size_t)param->max_rule_num * param->rule_size,
+		RTE_CACHE_LINE_SIZE, param->socket_id);
+
+	snprintf(name, sizeof(name), "VACL%p", vctx);
+	hprm.name = name;
+	hprm.entries = param->max_rule_num;
+	hprm.key_len = sizeof(uint32_t);
+	hprm.hash_func = rte_jhash;
+	hprm.socket_id = param->socket_id;
+	hprm.extra_flag = RTE_HASH_EXTRA_FLAGS_EXT_TABLE;
+	vctx->idx = rte_hash_create(&hprm);
+
+	if (vctx->cur == NULL || vctx->rules == NULL || vctx->idx == NULL) {
+		rte_acl_vctx_free(vctx);
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	if (param->flags & RTE_ACL_VCTX_F_SERVICE) {
+		snprintf(spec.name, sizeof(spec.name), "acl_vctx_%s",
+			param->name);
+		spec.callback = acl_vctx_service_run;
+		spec.callback_userdata = vctx;
+		spec.capabilities = RTE_SERVICE_CAP_MT_SAFE;
+		spec.socket_id = param->socket_id;
+		if (rte_service_component_register(&spec,
+				&vctx->service_id) != 0) {
+			vctx->flags &= ~RTE_ACL_VCTX_F_SERVICE;
+			rte_acl_vctx_free(vctx);
+			rte_errno = EINVAL;
+			return NULL;
+		}
+		rte_service_component_runstate_set(vctx->service_id, 1);
+	}
+
+	return vctx;
+}
+
+void
+rte_acl_vctx_free(struct rte_acl_vctx *vctx)
+{
+	uint32_t s;
+
+	if (vctx == NULL)
+		return;
+
+	if (vctx->flags & RTE_ACL_VCTX_F_SERVICE) {
+		rte_service_component_runstate_set(vctx->service_id, 0);
+		while (rte_service_may_be_active(vctx->service_id) == 1)
+			rte_pause();
+		rte_service_component_unregister(vctx->service_id);
+	}
+
+	if (vctx->cur != NULL) {
+		for (s = 0; s != vctx->num_shards; s++)
+			acl_vshard_free(vctx->cur->shard[s]);
+		rte_free(vctx->cur);
+	}
+	rte_hash_free(vctx->idx);
+	rte_free(vctx->rules);
+	rte_free(vctx);
+}
+
+int
+rte_acl_vctx_add_rules(struct rte_acl_vctx *vctx,
+	const struct rte_acl_rule *rules, uint32_t num)
+{
+	const struct rte_acl_rule *rv;
+	uint32_t i, j;
+	int32_t rc;
+	uint64_t dirty;
+
+	if (vctx == NULL || (rules == NULL && num != 0))
+		return -EINVAL;
+
+	for (i = 0; i != num; i++) {
+		rv = (const struct rte_acl_rule *)
+			((uintptr_t)rules + i * vctx->rule_size);
+		if ((RTE_LEN2MASK(RTE_ACL_MAX_CATEGORIES, uint32_t) &
+				rv->data.category_mask) == 0 ||
+				rv->data.priority > RTE_ACL_MAX_PRIORITY ||
+				rv->data.priority < RTE_ACL_MIN_PRIORITY ||
+				rv->data.userdata == 0) {
+			RTE_LOG(ERR, ACL, "%s(%s): rule #%u is invalid\n",
+				__func__, vctx->name, i + 1);
+			return -EINVAL;
+		}
+	}
+
+	rc = 0;
+	dirty = 0;
+	rte_spinlock_lock(&vctx->lock);
+
+	if (num > vctx->max_rule_num - vctx->num_rules)
+		rc = -ENOMEM;
+
+	for (i = 0; i != num && rc == 0; i++) {
+		rv = (const struct rte_acl_rule *)
+			((uintptr_t)rules + i * vctx->rule_size);
+		if (rte_hash_lookup(vctx->idx, &rv->data.userdata) >= 0)
+			rc = -EEXIST;
+		else
+			rc = rte_hash_add_key_data(vctx->idx,
+				&rv->data.userdata,
+				(void *)(uintptr_t)(vctx->num_rules + i));
+		if (rc != 0) {
+			/* undo the rules of that call */
+			for (j = 0; j != i; j++)
+				rte_hash_del_key(vctx->idx, &((const struct
+					rte_acl_rule *)((uintptr_t)rules +
+					j * vctx->rule_size))->data.userdata);
+			break;
+		}
+		memcpy(acl_vctx_rule(vctx, vctx->num_rules + i), rv,
+			vctx->rule_size);
+		dirty |= RTE_BIT64(acl_vctx_shard(vctx, rv->data.userdata));
+	}
+
+	if (rc == 0) {
+		vctx->num_rules += num;
+		vctx->dirty |= dirty;
+		vctx->num_upd++;
+		__atomic_store_n(&vctx->err, 0, __ATOMIC_RELAXED);
+	}
+
+	rte_spinlock_unlock(&vctx->lock);
+	return rc;
+}
+
+int
+rte_acl_vctx_del_rules(struct rte_acl_vctx *vctx, const uint32_t *userdata,
+	uint32_t num)
+{
+	uint32_t i, last;
+	uintptr_t pos;
+	void *data;
+
+	if (vctx == NULL || (userdata == NULL && num != 0))
+		return -EINVAL;
+
+	rte_spinlock_lock(&vctx->lock);
+
+	/* all or nothing */
+	for (i = 0; i != num; i++) {
+		if (rte_hash_lookup(vctx->idx, &userdata[i]) < 0) {
+			rte_spinlock_unlock(&vctx->lock);
+			return -ENOENT;
+		}
+	}
+
+	for (i = 0; i != num; i++) {
+		/* fails on a userdata repeated in the array */
+		if (rte_hash_lookup_data(vctx->idx, &userdata[i], &data) < 0)
+			continue;
+		rte_hash_del_key(vctx->idx, &userdata[i]);
+
+		/* move the last rule to the hole */
+		pos = (uintptr_t)data;
+		last = --vctx->num_rules;
+		if (pos != last) {
+			memcpy(acl_vctx_rule(vctx, pos),
+				acl_vctx_rule(vctx, last), vctx->rule_size);
+			rte_hash_add_key_data(vctx->idx,
+				&acl_vctx_rule(vctx, pos)->data.userdata,
+				(void *)pos);
+		}
+		vctx->dirty |= RTE_BIT64(acl_vctx_shard(vctx, userdata[i]));
+	}
+
+	if (num != 0) {
+		vctx->num_upd++;
+		__atomic_store_n(&vctx->err, 0, __ATOMIC_RELAXED);
+	}
+
+	rte_spinlock_unlock(&vctx->lock);
+	return 0;
+}
+
+int
+rte_acl_vctx_commit(struct rte_acl_vctx *vctx)
+{
+	int32_t rc;
+
+	if (vctx == NULL)
+		return -EINVAL;
+
+	rte_spinlock_lock(&vctx->build_lock);
+	rc = 0;
+	if (__atomic_load_n(&vctx->dirty, __ATOMIC_RELAXED) != 0)
+		rc = acl_vctx_do_commit(vctx);
+	rte_spinlock_unlock(&vctx->build_lock);
+	return rc;
+}
+
+int
+rte_acl_vctx_pending(const struct rte_acl_vctx *vctx)
+{
+	if (vctx == NULL)
+		return -EINVAL;
+
+	return rte_popcount64(__atomic_load_n(&vctx->dirty, __ATOMIC_RELAXED));
+}
+
+int
+rte_acl_vctx_error(const struct rte_acl_vctx *vctx)
+{
+	if (vctx == NULL)
+		return -EINVAL;
+
+	return __atomic_load_n(&vctx->err, __ATOMIC_RELAXED);
+}
+
+int
+rte_acl_vctx_service_id_get(const struct rte_acl_vctx *vctx,
+	uint32_t *service_id)
+{
+	if (vctx == NULL || service_id == NULL)
+		return -EINVAL;
+	if ((vctx->flags & RTE_ACL_VCTX_F_SERVICE) == 0)
+		return -ESRCH;
+
+	*service_id = vctx->service_id;
+	return 0;
+}
+
+int
+rte_acl_vctx_classify(const struct rte_acl_vctx *vctx, const uint8_t **data,
+	uint32_t *results, uint32_t num, uint32_t categories)
+{
+	uint32_t i, k, n, s, nc;
+	int32_t rc;
+	const struct acl_version *ver;
+	const struct acl_vshard *sh;
+	const struct acl_vmeta *m;
+	uint32_t res[ACL_VCTX_BURST * RTE_ACL_MAX_CATEGORIES];
+	int32_t prio[ACL_VCTX_BURST * RTE_ACL_MAX_CATEGORIES];
+
+	if (vctx == NULL || data == NULL || results == NULL ||
+			categories == 0 || categories > RTE_ACL_MAX_CATEGORIES ||
+			(categories != 1 &&
+			categories % RTE_ACL_RESULTS_MULTIPLIER != 0))
+		return -EINVAL;
+
+	ver = __atomic_load_n(&vctx->cur, __ATOMIC_ACQUIRE);
+
+	for (k = 0; k < num; k += n) {
+		n = RTE_MIN(num - k, (uint32_t)ACL_VCTX_BURST);
+		nc = n * categories;
+		memset(results + k * categories, 0, nc * sizeof(results[0]));
+
+		/* keep the highest priority match, the first shard on ties */
+		for (s = 0; s != vctx->num_shards; s++) {
+			sh = ver->shard[s];
+			if (sh == NULL)
+				continue;
+			rc = rte_acl_classify(sh->ctx, data + k, res, n,
+				categories);
+			if (rc != 0)
+				return rc;
+			for (i = 0; i != nc; i++) {
+				if (res[i] == 0)
+					continue;
+				m = &sh->meta[res[i] - 1];
+				if (results[k * categories + i] == 0 ||
+						m->priority > prio[i]) {
+					results[k * categories + i] =
+						m->userdata;
+					prio[i] = m->priority;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
@@ -5,6 +5,8 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <rte_debug.h>
 #include <rte_malloc.h>
@@ -23,6 +25,9 @@
 
 #define DIR24_8_NAMESIZE	64
 
+/* Number of routes of a bulk update sharing one dataplane update */
+#define DIR24_8_BULK_CHUNK	64
+
 #define ROUNDUP(x, y)	 RTE_ALIGN_CEIL(x, (1 << (32 - y)))
 
 static inline rte_fib_lookup_fn_t
@@ -169,13 +174,68 @@ tbl8_free_idx(struct dir24_8_tbl *dp, int idx)
 		~(1ULL << (idx & BITMAP_SLAB_BITMASK));
 }
 
+static int
+tbl8_get(struct dir24_8_tbl *dp)
+{
+	int tbl8_idx;
+
+	tbl8_idx = tbl8_get_idx(dp);
+	if (tbl8_idx == -ENOSPC && dp->dq != NULL) {
+		/* If there are no tbl8 groups try to reclaim one. */
+		if (rte_rcu_qsbr_dq_reclaim(dp->dq, 1, NULL, NULL, NULL) == 0)
+			tbl8_idx = tbl8_get_idx(dp);
+	}
+
+	return tbl8_idx;
+}
+
+static void
+tbl8_cleanup_and_free(struct dir24_8_tbl *dp, uint64_t tbl8_idx)
+{
+	uint8_t *ptr = (uint8_t *)dp->tbl8 +
+		((tbl8_idx * DIR24_8_TBL8_GRP_NUM_ENT) << dp->nh_sz);
+
+	memset(ptr, 0, DIR24_8_TBL8_GRP_NUM_ENT << dp->nh_sz);
+	tbl8_free_idx(dp, tbl8_idx);
+}
+
+static void
+__rcu_qsbr_free_resource(void *p, void *data, unsigned int n)
+{
+	RTE_SET_USED(n);
+	tbl8_cleanup_and_free(p, *(uint64_t *)data);
+}
+
+/*
+ * Release a tbl8 group which is not referenced by tbl24 anymore,
+ * once the readers which may still use it are done with it.
+ */
+static void
+tbl8_free(struct dir24_8_tbl *dp, uint64_t tbl8_idx)
+{
+	if (dp->v == NULL) {
+		tbl8_cleanup_and_free(dp, tbl8_idx);
+	} else if (dp->rcu_mode == RTE_FIB_QSBR_MODE_SYNC) {
+		/* Wait for quiescent state change. */
+		rte_rcu_qsbr_synchronize(dp->v, RTE_QSBR_THRID_INVALID);
+		tbl8_cleanup_and_free(dp, tbl8_idx);
+	} else if (dp->rcu_mode == RTE_FIB_QSBR_MODE_DQ) {
+		/* Push into QSBR defer queue, or wait if it is full. */
+		if (rte_rcu_qsbr_dq_enqueue(dp->dq, &tbl8_idx) != 0) {
+			rte_rcu_qsbr_synchronize(dp->v,
+				RTE_QSBR_THRID_INVALID);
+			tbl8_cleanup_and_free(dp, tbl8_idx);
+		}
+	}
+}
+
 static int
 tbl8_alloc(struct dir24_8_tbl *dp, uint64_t nh)
 {
 	int64_t	tbl8_idx;
 	uint8_t	*tbl8_ptr;
 
-	tbl8_idx = tbl8_get_idx(dp);
+	tbl8_idx = tbl8_get(dp);
 	if (tbl8_idx < 0)
 		return tbl8_idx;
 	tbl8_ptr = (uint8_t *)dp->tbl8 +
@@ -210,8 +270,6 @@ tbl8_recycle(struct dir24_8_tbl *dp, uint32_t ip, uint64_t tbl8_idx)
 		}
 		((uint8_t *)dp->tbl24)[ip >> 8] =
 			nh & ~DIR24_8_EXT_ENT;
-		for (i = 0; i < DIR24_8_TBL8_GRP_NUM_ENT; i++)
-			ptr8[i] = 0;
 		break;
 	case RTE_FIB_DIR24_8_2B:
 		ptr16 = &((uint16_t *)dp->tbl8)[tbl8_idx *
@@ -223,8 +281,6 @@ tbl8_recycle(struct dir24_8_tbl *dp, uint32_t ip, uint64_t tbl8_idx)
 		}
 		((uint16_t *)dp->tbl24)[ip >> 8] =
 			nh & ~DIR24_8_EXT_ENT;
-		for (i = 0; i < DIR24_8_TBL8_GRP_NUM_ENT; i++)
-			ptr16[i] = 0;
 		break;
 	case RTE_FIB_DIR24_8_4B:
 		ptr32 = &((uint32_t *)dp->tbl8)[tbl8_idx *
@@ -236,8 +292,6 @@ tbl8_recycle(struct dir24_8_tbl *dp, uint32_t ip, uint64_t tbl8_idx)
 		}
 		((uint32_t *)dp->tbl24)[ip >> 8] =
 			nh & ~DIR24_8_EXT_ENT;
-		for (i = 0; i < DIR24_8_TBL8_GRP_NUM_ENT; i++)
-			ptr32[i] = 0;
 		break;
 	case RTE_FIB_DIR24_8_8B:
 		ptr64 = &((uint64_t *)dp->tbl8)[tbl8_idx *
@@ -249,14 +303,26 @@ tbl8_recycle(struct dir24_8_tbl *dp, uint32_t ip, uint64_t tbl8_idx)
 		}
 		((uint64_t *)dp->tbl24)[ip >> 8] =
 			nh & ~DIR24_8_EXT_ENT;
-		for (i = 0; i < DIR24_8_TBL8_GRP_NUM_ENT; i++)
-			ptr64[i] = 0;
 		break;
 	}
-	tbl8_free_idx(dp, tbl8_idx);
+	tbl8_free(dp, tbl8_idx);
 	dp->cur_tbl8s--;
 }
 
+/*
+ * Check whether the tbl24 entry of an address gives the next hop to its
+ * whole /24 already: writing a part of it would only allocate a tbl8
+ * group to recycle it right after.
+ */
+static inline int
+tbl24_has_nh(struct dir24_8_tbl *dp, uint32_t ip, uint64_t next_hop)
+{
+	uint64_t tbl24_tmp = get_tbl24(dp, ip, dp->nh_sz);
+
+	return ((tbl24_tmp & DIR24_8_EXT_ENT) != DIR24_8_EXT_ENT) &&
+		((tbl24_tmp >> 1) == next_hop);
+}
+
 static int
 install_to_fib(struct dir24_8_tbl *dp, uint32_t ledge, uint32_t redge,
 	uint64_t next_hop)
@@ -271,7 +337,8 @@ install_to_fib(struct dir24_8_tbl *dp, uint32_t ledge, uint32_t redge,
 		((redge & DIR24_8_TBL24_MASK) - ROUNDUP(ledge, 24)) >> 8;
 
 	if (((ledge >> 8) != (redge >> 8)) || (len == 1 << 24)) {
-		if ((ROUNDUP(ledge, 24) - ledge) != 0) {
+		if (((ROUNDUP(ledge, 24) - ledge) != 0) &&
+				!tbl24_has_nh(dp, ledge, next_hop)) {
 			tbl24_tmp = get_tbl24(dp, ledge, dp->nh_sz);
 			if ((tbl24_tmp & DIR24_8_EXT_ENT) !=
 					DIR24_8_EXT_ENT) {
@@ -281,7 +348,7 @@ install_to_fib(struct dir24_8_tbl *dp, uint32_t ledge, uint32_t redge,
 				 * needs tbl8 for ledge and redge.
 				 */
 				tbl8_idx = tbl8_alloc(dp, tbl24_tmp);
-				tmp_tbl8_idx = tbl8_get_idx(dp);
+				tmp_tbl8_idx = tbl8_get(dp);
 				if (tbl8_idx < 0)
 					return -ENOSPC;
 				else if (tmp_tbl8_idx < 0) {
@@ -308,7 +375,8 @@ install_to_fib(struct dir24_8_tbl *dp, uint32_t ledge, uint32_t redge,
 		}
 		write_to_fib(get_tbl24_p(dp, ROUNDUP(ledge, 24), dp->nh_sz),
 			next_hop << 1, dp->nh_sz, len);
-		if (redge & ~DIR24_8_TBL24_MASK) {
+		if ((redge & ~DIR24_8_TBL24_MASK) &&
+				!tbl24_has_nh(dp, redge, next_hop)) {
 			tbl24_tmp = get_tbl24(dp, redge, dp->nh_sz);
 			if ((tbl24_tmp & DIR24_8_EXT_ENT) !=
 					DIR24_8_EXT_ENT) {
@@ -331,7 +399,8 @@ install_to_fib(struct dir24_8_tbl *dp, uint32_t ledge, uint32_t redge,
 				dp->nh_sz, redge & ~DIR24_8_TBL24_MASK);
 			tbl8_recycle(dp, redge, tbl8_idx);
 		}
-	} else if ((redge - ledge) != 0) {
+	} else if (((redge - ledge) != 0) &&
+			!tbl24_has_nh(dp, ledge, next_hop)) {
 		tbl24_tmp = get_tbl24(dp, ledge, dp->nh_sz);
 		if ((tbl24_tmp & DIR24_8_EXT_ENT) !=
 				DIR24_8_EXT_ENT) {
@@ -498,6 +567,347 @@ dir24_8_modify(struct rte_fib *fib, uint32_t ip, uint8_t depth,
 	return -EINVAL;
 }
 
+struct dir24_8_prefix {
+	uint32_t	ip;
+	uint8_t		depth;
+};
+
+/* Change of the RIB made by a bulk update, to revert it on failure */
+struct dir24_8_undo {
+	uint64_t	nh;	/**< next hop before the change */
+	uint32_t	ip;
+	uint8_t		depth;
+	uint8_t		op;	/**< RTE_FIB_ADD of a new route, RTE_FIB_DEL,
+				 * or UINT8_MAX for a next hop change
+				 */
+	int8_t		rsvd;	/**< change of the reserved tbl8 groups */
+};
+
+static int
+prefix_cmp(const void *p1, const void *p2)
+{
+	const struct dir24_8_prefix *a = p1;
+	const struct dir24_8_prefix *b = p2;
+
+	if (a->ip != b->ip)
+		return (a->ip < b->ip) ? -1 : 1;
+	return (int)a->depth - (int)b->depth;
+}
+
+/*
+ * Apply a route of a bulk update to the RIB, leaving the dataplane
+ * untouched, and record in 'undo' how to revert it. Returns 1 if the
+ * prefix has to be installed in the dataplane, 0 if nothing changed or
+ * a negative error.
+ */
+static int
+rib_modify(struct dir24_8_tbl *dp, struct rte_rib *rib,
+	const struct rte_fib_route *route, struct dir24_8_prefix *pfx,
+	struct dir24_8_undo *undo)
+{
+	struct rte_rib_node *tmp = NULL;
+	struct rte_rib_node *node;
+	uint64_t node_nh;
+
+	if ((route->depth > RTE_FIB_MAXDEPTH) ||
+			((route->op == RTE_FIB_ADD) &&
+			(route->next_hop > get_max_nh(dp->nh_sz))))
+		return -EINVAL;
+
+	pfx->ip = route->ip & rte_rib_depth_to_mask(route->depth);
+	pfx->depth = route->depth;
+	undo->ip = pfx->ip;
+	undo->depth = pfx->depth;
+	undo->rsvd = 0;
+
+	node = rte_rib_lookup_exact(rib, pfx->ip, pfx->depth);
+	switch (route->op) {
+	case RTE_FIB_ADD:
+		if (node != NULL) {
+			rte_rib_get_nh(node, &node_nh);
+			if (node_nh == route->next_hop)
+				return 0;
+			rte_rib_set_nh(node, route->next_hop);
+			undo->op = UINT8_MAX;
+			undo->nh = node_nh;
+			return 1;
+		}
+		if (pfx->depth > 24) {
+			tmp = rte_rib_get_nxt(rib, pfx->ip, 24, NULL,
+				RTE_RIB_GET_NXT_COVER);
+			if ((tmp == NULL) &&
+				(dp->rsvd_tbl8s >= dp->number_tbl8s))
+				return -ENOSPC;
+		}
+		node = rte_rib_insert(rib, pfx->ip, pfx->depth);
+		if (node == NULL)
+			return -rte_errno;
+		rte_rib_set_nh(node, route->next_hop);
+		if ((pfx->depth > 24) && (tmp == NULL)) {
+			dp->rsvd_tbl8s++;
+			undo->rsvd = 1;
+		}
+		undo->op = RTE_FIB_ADD;
+		return 1;
+	case RTE_FIB_DEL:
+		if (node == NULL)
+			return -ENOENT;
+		rte_rib_get_nh(node, &undo->nh);
+		rte_rib_remove(rib, pfx->ip, pfx->depth);
+		if (pfx->depth > 24) {
+			tmp = rte_rib_get_nxt(rib, pfx->ip, 24, NULL,
+				RTE_RIB_GET_NXT_COVER);
+			if (tmp == NULL) {
+				dp->rsvd_tbl8s--;
+				undo->rsvd = -1;
+			}
+		}
+		undo->op = RTE_FIB_DEL;
+		return 1;
+	default:
+		break;
+	}
+	return -EINVAL;
+}
+
+/* Revert the RIB changes of a bulk update, latest first */
+static void
+rib_undo(struct dir24_8_tbl *dp, struct rte_rib *rib,
+	const struct dir24_8_undo *undo, unsigned int nb_undo)
+{
+	struct rte_rib_node *node;
+
+	while (nb_undo-- != 0) {
+		switch (undo[nb_undo].op) {
+		case RTE_FIB_ADD:
+			rte_rib_remove(rib, undo[nb_undo].ip,
+				undo[nb_undo].depth);
+			break;
+		case RTE_FIB_DEL:
+			/* the node of the deleted route is free again */
+			node = rte_rib_insert(rib, undo[nb_undo].ip,
+				undo[nb_undo].depth);
+			RTE_ASSERT(node != NULL);
+			rte_rib_set_nh(node, undo[nb_undo].nh);
+			break;
+		default:
+			node = rte_rib_lookup_exact(rib, undo[nb_undo].ip,
+				undo[nb_undo].depth);
+			rte_rib_set_nh(node, undo[nb_undo].nh);
+			break;
+		}
+		dp->rsvd_tbl8s -= undo[nb_undo].rsvd;
+	}
+}
+
+/*
+ * Install a prefix modified by a bulk update, 'pfxs' being the sorted
+ * prefixes modified along with it. The parts of the prefix not covered
+ * by more specific routes get its next hop, or the one of the closest
+ * covering route if it was deleted. A deleted prefix is skipped when
+ * one of 'pfxs' lies between it and this covering route, since that
+ * one writes the same entries.
+ */
+static int
+prefix_install(struct dir24_8_tbl *dp, struct rte_rib *rib,
+	const struct dir24_8_prefix *pfx, const struct dir24_8_prefix *pfxs,
+	unsigned int nb_pfxs)
+{
+	struct rte_rib_node *node;
+	struct dir24_8_prefix key;
+	uint64_t nh = dp->def_nh;
+	uint8_t depth = 0;
+
+	node = rte_rib_lookup_exact(rib, pfx->ip, pfx->depth);
+	if (node != NULL) {
+		rte_rib_get_nh(node, &nh);
+		return modify_fib(dp, rib, pfx->ip, pfx->depth, nh);
+	}
+
+	for (node = rte_rib_lookup(rib, pfx->ip); node != NULL;
+			node = rte_rib_lookup_parent(node)) {
+		rte_rib_get_depth(node, &depth);
+		if (depth < pfx->depth) {
+			rte_rib_get_nh(node, &nh);
+			break;
+		}
+	}
+	if (node == NULL)
+		depth = 0;
+
+	for (key.depth = depth; key.depth < pfx->depth; key.depth++) {
+		key.ip = pfx->ip & rte_rib_depth_to_mask(key.depth);
+		if (bsearch(&key, pfxs, nb_pfxs, sizeof(key),
+				prefix_cmp) != NULL)
+			return 0;
+	}
+
+	return modify_fib(dp, rib, pfx->ip, pfx->depth, nh);
+}
+
+static int
+prefix_depth_cmp(const void *p1, const void *p2)
+{
+	const struct dir24_8_prefix *a = p1;
+	const struct dir24_8_prefix *b = p2;
+
+	if (a->depth != b->depth)
+		return (int)b->depth - (int)a->depth;
+	return (a->ip < b->ip) ? -1 : (a->ip > b->ip);
+}
+
+/*
+ * Install the sorted prefixes modified by a chunk of a bulk update.
+ * The prefixes removed from the RIB go first, so that the tbl8 groups
+ * they release can be used by the others. These go from the most to the
+ * least specific, so that the edges of a prefix fall in the tbl8 groups
+ * of its more specific routes rather than in new ones.
+ */
+static int
+chunk_install(struct dir24_8_tbl *dp, struct rte_rib *rib,
+	const struct dir24_8_prefix *pfxs, unsigned int nb_pfxs)
+{
+	struct dir24_8_prefix order[DIR24_8_BULK_CHUNK];
+	unsigned int k, nb_del, nb_add;
+	int ret;
+
+	nb_del = 0;
+	nb_add = nb_pfxs;
+	for (k = 0; k != nb_pfxs; k++) {
+		if (rte_rib_lookup_exact(rib, pfxs[k].ip,
+				pfxs[k].depth) == NULL)
+			order[nb_del++] = pfxs[k];
+		else
+			order[--nb_add] = pfxs[k];
+	}
+	qsort(&order[nb_add], nb_pfxs - nb_add, sizeof(order[0]),
+		prefix_depth_cmp);
+
+	for (k = 0; k != nb_pfxs; k++) {
+		ret = prefix_install(dp, rib, &order[k], pfxs, nb_pfxs);
+		if (ret != 0)
+			return ret;
+	}
+
+	return 0;
+}
+
+unsigned int
+dir24_8_modify_bulk(struct rte_fib *fib, const struct rte_fib_route *routes,
+	unsigned int n)
+{
+	struct dir24_8_prefix pfxs[DIR24_8_BULK_CHUNK];
+	struct dir24_8_undo undo[DIR24_8_BULK_CHUNK];
+	struct dir24_8_tbl *dp;
+	struct rte_rib *rib;
+	unsigned int i, j, k, nb_pfxs, nb_uniq;
+	int ret = 0;
+
+	dp = rte_fib_get_dp(fib);
+	rib = rte_fib_get_rib(fib);
+	RTE_ASSERT((dp != NULL) && (rib != NULL));
+
+	for (i = 0; i != n; i = j) {
+		/* update the RIB with a chunk of routes */
+		nb_pfxs = 0;
+		for (j = i; (j != n) && (j - i != DIR24_8_BULK_CHUNK); j++) {
+			ret = rib_modify(dp, rib, &routes[j], &pfxs[nb_pfxs],
+				&undo[nb_pfxs]);
+			if (ret < 0)
+				break;
+			nb_pfxs += ret;
+		}
+
+		/* then install each modified prefix once */
+		qsort(pfxs, nb_pfxs, sizeof(pfxs[0]), prefix_cmp);
+		for (k = 0, nb_uniq = 0; k != nb_pfxs; k++) {
+			if ((nb_uniq == 0) ||
+					(prefix_cmp(&pfxs[nb_uniq - 1],
+					&pfxs[k]) != 0))
+				pfxs[nb_uniq++] = pfxs[k];
+		}
+		if (chunk_install(dp, rib, pfxs, nb_uniq) != 0) {
+			/*
+			 * Revert the chunk in the RIB and reinstall its
+			 * prefixes as they were. If this needs the tbl8
+			 * groups released meanwhile, wait for the readers
+			 * to be done with them.
+			 */
+			rib_undo(dp, rib, undo, nb_pfxs);
+			ret = chunk_install(dp, rib, pfxs, nb_uniq);
+			if ((ret != 0) && (dp->dq != NULL)) {
+				rte_rcu_qsbr_synchronize(dp->v,
+					RTE_QSBR_THRID_INVALID);
+				rte_rcu_qsbr_dq_reclaim(dp->dq, UINT32_MAX,
+					NULL, NULL, NULL);
+				ret = chunk_install(dp, rib, pfxs, nb_uniq);
+			}
+			if (ret != 0) {
+				RTE_LOG(ERR, LPM,
+					"Can not restore reverted routes: %d\n",
+					ret);
+				rte_errno = EFAULT;
+			} else
+				rte_errno = ENOSPC;
+			return i;
+		}
+
+		if (dp->dq != NULL)
+			rte_rcu_qsbr_dq_reclaim(dp->dq,
+				RTE_FIB_RCU_DQ_RECLAIM_MAX, NULL, NULL, NULL);
+
+		if (ret < 0) {
+			rte_errno = -ret;
+			return j;
+		}
+	}
+
+	return n;
+}
+
+int
+dir24_8_rcu_qsbr_add(struct dir24_8_tbl *dp, struct rte_fib_rcu_config *cfg,
+	const char *name)
+{
+	struct rte_rcu_qsbr_dq_parameters params = {0};
+	char rcu_dq_name[RTE_RCU_QSBR_DQ_NAMESIZE];
+
+	if (dp == NULL || cfg == NULL)
+		return -EINVAL;
+
+	if (dp->v != NULL)
+		return -EEXIST;
+
+	if (cfg->mode == RTE_FIB_QSBR_MODE_SYNC) {
+		/* No other things to do. */
+	} else if (cfg->mode == RTE_FIB_QSBR_MODE_DQ) {
+		/* Init QSBR defer queue. */
+		snprintf(rcu_dq_name, sizeof(rcu_dq_name),
+				"FIB_RCU_%s", name);
+		params.name = rcu_dq_name;
+		params.size = cfg->dq_size;
+		if (params.size == 0)
+			params.size = dp->number_tbl8s;
+		params.trigger_reclaim_limit = cfg->reclaim_thd;
+		params.max_reclaim_size = cfg->reclaim_max;
+		if (params.max_reclaim_size == 0)
+			params.max_reclaim_size = RTE_FIB_RCU_DQ_RECLAIM_MAX;
+		params.esize = sizeof(uint64_t);	/* tbl8 group index */
+		params.free_fn = __rcu_qsbr_free_resource;
+		params.p = dp;
+		params.v = cfg->v;
+		dp->dq = rte_rcu_qsbr_dq_create(&params);
+		if (dp->dq == NULL)
+			return -rte_errno;
+	} else
+		return -EINVAL;
+
+	dp->rcu_mode = cfg->mode;
+	dp->v = cfg->v;
+
+	return 0;
+}
+
 void *
 dir24_8_create(const char *name, int socket_id, struct rte_fib_conf *fib_conf)
 {
@@ -569,6 +979,8 @@ dir24_8_free(void *p)
 {
 	struct dir24_8_tbl *dp = (struct dir24_8_tbl *)p;
 
+	if (dp->dq != NULL)
+		rte_rcu_qsbr_dq_delete(dp->dq);
 	rte_free(dp->tbl8_idxes);
 	rte_free(dp->tbl8);
 	rte_free(dp);
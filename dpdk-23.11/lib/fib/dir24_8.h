@@ -31,6 +31,10 @@ struct dir24_8_tbl {
 	uint64_t	def_nh;		/**< Default next hop */
 	uint64_t	*tbl8;		/**< tbl8 table. */
 	uint64_t	*tbl8_idxes;	/**< bitmap containing free tbl8 idxes*/
+	/* RCU config. */
+	enum rte_fib_qsbr_mode	rcu_mode;/* Blocking, defer queue. */
+	struct rte_rcu_qsbr	*v;	/* RCU QSBR variable. */
+	struct rte_rcu_qsbr_dq	*dq;	/* RCU QSBR defer queue. */
 	/* tbl24 table. */
 	__extension__ uint64_t	tbl24[0] __rte_cache_aligned;
 };
@@ -248,4 +252,12 @@ int
 dir24_8_modify(struct rte_fib *fib, uint32_t ip, uint8_t depth,
 	uint64_t next_hop, int op);
 
+unsigned int
+dir24_8_modify_bulk(struct rte_fib *fib, const struct rte_fib_route *routes,
+	unsigned int n);
+
+int
+dir24_8_rcu_qsbr_add(struct dir24_8_tbl *dp, struct rte_fib_rcu_config *cfg,
+	const char *name);
+
 #endif /* _DIR24_8_H_ */
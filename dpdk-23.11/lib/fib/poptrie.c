@@ -0,0 +1,905 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <rte_debug.h>
+#include <rte_malloc.h>
+#include <rte_errno.h>
+#include <rte_vect.h>
+
+#include <rte_rib.h>
+#include <rte_rib6.h>
+#include <rte_fib.h>
+#include <rte_fib6.h>
+#include "poptrie.h"
+
+#ifdef CC_POPTRIE_AVX512_SUPPORT
+
+#include "poptrie_avx512.h"
+
+#endif /* CC_POPTRIE_AVX512_SUPPORT */
+
+#define POPTRIE_NAMESIZE	64
+
+/* RCU defer queue entry: pool, block order and block index */
+#define POPTRIE_DQ_LEAF_POOL	(1ULL << 40)
+#define POPTRIE_DQ_ORDER_SHIFT	32
+#define POPTRIE_DQ_ORDER_MASK	0xff
+
+/* Context of a trie update */
+struct poptrie_build {
+	struct poptrie_tbl	*dp;
+	void			*rib;
+	/* RIB accessors, addresses being 128-bit big endian numbers */
+	int (*lookup_exact)(void *rib, uint64_t hi, uint64_t lo,
+		uint8_t depth, uint64_t *nh);
+	int (*has_more_specific)(void *rib, uint64_t hi, uint64_t lo,
+		uint8_t depth);
+	/* updated prefix */
+	uint64_t		hi;
+	uint64_t		lo;
+	uint8_t			depth;
+	/* release blocks once readers are done with them */
+	int			retire;
+};
+
+static inline int
+vector_supported(void)
+{
+#ifdef CC_POPTRIE_AVX512_SUPPORT
+	return (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512F) > 0) &&
+		(rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512BW) > 0) &&
+		(rte_vect_get_max_simd_bitwidth() >= RTE_VECT_SIMD_512);
+#else
+	return 0;
+#endif
+}
+
+static inline rte_fib_lookup_fn_t
+get_vector_fn(void)
+{
+#ifdef CC_POPTRIE_AVX512_SUPPORT
+	if (vector_supported())
+		return rte_poptrie_vec_lookup_bulk;
+#endif
+	return NULL;
+}
+
+static inline rte_fib6_lookup_fn_t
+get_vector_fn6(void)
+{
+#ifdef CC_POPTRIE_AVX512_SUPPORT
+	if (vector_supported())
+		return rte_poptrie6_vec_lookup_bulk;
+#endif
+	return NULL;
+}
+
+rte_fib_lookup_fn_t
+poptrie_get_lookup_fn(void *p, enum rte_fib_lookup_type type)
+{
+	rte_fib_lookup_fn_t ret_fn;
+
+	if (p == NULL)
+		return NULL;
+
+	switch (type) {
+	case RTE_FIB_LOOKUP_POPTRIE_SCALAR:
+		return poptrie_lookup_bulk;
+	case RTE_FIB_LOOKUP_POPTRIE_VECTOR_AVX512:
+		return get_vector_fn();
+	case RTE_FIB_LOOKUP_DEFAULT:
+		ret_fn = get_vector_fn();
+		return (ret_fn != NULL) ? ret_fn : poptrie_lookup_bulk;
+	default:
+		return NULL;
+	}
+}
+
+rte_fib6_lookup_fn_t
+poptrie6_get_lookup_fn(void *p, enum rte_fib6_lookup_type type)
+{
+	rte_fib6_lookup_fn_t ret_fn;
+
+	if (p == NULL)
+		return NULL;
+
+	switch (type) {
+	case RTE_FIB6_LOOKUP_POPTRIE_SCALAR:
+		return poptrie6_lookup_bulk;
+	case RTE_FIB6_LOOKUP_POPTRIE_VECTOR_AVX512:
+		return get_vector_fn6();
+	case RTE_FIB6_LOOKUP_DEFAULT:
+		ret_fn = get_vector_fn6();
+		return (ret_fn != NULL) ? ret_fn : poptrie6_lookup_bulk;
+	default:
+		return NULL;
+	}
+}
+
+static inline void
+key_mask(uint64_t *hi, uint64_t *lo, uint8_t depth)
+{
+	if (depth == 0) {
+		*hi = 0;
+		*lo = 0;
+	} else if (depth <= 64) {
+		*hi &= UINT64_MAX << (64 - depth);
+		*lo = 0;
+	} else
+		*lo &= UINT64_MAX << (128 - depth);
+}
+
+/*
+ * Set the bits of a key ending at depth to val. The bits consumed by
+ * a node never cross the 64-bit boundary.
+ */
+static inline void
+key_set(uint64_t *hi, uint64_t *lo, uint8_t depth, uint64_t val)
+{
+	if (depth <= 64)
+		*hi |= val << (64 - depth);
+	else
+		*lo |= val << (128 - depth);
+}
+
+/* Check if the prefix is covered by the updated one or covers it */
+static inline int
+upd_intersect(const struct poptrie_build *b, uint64_t hi, uint64_t lo,
+	uint8_t depth)
+{
+	uint64_t uhi = b->hi;
+	uint64_t ulo = b->lo;
+
+	depth = RTE_MIN(depth, b->depth);
+	key_mask(&hi, &lo, depth);
+	key_mask(&uhi, &ulo, depth);
+	return (hi == uhi) && (lo == ulo);
+}
+
+static void
+pool_init(struct poptrie_pool *pool, void *base, uint32_t unit_sz,
+	uint32_t size)
+{
+	int i;
+
+	pool->base = base;
+	pool->unit_sz = unit_sz;
+	pool->size = size;
+	pool->next = 0;
+	for (i = 0; i < POPTRIE_NUM_ORDERS; i++)
+		pool->free[i] = POPTRIE_NIL;
+}
+
+static inline uint32_t *
+pool_link(struct poptrie_pool *pool, uint32_t idx)
+{
+	return (uint32_t *)((uint8_t *)pool->base +
+		(size_t)idx * pool->unit_sz);
+}
+
+static void
+pool_put(struct poptrie_pool *pool, uint32_t idx, uint32_t order)
+{
+	*pool_link(pool, idx) = pool->free[order];
+	pool->free[order] = idx;
+}
+
+/*
+ * Get a block of 1 << order units, splitting a bigger free block if
+ * needed. Free blocks are never merged back.
+ */
+static uint32_t
+pool_get(struct poptrie_pool *pool, uint32_t order)
+{
+	uint32_t idx, o;
+
+	for (o = order; (o < POPTRIE_NUM_ORDERS) &&
+			(pool->free[o] == POPTRIE_NIL); o++)
+		;
+	if (o < POPTRIE_NUM_ORDERS) {
+		idx = pool->free[o];
+		pool->free[o] = *pool_link(pool, idx);
+		for (; o > order; o--)
+			pool_put(pool, idx + (1U << (o - 1)), o - 1);
+		return idx;
+	}
+
+	if (pool->size - pool->next < (1U << order))
+		return POPTRIE_NIL;
+	idx = pool->next;
+	pool->next += 1U << order;
+	return idx;
+}
+
+static uint32_t
+block_alloc(struct poptrie_tbl *dp, struct poptrie_pool *pool, uint32_t n)
+{
+	uint32_t order = rte_log2_u32(n);
+	unsigned int freed;
+	uint32_t idx;
+
+	idx = pool_get(pool, order);
+	/* If there is no room try to reclaim blocks released earlier. */
+	while ((idx == POPTRIE_NIL) && (dp->dq != NULL) &&
+			(rte_rcu_qsbr_dq_reclaim(dp->dq,
+			RTE_FIB_RCU_DQ_RECLAIM_MAX, &freed, NULL, NULL) == 0) &&
+			(freed != 0))
+		idx = pool_get(pool, order);
+
+	return idx;
+}
+
+static void
+__rcu_qsbr_free_resource(void *p, void *data, unsigned int n)
+{
+	struct poptrie_tbl *dp = p;
+	uint64_t blk = *(uint64_t *)data;
+
+	RTE_SET_USED(n);
+	pool_put((blk & POPTRIE_DQ_LEAF_POOL) ? &dp->leaf_pool :
+		&dp->node_pool, (uint32_t)blk,
+		(blk >> POPTRIE_DQ_ORDER_SHIFT) & POPTRIE_DQ_ORDER_MASK);
+}
+
+/*
+ * Release a block of n units. Blocks of the replaced trie may still
+ * be used by the readers, they are freed through the RCU defer queue
+ * if there is one.
+ */
+static void
+block_free(struct poptrie_build *b, struct poptrie_pool *pool, uint32_t idx,
+	uint32_t n)
+{
+	struct poptrie_tbl *dp = b->dp;
+	uint32_t order = rte_log2_u32(n);
+	uint64_t blk;
+
+	if (n == 0)
+		return;
+
+	if ((b->retire == 0) || (dp->dq == NULL)) {
+		pool_put(pool, idx, order);
+		return;
+	}
+
+	blk = ((pool == &dp->leaf_pool) ? POPTRIE_DQ_LEAF_POOL : 0) |
+		((uint64_t)order << POPTRIE_DQ_ORDER_SHIFT) | idx;
+	/* Push into QSBR defer queue, or wait if it is full. */
+	if (rte_rcu_qsbr_dq_enqueue(dp->dq, &blk) != 0) {
+		rte_rcu_qsbr_synchronize(dp->v, RTE_QSBR_THRID_INVALID);
+		pool_put(pool, idx, order);
+	}
+}
+
+static void
+node_release(struct poptrie_build *b, uint64_t hi, uint64_t lo, uint8_t len,
+	const struct poptrie_node *node);
+
+/*
+ * Release the first n children of a node, except the ones outside
+ * of the updated prefix which are shared by the old and new tries.
+ */
+static void
+children_release(struct poptrie_build *b, uint64_t hi, uint64_t lo,
+	uint8_t len, const struct poptrie_node *node, uint32_t n)
+{
+	uint8_t clen = len + POPTRIE_STRIDE;
+	uint64_t vector, chi, clo;
+	uint32_t i;
+
+	for (i = 0, vector = node->vector; i != n; i++,
+			vector &= vector - 1) {
+		chi = hi;
+		clo = lo;
+		key_set(&chi, &clo, clen, rte_ctz64(vector));
+		if (upd_intersect(b, chi, clo, clen))
+			node_release(b, chi, clo, clen,
+				&b->dp->nodes[node->base1 + i]);
+	}
+}
+
+static void
+node_release(struct poptrie_build *b, uint64_t hi, uint64_t lo, uint8_t len,
+	const struct poptrie_node *node)
+{
+	uint32_t nb_children = rte_popcount64(node->vector);
+
+	children_release(b, hi, lo, len, node, nb_children);
+	block_free(b, &b->dp->node_pool, node->base1, nb_children);
+	block_free(b, &b->dp->leaf_pool, node->base0,
+		rte_popcount64(node->leafvec));
+}
+
+/*
+ * Build the node for the prefix hi/lo of length len from the RIB,
+ * inh being the next hop of the prefix. The children which are not
+ * affected by the update are shared with the old node.
+ */
+static int
+node_build(struct poptrie_build *b, uint64_t hi, uint64_t lo, uint8_t len,
+	uint32_t inh, const struct poptrie_node *old, struct poptrie_node *dst)
+{
+	struct poptrie_tbl *dp = b->dp;
+	const struct poptrie_node *old_child;
+	struct poptrie_node node;
+	uint32_t nhs[POPTRIE_NODE_NUM_ENT];
+	uint8_t clen = len + POPTRIE_STRIDE;
+	uint64_t vector, chi, clo, nh;
+	uint32_t i, j, pos, span, last;
+	uint8_t l;
+	int ret;
+
+	/* Next hop of each position, longer prefixes first */
+	for (i = 0; i < POPTRIE_NODE_NUM_ENT; i++)
+		nhs[i] = inh;
+	for (l = len + 1; l <= RTE_MIN(clen, dp->key_len); l++) {
+		span = 1U << (clen - l);
+		for (j = 0; j < (1U << (l - len)); j++) {
+			chi = hi;
+			clo = lo;
+			key_set(&chi, &clo, l, j);
+			if (b->lookup_exact(b->rib, chi, clo, l, &nh) == 0)
+				continue;
+			for (i = j * span; i < (j + 1) * span; i++)
+				nhs[i] = nh;
+		}
+	}
+
+	/* Positions with more specific prefixes are child nodes */
+	node.vector = 0;
+	if (clen < dp->key_len) {
+		for (i = 0; i < POPTRIE_NODE_NUM_ENT; i++) {
+			chi = hi;
+			clo = lo;
+			key_set(&chi, &clo, clen, i);
+			if (b->has_more_specific(b->rib, chi, clo, clen))
+				node.vector |= 1ULL << i;
+		}
+	}
+
+	/* Other ones are leaves, stored once per run of equal next hops */
+	node.leafvec = 0;
+	for (i = 0, last = POPTRIE_NIL; i < POPTRIE_NODE_NUM_ENT; i++) {
+		if ((node.vector & (1ULL << i)) != 0)
+			continue;
+		if ((last == POPTRIE_NIL) || (nhs[i] != nhs[last]))
+			node.leafvec |= 1ULL << i;
+		last = i;
+	}
+
+	node.base0 = POPTRIE_NIL;
+	if (node.leafvec != 0) {
+		node.base0 = block_alloc(dp, &dp->leaf_pool,
+			rte_popcount64(node.leafvec));
+		if (node.base0 == POPTRIE_NIL)
+			return -ENOSPC;
+		for (i = 0, j = node.base0; i < POPTRIE_NODE_NUM_ENT; i++)
+			if ((node.leafvec & (1ULL << i)) != 0)
+				dp->leaves[j++] = nhs[i];
+	}
+
+	node.base1 = POPTRIE_NIL;
+	if (node.vector != 0) {
+		node.base1 = block_alloc(dp, &dp->node_pool,
+			rte_popcount64(node.vector));
+		if (node.base1 == POPTRIE_NIL) {
+			ret = -ENOSPC;
+			goto free_leaves;
+		}
+	}
+
+	for (i = 0, vector = node.vector; vector != 0; i++,
+			vector &= vector - 1) {
+		pos = rte_ctz64(vector);
+		chi = hi;
+		clo = lo;
+		key_set(&chi, &clo, clen, pos);
+		old_child = NULL;
+		if ((old != NULL) && ((old->vector & (1ULL << pos)) != 0))
+			old_child = &dp->nodes[old->base1 +
+				rte_popcount64(old->vector &
+				((2ULL << pos) - 1)) - 1];
+		if (!upd_intersect(b, chi, clo, clen)) {
+			/* Not affected by the update, share the subtrie. */
+			RTE_ASSERT(old_child != NULL);
+			dp->nodes[node.base1 + i] = *old_child;
+			continue;
+		}
+		ret = node_build(b, chi, clo, clen, nhs[pos],
+			(b->depth > clen) ? old_child : NULL,
+			&dp->nodes[node.base1 + i]);
+		if (ret != 0)
+			goto free_children;
+	}
+
+	*dst = node;
+	return 0;
+
+free_children:
+	children_release(b, hi, lo, len, &node, i);
+	block_free(b, &dp->node_pool, node.base1, rte_popcount64(node.vector));
+free_leaves:
+	block_free(b, &dp->leaf_pool, node.base0,
+		rte_popcount64(node.leafvec));
+	return ret;
+}
+
+/* Build the direct pointing entry idx from the RIB, nh being its next hop */
+static int
+dir_build(struct poptrie_build *b, uint32_t idx, uint64_t nh, uint32_t *ent)
+{
+	struct poptrie_tbl *dp = b->dp;
+	const struct poptrie_node *old = NULL;
+	uint64_t hi = (uint64_t)idx << (64 - POPTRIE_DIR_BITS);
+	uint32_t root;
+	int ret;
+
+	if (!b->has_more_specific(b->rib, hi, 0, POPTRIE_DIR_BITS)) {
+		*ent = nh | POPTRIE_LEAF;
+		return 0;
+	}
+
+	if ((b->depth > POPTRIE_DIR_BITS) &&
+			((dp->dir[idx] & POPTRIE_LEAF) == 0))
+		old = &dp->nodes[dp->dir[idx]];
+
+	root = block_alloc(dp, &dp->node_pool, 1);
+	if (root == POPTRIE_NIL)
+		return -ENOSPC;
+	ret = node_build(b, hi, 0, POPTRIE_DIR_BITS, nh, old,
+		&dp->nodes[root]);
+	if (ret != 0) {
+		block_free(b, &dp->node_pool, root, 1);
+		return ret;
+	}
+
+	*ent = root;
+	return 0;
+}
+
+/*
+ * Build the direct pointing entries covered by the prefix hi/len, nh
+ * being its next hop, in ascending order. The RIB is walked down bit
+ * by bit as long as it has more specific routes.
+ */
+static int
+dir_range_build(struct poptrie_build *b, uint64_t hi, uint8_t len,
+	uint64_t nh, uint32_t *ents, uint32_t *nb)
+{
+	uint64_t chi, cnh;
+	uint32_t i;
+	int ret;
+
+	if (len == POPTRIE_DIR_BITS) {
+		ret = dir_build(b, hi >> (64 - POPTRIE_DIR_BITS), nh, &ents[*nb]);
+		if (ret == 0)
+			(*nb)++;
+		return ret;
+	}
+
+	if (!b->has_more_specific(b->rib, hi, 0, len)) {
+		for (i = 0; i < (1U << (POPTRIE_DIR_BITS - len)); i++)
+			ents[(*nb)++] = nh | POPTRIE_LEAF;
+		return 0;
+	}
+
+	for (i = 0; i < 2; i++) {
+		chi = hi | ((uint64_t)i << (63 - len));
+		cnh = nh;
+		b->lookup_exact(b->rib, chi, 0, len + 1, &cnh);
+		ret = dir_range_build(b, chi, len + 1, cnh, ents, nb);
+		if (ret != 0)
+			return ret;
+	}
+	return 0;
+}
+
+static void
+dir_release(struct poptrie_build *b, uint32_t idx, uint32_t ent)
+{
+	if ((ent & POPTRIE_LEAF) != 0)
+		return;
+
+	node_release(b, (uint64_t)idx << (64 - POPTRIE_DIR_BITS), 0,
+		POPTRIE_DIR_BITS, &b->dp->nodes[ent]);
+	block_free(b, &b->dp->node_pool, ent, 1);
+}
+
+/*
+ * Rebuild the part of the trie covered by the updated prefix, the RIB
+ * being already updated.
+ */
+static int
+poptrie_update(struct poptrie_build *b)
+{
+	struct poptrie_tbl *dp = b->dp;
+	uint8_t len = RTE_MIN(b->depth, POPTRIE_DIR_BITS);
+	uint64_t hi, lo = 0, nh = dp->def_nh;
+	uint32_t first, nb, i, ent, old;
+	uint32_t *ents;
+	int depth, ret;
+
+	/* Next hop of the longest prefix covering the updated entries */
+	for (depth = len; depth >= 0; depth--) {
+		hi = b->hi;
+		key_mask(&hi, &lo, depth);
+		if (b->lookup_exact(b->rib, hi, lo, depth, &nh) != 0)
+			break;
+	}
+
+	first = b->hi >> (64 - POPTRIE_DIR_BITS);
+	nb = 1U << (POPTRIE_DIR_BITS - len);
+	ents = (nb == 1) ? &ent : rte_malloc(NULL, nb * sizeof(*ents), 0);
+	if (ents == NULL)
+		return -ENOMEM;
+
+	b->retire = 0;
+	hi = b->hi;
+	key_mask(&hi, &lo, len);
+	i = 0;
+	ret = dir_range_build(b, hi, len, nh, ents, &i);
+	if (ret != 0) {
+		while (i-- != 0)
+			dir_release(b, first + i, ents[i]);
+		goto exit;
+	}
+
+	/* Switch to the new subtries, then release the old ones. */
+	for (i = 0; i != nb; i++) {
+		old = dp->dir[first + i];
+		__atomic_store_n(&dp->dir[first + i], ents[i],
+			__ATOMIC_RELEASE);
+		ents[i] = old;
+	}
+
+	if ((dp->v != NULL) && (dp->rcu_mode == RTE_FIB_QSBR_MODE_SYNC))
+		/* Wait for quiescent state change. */
+		rte_rcu_qsbr_synchronize(dp->v, RTE_QSBR_THRID_INVALID);
+
+	b->retire = 1;
+	for (i = 0; i != nb; i++)
+		dir_release(b, first + i, ents[i]);
+
+exit:
+	if (ents != &ent)
+		rte_free(ents);
+	return ret;
+}
+
+static int
+rib_lookup_exact(void *rib, uint64_t hi, __rte_unused uint64_t lo,
+	uint8_t depth, uint64_t *nh)
+{
+	struct rte_rib_node *node;
+
+	node = rte_rib_lookup_exact(rib, hi >> 32, depth);
+	if (node == NULL)
+		return 0;
+	rte_rib_get_nh(node, nh);
+	return 1;
+}
+
+static int
+rib_has_more_specific(void *rib, uint64_t hi, __rte_unused uint64_t lo,
+	uint8_t depth)
+{
+	return rte_rib_get_nxt(rib, hi >> 32, depth, NULL,
+		RTE_RIB_GET_NXT_COVER) != NULL;
+}
+
+static inline void
+ip6_to_key(const uint8_t ip[RTE_FIB6_IPV6_ADDR_SIZE], uint64_t *hi,
+	uint64_t *lo)
+{
+	*hi = rte_be_to_cpu_64(*(const unaligned_uint64_t *)&ip[0]);
+	*lo = rte_be_to_cpu_64(*(const unaligned_uint64_t *)&ip[8]);
+}
+
+static inline void
+key_to_ip6(uint64_t hi, uint64_t lo, uint8_t ip[RTE_FIB6_IPV6_ADDR_SIZE])
+{
+	*(unaligned_uint64_t *)&ip[0] = rte_cpu_to_be_64(hi);
+	*(unaligned_uint64_t *)&ip[8] = rte_cpu_to_be_64(lo);
+}
+
+static int
+rib6_lookup_exact(void *rib, uint64_t hi, uint64_t lo, uint8_t depth,
+	uint64_t *nh)
+{
+	uint8_t ip[RTE_FIB6_IPV6_ADDR_SIZE];
+	struct rte_rib6_node *node;
+
+	key_to_ip6(hi, lo, ip);
+	node = rte_rib6_lookup_exact(rib, ip, depth);
+	if (node == NULL)
+		return 0;
+	rte_rib6_get_nh(node, nh);
+	return 1;
+}
+
+static int
+rib6_has_more_specific(void *rib, uint64_t hi, uint64_t lo, uint8_t depth)
+{
+	uint8_t ip[RTE_FIB6_IPV6_ADDR_SIZE];
+
+	key_to_ip6(hi, lo, ip);
+	return rte_rib6_get_nxt(rib, ip, depth, NULL,
+		RTE_RIB6_GET_NXT_COVER) != NULL;
+}
+
+int
+poptrie_modify(struct rte_fib *fib, uint32_t ip, uint8_t depth,
+	uint64_t next_hop, int op)
+{
+	struct poptrie_build b;
+	struct rte_rib_node *node;
+	struct rte_rib *rib;
+	uint64_t node_nh = 0;
+	int ret, found;
+
+	if ((fib == NULL) || (depth > RTE_FIB_MAXDEPTH) ||
+			(next_hop > POPTRIE_MAX_NH))
+		return -EINVAL;
+
+	b.dp = rte_fib_get_dp(fib);
+	rib = rte_fib_get_rib(fib);
+	RTE_ASSERT((b.dp != NULL) && (rib != NULL));
+
+	ip &= rte_rib_depth_to_mask(depth);
+
+	node = rte_rib_lookup_exact(rib, ip, depth);
+	found = (node != NULL);
+	if (found)
+		rte_rib_get_nh(node, &node_nh);
+
+	switch (op) {
+	case RTE_FIB_ADD:
+		if (found && (node_nh == next_hop))
+			return 0;
+		if (!found) {
+			node = rte_rib_insert(rib, ip, depth);
+			if (node == NULL)
+				return -rte_errno;
+		}
+		rte_rib_set_nh(node, next_hop);
+		break;
+	case RTE_FIB_DEL:
+		if (!found)
+			return -ENOENT;
+		rte_rib_remove(rib, ip, depth);
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	b.rib = rib;
+	b.lookup_exact = rib_lookup_exact;
+	b.has_more_specific = rib_has_more_specific;
+	b.hi = (uint64_t)ip << 32;
+	b.lo = 0;
+	b.depth = depth;
+	ret = poptrie_update(&b);
+	if (ret == 0)
+		return 0;
+
+	/* Restore the RIB. */
+	if (!found)
+		rte_rib_remove(rib, ip, depth);
+	else {
+		if (op == RTE_FIB_DEL)
+			node = rte_rib_insert(rib, ip, depth);
+		if (node != NULL)
+			rte_rib_set_nh(node, node_nh);
+	}
+	return ret;
+}
+
+int
+poptrie6_modify(struct rte_fib6 *fib, const uint8_t ip[RTE_FIB6_IPV6_ADDR_SIZE],
+	uint8_t depth, uint64_t next_hop, int op)
+{
+	uint8_t ip_masked[RTE_FIB6_IPV6_ADDR_SIZE];
+	struct poptrie_build b;
+	struct rte_rib6_node *node;
+	struct rte_rib6 *rib;
+	uint64_t node_nh = 0;
+	int ret, found;
+
+	if ((fib == NULL) || (ip == NULL) || (depth > RTE_FIB6_MAXDEPTH) ||
+			(next_hop > POPTRIE_MAX_NH))
+		return -EINVAL;
+
+	b.dp = rte_fib6_get_dp(fib);
+	rib = rte_fib6_get_rib(fib);
+	RTE_ASSERT((b.dp != NULL) && (rib != NULL));
+
+	ip6_to_key(ip, &b.hi, &b.lo);
+	key_mask(&b.hi, &b.lo, depth);
+	key_to_ip6(b.hi, b.lo, ip_masked);
+
+	node = rte_rib6_lookup_exact(rib, ip_masked, depth);
+	found = (node != NULL);
+	if (found)
+		rte_rib6_get_nh(node, &node_nh);
+
+	switch (op) {
+	case RTE_FIB6_ADD:
+		if (found && (node_nh == next_hop))
+			return 0;
+		if (!found) {
+			node = rte_rib6_insert(rib, ip_masked, depth);
+			if (node == NULL)
+				return -rte_errno;
+		}
+		rte_rib6_set_nh(node, next_hop);
+		break;
+	case RTE_FIB6_DEL:
+		if (!found)
+			return -ENOENT;
+		rte_rib6_remove(rib, ip_masked, depth);
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	b.rib = rib;
+	b.lookup_exact = rib6_lookup_exact;
+	b.has_more_specific = rib6_has_more_specific;
+	b.depth = depth;
+	ret = poptrie_update(&b);
+	if (ret == 0)
+		return 0;
+
+	/* Restore the RIB. */
+	if (!found)
+		rte_rib6_remove(rib, ip_masked, depth);
+	else {
+		if (op == RTE_FIB6_DEL)
+			node = rte_rib6_insert(rib, ip_masked, depth);
+		if (node != NULL)
+			rte_rib6_set_nh(node, node_nh);
+	}
+	return ret;
+}
+
+int
+poptrie_rcu_qsbr_add(struct poptrie_tbl *dp, struct rte_fib_rcu_config *cfg,
+	const char *name)
+{
+	struct rte_rcu_qsbr_dq_parameters params = {0};
+	char rcu_dq_name[RTE_RCU_QSBR_DQ_NAMESIZE];
+
+	if (dp == NULL || cfg == NULL)
+		return -EINVAL;
+
+	if (dp->v != NULL)
+		return -EEXIST;
+
+	if (cfg->mode == RTE_FIB_QSBR_MODE_SYNC) {
+		/* No other things to do. */
+	} else if (cfg->mode == RTE_FIB_QSBR_MODE_DQ) {
+		/* Init QSBR defer queue. */
+		snprintf(rcu_dq_name, sizeof(rcu_dq_name),
+				"FIB_RCU_%s", name);
+		params.name = rcu_dq_name;
+		params.size = cfg->dq_size;
+		if (params.size == 0)
+			params.size = dp->node_pool.size;
+		params.trigger_reclaim_limit = cfg->reclaim_thd;
+		params.max_reclaim_size = cfg->reclaim_max;
+		if (params.max_reclaim_size == 0)
+			params.max_reclaim_size = RTE_FIB_RCU_DQ_RECLAIM_MAX;
+		params.esize = sizeof(uint64_t);	/* pool, order and index */
+		params.free_fn = __rcu_qsbr_free_resource;
+		params.p = dp;
+		params.v = cfg->v;
+		dp->dq = rte_rcu_qsbr_dq_create(&params);
+		if (dp->dq == NULL)
+			return -rte_errno;
+	} else
+		return -EINVAL;
+
+	dp->rcu_mode = cfg->mode;
+	dp->v = cfg->v;
+
+	return 0;
+}
+
+static struct poptrie_tbl *
+tbl_create(const char *name, int socket_id, uint8_t key_len, uint64_t def_nh,
+	uint32_t num_nodes, uint32_t num_leaves)
+{
+	char mem_name[POPTRIE_NAMESIZE];
+	struct poptrie_tbl *dp;
+	uint32_t i;
+
+	if ((name == NULL) || (num_nodes == 0) ||
+			(num_nodes > POPTRIE_MAX_NH) || (num_leaves == 0) ||
+			(num_leaves > POPTRIE_MAX_NH) ||
+			(def_nh > POPTRIE_MAX_NH)) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	snprintf(mem_name, sizeof(mem_name), "DP_%s", name);
+	dp = rte_zmalloc_socket(mem_name, sizeof(struct poptrie_tbl) +
+		POPTRIE_DIR_NUM_ENT * sizeof(uint32_t), RTE_CACHE_LINE_SIZE,
+		socket_id);
+	if (dp == NULL) {
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	/* Init table with default value */
+	for (i = 0; i < POPTRIE_DIR_NUM_ENT; i++)
+		dp->dir[i] = def_nh | POPTRIE_LEAF;
+
+	snprintf(mem_name, sizeof(mem_name), "NODES_%p", dp);
+	dp->nodes = rte_zmalloc_socket(mem_name,
+		(size_t)num_nodes * sizeof(struct poptrie_node),
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (dp->nodes == NULL) {
+		rte_errno = ENOMEM;
+		rte_free(dp);
+		return NULL;
+	}
+
+	snprintf(mem_name, sizeof(mem_name), "LEAVES_%p", dp);
+	dp->leaves = rte_zmalloc_socket(mem_name,
+		(size_t)num_leaves * sizeof(uint32_t),
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (dp->leaves == NULL) {
+		rte_errno = ENOMEM;
+		rte_free(dp->nodes);
+		rte_free(dp);
+		return NULL;
+	}
+
+	dp->key_len = key_len;
+	dp->def_nh = def_nh;
+	pool_init(&dp->node_pool, dp->nodes, sizeof(struct poptrie_node),
+		num_nodes);
+	pool_init(&dp->leaf_pool, dp->leaves, sizeof(uint32_t), num_leaves);
+
+	return dp;
+}
+
+void *
+poptrie_create(const char *name, int socket_id, struct rte_fib_conf *conf)
+{
+	if (conf == NULL) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	return tbl_create(name, socket_id, RTE_FIB_MAXDEPTH, conf->default_nh,
+		conf->poptrie.num_nodes, conf->poptrie.num_leaves);
+}
+
+void *
+poptrie6_create(const char *name, int socket_id, struct rte_fib6_conf *conf)
+{
+	if (conf == NULL) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	return tbl_create(name, socket_id, RTE_FIB6_MAXDEPTH,
+		conf->default_nh, conf->poptrie.num_nodes,
+		conf->poptrie.num_leaves);
+}
+
+void
+poptrie_free(void *p)
+{
+	struct poptrie_tbl *dp = (struct poptrie_tbl *)p;
+
+	if (dp->dq != NULL)
+		rte_rcu_qsbr_dq_delete(dp->dq);
+	rte_free(dp->leaves);
+	rte_free(dp->nodes);
+	rte_free(dp);
+}
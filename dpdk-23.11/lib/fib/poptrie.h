@@ -0,0 +1,160 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _POPTRIE_H_
+#define _POPTRIE_H_
+
+#include <rte_bitops.h>
+#include <rte_byteorder.h>
+#include <rte_prefetch.h>
+#include <rte_fib.h>
+#include <rte_fib6.h>
+
+/**
+ * @file
+ * Poptrie algorithm
+ *
+ * Multibit trie whose nodes are compressed with bitmaps. The first
+ * POPTRIE_DIR_BITS bits of the address index a direct pointing array,
+ * the next ones are consumed POPTRIE_STRIDE bits per node. A node
+ * has 64 positions, each one either a child node or a leaf: a bitmap
+ * tells which positions are nodes and the children are stored
+ * contiguously, so that the index of a child is the population count
+ * of the bitmap up to its position. Runs of equal leaves are stored
+ * once, another bitmap telling where each run starts.
+ *
+ * The trie is updated by copying the path to the modified prefix and
+ * rebuilding the nodes covered by it from the RIB, then switching the
+ * direct pointing entry, so lookups always see a consistent trie.
+ */
+
+#define POPTRIE_DIR_BITS	16
+#define POPTRIE_DIR_NUM_ENT	(1 << POPTRIE_DIR_BITS)
+#define POPTRIE_STRIDE		6
+#define POPTRIE_NODE_NUM_ENT	(1 << POPTRIE_STRIDE)
+/* Direct pointing entry holding a next hop rather than a node index */
+#define POPTRIE_LEAF		(1U << 31)
+#define POPTRIE_MAX_NH		(POPTRIE_LEAF - 1)
+#define POPTRIE_NIL		UINT32_MAX
+/* Blocks of 1 to POPTRIE_NODE_NUM_ENT units */
+#define POPTRIE_NUM_ORDERS	(POPTRIE_STRIDE + 1)
+
+struct poptrie_node {
+	uint64_t	vector;		/**< positions which are nodes */
+	uint64_t	leafvec;	/**< positions starting a leaf run */
+	uint32_t	base0;		/**< index of the first leaf */
+	uint32_t	base1;		/**< index of the first child node */
+};
+
+/* Allocator of blocks of nodes or leaves */
+struct poptrie_pool {
+	void		*base;		/**< nodes or leaves array */
+	uint32_t	unit_sz;	/**< size of a node or leaf */
+	uint32_t	size;		/**< number of units */
+	uint32_t	next;		/**< first never allocated unit */
+	/** free blocks by power of two size, linked through their first unit */
+	uint32_t	free[POPTRIE_NUM_ORDERS];
+};
+
+struct poptrie_tbl {
+	uint8_t		key_len;	/**< 32 or 128 bits */
+	uint64_t	def_nh;		/**< Default next hop */
+	struct poptrie_node	*nodes;	/**< nodes array */
+	uint32_t	*leaves;	/**< leaves array */
+	struct poptrie_pool	node_pool;
+	struct poptrie_pool	leaf_pool;
+	/* RCU config. */
+	enum rte_fib_qsbr_mode	rcu_mode;/* Blocking, defer queue. */
+	struct rte_rcu_qsbr	*v;	/* RCU QSBR variable. */
+	struct rte_rcu_qsbr_dq	*dq;	/* RCU QSBR defer queue. */
+	/* direct pointing array. */
+	__extension__ uint32_t	dir[0] __rte_cache_aligned;
+};
+
+/*
+ * Look up an address given as a 128-bit big endian number, IPv4
+ * addresses being in the upper 32 bits.
+ */
+static inline uint64_t
+poptrie_lookup(const struct poptrie_tbl *dp, uint64_t hi, uint64_t lo)
+{
+	const struct poptrie_node *node;
+	uint64_t key, bit, msk;
+	uint32_t ent, off;
+
+	ent = dp->dir[hi >> (64 - POPTRIE_DIR_BITS)];
+	for (off = POPTRIE_DIR_BITS; (ent & POPTRIE_LEAF) == 0;
+			off += POPTRIE_STRIDE) {
+		node = &dp->nodes[ent];
+		key = (off < 64) ? hi << off : lo << (off - 64);
+		bit = 1ULL << (key >> (64 - POPTRIE_STRIDE));
+		msk = (bit << 1) - 1;
+		if ((node->vector & bit) == 0)
+			return dp->leaves[node->base0 +
+				rte_popcount64(node->leafvec & msk) - 1];
+		ent = node->base1 + rte_popcount64(node->vector & msk) - 1;
+	}
+
+	return ent & ~POPTRIE_LEAF;
+}
+
+static inline void
+poptrie_lookup_bulk(void *p, const uint32_t *ips,
+	uint64_t *next_hops, const unsigned int n)
+{
+	struct poptrie_tbl *dp = (struct poptrie_tbl *)p;
+	uint32_t prefetch_offset = RTE_MIN(15U, n);
+	uint32_t i;
+
+	for (i = 0; i < prefetch_offset; i++)
+		rte_prefetch0(&dp->dir[ips[i] >> (32 - POPTRIE_DIR_BITS)]);
+	for (i = 0; i < (n - prefetch_offset); i++) {
+		rte_prefetch0(&dp->dir[ips[i + prefetch_offset] >>
+			(32 - POPTRIE_DIR_BITS)]);
+		next_hops[i] = poptrie_lookup(dp, (uint64_t)ips[i] << 32, 0);
+	}
+	for (; i < n; i++)
+		next_hops[i] = poptrie_lookup(dp, (uint64_t)ips[i] << 32, 0);
+}
+
+static inline void
+poptrie6_lookup_bulk(void *p, uint8_t ips[][RTE_FIB6_IPV6_ADDR_SIZE],
+	uint64_t *next_hops, const unsigned int n)
+{
+	struct poptrie_tbl *dp = (struct poptrie_tbl *)p;
+	uint32_t i;
+
+	for (i = 0; i < n; i++)
+		next_hops[i] = poptrie_lookup(dp,
+			rte_be_to_cpu_64(*(unaligned_uint64_t *)&ips[i][0]),
+			rte_be_to_cpu_64(*(unaligned_uint64_t *)&ips[i][8]));
+}
+
+void *
+poptrie_create(const char *name, int socket_id, struct rte_fib_conf *conf);
+
+void *
+poptrie6_create(const char *name, int socket_id, struct rte_fib6_conf *conf);
+
+void
+poptrie_free(void *p);
+
+rte_fib_lookup_fn_t
+poptrie_get_lookup_fn(void *p, enum rte_fib_lookup_type type);
+
+rte_fib6_lookup_fn_t
+poptrie6_get_lookup_fn(void *p, enum rte_fib6_lookup_type type);
+
+int
+poptrie_modify(struct rte_fib *fib, uint32_t ip, uint8_t depth,
+	uint64_t next_hop, int op);
+
+int
+poptrie6_modify(struct rte_fib6 *fib, const uint8_t ip[RTE_FIB6_IPV6_ADDR_SIZE],
+	uint8_t depth, uint64_t next_hop, int op);
+
+int
+poptrie_rcu_qsbr_add(struct poptrie_tbl *dp, struct rte_fib_rcu_config *cfg,
+	const char *name);
+
+#endif /* _POPTRIE_H_ */
@@ -0,0 +1,137 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <rte_vect.h>
+#include <rte_fib.h>
+#include <rte_fib6.h>
+
+#include "poptrie.h"
+#include "poptrie_avx512.h"
+
+/* Population count of each 64-bit lane, using a 4-bit lookup table */
+static __rte_always_inline __m512i
+popcount_x8(__m512i v)
+{
+	const __m512i lut = _mm512_set4_epi32(0x04030302, 0x03020201,
+		0x03020201, 0x02010100);
+	const __m512i nibble = _mm512_set1_epi8(0x0f);
+	__m512i cnt;
+
+	cnt = _mm512_add_epi8(
+		_mm512_shuffle_epi8(lut, _mm512_and_si512(v, nibble)),
+		_mm512_shuffle_epi8(lut,
+			_mm512_and_si512(_mm512_srli_epi16(v, 4), nibble)));
+	return _mm512_sad_epu8(cnt, _mm512_setzero_si512());
+}
+
+/*
+ * Look up 8 addresses given as 128-bit numbers, walking down the trie
+ * one level per iteration while at least one of them is on a node.
+ */
+static __rte_always_inline void
+poptrie_vec_lookup_x8(const struct poptrie_tbl *dp, __m512i hi, __m512i lo,
+	uint64_t *next_hops)
+{
+	const __m512i leaf = _mm512_set1_epi64(POPTRIE_LEAF);
+	const __m512i lsb = _mm512_set1_epi64(1);
+	const __m512i base_msk = _mm512_set1_epi64(UINT32_MAX);
+	const void *nodes = dp->nodes;
+	__m512i ent, res, key, bit, msk, off, vector, leafvec, bases, idx;
+	__mmask8 act, is_node;
+	uint32_t shift;
+
+	ent = _mm512_cvtepu32_epi64(_mm512_i64gather_epi32(
+		_mm512_srli_epi64(hi, 64 - POPTRIE_DIR_BITS), dp->dir,
+		sizeof(uint32_t)));
+	act = _mm512_testn_epi64_mask(ent, leaf);
+	res = _mm512_andnot_si512(leaf, ent);
+	vector = leafvec = bases = _mm512_setzero_si512();
+
+	for (shift = POPTRIE_DIR_BITS; act != 0; shift += POPTRIE_STRIDE) {
+		key = (shift < 64) ?
+			_mm512_sll_epi64(hi, _mm_cvtsi32_si128(shift)) :
+			_mm512_sll_epi64(lo, _mm_cvtsi32_si128(shift - 64));
+		bit = _mm512_sllv_epi64(lsb,
+			_mm512_srli_epi64(key, 64 - POPTRIE_STRIDE));
+		msk = _mm512_sub_epi64(_mm512_slli_epi64(bit, 1), lsb);
+
+		/* nodes are 24 bytes long */
+		off = _mm512_add_epi64(_mm512_slli_epi64(ent, 4),
+			_mm512_slli_epi64(ent, 3));
+		vector = _mm512_mask_i64gather_epi64(vector, act, off,
+			(const uint8_t *)nodes +
+			offsetof(struct poptrie_node, vector), 1);
+		leafvec = _mm512_mask_i64gather_epi64(leafvec, act, off,
+			(const uint8_t *)nodes +
+			offsetof(struct poptrie_node, leafvec), 1);
+		bases = _mm512_mask_i64gather_epi64(bases, act, off,
+			(const uint8_t *)nodes +
+			offsetof(struct poptrie_node, base0), 1);
+
+		is_node = _mm512_mask_test_epi64_mask(act, vector, bit);
+
+		/* lanes reaching a leaf are done */
+		idx = _mm512_sub_epi64(_mm512_add_epi64(
+			_mm512_and_si512(bases, base_msk),
+			popcount_x8(_mm512_and_si512(leafvec, msk))), lsb);
+		res = _mm512_mask_mov_epi64(res, act & ~is_node,
+			_mm512_cvtepu32_epi64(_mm512_mask_i64gather_epi32(
+			_mm256_setzero_si256(), act & ~is_node, idx,
+			dp->leaves, sizeof(uint32_t))));
+
+		/* others go to the child node */
+		ent = _mm512_sub_epi64(_mm512_add_epi64(
+			_mm512_srli_epi64(bases, 32),
+			popcount_x8(_mm512_and_si512(vector, msk))), lsb);
+		act = is_node;
+	}
+
+	_mm512_storeu_si512(next_hops, res);
+}
+
+void
+rte_poptrie_vec_lookup_bulk(void *p, const uint32_t *ips,
+	uint64_t *next_hops, const unsigned int n)
+{
+	const struct poptrie_tbl *dp = p;
+	__m512i hi;
+	uint32_t i;
+
+	for (i = 0; i < (n / 8); i++) {
+		hi = _mm512_slli_epi64(_mm512_cvtepu32_epi64(
+			_mm256_loadu_si256((const void *)&ips[i * 8])), 32);
+		poptrie_vec_lookup_x8(dp, hi, _mm512_setzero_si512(),
+			next_hops + i * 8);
+	}
+	poptrie_lookup_bulk(p, ips + i * 8, next_hops + i * 8, n - i * 8);
+}
+
+void
+rte_poptrie6_vec_lookup_bulk(void *p, uint8_t ips[][RTE_FIB6_IPV6_ADDR_SIZE],
+	uint64_t *next_hops, const unsigned int n)
+{
+	const struct poptrie_tbl *dp = p;
+	const __rte_x86_zmm_t hi_idxes = {
+		.u64 = { 0, 2, 4, 6, 8, 10, 12, 14 },
+	};
+	const __rte_x86_zmm_t lo_idxes = {
+		.u64 = { 1, 3, 5, 7, 9, 11, 13, 15 },
+	};
+	const __m512i bswap = _mm512_set4_epi32(0x08090a0b, 0x0c0d0e0f,
+		0x00010203, 0x04050607);
+	__m512i tmp1, tmp2, hi, lo;
+	uint32_t i;
+
+	for (i = 0; i < (n / 8); i++) {
+		tmp1 = _mm512_loadu_si512(&ips[i * 8][0]);
+		tmp2 = _mm512_loadu_si512(&ips[i * 8 + 4][0]);
+		/* split the halves of the addresses, in host byte order */
+		hi = _mm512_shuffle_epi8(_mm512_permutex2var_epi64(tmp1,
+			hi_idxes.z, tmp2), bswap);
+		lo = _mm512_shuffle_epi8(_mm512_permutex2var_epi64(tmp1,
+			lo_idxes.z, tmp2), bswap);
+		poptrie_vec_lookup_x8(dp, hi, lo, next_hops + i * 8);
+	}
+	poptrie6_lookup_bulk(p, (uint8_t (*)[16])&ips[i * 8][0],
+		next_hops + i * 8, n - i * 8);
+}
@@ -17,6 +17,7 @@
 #include <rte_fib.h>
 
 #include "dir24_8.h"
+#include "poptrie.h"
 
 TAILQ_HEAD(rte_fib_list, rte_tailq_entry);
 static struct rte_tailq_elem rte_fib_tailq = {
@@ -110,6 +111,14 @@ init_dataplane(struct rte_fib *fib, __rte_unused int socket_id,
 			RTE_FIB_LOOKUP_DEFAULT);
 		fib->modify = dir24_8_modify;
 		return 0;
+	case RTE_FIB_POPTRIE:
+		fib->dp = poptrie_create(dp_name, socket_id, conf);
+		if (fib->dp == NULL)
+			return -rte_errno;
+		fib->lookup = poptrie_get_lookup_fn(fib->dp,
+			RTE_FIB_LOOKUP_DEFAULT);
+		fib->modify = poptrie_modify;
+		return 0;
 	default:
 		return -EINVAL;
 	}
@@ -134,6 +143,38 @@ rte_fib_delete(struct rte_fib *fib, uint32_t ip, uint8_t depth)
 	return fib->modify(fib, ip, depth, 0, RTE_FIB_DEL);
 }
 
+unsigned int
+rte_fib_modify_bulk(struct rte_fib *fib, const struct rte_fib_route *routes,
+	unsigned int n)
+{
+	unsigned int i;
+	int ret;
+
+	if ((fib == NULL) || (routes == NULL) || (fib->modify == NULL)) {
+		rte_errno = EINVAL;
+		return 0;
+	}
+
+	switch (fib->type) {
+	case RTE_FIB_DIR24_8:
+		return dir24_8_modify_bulk(fib, routes, n);
+	default:
+		for (i = 0; i != n; i++) {
+			if (routes[i].depth > RTE_FIB_MAXDEPTH)
+				ret = -EINVAL;
+			else
+				ret = fib->modify(fib, routes[i].ip,
+					routes[i].depth, routes[i].next_hop,
+					routes[i].op);
+			if (ret != 0) {
+				rte_errno = -ret;
+				break;
+			}
+		}
+		return i;
+	}
+}
+
 int
 rte_fib_lookup_bulk(struct rte_fib *fib, uint32_t *ips,
 	uint64_t *next_hops, int n)
@@ -158,7 +199,7 @@ rte_fib_create(const char *name, int socket_id, struct rte_fib_conf *conf)
 
 	/* Check user arguments. */
 	if ((name == NULL) || (conf == NULL) ||	(conf->max_routes < 0) ||
-			(conf->type > RTE_FIB_DIR24_8)) {
+			(conf->type > RTE_FIB_POPTRIE)) {
 		rte_errno = EINVAL;
 		return NULL;
 	}
@@ -272,6 +313,10 @@ free_dataplane(struct rte_fib *fib)
 		return;
 	case RTE_FIB_DIR24_8:
 		dir24_8_free(fib->dp);
+		return;
+	case RTE_FIB_POPTRIE:
+		poptrie_free(fib->dp);
+		return;
 	default:
 		return;
 	}
@@ -318,6 +363,22 @@ rte_fib_get_rib(struct rte_fib *fib)
 	return (fib == NULL) ? NULL : fib->rib;
 }
 
+int
+rte_fib_rcu_qsbr_add(struct rte_fib *fib, struct rte_fib_rcu_config *cfg)
+{
+	if (fib == NULL || cfg == NULL)
+		return -EINVAL;
+
+	switch (fib->type) {
+	case RTE_FIB_DIR24_8:
+		return dir24_8_rcu_qsbr_add(fib->dp, cfg, fib->name);
+	case RTE_FIB_POPTRIE:
+		return poptrie_rcu_qsbr_add(fib->dp, cfg, fib->name);
+	default:
+		return -ENOTSUP;
+	}
+}
+
 int
 rte_fib_select_lookup(struct rte_fib *fib,
 	enum rte_fib_lookup_type type)
@@ -331,6 +392,12 @@ rte_fib_select_lookup(struct rte_fib *fib,
 			return -EINVAL;
 		fib->lookup = fn;
 		return 0;
+	case RTE_FIB_POPTRIE:
+		fn = poptrie_get_lookup_fn(fib->dp, type);
+		if (fn == NULL)
+			return -EINVAL;
+		fib->lookup = fn;
+		return 0;
 	default:
 		return -EINVAL;
 	}
@@ -17,6 +17,8 @@
 
 #include <stdint.h>
 
+#include <rte_compat.h>
+#include <rte_rcu_qsbr.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,10 +30,14 @@ struct rte_rib;
 /** Maximum depth value possible for IPv4 FIB. */
 #define RTE_FIB_MAXDEPTH	32
 
+/** Default RCU defer queue entries to reclaim in one go. */
+#define RTE_FIB_RCU_DQ_RECLAIM_MAX	16
+
 /** Type of FIB struct */
 enum rte_fib_type {
 	RTE_FIB_DUMMY,		/**< RIB tree based FIB */
-	RTE_FIB_DIR24_8		/**< DIR24_8 based FIB */
+	RTE_FIB_DIR24_8,	/**< DIR24_8 based FIB */
+	RTE_FIB_POPTRIE		/**< Poptrie based FIB */
 };
 
 /** Modify FIB function */
@@ -46,6 +52,14 @@ enum rte_fib_op {
 	RTE_FIB_DEL,
 };
 
+/** RCU reclamation modes */
+enum rte_fib_qsbr_mode {
+	/** Create defer queue for reclaim. */
+	RTE_FIB_QSBR_MODE_DQ = 0,
+	/** Use blocking mode reclaim. No defer queue created. */
+	RTE_FIB_QSBR_MODE_SYNC
+};
+
 /** Size of nexthop (1 << nh_sz) bits for DIR24_8 based FIB */
 enum rte_fib_dir24_8_nh_sz {
 	RTE_FIB_DIR24_8_1B,
@@ -69,8 +83,12 @@ enum rte_fib_lookup_type {
 	/**<
 	 * Unified lookup function for all next hop sizes
 	 */
-	RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX512
+	RTE_FIB_LOOKUP_DIR24_8_VECTOR_AVX512,
 	/**< Vector implementation using AVX512 */
+	RTE_FIB_LOOKUP_POPTRIE_SCALAR,
+	/**< Scalar lookup function implementation for the poptrie */
+	RTE_FIB_LOOKUP_POPTRIE_VECTOR_AVX512
+	/**< Vector implementation using AVX512 for the poptrie */
 };
 
 /** FIB configuration structure */
@@ -86,9 +104,40 @@ struct rte_fib_conf {
 			enum rte_fib_dir24_8_nh_sz nh_sz;
 			uint32_t	num_tbl8;
 		} dir24_8;
+		struct {
+			/** Number of trie nodes, 24 bytes each */
+			uint32_t	num_nodes;
+			/** Number of leaves, next hops being 31-bit long */
+			uint32_t	num_leaves;
+		} poptrie;
 	};
 };
 
+/** FIB RCU QSBR configuration structure. */
+struct rte_fib_rcu_config {
+	struct rte_rcu_qsbr *v;	/* RCU QSBR variable. */
+	/* Mode of RCU QSBR. RTE_FIB_QSBR_MODE_xxx
+	 * '0' for default: create defer queue for reclaim.
+	 */
+	enum rte_fib_qsbr_mode mode;
+	uint32_t dq_size;	/* RCU defer queue size.
+				 * default: FIB number of tbl8s,
+				 * or of nodes for RTE_FIB_POPTRIE.
+				 */
+	uint32_t reclaim_thd;	/* Threshold to trigger auto reclaim. */
+	uint32_t reclaim_max;	/* Max entries to reclaim in one go.
+				 * default: RTE_FIB_RCU_DQ_RECLAIM_MAX.
+				 */
+};
+
+/** Route update, see rte_fib_modify_bulk() */
+struct rte_fib_route {
+	uint32_t ip;		/**< IPv4 prefix address */
+	uint8_t depth;		/**< Prefix length */
+	uint8_t op;		/**< RTE_FIB_ADD or RTE_FIB_DEL */
+	uint64_t next_hop;	/**< Next hop, ignored by RTE_FIB_DEL */
+};
+
 /**
  * Create FIB
  *
@@ -160,6 +209,44 @@ rte_fib_add(struct rte_fib *fib, uint32_t ip, uint8_t depth, uint64_t next_hop);
 int
 rte_fib_delete(struct rte_fib *fib, uint32_t ip, uint8_t depth);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Add and delete a set of routes.
+ *
+ * The routes are applied in order to the RIB by chunks. For each chunk,
+ * the dataplane entries of the modified prefixes are written once,
+ * after all the routes of the chunk have been applied, rather than
+ * once per route. So a prefix modified several times, or the more
+ * specific routes deleted along with a covering route, cost a single
+ * update of the dataplane. The tbl8 groups released by a chunk are
+ * reclaimed through the RCU QSBR variable if one was associated with
+ * the FIB, see rte_fib_rcu_qsbr_add().
+ *
+ * @param fib
+ *   FIB object handle
+ * @param routes
+ *   Array of routes to add or delete
+ * @param n
+ *   Number of elements in routes array
+ * @return
+ *   Number of routes applied. If less than n, rte_errno is set to the
+ *   error of the first route not applied:
+ *   - EINVAL - invalid parameter
+ *   - ENOENT - deleted route not found
+ *   - ENOSPC - no space left in the FIB. If the dataplane ran out of
+ *     space, the routes of the chunk starting at the returned index
+ *     are reverted, the previous chunks staying applied.
+ *   - EFAULT - the routes of the chunk starting at the returned index
+ *     are reverted in the RIB, but their previous dataplane entries
+ *     could not be restored.
+ */
+__rte_experimental
+unsigned int
+rte_fib_modify_bulk(struct rte_fib *fib, const struct rte_fib_route *routes,
+	unsigned int n);
+
 /**
  * Lookup multiple IP addresses in the FIB.
  *
@@ -219,6 +306,31 @@ rte_fib_get_rib(struct rte_fib *fib);
 int
 rte_fib_select_lookup(struct rte_fib *fib, enum rte_fib_lookup_type type);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Associate RCU QSBR variable with a FIB object.
+ *
+ * The tbl8 groups released by route updates are then only reused once
+ * all the lookup threads reporting to the QSBR variable went through
+ * a quiescent state.
+ *
+ * @param fib
+ *   FIB object handle
+ * @param cfg
+ *   RCU QSBR configuration
+ * @return
+ *   0 on success
+ *   -EINVAL - invalid pointer
+ *   -EEXIST - already added QSBR
+ *   -ENOMEM - memory allocation failure
+ *   -ENOTSUP - not supported by the FIB type
+ */
+__rte_experimental
+int
+rte_fib_rcu_qsbr_add(struct rte_fib *fib, struct rte_fib_rcu_config *cfg);
+
 #ifdef __cplusplus
 }
 #endif
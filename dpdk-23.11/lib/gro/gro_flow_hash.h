@@ -0,0 +1,217 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GRO_FLOW_HASH_H_
+#define _GRO_FLOW_HASH_H_
+
+#include <rte_common.h>
+#include <rte_hash_crc.h>
+#include <rte_malloc.h>
+#include <rte_mbuf.h>
+
+#ifndef INVALID_ARRAY_INDEX
+#define INVALID_ARRAY_INDEX 0xffffffffUL
+#endif
+
+/*
+ * Flow index of a reassembly table.
+ *
+ * Flows are found through an open-addressed hash table with linear
+ * probing, keyed by the CRC32 signature of the flow key. The hash table
+ * has at least twice as many slots as flows, so a lookup stops on an
+ * empty slot after a few probes, and the flow key is only compared when
+ * the signatures match. Free flows are kept in a stack, so that
+ * inserting a flow doesn't scan the flow array either.
+ */
+
+struct gro_flow_hash_entry {
+	/* signature of the flow key */
+	uint32_t sig;
+	/* INVALID_ARRAY_INDEX indicates an empty slot */
+	uint32_t flow_idx;
+};
+
+struct gro_flow_hash {
+	/* hash table, whose size is a power of 2 */
+	struct gro_flow_hash_entry *entries;
+	/* stack of free flow indexes */
+	uint32_t *free_flows;
+	uint32_t nb_free;
+	/* hash table size - 1 */
+	uint32_t mask;
+};
+
+/*
+ * Return the hash table size for 'max_flow_num' flows.
+ */
+static inline uint32_t
+gro_flow_hash_size(uint32_t max_flow_num)
+{
+	return rte_align32pow2(RTE_MAX(2 * max_flow_num, 2U));
+}
+
+/*
+ * Initialize a flow index of 'max_flow_num' flows, whose hash table
+ * 'entries' has gro_flow_hash_size(max_flow_num) slots.
+ */
+static inline void
+gro_flow_hash_init(struct gro_flow_hash *h,
+		struct gro_flow_hash_entry *entries,
+		uint32_t *free_flows,
+		uint32_t max_flow_num)
+{
+	uint32_t i, size = gro_flow_hash_size(max_flow_num);
+
+	for (i = 0; i < size; i++)
+		entries[i].flow_idx = INVALID_ARRAY_INDEX;
+	/* pop the flows in increasing order */
+	for (i = 0; i < max_flow_num; i++)
+		free_flows[i] = max_flow_num - 1 - i;
+
+	h->entries = entries;
+	h->free_flows = free_flows;
+	h->nb_free = max_flow_num;
+	h->mask = size - 1;
+}
+
+/*
+ * Allocate and initialize a flow index. Return 0 on success.
+ */
+static inline int
+gro_flow_hash_create(struct gro_flow_hash *h,
+		uint32_t max_flow_num,
+		uint16_t socket_id)
+{
+	struct gro_flow_hash_entry *entries;
+	uint32_t *free_flows;
+
+	entries = rte_malloc_socket(__func__,
+			sizeof(*entries) * gro_flow_hash_size(max_flow_num),
+			RTE_CACHE_LINE_SIZE,
+			socket_id);
+	free_flows = rte_malloc_socket(__func__,
+			sizeof(*free_flows) * max_flow_num,
+			RTE_CACHE_LINE_SIZE,
+			socket_id);
+	if (entries == NULL || free_flows == NULL) {
+		rte_free(entries);
+		rte_free(free_flows);
+		return -1;
+	}
+	gro_flow_hash_init(h, entries, free_flows, max_flow_num);
+
+	return 0;
+}
+
+static inline void
+gro_flow_hash_destroy(struct gro_flow_hash *h)
+{
+	rte_free(h->entries);
+	rte_free(h->free_flows);
+}
+
+/*
+ * Return the next flow whose signature is 'sig', starting at slot '*pos'
+ * which is initialized to 'sig & h->mask'. Return INVALID_ARRAY_INDEX
+ * when there are no more candidates. The caller compares the flow keys.
+ */
+static inline uint32_t
+gro_flow_hash_next(const struct gro_flow_hash *h, uint32_t sig,
+		uint32_t *pos)
+{
+	const struct gro_flow_hash_entry *e;
+
+	for (;;) {
+		e = &h->entries[*pos];
+		if (e->flow_idx == INVALID_ARRAY_INDEX)
+			return INVALID_ARRAY_INDEX;
+		*pos = (*pos + 1) & h->mask;
+		if (e->sig == sig)
+			return e->flow_idx;
+	}
+}
+
+/*
+ * Get a free flow and index it with 'sig'. Return INVALID_ARRAY_INDEX if
+ * all flows are used.
+ */
+static inline uint32_t
+gro_flow_hash_add(struct gro_flow_hash *h, uint32_t sig)
+{
+	uint32_t pos, flow_idx;
+
+	if (unlikely(h->nb_free == 0))
+		return INVALID_ARRAY_INDEX;
+	flow_idx = h->free_flows[--h->nb_free];
+
+	pos = sig & h->mask;
+	while (h->entries[pos].flow_idx != INVALID_ARRAY_INDEX)
+		pos = (pos + 1) & h->mask;
+	h->entries[pos].sig = sig;
+	h->entries[pos].flow_idx = flow_idx;
+
+	return flow_idx;
+}
+
+/*
+ * Remove the flow 'flow_idx' indexed with 'sig' and release it. The
+ * following slots of the probe sequence are shifted back, so that
+ * lookups don't need tombstones.
+ */
+static inline void
+gro_flow_hash_del(struct gro_flow_hash *h, uint32_t sig, uint32_t flow_idx)
+{
+	uint32_t i, j, home;
+
+	i = sig & h->mask;
+	while (h->entries[i].flow_idx != flow_idx) {
+		if (unlikely(h->entries[i].flow_idx == INVALID_ARRAY_INDEX))
+			return;
+		i = (i + 1) & h->mask;
+	}
+
+	j = i;
+	for (;;) {
+		j = (j + 1) & h->mask;
+		if (h->entries[j].flow_idx == INVALID_ARRAY_INDEX)
+			break;
+		/*
+		 * The entry in 'j' can fill the hole in 'i' unless its
+		 * home slot is cyclically in (i, j].
+		 */
+		home = h->entries[j].sig & h->mask;
+		if (((j - home) & h->mask) < ((j - i) & h->mask))
+			continue;
+		h->entries[i] = h->entries[j];
+		i = j;
+	}
+	h->entries[i].flow_idx = INVALID_ARRAY_INDEX;
+
+	h->free_flows[h->nb_free++] = flow_idx;
+}
+
+/*
+ * Return the index of an empty item in the item array of a reassembly
+ * table, or INVALID_ARRAY_INDEX if all items are used. Items are
+ * 'item_sz' bytes long and hold their first packet segment at offset
+ * 'firstseg_off'. The search starts after the 'item_num' stored items:
+ * that item is empty, unless items were deleted out of insertion order.
+ */
+static inline uint32_t
+gro_find_empty_item(const void *items, size_t item_sz, size_t firstseg_off,
+		uint32_t item_num, uint32_t max_item_num)
+{
+	const struct rte_mbuf * const *firstseg;
+	uint32_t i, j;
+
+	for (i = 0, j = item_num; i < max_item_num; i++, j++) {
+		if (j >= max_item_num)
+			j = 0;
+		firstseg = RTE_PTR_ADD(items, j * item_sz + firstseg_off);
+		if (*firstseg == NULL)
+			return j;
+	}
+	return INVALID_ARRAY_INDEX;
+}
+
+#endif
@@ -8,6 +8,8 @@
 
 #include <rte_tcp.h>
 
+#include "gro_flow_hash.h"
+
 /*
  * The max length of a IPv4 packet, which includes the length of the L3
  * header, the L4 header and the data payload.
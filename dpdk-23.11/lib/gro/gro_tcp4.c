@@ -52,6 +52,12 @@ gro_tcp4_tbl_create(uint16_t socket_id,
 		rte_free(tbl);
 		return NULL;
 	}
+	if (gro_flow_hash_create(&tbl->hash, entries_num, socket_id) < 0) {
+		rte_free(tbl->flows);
+		rte_free(tbl->items);
+		rte_free(tbl);
+		return NULL;
+	}
 	/* INVALID_ARRAY_INDEX indicates an empty flow */
 	for (i = 0; i < entries_num; i++)
 		tbl->flows[i].start_index = INVALID_ARRAY_INDEX;
@@ -68,31 +74,21 @@ gro_tcp4_tbl_destroy(void *tbl)
 	if (tcp_tbl) {
 		rte_free(tcp_tbl->items);
 		rte_free(tcp_tbl->flows);
+		gro_flow_hash_destroy(&tcp_tbl->hash);
 	}
 	rte_free(tcp_tbl);
 }
 
-static inline uint32_t
-find_an_empty_flow(struct gro_tcp4_tbl *tbl)
-{
-	uint32_t i;
-	uint32_t max_flow_num = tbl->max_flow_num;
-
-	for (i = 0; i < max_flow_num; i++)
-		if (tbl->flows[i].start_index == INVALID_ARRAY_INDEX)
-			return i;
-	return INVALID_ARRAY_INDEX;
-}
-
 static inline uint32_t
 insert_new_flow(struct gro_tcp4_tbl *tbl,
 		struct tcp4_flow_key *src,
+		uint32_t sig,
 		uint32_t item_idx)
 {
 	struct tcp4_flow_key *dst;
 	uint32_t flow_idx;
 
-	flow_idx = find_an_empty_flow(tbl);
+	flow_idx = gro_flow_hash_add(&tbl->hash, sig);
 	if (unlikely(flow_idx == INVALID_ARRAY_INDEX))
 		return INVALID_ARRAY_INDEX;
 
@@ -124,8 +120,7 @@ gro_tcp4_reassemble(struct rte_mbuf *pkt,
 
 	struct tcp4_flow_key key;
 	uint32_t item_idx;
-	uint32_t i, max_flow_num, remaining_flow_num;
-	uint8_t find;
+	uint32_t i, sig, pos;
 
 	/*
 	 * Don't process the packet whose TCP header length is greater
@@ -176,20 +171,14 @@ gro_tcp4_reassemble(struct rte_mbuf *pkt,
 	ip_id = is_atomic ? 0 : rte_be_to_cpu_16(ipv4_hdr->packet_id);
 
 	/* Search for a matched flow. */
-	max_flow_num = tbl->max_flow_num;
-	remaining_flow_num = tbl->flow_num;
-	find = 0;
-	for (i = 0; i < max_flow_num && remaining_flow_num; i++) {
-		if (tbl->flows[i].start_index != INVALID_ARRAY_INDEX) {
-			if (is_same_tcp4_flow(tbl->flows[i].key, key)) {
-				find = 1;
-				break;
-			}
-			remaining_flow_num--;
-		}
-	}
-
-	if (find == 0) {
+	sig = tcp4_flow_hash(&key);
+	pos = sig & tbl->hash.mask;
+	while ((i = gro_flow_hash_next(&tbl->hash, sig, &pos)) !=
+			INVALID_ARRAY_INDEX)
+		if (is_same_tcp4_flow(tbl->flows[i].key, key))
+			break;
+
+	if (i == INVALID_ARRAY_INDEX) {
 		sent_seq = rte_be_to_cpu_32(tcp_hdr->sent_seq);
 		item_idx = insert_new_tcp_item(pkt, tbl->items, &tbl->item_num,
 						tbl->max_item_num, start_time,
@@ -197,7 +186,7 @@ gro_tcp4_reassemble(struct rte_mbuf *pkt,
 						is_atomic);
 		if (item_idx == INVALID_ARRAY_INDEX)
 			return -1;
-		if (insert_new_flow(tbl, &key, item_idx) ==
+		if (insert_new_flow(tbl, &key, sig, item_idx) ==
 			INVALID_ARRAY_INDEX) {
 			/*
 			 * Fail to insert a new flow, so delete the
@@ -256,8 +245,12 @@ gro_tcp4_tbl_timeout_flush(struct gro_tcp4_tbl *tbl,
 				j = delete_tcp_item(tbl->items, j,
 							&tbl->item_num, INVALID_ARRAY_INDEX);
 				tbl->flows[i].start_index = j;
-				if (j == INVALID_ARRAY_INDEX)
+				if (j == INVALID_ARRAY_INDEX) {
 					tbl->flow_num--;
+					gro_flow_hash_del(&tbl->hash,
+						tcp4_flow_hash(&tbl->flows[i].key),
+						i);
+				}
 
 				if (unlikely(k == nb_out))
 					return k;
@@ -33,6 +33,8 @@ struct gro_tcp4_tbl {
 	struct gro_tcp_item *items;
 	/* flow array */
 	struct gro_tcp4_flow *flows;
+	/* flow index */
+	struct gro_flow_hash hash;
 	/* current item number */
 	uint32_t item_num;
 	/* current flow num */
@@ -144,4 +146,13 @@ is_same_tcp4_flow(struct tcp4_flow_key k1, struct tcp4_flow_key k2)
 			is_same_common_tcp_key(&k1.cmn_key, &k2.cmn_key));
 }
 
+/*
+ * Calculate the signature of a TCP/IPv4 flow key.
+ */
+static inline uint32_t
+tcp4_flow_hash(const struct tcp4_flow_key *k)
+{
+	return rte_hash_crc(k, sizeof(*k), 0);
+}
+
 #endif
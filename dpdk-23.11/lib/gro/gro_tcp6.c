@@ -52,6 +52,12 @@ gro_tcp6_tbl_create(uint16_t socket_id,
 		rte_free(tbl);
 		return NULL;
 	}
+	if (gro_flow_hash_create(&tbl->hash, entries_num, socket_id) < 0) {
+		rte_free(tbl->flows);
+		rte_free(tbl->items);
+		rte_free(tbl);
+		return NULL;
+	}
 	/* INVALID_ARRAY_INDEX indicates an empty flow */
 	for (i = 0; i < entries_num; i++)
 		tbl->flows[i].start_index = INVALID_ARRAY_INDEX;
@@ -68,31 +74,21 @@ gro_tcp6_tbl_destroy(void *tbl)
 	if (tcp_tbl) {
 		rte_free(tcp_tbl->items);
 		rte_free(tcp_tbl->flows);
+		gro_flow_hash_destroy(&tcp_tbl->hash);
 	}
 	rte_free(tcp_tbl);
 }
 
-static inline uint32_t
-find_an_empty_flow(struct gro_tcp6_tbl *tbl)
-{
-	uint32_t i;
-	uint32_t max_flow_num = tbl->max_flow_num;
-
-	for (i = 0; i < max_flow_num; i++)
-		if (tbl->flows[i].start_index == INVALID_ARRAY_INDEX)
-			return i;
-	return INVALID_ARRAY_INDEX;
-}
-
 static inline uint32_t
 insert_new_flow(struct gro_tcp6_tbl *tbl,
 		struct tcp6_flow_key *src,
+		uint32_t sig,
 		uint32_t item_idx)
 {
 	struct tcp6_flow_key *dst;
 	uint32_t flow_idx;
 
-	flow_idx = find_an_empty_flow(tbl);
+	flow_idx = gro_flow_hash_add(&tbl->hash, sig);
 	if (unlikely(flow_idx == INVALID_ARRAY_INDEX))
 		return INVALID_ARRAY_INDEX;
 
@@ -134,10 +130,9 @@ gro_tcp6_reassemble(struct rte_mbuf *pkt,
 	int32_t tcp_dl;
 	uint16_t ip_tlen;
 	struct tcp6_flow_key key;
-	uint32_t i, max_flow_num, remaining_flow_num;
+	uint32_t i, sig, pos;
 	uint32_t sent_seq;
 	struct rte_tcp_hdr *tcp_hdr;
-	uint8_t find;
 	uint32_t item_idx;
 	/*
 	 * Don't process the packet whose TCP header length is greater
@@ -176,27 +171,21 @@ gro_tcp6_reassemble(struct rte_mbuf *pkt,
 	key.vtc_flow = ipv6_hdr->vtc_flow;
 
 	/* Search for a matched flow. */
-	max_flow_num = tbl->max_flow_num;
-	remaining_flow_num = tbl->flow_num;
-	find = 0;
-	for (i = 0; i < max_flow_num && remaining_flow_num; i++) {
-		if (tbl->flows[i].start_index != INVALID_ARRAY_INDEX) {
-			if (is_same_tcp6_flow(&tbl->flows[i].key, &key)) {
-				find = 1;
-				break;
-			}
-			remaining_flow_num--;
-		}
-	}
-
-	if (find == 0) {
+	sig = tcp6_flow_hash(&key);
+	pos = sig & tbl->hash.mask;
+	while ((i = gro_flow_hash_next(&tbl->hash, sig, &pos)) !=
+			INVALID_ARRAY_INDEX)
+		if (is_same_tcp6_flow(&tbl->flows[i].key, &key))
+			break;
+
+	if (i == INVALID_ARRAY_INDEX) {
 		sent_seq = rte_be_to_cpu_32(tcp_hdr->sent_seq);
 		item_idx = insert_new_tcp_item(pkt, tbl->items, &tbl->item_num,
 						tbl->max_item_num, start_time,
 						INVALID_ARRAY_INDEX, sent_seq, 0, true);
 		if (item_idx == INVALID_ARRAY_INDEX)
 			return -1;
-		if (insert_new_flow(tbl, &key, item_idx) ==
+		if (insert_new_flow(tbl, &key, sig, item_idx) ==
 			INVALID_ARRAY_INDEX) {
 			/*
 			 * Fail to insert a new flow, so delete the
@@ -240,8 +229,12 @@ gro_tcp6_tbl_timeout_flush(struct gro_tcp6_tbl *tbl,
 				j = delete_tcp_item(tbl->items, j,
 						&tbl->item_num, INVALID_ARRAY_INDEX);
 				tbl->flows[i].start_index = j;
-				if (j == INVALID_ARRAY_INDEX)
+				if (j == INVALID_ARRAY_INDEX) {
 					tbl->flow_num--;
+					gro_flow_hash_del(&tbl->hash,
+						tcp6_flow_hash(&tbl->flows[i].key),
+						i);
+				}
 
 				if (unlikely(k == nb_out))
 					return k;
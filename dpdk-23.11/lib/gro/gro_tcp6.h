@@ -34,6 +34,8 @@ struct gro_tcp6_tbl {
 	struct gro_tcp_item *items;
 	/* flow array */
 	struct gro_tcp6_flow *flows;
+	/* flow index */
+	struct gro_flow_hash hash;
 	/* current item number */
 	uint32_t item_num;
 	/* current flow num */
@@ -157,4 +159,17 @@ is_same_tcp6_flow(struct tcp6_flow_key *k1, struct tcp6_flow_key *k2)
 	return is_same_common_tcp_key(&k1->cmn_key, &k2->cmn_key);
 }
 
+/*
+ * Calculate the signature of a TCP/IPv6 flow key. Like for the flow
+ * comparison, the traffic class is ignored.
+ */
+static inline uint32_t
+tcp6_flow_hash(const struct tcp6_flow_key *k)
+{
+	uint32_t sig;
+
+	sig = rte_hash_crc(k, offsetof(struct tcp6_flow_key, vtc_flow), 0);
+	return rte_hash_crc_4byte(k->vtc_flow & htonl(0xF00FFFFF), sig);
+}
+
 #endif
@@ -6,18 +6,6 @@
 #ifndef _GRO_TCP_INTERNAL_H_
 #define _GRO_TCP_INTERNAL_H_
 
-static inline uint32_t
-find_an_empty_item(struct gro_tcp_item *items,
-	uint32_t max_item_num)
-{
-	uint32_t i;
-
-	for (i = 0; i < max_item_num; i++)
-		if (items[i].firstseg == NULL)
-			return i;
-	return INVALID_ARRAY_INDEX;
-}
-
 static inline uint32_t
 insert_new_tcp_item(struct rte_mbuf *pkt,
 		struct gro_tcp_item *items,
@@ -31,7 +19,9 @@ insert_new_tcp_item(struct rte_mbuf *pkt,
 {
 	uint32_t item_idx;
 
-	item_idx = find_an_empty_item(items, max_item_num);
+	item_idx = gro_find_empty_item(items, sizeof(*items),
+			offsetof(struct gro_tcp_item, firstseg),
+			*item_num, max_item_num);
 	if (item_idx == INVALID_ARRAY_INDEX)
 		return INVALID_ARRAY_INDEX;
 
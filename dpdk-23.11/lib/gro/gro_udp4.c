@@ -30,7 +30,7 @@ gro_udp4_tbl_create(uint16_t socket_id,
 	if (tbl == NULL)
 		return NULL;
 
-	size = sizeof(struct gro_udp4_item) * entries_num;
+	size = sizeof(struct gro_udp_item) * entries_num;
 	tbl->items = rte_zmalloc_socket(__func__,
 			size,
 			RTE_CACHE_LINE_SIZE,
@@ -51,6 +51,12 @@ gro_udp4_tbl_create(uint16_t socket_id,
 		rte_free(tbl);
 		return NULL;
 	}
+	if (gro_flow_hash_create(&tbl->hash, entries_num, socket_id) < 0) {
+		rte_free(tbl->flows);
+		rte_free(tbl->items);
+		rte_free(tbl);
+		return NULL;
+	}
 	/* INVALID_ARRAY_INDEX indicates an empty flow */
 	for (i = 0; i < entries_num; i++)
 		tbl->flows[i].start_index = INVALID_ARRAY_INDEX;
@@ -67,34 +73,11 @@ gro_udp4_tbl_destroy(void *tbl)
 	if (udp_tbl) {
 		rte_free(udp_tbl->items);
 		rte_free(udp_tbl->flows);
+		gro_flow_hash_destroy(&udp_tbl->hash);
 	}
 	rte_free(udp_tbl);
 }
 
-static inline uint32_t
-find_an_empty_item(struct gro_udp4_tbl *tbl)
-{
-	uint32_t i;
-	uint32_t max_item_num = tbl->max_item_num;
-
-	for (i = 0; i < max_item_num; i++)
-		if (tbl->items[i].firstseg == NULL)
-			return i;
-	return INVALID_ARRAY_INDEX;
-}
-
-static inline uint32_t
-find_an_empty_flow(struct gro_udp4_tbl *tbl)
-{
-	uint32_t i;
-	uint32_t max_flow_num = tbl->max_flow_num;
-
-	for (i = 0; i < max_flow_num; i++)
-		if (tbl->flows[i].start_index == INVALID_ARRAY_INDEX)
-			return i;
-	return INVALID_ARRAY_INDEX;
-}
-
 static inline uint32_t
 insert_new_item(struct gro_udp4_tbl *tbl,
 		struct rte_mbuf *pkt,
@@ -105,7 +88,9 @@ insert_new_item(struct gro_udp4_tbl *tbl,
 {
 	uint32_t item_idx;
 
-	item_idx = find_an_empty_item(tbl);
+	item_idx = gro_find_empty_item(tbl->items, sizeof(tbl->items[0]),
+			offsetof(struct gro_udp_item, firstseg),
+			tbl->item_num, tbl->max_item_num);
 	if (unlikely(item_idx == INVALID_ARRAY_INDEX))
 		return INVALID_ARRAY_INDEX;
 
@@ -146,12 +131,13 @@ delete_item(struct gro_udp4_tbl *tbl, uint32_t item_idx,
 static inline uint32_t
 insert_new_flow(struct gro_udp4_tbl *tbl,
 		struct udp4_flow_key *src,
+		uint32_t sig,
 		uint32_t item_idx)
 {
 	struct udp4_flow_key *dst;
 	uint32_t flow_idx;
 
-	flow_idx = find_an_empty_flow(tbl);
+	flow_idx = gro_flow_hash_add(&tbl->hash, sig);
 	if (unlikely(flow_idx == INVALID_ARRAY_INDEX))
 		return INVALID_ARRAY_INDEX;
 
@@ -173,7 +159,7 @@ insert_new_flow(struct gro_udp4_tbl *tbl,
  * update the packet length for the flushed packet.
  */
 static inline void
-update_header(struct gro_udp4_item *item)
+update_header(struct gro_udp_item *item)
 {
 	struct rte_ipv4_hdr *ipv4_hdr;
 	struct rte_mbuf *pkt = item->firstseg;
@@ -206,9 +192,8 @@ gro_udp4_reassemble(struct rte_mbuf *pkt,
 
 	struct udp4_flow_key key;
 	uint32_t cur_idx, prev_idx, item_idx;
-	uint32_t i, max_flow_num, remaining_flow_num;
+	uint32_t i, sig, pos;
 	int cmp;
-	uint8_t find;
 
 	eth_hdr = rte_pktmbuf_mtod(pkt, struct rte_ether_hdr *);
 	ipv4_hdr = (struct rte_ipv4_hdr *)((char *)eth_hdr + pkt->l2_len);
@@ -248,30 +233,24 @@ gro_udp4_reassemble(struct rte_mbuf *pkt,
 	key.ip_id = ip_id;
 
 	/* Search for a matched flow. */
-	max_flow_num = tbl->max_flow_num;
-	remaining_flow_num = tbl->flow_num;
-	find = 0;
-	for (i = 0; i < max_flow_num && remaining_flow_num; i++) {
-		if (tbl->flows[i].start_index != INVALID_ARRAY_INDEX) {
-			if (is_same_udp4_flow(tbl->flows[i].key, key)) {
-				find = 1;
-				break;
-			}
-			remaining_flow_num--;
-		}
-	}
+	sig = udp4_flow_hash(&key);
+	pos = sig & tbl->hash.mask;
+	while ((i = gro_flow_hash_next(&tbl->hash, sig, &pos)) !=
+			INVALID_ARRAY_INDEX)
+		if (is_same_udp4_flow(tbl->flows[i].key, key))
+			break;
 
 	/*
 	 * Fail to find a matched flow. Insert a new flow and store the
 	 * packet into the flow.
 	 */
-	if (find == 0) {
+	if (i == INVALID_ARRAY_INDEX) {
 		item_idx = insert_new_item(tbl, pkt, start_time,
 				INVALID_ARRAY_INDEX, frag_offset,
 				is_last_frag);
 		if (unlikely(item_idx == INVALID_ARRAY_INDEX))
 			return -1;
-		if (insert_new_flow(tbl, &key, item_idx) ==
+		if (insert_new_flow(tbl, &key, sig, item_idx) ==
 				INVALID_ARRAY_INDEX) {
 			/*
 			 * Fail to insert a new flow, so delete the
@@ -290,10 +269,10 @@ gro_udp4_reassemble(struct rte_mbuf *pkt,
 	cur_idx = tbl->flows[i].start_index;
 	prev_idx = cur_idx;
 	do {
-		cmp = udp4_check_neighbor(&(tbl->items[cur_idx]),
+		cmp = udp_check_neighbor(&(tbl->items[cur_idx]),
 				frag_offset, ip_dl, 0);
 		if (cmp) {
-			if (merge_two_udp4_packets(&(tbl->items[cur_idx]),
+			if (merge_two_udp_packets(&(tbl->items[cur_idx]),
 						pkt, cmp, frag_offset,
 						is_last_frag, 0))
 				return 1;
@@ -358,10 +337,10 @@ gro_udp4_merge_items(struct gro_udp4_tbl *tbl,
 		ip_dl = pkt->pkt_len - hdr_len;
 		frag_offset = tbl->items[item_idx].frag_offset;
 		is_last_frag = tbl->items[item_idx].is_last_frag;
-		cmp = udp4_check_neighbor(&(tbl->items[start_idx]),
+		cmp = udp_check_neighbor(&(tbl->items[start_idx]),
 					frag_offset, ip_dl, 0);
 		if (cmp) {
-			if (merge_two_udp4_packets(
+			if (merge_two_udp_packets(
 					&(tbl->items[start_idx]),
 					pkt, cmp, frag_offset,
 					is_last_frag, 0)) {
@@ -405,8 +384,12 @@ gro_udp4_tbl_timeout_flush(struct gro_udp4_tbl *tbl,
 				 */
 				j = delete_item(tbl, j, INVALID_ARRAY_INDEX);
 				tbl->flows[i].start_index = j;
-				if (j == INVALID_ARRAY_INDEX)
+				if (j == INVALID_ARRAY_INDEX) {
 					tbl->flow_num--;
+					gro_flow_hash_del(&tbl->hash,
+						udp4_flow_hash(&tbl->flows[i].key),
+						i);
+				}
 
 				if (unlikely(k == nb_out))
 					return k;
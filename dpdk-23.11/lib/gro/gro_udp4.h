@@ -7,14 +7,9 @@
 
 #include <rte_ip.h>
 
-#define INVALID_ARRAY_INDEX 0xffffffffUL
-#define GRO_UDP4_TBL_MAX_ITEM_NUM (1024UL * 1024UL)
+#include "gro_udp.h"
 
-/*
- * The max length of a IPv4 packet, which includes the length of the L3
- * header, the L4 header and the data payload.
- */
-#define MAX_IPV4_PKT_LENGTH UINT16_MAX
+#define GRO_UDP4_TBL_MAX_ITEM_NUM (1024UL * 1024UL)
 
 /* Header fields representing a UDP/IPv4 flow */
 struct udp4_flow_key {
@@ -38,42 +33,16 @@ struct gro_udp4_flow {
 	uint32_t start_index;
 };
 
-struct gro_udp4_item {
-	/*
-	 * The first MBUF segment of the packet. If the value
-	 * is NULL, it means the item is empty.
-	 */
-	struct rte_mbuf *firstseg;
-	/* The last MBUF segment of the packet */
-	struct rte_mbuf *lastseg;
-	/*
-	 * The time when the first packet is inserted into the table.
-	 * This value won't be updated, even if the packet is merged
-	 * with other packets.
-	 */
-	uint64_t start_time;
-	/*
-	 * next_pkt_idx is used to chain the packets that
-	 * are in the same flow but can't be merged together
-	 * (e.g. caused by packet reordering).
-	 */
-	uint32_t next_pkt_idx;
-	/* offset of IP fragment packet */
-	uint16_t frag_offset;
-	/* is last IP fragment? */
-	uint8_t is_last_frag;
-	/* the number of merged packets */
-	uint16_t nb_merged;
-};
-
 /*
  * UDP/IPv4 reassembly table structure.
  */
 struct gro_udp4_tbl {
 	/* item array */
-	struct gro_udp4_item *items;
+	struct gro_udp_item *items;
 	/* flow array */
 	struct gro_udp4_flow *flows;
+	/* flow index */
+	struct gro_flow_hash hash;
 	/* current item number */
 	uint32_t item_num;
 	/* current flow num */
@@ -184,86 +153,14 @@ is_same_udp4_flow(struct udp4_flow_key k1, struct udp4_flow_key k2)
 }
 
 /*
- * Merge two UDP/IPv4 packets without updating checksums.
- * If cmp is larger than 0, append the new packet to the
- * original packet. Otherwise, pre-pend the new packet to
- * the original packet.
+ * Calculate the signature of a UDP/IPv4 flow key, without the tail
+ * padding of the key.
  */
-static inline int
-merge_two_udp4_packets(struct gro_udp4_item *item,
-		struct rte_mbuf *pkt,
-		int cmp,
-		uint16_t frag_offset,
-		uint8_t is_last_frag,
-		uint16_t l2_offset)
+static inline uint32_t
+udp4_flow_hash(const struct udp4_flow_key *k)
 {
-	struct rte_mbuf *pkt_head, *pkt_tail, *lastseg;
-	uint16_t hdr_len, l2_len;
-	uint32_t ip_len;
-
-	if (cmp > 0) {
-		pkt_head = item->firstseg;
-		pkt_tail = pkt;
-	} else {
-		pkt_head = pkt;
-		pkt_tail = item->firstseg;
-	}
-
-	/* check if the IPv4 packet length is greater than the max value */
-	hdr_len = l2_offset + pkt_head->l2_len + pkt_head->l3_len;
-	l2_len = l2_offset > 0 ? pkt_head->outer_l2_len : pkt_head->l2_len;
-	ip_len = pkt_head->pkt_len - l2_len
-		 + pkt_tail->pkt_len - hdr_len;
-	if (unlikely(ip_len > MAX_IPV4_PKT_LENGTH))
-		return 0;
-
-	/* remove the packet header for the tail packet */
-	rte_pktmbuf_adj(pkt_tail, hdr_len);
-
-	/* chain two packets together */
-	if (cmp > 0) {
-		item->lastseg->next = pkt;
-		item->lastseg = rte_pktmbuf_lastseg(pkt);
-	} else {
-		lastseg = rte_pktmbuf_lastseg(pkt);
-		lastseg->next = item->firstseg;
-		item->firstseg = pkt;
-		item->frag_offset = frag_offset;
-	}
-	item->nb_merged++;
-	if (is_last_frag)
-		item->is_last_frag = is_last_frag;
-
-	/* update MBUF metadata for the merged packet */
-	pkt_head->nb_segs += pkt_tail->nb_segs;
-	pkt_head->pkt_len += pkt_tail->pkt_len;
-
-	return 1;
-}
-
-/*
- * Check if two UDP/IPv4 packets are neighbors.
- */
-static inline int
-udp4_check_neighbor(struct gro_udp4_item *item,
-		uint16_t frag_offset,
-		uint16_t ip_dl,
-		uint16_t l2_offset)
-{
-	struct rte_mbuf *pkt_orig = item->firstseg;
-	uint16_t len;
-
-	/* check if the two packets are neighbors */
-	len = pkt_orig->pkt_len - l2_offset - pkt_orig->l2_len -
-		pkt_orig->l3_len;
-	if (frag_offset == item->frag_offset + len)
-		/* append the new packet */
-		return 1;
-	else if (frag_offset + ip_dl == item->frag_offset)
-		/* pre-pend the new packet */
-		return -1;
-
-	return 0;
+	return rte_hash_crc(k, offsetof(struct udp4_flow_key, ip_id) +
+			sizeof(k->ip_id), 0);
 }
 
 static inline int
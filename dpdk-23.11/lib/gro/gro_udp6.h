@@ -0,0 +1,188 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GRO_UDP6_H_
+#define _GRO_UDP6_H_
+
+#include <rte_ip.h>
+
+#include "gro_udp.h"
+
+#define GRO_UDP6_TBL_MAX_ITEM_NUM (1024UL * 1024UL)
+
+/* Header fields representing a UDP/IPv6 flow */
+struct udp6_flow_key {
+	struct rte_ether_addr eth_saddr;
+	struct rte_ether_addr eth_daddr;
+	uint8_t src_addr[16];
+	uint8_t dst_addr[16];
+
+	/* IP fragment for UDP does not contain UDP header
+	 * except the first one. But the identification of the
+	 * fragment extension header must be same.
+	 */
+	rte_be32_t frag_id;
+};
+
+struct gro_udp6_flow {
+	struct udp6_flow_key key;
+	/*
+	 * The index of the first packet in the flow.
+	 * INVALID_ARRAY_INDEX indicates an empty flow.
+	 */
+	uint32_t start_index;
+};
+
+/*
+ * UDP/IPv6 reassembly table structure.
+ */
+struct gro_udp6_tbl {
+	/* item array */
+	struct gro_udp_item *items;
+	/* flow array */
+	struct gro_udp6_flow *flows;
+	/* flow index */
+	struct gro_flow_hash hash;
+	/* current item number */
+	uint32_t item_num;
+	/* current flow num */
+	uint32_t flow_num;
+	/* item array size */
+	uint32_t max_item_num;
+	/* flow array size */
+	uint32_t max_flow_num;
+};
+
+/**
+ * This function creates a UDP/IPv6 reassembly table.
+ *
+ * @param socket_id
+ *  Socket index for allocating the UDP/IPv6 reassemble table
+ * @param max_flow_num
+ *  The maximum number of flows in the UDP/IPv6 GRO table
+ * @param max_item_per_flow
+ *  The maximum number of packets per flow
+ *
+ * @return
+ *  - Return the table pointer on success.
+ *  - Return NULL on failure.
+ */
+void *gro_udp6_tbl_create(uint16_t socket_id,
+		uint16_t max_flow_num,
+		uint16_t max_item_per_flow);
+
+/**
+ * This function destroys a UDP/IPv6 reassembly table.
+ *
+ * @param tbl
+ *  Pointer pointing to the UDP/IPv6 reassembly table.
+ */
+void gro_udp6_tbl_destroy(void *tbl);
+
+/**
+ * This function merges a UDP/IPv6 packet.
+ *
+ * This function does not check if the packet has correct checksums and
+ * does not re-calculate checksums for the merged packet. It returns the
+ * packet if it isn't UDP fragment or there is no available space in
+ * the table.
+ *
+ * @param pkt
+ *  Packet to reassemble
+ * @param tbl
+ *  Pointer pointing to the UDP/IPv6 reassembly table
+ * @start_time
+ *  The time when the packet is inserted into the table
+ *
+ * @return
+ *  - Return a positive value if the packet is merged.
+ *  - Return zero if the packet isn't merged but stored in the table.
+ *  - Return a negative value for invalid parameters or no available
+ *    space in the table.
+ */
+int32_t gro_udp6_reassemble(struct rte_mbuf *pkt,
+		struct gro_udp6_tbl *tbl,
+		uint64_t start_time);
+
+/**
+ * This function flushes timeout packets in a UDP/IPv6 reassembly table,
+ * and without updating checksums.
+ *
+ * @param tbl
+ *  UDP/IPv6 reassembly table pointer
+ * @param flush_timestamp
+ *  Flush packets which are inserted into the table before or at the
+ *  flush_timestamp.
+ * @param out
+ *  Pointer array used to keep flushed packets
+ * @param nb_out
+ *  The element number in 'out'. It also determines the maximum number of
+ *  packets that can be flushed finally.
+ *
+ * @return
+ *  The number of flushed packets
+ */
+uint16_t gro_udp6_tbl_timeout_flush(struct gro_udp6_tbl *tbl,
+		uint64_t flush_timestamp,
+		struct rte_mbuf **out,
+		uint16_t nb_out);
+
+/**
+ * This function returns the number of the packets in a UDP/IPv6
+ * reassembly table.
+ *
+ * @param tbl
+ *  UDP/IPv6 reassembly table pointer
+ *
+ * @return
+ *  The number of packets in the table
+ */
+uint32_t gro_udp6_tbl_pkt_count(void *tbl);
+
+/*
+ * Check if two UDP/IPv6 packets belong to the same flow.
+ */
+static inline int
+is_same_udp6_flow(struct udp6_flow_key *k1, struct udp6_flow_key *k2)
+{
+	return (rte_is_same_ether_addr(&k1->eth_saddr, &k2->eth_saddr) &&
+			rte_is_same_ether_addr(&k1->eth_daddr, &k2->eth_daddr) &&
+			!memcmp(k1->src_addr, k2->src_addr, sizeof(k1->src_addr)) &&
+			!memcmp(k1->dst_addr, k2->dst_addr, sizeof(k1->dst_addr)) &&
+			(k1->frag_id == k2->frag_id));
+}
+
+/*
+ * Calculate the signature of a UDP/IPv6 flow key.
+ */
+static inline uint32_t
+udp6_flow_hash(const struct udp6_flow_key *k)
+{
+	return rte_hash_crc(k, sizeof(*k), 0);
+}
+
+/*
+ * Get the fragment extension header in the first 'l3_len' bytes of an
+ * IPv6 packet. Return NULL if the packet isn't a fragment.
+ */
+static inline struct rte_ipv6_fragment_ext *
+get_ipv6_frag_hdr(struct rte_ipv6_hdr *hdr, uint16_t l3_len)
+{
+	uint8_t *ext = (uint8_t *)(hdr + 1);
+	uint16_t offset = sizeof(struct rte_ipv6_hdr);
+	int proto = hdr->proto;
+	size_t ext_len;
+
+	while (offset + RTE_IPV6_FRAG_HDR_SIZE <= l3_len) {
+		if (proto == IPPROTO_FRAGMENT)
+			return (struct rte_ipv6_fragment_ext *)ext;
+		proto = rte_ipv6_get_next_ext(ext, proto, &ext_len);
+		if (proto < 0)
+			return NULL;
+		ext += ext_len;
+		offset += ext_len;
+	}
+
+	return NULL;
+}
+#endif
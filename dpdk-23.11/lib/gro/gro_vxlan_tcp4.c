@@ -52,6 +52,12 @@ gro_vxlan_tcp4_tbl_create(uint16_t socket_id,
 		rte_free(tbl);
 		return NULL;
 	}
+	if (gro_flow_hash_create(&tbl->hash, entries_num, socket_id) < 0) {
+		rte_free(tbl->flows);
+		rte_free(tbl->items);
+		rte_free(tbl);
+		return NULL;
+	}
 
 	for (i = 0; i < entries_num; i++)
 		tbl->flows[i].start_index = INVALID_ARRAY_INDEX;
@@ -68,32 +74,11 @@ gro_vxlan_tcp4_tbl_destroy(void *tbl)
 	if (vxlan_tbl) {
 		rte_free(vxlan_tbl->items);
 		rte_free(vxlan_tbl->flows);
+		gro_flow_hash_destroy(&vxlan_tbl->hash);
 	}
 	rte_free(vxlan_tbl);
 }
 
-static inline uint32_t
-find_an_empty_item(struct gro_vxlan_tcp4_tbl *tbl)
-{
-	uint32_t max_item_num = tbl->max_item_num, i;
-
-	for (i = 0; i < max_item_num; i++)
-		if (tbl->items[i].inner_item.firstseg == NULL)
-			return i;
-	return INVALID_ARRAY_INDEX;
-}
-
-static inline uint32_t
-find_an_empty_flow(struct gro_vxlan_tcp4_tbl *tbl)
-{
-	uint32_t max_flow_num = tbl->max_flow_num, i;
-
-	for (i = 0; i < max_flow_num; i++)
-		if (tbl->flows[i].start_index == INVALID_ARRAY_INDEX)
-			return i;
-	return INVALID_ARRAY_INDEX;
-}
-
 static inline uint32_t
 insert_new_item(struct gro_vxlan_tcp4_tbl *tbl,
 		struct rte_mbuf *pkt,
@@ -107,7 +92,10 @@ insert_new_item(struct gro_vxlan_tcp4_tbl *tbl,
 {
 	uint32_t item_idx;
 
-	item_idx = find_an_empty_item(tbl);
+	item_idx = gro_find_empty_item(tbl->items, sizeof(tbl->items[0]),
+			offsetof(struct gro_vxlan_tcp4_item,
+			inner_item.firstseg),
+			tbl->item_num, tbl->max_item_num);
 	if (unlikely(item_idx == INVALID_ARRAY_INDEX))
 		return INVALID_ARRAY_INDEX;
 
@@ -152,12 +140,13 @@ delete_item(struct gro_vxlan_tcp4_tbl *tbl,
 static inline uint32_t
 insert_new_flow(struct gro_vxlan_tcp4_tbl *tbl,
 		struct vxlan_tcp4_flow_key *src,
+		uint32_t sig,
 		uint32_t item_idx)
 {
 	struct vxlan_tcp4_flow_key *dst;
 	uint32_t flow_idx;
 
-	flow_idx = find_an_empty_flow(tbl);
+	flow_idx = gro_flow_hash_add(&tbl->hash, sig);
 	if (unlikely(flow_idx == INVALID_ARRAY_INDEX))
 		return INVALID_ARRAY_INDEX;
 
@@ -171,8 +160,10 @@ insert_new_flow(struct gro_vxlan_tcp4_tbl *tbl,
 	dst->vxlan_hdr.vx_vni = src->vxlan_hdr.vx_vni;
 	rte_ether_addr_copy(&(src->outer_eth_saddr), &(dst->outer_eth_saddr));
 	rte_ether_addr_copy(&(src->outer_eth_daddr), &(dst->outer_eth_daddr));
-	dst->outer_ip_src_addr = src->outer_ip_src_addr;
-	dst->outer_ip_dst_addr = src->outer_ip_dst_addr;
+	memcpy(dst->outer_ip_src_addr, src->outer_ip_src_addr,
+			sizeof(dst->outer_ip_src_addr));
+	memcpy(dst->outer_ip_dst_addr, src->outer_ip_dst_addr,
+			sizeof(dst->outer_ip_dst_addr));
 	dst->outer_src_port = src->outer_src_port;
 	dst->outer_dst_port = src->outer_dst_port;
 
@@ -190,8 +181,10 @@ is_same_vxlan_tcp4_flow(struct vxlan_tcp4_flow_key k1,
 					&k2.outer_eth_saddr) &&
 			rte_is_same_ether_addr(&k1.outer_eth_daddr,
 				&k2.outer_eth_daddr) &&
-			(k1.outer_ip_src_addr == k2.outer_ip_src_addr) &&
-			(k1.outer_ip_dst_addr == k2.outer_ip_dst_addr) &&
+			!memcmp(k1.outer_ip_src_addr, k2.outer_ip_src_addr,
+				sizeof(k1.outer_ip_src_addr)) &&
+			!memcmp(k1.outer_ip_dst_addr, k2.outer_ip_dst_addr,
+				sizeof(k1.outer_ip_dst_addr)) &&
 			(k1.outer_src_port == k2.outer_src_port) &&
 			(k1.outer_dst_port == k2.outer_dst_port) &&
 			(k1.vxlan_hdr.vx_flags == k2.vxlan_hdr.vx_flags) &&
@@ -199,6 +192,20 @@ is_same_vxlan_tcp4_flow(struct vxlan_tcp4_flow_key k1,
 			is_same_tcp4_flow(k1.inner_key, k2.inner_key));
 }
 
+/*
+ * Calculate the signature of a VxLAN flow key, from the inner flow key
+ * and the fields following it.
+ */
+static inline uint32_t
+vxlan_tcp4_flow_hash(const struct vxlan_tcp4_flow_key *k)
+{
+	return rte_hash_crc(&k->vxlan_hdr,
+			offsetof(struct vxlan_tcp4_flow_key, outer_dst_port) +
+			sizeof(k->outer_dst_port) -
+			offsetof(struct vxlan_tcp4_flow_key, vxlan_hdr),
+			tcp4_flow_hash(&k->inner_key));
+}
+
 static inline int
 check_vxlan_seq_option(struct gro_vxlan_tcp4_item *item,
 		struct rte_tcp_hdr *tcp_hdr,
@@ -257,19 +264,28 @@ static inline void
 update_vxlan_header(struct gro_vxlan_tcp4_item *item)
 {
 	struct rte_ipv4_hdr *ipv4_hdr;
+	struct rte_ipv6_hdr *ipv6_hdr;
 	struct rte_udp_hdr *udp_hdr;
 	struct rte_mbuf *pkt = item->inner_item.firstseg;
 	uint16_t len;
 
-	/* Update the outer IPv4 header. */
+	/* Update the outer IPv4 or IPv6 header. */
 	len = pkt->pkt_len - pkt->outer_l2_len;
-	ipv4_hdr = (struct rte_ipv4_hdr *)(rte_pktmbuf_mtod(pkt, char *) +
-			pkt->outer_l2_len);
-	ipv4_hdr->total_length = rte_cpu_to_be_16(len);
+	if (RTE_ETH_IS_IPV6_HDR(pkt->packet_type)) {
+		ipv6_hdr = (struct rte_ipv6_hdr *)
+			(rte_pktmbuf_mtod(pkt, char *) + pkt->outer_l2_len);
+		ipv6_hdr->payload_len = rte_cpu_to_be_16(len -
+				sizeof(struct rte_ipv6_hdr));
+	} else {
+		ipv4_hdr = (struct rte_ipv4_hdr *)
+			(rte_pktmbuf_mtod(pkt, char *) + pkt->outer_l2_len);
+		ipv4_hdr->total_length = rte_cpu_to_be_16(len);
+	}
 
 	/* Update the outer UDP header. */
 	len -= pkt->outer_l3_len;
-	udp_hdr = (struct rte_udp_hdr *)((char *)ipv4_hdr + pkt->outer_l3_len);
+	udp_hdr = (struct rte_udp_hdr *)(rte_pktmbuf_mtod(pkt, char *) +
+			pkt->outer_l2_len + pkt->outer_l3_len);
 	udp_hdr->dgram_len = rte_cpu_to_be_16(len);
 
 	/* Update the inner IPv4 header. */
@@ -285,20 +301,20 @@ gro_vxlan_tcp4_reassemble(struct rte_mbuf *pkt,
 {
 	struct rte_ether_hdr *outer_eth_hdr, *eth_hdr;
 	struct rte_ipv4_hdr *outer_ipv4_hdr, *ipv4_hdr;
+	struct rte_ipv6_hdr *outer_ipv6_hdr;
 	struct rte_tcp_hdr *tcp_hdr;
 	struct rte_udp_hdr *udp_hdr;
 	struct rte_vxlan_hdr *vxlan_hdr;
 	uint32_t sent_seq;
 	int32_t tcp_dl;
 	uint16_t frag_off, outer_ip_id, ip_id;
-	uint8_t outer_is_atomic, is_atomic;
+	uint8_t outer_ipv6, outer_is_atomic, is_atomic;
 
 	struct vxlan_tcp4_flow_key key;
 	uint32_t cur_idx, prev_idx, item_idx;
-	uint32_t i, max_flow_num, remaining_flow_num;
+	uint32_t i, sig, pos;
 	int cmp;
 	uint16_t hdr_len;
-	uint8_t find;
 
 	/*
 	 * Don't process the packet whose TCP header length is greater
@@ -307,6 +323,7 @@ gro_vxlan_tcp4_reassemble(struct rte_mbuf *pkt,
 	if (unlikely(INVALID_TCP_HDRLEN(pkt->l4_len)))
 		return -1;
 
+	outer_ipv6 = RTE_ETH_IS_IPV6_HDR(pkt->packet_type) ? 1 : 0;
 	outer_eth_hdr = rte_pktmbuf_mtod(pkt, struct rte_ether_hdr *);
 	outer_ipv4_hdr = (struct rte_ipv4_hdr *)((char *)outer_eth_hdr +
 			pkt->outer_l2_len);
@@ -340,11 +357,17 @@ gro_vxlan_tcp4_reassemble(struct rte_mbuf *pkt,
 	 * Save IPv4 ID for the packet whose DF bit is 0. For the packet
 	 * whose DF bit is 1, IPv4 ID is ignored.
 	 */
-	frag_off = rte_be_to_cpu_16(outer_ipv4_hdr->fragment_offset);
-	outer_is_atomic =
-		(frag_off & RTE_IPV4_HDR_DF_FLAG) == RTE_IPV4_HDR_DF_FLAG;
-	outer_ip_id = outer_is_atomic ? 0 :
-		rte_be_to_cpu_16(outer_ipv4_hdr->packet_id);
+	if (outer_ipv6) {
+		/* There is no ID in the outer IPv6 header. */
+		outer_is_atomic = 1;
+		outer_ip_id = 0;
+	} else {
+		frag_off = rte_be_to_cpu_16(outer_ipv4_hdr->fragment_offset);
+		outer_is_atomic = (frag_off & RTE_IPV4_HDR_DF_FLAG) ==
+			RTE_IPV4_HDR_DF_FLAG;
+		outer_ip_id = outer_is_atomic ? 0 :
+			rte_be_to_cpu_16(outer_ipv4_hdr->packet_id);
+	}
 	frag_off = rte_be_to_cpu_16(ipv4_hdr->fragment_offset);
 	is_atomic = (frag_off & RTE_IPV4_HDR_DF_FLAG) == RTE_IPV4_HDR_DF_FLAG;
 	ip_id = is_atomic ? 0 : rte_be_to_cpu_16(ipv4_hdr->packet_id);
@@ -363,36 +386,42 @@ gro_vxlan_tcp4_reassemble(struct rte_mbuf *pkt,
 	key.vxlan_hdr.vx_vni = vxlan_hdr->vx_vni;
 	rte_ether_addr_copy(&(outer_eth_hdr->src_addr), &(key.outer_eth_saddr));
 	rte_ether_addr_copy(&(outer_eth_hdr->dst_addr), &(key.outer_eth_daddr));
-	key.outer_ip_src_addr = outer_ipv4_hdr->src_addr;
-	key.outer_ip_dst_addr = outer_ipv4_hdr->dst_addr;
+	if (outer_ipv6) {
+		outer_ipv6_hdr = (struct rte_ipv6_hdr *)outer_ipv4_hdr;
+		memcpy(key.outer_ip_src_addr, outer_ipv6_hdr->src_addr,
+				sizeof(key.outer_ip_src_addr));
+		memcpy(key.outer_ip_dst_addr, outer_ipv6_hdr->dst_addr,
+				sizeof(key.outer_ip_dst_addr));
+	} else {
+		memset(key.outer_ip_src_addr, 0, sizeof(key.outer_ip_src_addr));
+		memset(key.outer_ip_dst_addr, 0, sizeof(key.outer_ip_dst_addr));
+		memcpy(key.outer_ip_src_addr, &outer_ipv4_hdr->src_addr,
+				sizeof(outer_ipv4_hdr->src_addr));
+		memcpy(key.outer_ip_dst_addr, &outer_ipv4_hdr->dst_addr,
+				sizeof(outer_ipv4_hdr->dst_addr));
+	}
 	key.outer_src_port = udp_hdr->src_port;
 	key.outer_dst_port = udp_hdr->dst_port;
 
 	/* Search for a matched flow. */
-	max_flow_num = tbl->max_flow_num;
-	remaining_flow_num = tbl->flow_num;
-	find = 0;
-	for (i = 0; i < max_flow_num && remaining_flow_num; i++) {
-		if (tbl->flows[i].start_index != INVALID_ARRAY_INDEX) {
-			if (is_same_vxlan_tcp4_flow(tbl->flows[i].key, key)) {
-				find = 1;
-				break;
-			}
-			remaining_flow_num--;
-		}
-	}
+	sig = vxlan_tcp4_flow_hash(&key);
+	pos = sig & tbl->hash.mask;
+	while ((i = gro_flow_hash_next(&tbl->hash, sig, &pos)) !=
+			INVALID_ARRAY_INDEX)
+		if (is_same_vxlan_tcp4_flow(tbl->flows[i].key, key))
+			break;
 
 	/*
 	 * Can't find a matched flow. Insert a new flow and store the
 	 * packet into the flow.
 	 */
-	if (find == 0) {
+	if (i == INVALID_ARRAY_INDEX) {
 		item_idx = insert_new_item(tbl, pkt, start_time,
 				INVALID_ARRAY_INDEX, sent_seq, outer_ip_id,
 				ip_id, outer_is_atomic, is_atomic);
 		if (item_idx == INVALID_ARRAY_INDEX)
 			return -1;
-		if (insert_new_flow(tbl, &key, item_idx) ==
+		if (insert_new_flow(tbl, &key, sig, item_idx) ==
 				INVALID_ARRAY_INDEX) {
 			/*
 			 * Fail to insert a new flow, so
@@ -469,8 +498,12 @@ gro_vxlan_tcp4_tbl_timeout_flush(struct gro_vxlan_tcp4_tbl *tbl,
 				 */
 				j = delete_item(tbl, j, INVALID_ARRAY_INDEX);
 				tbl->flows[i].start_index = j;
-				if (j == INVALID_ARRAY_INDEX)
+				if (j == INVALID_ARRAY_INDEX) {
 					tbl->flow_num--;
+					gro_flow_hash_del(&tbl->hash,
+						vxlan_tcp4_flow_hash(&tbl->flows[i].key),
+						i);
+				}
 
 				if (unlikely(k == nb_out))
 					return k;
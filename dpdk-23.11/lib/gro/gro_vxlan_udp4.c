@@ -52,6 +52,12 @@ gro_vxlan_udp4_tbl_create(uint16_t socket_id,
 		rte_free(tbl);
 		return NULL;
 	}
+	if (gro_flow_hash_create(&tbl->hash, entries_num, socket_id) < 0) {
+		rte_free(tbl->flows);
+		rte_free(tbl->items);
+		rte_free(tbl);
+		return NULL;
+	}
 
 	for (i = 0; i < entries_num; i++)
 		tbl->flows[i].start_index = INVALID_ARRAY_INDEX;
@@ -68,32 +74,11 @@ gro_vxlan_udp4_tbl_destroy(void *tbl)
 	if (vxlan_tbl) {
 		rte_free(vxlan_tbl->items);
 		rte_free(vxlan_tbl->flows);
+		gro_flow_hash_destroy(&vxlan_tbl->hash);
 	}
 	rte_free(vxlan_tbl);
 }
 
-static inline uint32_t
-find_an_empty_item(struct gro_vxlan_udp4_tbl *tbl)
-{
-	uint32_t max_item_num = tbl->max_item_num, i;
-
-	for (i = 0; i < max_item_num; i++)
-		if (tbl->items[i].inner_item.firstseg == NULL)
-			return i;
-	return INVALID_ARRAY_INDEX;
-}
-
-static inline uint32_t
-find_an_empty_flow(struct gro_vxlan_udp4_tbl *tbl)
-{
-	uint32_t max_flow_num = tbl->max_flow_num, i;
-
-	for (i = 0; i < max_flow_num; i++)
-		if (tbl->flows[i].start_index == INVALID_ARRAY_INDEX)
-			return i;
-	return INVALID_ARRAY_INDEX;
-}
-
 static inline uint32_t
 insert_new_item(struct gro_vxlan_udp4_tbl *tbl,
 		struct rte_mbuf *pkt,
@@ -104,7 +89,10 @@ insert_new_item(struct gro_vxlan_udp4_tbl *tbl,
 {
 	uint32_t item_idx;
 
-	item_idx = find_an_empty_item(tbl);
+	item_idx = gro_find_empty_item(tbl->items, sizeof(tbl->items[0]),
+			offsetof(struct gro_vxlan_udp4_item,
+			inner_item.firstseg),
+			tbl->item_num, tbl->max_item_num);
 	if (unlikely(item_idx == INVALID_ARRAY_INDEX))
 		return INVALID_ARRAY_INDEX;
 
@@ -146,12 +134,13 @@ delete_item(struct gro_vxlan_udp4_tbl *tbl,
 static inline uint32_t
 insert_new_flow(struct gro_vxlan_udp4_tbl *tbl,
 		struct vxlan_udp4_flow_key *src,
+		uint32_t sig,
 		uint32_t item_idx)
 {
 	struct vxlan_udp4_flow_key *dst;
 	uint32_t flow_idx;
 
-	flow_idx = find_an_empty_flow(tbl);
+	flow_idx = gro_flow_hash_add(&tbl->hash, sig);
 	if (unlikely(flow_idx == INVALID_ARRAY_INDEX))
 		return INVALID_ARRAY_INDEX;
 
@@ -169,8 +158,10 @@ insert_new_flow(struct gro_vxlan_udp4_tbl *tbl,
 	dst->vxlan_hdr.vx_vni = src->vxlan_hdr.vx_vni;
 	rte_ether_addr_copy(&(src->outer_eth_saddr), &(dst->outer_eth_saddr));
 	rte_ether_addr_copy(&(src->outer_eth_daddr), &(dst->outer_eth_daddr));
-	dst->outer_ip_src_addr = src->outer_ip_src_addr;
-	dst->outer_ip_dst_addr = src->outer_ip_dst_addr;
+	memcpy(dst->outer_ip_src_addr, src->outer_ip_src_addr,
+			sizeof(dst->outer_ip_src_addr));
+	memcpy(dst->outer_ip_dst_addr, src->outer_ip_dst_addr,
+			sizeof(dst->outer_ip_dst_addr));
 	dst->outer_dst_port = src->outer_dst_port;
 
 	tbl->flows[flow_idx].start_index = item_idx;
@@ -193,14 +184,30 @@ is_same_vxlan_udp4_flow(struct vxlan_udp4_flow_key k1,
 					&k2.outer_eth_saddr) &&
 			rte_is_same_ether_addr(&k1.outer_eth_daddr,
 				&k2.outer_eth_daddr) &&
-			(k1.outer_ip_src_addr == k2.outer_ip_src_addr) &&
-			(k1.outer_ip_dst_addr == k2.outer_ip_dst_addr) &&
+			!memcmp(k1.outer_ip_src_addr, k2.outer_ip_src_addr,
+				sizeof(k1.outer_ip_src_addr)) &&
+			!memcmp(k1.outer_ip_dst_addr, k2.outer_ip_dst_addr,
+				sizeof(k1.outer_ip_dst_addr)) &&
 			(k1.outer_dst_port == k2.outer_dst_port) &&
 			(k1.vxlan_hdr.vx_flags == k2.vxlan_hdr.vx_flags) &&
 			(k1.vxlan_hdr.vx_vni == k2.vxlan_hdr.vx_vni) &&
 			is_same_udp4_flow(k1.inner_key, k2.inner_key));
 }
 
+/*
+ * Calculate the signature of a VxLAN flow key, from the inner flow key
+ * and the fields following it.
+ */
+static inline uint32_t
+vxlan_udp4_flow_hash(const struct vxlan_udp4_flow_key *k)
+{
+	return rte_hash_crc(&k->vxlan_hdr,
+			offsetof(struct vxlan_udp4_flow_key, outer_dst_port) +
+			sizeof(k->outer_dst_port) -
+			offsetof(struct vxlan_udp4_flow_key, vxlan_hdr),
+			udp4_flow_hash(&k->inner_key));
+}
+
 static inline int
 udp4_check_vxlan_neighbor(struct gro_vxlan_udp4_item *item,
 		uint16_t frag_offset,
@@ -220,7 +227,7 @@ udp4_check_vxlan_neighbor(struct gro_vxlan_udp4_item *item,
 	 */
 
 	l2_offset = pkt->outer_l2_len + pkt->outer_l3_len;
-	cmp = udp4_check_neighbor(&item->inner_item, frag_offset, ip_dl,
+	cmp = udp_check_neighbor(&item->inner_item, frag_offset, ip_dl,
 					l2_offset);
 	if (cmp > 0)
 		/* Append the new packet. */
@@ -239,7 +246,7 @@ merge_two_vxlan_udp4_packets(struct gro_vxlan_udp4_item *item,
 		uint16_t frag_offset,
 		uint8_t is_last_frag)
 {
-	if (merge_two_udp4_packets(&item->inner_item, pkt, cmp, frag_offset,
+	if (merge_two_udp_packets(&item->inner_item, pkt, cmp, frag_offset,
 				is_last_frag,
 				pkt->outer_l2_len + pkt->outer_l3_len)) {
 		return 1;
@@ -252,20 +259,29 @@ static inline void
 update_vxlan_header(struct gro_vxlan_udp4_item *item)
 {
 	struct rte_ipv4_hdr *ipv4_hdr;
+	struct rte_ipv6_hdr *ipv6_hdr;
 	struct rte_udp_hdr *udp_hdr;
 	struct rte_mbuf *pkt = item->inner_item.firstseg;
 	uint16_t len;
 	uint16_t frag_offset;
 
-	/* Update the outer IPv4 header. */
+	/* Update the outer IPv4 or IPv6 header. */
 	len = pkt->pkt_len - pkt->outer_l2_len;
-	ipv4_hdr = (struct rte_ipv4_hdr *)(rte_pktmbuf_mtod(pkt, char *) +
-			pkt->outer_l2_len);
-	ipv4_hdr->total_length = rte_cpu_to_be_16(len);
+	if (RTE_ETH_IS_IPV6_HDR(pkt->packet_type)) {
+		ipv6_hdr = (struct rte_ipv6_hdr *)
+			(rte_pktmbuf_mtod(pkt, char *) + pkt->outer_l2_len);
+		ipv6_hdr->payload_len = rte_cpu_to_be_16(len -
+				sizeof(struct rte_ipv6_hdr));
+	} else {
+		ipv4_hdr = (struct rte_ipv4_hdr *)
+			(rte_pktmbuf_mtod(pkt, char *) + pkt->outer_l2_len);
+		ipv4_hdr->total_length = rte_cpu_to_be_16(len);
+	}
 
 	/* Update the outer UDP header. */
 	len -= pkt->outer_l3_len;
-	udp_hdr = (struct rte_udp_hdr *)((char *)ipv4_hdr + pkt->outer_l3_len);
+	udp_hdr = (struct rte_udp_hdr *)(rte_pktmbuf_mtod(pkt, char *) +
+			pkt->outer_l2_len + pkt->outer_l3_len);
 	udp_hdr->dgram_len = rte_cpu_to_be_16(len);
 
 	/* Update the inner IPv4 header. */
@@ -288,20 +304,21 @@ gro_vxlan_udp4_reassemble(struct rte_mbuf *pkt,
 {
 	struct rte_ether_hdr *outer_eth_hdr, *eth_hdr;
 	struct rte_ipv4_hdr *outer_ipv4_hdr, *ipv4_hdr;
+	struct rte_ipv6_hdr *outer_ipv6_hdr;
 	struct rte_udp_hdr *udp_hdr;
 	struct rte_vxlan_hdr *vxlan_hdr;
 	uint16_t frag_offset;
-	uint8_t is_last_frag;
+	uint8_t outer_ipv6, is_last_frag;
 	int16_t ip_dl;
 	uint16_t ip_id;
 
 	struct vxlan_udp4_flow_key key;
 	uint32_t cur_idx, prev_idx, item_idx;
-	uint32_t i, max_flow_num, remaining_flow_num;
+	uint32_t i, sig, pos;
 	int cmp;
 	uint16_t hdr_len;
-	uint8_t find;
 
+	outer_ipv6 = RTE_ETH_IS_IPV6_HDR(pkt->packet_type) ? 1 : 0;
 	outer_eth_hdr = rte_pktmbuf_mtod(pkt, struct rte_ether_hdr *);
 	outer_ipv4_hdr = (struct rte_ipv4_hdr *)((char *)outer_eth_hdr +
 			pkt->outer_l2_len);
@@ -347,38 +364,44 @@ gro_vxlan_udp4_reassemble(struct rte_mbuf *pkt,
 	key.vxlan_hdr.vx_vni = vxlan_hdr->vx_vni;
 	rte_ether_addr_copy(&(outer_eth_hdr->src_addr), &(key.outer_eth_saddr));
 	rte_ether_addr_copy(&(outer_eth_hdr->dst_addr), &(key.outer_eth_daddr));
-	key.outer_ip_src_addr = outer_ipv4_hdr->src_addr;
-	key.outer_ip_dst_addr = outer_ipv4_hdr->dst_addr;
+	if (outer_ipv6) {
+		outer_ipv6_hdr = (struct rte_ipv6_hdr *)outer_ipv4_hdr;
+		memcpy(key.outer_ip_src_addr, outer_ipv6_hdr->src_addr,
+				sizeof(key.outer_ip_src_addr));
+		memcpy(key.outer_ip_dst_addr, outer_ipv6_hdr->dst_addr,
+				sizeof(key.outer_ip_dst_addr));
+	} else {
+		memset(key.outer_ip_src_addr, 0, sizeof(key.outer_ip_src_addr));
+		memset(key.outer_ip_dst_addr, 0, sizeof(key.outer_ip_dst_addr));
+		memcpy(key.outer_ip_src_addr, &outer_ipv4_hdr->src_addr,
+				sizeof(outer_ipv4_hdr->src_addr));
+		memcpy(key.outer_ip_dst_addr, &outer_ipv4_hdr->dst_addr,
+				sizeof(outer_ipv4_hdr->dst_addr));
+	}
 	/* Note: It is unnecessary to save outer_src_port here because it can
 	 * be different for VxLAN UDP fragments from the same flow.
 	 */
 	key.outer_dst_port = udp_hdr->dst_port;
 
 	/* Search for a matched flow. */
-	max_flow_num = tbl->max_flow_num;
-	remaining_flow_num = tbl->flow_num;
-	find = 0;
-	for (i = 0; i < max_flow_num && remaining_flow_num; i++) {
-		if (tbl->flows[i].start_index != INVALID_ARRAY_INDEX) {
-			if (is_same_vxlan_udp4_flow(tbl->flows[i].key, key)) {
-				find = 1;
-				break;
-			}
-			remaining_flow_num--;
-		}
-	}
+	sig = vxlan_udp4_flow_hash(&key);
+	pos = sig & tbl->hash.mask;
+	while ((i = gro_flow_hash_next(&tbl->hash, sig, &pos)) !=
+			INVALID_ARRAY_INDEX)
+		if (is_same_vxlan_udp4_flow(tbl->flows[i].key, key))
+			break;
 
 	/*
 	 * Can't find a matched flow. Insert a new flow and store the
 	 * packet into the flow.
 	 */
-	if (find == 0) {
+	if (i == INVALID_ARRAY_INDEX) {
 		item_idx = insert_new_item(tbl, pkt, start_time,
 				INVALID_ARRAY_INDEX, frag_offset,
 				is_last_frag);
 		if (unlikely(item_idx == INVALID_ARRAY_INDEX))
 			return -1;
-		if (insert_new_flow(tbl, &key, item_idx) ==
+		if (insert_new_flow(tbl, &key, sig, item_idx) ==
 				INVALID_ARRAY_INDEX) {
 			/*
 			 * Fail to insert a new flow, so
@@ -513,8 +536,12 @@ gro_vxlan_udp4_tbl_timeout_flush(struct gro_vxlan_udp4_tbl *tbl,
 				 */
 				j = delete_item(tbl, j, INVALID_ARRAY_INDEX);
 				tbl->flows[i].start_index = j;
-				if (j == INVALID_ARRAY_INDEX)
+				if (j == INVALID_ARRAY_INDEX) {
 					tbl->flow_num--;
+					gro_flow_hash_del(&tbl->hash,
+						vxlan_udp4_flow_hash(&tbl->flows[i].key),
+						i);
+				}
 
 				if (unlikely(k == nb_out))
 					return k;
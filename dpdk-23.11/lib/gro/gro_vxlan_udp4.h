@@ -17,8 +17,9 @@ struct vxlan_udp4_flow_key {
 	struct rte_ether_addr outer_eth_saddr;
 	struct rte_ether_addr outer_eth_daddr;
 
-	uint32_t outer_ip_src_addr;
-	uint32_t outer_ip_dst_addr;
+	/* Outer IPv6 addresses, or zero padded outer IPv4 addresses */
+	uint8_t outer_ip_src_addr[16];
+	uint8_t outer_ip_dst_addr[16];
 
 	/* Note: It is unnecessary to save outer_src_port here because it can
 	 * be different for VxLAN UDP fragments from the same flow.
@@ -36,7 +37,7 @@ struct gro_vxlan_udp4_flow {
 };
 
 struct gro_vxlan_udp4_item {
-	struct gro_udp4_item inner_item;
+	struct gro_udp_item inner_item;
 	/* Note: VXLAN UDP/IPv4 GRO needn't check outer_ip_id because
 	 * the difference between outer_ip_ids of two received packets
 	 * isn't always +/-1 in case of OVS DPDK. So no outer_ip_id
@@ -45,7 +46,7 @@ struct gro_vxlan_udp4_item {
 };
 
 /*
- * VxLAN (with an outer IPv4 header and an inner UDP/IPv4 packet)
+ * VxLAN (with an outer IPv4 or IPv6 header and an inner UDP/IPv4 packet)
  * reassembly table structure
  */
 struct gro_vxlan_udp4_tbl {
@@ -53,6 +54,8 @@ struct gro_vxlan_udp4_tbl {
 	struct gro_vxlan_udp4_item *items;
 	/* flow array */
 	struct gro_vxlan_udp4_flow *flows;
+	/* flow index */
+	struct gro_flow_hash hash;
 	/* current item number */
 	uint32_t item_num;
 	/* current flow number */
@@ -65,7 +68,7 @@ struct gro_vxlan_udp4_tbl {
 
 /**
  * This function creates a VxLAN reassembly table for VxLAN packets
- * which have an outer IPv4 header and an inner UDP/IPv4 packet.
+ * which have an outer IPv4 or IPv6 header and an inner UDP/IPv4 packet.
  *
  * @param socket_id
  *  Socket index for allocating the table
@@ -91,9 +94,9 @@ void *gro_vxlan_udp4_tbl_create(uint16_t socket_id,
 void gro_vxlan_udp4_tbl_destroy(void *tbl);
 
 /**
- * This function merges a VxLAN packet which has an outer IPv4 header and
- * an inner UDP/IPv4 packet. It does not process the packet which does not
- * have payload.
+ * This function merges a VxLAN packet which has an outer IPv4 or IPv6
+ * header and an inner UDP/IPv4 packet. It does not process the packet
+ * which does not have payload.
  *
  * This function does not check if the packet has correct checksums and
  * does not re-calculate checksums for the merged packet. It returns the
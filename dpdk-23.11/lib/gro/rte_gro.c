@@ -10,27 +10,36 @@
 #include "gro_tcp4.h"
 #include "gro_tcp6.h"
 #include "gro_udp4.h"
+#include "gro_udp6.h"
 #include "gro_vxlan_tcp4.h"
 #include "gro_vxlan_udp4.h"
 
+/* Hash table size of the flow index of the lightweight mode tables */
+#define GRO_FLOW_HASH_BURST_SIZE (2 * RTE_GRO_MAX_BURST_ITEM_NUM)
+
 typedef void *(*gro_tbl_create_fn)(uint16_t socket_id,
 		uint16_t max_flow_num,
 		uint16_t max_item_per_flow);
 typedef void (*gro_tbl_destroy_fn)(void *tbl);
 typedef uint32_t (*gro_tbl_pkt_count_fn)(void *tbl);
 
+/* VxLAN over IPv6 tables are the same as VxLAN over IPv4 ones */
 static gro_tbl_create_fn tbl_create_fn[RTE_GRO_TYPE_MAX_NUM] = {
 		gro_tcp4_tbl_create, gro_vxlan_tcp4_tbl_create,
-		gro_udp4_tbl_create, gro_vxlan_udp4_tbl_create, gro_tcp6_tbl_create, NULL};
+		gro_udp4_tbl_create, gro_vxlan_udp4_tbl_create, gro_tcp6_tbl_create,
+		gro_udp6_tbl_create, gro_vxlan_tcp4_tbl_create,
+		gro_vxlan_udp4_tbl_create, NULL};
 static gro_tbl_destroy_fn tbl_destroy_fn[RTE_GRO_TYPE_MAX_NUM] = {
 			gro_tcp4_tbl_destroy, gro_vxlan_tcp4_tbl_destroy,
 			gro_udp4_tbl_destroy, gro_vxlan_udp4_tbl_destroy,
-			gro_tcp6_tbl_destroy,
+			gro_tcp6_tbl_destroy, gro_udp6_tbl_destroy,
+			gro_vxlan_tcp4_tbl_destroy, gro_vxlan_udp4_tbl_destroy,
 			NULL};
 static gro_tbl_pkt_count_fn tbl_pkt_count_fn[RTE_GRO_TYPE_MAX_NUM] = {
 			gro_tcp4_tbl_pkt_count, gro_vxlan_tcp4_tbl_pkt_count,
 			gro_udp4_tbl_pkt_count, gro_vxlan_udp4_tbl_pkt_count,
-			gro_tcp6_tbl_pkt_count,
+			gro_tcp6_tbl_pkt_count, gro_udp6_tbl_pkt_count,
+			gro_vxlan_tcp4_tbl_pkt_count, gro_vxlan_udp4_tbl_pkt_count,
 			NULL};
 
 #define IS_IPV4_TCP_PKT(ptype) (RTE_ETH_IS_IPV4_HDR(ptype) && \
@@ -48,6 +57,10 @@ static gro_tbl_pkt_count_fn tbl_pkt_count_fn[RTE_GRO_TYPE_MAX_NUM] = {
 		((ptype & RTE_PTYPE_L4_UDP) == RTE_PTYPE_L4_UDP) && \
 		(RTE_ETH_IS_TUNNEL_PKT(ptype) == 0))
 
+#define IS_IPV6_UDP_PKT(ptype) (RTE_ETH_IS_IPV6_HDR(ptype) && \
+		((ptype & RTE_PTYPE_L4_UDP) == RTE_PTYPE_L4_UDP) && \
+		(RTE_ETH_IS_TUNNEL_PKT(ptype) == 0))
+
 #define IS_IPV4_VXLAN_TCP4_PKT(ptype) (RTE_ETH_IS_IPV4_HDR(ptype) && \
 		((ptype & RTE_PTYPE_L4_UDP) == RTE_PTYPE_L4_UDP) && \
 		((ptype & RTE_PTYPE_L4_FRAG) != RTE_PTYPE_L4_FRAG) && \
@@ -75,6 +88,33 @@ static gro_tbl_pkt_count_fn tbl_pkt_count_fn[RTE_GRO_TYPE_MAX_NUM] = {
 		 ((ptype & RTE_PTYPE_INNER_L3_MASK) == \
 		  RTE_PTYPE_INNER_L3_IPV4_EXT_UNKNOWN)))
 
+#define IS_IPV6_VXLAN_TCP4_PKT(ptype) (RTE_ETH_IS_IPV6_HDR(ptype) && \
+		((ptype & RTE_PTYPE_L4_UDP) == RTE_PTYPE_L4_UDP) && \
+		((ptype & RTE_PTYPE_L4_FRAG) != RTE_PTYPE_L4_FRAG) && \
+		((ptype & RTE_PTYPE_TUNNEL_VXLAN) == \
+		 RTE_PTYPE_TUNNEL_VXLAN) && \
+		((ptype & RTE_PTYPE_INNER_L4_TCP) == \
+		 RTE_PTYPE_INNER_L4_TCP) && \
+		(((ptype & RTE_PTYPE_INNER_L3_MASK) == \
+		  RTE_PTYPE_INNER_L3_IPV4) || \
+		 ((ptype & RTE_PTYPE_INNER_L3_MASK) == \
+		  RTE_PTYPE_INNER_L3_IPV4_EXT) || \
+		 ((ptype & RTE_PTYPE_INNER_L3_MASK) == \
+		  RTE_PTYPE_INNER_L3_IPV4_EXT_UNKNOWN)))
+
+#define IS_IPV6_VXLAN_UDP4_PKT(ptype) (RTE_ETH_IS_IPV6_HDR(ptype) && \
+		((ptype & RTE_PTYPE_L4_UDP) == RTE_PTYPE_L4_UDP) && \
+		((ptype & RTE_PTYPE_TUNNEL_VXLAN) == \
+		 RTE_PTYPE_TUNNEL_VXLAN) && \
+		((ptype & RTE_PTYPE_INNER_L4_UDP) == \
+		 RTE_PTYPE_INNER_L4_UDP) && \
+		(((ptype & RTE_PTYPE_INNER_L3_MASK) == \
+		  RTE_PTYPE_INNER_L3_IPV4) || \
+		 ((ptype & RTE_PTYPE_INNER_L3_MASK) == \
+		  RTE_PTYPE_INNER_L3_IPV4_EXT) || \
+		 ((ptype & RTE_PTYPE_INNER_L3_MASK) == \
+		  RTE_PTYPE_INNER_L3_IPV4_EXT_UNKNOWN)))
+
 /*
  * GRO context structure. It keeps the table structures, which are
  * used to merge packets, for different GRO types. Before using
@@ -156,40 +196,76 @@ rte_gro_reassemble_burst(struct rte_mbuf **pkts,
 	/* allocate a reassembly table for TCP/IPv4 GRO */
 	struct gro_tcp4_tbl tcp_tbl;
 	struct gro_tcp4_flow tcp_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_flow_hash_entry tcp_hash[GRO_FLOW_HASH_BURST_SIZE];
+	uint32_t tcp_free_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
 	struct gro_tcp_item tcp_items[RTE_GRO_MAX_BURST_ITEM_NUM] = {{0} };
 
 	struct gro_tcp6_tbl tcp6_tbl;
 	struct gro_tcp6_flow tcp6_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_flow_hash_entry tcp6_hash[GRO_FLOW_HASH_BURST_SIZE];
+	uint32_t tcp6_free_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
 	struct gro_tcp_item tcp6_items[RTE_GRO_MAX_BURST_ITEM_NUM] = {{0} };
 
 	/* allocate a reassembly table for UDP/IPv4 GRO */
 	struct gro_udp4_tbl udp_tbl;
 	struct gro_udp4_flow udp_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
-	struct gro_udp4_item udp_items[RTE_GRO_MAX_BURST_ITEM_NUM] = {{0} };
+	struct gro_flow_hash_entry udp_hash[GRO_FLOW_HASH_BURST_SIZE];
+	uint32_t udp_free_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_udp_item udp_items[RTE_GRO_MAX_BURST_ITEM_NUM] = {{0} };
+
+	/* allocate a reassembly table for UDP/IPv6 GRO */
+	struct gro_udp6_tbl udp6_tbl;
+	struct gro_udp6_flow udp6_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_flow_hash_entry udp6_hash[GRO_FLOW_HASH_BURST_SIZE];
+	uint32_t udp6_free_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_udp_item udp6_items[RTE_GRO_MAX_BURST_ITEM_NUM] = {{0} };
 
 	/* Allocate a reassembly table for VXLAN TCP GRO */
 	struct gro_vxlan_tcp4_tbl vxlan_tcp_tbl;
 	struct gro_vxlan_tcp4_flow vxlan_tcp_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_flow_hash_entry vxlan_tcp_hash[GRO_FLOW_HASH_BURST_SIZE];
+	uint32_t vxlan_tcp_free_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
 	struct gro_vxlan_tcp4_item vxlan_tcp_items[RTE_GRO_MAX_BURST_ITEM_NUM]
 			= {{{0}, 0, 0} };
 
 	/* Allocate a reassembly table for VXLAN UDP GRO */
 	struct gro_vxlan_udp4_tbl vxlan_udp_tbl;
 	struct gro_vxlan_udp4_flow vxlan_udp_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_flow_hash_entry vxlan_udp_hash[GRO_FLOW_HASH_BURST_SIZE];
+	uint32_t vxlan_udp_free_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
 	struct gro_vxlan_udp4_item vxlan_udp_items[RTE_GRO_MAX_BURST_ITEM_NUM]
 			= {{{0}} };
 
+	/* Allocate a reassembly table for VXLAN over IPv6 TCP GRO */
+	struct gro_vxlan_tcp4_tbl vxlan6_tcp_tbl;
+	struct gro_vxlan_tcp4_flow vxlan6_tcp_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_flow_hash_entry vxlan6_tcp_hash[GRO_FLOW_HASH_BURST_SIZE];
+	uint32_t vxlan6_tcp_free_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_vxlan_tcp4_item vxlan6_tcp_items[RTE_GRO_MAX_BURST_ITEM_NUM]
+			= {{{0}, 0, 0} };
+
+	/* Allocate a reassembly table for VXLAN over IPv6 UDP GRO */
+	struct gro_vxlan_udp4_tbl vxlan6_udp_tbl;
+	struct gro_vxlan_udp4_flow vxlan6_udp_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_flow_hash_entry vxlan6_udp_hash[GRO_FLOW_HASH_BURST_SIZE];
+	uint32_t vxlan6_udp_free_flows[RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_vxlan_udp4_item vxlan6_udp_items[RTE_GRO_MAX_BURST_ITEM_NUM]
+			= {{{0}} };
+
 	struct rte_mbuf *unprocess_pkts[nb_pkts];
 	uint32_t item_num;
 	int32_t ret;
 	uint16_t i, unprocess_num = 0, nb_after_gro = nb_pkts;
 	uint8_t do_tcp4_gro = 0, do_vxlan_tcp_gro = 0, do_udp4_gro = 0,
-		do_vxlan_udp_gro = 0, do_tcp6_gro = 0;
+		do_vxlan_udp_gro = 0, do_tcp6_gro = 0, do_udp6_gro = 0,
+		do_vxlan6_tcp_gro = 0, do_vxlan6_udp_gro = 0;
 
 	if (unlikely((param->gro_types & (RTE_GRO_IPV4_VXLAN_TCP_IPV4 |
 					RTE_GRO_TCP_IPV4 | RTE_GRO_TCP_IPV6 |
 					RTE_GRO_IPV4_VXLAN_UDP_IPV4 |
-					RTE_GRO_UDP_IPV4)) == 0))
+					RTE_GRO_UDP_IPV4 | RTE_GRO_UDP_IPV6 |
+					RTE_GRO_IPV6_VXLAN_TCP_IPV4 |
+					RTE_GRO_IPV6_VXLAN_UDP_IPV4)) == 0))
 		return nb_pkts;
 
 	/* Get the maximum number of packets */
@@ -207,6 +283,8 @@ rte_gro_reassemble_burst(struct rte_mbuf **pkts,
 		vxlan_tcp_tbl.item_num = 0;
 		vxlan_tcp_tbl.max_flow_num = item_num;
 		vxlan_tcp_tbl.max_item_num = item_num;
+		gro_flow_hash_init(&vxlan_tcp_tbl.hash, vxlan_tcp_hash,
+				vxlan_tcp_free_flows, item_num);
 		do_vxlan_tcp_gro = 1;
 	}
 
@@ -220,6 +298,8 @@ rte_gro_reassemble_burst(struct rte_mbuf **pkts,
 		vxlan_udp_tbl.item_num = 0;
 		vxlan_udp_tbl.max_flow_num = item_num;
 		vxlan_udp_tbl.max_item_num = item_num;
+		gro_flow_hash_init(&vxlan_udp_tbl.hash, vxlan_udp_hash,
+				vxlan_udp_free_flows, item_num);
 		do_vxlan_udp_gro = 1;
 	}
 
@@ -233,6 +313,8 @@ rte_gro_reassemble_burst(struct rte_mbuf **pkts,
 		tcp_tbl.item_num = 0;
 		tcp_tbl.max_flow_num = item_num;
 		tcp_tbl.max_item_num = item_num;
+		gro_flow_hash_init(&tcp_tbl.hash, tcp_hash,
+				tcp_free_flows, item_num);
 		do_tcp4_gro = 1;
 	}
 
@@ -246,6 +328,8 @@ rte_gro_reassemble_burst(struct rte_mbuf **pkts,
 		udp_tbl.item_num = 0;
 		udp_tbl.max_flow_num = item_num;
 		udp_tbl.max_item_num = item_num;
+		gro_flow_hash_init(&udp_tbl.hash, udp_hash,
+				udp_free_flows, item_num);
 		do_udp4_gro = 1;
 	}
 
@@ -259,9 +343,56 @@ rte_gro_reassemble_burst(struct rte_mbuf **pkts,
 		tcp6_tbl.item_num = 0;
 		tcp6_tbl.max_flow_num = item_num;
 		tcp6_tbl.max_item_num = item_num;
+		gro_flow_hash_init(&tcp6_tbl.hash, tcp6_hash,
+				tcp6_free_flows, item_num);
 		do_tcp6_gro = 1;
 	}
 
+	if (param->gro_types & RTE_GRO_UDP_IPV6) {
+		for (i = 0; i < item_num; i++)
+			udp6_flows[i].start_index = INVALID_ARRAY_INDEX;
+
+		udp6_tbl.flows = udp6_flows;
+		udp6_tbl.items = udp6_items;
+		udp6_tbl.flow_num = 0;
+		udp6_tbl.item_num = 0;
+		udp6_tbl.max_flow_num = item_num;
+		udp6_tbl.max_item_num = item_num;
+		gro_flow_hash_init(&udp6_tbl.hash, udp6_hash,
+				udp6_free_flows, item_num);
+		do_udp6_gro = 1;
+	}
+
+	if (param->gro_types & RTE_GRO_IPV6_VXLAN_TCP_IPV4) {
+		for (i = 0; i < item_num; i++)
+			vxlan6_tcp_flows[i].start_index = INVALID_ARRAY_INDEX;
+
+		vxlan6_tcp_tbl.flows = vxlan6_tcp_flows;
+		vxlan6_tcp_tbl.items = vxlan6_tcp_items;
+		vxlan6_tcp_tbl.flow_num = 0;
+		vxlan6_tcp_tbl.item_num = 0;
+		vxlan6_tcp_tbl.max_flow_num = item_num;
+		vxlan6_tcp_tbl.max_item_num = item_num;
+		gro_flow_hash_init(&vxlan6_tcp_tbl.hash, vxlan6_tcp_hash,
+				vxlan6_tcp_free_flows, item_num);
+		do_vxlan6_tcp_gro = 1;
+	}
+
+	if (param->gro_types & RTE_GRO_IPV6_VXLAN_UDP_IPV4) {
+		for (i = 0; i < item_num; i++)
+			vxlan6_udp_flows[i].start_index = INVALID_ARRAY_INDEX;
+
+		vxlan6_udp_tbl.flows = vxlan6_udp_flows;
+		vxlan6_udp_tbl.items = vxlan6_udp_items;
+		vxlan6_udp_tbl.flow_num = 0;
+		vxlan6_udp_tbl.item_num = 0;
+		vxlan6_udp_tbl.max_flow_num = item_num;
+		vxlan6_udp_tbl.max_item_num = item_num;
+		gro_flow_hash_init(&vxlan6_udp_tbl.hash, vxlan6_udp_hash,
+				vxlan6_udp_free_flows, item_num);
+		do_vxlan6_udp_gro = 1;
+	}
+
 	for (i = 0; i < nb_pkts; i++) {
 		/*
 		 * The timestamp is ignored, since all packets
@@ -309,6 +440,32 @@ rte_gro_reassemble_burst(struct rte_mbuf **pkts,
 				nb_after_gro--;
 			else if (ret < 0)
 				unprocess_pkts[unprocess_num++] = pkts[i];
+		} else if (IS_IPV6_UDP_PKT(pkts[i]->packet_type) &&
+				do_udp6_gro) {
+			ret = gro_udp6_reassemble(pkts[i], &udp6_tbl, 0);
+			if (ret > 0)
+				/* merge successfully */
+				nb_after_gro--;
+			else if (ret < 0)
+				unprocess_pkts[unprocess_num++] = pkts[i];
+		} else if (IS_IPV6_VXLAN_TCP4_PKT(pkts[i]->packet_type) &&
+				do_vxlan6_tcp_gro) {
+			ret = gro_vxlan_tcp4_reassemble(pkts[i],
+							&vxlan6_tcp_tbl, 0);
+			if (ret > 0)
+				/* Merge successfully */
+				nb_after_gro--;
+			else if (ret < 0)
+				unprocess_pkts[unprocess_num++] = pkts[i];
+		} else if (IS_IPV6_VXLAN_UDP4_PKT(pkts[i]->packet_type) &&
+				do_vxlan6_udp_gro) {
+			ret = gro_vxlan_udp4_reassemble(pkts[i],
+							&vxlan6_udp_tbl, 0);
+			if (ret > 0)
+				/* Merge successfully */
+				nb_after_gro--;
+			else if (ret < 0)
+				unprocess_pkts[unprocess_num++] = pkts[i];
 		} else
 			unprocess_pkts[unprocess_num++] = pkts[i];
 	}
@@ -350,6 +507,21 @@ rte_gro_reassemble_burst(struct rte_mbuf **pkts,
 			i += gro_tcp6_tbl_timeout_flush(&tcp6_tbl, 0,
 					&pkts[i], nb_pkts - i);
 		}
+
+		if (do_udp6_gro) {
+			i += gro_udp6_tbl_timeout_flush(&udp6_tbl, 0,
+					&pkts[i], nb_pkts - i);
+		}
+
+		if (do_vxlan6_tcp_gro) {
+			i += gro_vxlan_tcp4_tbl_timeout_flush(&vxlan6_tcp_tbl,
+					0, &pkts[i], nb_pkts - i);
+		}
+
+		if (do_vxlan6_udp_gro) {
+			i += gro_vxlan_udp4_tbl_timeout_flush(&vxlan6_udp_tbl,
+					0, &pkts[i], nb_pkts - i);
+		}
 	}
 
 	return nb_after_gro;
@@ -363,14 +535,18 @@ rte_gro_reassemble(struct rte_mbuf **pkts,
 	struct rte_mbuf *unprocess_pkts[nb_pkts];
 	struct gro_ctx *gro_ctx = ctx;
 	void *tcp_tbl, *udp_tbl, *vxlan_tcp_tbl, *vxlan_udp_tbl, *tcp6_tbl;
+	void *udp6_tbl, *vxlan6_tcp_tbl, *vxlan6_udp_tbl;
 	uint64_t current_time;
 	uint16_t i, unprocess_num = 0;
 	uint8_t do_tcp4_gro, do_vxlan_tcp_gro, do_udp4_gro, do_vxlan_udp_gro, do_tcp6_gro;
+	uint8_t do_udp6_gro, do_vxlan6_tcp_gro, do_vxlan6_udp_gro;
 
 	if (unlikely((gro_ctx->gro_types & (RTE_GRO_IPV4_VXLAN_TCP_IPV4 |
 					RTE_GRO_TCP_IPV4 | RTE_GRO_TCP_IPV6 |
 					RTE_GRO_IPV4_VXLAN_UDP_IPV4 |
-					RTE_GRO_UDP_IPV4)) == 0))
+					RTE_GRO_UDP_IPV4 | RTE_GRO_UDP_IPV6 |
+					RTE_GRO_IPV6_VXLAN_TCP_IPV4 |
+					RTE_GRO_IPV6_VXLAN_UDP_IPV4)) == 0))
 		return nb_pkts;
 
 	tcp_tbl = gro_ctx->tbls[RTE_GRO_TCP_IPV4_INDEX];
@@ -378,6 +554,9 @@ rte_gro_reassemble(struct rte_mbuf **pkts,
 	udp_tbl = gro_ctx->tbls[RTE_GRO_UDP_IPV4_INDEX];
 	vxlan_udp_tbl = gro_ctx->tbls[RTE_GRO_IPV4_VXLAN_UDP_IPV4_INDEX];
 	tcp6_tbl = gro_ctx->tbls[RTE_GRO_TCP_IPV6_INDEX];
+	udp6_tbl = gro_ctx->tbls[RTE_GRO_UDP_IPV6_INDEX];
+	vxlan6_tcp_tbl = gro_ctx->tbls[RTE_GRO_IPV6_VXLAN_TCP_IPV4_INDEX];
+	vxlan6_udp_tbl = gro_ctx->tbls[RTE_GRO_IPV6_VXLAN_UDP_IPV4_INDEX];
 
 	do_tcp4_gro = (gro_ctx->gro_types & RTE_GRO_TCP_IPV4) ==
 		RTE_GRO_TCP_IPV4;
@@ -388,6 +567,11 @@ rte_gro_reassemble(struct rte_mbuf **pkts,
 	do_vxlan_udp_gro = (gro_ctx->gro_types & RTE_GRO_IPV4_VXLAN_UDP_IPV4) ==
 		RTE_GRO_IPV4_VXLAN_UDP_IPV4;
 	do_tcp6_gro = (gro_ctx->gro_types & RTE_GRO_TCP_IPV6) == RTE_GRO_TCP_IPV6;
+	do_udp6_gro = (gro_ctx->gro_types & RTE_GRO_UDP_IPV6) == RTE_GRO_UDP_IPV6;
+	do_vxlan6_tcp_gro = (gro_ctx->gro_types & RTE_GRO_IPV6_VXLAN_TCP_IPV4) ==
+		RTE_GRO_IPV6_VXLAN_TCP_IPV4;
+	do_vxlan6_udp_gro = (gro_ctx->gro_types & RTE_GRO_IPV6_VXLAN_UDP_IPV4) ==
+		RTE_GRO_IPV6_VXLAN_UDP_IPV4;
 
 	current_time = rte_rdtsc();
 
@@ -417,6 +601,21 @@ rte_gro_reassemble(struct rte_mbuf **pkts,
 			if (gro_tcp6_reassemble(pkts[i], tcp6_tbl,
 						current_time) < 0)
 				unprocess_pkts[unprocess_num++] = pkts[i];
+		} else if (IS_IPV6_UDP_PKT(pkts[i]->packet_type) &&
+				do_udp6_gro) {
+			if (gro_udp6_reassemble(pkts[i], udp6_tbl,
+						current_time) < 0)
+				unprocess_pkts[unprocess_num++] = pkts[i];
+		} else if (IS_IPV6_VXLAN_TCP4_PKT(pkts[i]->packet_type) &&
+				do_vxlan6_tcp_gro) {
+			if (gro_vxlan_tcp4_reassemble(pkts[i], vxlan6_tcp_tbl,
+						current_time) < 0)
+				unprocess_pkts[unprocess_num++] = pkts[i];
+		} else if (IS_IPV6_VXLAN_UDP4_PKT(pkts[i]->packet_type) &&
+				do_vxlan6_udp_gro) {
+			if (gro_vxlan_udp4_reassemble(pkts[i], vxlan6_udp_tbl,
+						current_time) < 0)
+				unprocess_pkts[unprocess_num++] = pkts[i];
 		} else
 			unprocess_pkts[unprocess_num++] = pkts[i];
 	}
@@ -480,7 +679,28 @@ rte_gro_timeout_flush(void *ctx,
 				gro_ctx->tbls[RTE_GRO_TCP_IPV6_INDEX],
 				flush_timestamp,
 				&out[num], left_nb_out);
+		left_nb_out = max_nb_out - num;
+	}
+
+	if ((gro_types & RTE_GRO_UDP_IPV6) && left_nb_out > 0) {
+		num += gro_udp6_tbl_timeout_flush(
+				gro_ctx->tbls[RTE_GRO_UDP_IPV6_INDEX],
+				flush_timestamp,
+				&out[num], left_nb_out);
+		left_nb_out = max_nb_out - num;
+	}
 
+	if ((gro_types & RTE_GRO_IPV6_VXLAN_TCP_IPV4) && left_nb_out > 0) {
+		num += gro_vxlan_tcp4_tbl_timeout_flush(gro_ctx->tbls[
+				RTE_GRO_IPV6_VXLAN_TCP_IPV4_INDEX],
+				flush_timestamp, &out[num], left_nb_out);
+		left_nb_out = max_nb_out - num;
+	}
+
+	if ((gro_types & RTE_GRO_IPV6_VXLAN_UDP_IPV4) && left_nb_out > 0) {
+		num += gro_vxlan_udp4_tbl_timeout_flush(gro_ctx->tbls[
+				RTE_GRO_IPV6_VXLAN_UDP_IPV4_INDEX],
+				flush_timestamp, &out[num], left_nb_out);
 	}
 
 	return num;
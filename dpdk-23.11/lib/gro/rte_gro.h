@@ -41,6 +41,15 @@ extern "C" {
 #define RTE_GRO_TCP_IPV6_INDEX 4
 #define RTE_GRO_TCP_IPV6 (1ULL << RTE_GRO_TCP_IPV6_INDEX)
 /**< TCP/IPv6 GRO flag. */
+#define RTE_GRO_UDP_IPV6_INDEX 5
+#define RTE_GRO_UDP_IPV6 (1ULL << RTE_GRO_UDP_IPV6_INDEX)
+/**< UDP/IPv6 GRO flag. */
+#define RTE_GRO_IPV6_VXLAN_TCP_IPV4_INDEX 6
+#define RTE_GRO_IPV6_VXLAN_TCP_IPV4 (1ULL << RTE_GRO_IPV6_VXLAN_TCP_IPV4_INDEX)
+/**< VxLAN over IPv6 TCP/IPv4 GRO flag. */
+#define RTE_GRO_IPV6_VXLAN_UDP_IPV4_INDEX 7
+#define RTE_GRO_IPV6_VXLAN_UDP_IPV4 (1ULL << RTE_GRO_IPV6_VXLAN_UDP_IPV4_INDEX)
+/**< VxLAN over IPv6 UDP/IPv4 GRO flag. */
 
 /**
  * Structure used to create GRO context objects or used to pass
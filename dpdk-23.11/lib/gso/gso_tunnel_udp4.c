@@ -2,6 +2,8 @@
  * Copyright(c) 2020 Inspur Corporation
  */
 
+#include <errno.h>
+
 #include "gso_common.h"
 #include "gso_tunnel_udp4.h"
 
@@ -13,18 +15,21 @@ update_tunnel_ipv4_udp_headers(struct rte_mbuf *pkt, struct rte_mbuf **segs,
 {
 	struct rte_ipv4_hdr *ipv4_hdr;
 	uint16_t outer_id, inner_id, tail_idx, i, length;
-	uint16_t outer_ipv4_offset, inner_ipv4_offset;
+	uint16_t outer_l3_offset, inner_ipv4_offset;
 	uint16_t outer_udp_offset;
 	uint16_t frag_offset = 0, is_mf;
 
-	outer_ipv4_offset = pkt->outer_l2_len;
-	outer_udp_offset = outer_ipv4_offset + pkt->outer_l3_len;
+	outer_l3_offset = pkt->outer_l2_len;
+	outer_udp_offset = outer_l3_offset + pkt->outer_l3_len;
 	inner_ipv4_offset = outer_udp_offset + pkt->l2_len;
 
-	/* Outer IPv4 header. */
-	ipv4_hdr = (struct rte_ipv4_hdr *)(rte_pktmbuf_mtod(pkt, char *) +
-			outer_ipv4_offset);
-	outer_id = rte_be_to_cpu_16(ipv4_hdr->packet_id);
+	/* Outer IPv4 header, there is no ID to update in outer IPv6. */
+	outer_id = 0;
+	if (!(pkt->ol_flags & RTE_MBUF_F_TX_OUTER_IPV6)) {
+		ipv4_hdr = (struct rte_ipv4_hdr *)
+			(rte_pktmbuf_mtod(pkt, char *) + outer_l3_offset);
+		outer_id = rte_be_to_cpu_16(ipv4_hdr->packet_id);
+	}
 
 	/* Inner IPv4 header. */
 	ipv4_hdr = (struct rte_ipv4_hdr *)(rte_pktmbuf_mtod(pkt, char *) +
@@ -34,7 +39,7 @@ update_tunnel_ipv4_udp_headers(struct rte_mbuf *pkt, struct rte_mbuf **segs,
 	tail_idx = nb_segs - 1;
 
 	for (i = 0; i < nb_segs; i++) {
-		update_ipv4_header(segs[i], outer_ipv4_offset, outer_id);
+		update_outer_ip_header(segs[i], outer_l3_offset, outer_id);
 		update_udp_header(segs[i], outer_udp_offset);
 		update_ipv4_header(segs[i], inner_ipv4_offset, inner_id);
 		/* For the case inner packet is UDP, we must keep UDP
@@ -82,6 +87,10 @@ gso_tunnel_udp4_segment(struct rte_mbuf *pkt,
 	if ((hdr_offset + pkt->l4_len) >= pkt->pkt_len)
 		return 0;
 
+	/* Outer IPv6 headers may not leave room for any payload */
+	if (unlikely(gso_size < hdr_offset + 8))
+		return -EINVAL;
+
 	/* pyld_unit_size must be a multiple of 8 because frag_off
 	 * uses 8 bytes as unit.
 	 */
@@ -0,0 +1,142 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <errno.h>
+
+#include <rte_stdatomic.h>
+
+#include "gso_common.h"
+#include "gso_udp6.h"
+
+/* Identification of the IPv6 fragments, shared by all lcores */
+static RTE_ATOMIC(uint32_t) ipv6_frag_id;
+
+/*
+ * Offset of the 'next header' field announcing the upper layer protocol,
+ * i.e. the last one in the IPv6 header chain. Return 0 if the chain
+ * holds an unknown extension header.
+ */
+static uint16_t
+ipv6_next_header_offset(struct rte_mbuf *pkt)
+{
+	const uint8_t *l3 = rte_pktmbuf_mtod_offset(pkt, uint8_t *,
+			pkt->l2_len);
+	uint16_t nh_offset = offsetof(struct rte_ipv6_hdr, proto);
+	uint16_t offset = sizeof(struct rte_ipv6_hdr);
+	int proto = l3[nh_offset];
+	size_t ext_len;
+
+	while (offset < pkt->l3_len) {
+		nh_offset = offset;
+		proto = rte_ipv6_get_next_ext(l3 + offset, proto, &ext_len);
+		if (proto < 0)
+			return 0;
+		offset += ext_len;
+	}
+
+	return pkt->l2_len + nh_offset;
+}
+
+static void
+update_ipv6_udp_headers(struct rte_mbuf *pkt, uint16_t nh_offset,
+		struct rte_mbuf **segs, uint16_t nb_segs)
+{
+	struct rte_ipv6_fragment_ext *frag_hdr;
+	uint16_t hdr_offset = pkt->l2_len + pkt->l3_len;
+	uint16_t frag_offset = 0, tail_idx = nb_segs - 1, i;
+	uint8_t proto;
+	rte_be32_t id;
+
+	proto = *rte_pktmbuf_mtod_offset(pkt, uint8_t *, nh_offset);
+	id = rte_cpu_to_be_32(rte_atomic_fetch_add_explicit(&ipv6_frag_id, 1,
+			rte_memory_order_relaxed));
+
+	/*
+	 * The header part of each output segment only holds a copy of
+	 * the l2 and l3 headers: append the fragment header to it, keep
+	 * the same id and update the fragment offset and payload length.
+	 */
+	for (i = 0; i < nb_segs; i++) {
+		segs[i]->data_len += RTE_IPV6_FRAG_HDR_SIZE;
+		segs[i]->pkt_len += RTE_IPV6_FRAG_HDR_SIZE;
+		segs[i]->l3_len += RTE_IPV6_FRAG_HDR_SIZE;
+
+		*rte_pktmbuf_mtod_offset(segs[i], uint8_t *, nh_offset) =
+			IPPROTO_FRAGMENT;
+		frag_hdr = rte_pktmbuf_mtod_offset(segs[i],
+			struct rte_ipv6_fragment_ext *, hdr_offset);
+		frag_hdr->next_header = proto;
+		frag_hdr->reserved = 0;
+		frag_hdr->frag_data = rte_cpu_to_be_16(
+			RTE_IPV6_SET_FRAG_DATA(frag_offset, i < tail_idx));
+		frag_hdr->id = id;
+		update_ipv6_header(segs[i], pkt->l2_len);
+
+		frag_offset += segs[i]->pkt_len - hdr_offset -
+			RTE_IPV6_FRAG_HDR_SIZE;
+	}
+}
+
+int
+gso_udp6_segment(struct rte_mbuf *pkt,
+		uint16_t gso_size,
+		struct rte_mempool *direct_pool,
+		struct rte_mempool *indirect_pool,
+		struct rte_mbuf **pkts_out,
+		uint16_t nb_pkts_out)
+{
+	struct rte_ipv6_hdr *ipv6_hdr;
+	uint16_t pyld_unit_size, hdr_offset, nh_offset;
+	int i, ret;
+
+	/* Don't process the fragmented packet */
+	ipv6_hdr = rte_pktmbuf_mtod_offset(pkt, struct rte_ipv6_hdr *,
+			pkt->l2_len);
+	if (unlikely(is_ipv6_fragmented(ipv6_hdr, pkt->l3_len)))
+		return 0;
+
+	/* Don't process the packet with unknown extension headers */
+	nh_offset = ipv6_next_header_offset(pkt);
+	if (unlikely(nh_offset == 0))
+		return 0;
+
+	/*
+	 * UDP fragmentation is the same as IP fragmentation.
+	 * Except the first one, other output packets just have l2
+	 * and l3 headers, followed by the fragment header.
+	 */
+	hdr_offset = pkt->l2_len + pkt->l3_len;
+
+	/* Don't process the packet without data. */
+	if (unlikely(hdr_offset + pkt->l4_len >= pkt->pkt_len))
+		return 0;
+
+	/* IPv6 headers may not leave room for any payload */
+	if (unlikely(gso_size < hdr_offset + RTE_IPV6_FRAG_HDR_SIZE +
+			RTE_IPV6_EHDR_FO_ALIGN))
+		return -EINVAL;
+
+	/* pyld_unit_size must be a multiple of 8 because the fragment
+	 * offset uses 8 bytes as unit.
+	 */
+	pyld_unit_size = (gso_size - hdr_offset - RTE_IPV6_FRAG_HDR_SIZE) &
+		~(RTE_IPV6_EHDR_FO_ALIGN - 1);
+
+	/* Segment the payload */
+	ret = gso_do_segment(pkt, hdr_offset, pyld_unit_size, direct_pool,
+			indirect_pool, pkts_out, nb_pkts_out);
+	if (ret <= 1)
+		return ret;
+
+	/* All header parts come from the same pool */
+	if (unlikely(rte_pktmbuf_tailroom(pkts_out[0]) <
+			RTE_IPV6_FRAG_HDR_SIZE)) {
+		for (i = 0; i < ret; i++)
+			rte_pktmbuf_free(pkts_out[i]);
+		return -EINVAL;
+	}
+
+	update_ipv6_udp_headers(pkt, nh_offset, pkts_out, ret);
+
+	return ret;
+}
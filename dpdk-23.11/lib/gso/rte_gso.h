@@ -61,7 +61,9 @@ struct rte_gso_ctx {
 	uint16_t gso_size;
 	/**< maximum size of an output GSO segment, including packet
 	 * header and payload, measured in bytes. Must exceed
-	 * RTE_GSO_SEG_SIZE_MIN.
+	 * RTE_GSO_SEG_SIZE_MIN. For packets with IPv6 headers, it must
+	 * also exceed the length of the headers, plus the fragment
+	 * extension header for UDP/IPv6, otherwise segmentation fails.
 	 */
 };
 
@@ -81,6 +83,9 @@ struct rte_gso_ctx {
  * a TCP/IPv4 packet. If rte_gso_segment() succeeds, the RTE_MBUF_F_TX_TCP_SEG
  * flag is removed for all GSO segments and the input packet.
  *
+ * As for IPv4, UDP/IPv6 packets are segmented as IP fragments: each
+ * GSO segment gets an IPv6 fragment extension header.
+ *
  * Each of the newly-created GSO segments is organized as a two-segment
  * MBUF, where the first segment is a standard MBUF, which stores a copy
  * of packet header, and the second is an indirect MBUF which points to
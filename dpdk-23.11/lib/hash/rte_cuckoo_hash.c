@@ -10,6 +10,7 @@
 #include <sys/queue.h>
 
 #include <rte_common.h>
+#include <rte_cycles.h>
 #include <rte_log.h>
 #include <rte_prefetch.h>
 #include <rte_branch_prediction.h>
@@ -32,7 +33,9 @@
 				   RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY | \
 				   RTE_HASH_EXTRA_FLAGS_EXT_TABLE |	\
 				   RTE_HASH_EXTRA_FLAGS_NO_FREE_ON_DEL | \
-				   RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF)
+				   RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF | \
+				   RTE_HASH_EXTRA_FLAGS_RESIZABLE | \
+				   RTE_HASH_EXTRA_FLAGS_AGING)
 
 #define FOR_EACH_BUCKET(CURRENT_BKT, START_BUCKET)                            \
 	for (CURRENT_BKT = START_BUCKET;                                      \
@@ -51,6 +54,26 @@ struct __rte_hash_rcu_dq_entry {
 	uint32_t ext_bkt_idx;
 };
 
+/* Resizable tables, see the end of this file */
+static struct rte_hash *resize_create(const struct rte_hash_parameters *params);
+static void resize_free(struct rte_hash *h);
+static void resize_reset(struct rte_hash *h);
+static int resize_rcu_qsbr_add(struct rte_hash *h,
+		struct rte_hash_rcu_config *cfg);
+static int32_t resize_add(const struct rte_hash *h, const void *key,
+		hash_sig_t sig, void *data);
+static int32_t resize_del(const struct rte_hash *h, const void *key,
+		hash_sig_t sig);
+static int32_t resize_lookup(const struct rte_hash *h, const void *key,
+		hash_sig_t sig, void **data);
+static void resize_lookup_bulk(const struct rte_hash *h, const void **keys,
+		hash_sig_t *prim_hash, int32_t num_keys, int32_t *positions,
+		uint64_t *hit_mask, void *data[]);
+static const struct rte_hash *resize_table_of(const struct rte_hash *h,
+		int32_t *position);
+static int32_t resize_iterate(const struct rte_hash *h, const void **key,
+		void **data, uint32_t *next);
+
 struct rte_hash *
 rte_hash_find_existing(const char *name)
 {
@@ -85,8 +108,20 @@ rte_hash_get_last_bkt(struct rte_hash_bucket *lst_bkt)
 
 void rte_hash_set_cmp_func(struct rte_hash *h, rte_hash_cmp_eq_t func)
 {
+	struct rte_hash *t;
+
 	h->cmp_jump_table_idx = KEY_CUSTOM;
 	h->rte_hash_custom_cmp_eq = func;
+
+	if (h->resize != NULL) {
+		t = rte_atomic_load_explicit(&h->resize->cur,
+				rte_memory_order_relaxed);
+		rte_hash_set_cmp_func(t, func);
+		t = rte_atomic_load_explicit(&h->resize->old,
+				rte_memory_order_relaxed);
+		if (t != NULL)
+			rte_hash_set_cmp_func(t, func);
+	}
 }
 
 static inline int
@@ -128,8 +163,51 @@ get_alt_bucket_index(const struct rte_hash *h,
 	return (cur_bkt_idx ^ sig) & h->bucket_bitmask;
 }
 
-struct rte_hash *
-rte_hash_create(const struct rte_hash_parameters *params)
+/*
+ * Stamp a used entry with the aging clock. The timestamp is only written
+ * when it moves forward, so that lookups of a hot key keep its cache line
+ * shared, and so that a lookup never takes back the more recent time of
+ * an add.
+ */
+static inline void
+hash_touch(const struct rte_hash *h, const struct rte_hash_key *k)
+{
+	RTE_ATOMIC(uint64_t) *tstamp;
+	uint64_t now;
+
+	if (likely(h->age_off == 0))
+		return;
+
+	tstamp = (RTE_ATOMIC(uint64_t) *)((uintptr_t)k + h->age_off);
+	now = rte_atomic_load_explicit(&h->age_clock,
+				       rte_memory_order_relaxed);
+	if (rte_atomic_load_explicit(tstamp, rte_memory_order_relaxed) < now)
+		rte_atomic_store_explicit(tstamp, now,
+					  rte_memory_order_relaxed);
+}
+
+/*
+ * Stamp an added entry with the current time: the aging clock may be
+ * as old as the last rte_hash_age() call, and the entry would expire
+ * too early.
+ */
+static inline void
+hash_stamp(const struct rte_hash *h, const struct rte_hash_key *k)
+{
+	if (likely(h->age_off == 0))
+		return;
+
+	rte_atomic_store_explicit(
+		(RTE_ATOMIC(uint64_t) *)((uintptr_t)k + h->age_off),
+		rte_get_timer_cycles(), rte_memory_order_relaxed);
+}
+
+/*
+ * Tables backing a resizable table are not listed: they are only
+ * reachable through the handle returned to the application.
+ */
+static struct rte_hash *
+hash_create(const struct rte_hash_parameters *params, bool listed)
 {
 	struct rte_hash *h = NULL;
 	struct rte_tailq_entry *te = NULL;
@@ -158,11 +236,6 @@ rte_hash_create(const struct rte_hash_parameters *params)
 
 	hash_list = RTE_TAILQ_CAST(rte_hash_tailq.head, rte_hash_list);
 
-	if (params == NULL) {
-		RTE_LOG(ERR, HASH, "rte_hash_create has no parameters\n");
-		return NULL;
-	}
-
 	/* Check for valid parameters */
 	if ((params->entries > RTE_HASH_ENTRIES_MAX) ||
 			(params->entries < RTE_HASH_BUCKET_ENTRIES) ||
@@ -273,10 +346,12 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		goto err_unlock;
 	}
 
-	te = rte_zmalloc("HASH_TAILQ_ENTRY", sizeof(*te), 0);
-	if (te == NULL) {
-		RTE_LOG(ERR, HASH, "tailq entry allocation failed\n");
-		goto err_unlock;
+	if (listed) {
+		te = rte_zmalloc("HASH_TAILQ_ENTRY", sizeof(*te), 0);
+		if (te == NULL) {
+			RTE_LOG(ERR, HASH, "tailq entry allocation failed\n");
+			goto err_unlock;
+		}
 	}
 
 	h = (struct rte_hash *)rte_zmalloc_socket(hash_name, sizeof(struct rte_hash),
@@ -325,8 +400,14 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		}
 	}
 
-	const uint32_t key_entry_size =
+	/* With aging, a timestamp follows the key in each entry */
+	const uint32_t age_off =
+		(params->extra_flag & RTE_HASH_EXTRA_FLAGS_AGING) ?
 		RTE_ALIGN(sizeof(struct rte_hash_key) + params->key_len,
+			  sizeof(uint64_t)) : 0;
+	const uint32_t key_entry_size =
+		RTE_ALIGN(age_off ? age_off + sizeof(uint64_t) :
+			  sizeof(struct rte_hash_key) + params->key_len,
 			  KEY_ALIGNMENT);
 	const uint64_t key_tbl_size = (uint64_t) key_entry_size * num_key_slots;
 
@@ -407,6 +488,8 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	h->entries = params->entries;
 	h->key_len = params->key_len;
 	h->key_entry_size = key_entry_size;
+	h->age_off = age_off;
+	h->age_clock = rte_get_timer_cycles();
 	h->hash_func_init_val = params->hash_func_init_val;
 
 	h->num_buckets = num_buckets;
@@ -458,8 +541,10 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	for (i = 1; i < num_key_slots; i++)
 		rte_ring_sp_enqueue_elem(r, &i, sizeof(uint32_t));
 
-	te->data = (void *) h;
-	TAILQ_INSERT_TAIL(hash_list, te, next);
+	if (listed) {
+		te->data = (void *) h;
+		TAILQ_INSERT_TAIL(hash_list, te, next);
+	}
 	rte_mcfg_tailq_write_unlock();
 
 	return h;
@@ -479,6 +564,42 @@ err:
 	return NULL;
 }
 
+struct rte_hash *
+rte_hash_create(const struct rte_hash_parameters *params)
+{
+	if (params == NULL) {
+		RTE_LOG(ERR, HASH, "rte_hash_create has no parameters\n");
+		return NULL;
+	}
+
+	if (params->extra_flag & RTE_HASH_EXTRA_FLAGS_RESIZABLE)
+		return resize_create(params);
+
+	return hash_create(params, true);
+}
+
+/* Free the memory of a table already removed from the list */
+static void
+hash_free_table(struct rte_hash *h)
+{
+	if (h->dq)
+		rte_rcu_qsbr_dq_delete(h->dq);
+
+	if (h->use_local_cache)
+		rte_free(h->local_free_slots);
+	if (h->writer_takes_lock)
+		rte_free(h->readwrite_lock);
+	rte_ring_free(h->free_slots);
+	rte_ring_free(h->free_ext_bkts);
+	rte_free(h->key_store);
+	rte_free(h->buckets);
+	rte_free(h->buckets_ext);
+	rte_free(h->tbl_chng_cnt);
+	rte_free(h->ext_bkt_to_free);
+	rte_free(h->hash_rcu_cfg);
+	rte_free(h);
+}
+
 void
 rte_hash_free(struct rte_hash *h)
 {
@@ -507,22 +628,10 @@ rte_hash_free(struct rte_hash *h)
 
 	rte_mcfg_tailq_write_unlock();
 
-	if (h->dq)
-		rte_rcu_qsbr_dq_delete(h->dq);
-
-	if (h->use_local_cache)
-		rte_free(h->local_free_slots);
-	if (h->writer_takes_lock)
-		rte_free(h->readwrite_lock);
-	rte_ring_free(h->free_slots);
-	rte_ring_free(h->free_ext_bkts);
-	rte_free(h->key_store);
-	rte_free(h->buckets);
-	rte_free(h->buckets_ext);
-	rte_free(h->tbl_chng_cnt);
-	rte_free(h->ext_bkt_to_free);
-	rte_free(h->hash_rcu_cfg);
-	rte_free(h);
+	if (h->resize != NULL)
+		resize_free(h);
+	else
+		hash_free_table(h);
 	rte_free(te);
 }
 
@@ -537,6 +646,15 @@ int32_t
 rte_hash_max_key_id(const struct rte_hash *h)
 {
 	RETURN_IF_TRUE((h == NULL), -EINVAL);
+	if (h->resize != NULL) {
+		const struct rte_hash *old = rte_atomic_load_explicit(
+				&h->resize->old, rte_memory_order_acquire);
+
+		/* Positions in old follow those of cur */
+		return rte_hash_max_key_id(rte_atomic_load_explicit(
+				&h->resize->cur, rte_memory_order_acquire)) +
+			(old != NULL ? rte_hash_max_key_id(old) : 0);
+	}
 	if (h->use_local_cache)
 		/*
 		 * Increase number of slots by total number of indices
@@ -557,6 +675,11 @@ rte_hash_count(const struct rte_hash *h)
 	if (h == NULL)
 		return -EINVAL;
 
+	if (h->resize != NULL)
+		return rte_hash_count(rte_atomic_load_explicit(&h->resize->cur,
+					rte_memory_order_acquire)) +
+			h->resize->old_keys;
+
 	if (h->use_local_cache) {
 		tot_ring_cnt = h->entries + (RTE_MAX_LCORE - 1) *
 					(LCORE_CACHE_SIZE - 1);
@@ -617,6 +740,23 @@ __hash_rw_reader_unlock(const struct rte_hash *h)
 		rte_rwlock_read_unlock(h->readwrite_lock);
 }
 
+/* Writer lock of the add path, unless held for a whole burst of adds */
+static inline void
+__hash_rw_add_lock(const struct rte_hash *h, bool locked)
+	__rte_no_thread_safety_analysis
+{
+	if (!locked)
+		__hash_rw_writer_lock(h);
+}
+
+static inline void
+__hash_rw_add_unlock(const struct rte_hash *h, bool locked)
+	__rte_no_thread_safety_analysis
+{
+	if (!locked)
+		__hash_rw_writer_unlock(h);
+}
+
 void
 rte_hash_reset(struct rte_hash *h)
 {
@@ -626,6 +766,11 @@ rte_hash_reset(struct rte_hash *h)
 	if (h == NULL)
 		return;
 
+	if (h->resize != NULL) {
+		resize_reset(h);
+		return;
+	}
+
 	__hash_rw_writer_lock(h);
 
 	if (h->dq) {
@@ -716,6 +861,7 @@ search_and_update(const struct rte_hash *h, void *data, const void *key,
 				rte_atomic_store_explicit(&k->pdata,
 					data,
 					rte_memory_order_release);
+				hash_stamp(h, k);
 				/*
 				 * Return index where key is stored,
 				 * subtracting the first dummy index
@@ -738,19 +884,19 @@ rte_hash_cuckoo_insert_mw(const struct rte_hash *h,
 		struct rte_hash_bucket *sec_bkt,
 		const struct rte_hash_key *key, void *data,
 		uint16_t sig, uint32_t new_idx,
-		int32_t *ret_val)
+		int32_t *ret_val, bool locked)
 {
 	unsigned int i;
 	struct rte_hash_bucket *cur_bkt;
 	int32_t ret;
 
-	__hash_rw_writer_lock(h);
+	__hash_rw_add_lock(h, locked);
 	/* Check if key was inserted after last check but before this
 	 * protected region in case of inserting duplicated keys.
 	 */
 	ret = search_and_update(h, data, key, prim_bkt, sig);
 	if (ret != -1) {
-		__hash_rw_writer_unlock(h);
+		__hash_rw_add_unlock(h, locked);
 		*ret_val = ret;
 		return 1;
 	}
@@ -758,7 +904,7 @@ rte_hash_cuckoo_insert_mw(const struct rte_hash *h,
 	FOR_EACH_BUCKET(cur_bkt, sec_bkt) {
 		ret = search_and_update(h, data, key, cur_bkt, sig);
 		if (ret != -1) {
-			__hash_rw_writer_unlock(h);
+			__hash_rw_add_unlock(h, locked);
 			*ret_val = ret;
 			return 1;
 		}
@@ -782,7 +928,7 @@ rte_hash_cuckoo_insert_mw(const struct rte_hash *h,
 			break;
 		}
 	}
-	__hash_rw_writer_unlock(h);
+	__hash_rw_add_unlock(h, locked);
 
 	if (i != RTE_HASH_BUCKET_ENTRIES)
 		return 0;
@@ -803,7 +949,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 			const struct rte_hash_key *key, void *data,
 			struct queue_node *leaf, uint32_t leaf_slot,
 			uint16_t sig, uint32_t new_idx,
-			int32_t *ret_val)
+			int32_t *ret_val, bool locked)
 {
 	uint32_t prev_alt_bkt_idx;
 	struct rte_hash_bucket *cur_bkt;
@@ -812,11 +958,11 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 	uint32_t prev_slot, curr_slot = leaf_slot;
 	int32_t ret;
 
-	__hash_rw_writer_lock(h);
+	__hash_rw_add_lock(h, locked);
 
 	/* In case empty slot was gone before entering protected region */
 	if (curr_bkt->key_idx[curr_slot] != EMPTY_SLOT) {
-		__hash_rw_writer_unlock(h);
+		__hash_rw_add_unlock(h, locked);
 		return -1;
 	}
 
@@ -825,7 +971,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 	 */
 	ret = search_and_update(h, data, key, bkt, sig);
 	if (ret != -1) {
-		__hash_rw_writer_unlock(h);
+		__hash_rw_add_unlock(h, locked);
 		*ret_val = ret;
 		return 1;
 	}
@@ -833,7 +979,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 	FOR_EACH_BUCKET(cur_bkt, alt_bkt) {
 		ret = search_and_update(h, data, key, cur_bkt, sig);
 		if (ret != -1) {
-			__hash_rw_writer_unlock(h);
+			__hash_rw_add_unlock(h, locked);
 			*ret_val = ret;
 			return 1;
 		}
@@ -854,7 +1000,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 			rte_atomic_store_explicit(&curr_bkt->key_idx[curr_slot],
 				EMPTY_SLOT,
 				rte_memory_order_release);
-			__hash_rw_writer_unlock(h);
+			__hash_rw_add_unlock(h, locked);
 			return -1;
 		}
 
@@ -912,7 +1058,7 @@ rte_hash_cuckoo_move_insert_mw(const struct rte_hash *h,
 			 new_idx,
 			 rte_memory_order_release);
 
-	__hash_rw_writer_unlock(h);
+	__hash_rw_add_unlock(h, locked);
 
 	return 0;
 
@@ -928,7 +1074,7 @@ rte_hash_cuckoo_make_space_mw(const struct rte_hash *h,
 			struct rte_hash_bucket *sec_bkt,
 			const struct rte_hash_key *key, void *data,
 			uint16_t sig, uint32_t bucket_idx,
-			uint32_t new_idx, int32_t *ret_val)
+			uint32_t new_idx, int32_t *ret_val, bool locked)
 {
 	unsigned int i;
 	struct queue_node queue[RTE_HASH_BFS_QUEUE_MAX_LEN];
@@ -954,7 +1100,7 @@ rte_hash_cuckoo_make_space_mw(const struct rte_hash *h,
 				int32_t ret = rte_hash_cuckoo_move_insert_mw(h,
 						bkt, sec_bkt, key, data,
 						tail, i, sig,
-						new_idx, ret_val);
+						new_idx, ret_val, locked);
 				if (likely(ret != -1))
 					return ret;
 			}
@@ -1007,9 +1153,13 @@ alloc_slot(const struct rte_hash *h, struct lcore_cache *cached_free_slots)
 	return slot_id;
 }
 
+/*
+ * Add a key, taking the writer lock as needed unless @locked tells the
+ * caller already holds it.
+ */
 static inline int32_t
-__rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
-						hash_sig_t sig, void *data)
+__rte_hash_add_key(const struct rte_hash *h, const void *key,
+		hash_sig_t sig, void *data, bool locked)
 {
 	uint16_t short_sig;
 	uint32_t prim_bucket_idx, sec_bucket_idx;
@@ -1024,6 +1174,9 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	int32_t ret_val;
 	struct rte_hash_bucket *last;
 
+	if (unlikely(h->resize != NULL))
+		return resize_add(h, key, sig, data);
+
 	short_sig = get_short_sig(sig);
 	prim_bucket_idx = get_prim_bucket_index(h, sig);
 	sec_bucket_idx = get_alt_bucket_index(h, prim_bucket_idx, short_sig);
@@ -1033,10 +1186,10 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	rte_prefetch0(sec_bkt);
 
 	/* Check if key is already inserted in primary location */
-	__hash_rw_writer_lock(h);
+	__hash_rw_add_lock(h, locked);
 	ret = search_and_update(h, data, key, prim_bkt, short_sig);
 	if (ret != -1) {
-		__hash_rw_writer_unlock(h);
+		__hash_rw_add_unlock(h, locked);
 		return ret;
 	}
 
@@ -1044,12 +1197,12 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	FOR_EACH_BUCKET(cur_bkt, sec_bkt) {
 		ret = search_and_update(h, data, key, cur_bkt, short_sig);
 		if (ret != -1) {
-			__hash_rw_writer_unlock(h);
+			__hash_rw_add_unlock(h, locked);
 			return ret;
 		}
 	}
 
-	__hash_rw_writer_unlock(h);
+	__hash_rw_add_unlock(h, locked);
 
 	/* Did not find a match, so get a new slot for storing the new key */
 	if (h->use_local_cache) {
@@ -1059,11 +1212,11 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	slot_id = alloc_slot(h, cached_free_slots);
 	if (slot_id == EMPTY_SLOT) {
 		if (h->dq) {
-			__hash_rw_writer_lock(h);
+			__hash_rw_add_lock(h, locked);
 			ret = rte_rcu_qsbr_dq_reclaim(h->dq,
 					h->hash_rcu_cfg->max_reclaim_size,
 					NULL, NULL, NULL);
-			__hash_rw_writer_unlock(h);
+			__hash_rw_add_unlock(h, locked);
 			if (ret == 0)
 				slot_id = alloc_slot(h, cached_free_slots);
 		}
@@ -1081,10 +1234,11 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 		rte_memory_order_release);
 	/* Copy key */
 	memcpy(new_k->key, key, h->key_len);
+	hash_stamp(h, new_k);
 
 	/* Find an empty slot and insert */
 	ret = rte_hash_cuckoo_insert_mw(h, prim_bkt, sec_bkt, key, data,
-					short_sig, slot_id, &ret_val);
+					short_sig, slot_id, &ret_val, locked);
 	if (ret == 0)
 		return slot_id - 1;
 	else if (ret == 1) {
@@ -1094,7 +1248,8 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 
 	/* Primary bucket full, need to make space for new entry */
 	ret = rte_hash_cuckoo_make_space_mw(h, prim_bkt, sec_bkt, key, data,
-				short_sig, prim_bucket_idx, slot_id, &ret_val);
+				short_sig, prim_bucket_idx, slot_id, &ret_val,
+				locked);
 	if (ret == 0)
 		return slot_id - 1;
 	else if (ret == 1) {
@@ -1104,7 +1259,8 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 
 	/* Also search secondary bucket to get better occupancy */
 	ret = rte_hash_cuckoo_make_space_mw(h, sec_bkt, prim_bkt, key, data,
-				short_sig, sec_bucket_idx, slot_id, &ret_val);
+				short_sig, sec_bucket_idx, slot_id, &ret_val,
+				locked);
 
 	if (ret == 0)
 		return slot_id - 1;
@@ -1122,7 +1278,7 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	/* Now we need to go through the extendable bucket. Protection is needed
 	 * to protect all extendable bucket processes.
 	 */
-	__hash_rw_writer_lock(h);
+	__hash_rw_add_lock(h, locked);
 	/* We check for duplicates again since could be inserted before the lock */
 	ret = search_and_update(h, data, key, prim_bkt, short_sig);
 	if (ret != -1) {
@@ -1152,7 +1308,7 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 				rte_atomic_store_explicit(&cur_bkt->key_idx[i],
 						 slot_id,
 						 rte_memory_order_release);
-				__hash_rw_writer_unlock(h);
+				__hash_rw_add_unlock(h, locked);
 				return slot_id - 1;
 			}
 		}
@@ -1191,15 +1347,22 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 	/* Link the new bucket to sec bucket linked list */
 	last = rte_hash_get_last_bkt(sec_bkt);
 	last->next = &h->buckets_ext[ext_bkt_id - 1];
-	__hash_rw_writer_unlock(h);
+	__hash_rw_add_unlock(h, locked);
 	return slot_id - 1;
 
 failure:
-	__hash_rw_writer_unlock(h);
+	__hash_rw_add_unlock(h, locked);
 	return ret;
 
 }
 
+static inline int32_t
+__rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
+						hash_sig_t sig, void *data)
+{
+	return __rte_hash_add_key(h, key, sig, data, false);
+}
+
 int32_t
 rte_hash_add_key_with_hash(const struct rte_hash *h,
 			const void *key, hash_sig_t sig)
@@ -1243,6 +1406,72 @@ rte_hash_add_key_data(const struct rte_hash *h, const void *key, void *data)
 		return ret;
 }
 
+int
+rte_hash_add_bulk(const struct rte_hash *h, const void **keys,
+		const hash_sig_t *sig, void *data[], uint32_t num_keys,
+		int32_t *positions)
+	__rte_no_thread_safety_analysis
+{
+	hash_sig_t hash[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t prim_index, sec_index;
+	uint32_t i;
+	int32_t ret;
+	int added = 0;
+	bool locked;
+
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) || (num_keys == 0) ||
+			(num_keys > RTE_HASH_LOOKUP_BULK_MAX)), -EINVAL);
+
+	for (i = 0; i < num_keys; i++)
+		rte_prefetch0(keys[i]);
+
+	for (i = 0; i < num_keys; i++) {
+		hash[i] = (sig != NULL) ? sig[i] : rte_hash_hash(h, keys[i]);
+		/*
+		 * The buckets of a resizable table belong to an internal
+		 * table that a concurrent writer may retire, leave them
+		 * to the add path.
+		 */
+		if (h->resize != NULL)
+			continue;
+		prim_index = get_prim_bucket_index(h, hash[i]);
+		sec_index = get_alt_bucket_index(h, prim_index,
+						get_short_sig(hash[i]));
+		rte_prefetch0(&h->buckets[prim_index]);
+		rte_prefetch0(&h->buckets[sec_index]);
+	}
+
+	/*
+	 * With lock based concurrency, take the writer lock once for the
+	 * whole burst. Lock-free tables keep the per step locking of the
+	 * add path that their readers rely on, transactional locks would
+	 * abort on a burst sized footprint, and resizable tables have their
+	 * own add path.
+	 */
+	locked = h->writer_takes_lock && !h->readwrite_concur_lf_support &&
+		!h->hw_trans_mem_support && h->resize == NULL;
+	if (locked)
+		__hash_rw_writer_lock(h);
+
+	/*
+	 * Insert in order so that duplicates within the burst resolve as
+	 * with sequential adds: the last occurrence updates the data.
+	 */
+	for (i = 0; i < num_keys; i++) {
+		ret = __rte_hash_add_key(h, keys[i], hash[i],
+				(data != NULL) ? data[i] : NULL, locked);
+		if (positions != NULL)
+			positions[i] = ret;
+		if (ret >= 0)
+			added++;
+	}
+
+	if (locked)
+		__hash_rw_writer_unlock(h);
+
+	return added;
+}
+
 /* Search one bucket to find the match key - uses rw lock */
 static inline int32_t
 search_one_bucket_l(const struct rte_hash *h, const void *key,
@@ -1261,6 +1490,7 @@ search_one_bucket_l(const struct rte_hash *h, const void *key,
 			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
 				if (data != NULL)
 					*data = k->pdata;
+				hash_touch(h, k);
 				/*
 				 * Return index where key is stored,
 				 * subtracting the first dummy index
@@ -1302,6 +1532,7 @@ search_one_bucket_lf(const struct rte_hash *h, const void *key, uint16_t sig,
 							&k->pdata,
 							rte_memory_order_acquire);
 					}
+					hash_touch(h, k);
 					/*
 					 * Return index where key is stored,
 					 * subtracting the first dummy index
@@ -1416,6 +1647,8 @@ static inline int32_t
 __rte_hash_lookup_with_hash(const struct rte_hash *h, const void *key,
 					hash_sig_t sig, void **data)
 {
+	if (unlikely(h->resize != NULL))
+		return resize_lookup(h, key, sig, data);
 	if (h->readwrite_concur_lf_support)
 		return __rte_hash_lookup_with_hash_lf(h, key, sig, data);
 	else
@@ -1524,6 +1757,9 @@ rte_hash_rcu_qsbr_add(struct rte_hash *h, struct rte_hash_rcu_config *cfg)
 		return 1;
 	}
 
+	if (h->resize != NULL)
+		return resize_rcu_qsbr_add(h, cfg);
+
 	const uint32_t total_entries = h->use_local_cache ?
 		h->entries + (RTE_MAX_LCORE - 1) * (LCORE_CACHE_SIZE - 1) + 1
 							: h->entries + 1;
@@ -1679,8 +1915,12 @@ search_and_remove(const struct rte_hash *h, const void *key,
 	return -1;
 }
 
+/* Delete a key.
+ * Writer is expected to hold the lock while calling this
+ * function.
+ */
 static inline int32_t
-__rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
+__rte_hash_del_key_with_hash_locked(const struct rte_hash *h, const void *key,
 						hash_sig_t sig)
 {
 	uint32_t prim_bucket_idx, sec_bucket_idx;
@@ -1697,7 +1937,6 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 	sec_bucket_idx = get_alt_bucket_index(h, prim_bucket_idx, short_sig);
 	prim_bkt = &h->buckets[prim_bucket_idx];
 
-	__hash_rw_writer_lock(h);
 	/* look for key in primary bucket */
 	ret = search_and_remove(h, key, prim_bkt, short_sig, &pos);
 	if (ret != -1) {
@@ -1720,7 +1959,6 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 		}
 	}
 
-	__hash_rw_writer_unlock(h);
 	return -ENOENT;
 
 /* Search last bucket to see if empty to be recycled */
@@ -1780,6 +2018,20 @@ return_key:
 			if (rte_rcu_qsbr_dq_enqueue(h->dq, &rcu_dq_entry) != 0)
 				RTE_LOG(ERR, HASH, "Failed to push QSBR FIFO\n");
 	}
+	return ret;
+}
+
+static inline int32_t
+__rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
+						hash_sig_t sig)
+{
+	int32_t ret;
+
+	if (unlikely(h->resize != NULL))
+		return resize_del(h, key, sig);
+
+	__hash_rw_writer_lock(h);
+	ret = __rte_hash_del_key_with_hash_locked(h, key, sig);
 	__hash_rw_writer_unlock(h);
 	return ret;
 }
@@ -1805,6 +2057,13 @@ rte_hash_get_key_with_position(const struct rte_hash *h, const int32_t position,
 {
 	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
 
+	int32_t pos = position;
+
+	if (h->resize != NULL) {
+		h = resize_table_of(h, &pos);
+		return rte_hash_get_key_with_position(h, pos, key);
+	}
+
 	struct rte_hash_key *k, *keys = h->key_store;
 	k = (struct rte_hash_key *) ((char *) keys + (position + 1) *
 				     h->key_entry_size);
@@ -1828,6 +2087,13 @@ rte_hash_free_key_with_position(const struct rte_hash *h,
 
 	RETURN_IF_TRUE(((h == NULL) || (key_idx == EMPTY_SLOT)), -EINVAL);
 
+	if (h->resize != NULL) {
+		int32_t pos = position;
+
+		h = resize_table_of(h, &pos);
+		return rte_hash_free_key_with_position(h, pos);
+	}
+
 	const uint32_t total_entries = h->use_local_cache ?
 		h->entries + (RTE_MAX_LCORE - 1) * (LCORE_CACHE_SIZE - 1) + 1
 							: h->entries + 1;
@@ -1980,6 +2246,7 @@ __bulk_lookup_l(const struct rte_hash *h, const void **keys,
 					key_slot->key, keys[i], h)) {
 				if (data != NULL)
 					data[i] = key_slot->pdata;
+				hash_touch(h, key_slot);
 
 				hits |= 1ULL << i;
 				positions[i] = key_idx - 1;
@@ -2009,6 +2276,7 @@ __bulk_lookup_l(const struct rte_hash *h, const void **keys,
 					key_slot->key, keys[i], h)) {
 				if (data != NULL)
 					data[i] = key_slot->pdata;
+				hash_touch(h, key_slot);
 
 				hits |= 1ULL << i;
 				positions[i] = key_idx - 1;
@@ -2140,6 +2408,7 @@ __bulk_lookup_lf(const struct rte_hash *h, const void **keys,
 						data[i] = rte_atomic_load_explicit(
 							&key_slot->pdata,
 							rte_memory_order_acquire);
+					hash_touch(h, key_slot);
 
 					hits |= 1ULL << i;
 					positions[i] = key_idx - 1;
@@ -2173,6 +2442,7 @@ __bulk_lookup_lf(const struct rte_hash *h, const void **keys,
 						data[i] = rte_atomic_load_explicit(
 							&key_slot->pdata,
 							rte_memory_order_acquire);
+					hash_touch(h, key_slot);
 
 					hits |= 1ULL << i;
 					positions[i] = key_idx - 1;
@@ -2324,7 +2594,10 @@ __rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 			int32_t num_keys, int32_t *positions,
 			uint64_t *hit_mask, void *data[])
 {
-	if (h->readwrite_concur_lf_support)
+	if (unlikely(h->resize != NULL))
+		resize_lookup_bulk(h, keys, NULL, num_keys, positions,
+				   hit_mask, data);
+	else if (h->readwrite_concur_lf_support)
 		__rte_hash_lookup_bulk_lf(h, keys, num_keys, positions,
 					  hit_mask, data);
 	else
@@ -2436,7 +2709,10 @@ __rte_hash_lookup_with_hash_bulk(const struct rte_hash *h, const void **keys,
 			hash_sig_t *prim_hash, int32_t num_keys,
 			int32_t *positions, uint64_t *hit_mask, void *data[])
 {
-	if (h->readwrite_concur_lf_support)
+	if (unlikely(h->resize != NULL))
+		resize_lookup_bulk(h, keys, prim_hash, num_keys, positions,
+				   hit_mask, data);
+	else if (h->readwrite_concur_lf_support)
 		__rte_hash_lookup_with_hash_bulk_lf(h, keys, prim_hash,
 				num_keys, positions, hit_mask, data);
 	else
@@ -2485,6 +2761,9 @@ rte_hash_iterate(const struct rte_hash *h, const void **key, void **data, uint32
 
 	RETURN_IF_TRUE(((h == NULL) || (next == NULL)), -EINVAL);
 
+	if (h->resize != NULL)
+		return resize_iterate(h, key, data, next);
+
 	const uint32_t total_entries_main = h->num_buckets *
 							RTE_HASH_BUCKET_ENTRIES;
 	const uint32_t total_entries = total_entries_main << 1;
@@ -2552,3 +2831,772 @@ extend_table:
 	(*next)++;
 	return position - 1;
 }
+
+int
+rte_hash_age(struct rte_hash *h, uint64_t ttl, uint32_t *next,
+	     uint32_t max_buckets, int32_t positions[], void *data[],
+	     uint32_t max_expired)
+{
+	struct rte_hash_key *k, *expired[RTE_HASH_BUCKET_ENTRIES];
+	struct rte_hash_bucket *bkt;
+	uint32_t bkt_idx, key_idx, nb_bkts, nb_exp = 0;
+	unsigned int i, n;
+	uint64_t now, tstamp;
+	void *d;
+	int32_t ret;
+
+	if (h == NULL || h->age_off == 0 || next == NULL ||
+	    positions == NULL || max_expired == 0 ||
+	    *next >= h->num_buckets)
+		return -EINVAL;
+
+	now = rte_get_timer_cycles();
+	rte_atomic_store_explicit(&h->age_clock, now,
+				  rte_memory_order_relaxed);
+
+	__hash_rw_writer_lock(h);
+	bkt_idx = *next;
+	for (nb_bkts = 0; nb_bkts < max_buckets; nb_bkts++) {
+		/*
+		 * Collect the expired keys of each bucket of the chain
+		 * before deleting them, as a delete compacts the chain.
+		 * A chain is started again on the next call if the output
+		 * is full before its end.
+		 */
+		bkt = &h->buckets[bkt_idx];
+		while (bkt != NULL) {
+			n = 0;
+			for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+				key_idx = bkt->key_idx[i];
+				if (key_idx == EMPTY_SLOT)
+					continue;
+				k = (struct rte_hash_key *)((char *)h->key_store +
+						key_idx * h->key_entry_size);
+				tstamp = rte_atomic_load_explicit(
+					(RTE_ATOMIC(uint64_t) *)((uintptr_t)k +
+								 h->age_off),
+					rte_memory_order_relaxed);
+				if (now - tstamp > ttl)
+					expired[n++] = k;
+			}
+			for (i = 0; i < n; i++) {
+				if (nb_exp == max_expired)
+					goto out;
+				d = expired[i]->pdata;
+				ret = __rte_hash_del_key_with_hash_locked(h,
+					expired[i]->key,
+					rte_hash_hash(h, expired[i]->key));
+				if (ret < 0)
+					continue;
+				positions[nb_exp] = ret;
+				if (data != NULL)
+					data[nb_exp] = d;
+				nb_exp++;
+			}
+			/* An emptied last bucket is unlinked, its next is NULL */
+			bkt = bkt->next;
+		}
+		if (++bkt_idx == h->num_buckets) {
+			bkt_idx = 0;
+			break;
+		}
+	}
+out:
+	*next = bkt_idx;
+
+	/* Give the resources of the entries freed by the readers back */
+	if (h->dq != NULL)
+		rte_rcu_qsbr_dq_reclaim(h->dq, h->hash_rcu_cfg->max_reclaim_size,
+					NULL, NULL, NULL);
+	__hash_rw_writer_unlock(h);
+
+	return nb_exp;
+}
+
+/*
+ * Resizable tables.
+ *
+ * The handle of a table created with RTE_HASH_EXTRA_FLAGS_RESIZABLE does
+ * not store keys: they live in an unlisted table (cur). A resize creates
+ * a new table, which becomes cur, and the previous one (old) is drained
+ * a few buckets at a time by the following adds and deletes: each key is
+ * added to cur before being removed from old, and readers retry a miss if
+ * a key moved during their lookup (chng_cnt). Lookups never migrate keys
+ * as lock free readers must not write to the table. A drained table is
+ * freed once the readers are done with it, which with lock free
+ * concurrency requires the RCU variable given to rte_hash_rcu_qsbr_add().
+ */
+
+static void
+resize_free_retired(void *p, void *e, unsigned int n)
+{
+	RTE_SET_USED(p);
+	RTE_SET_USED(n);
+	hash_free_table(*(struct rte_hash **)e);
+}
+
+/* Create a table backing h, with the parameters and RCU config of h */
+static struct rte_hash *
+resize_table_create(const struct rte_hash *h, uint32_t entries)
+{
+	static RTE_ATOMIC(uint32_t) table_id;
+	struct rte_hash_parameters params = h->resize->params;
+	char name[RTE_HASH_NAMESIZE];
+	struct rte_hash *t;
+
+	/* Ring and defer queue names are built from the table name, keep
+	 * the unique suffix within their length limit.
+	 */
+	snprintf(name, sizeof(name), "%.11s@%x", h->name,
+		rte_atomic_fetch_add_explicit(&table_id, 1,
+				rte_memory_order_relaxed));
+	params.name = name;
+	params.entries = entries;
+
+	t = hash_create(&params, false);
+	if (t == NULL)
+		return NULL;
+
+	if (h->rte_hash_custom_cmp_eq != NULL)
+		rte_hash_set_cmp_func(t, h->rte_hash_custom_cmp_eq);
+
+	if (h->hash_rcu_cfg != NULL &&
+			rte_hash_rcu_qsbr_add(t, h->hash_rcu_cfg) != 0) {
+		hash_free_table(t);
+		return NULL;
+	}
+	return t;
+}
+
+static struct rte_hash *
+resize_create(const struct rte_hash_parameters *params)
+{
+	struct rte_tailq_entry *te = NULL;
+	struct rte_hash_list *hash_list;
+	struct rte_hash_resize *rz = NULL;
+	struct rte_hash *h = NULL, *cur = NULL;
+
+	hash_list = RTE_TAILQ_CAST(rte_hash_tailq.head, rte_hash_list);
+
+	if (params->extra_flag & (RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY |
+				  RTE_HASH_EXTRA_FLAGS_NO_FREE_ON_DEL |
+				  RTE_HASH_EXTRA_FLAGS_AGING)) {
+		rte_errno = EINVAL;
+		RTE_LOG(ERR, HASH, "rte_hash_create: resizable table cannot "
+			"use rw concurrency with locks, no free on del "
+			"or aging\n");
+		return NULL;
+	}
+
+	rz = rte_zmalloc_socket(NULL, sizeof(*rz), RTE_CACHE_LINE_SIZE,
+				params->socket_id);
+	h = rte_zmalloc_socket(NULL, sizeof(*h), RTE_CACHE_LINE_SIZE,
+			       params->socket_id);
+	if (rz == NULL || h == NULL) {
+		rte_errno = ENOMEM;
+		RTE_LOG(ERR, HASH, "memory allocation failed\n");
+		goto err;
+	}
+
+	rz->params = *params;
+	rz->params.name = NULL;
+	rz->params.extra_flag &= ~RTE_HASH_EXTRA_FLAGS_RESIZABLE;
+	rz->min_entries = params->entries;
+	strlcpy(h->name, params->name, sizeof(h->name));
+	h->resize = rz;
+
+	/* Validates the parameters */
+	cur = resize_table_create(h, params->entries);
+	if (cur == NULL)
+		goto err;
+	rte_atomic_store_explicit(&rz->cur, cur, rte_memory_order_relaxed);
+
+	/* The handle hashes keys and serializes writers */
+	h->entries = params->entries;
+	h->key_len = cur->key_len;
+	h->hash_func = cur->hash_func;
+	h->hash_func_init_val = cur->hash_func_init_val;
+	h->cmp_jump_table_idx = cur->cmp_jump_table_idx;
+	h->hw_trans_mem_support = cur->hw_trans_mem_support;
+	h->writer_takes_lock = cur->writer_takes_lock;
+	h->readwrite_concur_lf_support = cur->readwrite_concur_lf_support;
+	if (h->writer_takes_lock) {
+		h->readwrite_lock = rte_malloc(NULL, sizeof(rte_rwlock_t),
+						RTE_CACHE_LINE_SIZE);
+		if (h->readwrite_lock == NULL)
+			goto err;
+
+		rte_rwlock_init(h->readwrite_lock);
+	}
+
+	rte_mcfg_tailq_write_lock();
+
+	TAILQ_FOREACH(te, hash_list, next) {
+		if (strncmp(params->name, ((struct rte_hash *)te->data)->name,
+				RTE_HASH_NAMESIZE) == 0)
+			break;
+	}
+	if (te != NULL) {
+		rte_errno = EEXIST;
+		goto err_unlock;
+	}
+
+	te = rte_zmalloc("HASH_TAILQ_ENTRY", sizeof(*te), 0);
+	if (te == NULL) {
+		RTE_LOG(ERR, HASH, "tailq entry allocation failed\n");
+		goto err_unlock;
+	}
+	te->data = (void *) h;
+	TAILQ_INSERT_TAIL(hash_list, te, next);
+	rte_mcfg_tailq_write_unlock();
+
+	return h;
+err_unlock:
+	rte_mcfg_tailq_write_unlock();
+err:
+	if (cur != NULL)
+		hash_free_table(cur);
+	if (h != NULL)
+		rte_free(h->readwrite_lock);
+	rte_free(h);
+	rte_free(rz);
+	return NULL;
+}
+
+static void
+resize_free(struct rte_hash *h)
+{
+	struct rte_hash_resize *rz = h->resize;
+	struct rte_hash *old = rte_atomic_load_explicit(&rz->old,
+				rte_memory_order_relaxed);
+
+	/* Frees the tables retired by previous resizes */
+	if (h->dq)
+		rte_rcu_qsbr_dq_delete(h->dq);
+
+	if (old != NULL)
+		hash_free_table(old);
+	hash_free_table(rte_atomic_load_explicit(&rz->cur,
+				rte_memory_order_relaxed));
+	if (h->writer_takes_lock)
+		rte_free(h->readwrite_lock);
+	rte_free(h->hash_rcu_cfg);
+	rte_free(rz);
+	rte_free(h);
+}
+
+static int
+resize_rcu_qsbr_add(struct rte_hash *h, struct rte_hash_rcu_config *cfg)
+{
+	struct rte_rcu_qsbr_dq_parameters params = {0};
+	char rcu_dq_name[RTE_RCU_QSBR_DQ_NAMESIZE];
+	struct rte_hash_rcu_config *hash_rcu_cfg;
+	struct rte_hash_resize *rz = h->resize;
+	struct rte_hash *old;
+
+	if (h->hash_rcu_cfg) {
+		rte_errno = EEXIST;
+		return 1;
+	}
+
+	if (cfg->mode != RTE_HASH_QSBR_MODE_SYNC &&
+			cfg->mode != RTE_HASH_QSBR_MODE_DQ) {
+		rte_errno = EINVAL;
+		return 1;
+	}
+
+	hash_rcu_cfg = rte_zmalloc(NULL, sizeof(struct rte_hash_rcu_config), 0);
+	if (hash_rcu_cfg == NULL) {
+		RTE_LOG(ERR, HASH, "memory allocation failed\n");
+		return 1;
+	}
+	/* Kept as given: every new table derives its own defaults */
+	*hash_rcu_cfg = *cfg;
+
+	if (cfg->mode == RTE_HASH_QSBR_MODE_DQ) {
+		/* Tables left behind by a resize wait here for the readers */
+		snprintf(rcu_dq_name, sizeof(rcu_dq_name),
+					"HASH_RZ_%s", h->name);
+		params.name = rcu_dq_name;
+		params.size = RTE_HASH_RESIZE_DQ_SIZE;
+		params.trigger_reclaim_limit = 1;
+		params.max_reclaim_size = RTE_HASH_RESIZE_DQ_SIZE;
+		params.esize = sizeof(struct rte_hash *);
+		params.free_fn = resize_free_retired;
+		params.v = cfg->v;
+		h->dq = rte_rcu_qsbr_dq_create(&params);
+		if (h->dq == NULL) {
+			rte_free(hash_rcu_cfg);
+			RTE_LOG(ERR, HASH, "HASH defer queue creation failed\n");
+			return 1;
+		}
+	}
+
+	old = rte_atomic_load_explicit(&rz->old, rte_memory_order_relaxed);
+	if (rte_hash_rcu_qsbr_add(rte_atomic_load_explicit(&rz->cur,
+				rte_memory_order_relaxed), cfg) != 0 ||
+			(old != NULL && rte_hash_rcu_qsbr_add(old, cfg) != 0)) {
+		rte_rcu_qsbr_dq_delete(h->dq);
+		h->dq = NULL;
+		rte_free(hash_rcu_cfg);
+		return 1;
+	}
+
+	h->hash_rcu_cfg = hash_rcu_cfg;
+
+	return 0;
+}
+
+/* Free a table no longer reachable from h once no reader uses it */
+static void
+resize_retire(const struct rte_hash *h, struct rte_hash *t)
+{
+	/* Without RCU, readers do not run concurrently with writers */
+	if (h->hash_rcu_cfg == NULL) {
+		hash_free_table(t);
+		return;
+	}
+
+	if (h->dq != NULL && rte_rcu_qsbr_dq_enqueue(h->dq, &t) == 0)
+		return;
+
+	/* RTE_HASH_QSBR_MODE_SYNC, or nothing could be reclaimed */
+	rte_rcu_qsbr_synchronize(h->hash_rcu_cfg->v, RTE_QSBR_THRID_INVALID);
+	hash_free_table(t);
+}
+
+/* Writer lock of h is held by the callers of the functions below */
+
+static int
+resize_start(const struct rte_hash *h, uint32_t entries)
+{
+	struct rte_hash_resize *rz = h->resize;
+	struct rte_hash *cur, *next;
+
+	if (rte_atomic_load_explicit(&rz->old, rte_memory_order_relaxed))
+		return -EBUSY;
+
+	/* Without RCU, there is no telling when readers leave a table */
+	if (h->readwrite_concur_lf_support && h->hash_rcu_cfg == NULL)
+		return -ENOTSUP;
+
+	next = resize_table_create(h, entries);
+	if (next == NULL)
+		return -ENOMEM;
+
+	cur = rte_atomic_load_explicit(&rz->cur, rte_memory_order_relaxed);
+	rz->next_bkt = 0;
+	rz->old_keys = rte_hash_count(cur);
+
+	/* A reader that sees next as cur also sees cur as old */
+	rte_atomic_store_explicit(&rz->old, cur, rte_memory_order_release);
+	rte_atomic_store_explicit(&rz->cur, next, rte_memory_order_release);
+
+	return 0;
+}
+
+/* Move the key in slot i of bkt, a bucket of old, to cur */
+static int32_t
+resize_move(const struct rte_hash *h, struct rte_hash_bucket *bkt,
+		unsigned int i)
+{
+	struct rte_hash_resize *rz = h->resize;
+	const struct rte_hash *old = rte_atomic_load_explicit(&rz->old,
+				rte_memory_order_relaxed);
+	const struct rte_hash_key *k;
+	int32_t ret;
+
+	k = (const struct rte_hash_key *) ((const char *)old->key_store +
+				bkt->key_idx[i] * old->key_entry_size);
+	ret = __rte_hash_add_key_with_hash(rte_atomic_load_explicit(&rz->cur,
+				rte_memory_order_relaxed),
+			k->key, rte_hash_hash(h, k->key), k->pdata);
+	if (ret < 0)
+		return ret;
+
+	/* Inform the readers that the key may have left old before
+	 * they looked for it there.
+	 */
+	rte_atomic_store_explicit(&rz->chng_cnt, rz->chng_cnt + 1,
+			rte_memory_order_release);
+	/* The store to sig_current should not move above the store
+	 * to chng_cnt.
+	 */
+	__atomic_thread_fence(rte_memory_order_release);
+	bkt->sig_current[i] = NULL_SIGNATURE;
+	rte_atomic_store_explicit(&bkt->key_idx[i], EMPTY_SLOT,
+			rte_memory_order_release);
+	rz->old_keys--;
+
+	return ret;
+}
+
+/* Move up to max_buckets buckets of old, return how many are left */
+static uint32_t
+resize_migrate(const struct rte_hash *h, uint32_t max_buckets)
+{
+	struct rte_hash_resize *rz = h->resize;
+	struct rte_hash *old = rte_atomic_load_explicit(&rz->old,
+				rte_memory_order_relaxed);
+	struct rte_hash_bucket *bkt;
+	unsigned int i;
+
+	while (max_buckets-- > 0 && rz->next_bkt < old->num_buckets) {
+		/* Also drain the extendable buckets chained to it */
+		FOR_EACH_BUCKET(bkt, &old->buckets[rz->next_bkt]) {
+			for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+				/* cur is full: the next call retries */
+				if (bkt->key_idx[i] != EMPTY_SLOT &&
+						resize_move(h, bkt, i) < 0)
+					return old->num_buckets - rz->next_bkt;
+			}
+		}
+		rz->next_bkt++;
+	}
+
+	if (rz->next_bkt < old->num_buckets)
+		return old->num_buckets - rz->next_bkt;
+
+	rte_atomic_store_explicit(&rz->old, NULL, rte_memory_order_release);
+	rz->old_keys = 0;
+	resize_retire(h, old);
+
+	return 0;
+}
+
+/* Called after each add or delete: move a few buckets of old or, every
+ * RTE_HASH_RESIZE_CHECK_PERIOD calls, check whether the load calls for
+ * a resize. rte_hash_count() walks the lcore caches, hence the period.
+ */
+static void
+resize_progress(const struct rte_hash *h)
+{
+	struct rte_hash_resize *rz = h->resize;
+	const struct rte_hash *cur;
+	int32_t used;
+
+	if (rte_atomic_load_explicit(&rz->old, rte_memory_order_relaxed)) {
+		resize_migrate(h, RTE_HASH_RESIZE_BKTS_PER_OP);
+		return;
+	}
+
+	if (++rz->nb_ops % RTE_HASH_RESIZE_CHECK_PERIOD != 0)
+		return;
+
+	if (h->dq)
+		rte_rcu_qsbr_dq_reclaim(h->dq, RTE_HASH_RESIZE_DQ_SIZE,
+					NULL, NULL, NULL);
+
+	cur = rte_atomic_load_explicit(&rz->cur, rte_memory_order_relaxed);
+	used = rte_hash_count(cur);
+	if (used > (int32_t)(cur->entries / 4 * 3) &&
+			cur->entries <= RTE_HASH_ENTRIES_MAX / 2)
+		resize_start(h, cur->entries * 2);
+	else if (used < (int32_t)(cur->entries / 8) &&
+			cur->entries / 2 >= rz->min_entries)
+		resize_start(h, cur->entries / 2);
+}
+
+static int32_t
+resize_add(const struct rte_hash *h, const void *key, hash_sig_t sig,
+		void *data)
+{
+	struct rte_hash_resize *rz = h->resize;
+	uint16_t short_sig = get_short_sig(sig);
+	struct rte_hash *cur, *old;
+	struct rte_hash_bucket *bkt, *cur_bkt;
+	struct rte_hash_key *k;
+	uint32_t prim_bucket_idx;
+	int32_t ret;
+
+	__hash_rw_writer_lock(h);
+	cur = rte_atomic_load_explicit(&rz->cur, rte_memory_order_relaxed);
+	old = rte_atomic_load_explicit(&rz->old, rte_memory_order_relaxed);
+
+	/* A key still in old is updated there and moves with its bucket */
+	if (old != NULL) {
+		prim_bucket_idx = get_prim_bucket_index(old, sig);
+		bkt = &old->buckets[get_alt_bucket_index(old,
+					prim_bucket_idx, short_sig)];
+		ret = search_one_bucket_l(old, key, short_sig, NULL,
+					  &old->buckets[prim_bucket_idx]);
+		FOR_EACH_BUCKET(cur_bkt, bkt) {
+			if (ret != -1)
+				break;
+			ret = search_one_bucket_l(old, key, short_sig, NULL,
+						  cur_bkt);
+		}
+		if (ret != -1) {
+			k = (struct rte_hash_key *) ((char *)old->key_store +
+					(ret + 1) * old->key_entry_size);
+			rte_atomic_store_explicit(&k->pdata, data,
+					rte_memory_order_release);
+			ret += rte_hash_max_key_id(cur);
+			goto progress;
+		}
+	}
+
+	ret = __rte_hash_add_key_with_hash(cur, key, sig, data);
+	if (ret == -ENOSPC && cur->entries <= RTE_HASH_ENTRIES_MAX / 2) {
+		/* Grow now rather than fail, old has to be drained first */
+		if (old != NULL)
+			resize_migrate(h, UINT32_MAX);
+		if (resize_start(h, cur->entries * 2) == 0)
+			ret = __rte_hash_add_key_with_hash(
+				rte_atomic_load_explicit(&rz->cur,
+					rte_memory_order_relaxed),
+				key, sig, data);
+	}
+
+progress:
+	resize_progress(h);
+	__hash_rw_writer_unlock(h);
+	return ret;
+}
+
+static int32_t
+resize_del(const struct rte_hash *h, const void *key, hash_sig_t sig)
+{
+	struct rte_hash_resize *rz = h->resize;
+	struct rte_hash *cur, *old;
+	int32_t ret = -ENOENT;
+
+	__hash_rw_writer_lock(h);
+	cur = rte_atomic_load_explicit(&rz->cur, rte_memory_order_relaxed);
+	old = rte_atomic_load_explicit(&rz->old, rte_memory_order_relaxed);
+
+	/* Deleting from old frees the key data through the RCU of old */
+	if (old != NULL) {
+		ret = __rte_hash_del_key_with_hash(old, key, sig);
+		if (ret >= 0) {
+			rz->old_keys--;
+			ret += rte_hash_max_key_id(cur);
+		}
+	}
+	if (ret < 0)
+		ret = __rte_hash_del_key_with_hash(cur, key, sig);
+
+	resize_progress(h);
+	__hash_rw_writer_unlock(h);
+	return ret;
+}
+
+static int32_t
+resize_lookup(const struct rte_hash *h, const void *key, hash_sig_t sig,
+		void **data)
+{
+	struct rte_hash_resize *rz = h->resize;
+	const struct rte_hash *cur, *old;
+	uint32_t cnt_b, cnt_a;
+	int32_t ret;
+
+	do {
+		/* Load the change counter before the tables, a key moved
+		 * after this load makes the lookup retry.
+		 */
+		cnt_b = rte_atomic_load_explicit(&rz->chng_cnt,
+				rte_memory_order_acquire);
+		cur = rte_atomic_load_explicit(&rz->cur,
+				rte_memory_order_acquire);
+		old = rte_atomic_load_explicit(&rz->old,
+				rte_memory_order_acquire);
+
+		ret = __rte_hash_lookup_with_hash(cur, key, sig, data);
+		if (ret >= 0)
+			return ret;
+		if (old != NULL) {
+			ret = __rte_hash_lookup_with_hash(old, key, sig, data);
+			if (ret >= 0)
+				return ret + rte_hash_max_key_id(cur);
+		}
+
+		/* The loads of sig_current in the lookups should not move
+		 * below the load from chng_cnt.
+		 */
+		__atomic_thread_fence(rte_memory_order_acquire);
+		cnt_a = rte_atomic_load_explicit(&rz->chng_cnt,
+				rte_memory_order_acquire);
+	} while (cnt_b != cnt_a);
+
+	return -ENOENT;
+}
+
+static void
+resize_lookup_bulk(const struct rte_hash *h, const void **keys,
+		hash_sig_t *prim_hash, int32_t num_keys, int32_t *positions,
+		uint64_t *hit_mask, void *data[])
+{
+	struct rte_hash_resize *rz = h->resize;
+	const uint64_t all = RTE_LEN2MASK(num_keys, uint64_t);
+	const void *old_keys[RTE_HASH_LOOKUP_BULK_MAX];
+	hash_sig_t old_hash[RTE_HASH_LOOKUP_BULK_MAX];
+	int32_t old_positions[RTE_HASH_LOOKUP_BULK_MAX];
+	void *old_data[RTE_HASH_LOOKUP_BULK_MAX];
+	int32_t idx[RTE_HASH_LOOKUP_BULK_MAX];
+	const struct rte_hash *cur, *old;
+	uint64_t hits, old_hits;
+	uint32_t cnt_b, cnt_a;
+	int32_t i, n, base;
+
+	do {
+		cnt_b = rte_atomic_load_explicit(&rz->chng_cnt,
+				rte_memory_order_acquire);
+		cur = rte_atomic_load_explicit(&rz->cur,
+				rte_memory_order_acquire);
+		old = rte_atomic_load_explicit(&rz->old,
+				rte_memory_order_acquire);
+
+		if (prim_hash != NULL)
+			__rte_hash_lookup_with_hash_bulk(cur, keys, prim_hash,
+				num_keys, positions, &hits, data);
+		else
+			__rte_hash_lookup_bulk(cur, keys, num_keys, positions,
+				&hits, data);
+		if (hits == all)
+			break;
+
+		/* Look for the misses in old */
+		if (old != NULL) {
+			for (i = 0, n = 0; i < num_keys; i++) {
+				if (hits & (1ULL << i))
+					continue;
+				idx[n] = i;
+				old_keys[n] = keys[i];
+				if (prim_hash != NULL)
+					old_hash[n] = prim_hash[i];
+				n++;
+			}
+			if (prim_hash != NULL)
+				__rte_hash_lookup_with_hash_bulk(old, old_keys,
+					old_hash, n, old_positions, &old_hits,
+					old_data);
+			else
+				__rte_hash_lookup_bulk(old, old_keys, n,
+					old_positions, &old_hits, old_data);
+
+			base = rte_hash_max_key_id(cur);
+			for (i = 0; i < n; i++) {
+				if (!(old_hits & (1ULL << i)))
+					continue;
+				positions[idx[i]] = old_positions[i] + base;
+				if (data != NULL)
+					data[idx[i]] = old_data[i];
+				hits |= 1ULL << idx[i];
+			}
+		}
+
+		__atomic_thread_fence(rte_memory_order_acquire);
+		cnt_a = rte_atomic_load_explicit(&rz->chng_cnt,
+				rte_memory_order_acquire);
+	} while (hits != all && cnt_b != cnt_a);
+
+	if (hit_mask != NULL)
+		*hit_mask = hits;
+}
+
+/* Table of h holding position, which is rebased to that table */
+static const struct rte_hash *
+resize_table_of(const struct rte_hash *h, int32_t *position)
+{
+	const struct rte_hash *cur = rte_atomic_load_explicit(&h->resize->cur,
+				rte_memory_order_acquire);
+	const struct rte_hash *old = rte_atomic_load_explicit(&h->resize->old,
+				rte_memory_order_acquire);
+	int32_t base = rte_hash_max_key_id(cur);
+
+	if (old == NULL || *position < base)
+		return cur;
+	*position -= base;
+	return old;
+}
+
+/* Iterate cur, then old: the iterator values of old follow those of cur */
+static int32_t
+resize_iterate(const struct rte_hash *h, const void **key, void **data,
+		uint32_t *next)
+{
+	const struct rte_hash *cur = rte_atomic_load_explicit(&h->resize->cur,
+				rte_memory_order_acquire);
+	const struct rte_hash *old = rte_atomic_load_explicit(&h->resize->old,
+				rte_memory_order_acquire);
+	const uint32_t cur_next_max = cur->num_buckets *
+					RTE_HASH_BUCKET_ENTRIES * 2;
+	uint32_t old_next;
+	int32_t ret;
+
+	if (*next < cur_next_max) {
+		ret = rte_hash_iterate(cur, key, data, next);
+		if (ret != -ENOENT || old == NULL)
+			return ret;
+		*next = cur_next_max;
+	}
+	if (old == NULL)
+		return -ENOENT;
+
+	old_next = *next - cur_next_max;
+	ret = rte_hash_iterate(old, key, data, &old_next);
+	*next = old_next + cur_next_max;
+	if (ret < 0)
+		return ret;
+	return ret + rte_hash_max_key_id(cur);
+}
+
+static void
+resize_reset(struct rte_hash *h)
+{
+	struct rte_hash_resize *rz = h->resize;
+	struct rte_hash *old;
+
+	__hash_rw_writer_lock(h);
+	old = rte_atomic_load_explicit(&rz->old, rte_memory_order_relaxed);
+	if (old != NULL) {
+		rte_atomic_store_explicit(&rz->old, NULL,
+				rte_memory_order_release);
+		rz->old_keys = 0;
+		resize_retire(h, old);
+	}
+	rte_hash_reset(rte_atomic_load_explicit(&rz->cur,
+				rte_memory_order_relaxed));
+	__hash_rw_writer_unlock(h);
+}
+
+int
+rte_hash_resize(struct rte_hash *h, uint32_t entries)
+{
+	int ret;
+
+	RETURN_IF_TRUE(((h == NULL) || (h->resize == NULL) ||
+			(entries < RTE_HASH_BUCKET_ENTRIES) ||
+			(entries > RTE_HASH_ENTRIES_MAX)), -EINVAL);
+
+	__hash_rw_writer_lock(h);
+	if (rte_atomic_load_explicit(&h->resize->old,
+				rte_memory_order_relaxed) != NULL)
+		ret = -EBUSY;
+	else if ((uint32_t)rte_hash_count(h) > entries)
+		ret = -ENOSPC;
+	else {
+		ret = resize_start(h, entries);
+		if (ret == 0)
+			h->resize->min_entries = entries;
+	}
+	__hash_rw_writer_unlock(h);
+
+	return ret;
+}
+
+int
+rte_hash_resize_step(struct rte_hash *h, uint32_t max_buckets)
+{
+	int ret = 0;
+
+	RETURN_IF_TRUE(((h == NULL) || (h->resize == NULL)), -EINVAL);
+
+	__hash_rw_writer_lock(h);
+	if (rte_atomic_load_explicit(&h->resize->old,
+				rte_memory_order_relaxed) != NULL)
+		ret = resize_migrate(h, max_buckets);
+	__hash_rw_writer_unlock(h);
+
+	return ret;
+}
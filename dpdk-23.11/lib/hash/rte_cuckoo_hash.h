@@ -213,6 +213,8 @@ struct rte_hash {
 	uint32_t bucket_bitmask;
 	/**< Bitmask for getting bucket index from hash signature. */
 	uint32_t key_entry_size;         /**< Size of each key entry. */
+	uint32_t age_off;
+	/**< Offset of the timestamp in each key entry, 0 without aging. */
 
 	void *key_store;                /**< Table storing all keys and data */
 	struct rte_hash_bucket *buckets;
@@ -231,8 +233,33 @@ struct rte_hash {
 	uint32_t *ext_bkt_to_free;
 	RTE_ATOMIC(uint32_t) *tbl_chng_cnt;
 	/**< Indicates if the hash table changed from last read. */
+	struct rte_hash_resize *resize;
+	/**< Resize state, only set with RTE_HASH_EXTRA_FLAGS_RESIZABLE. */
+	RTE_ATOMIC(uint64_t) age_clock;
+	/**< Time stamped on used entries, advanced by rte_hash_age(). */
 } __rte_cache_aligned;
 
+/**
+ * State of a table created with RTE_HASH_EXTRA_FLAGS_RESIZABLE.
+ * The handle given to the application only holds the parameters and
+ * this state: keys live in unlisted tables, cur and, while a resize
+ * is running, old. In that handle, hash_rcu_cfg is the configuration
+ * given to every table and dq holds the tables waiting to be freed.
+ */
+struct rte_hash_resize {
+	RTE_ATOMIC(struct rte_hash *) cur;
+	/**< Table all keys are added to. */
+	RTE_ATOMIC(struct rte_hash *) old;
+	/**< Table being drained into cur, NULL when no resize is running. */
+	RTE_ATOMIC(uint32_t) chng_cnt;
+	/**< Incremented each time a key moves from old to cur. */
+	uint32_t next_bkt;      /**< Next bucket of old to migrate. */
+	uint32_t old_keys;      /**< Number of keys still in old. */
+	uint32_t min_entries;   /**< Automatic shrinking stops at this size. */
+	uint32_t nb_ops;        /**< Writer calls, paces the load checks. */
+	struct rte_hash_parameters params; /**< Template for new tables. */
+};
+
 struct queue_node {
 	struct rte_hash_bucket *bkt; /* Current bucket on the bfs search */
 	uint32_t cur_bkt_idx;
@@ -244,4 +271,13 @@ struct queue_node {
 /** @internal Default RCU defer queue entries to reclaim in one go. */
 #define RTE_HASH_RCU_DQ_RECLAIM_MAX	16
 
+/** @internal Buckets a resizable table migrates on each add or delete. */
+#define RTE_HASH_RESIZE_BKTS_PER_OP	4
+
+/** @internal Writer calls between two load checks of a resizable table. */
+#define RTE_HASH_RESIZE_CHECK_PERIOD	32
+
+/** @internal Retired tables of a resizable table waiting for readers. */
+#define RTE_HASH_RESIZE_DQ_SIZE		8
+
 #endif
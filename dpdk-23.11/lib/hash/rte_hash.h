@@ -14,6 +14,7 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include <rte_compat.h>
 #include <rte_rcu_qsbr.h>
 
 #ifdef __cplusplus
@@ -55,6 +56,31 @@ extern "C" {
  */
 #define RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF 0x20
 
+/** Flag to let the table grow and shrink with the number of keys.
+ * A resize allocates a new table and moves the keys over incrementally,
+ * a few buckets on each add or delete, so that no single call pays for
+ * the whole copy. Lookups keep working while keys move. Can be combined
+ * with RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF, in which case the table
+ * only resizes once an RCU QSBR variable has been attached with
+ * rte_hash_rcu_qsbr_add(). Cannot be combined with
+ * RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY or
+ * RTE_HASH_EXTRA_FLAGS_NO_FREE_ON_DEL.
+ * Positions returned by the add/lookup/iterate APIs are only valid until
+ * the next resize, use the _data APIs to associate user data with keys.
+ * Keys are rehashed with the hash function of the table when they move,
+ * so precomputed hash values given to the _with_hash APIs must come from
+ * rte_hash_hash().
+ */
+#define RTE_HASH_EXTRA_FLAGS_RESIZABLE 0x40
+
+/** Flag to keep a last use timestamp with each entry, for aging.
+ * The timestamp is set when the key is added and refreshed by every
+ * lookup hitting it; rte_hash_age() deletes the entries not used for
+ * longer than a given time. Cannot be combined with
+ * RTE_HASH_EXTRA_FLAGS_RESIZABLE.
+ */
+#define RTE_HASH_EXTRA_FLAGS_AGING 0x80
+
 /**
  * The type of hash value of a key.
  * It should be a value of at least 32bit with fully random pattern.
@@ -318,6 +344,46 @@ rte_hash_add_key(const struct rte_hash *h, const void *key);
 int32_t
 rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key, hash_sig_t sig);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Add a burst of keys to an existing hash table.
+ * The hash of every key is computed and both candidate buckets are
+ * prefetched for the whole burst before the first insertion,
+ * so the memory latency of the burst is paid once.
+ * Keys are then inserted in order, the result is the same as adding
+ * them one by one: a key appearing several times in the burst
+ * is stored once, with the data of its last occurrence.
+ * Thread safety is the same as for rte_hash_add_key_data().
+ * With lock based concurrency, the writer lock is taken once for the
+ * whole burst, so readers may wait for up to a burst of insertions.
+ *
+ * @param h
+ *   Hash table to add the keys to.
+ * @param keys
+ *   A pointer to a list of keys to add.
+ * @param sig
+ *   A pointer to a list of precomputed hash values for the keys,
+ *   or NULL to compute them with rte_hash_hash().
+ * @param data
+ *   A pointer to a list of data to add with the keys, or NULL.
+ * @param num_keys
+ *   How many keys are in the keys list (at most RTE_HASH_LOOKUP_BULK_MAX).
+ * @param positions
+ *   Output containing, for each key, the value that rte_hash_add_key()
+ *   would have returned: the key position or a negative errno.
+ *   Can be NULL.
+ * @return
+ *   - -EINVAL if the parameters are invalid.
+ *   - The number of keys added or updated.
+ */
+__rte_experimental
+int
+rte_hash_add_bulk(const struct rte_hash *h, const void **keys,
+		const hash_sig_t *sig, void *data[], uint32_t num_keys,
+		int32_t *positions);
+
 /**
  * Remove a key from an existing hash table.
  * This operation is not multi-thread safe
@@ -674,6 +740,101 @@ rte_hash_iterate(const struct rte_hash *h, const void **key, void **data, uint32
  */
 int rte_hash_rcu_qsbr_add(struct rte_hash *h, struct rte_hash_rcu_config *cfg);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Start resizing a table created with RTE_HASH_EXTRA_FLAGS_RESIZABLE.
+ * A new table of the requested size is allocated and becomes the target
+ * of all additions; keys are then moved over by the following add and
+ * delete calls, or by rte_hash_resize_step(). The size also becomes the
+ * lower bound for automatic shrinking.
+ * This operation must be called from a writer thread.
+ *
+ * @param h
+ *   Hash table to resize.
+ * @param entries
+ *   New number of entries.
+ * @return
+ *   - 0 if the resize started.
+ *   - -EINVAL if the parameters are invalid or the table is not resizable.
+ *   - -EBUSY if a resize is still in progress.
+ *   - -ENOSPC if the table holds more keys than entries.
+ *   - -ENOTSUP if lock free concurrency is enabled and no RCU QSBR
+ *     variable is attached.
+ *   - -ENOMEM if the new table could not be allocated.
+ */
+__rte_experimental
+int
+rte_hash_resize(struct rte_hash *h, uint32_t entries);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Move the keys of up to max_buckets buckets of an ongoing resize, e.g.
+ * to finish it from a control thread while writers are idle.
+ * This operation must be called from a writer thread.
+ *
+ * @param h
+ *   Hash table created with RTE_HASH_EXTRA_FLAGS_RESIZABLE.
+ * @param max_buckets
+ *   Maximum number of buckets to migrate.
+ * @return
+ *   - Number of buckets still to migrate, 0 if no resize is in progress.
+ *   - -EINVAL if the parameters are invalid or the table is not resizable.
+ */
+__rte_experimental
+int
+rte_hash_resize_step(struct rte_hash *h, uint32_t max_buckets);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Delete the entries of a table created with RTE_HASH_EXTRA_FLAGS_AGING
+ * that have not been added or looked up for longer than ttl.
+ * The table is scanned incrementally: each call checks at most
+ * max_buckets buckets starting at *next and deletes at most max_expired
+ * entries, so a service core can age a large table in small time slices.
+ * Adds stamp entries with the timer. Lookups read a clock advanced by
+ * this function instead, so the age of an entry last looked up is only
+ * accurate to the interval between two calls; ttl should be much larger
+ * than it.
+ * Entries are deleted as with rte_hash_del_key(): if an RCU QSBR variable
+ * is attached, their resources are reclaimed once the readers quiesce,
+ * and each call also reclaims pending resources of the defer queue.
+ * If neither RTE_HASH_EXTRA_FLAGS_NO_FREE_ON_DEL nor lock free
+ * concurrency is enabled, the key index is freed on delete: the returned
+ * positions can then be reused by the next add.
+ * This operation must be called from a writer thread.
+ *
+ * @param h
+ *   Hash table created with RTE_HASH_EXTRA_FLAGS_AGING.
+ * @param ttl
+ *   Time in timer cycles (see rte_get_timer_hz()) after which an unused
+ *   entry expires.
+ * @param next
+ *   Bucket to start from, 0 for the first call. Updated to the bucket
+ *   to continue from, it is back to 0 once the whole table was scanned.
+ * @param max_buckets
+ *   Maximum number of buckets to scan.
+ * @param positions
+ *   Output containing the positions of the deleted entries.
+ * @param data
+ *   Output containing the data of the deleted entries, can be NULL.
+ * @param max_expired
+ *   Size of the output arrays, must not be 0.
+ * @return
+ *   - Number of entries deleted.
+ *   - -EINVAL if the parameters are invalid or the table has no aging.
+ */
+__rte_experimental
+int
+rte_hash_age(struct rte_hash *h, uint64_t ttl, uint32_t *next,
+	     uint32_t max_buckets, int32_t positions[], void *data[],
+	     uint32_t max_expired);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,6 +6,9 @@
 
 #include <rte_thash.h>
 #include <rte_tailq.h>
+#include <rte_cpuflags.h>
+#include <rte_ether.h>
+#include <rte_mbuf.h>
 #include <rte_random.h>
 #include <rte_memcpy.h>
 #include <rte_errno.h>
@@ -13,8 +16,11 @@
 #include <rte_log.h>
 #include <rte_malloc.h>
 
+#include "thash_softrss.h"
+
 #define THASH_NAME_LEN		64
 #define TOEPLITZ_HASH_LEN	32
+#define SOFTRSS_BURST		32
 
 #define RETA_SZ_IN_RANGE(reta_sz)	((reta_sz >= RTE_THASH_RETA_SZ_MIN) &&\
 					(reta_sz <= RTE_THASH_RETA_SZ_MAX))
@@ -826,3 +832,234 @@ rte_thash_adjust_tuple(struct rte_thash_ctx *ctx,
 
 	return ret;
 }
+
+static void
+thash_softrss_scalar(const struct rte_thash_softrss *ctx, uint8_t *tuple[],
+		uint32_t len, uint32_t hash[], uint32_t n)
+{
+	uint32_t tmp_tuple[THASH_SOFTRSS_TUPLE_MAX / 4];
+	uint32_t i, j;
+
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < len / 4; j++)
+			tmp_tuple[j] = rte_be_to_cpu_32(
+				*(unaligned_uint32_t *)&tuple[i][j * 4]);
+		hash[i] = rte_softrss_be(tmp_tuple, len / 4,
+			(const uint8_t *)ctx->key_be);
+	}
+}
+
+static thash_softrss_fn
+softrss_get_fn(enum rte_thash_softrss_alg alg)
+{
+	switch (alg) {
+	case RTE_THASH_SOFTRSS_SCALAR:
+		return thash_softrss_scalar;
+	case RTE_THASH_SOFTRSS_CLMUL:
+#ifdef CC_THASH_PCLMULQDQ_SUPPORT
+		if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_PCLMULQDQ) &&
+				rte_vect_get_max_simd_bitwidth() >=
+				RTE_VECT_SIMD_128)
+			return thash_softrss_clmul;
+#endif
+		return NULL;
+	case RTE_THASH_SOFTRSS_GFNI:
+#ifdef CC_THASH_GFNI_SUPPORT
+		if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512F) &&
+				rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512BW) &&
+				rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512DQ) &&
+				rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512VL) &&
+				rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512VBMI) &&
+				rte_cpu_get_flag_enabled(RTE_CPUFLAG_GFNI) &&
+				rte_vect_get_max_simd_bitwidth() >=
+				RTE_VECT_SIMD_512)
+			return thash_softrss_gfni;
+#endif
+		return NULL;
+	}
+
+	return NULL;
+}
+
+struct rte_thash_softrss *
+rte_thash_softrss_create(const uint8_t *rss_key, uint32_t key_len,
+	uint32_t flags, int socket_id)
+{
+	struct rte_thash_softrss *ctx;
+	uint32_t c, j, b;
+
+	if ((rss_key == NULL) || (key_len < RTE_THASH_SOFTRSS_KEY_LEN_MIN) ||
+			(flags & ~RTE_THASH_SOFTRSS_L4)) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	ctx = rte_zmalloc_socket(NULL, sizeof(*ctx), RTE_CACHE_LINE_SIZE,
+		socket_id);
+	if (ctx == NULL) {
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	ctx->flags = flags;
+	memcpy(ctx->key, rss_key, RTE_MIN(key_len,
+		(uint32_t)THASH_SOFTRSS_KEY_LEN));
+	rte_convert_rss_key((const uint32_t *)ctx->key, ctx->key_be,
+		THASH_SOFTRSS_KEY_LEN);
+	rte_thash_complete_matrix(ctx->matrices, ctx->key,
+		THASH_SOFTRSS_KEY_LEN);
+
+	/* bit j of the window of chunk c is bit 64 * c + j of the key */
+	for (c = 0; c < THASH_SOFTRSS_CHUNKS; c++) {
+		for (j = 0; j < 96; j++) {
+			b = c * 64 + j;
+			if (ctx->key[b / CHAR_BIT] &
+					(1 << (CHAR_BIT - 1 - b % CHAR_BIT)))
+				ctx->clmul_key[c][j / 64] |= 1ULL << (j % 64);
+		}
+	}
+
+	ctx->hash_fn = softrss_get_fn(RTE_THASH_SOFTRSS_GFNI);
+	if (ctx->hash_fn == NULL)
+		ctx->hash_fn = softrss_get_fn(RTE_THASH_SOFTRSS_CLMUL);
+	if (ctx->hash_fn == NULL)
+		ctx->hash_fn = thash_softrss_scalar;
+
+	return ctx;
+}
+
+int
+rte_thash_softrss_set_alg(struct rte_thash_softrss *ctx,
+	enum rte_thash_softrss_alg alg)
+{
+	thash_softrss_fn fn;
+
+	if ((ctx == NULL) || (alg > RTE_THASH_SOFTRSS_GFNI))
+		return -EINVAL;
+
+	fn = softrss_get_fn(alg);
+	if (fn == NULL)
+		return -ENOTSUP;
+
+	ctx->hash_fn = fn;
+	return 0;
+}
+
+void
+rte_thash_softrss_free(struct rte_thash_softrss *ctx)
+{
+	rte_free(ctx);
+}
+
+/*
+ * Extract the hashed tuple of a packet, in network byte order.
+ * Returns the tuple length in bytes, 0 if the packet is not hashed.
+ */
+static uint32_t
+softrss_parse(const struct rte_mbuf *m, uint32_t flags, uint8_t *tuple)
+{
+	const struct rte_ether_hdr *eth;
+	const struct rte_vlan_hdr *vlan;
+	const struct rte_ipv4_hdr *ipv4;
+	const struct rte_ipv6_hdr *ipv6;
+	uint32_t off, len, data_len;
+	uint16_t proto;
+	uint8_t l4_proto;
+	int i;
+
+	data_len = rte_pktmbuf_data_len(m);
+	if (data_len < sizeof(*eth))
+		return 0;
+
+	eth = rte_pktmbuf_mtod(m, const struct rte_ether_hdr *);
+	proto = eth->ether_type;
+	off = sizeof(*eth);
+
+	for (i = 0; i < 2 &&
+			(proto == RTE_BE16(RTE_ETHER_TYPE_VLAN) ||
+			proto == RTE_BE16(RTE_ETHER_TYPE_QINQ)); i++) {
+		if (data_len < off + sizeof(*vlan))
+			return 0;
+		vlan = rte_pktmbuf_mtod_offset(m, const struct rte_vlan_hdr *,
+			off);
+		proto = vlan->eth_proto;
+		off += sizeof(*vlan);
+	}
+
+	if (proto == RTE_BE16(RTE_ETHER_TYPE_IPV4)) {
+		if (data_len < off + sizeof(*ipv4))
+			return 0;
+		ipv4 = rte_pktmbuf_mtod_offset(m, const struct rte_ipv4_hdr *,
+			off);
+		memcpy(tuple, &ipv4->src_addr, 2 * sizeof(ipv4->src_addr));
+		len = 2 * sizeof(ipv4->src_addr);
+		if (ipv4->fragment_offset & RTE_BE16(RTE_IPV4_HDR_MF_FLAG |
+				RTE_IPV4_HDR_OFFSET_MASK))
+			return len;
+		l4_proto = ipv4->next_proto_id;
+		off += rte_ipv4_hdr_len(ipv4);
+	} else if (proto == RTE_BE16(RTE_ETHER_TYPE_IPV6)) {
+		if (data_len < off + sizeof(*ipv6))
+			return 0;
+		ipv6 = rte_pktmbuf_mtod_offset(m, const struct rte_ipv6_hdr *,
+			off);
+		memcpy(tuple, ipv6->src_addr,
+			sizeof(ipv6->src_addr) + sizeof(ipv6->dst_addr));
+		len = sizeof(ipv6->src_addr) + sizeof(ipv6->dst_addr);
+		l4_proto = ipv6->proto;
+		off += sizeof(*ipv6);
+	} else
+		return 0;
+
+	if ((flags & RTE_THASH_SOFTRSS_L4) &&
+			(l4_proto == IPPROTO_TCP || l4_proto == IPPROTO_UDP ||
+			l4_proto == IPPROTO_SCTP) &&
+			(data_len >= off + 2 * sizeof(rte_be16_t))) {
+		/* source and destination ports lead all three headers */
+		memcpy(tuple + len, rte_pktmbuf_mtod_offset(m, uint8_t *, off),
+			2 * sizeof(rte_be16_t));
+		len += 2 * sizeof(rte_be16_t);
+	}
+
+	return len;
+}
+
+uint16_t
+rte_thash_softrss_bulk(const struct rte_thash_softrss *ctx,
+	struct rte_mbuf **pkts, uint16_t nb_pkts)
+{
+	uint8_t tuples[SOFTRSS_BURST][THASH_SOFTRSS_TUPLE_MAX] __rte_aligned(8);
+	uint8_t *tuple_ptrs[SOFTRSS_BURST];
+	uint32_t hash[SOFTRSS_BURST];
+	uint16_t idx[SOFTRSS_BURST];
+	uint32_t i, j, n, len, max_len;
+	uint16_t nb_hashed = 0;
+
+	for (i = 0; i < nb_pkts; i += SOFTRSS_BURST) {
+		n = 0;
+		max_len = 0;
+		for (j = i; j < RTE_MIN(i + SOFTRSS_BURST, nb_pkts); j++) {
+			memset(tuples[n], 0, sizeof(tuples[n]));
+			len = softrss_parse(pkts[j], ctx->flags, tuples[n]);
+			if (len == 0)
+				continue;
+			max_len = RTE_MAX(max_len, len);
+			tuple_ptrs[n] = tuples[n];
+			idx[n++] = j;
+		}
+		if (n == 0)
+			continue;
+
+		/* zero padding of shorter tuples does not change their hash */
+		ctx->hash_fn(ctx, tuple_ptrs, RTE_ALIGN_CEIL(max_len, 8),
+			hash, n);
+
+		for (j = 0; j < n; j++) {
+			pkts[idx[j]]->hash.rss = hash[j];
+			pkts[idx[j]]->ol_flags |= RTE_MBUF_F_RX_RSS_HASH;
+		}
+		nb_hashed += n;
+	}
+
+	return nb_hashed;
+}
@@ -22,6 +22,7 @@ extern "C" {
 #include <stdint.h>
 
 #include <rte_byteorder.h>
+#include <rte_compat.h>
 #include <rte_ip.h>
 #include <rte_common.h>
 #include <rte_thash_gfni.h>
@@ -447,6 +448,111 @@ rte_thash_adjust_tuple(struct rte_thash_ctx *ctx,
 	uint32_t desired_value, unsigned int attempts,
 	rte_thash_check_tuple_t fn, void *userdata);
 
+/** Include the L4 source and destination ports in the software RSS hash */
+#define RTE_THASH_SOFTRSS_L4		0x1
+
+/** Minimum RSS key length accepted by rte_thash_softrss_create() */
+#define RTE_THASH_SOFTRSS_KEY_LEN_MIN	40
+
+/** Implementations of the bulk software RSS hash */
+enum rte_thash_softrss_alg {
+	RTE_THASH_SOFTRSS_SCALAR,	/**< Generic rte_softrss_be() */
+	RTE_THASH_SOFTRSS_CLMUL,	/**< Carry-less multiplication */
+	RTE_THASH_SOFTRSS_GFNI,		/**< AVX512 and GFNI */
+};
+
+struct rte_mbuf;
+
+/** Software RSS context */
+struct rte_thash_softrss;
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Create a context to compute the RSS hash of received packets in
+ * software, for ports without RSS or queues fed by a single queue NIC.
+ * The fastest implementation supported by the CPU is selected.
+ *
+ * @param rss_key
+ *  Pointer to the Toeplitz hash key, as programmed into the NIC.
+ * @param key_len
+ *  Length of the key in bytes, at least RTE_THASH_SOFTRSS_KEY_LEN_MIN.
+ *  Bytes beyond what the longest tuple uses are ignored.
+ * @param flags
+ *  RTE_THASH_SOFTRSS_* flags.
+ * @param socket_id
+ *  Socket to allocate the context on, or SOCKET_ID_ANY.
+ * @return
+ *  A pointer to the context on success, NULL otherwise with rte_errno set:
+ *  - EINVAL - invalid parameter passed to function
+ *  - ENOMEM - no appropriate memory area found
+ */
+__rte_experimental
+struct rte_thash_softrss *
+rte_thash_softrss_create(const uint8_t *rss_key, uint32_t key_len,
+	uint32_t flags, int socket_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Force the implementation used by a software RSS context.
+ *
+ * @param ctx
+ *  Software RSS context
+ * @param alg
+ *  Implementation to use
+ * @return
+ *  0 on success
+ *  -ENOTSUP if the implementation is not supported by the build or the CPU
+ *  -EINVAL if the parameters are invalid
+ */
+__rte_experimental
+int
+rte_thash_softrss_set_alg(struct rte_thash_softrss *ctx,
+	enum rte_thash_softrss_alg alg);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Free a software RSS context.
+ *
+ * @param ctx
+ *  Software RSS context, may be NULL.
+ */
+__rte_experimental
+void
+rte_thash_softrss_free(struct rte_thash_softrss *ctx);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Compute the RSS hash of a burst of packets.
+ * The IPv4 or IPv6 source and destination addresses are hashed, after
+ * up to two VLAN tags. With RTE_THASH_SOFTRSS_L4, the TCP, UDP or SCTP
+ * ports of non fragmented packets are hashed as well, the same way as
+ * the RTE_ETH_RSS_NONFRAG_* NIC types.
+ * The hash is stored in hash.rss of each IP packet, and
+ * RTE_MBUF_F_RX_RSS_HASH is set; other packets are left untouched.
+ * Headers must be in the first segment.
+ *
+ * @param ctx
+ *  Software RSS context
+ * @param pkts
+ *  Array of packets
+ * @param nb_pkts
+ *  Number of packets
+ * @return
+ *  Number of packets hashed.
+ */
+__rte_experimental
+uint16_t
+rte_thash_softrss_bulk(const struct rte_thash_softrss *ctx,
+	struct rte_mbuf **pkts, uint16_t nb_pkts);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _THASH_SOFTRSS_H_
+#define _THASH_SOFTRSS_H_
+
+/*
+ * Different implementations of the software RSS hash
+ */
+
+#include <stdint.h>
+
+/* Longest tuple: IPv6 addresses and L4 ports, padded to 64-bit chunks */
+#define THASH_SOFTRSS_TUPLE_MAX		40
+#define THASH_SOFTRSS_CHUNKS		(THASH_SOFTRSS_TUPLE_MAX / 8)
+/* The hash of the last tuple byte uses the 4 following key bytes */
+#define THASH_SOFTRSS_KEY_LEN		(THASH_SOFTRSS_TUPLE_MAX + 4)
+
+struct rte_thash_softrss;
+
+/*
+ * Hash n tuples of len bytes, in network byte order and zero padded up
+ * to a multiple of 8 bytes.
+ */
+typedef void (*thash_softrss_fn)(const struct rte_thash_softrss *ctx,
+		uint8_t *tuple[], uint32_t len, uint32_t hash[], uint32_t n);
+
+struct rte_thash_softrss {
+	thash_softrss_fn hash_fn;	/**< Selected implementation */
+	uint32_t flags;			/**< RTE_THASH_SOFTRSS_* */
+	uint32_t key_be[THASH_SOFTRSS_KEY_LEN / 4];
+	/**< Key converted for rte_softrss_be() */
+	uint64_t clmul_key[THASH_SOFTRSS_CHUNKS][2];
+	/**< Bit reversed 96-bit window of the key for each tuple chunk */
+	uint64_t matrices[THASH_SOFTRSS_KEY_LEN];
+	/**< Key converted for rte_thash_gfni_bulk() */
+	uint8_t key[THASH_SOFTRSS_KEY_LEN];	/**< Original key */
+};
+
+/* PCLMULQDQ */
+
+void
+thash_softrss_clmul(const struct rte_thash_softrss *ctx, uint8_t *tuple[],
+		uint32_t len, uint32_t hash[], uint32_t n);
+
+/* AVX512 and GFNI */
+
+void
+thash_softrss_gfni(const struct rte_thash_softrss *ctx, uint8_t *tuple[],
+		uint32_t len, uint32_t hash[], uint32_t n);
+
+#endif /* _THASH_SOFTRSS_H_ */
@@ -0,0 +1,14 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <rte_common.h>
+#include <rte_thash_gfni.h>
+
+#include "thash_softrss.h"
+
+void
+thash_softrss_gfni(const struct rte_thash_softrss *ctx, uint8_t *tuple[],
+		uint32_t len, uint32_t hash[], uint32_t n)
+{
+	rte_thash_gfni_bulk(ctx->matrices, len, tuple, hash, n);
+}
@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_byteorder.h>
+
+#include "thash_softrss.h"
+
+#include <x86intrin.h>
+
+/*
+ * Toeplitz hash with carry-less multiplication.
+ *
+ * The hash XORs, for each set bit i of the tuple, the 32-bit window of
+ * the key starting at bit i. For a 64-bit chunk of the tuple, loaded
+ * big endian so that its first bit is the MSB, this is the carry-less
+ * product of the chunk with the following 96 bits of the key stored bit
+ * reversed: bit 63 + t of the product is the window sum for bit 31 - t
+ * of the hash. Products of all chunks are XORed and the 32 bits are
+ * reversed once at the end.
+ */
+
+static inline uint32_t
+bitrev32(uint32_t v)
+{
+	v = ((v >> 1) & 0x55555555) | ((v & 0x55555555) << 1);
+	v = ((v >> 2) & 0x33333333) | ((v & 0x33333333) << 2);
+	v = ((v >> 4) & 0x0f0f0f0f) | ((v & 0x0f0f0f0f) << 4);
+	return rte_bswap32(v);
+}
+
+void
+thash_softrss_clmul(const struct rte_thash_softrss *ctx, uint8_t *tuple[],
+		uint32_t len, uint32_t hash[], uint32_t n)
+{
+	const uint32_t nb_chunks = RTE_ALIGN_CEIL(len, 8) / 8;
+	__m128i key[THASH_SOFTRSS_CHUNKS];
+	__m128i acc, chunk;
+	uint64_t lo, hi, x;
+	uint32_t i, c;
+
+	for (c = 0; c < nb_chunks; c++)
+		key[c] = _mm_loadu_si128((const __m128i *)ctx->clmul_key[c]);
+
+	for (i = 0; i < n; i++) {
+		acc = _mm_setzero_si128();
+		for (c = 0; c < nb_chunks; c++) {
+			memcpy(&x, tuple[i] + c * 8, sizeof(x));
+			chunk = _mm_cvtsi64_si128(rte_be_to_cpu_64(x));
+			acc = _mm_xor_si128(acc,
+				_mm_clmulepi64_si128(chunk, key[c], 0x00));
+			acc = _mm_xor_si128(acc, _mm_slli_si128(
+				_mm_clmulepi64_si128(chunk, key[c], 0x10), 8));
+		}
+		lo = _mm_cvtsi128_si64(acc);
+		hi = _mm_extract_epi64(acc, 1);
+		hash[i] = bitrev32((uint32_t)((lo >> 63) | (hi << 1)));
+	}
+}
@@ -11,6 +11,7 @@
  */
 
 #include <rte_ip_frag.h>
+#include <rte_spinlock.h>
 
 enum {
 	IP_LAST_FRAG_IDX,    /* index of last fragment */
@@ -85,4 +86,16 @@ struct rte_ip_frag_tbl {
 	__extension__ struct ip_frag_pkt pkt[]; /* hash table. */
 };
 
+/* shard of a shared fragmentation table */
+struct ip_frag_shard {
+	rte_spinlock_t lock;         /* protects the shard table. */
+	struct rte_ip_frag_tbl *tbl; /* fragmentation table of the shard. */
+} __rte_cache_aligned;
+
+/* fragmentation table shared by several lcores */
+struct rte_ip_frag_shared_tbl {
+	uint32_t nb_shards;                    /* number of shards. */
+	__extension__ struct ip_frag_shard shard[]; /* shards. */
+};
+
 #endif /* _IP_REASSEMBLY_H_ */
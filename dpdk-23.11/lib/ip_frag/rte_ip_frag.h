@@ -19,6 +19,7 @@ extern "C" {
 #include <stdint.h>
 #include <stdio.h>
 
+#include <rte_compat.h>
 #include <rte_config.h>
 #include <rte_malloc.h>
 #include <rte_memory.h>
@@ -291,6 +292,195 @@ void
 rte_ip_frag_table_del_expired_entries(struct rte_ip_frag_tbl *tbl,
 	struct rte_ip_frag_death_row *dr, uint64_t tms);
 
+/** Fragmentation table shared by several lcores */
+struct rte_ip_frag_shared_tbl;
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Create a new IP fragmentation table, which can be used concurrently by
+ * several lcores. This allows reassembling datagrams whose fragments are
+ * received on different queues, e.g. because RSS only spreads the first
+ * fragment on the L4 ports.
+ *
+ * The table is split into shards, each one being a fragmentation table with
+ * its own lock and LRU list. All the fragments of a datagram go to the same
+ * shard, so lcores processing different datagrams rarely contend.
+ *
+ * @param nb_shards
+ *   Number of shards, at least the number of lcores using the table.
+ * @param bucket_num
+ *   Number of buckets in the hash table, split between the shards.
+ * @param bucket_entries
+ *   Number of entries per bucket (e.g. hash associativity).
+ *   Should be power of two.
+ * @param max_entries
+ *   Maximum number of entries that could be stored in the table,
+ *   split between the shards.
+ * @param max_cycles
+ *   Maximum TTL in cycles for each fragmented packet.
+ * @param socket_id
+ *   The *socket_id* argument is the socket identifier in the case of
+ *   NUMA. The value can be *SOCKET_ID_ANY* if there is no NUMA constraints.
+ * @return
+ *   The pointer to the new allocated fragmentation table, on success. NULL on error.
+ */
+__rte_experimental
+struct rte_ip_frag_shared_tbl *
+rte_ip_frag_shared_table_create(uint32_t nb_shards, uint32_t bucket_num,
+		uint32_t bucket_entries, uint32_t max_entries,
+		uint64_t max_cycles, int socket_id);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Free allocated shared IP fragmentation table.
+ *
+ * @param tbl
+ *   Fragmentation table to free.
+ */
+__rte_experimental
+void
+rte_ip_frag_shared_table_destroy(struct rte_ip_frag_shared_tbl *tbl);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Reassemble fragmented IPv4 packets using a shared table.
+ * Same as rte_ipv4_frag_reassemble_packet(), but may be called by several
+ * lcores at the same time, each one with its own death row.
+ *
+ * @param tbl
+ *   Table where to lookup/add the fragmented packet.
+ * @param dr
+ *   Death row to free buffers to, private to the calling lcore.
+ * @param mb
+ *   Incoming mbuf with IPv4 fragment.
+ * @param tms
+ *   Fragment arrival timestamp.
+ * @param ip_hdr
+ *   Pointer to the IPV4 header inside the fragment.
+ * @return
+ *   Pointer to mbuf for reassembled packet, or NULL if:
+ *   - an error occurred.
+ *   - not all fragments of the packet are collected yet.
+ */
+__rte_experimental
+struct rte_mbuf *
+rte_ipv4_frag_shared_reassemble_packet(struct rte_ip_frag_shared_tbl *tbl,
+		struct rte_ip_frag_death_row *dr,
+		struct rte_mbuf *mb, uint64_t tms, struct rte_ipv4_hdr *ip_hdr);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Reassemble fragmented IPv6 packets using a shared table.
+ * Same as rte_ipv6_frag_reassemble_packet(), but may be called by several
+ * lcores at the same time, each one with its own death row.
+ *
+ * @param tbl
+ *   Table where to lookup/add the fragmented packet.
+ * @param dr
+ *   Death row to free buffers to, private to the calling lcore.
+ * @param mb
+ *   Incoming mbuf with IPv6 fragment.
+ * @param tms
+ *   Fragment arrival timestamp.
+ * @param ip_hdr
+ *   Pointer to the IPv6 header.
+ * @param frag_hdr
+ *   Pointer to the IPv6 fragment extension header.
+ * @return
+ *   Pointer to mbuf for reassembled packet, or NULL if:
+ *   - an error occurred.
+ *   - not all fragments of the packet are collected yet.
+ */
+__rte_experimental
+struct rte_mbuf *
+rte_ipv6_frag_shared_reassemble_packet(struct rte_ip_frag_shared_tbl *tbl,
+		struct rte_ip_frag_death_row *dr,
+		struct rte_mbuf *mb, uint64_t tms, struct rte_ipv6_hdr *ip_hdr,
+		struct rte_ipv6_fragment_ext *frag_hdr);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Delete expired fragments from a shared table.
+ * The shards being processed by another lcore are skipped, so that
+ * several lcores can call this function without waiting for each other.
+ *
+ * @param tbl
+ *   Table to delete expired fragments from
+ * @param dr
+ *   Death row to free buffers to, private to the calling lcore.
+ * @param tms
+ *   Current timestamp
+ */
+__rte_experimental
+void
+rte_ip_frag_shared_table_del_expired_entries(struct rte_ip_frag_shared_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, uint64_t tms);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Dump shared fragmentation table statistics to file, for each shard.
+ *
+ * @param f
+ *   File to dump statistics to
+ * @param tbl
+ *   Fragmentation table to dump statistics from
+ */
+__rte_experimental
+void
+rte_ip_frag_shared_table_statistics_dump(FILE *f,
+	const struct rte_ip_frag_shared_tbl *tbl);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Hash the reassembly key of an IPv4 fragment: source and destination
+ * addresses and packet ID. All the fragments of a datagram have the same
+ * hash, which can be used to hand them over to the same lcore,
+ * e.g. through a ring per lcore.
+ *
+ * @param ip_hdr
+ *   Pointer to the IPV4 header inside the fragment.
+ * @return
+ *   Hash value of the fragment.
+ */
+__rte_experimental
+uint32_t
+rte_ipv4_frag_hash(const struct rte_ipv4_hdr *ip_hdr);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Hash the reassembly key of an IPv6 fragment: source and destination
+ * addresses and fragment identification. All the fragments of a datagram
+ * have the same hash, which can be used to hand them over to the same
+ * lcore, e.g. through a ring per lcore.
+ *
+ * @param ip_hdr
+ *   Pointer to the IPv6 header.
+ * @param frag_hdr
+ *   Pointer to the IPv6 fragment extension header.
+ * @return
+ *   Hash value of the fragment.
+ */
+__rte_experimental
+uint32_t
+rte_ipv6_frag_hash(const struct rte_ipv6_hdr *ip_hdr,
+	const struct rte_ipv6_fragment_ext *frag_hdr);
+
 /**@{@name Obsolete macros, kept here for compatibility reasons.
  * Will be deprecated/removed in future DPDK releases.
  */
@@ -0,0 +1,166 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include <rte_hash_crc.h>
+#include <rte_log.h>
+
+#include "ip_frag_common.h"
+
+/*
+ * Seed of the fragment hash, different from the bucket hash one,
+ * so that the buckets used in a shard don't depend on the shard.
+ */
+#define	IP_FRAG_SHARD_SEED	0x5bd1e995
+
+uint32_t
+rte_ipv4_frag_hash(const struct rte_ipv4_hdr *ip_hdr)
+{
+	uint32_t v;
+
+	v = rte_hash_crc_4byte(ip_hdr->src_addr, IP_FRAG_SHARD_SEED);
+	v = rte_hash_crc_4byte(ip_hdr->dst_addr, v);
+	return rte_hash_crc_4byte(ip_hdr->packet_id, v);
+}
+
+uint32_t
+rte_ipv6_frag_hash(const struct rte_ipv6_hdr *ip_hdr,
+	const struct rte_ipv6_fragment_ext *frag_hdr)
+{
+	uint32_t v;
+
+	/* source and destination addresses are contiguous */
+	v = rte_hash_crc(ip_hdr->src_addr, 2 * sizeof(ip_hdr->src_addr),
+		IP_FRAG_SHARD_SEED);
+	return rte_hash_crc_4byte(frag_hdr->id, v);
+}
+
+/* select the shard of a fragment from the upper bits of its hash */
+static inline struct ip_frag_shard *
+ip_frag_shard_get(struct rte_ip_frag_shared_tbl *tbl, uint32_t hash)
+{
+	return &tbl->shard[((uint64_t)hash * tbl->nb_shards) >> 32];
+}
+
+/* create shared fragmentation table */
+struct rte_ip_frag_shared_tbl *
+rte_ip_frag_shared_table_create(uint32_t nb_shards, uint32_t bucket_num,
+	uint32_t bucket_entries, uint32_t max_entries, uint64_t max_cycles,
+	int socket_id)
+{
+	struct rte_ip_frag_shared_tbl *tbl;
+	uint32_t i;
+
+	if (nb_shards == 0 || bucket_num < nb_shards ||
+			max_entries < nb_shards) {
+		RTE_LOG(ERR, USER1, "%s: invalid input parameter\n", __func__);
+		return NULL;
+	}
+
+	tbl = rte_zmalloc_socket(__func__,
+		sizeof(*tbl) + nb_shards * sizeof(tbl->shard[0]),
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (tbl == NULL) {
+		RTE_LOG(ERR, USER1,
+			"%s: allocation of %u shards at socket %d failed\n",
+			__func__, nb_shards, socket_id);
+		return NULL;
+	}
+	tbl->nb_shards = nb_shards;
+
+	for (i = 0; i != nb_shards; i++) {
+		rte_spinlock_init(&tbl->shard[i].lock);
+		tbl->shard[i].tbl = rte_ip_frag_table_create(
+			RTE_ALIGN_MUL_CEIL(bucket_num, nb_shards) / nb_shards,
+			bucket_entries,
+			RTE_ALIGN_MUL_CEIL(max_entries, nb_shards) / nb_shards,
+			max_cycles, socket_id);
+		if (tbl->shard[i].tbl == NULL) {
+			rte_ip_frag_shared_table_destroy(tbl);
+			return NULL;
+		}
+	}
+
+	return tbl;
+}
+
+/* delete shared fragmentation table */
+void
+rte_ip_frag_shared_table_destroy(struct rte_ip_frag_shared_tbl *tbl)
+{
+	uint32_t i;
+
+	if (tbl == NULL)
+		return;
+
+	for (i = 0; i != tbl->nb_shards; i++)
+		if (tbl->shard[i].tbl != NULL)
+			rte_ip_frag_table_destroy(tbl->shard[i].tbl);
+
+	rte_free(tbl);
+}
+
+struct rte_mbuf *
+rte_ipv4_frag_shared_reassemble_packet(struct rte_ip_frag_shared_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, struct rte_mbuf *mb, uint64_t tms,
+	struct rte_ipv4_hdr *ip_hdr)
+{
+	struct ip_frag_shard *shard;
+
+	shard = ip_frag_shard_get(tbl, rte_ipv4_frag_hash(ip_hdr));
+
+	rte_spinlock_lock(&shard->lock);
+	mb = rte_ipv4_frag_reassemble_packet(shard->tbl, dr, mb, tms, ip_hdr);
+	rte_spinlock_unlock(&shard->lock);
+
+	return mb;
+}
+
+struct rte_mbuf *
+rte_ipv6_frag_shared_reassemble_packet(struct rte_ip_frag_shared_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, struct rte_mbuf *mb, uint64_t tms,
+	struct rte_ipv6_hdr *ip_hdr, struct rte_ipv6_fragment_ext *frag_hdr)
+{
+	struct ip_frag_shard *shard;
+
+	shard = ip_frag_shard_get(tbl, rte_ipv6_frag_hash(ip_hdr, frag_hdr));
+
+	rte_spinlock_lock(&shard->lock);
+	mb = rte_ipv6_frag_reassemble_packet(shard->tbl, dr, mb, tms, ip_hdr,
+		frag_hdr);
+	rte_spinlock_unlock(&shard->lock);
+
+	return mb;
+}
+
+/* Delete expired fragments of the shards not used by other lcores */
+void
+rte_ip_frag_shared_table_del_expired_entries(struct rte_ip_frag_shared_tbl *tbl,
+	struct rte_ip_frag_death_row *dr, uint64_t tms)
+{
+	struct ip_frag_shard *shard;
+	uint32_t i;
+
+	for (i = 0; i != tbl->nb_shards; i++) {
+		shard = &tbl->shard[i];
+		if (rte_spinlock_trylock(&shard->lock) == 0)
+			continue;
+		rte_ip_frag_table_del_expired_entries(shard->tbl, dr, tms);
+		rte_spinlock_unlock(&shard->lock);
+	}
+}
+
+/* dump shared frag table statistics to file */
+void
+rte_ip_frag_shared_table_statistics_dump(FILE *f,
+	const struct rte_ip_frag_shared_tbl *tbl)
+{
+	uint32_t i;
+
+	for (i = 0; i != tbl->nb_shards; i++) {
+		fprintf(f, "shard %u:\n", i);
+		rte_ip_frag_table_statistics_dump(f, tbl->shard[i].tbl);
+	}
+}
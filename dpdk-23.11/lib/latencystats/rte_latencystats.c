@@ -2,16 +2,21 @@
  * Copyright(c) 2018 Intel Corporation
  */
 
+#include <ctype.h>
 #include <math.h>
+#include <stdlib.h>
 
 #include <rte_string_fns.h>
 #include <rte_mbuf_dyn.h>
 #include <rte_log.h>
 #include <rte_cycles.h>
 #include <rte_ethdev.h>
+#include <rte_malloc.h>
 #include <rte_metrics.h>
 #include <rte_memzone.h>
 #include <rte_lcore.h>
+#include <rte_seqlock.h>
+#include <rte_telemetry.h>
 
 #include "rte_latencystats.h"
 
@@ -41,26 +46,77 @@ timestamp_dynfield(struct rte_mbuf *mbuf)
 static const char *MZ_RTE_LATENCY_STATS = "rte_latencystats";
 static int latency_stats_index;
 static uint64_t samp_intvl;
-static uint64_t timer_tsc;
-static uint64_t prev_tsc;
+/** Nano seconds per clock cycle, for histograms */
+static double ns_per_cycle;
 
 struct rte_latency_stats {
 	float min_latency; /**< Minimum latency in nano seconds */
 	float avg_latency; /**< Average latency in nano seconds */
 	float max_latency; /**< Maximum latency in nano seconds */
 	float jitter; /** Latency variation */
-	rte_spinlock_t lock; /** Latency calculation lock */
 };
 
-static struct rte_latency_stats *glob_stats;
+/*
+ * Latency stats of a Tx queue, only updated by the lcore polling it:
+ * queues do not contend for a lock or cache lines.
+ */
+struct latency_queue_stats {
+	struct rte_latency_stats stats; /**< In clock cycles */
+	float prev_latency; /**< Last sample, for jitter */
+	struct rte_latencystats_hist hist;
+} __rte_cache_aligned;
+
+struct latency_port_stats {
+	uint32_t first_queue; /**< Index of the stats of Tx queue 0 */
+	uint16_t nb_queues; /**< Number of Tx queues with stats */
+};
+
+/* Shared memory for multi process support */
+struct latency_stats_zone {
+	struct latency_port_stats ports[RTE_MAX_ETHPORTS];
+	uint32_t nb_queues;
+	struct latency_queue_stats queues[];
+};
+
+static struct latency_stats_zone *glob_stats;
+
+/* Rx sampling state of a queue */
+struct latency_rx_queue {
+	uint64_t timer_tsc;
+	uint64_t prev_tsc;
+} __rte_cache_aligned;
 
 struct rxtx_cbs {
 	const struct rte_eth_rxtx_callback *cb;
+	struct latency_rx_queue *rxq;
 };
 
 static struct rxtx_cbs rx_cbs[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT];
 static struct rxtx_cbs tx_cbs[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT];
 
+/* Source of the Rx timestamps of a port */
+enum latency_clock {
+	LATENCY_CLOCK_TSC, /**< Set by the Rx callback with rte_rdtsc() */
+	LATENCY_CLOCK_HW, /**< Set by the PMD, NIC clock readable */
+	LATENCY_CLOCK_HW_UNKNOWN, /**< Set by the PMD, unusable */
+};
+
+/*
+ * NIC clock of a port with Rx timestamp offload, estimated from the TSC
+ * to avoid reading it on every Tx burst.
+ */
+struct latency_hw_clock {
+	enum latency_clock type;
+	rte_seqlock_t lock; /**< Protects the estimation below */
+	uint64_t tsc_base; /**< TSC when calibrated */
+	uint64_t ticks_base; /**< NIC clock when calibrated */
+	double ticks_per_cycle;
+	uint64_t tsc_ref; /**< First calibration, to refine the ratio */
+	uint64_t ticks_ref;
+};
+
+static struct latency_hw_clock hw_clocks[RTE_MAX_ETHPORTS];
+
 struct latency_stats_nameoff {
 	char name[RTE_ETH_XSTATS_NAME_SIZE];
 	unsigned int offset;
@@ -76,16 +132,105 @@ static const struct latency_stats_nameoff lat_stats_strings[] = {
 #define NUM_LATENCY_STATS (sizeof(lat_stats_strings) / \
 				sizeof(lat_stats_strings[0]))
 
+/*
+ * Relate the NIC clock of a port to the TSC. The first call measures the
+ * NIC frequency over a short delay, later ones refine it over the whole
+ * interval since then and catch up with drifts.
+ */
+static void
+latency_hw_clock_calibrate(uint16_t pid, struct latency_hw_clock *clock)
+{
+	uint64_t tsc, ticks;
+
+	if (rte_eth_read_clock(pid, &ticks) != 0) {
+		clock->type = LATENCY_CLOCK_HW_UNKNOWN;
+		return;
+	}
+	tsc = rte_rdtsc();
+
+	if (clock->tsc_ref == 0) {
+		clock->tsc_ref = tsc;
+		clock->ticks_ref = ticks;
+		rte_delay_ms(10);
+		if (rte_eth_read_clock(pid, &ticks) != 0) {
+			clock->type = LATENCY_CLOCK_HW_UNKNOWN;
+			return;
+		}
+		tsc = rte_rdtsc();
+	}
+	if (tsc == clock->tsc_ref || ticks == clock->ticks_ref) {
+		clock->type = LATENCY_CLOCK_HW_UNKNOWN;
+		return;
+	}
+
+	rte_seqlock_write_lock(&clock->lock);
+	clock->tsc_base = tsc;
+	clock->ticks_base = ticks;
+	clock->ticks_per_cycle = (double)(ticks - clock->ticks_ref) /
+			(tsc - clock->tsc_ref);
+	rte_seqlock_write_unlock(&clock->lock);
+	clock->type = LATENCY_CLOCK_HW;
+}
+
+static void
+latency_hw_clocks_calibrate(void)
+{
+	uint16_t pid;
+
+	for (pid = 0; pid < RTE_MAX_ETHPORTS; pid++) {
+		if (hw_clocks[pid].type == LATENCY_CLOCK_HW)
+			latency_hw_clock_calibrate(pid, &hw_clocks[pid]);
+	}
+}
+
+/*
+ * Combine the stats of all queues: extremes of the minimums and maximums,
+ * averages and jitters weighted by the number of samples of each queue.
+ */
+static void
+latencystats_aggregate(struct rte_latency_stats *agg)
+{
+	const struct latency_queue_stats *q;
+	uint64_t nb_samples = 0;
+	double avg = 0, jitter = 0;
+	unsigned int i;
+
+	memset(agg, 0, sizeof(*agg));
+	if (glob_stats == NULL)
+		return;
+	for (i = 0; i < glob_stats->nb_queues; i++) {
+		q = &glob_stats->queues[i];
+		if (q->hist.count == 0)
+			continue;
+		if (agg->min_latency == 0 ||
+				(q->stats.min_latency != 0 &&
+				q->stats.min_latency < agg->min_latency))
+			agg->min_latency = q->stats.min_latency;
+		if (q->stats.max_latency > agg->max_latency)
+			agg->max_latency = q->stats.max_latency;
+		avg += (double)q->stats.avg_latency * q->hist.count;
+		jitter += (double)q->stats.jitter * q->hist.count;
+		nb_samples += q->hist.count;
+	}
+	if (nb_samples != 0) {
+		agg->avg_latency = avg / nb_samples;
+		agg->jitter = jitter / nb_samples;
+	}
+}
+
 int32_t
 rte_latencystats_update(void)
 {
+	struct rte_latency_stats agg;
 	unsigned int i;
 	float *stats_ptr = NULL;
 	uint64_t values[NUM_LATENCY_STATS] = {0};
 	int ret;
 
+	latency_hw_clocks_calibrate();
+	latencystats_aggregate(&agg);
 	for (i = 0; i < NUM_LATENCY_STATS; i++) {
-		stats_ptr = RTE_PTR_ADD(glob_stats,
+		stats_ptr = RTE_PTR_ADD(&agg,
 				lat_stats_strings[i].offset);
 		values[i] = (uint64_t)floor((*stats_ptr)/
 				latencystat_cycles_per_ns());
@@ -103,11 +248,13 @@ rte_latencystats_update(void)
 static void
 rte_latencystats_fill_values(struct rte_metric_value *values)
 {
+	struct rte_latency_stats agg;
 	unsigned int i;
 	float *stats_ptr = NULL;
 
+	latencystats_aggregate(&agg);
 	for (i = 0; i < NUM_LATENCY_STATS; i++) {
-		stats_ptr = RTE_PTR_ADD(glob_stats,
+		stats_ptr = RTE_PTR_ADD(&agg,
 				lat_stats_strings[i].offset);
 		values[i].key = i;
 		values[i].value = (uint64_t)floor((*stats_ptr)/
@@ -115,14 +262,105 @@ rte_latencystats_fill_values(struct rte_metric_value *values)
 	}
 }
 
+/*
+ * Log-linear histogram buckets: values below 2^SUB_BITS have a bucket
+ * each, then every power of 2 is split in 2^SUB_BITS buckets.
+ */
+#define HIST_SUB_BITS	4
+#define HIST_SUB_BUCKETS	(1 << HIST_SUB_BITS)
+
+static inline unsigned int
+latency_hist_bucket(uint64_t ns)
+{
+	unsigned int shift, idx;
+
+	if (ns < HIST_SUB_BUCKETS)
+		return ns;
+
+	shift = rte_fls_u64(ns) - 1 - HIST_SUB_BITS;
+	idx = (shift + 1) * HIST_SUB_BUCKETS + ((ns >> shift) & (HIST_SUB_BUCKETS - 1));
+
+	return RTE_MIN(idx, RTE_LATENCYSTATS_HIST_BUCKETS - 1u);
+}
+
+uint64_t
+rte_latencystats_hist_bucket_ns(unsigned int idx)
+{
+	unsigned int shift;
+
+	if (idx < HIST_SUB_BUCKETS)
+		return idx;
+	if (idx >= RTE_LATENCYSTATS_HIST_BUCKETS)
+		return UINT64_MAX;
+
+	shift = idx / HIST_SUB_BUCKETS - 1;
+	return (uint64_t)(HIST_SUB_BUCKETS + idx % HIST_SUB_BUCKETS) << shift;
+}
+
+static inline void
+latency_hist_add(struct rte_latencystats_hist *hist, uint64_t ns)
+{
+	if (hist->count == 0 || ns < hist->min_ns)
+		hist->min_ns = ns;
+	if (ns > hist->max_ns)
+		hist->max_ns = ns;
+	hist->sum_ns += ns;
+	hist->count++;
+	hist->buckets[latency_hist_bucket(ns)]++;
+}
+
+void
+rte_latencystats_hist_merge(struct rte_latencystats_hist *dst,
+		const struct rte_latencystats_hist *src)
+{
+	unsigned int i;
+
+	if (src->count == 0)
+		return;
+
+	if (dst->count == 0 || src->min_ns < dst->min_ns)
+		dst->min_ns = src->min_ns;
+	if (src->max_ns > dst->max_ns)
+		dst->max_ns = src->max_ns;
+	dst->sum_ns += src->sum_ns;
+	dst->count += src->count;
+	for (i = 0; i < RTE_LATENCYSTATS_HIST_BUCKETS; i++)
+		dst->buckets[i] += src->buckets[i];
+}
+
+uint64_t
+rte_latencystats_hist_percentile(const struct rte_latencystats_hist *hist,
+		double percentile)
+{
+	uint64_t rank, cumul = 0;
+	unsigned int i;
+
+	if (hist->count == 0)
+		return 0;
+	if (percentile <= 0)
+		return hist->min_ns;
+
+	rank = ceil(hist->count * RTE_MIN(percentile, 100.0) / 100);
+	for (i = 0; i < RTE_LATENCYSTATS_HIST_BUCKETS - 1; i++) {
+		cumul += hist->buckets[i];
+		if (cumul >= rank)
+			break;
+	}
+
+	/* Highest value of the bucket, within the observed range */
+	return RTE_MAX(RTE_MIN(rte_latencystats_hist_bucket_ns(i + 1) - 1,
+			hist->max_ns), hist->min_ns);
+}
+
 static uint16_t
 add_time_stamps(uint16_t pid __rte_unused,
 		uint16_t qid __rte_unused,
 		struct rte_mbuf **pkts,
 		uint16_t nb_pkts,
 		uint16_t max_pkts __rte_unused,
-		void *user_cb __rte_unused)
+		void *arg)
 {
+	struct latency_rx_queue *rxq = arg;
 	unsigned int i;
 	uint64_t diff_tsc, now;
 
@@ -132,33 +370,56 @@ add_time_stamps(uint16_t pid __rte_unused,
 	 */
 	now = rte_rdtsc();
 	for (i = 0; i < nb_pkts; i++) {
-		diff_tsc = now - prev_tsc;
-		timer_tsc += diff_tsc;
+		diff_tsc = now - rxq->prev_tsc;
+		rxq->timer_tsc += diff_tsc;
 
 		if ((pkts[i]->ol_flags & timestamp_dynflag) == 0
-				&& (timer_tsc >= samp_intvl)) {
+				&& (rxq->timer_tsc >= samp_intvl)) {
 			*timestamp_dynfield(pkts[i]) = now;
 			pkts[i]->ol_flags |= timestamp_dynflag;
-			timer_tsc = 0;
+			rxq->timer_tsc = 0;
 		}
-		prev_tsc = now;
+		rxq->prev_tsc = now;
 		now = rte_rdtsc();
 	}
 
 	return nb_pkts;
 }
 
+/* Current NIC clock of a port, from the TSC */
+static uint64_t
+latency_hw_clock_now(struct latency_hw_clock *clock, uint64_t tsc,
+		double *ticks_per_cycle)
+{
+	uint32_t sn;
+	uint64_t ticks;
+
+	do {
+		sn = rte_seqlock_read_begin(&clock->lock);
+		*ticks_per_cycle = clock->ticks_per_cycle;
+		ticks = clock->ticks_base +
+			(int64_t)((double)(int64_t)(tsc - clock->tsc_base) *
+				*ticks_per_cycle);
+	} while (rte_seqlock_read_retry(&clock->lock, sn));
+
+	return ticks;
+}
+
 static uint16_t
 calc_latency(uint16_t pid __rte_unused,
 		uint16_t qid __rte_unused,
 		struct rte_mbuf **pkts,
 		uint16_t nb_pkts,
-		void *_ __rte_unused)
+		void *arg)
 {
+	struct latency_queue_stats *q = arg;
+	struct latency_hw_clock *clock;
 	unsigned int i, cnt = 0;
-	uint64_t now;
+	uint64_t now, ticks = 0;
+	uint16_t port = RTE_MAX_ETHPORTS;
+	double ticks_per_cycle = 1;
 	float latency[nb_pkts];
-	static float prev_latency;
+	int64_t delta;
 	/*
 	 * Alpha represents degree of weighting decrease in EWMA,
 	 * a constant smoothing factor between 0 and 1. The value
@@ -168,11 +429,27 @@ calc_latency(uint16_t pid __rte_unused,
 
 	now = rte_rdtsc();
 	for (i = 0; i < nb_pkts; i++) {
-		if (pkts[i]->ol_flags & timestamp_dynflag)
+		if (!(pkts[i]->ol_flags & timestamp_dynflag))
+			continue;
+
+		if (pkts[i]->port >= RTE_MAX_ETHPORTS ||
+				hw_clocks[pkts[i]->port].type == LATENCY_CLOCK_TSC) {
 			latency[cnt++] = now - *timestamp_dynfield(pkts[i]);
+			continue;
+		}
+
+		/* Timestamped by the NIC, in its own clock */
+		clock = &hw_clocks[pkts[i]->port];
+		if (clock->type != LATENCY_CLOCK_HW)
+			continue;
+		if (pkts[i]->port != port) {
+			port = pkts[i]->port;
+			ticks = latency_hw_clock_now(clock, now, &ticks_per_cycle);
+		}
+		delta = ticks - *timestamp_dynfield(pkts[i]);
+		latency[cnt++] = delta > 0 ? delta / ticks_per_cycle : 0;
 	}
 
-	rte_spinlock_lock(&glob_stats->lock);
 	for (i = 0; i < cnt; i++) {
 		/*
 		 * The jitter is calculated as statistical mean of interpacket
@@ -185,36 +462,40 @@ calc_latency(uint16_t pid __rte_unused,
 		 * Reference: Calculated as per RFC 5481, sec 4.1,
 		 * RFC 3393 sec 4.5, RFC 1889 sec.
 		 */
-		glob_stats->jitter +=  (fabsf(prev_latency - latency[i])
-					- glob_stats->jitter)/16;
-		if (glob_stats->min_latency == 0)
-			glob_stats->min_latency = latency[i];
-		else if (latency[i] < glob_stats->min_latency)
-			glob_stats->min_latency = latency[i];
-		else if (latency[i] > glob_stats->max_latency)
-			glob_stats->max_latency = latency[i];
+		q->stats.jitter +=  (fabsf(q->prev_latency - latency[i])
+					- q->stats.jitter)/16;
+		if (q->stats.min_latency == 0)
+			q->stats.min_latency = latency[i];
+		else if (latency[i] < q->stats.min_latency)
+			q->stats.min_latency = latency[i];
+		else if (latency[i] > q->stats.max_latency)
+			q->stats.max_latency = latency[i];
 		/*
 		 * The average latency is measured using exponential moving
 		 * average, i.e. using EWMA
 		 * https://en.wikipedia.org/wiki/Moving_average
 		 */
-		glob_stats->avg_latency +=
-			alpha * (latency[i] - glob_stats->avg_latency);
-		prev_latency = latency[i];
+		q->stats.avg_latency +=
+			alpha * (latency[i] - q->stats.avg_latency);
+		q->prev_latency = latency[i];
+		latency_hist_add(&q->hist, latency[i] * ns_per_cycle);
 	}
-	rte_spinlock_unlock(&glob_stats->lock);
 
 	return nb_pkts;
 }
 
 int
 rte_latencystats_init(uint64_t app_samp_intvl,
-		rte_latency_stats_flow_type_fn user_cb)
+		rte_latency_stats_flow_type_fn user_cb __rte_unused)
 {
 	unsigned int i;
 	uint16_t pid;
 	uint16_t qid;
+	uint32_t nb_queues = 0;
 	struct rxtx_cbs *cbs = NULL;
+	struct latency_queue_stats *q;
+	struct rte_eth_dev_info dev_info;
+	struct rte_eth_conf dev_conf;
 	const char *ptr_strings[NUM_LATENCY_STATS] = {0};
 	const struct rte_memzone *mz = NULL;
 	const unsigned int flags = 0;
@@ -223,8 +504,15 @@ rte_latencystats_init(uint64_t app_samp_intvl,
 	if (rte_memzone_lookup(MZ_RTE_LATENCY_STATS))
 		return -EEXIST;
 
+	/* Stats of each Tx queue follow the ports table */
+	RTE_ETH_FOREACH_DEV(pid) {
+		if (rte_eth_dev_info_get(pid, &dev_info) == 0)
+			nb_queues += dev_info.nb_tx_queues;
+	}
+
 	/** Allocate stats in shared memory fo multi process support */
-	mz = rte_memzone_reserve(MZ_RTE_LATENCY_STATS, sizeof(*glob_stats),
+	mz = rte_memzone_reserve(MZ_RTE_LATENCY_STATS, sizeof(*glob_stats) +
+					nb_queues * sizeof(glob_stats->queues[0]),
 					rte_socket_id(), flags);
 	if (mz == NULL) {
 		RTE_LOG(ERR, LATENCY_STATS, "Cannot reserve memory: %s:%d\n",
@@ -233,8 +521,9 @@ rte_latencystats_init(uint64_t app_samp_intvl,
 	}
 
 	glob_stats = mz->addr;
-	rte_spinlock_init(&glob_stats->lock);
+	memset(glob_stats, 0, mz->len);
 	samp_intvl = app_samp_intvl * latencystat_cycles_per_ns();
+	ns_per_cycle = NS_PER_SEC / rte_get_timer_hz();
 
 	/** Register latency stats with stats library */
 	for (i = 0; i < NUM_LATENCY_STATS; i++)
@@ -259,8 +548,6 @@ rte_latencystats_init(uint64_t app_samp_intvl,
 
 	/** Register Rx/Tx callbacks */
 	RTE_ETH_FOREACH_DEV(pid) {
-		struct rte_eth_dev_info dev_info;
-
 		ret = rte_eth_dev_info_get(pid, &dev_info);
 		if (ret != 0) {
 			RTE_LOG(INFO, LATENCY_STATS,
@@ -270,19 +557,46 @@ rte_latencystats_init(uint64_t app_samp_intvl,
 			continue;
 		}
 
-		for (qid = 0; qid < dev_info.nb_rx_queues; qid++) {
+		/* Timestamps of the PMD are used as is, in the NIC clock */
+		if (rte_eth_dev_conf_get(pid, &dev_conf) == 0 &&
+				(dev_conf.rxmode.offloads &
+				 RTE_ETH_RX_OFFLOAD_TIMESTAMP)) {
+			latency_hw_clock_calibrate(pid, &hw_clocks[pid]);
+			if (hw_clocks[pid].type != LATENCY_CLOCK_HW)
+				RTE_LOG(INFO, LATENCY_STATS, "Cannot read "
+					"clock of pid=%d, its packets are "
+					"ignored\n", pid);
+		}
+
+		for (qid = 0; qid < dev_info.nb_rx_queues &&
+				hw_clocks[pid].type == LATENCY_CLOCK_TSC; qid++) {
 			cbs = &rx_cbs[pid][qid];
-			cbs->cb = rte_eth_add_first_rx_callback(pid, qid,
-					add_time_stamps, user_cb);
+			/* Kept from a previous init if any, see uninit */
+			if (cbs->rxq == NULL)
+				cbs->rxq = rte_zmalloc_socket("latencystats_rxq",
+					sizeof(*cbs->rxq), RTE_CACHE_LINE_SIZE,
+					rte_eth_dev_socket_id(pid));
+			else
+				memset(cbs->rxq, 0, sizeof(*cbs->rxq));
+			if (cbs->rxq != NULL)
+				cbs->cb = rte_eth_add_first_rx_callback(pid,
+						qid, add_time_stamps, cbs->rxq);
 			if (!cbs->cb)
 				RTE_LOG(INFO, LATENCY_STATS, "Failed to "
 					"register Rx callback for pid=%d, "
 					"qid=%d\n", pid, qid);
 		}
-		for (qid = 0; qid < dev_info.nb_tx_queues; qid++) {
+
+		/* Device may have been given queues since counted */
+		glob_stats->ports[pid].first_queue = glob_stats->nb_queues;
+		glob_stats->ports[pid].nb_queues = RTE_MIN(dev_info.nb_tx_queues,
+				nb_queues - glob_stats->nb_queues);
+		glob_stats->nb_queues += glob_stats->ports[pid].nb_queues;
+		for (qid = 0; qid < glob_stats->ports[pid].nb_queues; qid++) {
 			cbs = &tx_cbs[pid][qid];
+			q = &glob_stats->queues[glob_stats->ports[pid].first_queue + qid];
 			cbs->cb =  rte_eth_add_tx_callback(pid, qid,
-					calc_latency, user_cb);
+					calc_latency, q);
 			if (!cbs->cb)
 				RTE_LOG(INFO, LATENCY_STATS, "Failed to "
 					"register Tx callback for pid=%d, "
@@ -316,26 +630,35 @@ rte_latencystats_uninit(void)
 
 		for (qid = 0; qid < dev_info.nb_rx_queues; qid++) {
 			cbs = &rx_cbs[pid][qid];
+			if (cbs->cb == NULL)
+				continue;
 			ret = rte_eth_remove_rx_callback(pid, qid, cbs->cb);
 			if (ret)
 				RTE_LOG(INFO, LATENCY_STATS, "failed to "
 					"remove Rx callback for pid=%d, "
 					"qid=%d\n", pid, qid);
+			/* The callback may still be running, keep its state */
+			cbs->cb = NULL;
 		}
 		for (qid = 0; qid < dev_info.nb_tx_queues; qid++) {
 			cbs = &tx_cbs[pid][qid];
+			if (cbs->cb == NULL)
+				continue;
 			ret = rte_eth_remove_tx_callback(pid, qid, cbs->cb);
 			if (ret)
 				RTE_LOG(INFO, LATENCY_STATS, "failed to "
 					"remove Tx callback for pid=%d, "
 					"qid=%d\n", pid, qid);
+			cbs->cb = NULL;
 		}
 	}
+	memset(hw_clocks, 0, sizeof(hw_clocks));
 
 	/* free up the memzone */
 	mz = rte_memzone_lookup(MZ_RTE_LATENCY_STATS);
 	if (mz)
 		rte_memzone_free(mz);
+	glob_stats = NULL;
 
 	return 0;
 }
@@ -377,3 +700,125 @@ rte_latencystats_get(struct rte_metric_value *values, uint16_t size)
 
 	return NUM_LATENCY_STATS;
 }
+
+int
+rte_latencystats_hist_get(uint16_t port_id, uint16_t queue_id,
+		struct rte_latencystats_hist *hist)
+{
+	const struct latency_port_stats *port;
+	const struct rte_memzone *mz;
+	uint16_t qid;
+
+	if (hist == NULL || port_id >= RTE_MAX_ETHPORTS)
+		return -EINVAL;
+
+	if (rte_eal_process_type() == RTE_PROC_SECONDARY) {
+		mz = rte_memzone_lookup(MZ_RTE_LATENCY_STATS);
+		if (mz == NULL) {
+			RTE_LOG(ERR, LATENCY_STATS,
+				"Latency stats memzone not found\n");
+			return -ENOMEM;
+		}
+		glob_stats = mz->addr;
+	}
+	if (glob_stats == NULL)
+		return -ENOENT;
+
+	port = &glob_stats->ports[port_id];
+	if (queue_id != RTE_LATENCYSTATS_ALL_QUEUES &&
+			queue_id >= port->nb_queues)
+		return -EINVAL;
+
+	memset(hist, 0, sizeof(*hist));
+	for (qid = 0; qid < port->nb_queues; qid++) {
+		if (queue_id == RTE_LATENCYSTATS_ALL_QUEUES || queue_id == qid)
+			rte_latencystats_hist_merge(hist,
+				&glob_stats->queues[port->first_queue + qid].hist);
+	}
+
+	return 0;
+}
+
+static int
+latencystats_handle_hist(const char *cmd __rte_unused, const char *params,
+		struct rte_tel_data *d)
+{
+	static const struct {
+		const char *name;
+		double percentile;
+	} percentiles[] = {
+		{"p50_ns", 50}, {"p90_ns", 90}, {"p99_ns", 99},
+		{"p999_ns", 99.9}, {"p9999_ns", 99.99},
+	};
+	struct rte_latencystats_hist *hist;
+	struct rte_tel_data *bucket_ns, *bucket_count;
+	uint16_t queue_id = RTE_LATENCYSTATS_ALL_QUEUES;
+	unsigned long port_id, qid;
+	char *end_param;
+	unsigned int i;
+	int ret;
+
+	if (params == NULL || !isdigit(*params))
+		return -EINVAL;
+	port_id = strtoul(params, &end_param, 0);
+	if (*end_param == ',') {
+		if (!isdigit(end_param[1]))
+			return -EINVAL;
+		qid = strtoul(end_param + 1, &end_param, 0);
+		if (qid >= RTE_LATENCYSTATS_ALL_QUEUES)
+			return -EINVAL;
+		queue_id = qid;
+	}
+	if (*end_param != '\0' || port_id >= RTE_MAX_ETHPORTS)
+		return -EINVAL;
+
+	hist = malloc(sizeof(*hist));
+	if (hist == NULL)
+		return -ENOMEM;
+	ret = rte_latencystats_hist_get(port_id, queue_id, hist);
+	if (ret != 0)
+		goto out;
+
+	bucket_ns = rte_tel_data_alloc();
+	bucket_count = rte_tel_data_alloc();
+	if (bucket_ns == NULL || bucket_count == NULL) {
+		rte_tel_data_free(bucket_ns);
+		rte_tel_data_free(bucket_count);
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	rte_tel_data_start_dict(d);
+	rte_tel_data_add_dict_uint(d, "count", hist->count);
+	rte_tel_data_add_dict_uint(d, "min_ns", hist->min_ns);
+	rte_tel_data_add_dict_uint(d, "max_ns", hist->max_ns);
+	rte_tel_data_add_dict_uint(d, "avg_ns",
+		hist->count != 0 ? hist->sum_ns / hist->count : 0);
+	for (i = 0; i < RTE_DIM(percentiles); i++)
+		rte_tel_data_add_dict_uint(d, percentiles[i].name,
+			rte_latencystats_hist_percentile(hist,
+				percentiles[i].percentile));
+
+	/* Non empty buckets, by lowest latency */
+	rte_tel_data_start_array(bucket_ns, RTE_TEL_UINT_VAL);
+	rte_tel_data_start_array(bucket_count, RTE_TEL_UINT_VAL);
+	for (i = 0; i < RTE_LATENCYSTATS_HIST_BUCKETS; i++) {
+		if (hist->buckets[i] == 0)
+			continue;
+		rte_tel_data_add_array_uint(bucket_ns,
+			rte_latencystats_hist_bucket_ns(i));
+		rte_tel_data_add_array_uint(bucket_count, hist->buckets[i]);
+	}
+	rte_tel_data_add_dict_container(d, "bucket_ns", bucket_ns, 0);
+	rte_tel_data_add_dict_container(d, "bucket_count", bucket_count, 0);
+
+out:
+	free(hist);
+	return ret;
+}
+
+RTE_INIT(latencystats_init_telemetry)
+{
+	rte_telemetry_register_cmd("/latencystats/hist", latencystats_handle_hist,
+		"Returns latency histogram of Tx queues of a port. Parameters: int port_id, int queue_id (Optional, all queues merged if absent)");
+}
@@ -13,6 +13,7 @@
  */
 
 #include <stdint.h>
+#include <rte_compat.h>
 #include <rte_metrics.h>
 #include <rte_mbuf.h>
 
@@ -40,9 +41,41 @@ extern "C" {
 typedef uint16_t (*rte_latency_stats_flow_type_fn)(struct rte_mbuf *pkt,
 							void *user_param);
 
+/** Number of buckets of a latency histogram */
+#define RTE_LATENCYSTATS_HIST_BUCKETS 512
+
+/** Queue identifier to get the histogram of all queues of a port */
+#define RTE_LATENCYSTATS_ALL_QUEUES UINT16_MAX
+
+/**
+ * Histogram of latencies in nano seconds.
+ *
+ * Buckets are log-linear: latencies below 16 ns have a bucket each,
+ * then each power of 2 is split in 16 buckets, so that the relative
+ * error is below 6.25%. The last bucket holds latencies from about 33 s,
+ * that is 31 * 2^30 ns, and above.
+ * Histograms of different queues or time intervals can be merged
+ * by adding their buckets, see rte_latencystats_hist_merge().
+ */
+struct rte_latencystats_hist {
+	uint64_t count; /**< Number of samples */
+	uint64_t sum_ns; /**< Sum of the samples */
+	uint64_t min_ns; /**< Lowest sample */
+	uint64_t max_ns; /**< Highest sample */
+	uint64_t buckets[RTE_LATENCYSTATS_HIST_BUCKETS];
+	/**< Number of samples per bucket */
+};
+
 /**
  *  Registers Rx/Tx callbacks for each active port, queue.
  *
+ *  The latency of sampled packets is recorded per Tx queue without
+ *  locking, assuming as ethdev does that each queue is used by a single
+ *  lcore at a time.
+ *  Ports configured with RTE_ETH_RX_OFFLOAD_TIMESTAMP get no Rx callback:
+ *  all their packets are measured from the timestamp set by the PMD,
+ *  using the device clock as read by rte_eth_read_clock().
+ *
  * @param samp_intvl
  *  Sampling time period in nano seconds, at which packet
  *  should be marked with time stamp.
@@ -121,6 +154,81 @@ int rte_latencystats_get_names(struct rte_metric_name *names,
 int rte_latencystats_get(struct rte_metric_value *values,
 			uint16_t size);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Retrieve the latency histogram of a Tx queue.
+ *
+ * Values are updated without synchronization,
+ * so that the histogram may be slightly inconsistent during traffic.
+ *
+ * @param port_id
+ *   The port identifier of the Ethernet device.
+ * @param queue_id
+ *   The Tx queue index, or RTE_LATENCYSTATS_ALL_QUEUES to get the
+ *   histograms of all queues of the port merged.
+ * @param hist
+ *   Histogram to fill.
+ * @return
+ *   - 0: On success.
+ *   - -EINVAL: Invalid parameters, or queue without latency stats.
+ *   - -ENOENT: Latency stats not initialized.
+ *   - -ENOMEM: Latency stats memzone not found in secondary process.
+ */
+__rte_experimental
+int rte_latencystats_hist_get(uint16_t port_id, uint16_t queue_id,
+			struct rte_latencystats_hist *hist);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Add the samples of a latency histogram to another one.
+ *
+ * @param dst
+ *   Histogram to update.
+ * @param src
+ *   Histogram to add.
+ */
+__rte_experimental
+void rte_latencystats_hist_merge(struct rte_latencystats_hist *dst,
+			const struct rte_latencystats_hist *src);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Estimate a percentile of the latencies of a histogram.
+ *
+ * @param hist
+ *   Latency histogram.
+ * @param percentile
+ *   Percentile, between 0 and 100.
+ * @return
+ *   Highest latency, in nano seconds, of the bucket holding the percentile,
+ *   bounded by the lowest and highest samples. 0 if the histogram is empty.
+ */
+__rte_experimental
+uint64_t rte_latencystats_hist_percentile(
+			const struct rte_latencystats_hist *hist,
+			double percentile);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the lowest latency of a histogram bucket.
+ *
+ * @param idx
+ *   Bucket index.
+ * @return
+ *   Lowest latency in nano seconds of the bucket,
+ *   UINT64_MAX if idx is out of range.
+ */
+__rte_experimental
+uint64_t rte_latencystats_hist_bucket_ns(unsigned int idx);
+
 #ifdef __cplusplus
 }
 #endif
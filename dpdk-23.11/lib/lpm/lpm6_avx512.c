@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <rte_vect.h>
+#include <rte_lpm6.h>
+
+#include "lpm6_avx512.h"
+
+#define LPM6_VALID_EXT_ENTRY_BITMASK	0xA0000000
+#define LPM6_LOOKUP_SUCCESS		0x20000000
+#define LPM6_TBL8_BITMASK		0x001FFFFF
+#define LPM6_LOOKUP_FIRST_BYTE		4
+
+/*
+ * Look up 16 addresses at once. All the lanes walk the tables in lock
+ * step, one gather per level, and drop out of the mask once resolved.
+ */
+static __rte_always_inline void
+lpm6_vec_lookup_x16(const uint32_t *tbl, uint32_t tbl8_ofs,
+	uint8_t ips[][RTE_LPM6_IPV6_ADDR_SIZE], int32_t *next_hops,
+	__mmask16 msk)
+{
+	__m512i words[RTE_LPM6_IPV6_ADDR_SIZE / sizeof(uint32_t)];
+	__m512i idxes, ent, res, bytes;
+	__mmask16 msk_ext, msk_hit, msk_store;
+	const __m512i zero = _mm512_set1_epi32(0);
+	const __m512i byte_mask = _mm512_set1_epi32(UINT8_MAX);
+	const __m512i ext_bits = _mm512_set1_epi32(LPM6_VALID_EXT_ENTRY_BITMASK);
+	const __m512i hit_bit = _mm512_set1_epi32(LPM6_LOOKUP_SUCCESS);
+	const __m512i nh_mask = _mm512_set1_epi32(LPM6_TBL8_BITMASK);
+	const __m512i ofs = _mm512_set1_epi32(tbl8_ofs);
+	/* index of the first 32-bit word of each address */
+	const __m512i lanes = _mm512_set_epi32(60, 56, 52, 48, 44, 40, 36, 32,
+		28, 24, 20, 16, 12, 8, 4, 0);
+	unsigned int b, w;
+
+	for (w = 0; w != RTE_DIM(words); w++)
+		words[w] = _mm512_mask_i32gather_epi32(zero, msk,
+			_mm512_add_epi32(lanes, _mm512_set1_epi32(w)),
+			(const void *)ips, sizeof(uint32_t));
+
+	/* tbl24 index is made of the first three bytes, in network order */
+	idxes = _mm512_or_epi32(
+		_mm512_slli_epi32(_mm512_and_epi32(words[0], byte_mask), 16),
+		_mm512_or_epi32(
+			_mm512_and_epi32(words[0], _mm512_set1_epi32(0xff00)),
+			_mm512_and_epi32(_mm512_srli_epi32(words[0], 16),
+				byte_mask)));
+	ent = _mm512_mask_i32gather_epi32(zero, msk, idxes,
+		(const void *)tbl, sizeof(uint32_t));
+
+	res = _mm512_set1_epi32(-1);
+	msk_store = msk;
+	for (b = LPM6_LOOKUP_FIRST_BYTE - 1; ; b++) {
+		msk_ext = _mm512_mask_cmpeq_epi32_mask(msk,
+			_mm512_and_epi32(ent, ext_bits), ext_bits);
+		msk_hit = _mm512_mask_test_epi32_mask(msk & ~msk_ext,
+			ent, hit_bit);
+		res = _mm512_mask_and_epi32(res, msk_hit, ent, nh_mask);
+
+		msk = msk_ext;
+		if (msk == 0 || b == RTE_LPM6_IPV6_ADDR_SIZE)
+			break;
+
+		/* tbl8 index is the group times 256 plus the next byte */
+		bytes = _mm512_and_epi32(_mm512_srlv_epi32(words[b / 4],
+			_mm512_set1_epi32((b % 4) * 8)), byte_mask);
+		idxes = _mm512_add_epi32(_mm512_add_epi32(ofs, bytes),
+			_mm512_slli_epi32(_mm512_and_epi32(ent, nh_mask), 8));
+		ent = _mm512_mask_i32gather_epi32(ent, msk, idxes,
+			(const void *)tbl, sizeof(uint32_t));
+	}
+
+	_mm512_mask_storeu_epi32(next_hops, msk_store, res);
+}
+
+void
+rte_lpm6_vec_lookup_bulk(const uint32_t *tbl, uint32_t tbl8_ofs,
+	uint8_t ips[][RTE_LPM6_IPV6_ADDR_SIZE], int32_t *next_hops,
+	unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i + 16 <= n; i += 16)
+		lpm6_vec_lookup_x16(tbl, tbl8_ofs, &ips[i], &next_hops[i],
+			UINT16_MAX);
+
+	if (i != n)
+		lpm6_vec_lookup_x16(tbl, tbl8_ofs, &ips[i], &next_hops[i],
+			(1 << (n - i)) - 1);
+}
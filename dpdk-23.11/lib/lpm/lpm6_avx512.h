@@ -0,0 +1,16 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _LPM6_AVX512_H_
+#define _LPM6_AVX512_H_
+
+/*
+ * Look up 'n' addresses in the tbl24 'tbl', whose tbl8 groups start at
+ * entry 'tbl8_ofs' of 'tbl'.
+ */
+void
+rte_lpm6_vec_lookup_bulk(const uint32_t *tbl, uint32_t tbl8_ofs,
+	uint8_t ips[][RTE_LPM6_IPV6_ADDR_SIZE], int32_t *next_hops,
+	unsigned int n);
+
+#endif /* _LPM6_AVX512_H_ */
@@ -18,9 +18,16 @@
 #include <assert.h>
 #include <rte_jhash.h>
 #include <rte_tailq.h>
+#include <rte_vect.h>
 
 #include "rte_lpm6.h"
 
+#ifdef CC_LPM6_AVX512_SUPPORT
+
+#include "lpm6_avx512.h"
+
+#endif /* CC_LPM6_AVX512_SUPPORT */
+
 #define RTE_LPM6_TBL24_NUM_ENTRIES        (1 << 24)
 #define RTE_LPM6_TBL8_GROUP_NUM_ENTRIES         256
 #define RTE_LPM6_TBL8_MAX_NUM_GROUPS      (1 << 21)
@@ -966,11 +973,8 @@ rte_lpm6_lookup(const struct rte_lpm6 *lpm, const uint8_t *ip,
 	return status;
 }
 
-/*
- * Looks up a group of IP addresses
- */
-int
-rte_lpm6_lookup_bulk_func(const struct rte_lpm6 *lpm,
+static int
+lookup_bulk_scalar(const struct rte_lpm6 *lpm,
 		uint8_t ips[][RTE_LPM6_IPV6_ADDR_SIZE],
 		int32_t *next_hops, unsigned int n)
 {
@@ -981,10 +985,6 @@ rte_lpm6_lookup_bulk_func(const struct rte_lpm6 *lpm,
 	uint8_t first_byte;
 	int status;
 
-	/* DEBUG: Check user input arguments. */
-	if ((lpm == NULL) || (ips == NULL) || (next_hops == NULL))
-		return -EINVAL;
-
 	for (i = 0; i < n; i++) {
 		first_byte = LOOKUP_FIRST_BYTE;
 		tbl24_index = (ips[i][0] << BYTES2_SIZE) |
@@ -1011,6 +1011,56 @@ rte_lpm6_lookup_bulk_func(const struct rte_lpm6 *lpm,
 	return 0;
 }
 
+#ifdef CC_LPM6_AVX512_SUPPORT
+static int
+lookup_bulk_avx512(const struct rte_lpm6 *lpm,
+		uint8_t ips[][RTE_LPM6_IPV6_ADDR_SIZE],
+		int32_t *next_hops, unsigned int n)
+{
+	/* tbl8 follows tbl24, so both are indexed from tbl24 */
+	rte_lpm6_vec_lookup_bulk((const uint32_t *)lpm->tbl24,
+			(offsetof(struct rte_lpm6, tbl8) -
+			offsetof(struct rte_lpm6, tbl24)) /
+			sizeof(lpm->tbl24[0]), ips, next_hops, n);
+
+	return 0;
+}
+
+/* CPU support of the AVX512 lookup, checked once per process */
+static bool lookup_bulk_avx512_cpu;
+
+RTE_INIT(lpm6_lookup_bulk_init)
+{
+	lookup_bulk_avx512_cpu =
+		rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512F) > 0;
+}
+#endif
+
+/*
+ * Looks up a group of IP addresses
+ */
+int
+rte_lpm6_lookup_bulk_func(const struct rte_lpm6 *lpm,
+		uint8_t ips[][RTE_LPM6_IPV6_ADDR_SIZE],
+		int32_t *next_hops, unsigned int n)
+{
+	/* DEBUG: Check user input arguments. */
+	if ((lpm == NULL) || (ips == NULL) || (next_hops == NULL))
+		return -EINVAL;
+
+#ifdef CC_LPM6_AVX512_SUPPORT
+	/*
+	 * The implementation is chosen per call rather than stored in the
+	 * table, which is shared with secondary processes.
+	 */
+	if (lookup_bulk_avx512_cpu &&
+			rte_vect_get_max_simd_bitwidth() >= RTE_VECT_SIMD_512)
+		return lookup_bulk_avx512(lpm, ips, next_hops, n);
+#endif
+
+	return lookup_bulk_scalar(lpm, ips, next_hops, n);
+}
+
 /*
  * Look for a rule in the high-level rules table
  */
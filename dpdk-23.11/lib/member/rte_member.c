@@ -331,6 +331,66 @@ rte_member_report_heavyhitter(const struct rte_member_setsum *setsum,
 	}
 }
 
+int
+rte_member_merge(const struct rte_member_setsum *dst,
+		 const struct rte_member_setsum *src)
+{
+	if (dst == NULL || src == NULL || dst == src ||
+			dst->type != src->type)
+		return -EINVAL;
+
+	switch (dst->type) {
+	case RTE_MEMBER_TYPE_SKETCH:
+		return rte_member_merge_sketch(dst, src);
+	default:
+		return -EINVAL;
+	}
+}
+
+int
+rte_member_serialize(const struct rte_member_setsum *setsum,
+		     void *buf, size_t size)
+{
+	if (setsum == NULL)
+		return -EINVAL;
+
+	switch (setsum->type) {
+	case RTE_MEMBER_TYPE_SKETCH:
+		return rte_member_serialize_sketch(setsum, buf, size);
+	default:
+		return -EINVAL;
+	}
+}
+
+int
+rte_member_merge_serialized(const struct rte_member_setsum *dst,
+			    const void *buf, size_t size)
+{
+	if (dst == NULL || buf == NULL)
+		return -EINVAL;
+
+	switch (dst->type) {
+	case RTE_MEMBER_TYPE_SKETCH:
+		return rte_member_merge_serialized_sketch(dst, buf, size);
+	default:
+		return -EINVAL;
+	}
+}
+
+int
+rte_member_decay(const struct rte_member_setsum *setsum, float factor)
+{
+	if (setsum == NULL)
+		return -EINVAL;
+
+	switch (setsum->type) {
+	case RTE_MEMBER_TYPE_SKETCH:
+		return rte_member_decay_sketch(setsum, factor);
+	default:
+		return -EINVAL;
+	}
+}
+
 int
 rte_member_delete(const struct rte_member_setsum *setsum, const void *key,
 			member_set_t set_id)
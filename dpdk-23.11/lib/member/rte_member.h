@@ -63,6 +63,7 @@ extern "C" {
 #include <inttypes.h>
 
 #include <rte_common.h>
+#include <rte_compat.h>
 
 /** The set ID type that stored internally in hash table based set summary. */
 typedef uint16_t member_set_t;
@@ -90,6 +91,12 @@ typedef uint16_t member_set_t;
 #define RTE_MEMBER_SKETCH_ALWAYS_BOUNDED 0x01
 /** For sketch, use the flag if to count packet size instead of packet count */
 #define RTE_MEMBER_SKETCH_COUNT_BYTE 0x02
+/**
+ * For sketch, use the flag to derive the hash seeds from prim_hash_seed and
+ * sec_hash_seed instead of random ones, so that the sketches created with
+ * the same parameters (e.g. one per lcore) can be merged.
+ */
+#define RTE_MEMBER_SKETCH_MERGEABLE 0x04
 
 /** @internal Hash function used by membership library. */
 #if defined(RTE_ARCH_X86) || defined(__ARM_FEATURE_CRC32)
@@ -577,6 +584,95 @@ int
 rte_member_delete(const struct rte_member_setsum *setsum, const void *key,
 			member_set_t set_id);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Merge a sketch into another one: the counters of the source are added to
+ * the destination ones and the source heavy hitters compete for the
+ * destination top-k. Both sketches must be created with the same
+ * parameters and the RTE_MEMBER_SKETCH_MERGEABLE flag.
+ * Neither sketch may be updated during the merge.
+ *
+ * @param dst
+ *   Pointer of the set-summary to merge into.
+ * @param src
+ *   Pointer of the set-summary to merge.
+ * @return
+ *   Return -EINVAL for invalid parameters or sketches which can't be
+ *   merged, 0 on success.
+ */
+__rte_experimental
+int
+rte_member_merge(const struct rte_member_setsum *dst,
+		 const struct rte_member_setsum *src);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Serialize a sketch with its top-k keys into a buffer, e.g. to export it
+ * to another process or node and merge it there with
+ * rte_member_merge_serialized(). The format does not depend on the CPU
+ * endianness. The sketch may not be updated during the serialization.
+ *
+ * @param setsum
+ *   Pointer of a set-summary.
+ * @param buf
+ *   Output buffer, NULL to query the size needed.
+ * @param size
+ *   Size of the output buffer.
+ * @return
+ *   Return -EINVAL for invalid parameters, -ENOSPC if the buffer is too
+ *   small, otherwise the size of the serialized sketch.
+ */
+__rte_experimental
+int
+rte_member_serialize(const struct rte_member_setsum *setsum,
+		     void *buf, size_t size);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Merge a sketch serialized by rte_member_serialize() into a set-summary,
+ * same as rte_member_merge().
+ *
+ * @param dst
+ *   Pointer of the set-summary to merge into.
+ * @param buf
+ *   Serialized sketch.
+ * @param size
+ *   Size of the serialized sketch.
+ * @return
+ *   Return -EINVAL for invalid parameters, invalid buffer or sketches
+ *   which can't be merged, 0 on success.
+ */
+__rte_experimental
+int
+rte_member_merge_serialized(const struct rte_member_setsum *dst,
+			    const void *buf, size_t size);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Multiply all the counts of a sketch by a factor. Called periodically,
+ * e.g. from a timer, it makes the sketch a sliding window in which the
+ * weight of the packets decays exponentially with their age.
+ * The sketch may not be updated during the decay.
+ *
+ * @param setsum
+ *   Pointer of a set-summary.
+ * @param factor
+ *   Decay factor, between 0 and 1.
+ * @return
+ *   Return -EINVAL for invalid parameters, 0 on success.
+ */
+__rte_experimental
+int
+rte_member_decay(const struct rte_member_setsum *setsum, float factor);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,6 +6,7 @@
 #include <math.h>
 #include <string.h>
 
+#include <rte_byteorder.h>
 #include <rte_malloc.h>
 #include <rte_memory.h>
 #include <rte_errno.h>
@@ -22,6 +23,26 @@
 #include "rte_member_sketch_avx512.h"
 #endif /* CC_AVX512_SUPPORT */
 
+/*
+ * Serialized sketch header, followed by the num_row hash seeds,
+ * the num_row * num_col counters and the num_keys top-k keys.
+ * All fields are little endian.
+ */
+struct sketch_serial_hdr {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t flags;
+	uint32_t key_len;
+	uint32_t num_row;
+	uint32_t num_col;
+	uint32_t num_keys;
+};
+
+#define SKETCH_SERIAL_MAGIC	0x48435453 /* "STCH" */
+#define SKETCH_SERIAL_VERSION	1
+#define SKETCH_SERIAL_F_BYTE	0x1 /* counting bytes */
+#define SKETCH_SERIAL_F_VEC	0x2 /* vector hash */
+
 struct sketch_runtime {
 	uint64_t pkt_cnt;
 	uint32_t until_next;
@@ -227,8 +248,16 @@ rte_member_create_sketch(struct rte_member_setsum *ss,
 		goto error_runtime;
 	}
 
-	for (i = 0; i < ss->num_row; i++)
-		ss->hash_seeds[i] = rte_rand();
+	/* mergeable sketches need the same seeds, derive them from the params */
+	for (i = 0; i < ss->num_row; i++) {
+		if (params->extra_flag & RTE_MEMBER_SKETCH_MERGEABLE)
+			ss->hash_seeds[i] = (uint64_t)MEMBER_HASH_FUNC(&i,
+					sizeof(i), ss->prim_hash_seed) << 32 |
+				MEMBER_HASH_FUNC(&i, sizeof(i),
+					ss->sec_hash_seed);
+		else
+			ss->hash_seeds[i] = rte_rand();
+	}
 
 	if (params->extra_flag & RTE_MEMBER_SKETCH_ALWAYS_BOUNDED)
 		ss->always_bounded = 1;
@@ -591,3 +620,211 @@ rte_member_reset_sketch(const struct rte_member_setsum *ss)
 	for (i = 0; i < ss->topk; i++)
 		rte_ring_sp_enqueue_elem(runtime_var->free_key_slots, &i, sizeof(uint32_t));
 }
+
+/*
+ * Refresh the top-k counts from the sketch, then restore the heap order
+ * as the counts may not have changed uniformly.
+ */
+static void
+sketch_heap_refresh(const struct rte_member_setsum *ss)
+{
+	struct sketch_runtime *runtime_var = ss->runtime_var;
+	uint32_t i;
+
+	rte_member_update_heap(ss);
+	for (i = runtime_var->heap.size / 2; i-- != 0; )
+		rte_member_heapify(&runtime_var->heap, i, true);
+}
+
+static uint16_t
+sketch_serial_flags(const struct rte_member_setsum *ss)
+{
+	uint16_t flags = 0;
+
+	if (ss->count_byte == 1)
+		flags |= SKETCH_SERIAL_F_BYTE;
+#ifdef RTE_ARCH_X86
+	if (ss->use_avx512 == true)
+		flags |= SKETCH_SERIAL_F_VEC;
+#endif
+	return flags;
+}
+
+static int
+sketch_check_merge(const struct rte_member_setsum *ss, uint16_t flags,
+		   uint32_t key_len, uint32_t num_row, uint32_t num_col)
+{
+	if (sketch_serial_flags(ss) != flags || ss->key_len != key_len ||
+			ss->num_row != num_row || ss->num_col != num_col) {
+		RTE_MEMBER_LOG(ERR, "Sketches with different parameters "
+			"can't be merged\n");
+		return -EINVAL;
+	}
+	return 0;
+}
+
+int
+rte_member_merge_sketch(const struct rte_member_setsum *ss,
+			const struct rte_member_setsum *src)
+{
+	struct sketch_runtime *src_var = src->runtime_var;
+	uint64_t *count_array = ss->table;
+	const uint64_t *src_array = src->table;
+	uint32_t i;
+
+	if (sketch_check_merge(ss, sketch_serial_flags(src), src->key_len,
+			src->num_row, src->num_col) != 0)
+		return -EINVAL;
+
+	if (memcmp(ss->hash_seeds, src->hash_seeds,
+			sizeof(uint64_t) * ss->num_row) != 0) {
+		RTE_MEMBER_LOG(ERR, "Sketches with different hash seeds "
+			"can't be merged\n");
+		return -EINVAL;
+	}
+
+	for (i = 0; i < ss->num_row * ss->num_col; i++)
+		count_array[i] += src_array[i];
+
+	/* the heavy hitters of both sketches compete for the top-k */
+	sketch_heap_refresh(ss);
+	for (i = 0; i < src_var->heap.size; i++)
+		heap_update(ss, src_var->heap.elem[i].key);
+	sketch_heap_refresh(ss);
+
+	return 0;
+}
+
+int
+rte_member_serialize_sketch(const struct rte_member_setsum *ss,
+			    void *buf, size_t size)
+{
+	struct sketch_runtime *runtime_var = ss->runtime_var;
+	struct sketch_serial_hdr hdr;
+	const uint64_t *count_array = ss->table;
+	uint32_t i, num_keys;
+	uint64_t v;
+	size_t len;
+	uint8_t *p;
+
+	num_keys = runtime_var->heap.size;
+	len = sizeof(hdr) + sizeof(uint64_t) *
+		(ss->num_row + (size_t)ss->num_row * ss->num_col) +
+		(size_t)num_keys * ss->key_len;
+	if (len > INT32_MAX)
+		return -E2BIG;
+
+	if (buf == NULL)
+		return len;
+	if (size < len)
+		return -ENOSPC;
+
+	hdr.magic = rte_cpu_to_le_32(SKETCH_SERIAL_MAGIC);
+	hdr.version = rte_cpu_to_le_16(SKETCH_SERIAL_VERSION);
+	hdr.flags = rte_cpu_to_le_16(sketch_serial_flags(ss));
+	hdr.key_len = rte_cpu_to_le_32(ss->key_len);
+	hdr.num_row = rte_cpu_to_le_32(ss->num_row);
+	hdr.num_col = rte_cpu_to_le_32(ss->num_col);
+	hdr.num_keys = rte_cpu_to_le_32(num_keys);
+
+	p = buf;
+	memcpy(p, &hdr, sizeof(hdr));
+	p += sizeof(hdr);
+
+	for (i = 0; i < ss->num_row; i++, p += sizeof(v)) {
+		v = rte_cpu_to_le_64(ss->hash_seeds[i]);
+		memcpy(p, &v, sizeof(v));
+	}
+
+	for (i = 0; i < ss->num_row * ss->num_col; i++, p += sizeof(v)) {
+		v = rte_cpu_to_le_64(count_array[i]);
+		memcpy(p, &v, sizeof(v));
+	}
+
+	for (i = 0; i < num_keys; i++, p += ss->key_len)
+		memcpy(p, runtime_var->heap.elem[i].key, ss->key_len);
+
+	return len;
+}
+
+int
+rte_member_merge_serialized_sketch(const struct rte_member_setsum *ss,
+				   const void *buf, size_t size)
+{
+	struct sketch_serial_hdr hdr;
+	uint64_t *count_array = ss->table;
+	const uint8_t *p, *keys;
+	uint32_t i, num_keys;
+	uint64_t v;
+	size_t len;
+
+	if (size < sizeof(hdr))
+		return -EINVAL;
+
+	memcpy(&hdr, buf, sizeof(hdr));
+	if (rte_le_to_cpu_32(hdr.magic) != SKETCH_SERIAL_MAGIC ||
+			rte_le_to_cpu_16(hdr.version) != SKETCH_SERIAL_VERSION) {
+		RTE_MEMBER_LOG(ERR, "Invalid serialized sketch\n");
+		return -EINVAL;
+	}
+
+	if (sketch_check_merge(ss, rte_le_to_cpu_16(hdr.flags),
+			rte_le_to_cpu_32(hdr.key_len),
+			rte_le_to_cpu_32(hdr.num_row),
+			rte_le_to_cpu_32(hdr.num_col)) != 0)
+		return -EINVAL;
+
+	num_keys = rte_le_to_cpu_32(hdr.num_keys);
+	len = sizeof(hdr) + sizeof(uint64_t) *
+		(ss->num_row + (size_t)ss->num_row * ss->num_col) +
+		(size_t)num_keys * ss->key_len;
+	if (size != len) {
+		RTE_MEMBER_LOG(ERR, "Invalid serialized sketch size\n");
+		return -EINVAL;
+	}
+
+	p = RTE_PTR_ADD(buf, sizeof(hdr));
+	for (i = 0; i < ss->num_row; i++, p += sizeof(v)) {
+		memcpy(&v, p, sizeof(v));
+		if (rte_le_to_cpu_64(v) != ss->hash_seeds[i]) {
+			RTE_MEMBER_LOG(ERR, "Sketches with different hash "
+				"seeds can't be merged\n");
+			return -EINVAL;
+		}
+	}
+
+	for (i = 0; i < ss->num_row * ss->num_col; i++, p += sizeof(v)) {
+		memcpy(&v, p, sizeof(v));
+		count_array[i] += rte_le_to_cpu_64(v);
+	}
+
+	keys = p;
+	sketch_heap_refresh(ss);
+	for (i = 0; i < num_keys; i++)
+		heap_update(ss, keys + i * ss->key_len);
+	sketch_heap_refresh(ss);
+
+	return 0;
+}
+
+/*
+ * Scale down all the counters, so that older packets weigh less than
+ * recent ones. Called periodically, it turns the sketch into a time decayed
+ * sliding window.
+ */
+int
+rte_member_decay_sketch(const struct rte_member_setsum *ss, float factor)
+{
+	uint64_t *count_array = ss->table;
+	uint32_t i;
+
+	if (!(factor >= 0 && factor <= 1))
+		return -EINVAL;
+
+	for (i = 0; i < ss->num_row * ss->num_col; i++)
+		count_array[i] = count_array[i] * (double)factor;
+
+	sketch_heap_refresh(ss);
+
+	return 0;
+}
@@ -71,6 +71,21 @@ rte_member_report_heavyhitter_sketch(const struct rte_member_setsum *setsum,
 void
 rte_member_update_heap(const struct rte_member_setsum *ss);
 
+int
+rte_member_merge_sketch(const struct rte_member_setsum *ss,
+			const struct rte_member_setsum *src);
+
+int
+rte_member_serialize_sketch(const struct rte_member_setsum *ss,
+			    void *buf, size_t size);
+
+int
+rte_member_merge_serialized_sketch(const struct rte_member_setsum *ss,
+				   const void *buf, size_t size);
+
+int
+rte_member_decay_sketch(const struct rte_member_setsum *ss, float factor);
+
 static __rte_always_inline uint64_t
 count_min(const struct rte_member_setsum *ss, const uint32_t *hash_results)
 {
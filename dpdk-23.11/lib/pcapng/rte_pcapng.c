@@ -464,6 +464,69 @@ pcapng_vlan_insert(struct rte_mbuf *m, uint16_t ether_type, uint16_t tci)
  *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  */
 
+/* Length of the options trailing the packet data of an EPB */
+static uint16_t
+pcapng_epb_optlen(bool rss_hash, const char *comment)
+{
+	uint16_t optlen;
+
+	optlen = pcapng_optlen(sizeof(uint32_t));	/* flags */
+	optlen += pcapng_optlen(sizeof(uint32_t));	/* queue */
+	if (rss_hash)
+		optlen += pcapng_optlen(sizeof(uint8_t) + sizeof(uint32_t));
+
+	if (comment)
+		optlen += pcapng_optlen(strlen(comment));
+
+	return optlen;
+}
+
+/* Fill in the EPB options, returns where the block length trailer goes */
+static struct pcapng_option *
+pcapng_epb_options(struct pcapng_option *opt, const struct rte_mbuf *md,
+		   uint32_t queue, enum rte_pcapng_direction direction,
+		   bool rss_hash, const char *comment)
+{
+	uint32_t flags;
+
+	switch (direction) {
+	case RTE_PCAPNG_DIRECTION_IN:
+		flags = PCAPNG_IFB_INBOUND;
+		break;
+	case RTE_PCAPNG_DIRECTION_OUT:
+		flags = PCAPNG_IFB_OUTBOUND;
+		break;
+	default:
+		flags = 0;
+	}
+
+	opt = pcapng_add_option(opt, PCAPNG_EPB_FLAGS,
+				&flags, sizeof(flags));
+
+	opt = pcapng_add_option(opt, PCAPNG_EPB_QUEUE,
+				&queue, sizeof(queue));
+
+	if (rss_hash) {
+		uint8_t hash_opt[5];
+
+		/* The algorithm could be something else if
+		 * using rte_flow_action_rss; but the current API does not
+		 * have a way for ethdev to report  this on a per-packet basis.
+		 */
+		hash_opt[0] = PCAPNG_HASH_TOEPLITZ;
+
+		memcpy(&hash_opt[1], &md->hash.rss, sizeof(uint32_t));
+		opt = pcapng_add_option(opt, PCAPNG_EPB_HASH,
+					&hash_opt, sizeof(hash_opt));
+	}
+
+	if (comment)
+		opt = pcapng_add_option(opt, PCAPNG_OPT_COMMENT, comment,
+					strlen(comment));
+
+	return opt;
+}
+
 /* Make a copy of original mbuf with pcapng header and options */
 struct rte_mbuf *
 rte_pcapng_copy(uint16_t port_id, uint32_t queue,
@@ -474,7 +537,7 @@ rte_pcapng_copy(uint16_t port_id, uint32_t queue,
 		const char *comment)
 {
 	struct pcapng_enhance_packet_block *epb;
-	uint32_t orig_len, data_len, padding, flags;
+	uint32_t orig_len, data_len, padding;
 	struct pcapng_option *opt;
 	uint64_t timestamp;
 	uint16_t optlen;
@@ -525,13 +588,7 @@ rte_pcapng_copy(uint16_t port_id, uint32_t queue,
 		memset(tail, 0, padding);
 	}
 
-	optlen = pcapng_optlen(sizeof(flags));
-	optlen += pcapng_optlen(sizeof(queue));
-	if (rss_hash)
-		optlen += pcapng_optlen(sizeof(uint8_t) + sizeof(uint32_t));
-
-	if (comment)
-		optlen += pcapng_optlen(strlen(comment));
+	optlen = pcapng_epb_optlen(rss_hash, comment);
 
 	/* reserve trailing options and block length */
 	opt = (struct pcapng_option *)
@@ -539,40 +596,8 @@ rte_pcapng_copy(uint16_t port_id, uint32_t queue,
 	if (unlikely(opt == NULL))
 		goto fail;
 
-	switch (direction) {
-	case RTE_PCAPNG_DIRECTION_IN:
-		flags = PCAPNG_IFB_INBOUND;
-		break;
-	case RTE_PCAPNG_DIRECTION_OUT:
-		flags = PCAPNG_IFB_OUTBOUND;
-		break;
-	default:
-		flags = 0;
-	}
-
-	opt = pcapng_add_option(opt, PCAPNG_EPB_FLAGS,
-				&flags, sizeof(flags));
-
-	opt = pcapng_add_option(opt, PCAPNG_EPB_QUEUE,
-				&queue, sizeof(queue));
-
-	if (rss_hash) {
-		uint8_t hash_opt[5];
-
-		/* The algorithm could be something else if
-		 * using rte_flow_action_rss; but the current API does not
-		 * have a way for ethdev to report  this on a per-packet basis.
-		 */
-		hash_opt[0] = PCAPNG_HASH_TOEPLITZ;
-
-		memcpy(&hash_opt[1], &md->hash.rss, sizeof(uint32_t));
-		opt = pcapng_add_option(opt, PCAPNG_EPB_HASH,
-					&hash_opt, sizeof(hash_opt));
-	}
-
-	if (comment)
-		opt = pcapng_add_option(opt, PCAPNG_OPT_COMMENT, comment,
-					strlen(comment));
+	opt = pcapng_epb_options(opt, md, queue, direction,
+				 rss_hash, comment);
 
 	/* Note: END_OPT necessary here. Wireshark doesn't do it. */
 
@@ -605,6 +630,140 @@ fail:
 	return NULL;
 }
 
+/*
+ * Zero copy mode can only reference segments whose buffer goes back to
+ * a mempool when the last reference is dropped. External buffers have
+ * a free callback which is only valid in the process that attached it.
+ */
+static bool
+pcapng_can_attach(const struct rte_mbuf *md)
+{
+	const struct rte_mbuf *seg;
+
+	for (seg = md; seg != NULL; seg = seg->next) {
+		if (RTE_MBUF_HAS_EXTBUF(seg))
+			return false;
+	}
+	return true;
+}
+
+/* Make a pcapng block referencing the data of the original mbuf */
+struct rte_mbuf *
+rte_pcapng_attach(uint16_t port_id, uint32_t queue,
+		  struct rte_mbuf *md,
+		  struct rte_mempool *mp,
+		  uint32_t length,
+		  enum rte_pcapng_direction direction,
+		  const char *comment)
+{
+	struct pcapng_enhance_packet_block *epb;
+	uint32_t orig_len, data_len, padding, remain;
+	struct rte_mbuf *mh, *mi, *mt, *seg;
+	struct pcapng_option *opt;
+	uint64_t timestamp;
+	uint16_t optlen;
+	bool rss_hash;
+	uint8_t *tail;
+
+#ifdef RTE_LIBRTE_ETHDEV_DEBUG
+	RTE_ETH_VALID_PORTID_OR_ERR_RET(port_id, NULL);
+#endif
+	/*
+	 * Offloaded VLAN tags have to be put back into the packet data,
+	 * which can not be done without a copy.
+	 */
+	if ((direction == RTE_PCAPNG_DIRECTION_IN &&
+	     (md->ol_flags & (RTE_MBUF_F_RX_VLAN_STRIPPED |
+			      RTE_MBUF_F_RX_QINQ_STRIPPED))) ||
+	    (direction == RTE_PCAPNG_DIRECTION_OUT &&
+	     (md->ol_flags & (RTE_MBUF_F_TX_VLAN | RTE_MBUF_F_TX_QINQ))) ||
+	    !pcapng_can_attach(md))
+		return rte_pcapng_copy(port_id, queue, md, mp, length,
+				       direction, comment);
+
+	orig_len = rte_pktmbuf_pkt_len(md);
+
+	/* Block header goes in its own segment */
+	mh = rte_pktmbuf_alloc(mp);
+	if (unlikely(mh == NULL))
+		return NULL;
+
+	epb = (struct pcapng_enhance_packet_block *)
+		rte_pktmbuf_append(mh, sizeof(*epb));
+	if (unlikely(epb == NULL))
+		goto fail;
+
+	/* Reference the packet data, up to the snapshot length */
+	data_len = 0;
+	remain = RTE_MIN(length, orig_len);
+	for (seg = md; seg != NULL && remain > 0; seg = seg->next) {
+		if (seg->data_len == 0)
+			continue;
+
+		mi = rte_pktmbuf_alloc(mp);
+		if (unlikely(mi == NULL))
+			goto fail;
+
+		rte_pktmbuf_attach(mi, seg);
+		mi->data_len = RTE_MIN(seg->data_len, remain);
+		mi->pkt_len = mi->data_len;
+
+		if (unlikely(rte_pktmbuf_chain(mh, mi) != 0)) {
+			rte_pktmbuf_free(mi);
+			goto fail;
+		}
+		data_len += mi->data_len;
+		remain -= mi->data_len;
+	}
+
+	rss_hash = (direction == RTE_PCAPNG_DIRECTION_IN &&
+		    (md->ol_flags & RTE_MBUF_F_RX_RSS_HASH));
+
+	/* Padding, options and block length go in the last segment */
+	mt = rte_pktmbuf_alloc(mp);
+	if (unlikely(mt == NULL))
+		goto fail;
+
+	if (unlikely(rte_pktmbuf_chain(mh, mt) != 0)) {
+		rte_pktmbuf_free(mt);
+		goto fail;
+	}
+
+	padding = RTE_ALIGN(data_len, sizeof(uint32_t)) - data_len;
+	optlen = pcapng_epb_optlen(rss_hash, comment);
+
+	tail = (uint8_t *)rte_pktmbuf_append(mh, padding + optlen +
+					     sizeof(uint32_t));
+	if (unlikely(tail == NULL))
+		goto fail;
+	memset(tail, 0, padding);
+
+	opt = pcapng_epb_options((struct pcapng_option *)(tail + padding),
+				 md, queue, direction, rss_hash, comment);
+
+	epb->block_type = PCAPNG_ENHANCED_PACKET_BLOCK;
+	epb->block_length = rte_pktmbuf_pkt_len(mh);
+
+	/* Interface index is filled in later during write */
+	mh->port = port_id;
+
+	/* Put timestamp in cycles here - adjust in packet write */
+	timestamp = rte_get_tsc_cycles();
+	epb->timestamp_hi = timestamp >> 32;
+	epb->timestamp_lo = (uint32_t)timestamp;
+	epb->capture_length = data_len;
+	epb->original_length = orig_len;
+
+	/* set trailer of block length */
+	*(uint32_t *)opt = epb->block_length;
+
+	return mh;
+
+fail:
+	rte_pktmbuf_free(mh);
+	return NULL;
+}
+
 /* Write pre-formatted packets to file. */
 ssize_t
 rte_pcapng_write_packets(rte_pcapng_t *self,
@@ -622,7 +781,7 @@ rte_pcapng_write_packets(rte_pcapng_t *self,
 		/* sanity check that is really a pcapng mbuf */
 		epb = rte_pktmbuf_mtod(m, struct pcapng_enhance_packet_block *);
 		if (unlikely(epb->block_type != PCAPNG_ENHANCED_PACKET_BLOCK ||
-			     epb->block_length != rte_pktmbuf_data_len(m))) {
+			     epb->block_length != rte_pktmbuf_pkt_len(m))) {
 			rte_errno = EINVAL;
 			return -1;
 		}
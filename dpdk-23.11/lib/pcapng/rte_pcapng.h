@@ -22,6 +22,7 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <rte_compat.h>
 #include <rte_mempool.h>
 
 #ifdef __cplusplus
@@ -129,6 +130,52 @@ rte_pcapng_copy(uint16_t port_id, uint32_t queue,
 		uint32_t length,
 		enum rte_pcapng_direction direction, const char *comment);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Format an mbuf for writing to file without copying the packet data.
+ *
+ * The result is a chain of an mbuf holding the block header,
+ * indirect mbufs attached to the segments of the original packet,
+ * and an mbuf holding the block trailer. The original packet data
+ * stays referenced until the result is freed, therefore the packet
+ * must not be modified after this call, and the pool of the original
+ * mbuf must be sized to account for packets held by the capture.
+ *
+ * Packets with offloaded VLAN tags or with external buffers
+ * fall back to rte_pcapng_copy().
+ *
+ * @param port_id
+ *   The Ethernet port on which packet was received
+ *   or is going to be transmitted.
+ * @param queue
+ *   The queue on the Ethernet port where packet was received
+ *   or is going to be transmitted.
+ * @param m
+ *   The mbuf to reference.
+ * @param mp
+ *   The mempool from which the header, trailer and indirect mbufs
+ *   are allocated. Up to two more mbufs than segments are needed.
+ * @param length
+ *   The upper limit on bytes to capture.  Passing UINT32_MAX
+ *   means all data.
+ * @param direction
+ *   The direction of the packet: receive, transmit or unknown.
+ * @param comment
+ *   Packet comment.
+ *
+ * @return
+ *   - The pointer to the new mbuf formatted for pcapng_write
+ *   - NULL if allocation fails.
+ */
+__rte_experimental
+struct rte_mbuf *
+rte_pcapng_attach(uint16_t port_id, uint32_t queue,
+		  struct rte_mbuf *m, struct rte_mempool *mp,
+		  uint32_t length,
+		  enum rte_pcapng_direction direction, const char *comment);
+
 
 /**
  * Determine optimum mbuf data size.
@@ -146,6 +193,7 @@ rte_pcapng_mbuf_size(uint32_t length);
  * Write packets to the capture file.
  *
  * Packets to be captured are copied by rte_pcapng_copy()
+ * or referenced by rte_pcapng_attach()
  * and then this function is called to write them to the file.
  *
  * @warning
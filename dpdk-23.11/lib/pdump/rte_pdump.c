@@ -12,6 +12,7 @@
 #include <rte_errno.h>
 #include <rte_string_fns.h>
 #include <rte_pcapng.h>
+#include <rte_telemetry.h>
 
 #include "rte_pdump.h"
 
@@ -62,6 +63,7 @@ static struct pdump_rxtx_cbs {
 	const struct rte_bpf *filter;
 	enum pdump_version ver;
 	uint32_t snaplen;
+	bool zero_copy;
 } rx_cbs[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT],
 tx_cbs[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT];
 
@@ -70,14 +72,53 @@ tx_cbs[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT];
  * The packet capture statistics keep track of packets
  * accepted, filtered and dropped. These are per-queue
  * and in memory between primary and secondary processes.
+ * The count of capture triggers is shared the same way.
  */
 static const char MZ_RTE_PDUMP_STATS[] = "rte_pdump_stats";
 static struct {
 	struct rte_pdump_stats rx[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT];
 	struct rte_pdump_stats tx[RTE_MAX_ETHPORTS][RTE_MAX_QUEUES_PER_PORT];
+	RTE_ATOMIC(uint64_t) triggers;
 	const struct rte_memzone *mz;
 } *pdump_stats;
 
+/*
+ * Reference the packet data with indirect mbufs, dropping the segments
+ * past the snapshot length. The buffers of the original packet are
+ * released by the capture process, so external buffers can't be shared.
+ */
+static struct rte_mbuf *
+pdump_clone(struct rte_mbuf *md, struct rte_mempool *mp, uint32_t snaplen)
+{
+	struct rte_mbuf *mc, *seg, *last;
+	uint32_t len;
+
+	for (seg = md; seg != NULL; seg = seg->next) {
+		if (RTE_MBUF_HAS_EXTBUF(seg))
+			return rte_pktmbuf_copy(md, mp, 0, snaplen);
+	}
+
+	mc = rte_pktmbuf_clone(md, mp);
+	if (unlikely(mc == NULL) || rte_pktmbuf_pkt_len(mc) <= snaplen)
+		return mc;
+
+	/* find the segment where the snapshot ends */
+	len = 0;
+	for (last = mc; len + last->data_len < snaplen; last = last->next)
+		len += last->data_len;
+
+	last->data_len = snaplen - len;
+	rte_pktmbuf_free(last->next);
+	last->next = NULL;
+
+	mc->pkt_len = snaplen;
+	mc->nb_segs = 1;
+	for (seg = mc; seg != last; seg = seg->next)
+		mc->nb_segs++;
+
+	return mc;
+}
+
 /* Create a clone of mbuf to be placed into ring. */
 static void
 pdump_copy(uint16_t port_id, uint16_t queue,
@@ -117,10 +158,16 @@ pdump_copy(uint16_t port_id, uint16_t queue,
 		 * If using pcapng then want to wrap packets
 		 * otherwise a simple copy.
 		 */
-		if (cbs->ver == V2)
+		if (cbs->ver == V2 && cbs->zero_copy)
+			p = rte_pcapng_attach(port_id, queue,
+					      pkts[i], mp, cbs->snaplen,
+					      direction, NULL);
+		else if (cbs->ver == V2)
 			p = rte_pcapng_copy(port_id, queue,
 					    pkts[i], mp, cbs->snaplen,
 					    direction, NULL);
+		else if (cbs->zero_copy)
+			p = pdump_clone(pkts[i], mp, cbs->snaplen);
 		else
 			p = rte_pktmbuf_copy(pkts[i], mp, 0, cbs->snaplen);
 
@@ -166,15 +213,77 @@ pdump_tx(uint16_t port, uint16_t queue,
 	return nb_pkts;
 }
 
+/*
+ * With fast free the driver puts transmitted mbufs back in the pool
+ * without looking at the reference count, so the data can not be shared.
+ */
+static bool
+pdump_txq_fast_free(uint16_t port, uint16_t queue)
+{
+	struct rte_eth_txq_info qinfo;
+	struct rte_eth_conf dev_conf;
+	uint64_t offloads = 0;
+
+	if (rte_eth_dev_conf_get(port, &dev_conf) == 0)
+		offloads |= dev_conf.txmode.offloads;
+	if (rte_eth_tx_queue_info_get(port, queue, &qinfo) == 0)
+		offloads |= qinfo.conf.offloads;
+
+	return (offloads & RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE) != 0;
+}
+
+static bool
+pdump_tx_fast_free(uint16_t port, uint16_t queue)
+{
+	if (pdump_txq_fast_free(port, queue)) {
+		PDUMP_LOG(NOTICE,
+			"port=%d queue=%d uses mbuf fast free, zero copy disabled\n",
+			port, queue);
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * A received mbuf may be forwarded to any port, so its data can not be
+ * shared if a transmit queue of any port uses fast free.
+ */
+static bool
+pdump_rx_fast_free(uint16_t port)
+{
+	struct rte_eth_dev_info dev_info;
+	uint16_t p, qid;
+
+	RTE_ETH_FOREACH_DEV(p) {
+		if (rte_eth_dev_info_get(p, &dev_info) != 0)
+			continue;
+		for (qid = 0; qid < dev_info.nb_tx_queues; qid++) {
+			if (pdump_txq_fast_free(p, qid)) {
+				PDUMP_LOG(NOTICE,
+					"port=%d rx mbufs may be freed by port=%d queue=%d using mbuf fast free, zero copy disabled\n",
+					port, p, qid);
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
 static int
 pdump_register_rx_callbacks(enum pdump_version ver,
 			    uint16_t end_q, uint16_t port, uint16_t queue,
 			    struct rte_ring *ring, struct rte_mempool *mp,
 			    struct rte_bpf *filter,
-			    uint16_t operation, uint32_t snaplen)
+			    uint16_t operation, uint32_t snaplen,
+			    bool zero_copy)
 {
 	uint16_t qid;
 
+	if (operation == ENABLE && zero_copy)
+		zero_copy = !pdump_rx_fast_free(port);
+
 	qid = (queue == RTE_PDUMP_ALL_QUEUES) ? 0 : queue;
 	for (; qid < end_q; qid++) {
 		struct pdump_rxtx_cbs *cbs = &rx_cbs[port][qid];
@@ -191,6 +300,7 @@ pdump_register_rx_callbacks(enum pdump_version ver,
 			cbs->mp = mp;
 			cbs->snaplen = snaplen;
 			cbs->filter = filter;
+			cbs->zero_copy = zero_copy;
 
 			cbs->cb = rte_eth_add_first_rx_callback(port, qid,
 								pdump_rx, cbs);
@@ -228,7 +338,8 @@ pdump_register_tx_callbacks(enum pdump_version ver,
 			    uint16_t end_q, uint16_t port, uint16_t queue,
 			    struct rte_ring *ring, struct rte_mempool *mp,
 			    struct rte_bpf *filter,
-			    uint16_t operation, uint32_t snaplen)
+			    uint16_t operation, uint32_t snaplen,
+			    bool zero_copy)
 {
 
 	uint16_t qid;
@@ -249,6 +360,8 @@ pdump_register_tx_callbacks(enum pdump_version ver,
 			cbs->mp = mp;
 			cbs->snaplen = snaplen;
 			cbs->filter = filter;
+			cbs->zero_copy = zero_copy &&
+				!pdump_tx_fast_free(port, qid);
 
 			cbs->cb = rte_eth_add_tx_callback(port, qid, pdump_tx,
 								cbs);
@@ -292,6 +405,7 @@ set_pdump_rxtx_cbs(const struct pdump_request *p)
 	uint16_t operation;
 	struct rte_ring *ring;
 	struct rte_mempool *mp;
+	bool zero_copy;
 
 	/* Check for possible DPDK version mismatch */
 	if (!(p->ver == V1 || p->ver == V2)) {
@@ -317,6 +431,7 @@ set_pdump_rxtx_cbs(const struct pdump_request *p)
 	}
 
 	flags = p->flags;
+	zero_copy = (flags & RTE_PDUMP_FLAG_ZERO_COPY) != 0;
 	operation = p->op;
 	queue = p->queue;
 	ring = p->ring;
@@ -355,7 +470,7 @@ set_pdump_rxtx_cbs(const struct pdump_request *p)
 			return -EINVAL;
 		}
 		if ((nb_tx_q == 0 || nb_rx_q == 0) &&
-			flags == RTE_PDUMP_FLAG_RXTX) {
+			(flags & RTE_PDUMP_FLAG_RXTX) == RTE_PDUMP_FLAG_RXTX) {
 			PDUMP_LOG(ERR,
 				"both tx&rx queues must be non zero\n");
 			return -EINVAL;
@@ -367,7 +482,8 @@ set_pdump_rxtx_cbs(const struct pdump_request *p)
 		end_q = (queue == RTE_PDUMP_ALL_QUEUES) ? nb_rx_q : queue + 1;
 		ret = pdump_register_rx_callbacks(p->ver, end_q, port, queue,
 						  ring, mp, filter,
-						  operation, p->snaplen);
+						  operation, p->snaplen,
+						  zero_copy);
 		if (ret < 0)
 			return ret;
 	}
@@ -377,7 +493,8 @@ set_pdump_rxtx_cbs(const struct pdump_request *p)
 		end_q = (queue == RTE_PDUMP_ALL_QUEUES) ? nb_tx_q : queue + 1;
 		ret = pdump_register_tx_callbacks(p->ver, end_q, port, queue,
 						  ring, mp, filter,
-						  operation, p->snaplen);
+						  operation, p->snaplen,
+						  zero_copy);
 		if (ret < 0)
 			return ret;
 	}
@@ -488,7 +605,8 @@ pdump_validate_flags(uint32_t flags)
 	}
 
 	/* mask off the flags we know about */
-	if (flags & ~(RTE_PDUMP_FLAG_RXTX | RTE_PDUMP_FLAG_PCAPNG)) {
+	if (flags & ~(RTE_PDUMP_FLAG_RXTX | RTE_PDUMP_FLAG_PCAPNG |
+		      RTE_PDUMP_FLAG_ZERO_COPY)) {
 		PDUMP_LOG(ERR,
 			  "unknown flags: %#x\n", flags);
 		rte_errno = ENOTSUP;
@@ -544,7 +662,7 @@ pdump_prepare_client_request(const char *device, uint16_t queue,
 	memset(req, 0, sizeof(*req));
 
 	req->ver = (flags & RTE_PDUMP_FLAG_PCAPNG) ? V2 : V1;
-	req->flags = flags & RTE_PDUMP_FLAG_RXTX;
+	req->flags = flags & (RTE_PDUMP_FLAG_RXTX | RTE_PDUMP_FLAG_ZERO_COPY);
 	req->op = operation;
 	req->queue = queue;
 	rte_strscpy(req->device, device, sizeof(req->device));
@@ -728,11 +846,38 @@ pdump_sum_stats(uint16_t port, uint16_t nq,
 	}
 }
 
+static int
+pdump_stats_lookup(void)
+{
+	const struct rte_memzone *mz;
+
+	if (pdump_stats != NULL)
+		return 0;
+
+	if (rte_eal_process_type() == RTE_PROC_PRIMARY) {
+		/* rte_pdump_init was not called */
+		PDUMP_LOG(ERR, "pdump stats not initialized\n");
+		rte_errno = EINVAL;
+		return -1;
+	}
+
+	/* secondary process looks up the memzone */
+	mz = rte_memzone_lookup(MZ_RTE_PDUMP_STATS);
+	if (mz == NULL) {
+		/* rte_pdump_init was not called in primary process?? */
+		PDUMP_LOG(ERR, "can not find pdump stats\n");
+		rte_errno = EINVAL;
+		return -1;
+	}
+	pdump_stats = mz->addr;
+
+	return 0;
+}
+
 int
 rte_pdump_stats(uint16_t port, struct rte_pdump_stats *stats)
 {
 	struct rte_eth_dev_info dev_info;
-	const struct rte_memzone *mz;
 	int ret;
 
 	memset(stats, 0, sizeof(*stats));
@@ -744,26 +889,95 @@ rte_pdump_stats(uint16_t port, struct rte_pdump_stats *stats)
 		return ret;
 	}
 
-	if (pdump_stats == NULL) {
-		if (rte_eal_process_type() == RTE_PROC_PRIMARY) {
-			/* rte_pdump_init was not called */
-			PDUMP_LOG(ERR, "pdump stats not initialized\n");
-			rte_errno = EINVAL;
-			return -1;
-		}
+	if (pdump_stats_lookup() < 0)
+		return -1;
+
+	pdump_sum_stats(port, dev_info.nb_rx_queues, pdump_stats->rx, stats);
+	pdump_sum_stats(port, dev_info.nb_tx_queues, pdump_stats->tx, stats);
+	return 0;
+}
+
+int
+rte_pdump_trigger(void)
+{
+	if (pdump_stats_lookup() < 0)
+		return -1;
+
+	rte_atomic_fetch_add_explicit(&pdump_stats->triggers, 1,
+				      rte_memory_order_release);
+	return 0;
+}
+
+int
+rte_pdump_trigger_count(uint64_t *count)
+{
+	if (count == NULL) {
+		rte_errno = EINVAL;
+		return -1;
+	}
 
-		/* secondary process looks up the memzone */
-		mz = rte_memzone_lookup(MZ_RTE_PDUMP_STATS);
-		if (mz == NULL) {
-			/* rte_pdump_init was not called in primary process?? */
-			PDUMP_LOG(ERR, "can not find pdump stats\n");
-			rte_errno = EINVAL;
-			return -1;
+	if (pdump_stats_lookup() < 0)
+		return -1;
+
+	*count = rte_atomic_load_explicit(&pdump_stats->triggers,
+					  rte_memory_order_acquire);
+	return 0;
+}
+
+static void
+pdump_put_seg(struct rte_mbuf *m)
+{
+	m = rte_pktmbuf_prefree_seg(m);
+	if (m != NULL)
+		rte_mempool_generic_put(m->pool, (void **)&m, 1, NULL);
+}
+
+void
+rte_pdump_free_bulk(struct rte_mbuf **pkts, unsigned int n)
+{
+	struct rte_mbuf *m, *md, *next;
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		for (m = pkts[i]; m != NULL; m = next) {
+			next = m->next;
+
+			/*
+			 * Hold the mbuf attached to a segment being freed,
+			 * or detaching the segment would free it through
+			 * the cache.
+			 */
+			md = NULL;
+			if (RTE_MBUF_CLONED(m) &&
+			    rte_mbuf_refcnt_read(m) == 1) {
+				md = rte_mbuf_from_indirect(m);
+				rte_mbuf_refcnt_update(md, 1);
+			}
+
+			pdump_put_seg(m);
+			if (md != NULL)
+				pdump_put_seg(md);
 		}
-		pdump_stats = mz->addr;
 	}
+}
 
-	pdump_sum_stats(port, dev_info.nb_rx_queues, pdump_stats->rx, stats);
-	pdump_sum_stats(port, dev_info.nb_tx_queues, pdump_stats->tx, stats);
+static int
+pdump_handle_trigger(const char *cmd __rte_unused,
+		     const char *params __rte_unused,
+		     struct rte_tel_data *d)
+{
+	uint64_t count;
+
+	if (rte_pdump_trigger() < 0 || rte_pdump_trigger_count(&count) < 0)
+		return -EINVAL;
+
+	rte_tel_data_start_dict(d);
+	rte_tel_data_add_dict_uint(d, "triggers", count);
 	return 0;
 }
+
+RTE_INIT(pdump_init_telemetry)
+{
+	rte_telemetry_register_cmd("/pdump/trigger", pdump_handle_trigger,
+			"Raise a packet capture trigger. Takes no parameters");
+}
@@ -15,6 +15,7 @@
 #include <stdint.h>
 
 #include <rte_bpf.h>
+#include <rte_compat.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,6 +30,9 @@ enum {
 	RTE_PDUMP_FLAG_RXTX = (RTE_PDUMP_FLAG_RX|RTE_PDUMP_FLAG_TX),
 
 	RTE_PDUMP_FLAG_PCAPNG = 4, /* format for pcapng */
+
+	/* reference packet data instead of copying (experimental) */
+	RTE_PDUMP_FLAG_ZERO_COPY = 8,
 };
 
 /**
@@ -246,6 +250,61 @@ struct rte_pdump_stats {
 int
 rte_pdump_stats(uint16_t port_id, struct rte_pdump_stats *stats);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Raise a packet capture trigger.
+ *
+ * Capture applications which retain packets in memory until an event,
+ * like dpdk-dumpcap with a pre-trigger window, write them to file
+ * when the count of triggers changes.
+ * The same is done by the /pdump/trigger telemetry command.
+ *
+ * @return
+ *   Zero if successful. -1 on error and rte_errno is set.
+ */
+__rte_experimental
+int
+rte_pdump_trigger(void);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Retrieve the number of packet capture triggers raised.
+ *
+ * @param count
+ *   A pointer to be filled with the number of triggers.
+ * @return
+ *   Zero if successful. -1 on error and rte_errno is set.
+ */
+__rte_experimental
+int
+rte_pdump_trigger_count(uint64_t *count);
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Free captured packets without the mempool cache of the calling lcore.
+ *
+ * A capture process is a secondary process, whose lcore ids are also used
+ * by the primary process, so it must not use the per-lcore cache of a
+ * mempool shared with the primary process. With RTE_PDUMP_FLAG_ZERO_COPY,
+ * the captured packets reference mbufs of the primary process, which are
+ * returned to their pool by the capture process when it frees the last
+ * reference.
+ *
+ * @param pkts
+ *   Array of captured packets to free. NULL entries are ignored.
+ * @param n
+ *   Number of elements in pkts array.
+ */
+__rte_experimental
+void
+rte_pdump_free_bulk(struct rte_mbuf **pkts, unsigned int n);
+
 
 #ifdef __cplusplus
 }
@@ -12,6 +12,7 @@
 #include <rte_eal_memconfig.h>
 #include <rte_errno.h>
 #include <rte_malloc.h>
+#include <rte_stdatomic.h>
 #include <rte_tailq.h>
 
 #include "rte_reorder.h"
@@ -42,31 +43,86 @@ struct cir_buffer {
 	struct rte_mbuf **entries;
 } __rte_cache_aligned;
 
+/*
+ * Slot of the multi-producer order buffer. The tag holds the sequence
+ * number the slot is waiting for in its upper 32 bits and the slot state
+ * in the lower ones, so that a producer claims a slot for its sequence
+ * number with a single compare and swap.
+ */
+#define MP_SLOT_EMPTY	0 /**< Waiting for the packet */
+#define MP_SLOT_BUSY	1 /**< Claimed by a producer, mbuf being written */
+#define MP_SLOT_FULL	2 /**< Packet available for the consumer */
+#define MP_SLOT_TAG(seqn, state)	(((uint64_t)(seqn) << 32) | (state))
+
+struct mp_slot {
+	RTE_ATOMIC(uint64_t) tag;
+	struct rte_mbuf *mbuf;
+};
+
+/* Order buffer shared by producers and the consumer */
+struct mp_buffer {
+	RTE_ATOMIC(uint32_t) min_seqn; /**< Lowest seq. number, consumer owned */
+	RTE_ATOMIC(uint32_t) skip_seqn; /**< min_seqn requested by early packets */
+	struct mp_slot *slots;
+} __rte_cache_aligned;
+
 /* The reorder buffer data structure itself */
 struct rte_reorder_buffer {
 	char name[RTE_REORDER_NAMESIZE];
 	uint32_t min_seqn;  /**< Lowest seq. number that can be in the buffer */
 	unsigned int memsize; /**< memory area size of reorder buffer */
 	bool is_initialized; /**< flag indicates that buffer was initialized */
+	uint32_t flags; /**< RTE_REORDER_F_* */
+	unsigned int init_window; /**< Window size at creation and reset */
+	RTE_ATOMIC(uint32_t) window; /**< Current window, up to order_buf.size */
 
 	struct cir_buffer ready_buf; /**< temp buffer for dequeued entries */
 	struct cir_buffer order_buf; /**< buffer used to reorder entries */
+	struct mp_buffer mp; /**< order entries in multi-producer mode */
 } __rte_cache_aligned;
 
 static void
 rte_reorder_free_mbufs(struct rte_reorder_buffer *b);
 
+static unsigned int
+reorder_footprint(unsigned int size, uint32_t flags)
+{
+	if (flags & RTE_REORDER_F_MP_INSERT)
+		return sizeof(struct rte_reorder_buffer) + size * sizeof(struct mp_slot);
+
+	return sizeof(struct rte_reorder_buffer) + (2 * size * sizeof(struct rte_mbuf *));
+}
+
 unsigned int
 rte_reorder_memory_footprint_get(unsigned int size)
 {
-	return sizeof(struct rte_reorder_buffer) + (2 * size * sizeof(struct rte_mbuf *));
+	return reorder_footprint(size, 0);
 }
 
-struct rte_reorder_buffer *
-rte_reorder_init(struct rte_reorder_buffer *b, unsigned int bufsize,
-		const char *name, unsigned int size)
+/* Make every slot wait for its first sequence number from min_seqn on */
+static void
+reorder_mp_slots_init(struct rte_reorder_buffer *b, uint32_t min_seqn)
+{
+	unsigned int i;
+
+	for (i = 0; i < b->order_buf.size; i++) {
+		b->mp.slots[i].mbuf = NULL;
+		rte_atomic_store_explicit(&b->mp.slots[i].tag,
+			MP_SLOT_TAG(min_seqn + ((i - min_seqn) & b->order_buf.mask),
+				MP_SLOT_EMPTY), rte_memory_order_relaxed);
+	}
+	rte_atomic_store_explicit(&b->mp.skip_seqn, min_seqn,
+		rte_memory_order_relaxed);
+	rte_atomic_store_explicit(&b->mp.min_seqn, min_seqn,
+		rte_memory_order_release);
+}
+
+static struct rte_reorder_buffer *
+reorder_init(struct rte_reorder_buffer *b, unsigned int bufsize,
+		const char *name, unsigned int size, unsigned int max_size,
+		uint32_t flags)
 {
-	const unsigned int min_bufsize = rte_reorder_memory_footprint_get(size);
+	const unsigned int min_bufsize = reorder_footprint(max_size, flags);
 	static const struct rte_mbuf_dynfield reorder_seqn_dynfield_desc = {
 		.name = RTE_REORDER_SEQN_DYNFIELD_NAME,
 		.size = sizeof(rte_reorder_seqn_t),
@@ -110,15 +166,36 @@ rte_reorder_init(struct rte_reorder_buffer *b, unsigned int bufsize,
 	memset(b, 0, bufsize);
 	strlcpy(b->name, name, sizeof(b->name));
 	b->memsize = bufsize;
-	b->order_buf.size = b->ready_buf.size = size;
-	b->order_buf.mask = b->ready_buf.mask = size - 1;
+	b->flags = flags;
+	b->init_window = size;
+	b->window = size;
+	b->order_buf.size = max_size;
+	b->order_buf.mask = max_size - 1;
+
+	if (flags & RTE_REORDER_F_MP_INSERT) {
+		/* Sequence numbers start from 0, see rte_reorder_min_seqn_set() */
+		b->is_initialized = true;
+		b->mp.slots = (void *)&b[1];
+		reorder_mp_slots_init(b, 0);
+		return b;
+	}
+
+	b->ready_buf.size = max_size;
+	b->ready_buf.mask = max_size - 1;
 	b->ready_buf.entries = (void *)&b[1];
 	b->order_buf.entries = RTE_PTR_ADD(&b[1],
-			size * sizeof(b->ready_buf.entries[0]));
+			max_size * sizeof(b->ready_buf.entries[0]));
 
 	return b;
 }
 
+struct rte_reorder_buffer *
+rte_reorder_init(struct rte_reorder_buffer *b, unsigned int bufsize,
+		const char *name, unsigned int size)
+{
+	return reorder_init(b, bufsize, name, size, size, 0);
+}
+
 /*
  * Insert new entry into global list.
  * Returns pointer to already inserted entry if such exists, or to newly inserted one.
@@ -151,27 +228,14 @@ rte_reorder_entry_insert(struct rte_tailq_entry *new_te)
 	return te;
 }
 
-struct rte_reorder_buffer*
-rte_reorder_create(const char *name, unsigned socket_id, unsigned int size)
+static struct rte_reorder_buffer *
+reorder_create(const char *name, unsigned int socket_id, unsigned int size,
+		unsigned int max_size, uint32_t flags)
 {
 	struct rte_reorder_buffer *b = NULL;
 	struct rte_tailq_entry *te, *te_inserted;
 
-	const unsigned int bufsize = rte_reorder_memory_footprint_get(size);
-
-	/* Check user arguments. */
-	if (!rte_is_power_of_2(size)) {
-		RTE_LOG(ERR, REORDER, "Invalid reorder buffer size"
-				" - Not a power of 2\n");
-		rte_errno = EINVAL;
-		return NULL;
-	}
-	if (name == NULL) {
-		RTE_LOG(ERR, REORDER, "Invalid reorder buffer name ptr:"
-					" NULL\n");
-		rte_errno = EINVAL;
-		return NULL;
-	}
+	const unsigned int bufsize = reorder_footprint(max_size, flags);
 
 	/* allocate tailq entry */
 	te = rte_zmalloc("REORDER_TAILQ_ENTRY", sizeof(*te), 0);
@@ -189,7 +253,7 @@ rte_reorder_create(const char *name, unsigned socket_id, unsigned int size)
 		rte_free(te);
 		return NULL;
 	} else {
-		if (rte_reorder_init(b, bufsize, name, size) == NULL) {
+		if (reorder_init(b, bufsize, name, size, max_size, flags) == NULL) {
 			rte_free(b);
 			rte_free(te);
 			return NULL;
@@ -207,6 +271,58 @@ rte_reorder_create(const char *name, unsigned socket_id, unsigned int size)
 	return b;
 }
 
+struct rte_reorder_buffer*
+rte_reorder_create(const char *name, unsigned socket_id, unsigned int size)
+{
+	/* Check user arguments. */
+	if (!rte_is_power_of_2(size)) {
+		RTE_LOG(ERR, REORDER, "Invalid reorder buffer size"
+				" - Not a power of 2\n");
+		rte_errno = EINVAL;
+		return NULL;
+	}
+	if (name == NULL) {
+		RTE_LOG(ERR, REORDER, "Invalid reorder buffer name ptr:"
+					" NULL\n");
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	return reorder_create(name, socket_id, size, size, 0);
+}
+
+struct rte_reorder_buffer *
+rte_reorder_create_with_conf(const char *name, unsigned int socket_id,
+		const struct rte_reorder_conf *conf)
+{
+	unsigned int max_size;
+
+	/* Check user arguments. */
+	if (name == NULL || conf == NULL) {
+		RTE_LOG(ERR, REORDER, "Invalid reorder buffer parameter:"
+					" NULL\n");
+		rte_errno = EINVAL;
+		return NULL;
+	}
+	max_size = conf->max_size != 0 ? conf->max_size : conf->size;
+	if (!rte_is_power_of_2(conf->size) || !rte_is_power_of_2(max_size) ||
+			max_size < conf->size) {
+		RTE_LOG(ERR, REORDER, "Invalid reorder buffer size: %u, max: %u"
+				" - Not powers of 2 in order\n",
+				conf->size, conf->max_size);
+		rte_errno = EINVAL;
+		return NULL;
+	}
+	if (conf->flags & ~RTE_REORDER_F_MP_INSERT) {
+		RTE_LOG(ERR, REORDER, "Invalid reorder buffer flags: 0x%x\n",
+				conf->flags);
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	return reorder_create(name, socket_id, conf->size, max_size, conf->flags);
+}
+
 void
 rte_reorder_reset(struct rte_reorder_buffer *b)
 {
@@ -215,7 +331,8 @@ rte_reorder_reset(struct rte_reorder_buffer *b)
 	rte_reorder_free_mbufs(b);
 	strlcpy(name, b->name, sizeof(name));
 	/* No error checking as current values should be valid */
-	rte_reorder_init(b, b->memsize, name, b->order_buf.size);
+	reorder_init(b, b->memsize, name, b->init_window, b->order_buf.size,
+			b->flags);
 }
 
 static void
@@ -223,6 +340,16 @@ rte_reorder_free_mbufs(struct rte_reorder_buffer *b)
 {
 	unsigned i;
 
+	if (b->flags & RTE_REORDER_F_MP_INSERT) {
+		for (i = 0; i < b->order_buf.size; i++) {
+			if ((rte_atomic_load_explicit(&b->mp.slots[i].tag,
+					rte_memory_order_acquire) & UINT32_MAX) ==
+					MP_SLOT_FULL)
+				rte_pktmbuf_free(b->mp.slots[i].mbuf);
+		}
+		return;
+	}
+
 	/* Free up the mbufs of order buffer & ready buffer */
 	for (i = 0; i < b->order_buf.size; i++) {
 		rte_pktmbuf_free(b->order_buf.entries[i]);
@@ -345,16 +472,30 @@ rte_reorder_fill_overflow(struct rte_reorder_buffer *b, unsigned n)
 	return order_head_adv;
 }
 
-int
-rte_reorder_insert(struct rte_reorder_buffer *b, struct rte_mbuf *mbuf)
+/*
+ * Early packets just outside the window are a sign of out of order bursts
+ * deeper than the window: rather than skipping the missing packets, double
+ * the window while the buffer has room for it.
+ */
+static uint32_t
+reorder_window_grow(struct rte_reorder_buffer *b, uint32_t window)
 {
-	uint32_t offset, position;
-	struct cir_buffer *order_buf;
+	const uint32_t new_window = RTE_MIN(2 * window, b->order_buf.size);
 
-	if (b == NULL || mbuf == NULL) {
-		rte_errno = EINVAL;
-		return -1;
-	}
+	if (rte_atomic_compare_exchange_strong_explicit(&b->window, &window,
+			new_window, rte_memory_order_relaxed,
+			rte_memory_order_relaxed))
+		return new_window;
+
+	/* Grown concurrently by another producer */
+	return window;
+}
+
+static int
+reorder_sp_insert(struct rte_reorder_buffer *b, struct rte_mbuf *mbuf)
+{
+	uint32_t offset, position, window;
+	struct cir_buffer *order_buf;
 
 	order_buf = &b->order_buf;
 	if (!b->is_initialized) {
@@ -372,11 +513,16 @@ rte_reorder_insert(struct rte_reorder_buffer *b, struct rte_mbuf *mbuf)
 	 */
 	offset = *rte_reorder_seqn(mbuf) - b->min_seqn;
 
+	window = rte_atomic_load_explicit(&b->window, rte_memory_order_relaxed);
+	if (offset >= window && offset < 2 * window &&
+			window < order_buf->size)
+		window = reorder_window_grow(b, window);
+
 	/*
 	 * action to take depends on offset.
-	 * offset < buffer->size: the mbuf fits within the current window of
+	 * offset < window: the mbuf fits within the current window of
 	 *    sequence numbers we can reorder. EXPECTED CASE.
-	 * offset > buffer->size: the mbuf is outside the current window. There
+	 * offset > window: the mbuf is outside the current window. There
 	 *    are a number of cases to consider:
 	 *    1. The packet sequence is just outside the window, then we need
 	 *       to see about shifting the head pointer and taking any ready
@@ -385,17 +531,17 @@ rte_reorder_insert(struct rte_reorder_buffer *b, struct rte_mbuf *mbuf)
 	 *       this case will skip over the dropped packet instead, and any
 	 *       packets dequeued here will be returned on the next drain call.
 	 *    2. The packet sequence number is vastly outside our window, taken
-	 *       here as having offset greater than twice the buffer size. In
+	 *       here as having offset greater than twice the window. In
 	 *       this case, the packet is probably an old or late packet that
 	 *       was previously skipped, so just enqueue the packet for
 	 *       immediate return on the next drain call, or else return error.
 	 */
-	if (offset < b->order_buf.size) {
+	if (offset < window) {
 		position = (order_buf->head + offset) & order_buf->mask;
 		order_buf->entries[position] = mbuf;
-	} else if (offset < 2 * b->order_buf.size) {
-		if (rte_reorder_fill_overflow(b, offset + 1 - order_buf->size)
-				< (offset + 1 - order_buf->size)) {
+	} else if (offset < 2 * window) {
+		if (rte_reorder_fill_overflow(b, offset + 1 - window)
+				< (offset + 1 - window)) {
 			/* Put in handling for enqueue straight to output */
 			rte_errno = ENOSPC;
 			return -1;
@@ -411,15 +557,209 @@ rte_reorder_insert(struct rte_reorder_buffer *b, struct rte_mbuf *mbuf)
 	return 0;
 }
 
+/*
+ * Ask the consumer to skip missing packets up to min_seqn (exclusive),
+ * unless a further skip is already requested.
+ */
+static void
+reorder_mp_skip_request(struct rte_reorder_buffer *b, uint32_t cur_min_seqn,
+		uint32_t min_seqn)
+{
+	uint32_t skip_seqn;
+
+	skip_seqn = rte_atomic_load_explicit(&b->mp.skip_seqn,
+			rte_memory_order_relaxed);
+	do {
+		/* A pending request is ahead of the window minimum */
+		if (skip_seqn - cur_min_seqn - 1 < b->order_buf.size &&
+				(int32_t)(skip_seqn - min_seqn) >= 0)
+			return;
+	} while (!rte_atomic_compare_exchange_weak_explicit(&b->mp.skip_seqn,
+			&skip_seqn, min_seqn, rte_memory_order_release,
+			rte_memory_order_relaxed));
+}
+
+/*
+ * Multi-producer insert. The window minimum may be stale, in which case
+ * the packet is only seen further from it than it really is: it is
+ * refreshed before refusing the packet. A packet late for a slot the
+ * consumer already skipped or drained finds the slot waiting for a later
+ * sequence number.
+ */
+static int
+reorder_mp_insert(struct rte_reorder_buffer *b, struct rte_mbuf *mbuf,
+		uint32_t *min_seqn)
+{
+	const uint32_t seqn = *rte_reorder_seqn(mbuf);
+	uint32_t offset, window, cur_min_seqn;
+	struct mp_slot *slot;
+	uint64_t tag;
+
+	for (;;) {
+		offset = seqn - *min_seqn;
+		window = rte_atomic_load_explicit(&b->window,
+				rte_memory_order_relaxed);
+		if (offset < window)
+			break;
+
+		cur_min_seqn = rte_atomic_load_explicit(&b->mp.min_seqn,
+				rte_memory_order_acquire);
+		if (cur_min_seqn != *min_seqn) {
+			*min_seqn = cur_min_seqn;
+			continue;
+		}
+
+		if (offset < 2 * window && window < b->order_buf.size) {
+			window = reorder_window_grow(b, window);
+			if (offset < window)
+				break;
+		}
+
+		if (offset < 2 * window) {
+			/* Retry once the consumer has moved the window on drain */
+			reorder_mp_skip_request(b, *min_seqn, seqn + 1 - window);
+			rte_errno = ENOSPC;
+		} else {
+			rte_errno = ERANGE;
+		}
+		return -1;
+	}
+
+	slot = &b->mp.slots[seqn & b->order_buf.mask];
+	tag = MP_SLOT_TAG(seqn, MP_SLOT_EMPTY);
+	if (!rte_atomic_compare_exchange_strong_explicit(&slot->tag, &tag,
+			MP_SLOT_TAG(seqn, MP_SLOT_BUSY), rte_memory_order_acquire,
+			rte_memory_order_relaxed)) {
+		/* Skipped as missing, or duplicate sequence number */
+		rte_errno = ERANGE;
+		return -1;
+	}
+	slot->mbuf = mbuf;
+	rte_atomic_store_explicit(&slot->tag, MP_SLOT_TAG(seqn, MP_SLOT_FULL),
+			rte_memory_order_release);
+
+	return 0;
+}
+
+int
+rte_reorder_insert(struct rte_reorder_buffer *b, struct rte_mbuf *mbuf)
+{
+	uint32_t min_seqn;
+
+	if (b == NULL || mbuf == NULL) {
+		rte_errno = EINVAL;
+		return -1;
+	}
+
+	if (b->flags & RTE_REORDER_F_MP_INSERT) {
+		min_seqn = rte_atomic_load_explicit(&b->mp.min_seqn,
+				rte_memory_order_acquire);
+		return reorder_mp_insert(b, mbuf, &min_seqn);
+	}
+
+	return reorder_sp_insert(b, mbuf);
+}
+
+unsigned int
+rte_reorder_insert_bulk(struct rte_reorder_buffer *b, struct rte_mbuf **mbufs,
+		unsigned int nb_mbufs)
+{
+	uint32_t min_seqn;
+	unsigned int i;
+
+	if (b == NULL || (mbufs == NULL && nb_mbufs != 0)) {
+		rte_errno = EINVAL;
+		return 0;
+	}
+
+	if (b->flags & RTE_REORDER_F_MP_INSERT) {
+		/* The window minimum is only refreshed for early packets */
+		min_seqn = rte_atomic_load_explicit(&b->mp.min_seqn,
+				rte_memory_order_acquire);
+		for (i = 0; i < nb_mbufs; i++) {
+			if (reorder_mp_insert(b, mbufs[i], &min_seqn) != 0)
+				break;
+		}
+		return i;
+	}
+
+	for (i = 0; i < nb_mbufs; i++) {
+		if (reorder_sp_insert(b, mbufs[i]) != 0)
+			break;
+	}
+	return i;
+}
+
+/*
+ * Multi-producer drain: move the window by up to nb_seqn sequence numbers,
+ * returning the packets found and skipping the missing ones among the
+ * first nb_skip. A slot being written by a producer stops the drain.
+ */
+static unsigned int
+reorder_mp_drain(struct rte_reorder_buffer *b, struct rte_mbuf **mbufs,
+		unsigned int max_mbufs, uint32_t nb_seqn, uint32_t nb_skip)
+{
+	const uint32_t size = b->order_buf.size;
+	uint32_t min_seqn, end_seqn;
+	unsigned int drain_cnt = 0;
+	struct mp_slot *slot;
+	uint64_t tag;
+
+	min_seqn = rte_atomic_load_explicit(&b->mp.min_seqn,
+			rte_memory_order_relaxed);
+	end_seqn = min_seqn + RTE_MIN(nb_seqn, size);
+
+	while (drain_cnt < max_mbufs && min_seqn != end_seqn) {
+		slot = &b->mp.slots[min_seqn & b->order_buf.mask];
+		tag = rte_atomic_load_explicit(&slot->tag,
+				rte_memory_order_acquire);
+		if (tag == MP_SLOT_TAG(min_seqn, MP_SLOT_FULL)) {
+			mbufs[drain_cnt++] = slot->mbuf;
+			/* Hand the slot over to the next lap */
+			rte_atomic_store_explicit(&slot->tag,
+				MP_SLOT_TAG(min_seqn + size, MP_SLOT_EMPTY),
+				rte_memory_order_release);
+		} else if (nb_skip == 0 ||
+				tag != MP_SLOT_TAG(min_seqn, MP_SLOT_EMPTY) ||
+				!rte_atomic_compare_exchange_strong_explicit(
+					&slot->tag, &tag,
+					MP_SLOT_TAG(min_seqn + size, MP_SLOT_EMPTY),
+					rte_memory_order_relaxed,
+					rte_memory_order_relaxed)) {
+			/* Waiting for the packet, or a producer is storing it */
+			break;
+		}
+		min_seqn++;
+		nb_skip -= nb_skip != 0;
+	}
+
+	rte_atomic_store_explicit(&b->mp.min_seqn, min_seqn,
+			rte_memory_order_release);
+
+	return drain_cnt;
+}
+
 unsigned int
 rte_reorder_drain(struct rte_reorder_buffer *b, struct rte_mbuf **mbufs,
 		unsigned max_mbufs)
 {
 	unsigned int drain_cnt = 0;
+	uint32_t min_seqn, nb_skip;
 
 	struct cir_buffer *order_buf = &b->order_buf,
 			*ready_buf = &b->ready_buf;
 
+	if (b->flags & RTE_REORDER_F_MP_INSERT) {
+		/* Skip the missing packets holding back early ones */
+		min_seqn = rte_atomic_load_explicit(&b->mp.min_seqn,
+				rte_memory_order_relaxed);
+		nb_skip = rte_atomic_load_explicit(&b->mp.skip_seqn,
+				rte_memory_order_acquire) - min_seqn;
+		if (nb_skip > b->order_buf.size)
+			nb_skip = 0;
+		return reorder_mp_drain(b, mbufs, max_mbufs, UINT32_MAX, nb_skip);
+	}
+
 	/* Try to fetch requested number of mbufs from ready buffer */
 	while ((drain_cnt < max_mbufs) && (ready_buf->tail != ready_buf->head)) {
 		mbufs[drain_cnt++] = ready_buf->entries[ready_buf->tail];
@@ -479,6 +819,15 @@ rte_reorder_drain_up_to_seqn(struct rte_reorder_buffer *b, struct rte_mbuf **mbu
 	struct cir_buffer *order_buf = &b->order_buf,
 			*ready_buf = &b->ready_buf;
 
+	if (b->flags & RTE_REORDER_F_MP_INSERT) {
+		offset = seqn - rte_atomic_load_explicit(&b->mp.min_seqn,
+				rte_memory_order_relaxed);
+		/* Nothing below seqn is left */
+		if ((int32_t)offset <= 0)
+			return 0;
+		return reorder_mp_drain(b, mbufs, max_mbufs, offset, offset);
+	}
+
 	/* Seqn in Ready buffer */
 	if (seqn < b->min_seqn) {
 		/* All sequence numbers are higher then given */
@@ -526,6 +875,16 @@ rte_reorder_is_empty(const struct rte_reorder_buffer *b)
 	const struct cir_buffer *order_buf = &b->order_buf, *ready_buf = &b->ready_buf;
 	unsigned int i;
 
+	if (b->flags & RTE_REORDER_F_MP_INSERT) {
+		for (i = 0; i < order_buf->size; i++) {
+			if ((rte_atomic_load_explicit(&b->mp.slots[i].tag,
+					rte_memory_order_acquire) & UINT32_MAX) !=
+					MP_SLOT_EMPTY)
+				return false;
+		}
+		return true;
+	}
+
 	/* Ready buffer does not have gaps */
 	if (ready_buf->tail != ready_buf->head)
 		return false;
@@ -545,8 +904,17 @@ rte_reorder_min_seqn_set(struct rte_reorder_buffer *b, rte_reorder_seqn_t min_se
 	if (!rte_reorder_is_empty(b))
 		return -ENOTEMPTY;
 
+	if (b->flags & RTE_REORDER_F_MP_INSERT)
+		reorder_mp_slots_init(b, min_seqn);
+
 	b->min_seqn = min_seqn;
 	b->is_initialized = true;
 
 	return 0;
 }
+
+unsigned int
+rte_reorder_window_get(const struct rte_reorder_buffer *b)
+{
+	return rte_atomic_load_explicit(&b->window, rte_memory_order_relaxed);
+}
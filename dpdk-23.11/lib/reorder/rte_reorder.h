@@ -14,6 +14,7 @@
  * sequence number present in mbuf.
  */
 
+#include <rte_bitops.h>
 #include <rte_compat.h>
 #include <rte_mbuf.h>
 #include <rte_mbuf_dyn.h>
@@ -44,6 +45,31 @@ rte_reorder_seqn(struct rte_mbuf *mbuf)
 		rte_reorder_seqn_t *);
 }
 
+/**
+ * Reorder buffer flag: rte_reorder_insert() and rte_reorder_insert_bulk()
+ * may be called concurrently by several threads. Draining is still done by
+ * a single thread at a time, concurrently with the inserts.
+ * The first sequence number is 0, unless set with rte_reorder_min_seqn_set()
+ * before any insert.
+ */
+#define RTE_REORDER_F_MP_INSERT		RTE_BIT32(0)
+
+/**
+ * Reorder buffer configuration, see rte_reorder_create_with_conf().
+ */
+struct rte_reorder_conf {
+	/** Initial window of sequence numbers, power of 2 */
+	unsigned int size;
+	/**
+	 * Maximum window, power of 2 not less than size. The window doubles,
+	 * up to this size, when a packet arrives just beyond it, instead of
+	 * skipping the missing packets. 0 for a fixed window.
+	 */
+	unsigned int max_size;
+	/** RTE_REORDER_F_* flags */
+	uint32_t flags;
+};
+
 /**
  * Create a new reorder buffer instance
  *
@@ -66,6 +92,31 @@ rte_reorder_seqn(struct rte_mbuf *mbuf)
 struct rte_reorder_buffer *
 rte_reorder_create(const char *name, unsigned socket_id, unsigned int size);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Create a new reorder buffer instance with an adaptive window
+ * and, optionally, concurrent inserts.
+ *
+ * @param name
+ *   The name to be given to the reorder buffer instance.
+ * @param socket_id
+ *   The NUMA node on which the memory for the reorder buffer
+ *   instance is to be reserved.
+ * @param conf
+ *   Reorder buffer configuration.
+ * @return
+ *   The initialized reorder buffer instance, or NULL on error
+ *   On error case, rte_errno will be set appropriately:
+ *    - ENOMEM - no appropriate memory area found in which to create memzone
+ *    - EINVAL - invalid parameters
+ */
+__rte_experimental
+struct rte_reorder_buffer *
+rte_reorder_create_with_conf(const char *name, unsigned int socket_id,
+		const struct rte_reorder_conf *conf);
+
 /**
  * Initializes given reorder buffer instance
  *
@@ -142,10 +193,37 @@ rte_reorder_free(struct rte_reorder_buffer *b);
  *      early mbuf, but it can be accommodated by performing drain and then insert.
  *    - ERANGE - Too early or late mbuf which is vastly out of range of expected
  *      window should be ignored without any handling.
+ *      With RTE_REORDER_F_MP_INSERT, also an mbuf late for a window moved
+ *      by a drain, or with the sequence number of an inserted mbuf.
  */
 int
 rte_reorder_insert(struct rte_reorder_buffer *b, struct rte_mbuf *mbuf);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Insert a burst of mbufs in reorder buffer in their correct position.
+ *
+ * Equivalent to calling rte_reorder_insert() for each mbuf, stopping at
+ * the first one which cannot be inserted.
+ *
+ * @param b
+ *   Reorder buffer where the mbufs have to be inserted.
+ * @param mbufs
+ *   Array of mbufs of packets that need to be inserted in reorder buffer.
+ * @param nb_mbufs
+ *   The number of elements in the mbufs array.
+ * @return
+ *   The number of mbufs inserted, from the start of the array.
+ *   When less than nb_mbufs, rte_errno is set as for rte_reorder_insert()
+ *   for the first mbuf not inserted.
+ */
+__rte_experimental
+unsigned int
+rte_reorder_insert_bulk(struct rte_reorder_buffer *b, struct rte_mbuf **mbufs,
+		unsigned int nb_mbufs);
+
 /**
  * Fetch reordered buffers
  *
@@ -154,6 +232,10 @@ rte_reorder_insert(struct rte_reorder_buffer *b, struct rte_mbuf *mbuf);
  * delayed too long before reaching the reorder window, or have been previously
  * dropped by the system.
  *
+ * With RTE_REORDER_F_MP_INSERT, inserts cannot move the window themselves:
+ * missing packets holding back early mbufs refused with ENOSPC are skipped
+ * here, so that the early mbufs can be inserted again.
+ *
  * @param b
  *   Reorder buffer instance from which packets are to be drained
  * @param mbufs
@@ -229,6 +311,21 @@ __rte_experimental
 unsigned int
 rte_reorder_memory_footprint_get(unsigned int size);
 
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice
+ *
+ * Get the current window of sequence numbers of a reorder buffer.
+ *
+ * @param b
+ *   Reorder buffer instance.
+ * @return
+ *   Number of sequence numbers that can be reordered.
+ */
+__rte_experimental
+unsigned int
+rte_reorder_window_get(const struct rte_reorder_buffer *b);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,11 +8,13 @@
 #include <inttypes.h>
 #include <assert.h>
 
+#include <rte_bitops.h>
 #include <rte_common.h>
 #include <rte_cycles.h>
 #include <rte_eal_memconfig.h>
 #include <rte_memory.h>
 #include <rte_lcore.h>
+#include <rte_malloc.h>
 #include <rte_branch_prediction.h>
 #include <rte_spinlock.h>
 #include <rte_random.h>
@@ -21,6 +23,29 @@
 
 #include "rte_timer.h"
 
+#define WHEEL_LEVELS		4
+#define WHEEL_SLOT_BITS		8
+#define WHEEL_SLOTS		(1 << WHEEL_SLOT_BITS)
+#define WHEEL_SLOT_MASK		(WHEEL_SLOTS - 1)
+#define WHEEL_RESOLUTION_US	100
+
+/**
+ * Per-lcore hierarchical timing wheel.
+ *
+ * A slot of level n spans WHEEL_SLOTS^n ticks of the wheel. A timer goes
+ * to the lowest level whose span covers its distance to the current
+ * tick; when the current tick reaches the start of a level n slot, the
+ * timers of that slot are moved down to level n - 1.
+ */
+struct timer_wheel {
+	uint64_t resolution;	/**< timer cycles per tick */
+	uint64_t cur;		/**< next tick to process */
+	uint32_t nb_pending;	/**< number of timers in the wheel */
+	/** non empty slots of level 0 */
+	uint64_t slot_bitmap[WHEEL_SLOTS / 64];
+	struct rte_timer *slots[WHEEL_LEVELS][WHEEL_SLOTS];
+};
+
 /**
  * Per-lcore info for timers.
  */
@@ -28,6 +53,9 @@ struct priv_timer {
 	struct rte_timer pending_head;  /**< dummy timer instance to head up list */
 	rte_spinlock_t list_lock;       /**< lock to protect list access */
 
+	/** timing wheel holding the pending timers, NULL for the skiplist */
+	struct timer_wheel *wheel;
+
 	/** per-core variable that true if a timer was updated on this
 	 *  core since last reset of the variable */
 	int updated;
@@ -50,6 +78,7 @@ struct priv_timer {
 struct rte_timer_data {
 	struct priv_timer priv_timer[RTE_MAX_LCORE];
 	uint8_t internal_flags;
+	struct timer_wheel *wheels; /**< per-lcore wheels, or NULL */
 };
 
 #define RTE_MAX_DATA_ELS 64
@@ -86,18 +115,70 @@ timer_data_valid(uint32_t id)
 
 int
 rte_timer_data_alloc(uint32_t *id_ptr)
+{
+	const struct rte_timer_data_conf conf = {
+		.backend = RTE_TIMER_BACKEND_SKIPLIST,
+	};
+
+	return rte_timer_data_alloc_conf(id_ptr, &conf);
+}
+
+static struct timer_wheel *
+timer_wheels_create(uint64_t resolution)
+{
+	struct timer_wheel *wheels;
+	uint64_t cur_time = rte_get_timer_cycles();
+	unsigned int lcore_id;
+
+	if (resolution == 0)
+		resolution = RTE_MAX(rte_get_timer_hz() / US_PER_S *
+			WHEEL_RESOLUTION_US, 1ULL);
+
+	wheels = rte_zmalloc("rte_timer_wheels",
+		sizeof(*wheels) * RTE_MAX_LCORE, RTE_CACHE_LINE_SIZE);
+	if (wheels == NULL)
+		return NULL;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		wheels[lcore_id].resolution = resolution;
+		wheels[lcore_id].cur = cur_time / resolution;
+	}
+
+	return wheels;
+}
+
+int
+rte_timer_data_alloc_conf(uint32_t *id_ptr,
+			  const struct rte_timer_data_conf *conf)
 {
 	int i;
+	unsigned int lcore_id;
 	struct rte_timer_data *data;
+	struct timer_wheel *wheels = NULL;
+
+	if (conf == NULL || (conf->backend != RTE_TIMER_BACKEND_SKIPLIST &&
+			conf->backend != RTE_TIMER_BACKEND_WHEEL))
+		return -EINVAL;
 
 	if (!rte_timer_subsystem_initialized)
 		return -ENOMEM;
 
+	if (conf->backend == RTE_TIMER_BACKEND_WHEEL) {
+		wheels = timer_wheels_create(conf->wheel_resolution);
+		if (wheels == NULL)
+			return -ENOMEM;
+	}
+
 	for (i = 0; i < RTE_MAX_DATA_ELS; i++) {
 		data = &rte_timer_data_arr[i];
 		if (!(data->internal_flags & FL_ALLOCATED)) {
 			data->internal_flags |= FL_ALLOCATED;
 
+			data->wheels = wheels;
+			for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++)
+				data->priv_timer[lcore_id].wheel =
+					wheels == NULL ? NULL : &wheels[lcore_id];
+
 			if (id_ptr)
 				*id_ptr = i;
 
@@ -105,6 +186,7 @@ rte_timer_data_alloc(uint32_t *id_ptr)
 		}
 	}
 
+	rte_free(wheels);
 	return -ENOSPC;
 }
 
@@ -112,10 +194,18 @@ int
 rte_timer_data_dealloc(uint32_t id)
 {
 	struct rte_timer_data *timer_data;
+	unsigned int lcore_id;
 	TIMER_DATA_VALID_GET_OR_ERR_RET(id, timer_data, -EINVAL);
 
 	timer_data->internal_flags &= ~(FL_ALLOCATED);
 
+	if (timer_data->wheels != NULL) {
+		for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++)
+			timer_data->priv_timer[lcore_id].wheel = NULL;
+		rte_free(timer_data->wheels);
+		timer_data->wheels = NULL;
+	}
+
 	return 0;
 }
 
@@ -382,6 +472,169 @@ timer_get_prev_entries_for_node(struct rte_timer *tim, unsigned tim_lcore,
 	}
 }
 
+/* insert a timer in the slot of its expiry tick, list lock held */
+static void
+timer_wheel_add(struct timer_wheel *wheel, struct rte_timer *tim)
+{
+	uint64_t tick, delta;
+	unsigned int lvl, idx;
+	struct rte_timer **slot;
+
+	/* round up, so that the timer never runs before its expiry time */
+	tick = tim->expire / wheel->resolution +
+		(tim->expire % wheel->resolution != 0);
+	if (tick < wheel->cur)
+		tick = wheel->cur;
+	delta = tick - wheel->cur;
+
+	for (lvl = 0; lvl < WHEEL_LEVELS - 1; lvl++)
+		if (delta < (1ULL << ((lvl + 1) * WHEEL_SLOT_BITS)))
+			break;
+	/* beyond the wheel span: park in the last slot, moved down later */
+	if (delta >= (1ULL << (WHEEL_LEVELS * WHEEL_SLOT_BITS)))
+		tick = wheel->cur + (1ULL << (WHEEL_LEVELS * WHEEL_SLOT_BITS)) - 1;
+
+	idx = (tick >> (lvl * WHEEL_SLOT_BITS)) & WHEEL_SLOT_MASK;
+	slot = &wheel->slots[lvl][idx];
+
+	tim->wheel.next = *slot;
+	if (*slot != NULL)
+		(*slot)->wheel.pprev = &tim->wheel.next;
+	tim->wheel.pprev = slot;
+	*slot = tim;
+
+	if (lvl == 0)
+		wheel->slot_bitmap[idx / 64] |= 1ULL << (idx % 64);
+	wheel->nb_pending++;
+}
+
+/* unlink a timer from its slot, list lock held */
+static void
+timer_wheel_del(struct timer_wheel *wheel, struct rte_timer *tim)
+{
+	struct rte_timer **pprev = tim->wheel.pprev;
+	unsigned int idx;
+
+	/* already moved to a run list by the timer manager */
+	if (pprev == NULL)
+		return;
+
+	*pprev = tim->wheel.next;
+	if (tim->wheel.next != NULL)
+		tim->wheel.next->wheel.pprev = pprev;
+	tim->wheel.pprev = NULL;
+
+	if (*pprev == NULL && pprev >= &wheel->slots[0][0] &&
+			pprev < &wheel->slots[0][WHEEL_SLOTS]) {
+		idx = pprev - &wheel->slots[0][0];
+		wheel->slot_bitmap[idx / 64] &= ~(1ULL << (idx % 64));
+	}
+	wheel->nb_pending--;
+}
+
+/* move the timers of the slots starting at the current tick one level down */
+static void
+timer_wheel_cascade(struct timer_wheel *wheel)
+{
+	struct rte_timer *tim, *next_tim;
+	unsigned int lvl, idx;
+
+	for (lvl = 1; lvl < WHEEL_LEVELS; lvl++) {
+		idx = (wheel->cur >> (lvl * WHEEL_SLOT_BITS)) & WHEEL_SLOT_MASK;
+		tim = wheel->slots[lvl][idx];
+		wheel->slots[lvl][idx] = NULL;
+		for (; tim != NULL; tim = next_tim) {
+			next_tim = tim->wheel.next;
+			wheel->nb_pending--;
+			timer_wheel_add(wheel, tim);
+		}
+		/* upper levels only move when this one wraps around */
+		if (idx != 0)
+			break;
+	}
+}
+
+/* first tick from the current one with timers in level 0, or the next
+ * tick where upper levels cascade
+ */
+static uint64_t
+timer_wheel_next_tick(const struct timer_wheel *wheel)
+{
+	unsigned int idx = wheel->cur & WHEEL_SLOT_MASK;
+	unsigned int word = idx / 64;
+	uint64_t bits;
+
+	bits = wheel->slot_bitmap[word] & (UINT64_MAX << (idx % 64));
+	while (bits == 0 && ++word < RTE_DIM(wheel->slot_bitmap))
+		bits = wheel->slot_bitmap[word];
+
+	if (bits != 0)
+		return (wheel->cur & ~(uint64_t)WHEEL_SLOT_MASK) +
+			word * 64 + rte_ctz64(bits);
+
+	return (wheel->cur | WHEEL_SLOT_MASK) + 1;
+}
+
+/*
+ * Detach the timers of all ticks up to cur_time, mark them as running
+ * and return them linked through sl_next[0], list lock held.
+ */
+static struct rte_timer *
+timer_wheel_expire(struct timer_wheel *wheel, uint64_t cur_time)
+{
+	uint64_t last = cur_time / wheel->resolution;
+	struct rte_timer *run_first_tim = NULL, **tail = &run_first_tim;
+	struct rte_timer *tim, *next_tim;
+	unsigned int idx;
+	uint64_t next;
+
+	while (wheel->cur <= last) {
+		if (wheel->nb_pending == 0) {
+			wheel->cur = last + 1;
+			break;
+		}
+
+		if ((wheel->cur & WHEEL_SLOT_MASK) == 0)
+			timer_wheel_cascade(wheel);
+
+		/* skip empty slots up to the next busy one or cascade */
+		next = timer_wheel_next_tick(wheel);
+		if (next > last) {
+			wheel->cur = last + 1;
+			break;
+		}
+		if (next != wheel->cur && (next & WHEEL_SLOT_MASK) == 0) {
+			wheel->cur = next;
+			continue;
+		}
+		wheel->cur = next;
+
+		/* the whole slot expires at once */
+		idx = next & WHEEL_SLOT_MASK;
+		tim = wheel->slots[0][idx];
+		wheel->slots[0][idx] = NULL;
+		wheel->slot_bitmap[idx / 64] &= ~(1ULL << (idx % 64));
+		for (; tim != NULL; tim = next_tim) {
+			next_tim = tim->wheel.next;
+			tim->wheel.pprev = NULL;
+			wheel->nb_pending--;
+
+			/* another core is trying to re-config this one,
+			 * leave it out of the run list
+			 */
+			if (timer_set_running_state(tim) < 0)
+				continue;
+			*tail = tim;
+			tail = &tim->wheel.next;
+		}
+
+		wheel->cur++;
+	}
+	*tail = NULL;
+
+	return run_first_tim;
+}
+
 /* call with lock held as necessary
  * add in list
  * timer must be in config state
@@ -394,6 +647,11 @@ timer_add(struct rte_timer *tim, unsigned int tim_lcore,
 	unsigned lvl;
 	struct rte_timer *prev[MAX_SKIPLIST_DEPTH+1];
 
+	if (priv_timer[tim_lcore].wheel != NULL) {
+		timer_wheel_add(priv_timer[tim_lcore].wheel, tim);
+		return;
+	}
+
 	/* find where exactly this element goes in the list of elements
 	 * for each depth. */
 	timer_get_prev_entries(tim->expire, tim_lcore, prev, priv_timer);
@@ -439,6 +697,11 @@ timer_del(struct rte_timer *tim, union rte_timer_status prev_status,
 	if (prev_owner != lcore_id || !local_is_locked)
 		rte_spinlock_lock(&priv_timer[prev_owner].list_lock);
 
+	if (priv_timer[prev_owner].wheel != NULL) {
+		timer_wheel_del(priv_timer[prev_owner].wheel, tim);
+		goto unlock;
+	}
+
 	/* save the lowest list entry into the expire field of the dummy hdr.
 	 * NOTE: this is not atomic on 32-bit */
 	if (tim == priv_timer[prev_owner].pending_head.sl_next[0])
@@ -459,6 +722,7 @@ timer_del(struct rte_timer *tim, union rte_timer_status prev_status,
 		else
 			break;
 
+unlock:
 	if (prev_owner != lcore_id || !local_is_locked)
 		rte_spinlock_unlock(&priv_timer[prev_owner].list_lock);
 }
@@ -824,6 +1088,21 @@ rte_timer_alt_manage(uint32_t timer_data_id,
 		poll_lcore = poll_lcores[i];
 		privp = &data->priv_timer[poll_lcore];
 
+		if (privp->wheel != NULL) {
+			/* optimize for the case where per-cpu wheel is empty */
+			if (privp->wheel->nb_pending == 0)
+				continue;
+			cur_time = rte_get_timer_cycles();
+
+			rte_spinlock_lock(&privp->list_lock);
+			tim = timer_wheel_expire(privp->wheel, cur_time);
+			rte_spinlock_unlock(&privp->list_lock);
+
+			if (tim != NULL)
+				run_first_tims[nb_runlists++] = tim;
+			continue;
+		}
+
 		/* optimize for the case where per-cpu list is empty */
 		if (privp->pending_head.sl_next[0] == NULL)
 			continue;
@@ -969,6 +1248,31 @@ rte_timer_alt_manage(uint32_t timer_data_id,
 	return 0;
 }
 
+/* stop the timers of all slots of a wheel */
+static void
+timer_wheel_stop_all(struct timer_wheel *wheel,
+		     struct rte_timer_data *timer_data,
+		     rte_timer_stop_all_cb_t f, void *f_arg)
+{
+	struct rte_timer *tim, *next_tim;
+	unsigned int lvl, idx;
+
+	for (lvl = 0; lvl < WHEEL_LEVELS; lvl++) {
+		for (idx = 0; idx < WHEEL_SLOTS; idx++) {
+			for (tim = wheel->slots[lvl][idx];
+			     tim != NULL;
+			     tim = next_tim) {
+				next_tim = tim->wheel.next;
+
+				__rte_timer_stop(tim, timer_data);
+
+				if (f)
+					f(tim, f_arg);
+			}
+		}
+	}
+}
+
 /* Walk pending lists, stopping timers and calling user-specified function */
 int
 rte_timer_stop_all(uint32_t timer_data_id, unsigned int *walk_lcores,
@@ -987,6 +1291,12 @@ rte_timer_stop_all(uint32_t timer_data_id, unsigned int *walk_lcores,
 		walk_lcore = walk_lcores[i];
 		priv_timer = &timer_data->priv_timer[walk_lcore];
 
+		if (priv_timer->wheel != NULL) {
+			timer_wheel_stop_all(priv_timer->wheel, timer_data,
+					     f, f_arg);
+			continue;
+		}
+
 		for (tim = priv_timer->pending_head.sl_next[0];
 		     tim != NULL;
 		     tim = next_tim) {
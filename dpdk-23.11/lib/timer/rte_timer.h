@@ -38,6 +38,7 @@
 #include <stdint.h>
 
 #include <rte_common.h>
+#include <rte_compat.h>
 #include <rte_spinlock.h>
 
 #ifdef __cplusplus
@@ -98,7 +99,14 @@ typedef void (*rte_timer_cb_t)(struct rte_timer *, void *);
 struct rte_timer
 {
 	uint64_t expire;       /**< Time when timer expire. */
-	struct rte_timer *sl_next[MAX_SKIPLIST_DEPTH];
+	union {
+		struct rte_timer *sl_next[MAX_SKIPLIST_DEPTH];
+		/** Links used when the timer is in a timing wheel. */
+		struct {
+			struct rte_timer *next;  /**< Next timer in the slot. */
+			struct rte_timer **pprev; /**< Link pointing to this one. */
+		} wheel;
+	};
 	volatile union rte_timer_status status; /**< Status of timer. */
 	uint64_t period;       /**< Period of timer (0 if not periodic). */
 	rte_timer_cb_t f;      /**< Callback function. */
@@ -144,6 +152,59 @@ struct rte_timer
  */
 int rte_timer_data_alloc(uint32_t *id_ptr);
 
+/**
+ * Data structure holding the pending timers of a timer data instance.
+ */
+enum rte_timer_backend {
+	/** Skiplist sorted by expiry time, O(log n) reset and stop. */
+	RTE_TIMER_BACKEND_SKIPLIST,
+	/**
+	 * Hierarchical timing wheel, O(1) reset and stop.
+	 * Timers expire in batches, at the first rte_timer_alt_manage() call
+	 * after the end of their slot: up to one resolution after the
+	 * requested time, never before.
+	 */
+	RTE_TIMER_BACKEND_WHEEL,
+};
+
+/**
+ * Configuration of a timer data instance.
+ */
+struct rte_timer_data_conf {
+	enum rte_timer_backend backend; /**< Pending timers structure. */
+	/**
+	 * Length of a wheel slot in timer cycles (see rte_get_timer_hz()).
+	 * 0 selects 100 microseconds. Unused by the skiplist.
+	 */
+	uint64_t wheel_resolution;
+};
+
+/**
+ * @warning
+ * @b EXPERIMENTAL: this API may change without prior notice.
+ *
+ * Allocate a timer data instance with a given configuration.
+ *
+ * The instance is used with the rte_timer_alt_*() functions and
+ * rte_timer_stop_all(). rte_timer_data_alloc() is equivalent to a
+ * RTE_TIMER_BACKEND_SKIPLIST configuration.
+ *
+ * @param id_ptr
+ *   Pointer to variable into which to write the identifier of the allocated
+ *   timer data instance.
+ * @param conf
+ *   Configuration of the instance.
+ *
+ * @return
+ *   - 0: Success
+ *   - -EINVAL: invalid configuration
+ *   - -ENOMEM: subsystem not initialized or no memory for the wheels
+ *   - -ENOSPC: maximum number of timer data instances already allocated
+ */
+__rte_experimental
+int rte_timer_data_alloc_conf(uint32_t *id_ptr,
+		const struct rte_timer_data_conf *conf);
+
 /**
  * Deallocate a timer data instance.
  *